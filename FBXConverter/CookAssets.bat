@@ -0,0 +1,5 @@
+@echo off
+
+"%~dp0\FBXConverter/x64/Release/FBXConverter" -cook %*
+"%~dp0\FBXConverter/x64/Release/AssetTool" -cook -texconv "%~dp0\FBXConverter\FBXConverter\texconv.exe" %*
+pause
\ No newline at end of file
@@ -0,0 +1,675 @@
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include <Utility.h>
+#include <MappedFile.h>
+#include <MeshFile.h>
+#include <MeshCooker.h>
+#include <MeshWelder.h>
+#include <MeshTangentGenerator.h>
+#include <AssetCooker.h>
+#include <AssetArchive.h>
+#include <ThreadPool.h>
+#include <TlsfAllocator.h>
+#include <cfloat>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <thread>
+#include <map>
+#include <random>
+
+//FBX SDKを使わないアセットの処理をまとめたツール。Utilityだけにリンクするので、FBX SDKのない環境でもビルドできる
+//FBXの変換はFBXConverterが行う
+
+//変換の中身やtexconvに渡すオプションを変えたら上げる
+constexpr uint32 TEXCONV_COOK_VERSION = 1;
+
+//texconvでテクスチャをミップマップ付きのDDSに変換するクックの変換器。入力と同じフォルダに書き出す
+//圧縮フォーマットはTextureConverterのバッチファイルの使い分けに合わせてファイル名から選ぶ
+class TexconvAssetConverter :public AssetConverter {
+public:
+	TexconvAssetConverter(const String& texconvPath) :_texconvPath(texconvPath) {}
+
+	const char* getName() const override { return "texconv"; }
+
+	bool canConvert(const String& inputPath) const override {
+		const char* extensions[] = { "png", "tga", "jpg", "jpeg", "bmp", "tif", "tiff", "hdr" };
+		for (const char* extension : extensions) {
+			if (AssetCooker::hasExtension(inputPath, extension)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//フォーマットは入力のパスで決まるので、設定にはバージョンだけを含める
+	uint64 getSettingsHash() const override {
+		return AssetCooker::computeHash(&TEXCONV_COOK_VERSION, sizeof(TEXCONV_COOK_VERSION));
+	}
+
+	bool convert(const String& inputPath, AssetCookResult& outResult) override {
+		const size_t directoryEnd = inputPath.find_last_of("/\\");
+		const String directory = directoryEnd == String::npos ? String(".") : inputPath.substr(0, directoryEnd);
+		const String fileName = directoryEnd == String::npos ? inputPath : inputPath.substr(directoryEnd + 1);
+		const char* format = selectFormat(fileName);
+
+		String command = "\"" + _texconvPath + "\" -nologo -f " + format + " -m 0 -y -o \"" + directory + "\" \"" + inputPath + "\" >nul";
+#ifdef _WIN32
+		//cmdは先頭と末尾の引用符を外すので、全体をもう一度囲む
+		command = "\"" + command + "\"";
+#endif
+
+		const int exitCode = std::system(command.c_str());
+		if (exitCode != 0) {
+			outResult.log += "Failed (texconv " + String(std::to_string(exitCode).c_str()) + "): " + inputPath + "\n";
+			return false;
+		}
+
+		//texconvは拡張子を大文字のDDSに置き換えて書き出す
+		const String outputPath = directory + "/" + fileName.substr(0, fileName.find_last_of('.')) + ".DDS";
+		outResult.log += "Converted: " + inputPath + " -> " + outputPath + " (" + format + ")\n";
+		outResult.outputPaths.push_back(outputPath);
+		return true;
+	}
+
+private:
+	//法線はBC5、ベースカラーはsRGBのBC7、ラフネスなどの1チャンネルはBC4、HDRはBC6H、それ以外はBC7
+	static const char* selectFormat(const String& fileName) {
+		if (AssetCooker::hasExtension(fileName, "hdr")) {
+			return "BC6H_UF16";
+		}
+
+		String stem = fileName.substr(0, fileName.find_last_of('.'));
+		std::transform(stem.begin(), stem.end(), stem.begin(), [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+		auto contains = [&stem](const char* word) { return stem.find(word) != String::npos; };
+		auto endsWith = [&stem](const char* word) {
+			const size_t length = strlen(word);
+			return stem.size() >= length && stem.compare(stem.size() - length, length, word) == 0;
+		};
+
+		if (contains("normal") || endsWith("_n")) {
+			return "BC5_UNORM";
+		}
+
+		if (contains("roughness") || contains("metallic") || contains("occlusion") || endsWith("_ao")) {
+			return "BC4_UNORM";
+		}
+
+		if (contains("basecolor") || contains("albedo") || contains("diffuse") || endsWith("_d")) {
+			return "BC7_UNORM_SRGB";
+		}
+
+		return "BC7_UNORM";
+	}
+
+	String _texconvPath;
+};
+//入力を並列に変換し、入力と設定が前回から変わっていないアセットは変換しない
+//変換の経過は入力の順に表示し、キャッシュマニフェストと依存マニフェストを書き出す
+//FBXはFBXConverterが同じマニフェストを使ってクックするので、ここでは扱えない入力として飛ばす
+int cookAssets(const VectorArray<String>& inputPaths, bool isForced, uint32 workerCount, const String& texconvPath) {
+	const String cacheFilePath = "AssetCache.txt";
+	const String dependencyFilePath = "AssetDependencies.d";
+
+	AssetCookCache cache;
+	if (!cache.load(cacheFilePath)) {
+		std::cout << "Broken cache: " << cacheFilePath << std::endl;
+	}
+
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+
+	const MeshCookSettings meshSettings;
+	MeshAssetConverter meshConverter(meshSettings);
+	TexconvAssetConverter texconvConverter(texconvPath);
+
+	AssetCooker cooker;
+	cooker.addConverter(&meshConverter);
+	cooker.addConverter(&texconvConverter);
+	cooker.setForced(isForced);
+
+	VectorArray<AssetCookResult> results;
+	VectorArray<AssetCookStatus> statuses;
+	AssetCookStatistics statistics;
+	cooker.cook(inputPaths, threadPool, cache, results, statuses, statistics);
+	threadPool.shutdown();
+
+	for (const auto& result : results) {
+		std::cout << result.log;
+	}
+
+	std::cout << "Cooked: " << statistics.convertedCount << " converted, " << statistics.skippedCount << " skipped, "
+		<< statistics.failedCount << " failed, " << statistics.unsupportedCount << " unsupported (" << statistics.elapsedMilliseconds << " ms)" << std::endl;
+
+	const bool isCacheSaved = cache.save(cacheFilePath);
+	const bool isDependencySaved = cache.saveDependencies(dependencyFilePath);
+	if (!isCacheSaved || !isDependencySaved) {
+		std::cout << "Failed (write): " << cacheFilePath << " " << dependencyFilePath << std::endl;
+		return 1;
+	}
+
+	return statistics.failedCount > 0 ? 1 : 0;
+}
+//ハッシュマップで頂点をまとめる従来の方法の頂点。-weldbenchで比べる基準にする
+//比較とハッシュはどちらも全属性を使い、完全に一致する頂点だけをまとめる
+struct WeldMapVertex {
+	MeshFileFloatVertex vertex;
+
+	bool operator==(const WeldMapVertex& other) const {
+		const float* a = &vertex.position[0];
+		const float* b = &other.vertex.position[0];
+		for (uint32 i = 0; i < sizeof(MeshFileFloatVertex) / sizeof(float); ++i) {
+			if (a[i] != b[i]) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+#define HashCombine(hash,seed) hash + 0x9e3779b9 + (seed << 6) + (seed >> 2)
+
+namespace std {
+	template<>
+	class hash<WeldMapVertex> {
+	public:
+
+		size_t operator () (const WeldMapVertex& p) const {
+			size_t seed = 0;
+			const float* values = &p.vertex.position[0];
+			for (uint32 i = 0; i < sizeof(MeshFileFloatVertex) / sizeof(float); ++i) {
+				seed ^= HashCombine(hash<float>()(values[i]), seed);
+			}
+			return seed;
+		}
+	};
+}
+
+//.meshをインデックスで角ごとの頂点に戻し、FBXから取り出した直後と同じ形にする
+//repeatCountが2以上なら位置をずらして複製し、重ならない頂点を増やす
+bool loadPolygonVertices(const String& filePath, uint32 repeatCount, VectorArray<MeshFileFloatVertex>& outPolygonVertices) {
+	MappedFile file;
+	MeshFileReader reader;
+	if (!file.open(filePath.c_str()) || !reader.open(file.data(), file.size())) {
+		return false;
+	}
+
+	for (uint32 meshIndex = 0; meshIndex < reader.getMeshCount(); ++meshIndex) {
+		const MeshFileMesh mesh = reader.getMesh(meshIndex);
+		VectorArray<uint32> indices;
+		if (!MeshOptimizer::loadIndices(mesh, indices)) {
+			return false;
+		}
+
+		VectorArray<MeshFileFloatVertex> vertices(mesh.vertexCount);
+		for (uint32 i = 0; i < mesh.vertexCount; ++i) {
+			if (mesh.info.vertexFormat == MESH_VERTEX_FORMAT_COMPACT) {
+				MeshVertexCodec::decodeCompactVertex(reinterpret_cast<const MeshFileCompactVertex*>(mesh.vertices)[i], mesh.info, vertices[i]);
+			}
+			else {
+				vertices[i] = reinterpret_cast<const MeshFileFloatVertex*>(mesh.vertices)[i];
+			}
+		}
+
+		const float offset = mesh.info.boundsMax[0] - mesh.info.boundsMin[0] + 1.0f;
+		for (uint32 repeat = 0; repeat < repeatCount; ++repeat) {
+			for (uint32 index : indices) {
+				MeshFileFloatVertex vertex = vertices[index];
+				vertex.position[0] += offset * repeat;
+				outPolygonVertices.push_back(vertex);
+			}
+		}
+	}
+
+	return true;
+}
+
+//角ごとの頂点をハッシュマップと基数ソートでまとめ、時間と結果の頂点数を比べる
+int benchmarkWeld(const VectorArray<String>& fileNames, uint32 repeatCount, uint32 workerCount) {
+	VectorArray<MeshFileFloatVertex> polygonVertices;
+	for (const auto& fileName : fileNames) {
+		if (!loadPolygonVertices(fileName, repeatCount, polygonVertices)) {
+			std::cout << "Failed: " << fileName << std::endl;
+			return 1;
+		}
+	}
+
+	const uint32 polygonVertexCount = static_cast<uint32>(polygonVertices.size());
+	std::cout << "Weld: " << polygonVertexCount / 3 << " triangles, " << polygonVertexCount << " polygon vertices" << std::endl;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	UnorderedMap<WeldMapVertex, uint32> mapVertices;
+	mapVertices.reserve(polygonVertexCount);
+	VectorArray<uint32> mapIndices(polygonVertexCount);
+	for (uint32 i = 0; i < polygonVertexCount; ++i) {
+		const WeldMapVertex vertex = { polygonVertices[i] };
+		auto result = mapVertices.emplace(vertex, static_cast<uint32>(mapVertices.size()));
+		mapIndices[i] = result.first->second;
+	}
+	const std::chrono::duration<float, std::milli> mapElapsed = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Map: " << mapVertices.size() << " vertices (" << mapElapsed.count() << " ms)" << std::endl;
+
+	const MeshWeldSettings settings;
+	VectorArray<uint32> remap;
+	VectorArray<MeshFileFloatVertex> weldedVertices;
+	startTime = std::chrono::high_resolution_clock::now();
+	const uint32 serialVertexCount = MeshWelder::weldVertices(polygonVertices.data(), polygonVertexCount, settings, nullptr, remap, weldedVertices);
+	const std::chrono::duration<float, std::milli> serialElapsed = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Radix (1 thread): " << serialVertexCount << " vertices (" << serialElapsed.count() << " ms)" << std::endl;
+
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+	startTime = std::chrono::high_resolution_clock::now();
+	const uint32 parallelVertexCount = MeshWelder::weldVertices(polygonVertices.data(), polygonVertexCount, settings, &threadPool, remap, weldedVertices);
+	const std::chrono::duration<float, std::milli> parallelElapsed = std::chrono::high_resolution_clock::now() - startTime;
+	threadPool.shutdown();
+	std::cout << "Radix (" << workerCount + 1 << " threads): " << parallelVertexCount << " vertices (" << parallelElapsed.count() << " ms)" << std::endl;
+
+	//まとめた頂点が元の頂点と一致し、頂点数がハッシュマップと同じなら正しくまとめられている
+	bool isValid = serialVertexCount == mapVertices.size() && parallelVertexCount == mapVertices.size();
+	for (uint32 i = 0; i < polygonVertexCount && isValid; ++i) {
+		isValid = MeshWelder::isEqualVertex(weldedVertices[remap[i]], polygonVertices[i], settings);
+	}
+
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//角ごとの頂点の接線をUVから求める時間を計り、法線と上向きの外積で作っていた従来の接線とのずれと、頂点の結合で分かれる頂点の数を比べる
+int benchmarkTangents(const VectorArray<String>& fileNames, uint32 repeatCount, uint32 workerCount) {
+	VectorArray<MeshFileFloatVertex> polygonVertices;
+	for (const auto& fileName : fileNames) {
+		if (!loadPolygonVertices(fileName, repeatCount, polygonVertices)) {
+			std::cout << "Failed: " << fileName << std::endl;
+			return 1;
+		}
+	}
+
+	const uint32 polygonVertexCount = static_cast<uint32>(polygonVertices.size());
+	std::cout << "Tangent: " << polygonVertexCount / 3 << " triangles" << std::endl;
+
+	//従来の接線
+	VectorArray<MeshFileFloatVertex> crossVertices = polygonVertices;
+	//Mathには依存しないので、cross(normal, (0, 1, EPSILON))を展開して求める
+	const float epsilon = 0.000001f;
+	for (auto& vertex : crossVertices) {
+		vertex.tangent[0] = vertex.normal[1] * epsilon - vertex.normal[2];
+		vertex.tangent[1] = -vertex.normal[0] * epsilon;
+		vertex.tangent[2] = vertex.normal[0];
+	}
+
+	VectorArray<MeshFileFloatVertex> serialVertices = polygonVertices;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	MeshTangentGenerator::generateTangents(serialVertices.data(), polygonVertexCount, nullptr);
+	const std::chrono::duration<float, std::milli> serialElapsed = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Generate (1 thread): " << serialElapsed.count() << " ms" << std::endl;
+
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+	VectorArray<MeshFileFloatVertex> parallelVertices = polygonVertices;
+	startTime = std::chrono::high_resolution_clock::now();
+	MeshTangentGenerator::generateTangents(parallelVertices.data(), polygonVertexCount, &threadPool);
+	const std::chrono::duration<float, std::milli> parallelElapsed = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Generate (" << workerCount + 1 << " threads): " << parallelElapsed.count() << " ms" << std::endl;
+
+	uint32 mirroredCount = 0;
+	double angleSum = 0.0;
+	for (uint32 i = 0; i < polygonVertexCount; ++i) {
+		const MeshFileFloatVertex& generated = serialVertices[i];
+		const MeshFileFloatVertex& crossed = crossVertices[i];
+		mirroredCount += MeshVertexCodec::getBitangentSign(generated) < 0.0f ? 1 : 0;
+
+		const float generatedLength = std::sqrt(generated.tangent[0] * generated.tangent[0] + generated.tangent[1] * generated.tangent[1] + generated.tangent[2] * generated.tangent[2]);
+		const float crossedLength = std::sqrt(crossed.tangent[0] * crossed.tangent[0] + crossed.tangent[1] * crossed.tangent[1] + crossed.tangent[2] * crossed.tangent[2]);
+		const float cosAngle = (generated.tangent[0] * crossed.tangent[0] + generated.tangent[1] * crossed.tangent[1] + generated.tangent[2] * crossed.tangent[2])
+			/ std::max(generatedLength * crossedLength, FLT_MIN);
+		angleSum += std::acos(std::max(-1.0f, std::min(1.0f, cosAngle))) * 57.2957795f;
+	}
+
+	VectorArray<uint32> remap;
+	VectorArray<MeshFileFloatVertex> weldedVertices;
+	const uint32 crossVertexCount = MeshWelder::weldVertices(crossVertices.data(), polygonVertexCount, MeshWeldSettings(), &threadPool, remap, weldedVertices);
+	const uint32 generatedVertexCount = MeshWelder::weldVertices(serialVertices.data(), polygonVertexCount, MeshWeldSettings(), &threadPool, remap, weldedVertices);
+	threadPool.shutdown();
+
+	std::cout << "Mirrored: " << mirroredCount << " / " << polygonVertexCount << " polygon vertices" << std::endl;
+	std::cout << "Difference from cross(normal, up): " << angleSum / std::max(polygonVertexCount, 1u) << " degrees on average" << std::endl;
+	std::cout << "Welded: " << crossVertexCount << " -> " << generatedVertexCount << " vertices" << std::endl;
+
+	//並列数によらず同じ結果になる
+	const bool isValid = memcmp(serialVertices.data(), parallelVertices.data(), sizeof(MeshFileFloatVertex) * polygonVertexCount) == 0;
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+//TlsfAllocatorでランダムに確保と解放を繰り返し、確保した範囲が重ならずアライメントを守っていることと、すべて解放すると1つの空きブロックに戻ることを調べる
+//続けて確保と解放の1回あたりの時間を計る。乱数の種は固定なので、失敗した手順はそのまま再現できる
+int benchmarkTlsf(uint32 repeatCount) {
+	//GPUメモリのページと同じ容量で、粒度は小さいバッファに合わせる
+	const uint64 capacity = 64ull * 1024 * 1024;
+	const uint64 granularity = 256;
+	const uint32 operationCount = 200000 * std::max(repeatCount, 1u);
+
+	TlsfAllocator allocator;
+	allocator.create(capacity, granularity);
+
+	std::mt19937 random(1);
+	VectorArray<TlsfAllocator::Allocation> allocations;
+	std::map<uint64, uint64> allocatedRanges;
+	uint32 failedCount = 0;
+	bool isValid = true;
+	for (uint32 i = 0; i < operationCount && isValid; ++i) {
+		//確保と解放を半々にして、使用量が容量の近くで上下するようにする
+		if (allocations.empty() || random() % 2 == 0) {
+			//ほとんどは小さいバッファで、ときどきテクスチャ程度の大きさにする
+			const uint64 size = 1 + random() % (random() % 8 == 0 ? 4 * 1024 * 1024 : 64 * 1024);
+			const uint64 alignment = 1ull << (random() % 17);
+			const TlsfAllocator::Allocation allocation = allocator.allocate(size, alignment);
+			if (!allocation.isValid()) {
+				++failedCount;
+				continue;
+			}
+
+			isValid = allocation.size >= size && allocation.offset % std::max(alignment, granularity) == 0 && allocation.offset + allocation.size <= capacity;
+
+			//前後の確保済みの範囲と重ならない
+			auto next = allocatedRanges.lower_bound(allocation.offset);
+			if (next != allocatedRanges.end() && next->first < allocation.offset + allocation.size) {
+				isValid = false;
+			}
+			if (next != allocatedRanges.begin() && std::prev(next)->second > allocation.offset) {
+				isValid = false;
+			}
+
+			allocatedRanges.emplace(allocation.offset, allocation.offset + allocation.size);
+			allocations.push_back(allocation);
+		}
+		else {
+			const size_t index = random() % allocations.size();
+			allocatedRanges.erase(allocations[index].offset);
+			allocator.free(allocations[index]);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+	}
+
+	const TlsfAllocator::Statistics checkStatistics = allocator.getStatistics();
+	std::cout << "Check: " << operationCount << " operations, " << checkStatistics.allocationCount << " allocations, "
+		<< failedCount << " failed, peak " << checkStatistics.peakUsedSize / 1024 << " KB" << std::endl;
+
+	//解放した順によらず、隣接する空きブロックがすべて結合されて最初の1ブロックに戻る
+	std::shuffle(allocations.begin(), allocations.end(), random);
+	for (const auto& allocation : allocations) {
+		allocator.free(allocation);
+	}
+
+	const bool isCoalesced = allocator.isEmpty() && allocator.getFreeSize() == capacity
+		&& allocator.getLargestFreeBlockSize() == capacity && allocator.getStatistics().freeBlockCount == 1;
+	std::cout << "Coalesced: " << allocator.getStatistics().freeBlockCount << " free blocks, largest " << allocator.getLargestFreeBlockSize() / 1024 << " KB" << std::endl;
+	isValid = isValid && isCoalesced;
+
+	//サイズクラスの境界にない容量でも、容量いっぱいの確保ができる
+	uint32 exactFailedCount = 0;
+	for (uint64 units = 1; units <= 1024; ++units) {
+		TlsfAllocator exactAllocator;
+		exactAllocator.create(units * granularity, granularity);
+		exactFailedCount += exactAllocator.allocate(units * granularity, granularity).isValid() ? 0 : 1;
+	}
+	std::cout << "Exact capacity: " << exactFailedCount << " failed" << std::endl;
+	isValid = isValid && exactFailedCount == 0;
+
+	//確保と解放の時間 乱数は先に作っておき、計測に含めない
+	const uint32 liveCount = 4096;
+	const uint32 roundCount = 50 * std::max(repeatCount, 1u);
+	VectorArray<uint64> sizes(liveCount);
+	for (auto& size : sizes) {
+		size = granularity + random() % (64 * 1024);
+	}
+
+	TlsfAllocator timingAllocator;
+	timingAllocator.create(capacity * 4, granularity);
+	VectorArray<TlsfAllocator::Allocation> timingAllocations(liveCount);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (uint32 round = 0; round < roundCount; ++round) {
+		//1つおきに解放して確保し直し、空きブロックが散らばった状態で計る
+		for (uint32 i = 0; i < liveCount; ++i) {
+			if (round == 0 || i % 2 == round % 2) {
+				if (timingAllocations[i].isValid()) {
+					timingAllocator.free(timingAllocations[i]);
+				}
+				timingAllocations[i] = timingAllocator.allocate(sizes[(i + round) % liveCount], granularity);
+			}
+		}
+	}
+	const std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	const uint64 timingAllocationCount = timingAllocator.getStatistics().allocationCount;
+	std::cout << "Allocate + free: " << elapsed.count() / std::max(timingAllocationCount, static_cast<uint64>(1)) << " ns (" << timingAllocationCount << " allocations, "
+		<< timingAllocator.getStatistics().failedAllocationCount << " failed)" << std::endl;
+
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//directory以下のファイルをdirectoryからの相対パスで集める
+void collectFiles(const String& directory, const String& relativeDirectory, VectorArray<String>& outRelativePaths) {
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData = {};
+	HANDLE findHandle = FindFirstFileA((directory + relativeDirectory + "*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	do {
+		const String name = findData.cFileName;
+		if (name == "." || name == "..") {
+			continue;
+		}
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			collectFiles(directory, relativeDirectory + name + "/", outRelativePaths);
+		}
+		else {
+			outRelativePaths.push_back(relativeDirectory + name);
+		}
+	} while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+#else
+	DIR* dir = opendir((directory + relativeDirectory).c_str());
+	if (dir == nullptr) {
+		return;
+	}
+
+	while (const dirent* entry = readdir(dir)) {
+		const String name = entry->d_name;
+		if (name == "." || name == "..") {
+			continue;
+		}
+
+		struct stat fileStat = {};
+		if (stat((directory + relativeDirectory + name).c_str(), &fileStat) != 0) {
+			continue;
+		}
+
+		if (S_ISDIR(fileStat.st_mode)) {
+			collectFiles(directory, relativeDirectory + name + "/", outRelativePaths);
+		}
+		else {
+			outRelativePaths.push_back(relativeDirectory + name);
+		}
+	}
+	closedir(dir);
+#endif
+}
+
+//directory以下のエンジンが読むファイルを1つのアーカイブにまとめる。アーカイブ内のパスはdirectoryからの相対パス
+//isCompressedならLZ4で圧縮して縮むファイルを圧縮する。DDSはストリーミングでミップの一部だけを読むので圧縮しない
+int packAssets(const String& archivePath, const String& directory, bool isCompressed, uint32 workerCount) {
+	String rootDirectory = directory;
+	if (!rootDirectory.empty() && rootDirectory.back() != '/' && rootDirectory.back() != '\\') {
+		rootDirectory += '/';
+	}
+
+	VectorArray<String> relativePaths;
+	collectFiles(rootDirectory, "", relativePaths);
+	std::sort(relativePaths.begin(), relativePaths.end());
+
+	AssetArchiveWriter writer;
+	for (const auto& relativePath : relativePaths) {
+		const bool isTexture = AssetCooker::hasExtension(relativePath, "dds");
+		if (!isTexture && !AssetCooker::hasExtension(relativePath, "mesh") && !AssetCooker::hasExtension(relativePath, "scene")) {
+			continue;
+		}
+
+		writer.addFile(relativePath, rootDirectory + relativePath, isCompressed && !isTexture);
+	}
+
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	AssetArchiveWriteStatistics statistics;
+	String log;
+	const bool isWritten = writer.write(archivePath.c_str(), &threadPool, statistics, log);
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	threadPool.shutdown();
+
+	std::cout << log;
+	if (!isWritten) {
+		std::cout << "Failed: " << archivePath << std::endl;
+		return 1;
+	}
+
+	//書き出したアーカイブを開き直して壊れていないか確かめる
+	AssetArchive archive;
+	if (!archive.open(archivePath.c_str()) || !archive.verifyHashes()) {
+		std::cout << "Broken: " << archivePath << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed: " << statistics.fileCount << " files (" << statistics.compressedCount << " compressed), "
+		<< statistics.size / 1024 << " KB -> " << statistics.storedSize / 1024 << " KB, archive " << statistics.archiveSize / 1024 << " KB ("
+		<< elapsed.count() << " ms)" << std::endl;
+	return 0;
+}
+//AssetTool -upgrade file.mesh ...  古い.meshをv2の圧縮頂点と圧縮インデックスに書き換える
+//AssetTool -optimize file.mesh ... -upgradeに加えて頂点とインデックスを描画向けに並べ替え、ACMRとATVRの変化を表示する
+//AssetTool -cook [-force] [-j N] [-texconv path] file ...
+//                                  .meshとテクスチャを並列に変換する。前回から変わっていない入力は変換しない
+//                                  -forceはキャッシュを見ずにすべて変換し、-jはワーカースレッド数を指定する
+//AssetTool -weldbench [-j N] [-repeat N] file.mesh ...
+//                                  .meshを角ごとの頂点に戻し、頂点の結合をハッシュマップと基数ソートで比べる
+//AssetTool -tangentbench [-j N] [-repeat N] file.mesh ...
+//                                  .meshを角ごとの頂点に戻し、UVから接線を求める時間と従来の接線との違いを調べる
+//AssetTool -tlsfbench [-repeat N]
+//                                  TlsfAllocatorのランダムな確保と解放で重なり、アライメント、空きブロックの結合を調べ、確保と解放の時間を計る
+//AssetTool -pack [-compress] [-j N] output.pak directory
+//                                  directory以下の.dds、.mesh、.sceneを1つのアーカイブにまとめる。-compressはDDS以外をLZ4で圧縮する
+//頂点はメッシュごとに圧縮を試し、誤差が大きければfloatのまま書き出す
+//インデックスは頂点数が65536以下なら16ビットにし、差分の符号化で小さくなる場合は符号化して書き出す
+//LODやメッシュレットを持たないメッシュにはLODやメッシュレットを作って書き出す
+int main(int argc, char* argv[]) {
+	const bool isCook = argc > 1 && strcmp(argv[1], "-cook") == 0;
+	const bool isWeldBenchmark = argc > 1 && strcmp(argv[1], "-weldbench") == 0;
+	const bool isTangentBenchmark = argc > 1 && strcmp(argv[1], "-tangentbench") == 0;
+	const bool isTlsfBenchmark = argc > 1 && strcmp(argv[1], "-tlsfbench") == 0;
+	const bool isPack = argc > 1 && strcmp(argv[1], "-pack") == 0;
+	const bool isOptimize = argc > 1 && strcmp(argv[1], "-optimize") == 0;
+	const bool isUpgrade = isOptimize || (argc > 1 && strcmp(argv[1], "-upgrade") == 0);
+	if (!isCook && !isWeldBenchmark && !isTangentBenchmark && !isTlsfBenchmark && !isPack && !isUpgrade) {
+		std::cout << "Usage: AssetTool -upgrade|-optimize|-cook|-weldbench|-tangentbench|-tlsfbench|-pack ..." << std::endl;
+		return 1;
+	}
+
+	//呼び出しスレッドも変換を行うので、ワーカーはコア数より1つ少なくする
+	const uint32 coreCount = std::thread::hardware_concurrency();
+	uint32 workerCount = coreCount > 1 ? coreCount - 1 : 0;
+	bool isForced = false;
+	bool isCompressed = false;
+	uint32 repeatCount = 1;
+	String texconvPath = "texconv";
+	int firstFileIndex = 2;
+	while (!isUpgrade && firstFileIndex < argc && argv[firstFileIndex][0] == '-') {
+		if (strcmp(argv[firstFileIndex], "-force") == 0) {
+			isForced = true;
+		}
+		else if (strcmp(argv[firstFileIndex], "-compress") == 0) {
+			isCompressed = true;
+		}
+		else if (strcmp(argv[firstFileIndex], "-j") == 0 && firstFileIndex + 1 < argc) {
+			workerCount = static_cast<uint32>(strtoul(argv[++firstFileIndex], nullptr, 10));
+		}
+		else if (strcmp(argv[firstFileIndex], "-repeat") == 0 && firstFileIndex + 1 < argc) {
+			repeatCount = static_cast<uint32>(strtoul(argv[++firstFileIndex], nullptr, 10));
+		}
+		else if (strcmp(argv[firstFileIndex], "-texconv") == 0 && firstFileIndex + 1 < argc) {
+			texconvPath = argv[++firstFileIndex];
+		}
+		else {
+			std::cout << "Unknown option: " << argv[firstFileIndex] << std::endl;
+			return 1;
+		}
+		++firstFileIndex;
+	}
+
+	VectorArray<String> fileNames;
+	for (int i = firstFileIndex; i < argc; ++i) {
+		//同じ入力を並列に変換しないように重複を除く
+		const String fileName = argv[i];
+		if (std::find(fileNames.begin(), fileNames.end(), fileName) != fileNames.end()) {
+			continue;
+		}
+
+		fileNames.push_back(fileName);
+		std::cout << "File: " << fileName << std::endl;
+	}
+
+	if (isCook) {
+		return cookAssets(fileNames, isForced, workerCount, texconvPath);
+	}
+
+	if (isPack) {
+		if (fileNames.size() != 2) {
+			std::cout << "Usage: -pack [-compress] [-j N] output.pak directory" << std::endl;
+			return 1;
+		}
+
+		return packAssets(fileNames[0], fileNames[1], isCompressed, workerCount);
+	}
+
+	if (isWeldBenchmark) {
+		return benchmarkWeld(fileNames, repeatCount, workerCount);
+	}
+
+	if (isTangentBenchmark) {
+		return benchmarkTangents(fileNames, repeatCount, workerCount);
+	}
+
+	if (isTlsfBenchmark) {
+		return benchmarkTlsf(repeatCount);
+	}
+
+	//-upgradeは並べ替えず、書式だけを新しくする
+	MeshCookSettings settings;
+	settings.isOptimize = isOptimize;
+	int result = 0;
+	for (const auto& fileName : fileNames) {
+		String log;
+		bool isWritten = false;
+		result |= MeshCooker::cookMeshFile(fileName, settings, log, isWritten) ? 0 : 1;
+		std::cout << log;
+	}
+
+	return result;
+}
@@ -4,6 +4,18 @@
 #include <fbxsdk.h>
 #include <LMath.h>
 #include <Utility.h>
+#include <MeshFile.h>
+#include <MeshCooker.h>
+#include <MeshWelder.h>
+#include <MeshTangentGenerator.h>
+#include <AssetCooker.h>
+#include <ThreadPool.h>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <mutex>
 using namespace fbxsdk;
 
 struct RawVertex {
@@ -11,10 +23,6 @@ struct RawVertex {
 	Vector3 normal;
 	Vector3 tangent;
 	Vector2 texcoord;
-
-	bool operator==(const RawVertex& left) const {
-		return position == left.position && texcoord == texcoord;
-	}
 };
 
 struct MaterialDrawRange {
@@ -24,196 +32,338 @@ struct MaterialDrawRange {
 	uint32 indexOffset;
 };
 
-#define HashCombine(hash,seed) hash + 0x9e3779b9 + (seed << 6) + (seed >> 2)
-
-namespace std {
-	template<>
-	class hash<RawVertex> {
-	public:
-
-		size_t operator () (const RawVertex& p) const {
-			size_t seed = 0;
-
-			seed ^= HashCombine(hash<float>()(p.position.x), seed);
-			seed ^= HashCombine(hash<float>()(p.position.y), seed);
-			seed ^= HashCombine(hash<float>()(p.position.z), seed);
-			seed ^= HashCombine(hash<float>()(p.normal.x), seed);
-			seed ^= HashCombine(hash<float>()(p.normal.y), seed);
-			seed ^= HashCombine(hash<float>()(p.normal.z), seed);
-			seed ^= HashCombine(hash<float>()(p.texcoord.x), seed);
-			seed ^= HashCombine(hash<float>()(p.texcoord.y), seed);
-			return seed;
+//FBXから変換したメッシュ1つ分
+struct ConvertedMesh {
+	String name;
+	VectorArray<RawVertex> vertices;
+	VectorArray<uint32> indices;
+	VectorArray<MaterialDrawRange> materialRanges;
+	Vector3 aabbMin;
+	Vector3 aabbMax;
+};
+
+static_assert(sizeof(RawVertex) == sizeof(MeshFileFloatVertex), "float頂点と同じレイアウトで書き出す");
+static_assert(sizeof(MaterialDrawRange) == sizeof(MeshFileMaterialRange), "マテリアルの描画範囲はそのまま書き出す");
+
+//ポリゴンの角ごとに頂点をインデックスバッファの並びで取り出す。接線はweldMeshでUVから求め、頂点もそこでまとめる
+void convertMesh(FbxMesh* mesh, uint32 materialCount, ConvertedMesh& outMesh) {
+	const uint32 vertexCount = mesh->GetControlPointsCount();
+	const uint32 polygonCount = mesh->GetPolygonCount();
+	const uint32 polygonVertexCount = 3;
+	const uint32 indexCount = polygonCount * polygonVertexCount;
+
+	FbxStringList uvSetNames;
+	bool bIsUnmapped = false;
+	mesh->GetUVSetNames(uvSetNames);
+
+	FbxLayerElementMaterial* meshMaterials = mesh->GetLayer(0)->GetMaterials();
+
+	//マテリアルごとの頂点インデックス数を調べる
+	VectorArray<uint32> materialIndexSizes(materialCount);
+	for (uint32 i = 0; i < polygonCount; ++i) {
+		const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
+		materialIndexSizes[materialId] += polygonVertexCount;
+	}
+
+	//マテリアルごとのインデックスオフセットを計算
+	VectorArray<uint32> materialIndexOffsets(materialCount);
+	for (size_t i = 0; i < materialIndexOffsets.size(); ++i) {
+		for (size_t j = 0; j < i; ++j) {
+			materialIndexOffsets[i] += materialIndexSizes[j];
 		}
-	};
-}
+	}
 
-int main(int argc, char* argv[]) {
-	std::cout << argc << std::endl;
+	VectorArray<RawVertex>& polygonVertices = outMesh.vertices;//インデックスバッファの並びで置いたポリゴンの角ごとの頂点
+	polygonVertices.resize(indexCount);
+	VectorArray<uint32> materialIndexCounter(materialCount);//マテリアルごとのインデックス数を管理
+
+	for (uint32 i = 0; i < polygonCount; ++i) {
+		const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
+		const uint32 materialIndexOffset = materialIndexOffsets[materialId];
+		uint32& indexCount = materialIndexCounter[materialId];
+
+		for (uint32 j = 0; j < polygonVertexCount; ++j) {
+			const uint32 vertexIndex = mesh->GetPolygonVertex(i, j);
+			FbxVector4 v = mesh->GetControlPointAt(vertexIndex);
+			FbxVector4 normal;
+			FbxVector2 texcoord;
+
+			FbxString uvSetName = uvSetNames.GetStringAt(0);//UVSetは０番インデックスのみ対応
+			mesh->GetPolygonVertexUV(i, j, uvSetName, texcoord, bIsUnmapped);
+			mesh->GetPolygonVertexNormal(i, j, normal);
+
+			RawVertex r;
+			r.position = { (float)v[0], (float)v[1], -(float)v[2] };//FBXは右手座標系なので左手座標系に直すためにZを反転する
+			r.normal = { (float)normal[0], (float)normal[1], -(float)normal[2] };
+			r.texcoord = { (float)texcoord[0], 1 - (float)texcoord[1] };//UVのY軸を反転
+
+			//Zを反転するとポリゴンが左回りになるので右回りになるようにインデックスを0,1,2 → 2,1,0にする
+			const uint32 indexInverseCorrectionedValue = indexCount + 2 - j;
+			const uint32 indexPerMaterial = materialIndexOffset + indexInverseCorrectionedValue;
+			polygonVertices[indexPerMaterial] = r;
+		}
+
+		indexCount += polygonVertexCount;
+	}
 
-	uint32 fileCount = argc - 1;
-	VectorArray<String> fileNames(fileCount);
+	//マテリアルの描画範囲を設定
+	VectorArray<MaterialDrawRange>& materialRanges = outMesh.materialRanges;
+	materialRanges.reserve(materialCount);
 
-	for (int i = 0; i < fileCount; ++i) {
-		fileNames[i] = argv[i + 1];
-		std::cout <<"File: "<< fileNames[i] << std::endl;
+	for (size_t i = 0; i < materialCount; ++i) {
+		materialRanges.emplace_back(materialIndexSizes[i], materialIndexOffsets[i]);
 	}
+}
 
+//角ごとの頂点の接線をUVから求め、すべての属性が一致する頂点をまとめてインデックスを作り、BoundingBoxを計算する
+//接線と従法線の符号も比べてまとめるので、UVの継ぎ目や裏返りで接線が分かれる頂点は分かれたまま残る
+//FBX SDKに触れないので、読み込みの排他の外で並列に行える
+void weldMesh(ConvertedMesh& mesh, ThreadPool* threadPool) {
+	VectorArray<RawVertex>& vertices = mesh.vertices;
+	MeshFileFloatVertex* polygonVertices = reinterpret_cast<MeshFileFloatVertex*>(vertices.data());
+	const uint32 polygonVertexCount = static_cast<uint32>(vertices.size());
+	MeshTangentGenerator::generateTangents(polygonVertices, polygonVertexCount, threadPool);
+
+	//角ごとの頂点はインデックスバッファの並びなので、まとめた後の頂点番号がそのままインデックスになる
+	VectorArray<MeshFileFloatVertex> weldedVertices;
+	const uint32 weldedVertexCount = MeshWelder::weldVertices(polygonVertices, polygonVertexCount, MeshWeldSettings(), threadPool, mesh.indices, weldedVertices);
+
+	vertices.resize(weldedVertexCount);
+	memcpy(vertices.data(), weldedVertices.data(), sizeof(RawVertex) * weldedVertexCount);
+	vertices.shrink_to_fit();
+
+	//BoundingBoxのサイズを計算
+	Vector3& aabbMin = mesh.aabbMin;
+	Vector3& aabbMax = mesh.aabbMax;
+	aabbMin = vertices.empty() ? Vector3() : Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	aabbMax = vertices.empty() ? Vector3() : Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (auto&& v : vertices) {
+		const Vector3& p = v.position;
+		if (p.x < aabbMin.x) { aabbMin.x = p.x; }
+		if (p.x > aabbMax.x) { aabbMax.x = p.x; }
+		if (p.y < aabbMin.y) { aabbMin.y = p.y; }
+		if (p.y > aabbMax.y) { aabbMax.y = p.y; }
+		if (p.z < aabbMin.z) { aabbMin.z = p.z; }
+		if (p.z > aabbMax.z) { aabbMax.z = p.z; }
+	}
+}
 
-	for (const auto& fileName : fileNames) {
-		fbxsdk::FbxManager* manager = fbxsdk::FbxManager::Create();
-		FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
-		manager->SetIOSettings(ios);
-		FbxScene* scene = FbxScene::Create(manager, "");
+MeshFileMesh makeMeshFileMesh(const ConvertedMesh& mesh) {
+	MeshFileMesh fileMesh = {};
+	strncpy(fileMesh.info.name, mesh.name.c_str(), MESH_FILE_MAX_NAME_LENGTH - 1);
+	fileMesh.info.boundsMin[0] = mesh.aabbMin.x;
+	fileMesh.info.boundsMin[1] = mesh.aabbMin.y;
+	fileMesh.info.boundsMin[2] = mesh.aabbMin.z;
+	fileMesh.info.boundsMax[0] = mesh.aabbMax.x;
+	fileMesh.info.boundsMax[1] = mesh.aabbMax.y;
+	fileMesh.info.boundsMax[2] = mesh.aabbMax.z;
+	fileMesh.vertexStride = sizeof(RawVertex);
+	fileMesh.vertexCount = static_cast<uint32>(mesh.vertices.size());
+	fileMesh.indexCount = static_cast<uint32>(mesh.indices.size());
+	fileMesh.materialRangeCount = static_cast<uint32>(mesh.materialRanges.size());
+	fileMesh.vertices = reinterpret_cast<const byte*>(mesh.vertices.data());
+	fileMesh.indices = mesh.indices.data();
+	fileMesh.materialRanges = reinterpret_cast<const MeshFileMaterialRange*>(mesh.materialRanges.data());
+	return fileMesh;
+}
 
-		FbxImporter* importer = FbxImporter::Create(manager, "");
-		String fullPath = fileName;
-		bool isSuccsess = importer->Initialize(fullPath.c_str(), -1, manager->GetIOSettings());
-		assert(isSuccsess && "FBXǂݍݎs");
+//FBXを読み込んで三角形に分割し、シーン内のメッシュをすべて変換する
+bool importFbx(const String& filePath, VectorArray<ConvertedMesh>& outMeshes) {
+	fbxsdk::FbxManager* manager = fbxsdk::FbxManager::Create();
+	FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
+	manager->SetIOSettings(ios);
+	FbxScene* scene = FbxScene::Create(manager, "");
 
-		importer->Import(scene);
+	FbxImporter* importer = FbxImporter::Create(manager, "");
+	bool isSuccsess = importer->Initialize(filePath.c_str(), -1, manager->GetIOSettings());
+	if (!isSuccsess) {
 		importer->Destroy();
+		manager->Destroy();
+		return false;
+	}
 
-		FbxGeometryConverter geometryConverter(manager);
-		geometryConverter.Triangulate(scene, true);
+	importer->Import(scene);
+	importer->Destroy();
 
-		FbxAxisSystem::DirectX.ConvertScene(scene);
+	FbxGeometryConverter geometryConverter(manager);
+	geometryConverter.Triangulate(scene, true);
 
-		FbxMesh* mesh = scene->GetMember<FbxMesh>(0);
-		const uint32 materialCount = scene->GetMaterialCount();
-		const uint32 vertexCount = mesh->GetControlPointsCount();
-		const uint32 polygonCount = mesh->GetPolygonCount();
-		const uint32 polygonVertexCount = 3;
-		const uint32 indexCount = polygonCount * polygonVertexCount;
+	FbxAxisSystem::DirectX.ConvertScene(scene);
 
-		FbxStringList uvSetNames;
-		bool bIsUnmapped = false;
-		mesh->GetUVSetNames(uvSetNames);
+	//マテリアルIDはノードのマテリアルを指すので、シーン全体のマテリアル数あれば足りる
+	const uint32 materialCount = scene->GetMaterialCount();
+	const uint32 meshCount = scene->GetMemberCount<FbxMesh>();
+	outMeshes.resize(meshCount);
+	for (uint32 i = 0; i < meshCount; ++i) {
+		FbxMesh* mesh = scene->GetMember<FbxMesh>(i);
+		FbxNode* node = mesh->GetNode();
+		outMeshes[i].name = node != nullptr ? node->GetName() : "";
+		convertMesh(mesh, materialCount, outMeshes[i]);
+	}
 
-		FbxLayerElementMaterial* meshMaterials = mesh->GetLayer(0)->GetMaterials();
+	manager->Destroy();
+	return true;
+}
 
-		//}eAƂ̒_CfbNX𒲂ׂ
-		VectorArray<uint32> materialIndexSizes(materialCount);
-		for (uint32 i = 0; i < polygonCount; ++i) {
-			const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
-			materialIndexSizes[materialId] += polygonVertexCount;
-		}
+//FBXをv2の.meshに変換するクックの変換器。シーン内のメッシュをすべて1つのファイルに書き出す
+//FBXから変換するときは常に並べ替え、LODとメッシュレットを作る
+class FbxAssetConverter :public AssetConverter {
+public:
+	FbxAssetConverter(const MeshCookSettings& settings, ThreadPool* threadPool) :_settings(settings), _threadPool(threadPool) {
+		_settings.isOptimize = true;
+	}
 
-		//}eAƂ̃CfbNXItZbgvZ
-		VectorArray<uint32> materialIndexOffsets(materialCount);
-		for (size_t i = 0; i < materialIndexOffsets.size(); ++i) {
-			for (size_t j = 0; j < i; ++j) {
-				materialIndexOffsets[i] += materialIndexSizes[j];
+	const char* getName() const override { return "fbx"; }
+	bool canConvert(const String& inputPath) const override { return AssetCooker::hasExtension(inputPath, "fbx"); }
+	uint64 getSettingsHash() const override { return _settings.computeHash(); }
+
+	bool convert(const String& inputPath, AssetCookResult& outResult) override {
+		VectorArray<ConvertedMesh> meshes;
+		{
+			//FBX SDKはスレッドセーフではないので読み込みは1ファイルずつ行い、後処理だけを並列に行う
+			std::lock_guard<std::mutex> lock(_importMutex);
+			if (!importFbx(inputPath, meshes)) {
+				outResult.log += "Failed (import): " + inputPath + "\n";
+				return false;
 			}
 		}
 
-		UnorderedMap<RawVertex, uint32> optimizedVertices;//dȂ_ƐV_CfbNX
-		VectorArray<uint32> indices(indexCount);//V_CfbNXłłCfbNXobt@
-		VectorArray<uint32> materialIndexCounter(materialCount);//}eAƂ̃CfbNXǗ
-
-		optimizedVertices.reserve(indexCount);
-
-		for (uint32 i = 0; i < polygonCount; ++i) {
-			const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
-			const uint32 materialIndexOffset = materialIndexOffsets[materialId];
-			uint32& indexCount = materialIndexCounter[materialId];
-
-			for (uint32 j = 0; j < polygonVertexCount; ++j) {
-				const uint32 vertexIndex = mesh->GetPolygonVertex(i, j);
-				FbxVector4 v = mesh->GetControlPointAt(vertexIndex);
-				FbxVector4 normal;
-				FbxVector2 texcoord;
-
-				FbxString uvSetName = uvSetNames.GetStringAt(0);//UVSet͂OԃCfbNX̂ݑΉ
-				mesh->GetPolygonVertexUV(i, j, uvSetName, texcoord, bIsUnmapped);
-				mesh->GetPolygonVertexNormal(i, j, normal);
-
-				RawVertex r;
-				r.position = { (float)v[0], (float)v[1], -(float)v[2] };//FBX͉EWnȂ̂ōWnɒ߂Z𔽓]
-				r.normal = { (float)normal[0], (float)normal[1], -(float)normal[2] };
-				r.texcoord = { (float)texcoord[0], 1 - (float)texcoord[1] };//UVY𔽓]
-
-				const Vector3 vectorUp = { 0.0f, 1, EPSILON };
-				r.tangent = Vector3::cross(r.normal, vectorUp);
-
-				//Z𔽓]ƃ|SɂȂ̂ŉEɂȂ悤ɃCfbNX0,1,2  2,1,0ɂ
-				const uint32 indexInverseCorrectionedValue = indexCount + 2 - j;
-				const uint32 indexPerMaterial = materialIndexOffset + indexInverseCorrectionedValue;
-				if (optimizedVertices.count(r) == 0) {
-					uint32 vertexIndex = static_cast<uint32>(optimizedVertices.size());
-					indices[indexPerMaterial] = vertexIndex;
-					optimizedVertices.emplace(r, vertexIndex);
-				}
-				else {
-					indices[indexPerMaterial] = optimizedVertices.at(r);
-				}
-
+		const uint32 meshCount = static_cast<uint32>(meshes.size());
+		VectorArray<MeshCookData> cookData(meshCount);
+		MeshFileWriter writer;
+		for (uint32 i = 0; i < meshCount; ++i) {
+			weldMesh(meshes[i], _threadPool);
+			MeshFileMesh fileMesh = makeMeshFileMesh(meshes[i]);
+			bool isChanged = false;
+			if (!MeshCooker::cookMesh(fileMesh, _settings, cookData[i], outResult.log, isChanged)) {
+				return false;
 			}
-
-			indexCount += polygonVertexCount;
+			writer.addMesh(fileMesh);
 		}
 
-		//UnorederedMap̔z񂩂VectorArrayɕϊ
-		VectorArray<RawVertex> vertices(optimizedVertices.size());
-		for (const auto& vertex : optimizedVertices) {
-			vertices[vertex.second] = vertex.first;
+		const String meshFilePath = inputPath.substr(0, inputPath.find_last_of('.')) + ".mesh";
+		if (!writer.write(meshFilePath.c_str())) {
+			outResult.log += "Failed (write): " + meshFilePath + "\n";
+			return false;
 		}
 
-		manager->Destroy();
+		outResult.log += "Converted: " + inputPath + " -> " + meshFilePath + "\n";
+		outResult.outputPaths.push_back(meshFilePath);
+		return true;
+	}
 
-		//}eA̕`͈͂ݒ
-		VectorArray<MaterialDrawRange> materialRanges;
-		materialRanges.reserve(materialCount);
+private:
+	MeshCookSettings _settings;
+	RefPtr<ThreadPool> _threadPool;
+	std::mutex _importMutex;
+};
+
+//入力を並列に変換し、入力と設定が前回から変わっていないアセットは変換しない
+//変換の経過は入力の順に表示し、キャッシュマニフェストと依存マニフェストを書き出す
+//.meshとテクスチャはAssetToolが同じマニフェストを使ってクックするので、ここではFBXだけを扱う
+int cookAssets(const VectorArray<String>& inputPaths, bool isForced, uint32 workerCount) {
+	const String cacheFilePath = "AssetCache.txt";
+	const String dependencyFilePath = "AssetDependencies.d";
+
+	AssetCookCache cache;
+	if (!cache.load(cacheFilePath)) {
+		std::cout << "Broken cache: " << cacheFilePath << std::endl;
+	}
+
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+
+	//FBXの頂点の結合は変換中のワーカーからさらに並列に行う
+	const MeshCookSettings meshSettings;
+	FbxAssetConverter fbxConverter(meshSettings, &threadPool);
+
+	AssetCooker cooker;
+	cooker.addConverter(&fbxConverter);
+	cooker.setForced(isForced);
+
+	VectorArray<AssetCookResult> results;
+	VectorArray<AssetCookStatus> statuses;
+	AssetCookStatistics statistics;
+	cooker.cook(inputPaths, threadPool, cache, results, statuses, statistics);
+	threadPool.shutdown();
 
-		for (size_t i = 0; i < materialCount; ++i) {
-			materialRanges.emplace_back(materialIndexSizes[i], materialIndexOffsets[i]);
+	for (const auto& result : results) {
+		std::cout << result.log;
+	}
+
+	std::cout << "Cooked: " << statistics.convertedCount << " converted, " << statistics.skippedCount << " skipped, "
+		<< statistics.failedCount << " failed, " << statistics.unsupportedCount << " unsupported (" << statistics.elapsedMilliseconds << " ms)" << std::endl;
+
+	const bool isCacheSaved = cache.save(cacheFilePath);
+	const bool isDependencySaved = cache.saveDependencies(dependencyFilePath);
+	if (!isCacheSaved || !isDependencySaved) {
+		std::cout << "Failed (write): " << cacheFilePath << " " << dependencyFilePath << std::endl;
+		return 1;
+	}
+
+	return statistics.failedCount > 0 ? 1 : 0;
+}
+
+//FBXConverter file.fbx ...          FBXをv2の.meshに変換する。シーン内のメッシュをすべて1つのファイルに書き出す
+//FBXConverter -cook [-force] [-j N] file.fbx ...
+//                                     .fbxを並列に変換する。前回から変わっていない入力は変換しない
+//                                     -forceはキャッシュを見ずにすべて変換し、-jはワーカースレッド数を指定する
+//.meshの書き換えと並べ替え、.meshとテクスチャのクック、アーカイブへのまとめ、頂点の結合と接線のベンチマーク、TlsfAllocatorの検査はFBX SDKを使わないAssetToolで行う
+//FBXから変換するときは常に並べ替える
+//頂点はメッシュごとに圧縮を試し、誤差が大きければfloatのまま書き出す
+//インデックスは頂点数が65536以下なら16ビットにし、差分の符号化で小さくなる場合は符号化して書き出す
+//LODやメッシュレットを持たないメッシュにはLODやメッシュレットを作って書き出す
+int main(int argc, char* argv[]) {
+	std::cout << argc << std::endl;
+
+	const bool isCook = argc > 1 && strcmp(argv[1], "-cook") == 0;
+	int firstFileIndex = isCook ? 2 : 1;
+
+	//呼び出しスレッドも変換を行うので、ワーカーはコア数より1つ少なくする
+	const uint32 coreCount = std::thread::hardware_concurrency();
+	uint32 workerCount = coreCount > 1 ? coreCount - 1 : 0;
+	bool isForced = false;
+	while (isCook && firstFileIndex < argc && argv[firstFileIndex][0] == '-') {
+		if (strcmp(argv[firstFileIndex], "-force") == 0) {
+			isForced = true;
+		}
+		else if (strcmp(argv[firstFileIndex], "-j") == 0 && firstFileIndex + 1 < argc) {
+			workerCount = static_cast<uint32>(strtoul(argv[++firstFileIndex], nullptr, 10));
 		}
+		else {
+			std::cout << "Unknown option: " << argv[firstFileIndex] << std::endl;
+			return 1;
+		}
+		++firstFileIndex;
+	}
 
-		//BoundingBox̃TCYvZ
-		Vector3 aabbMin;
-		Vector3 aabbMax;
-		for (auto&& v : vertices) {
-			const Vector3& p = v.position;
-			if (p.x < aabbMin.x) { aabbMin.x = p.x; }
-			if (p.x > aabbMax.x) { aabbMax.x = p.x; }
-			if (p.y < aabbMin.y) { aabbMin.y = p.y; }
-			if (p.y > aabbMax.y) { aabbMax.y = p.y; }
-			if (p.z < aabbMin.z) { aabbMin.z = p.z; }
-			if (p.z > aabbMax.z) { aabbMax.z = p.z; }
+	VectorArray<String> fileNames;
+	for (int i = firstFileIndex; i < argc; ++i) {
+		//同じ入力を並列に変換しないように重複を除く
+		const String fileName = argv[i];
+		if (std::find(fileNames.begin(), fileNames.end(), fileName) != fileNames.end()) {
+			continue;
 		}
 
-		uint32 allFileSize = 0;
-		uint32 verticesCount = vertices.size();
-		uint32 indicesCount = indices.size();
-		uint32 verticesSize = verticesCount * sizeof(RawVertex);
-		uint32 indicesSize = indicesCount * sizeof(uint32);
-		uint32 materialSize = materialCount * sizeof(MaterialDrawRange);
-		uint32 boundingBoxSize = sizeof(Vector3) * 2;
-
-		allFileSize += verticesSize;
-		allFileSize += indicesSize;
-		allFileSize += materialSize;
-		allFileSize += boundingBoxSize;
-
-		std::string filePath(fileName.c_str());
-		size_t splitPoint = filePath.find('.');
-		filePath = filePath.substr(0, splitPoint);
-		filePath.append(".mesh");
-
-		std::ofstream fout;
-		fout.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
-
-		fout.write(reinterpret_cast<const char*>(&allFileSize), 4);
-		fout.write(reinterpret_cast<const char*>(&verticesCount), 4);
-		fout.write(reinterpret_cast<const char*>(&indicesCount), 4);
-		fout.write(reinterpret_cast<const char*>(&materialCount), 4);
-		fout.write(reinterpret_cast<const char*>(vertices.data()), verticesSize);
-		fout.write(reinterpret_cast<const char*>(indices.data()), indicesSize);
-		fout.write(reinterpret_cast<const char*>(materialRanges.data()), materialSize);
-		fout.write(reinterpret_cast<const char*>(&aabbMin), 12);
-		fout.write(reinterpret_cast<const char*>(&aabbMax), 12);
-
-		fout.close();
-	}
-
-	return 0;
-}
\ No newline at end of file
+		fileNames.push_back(fileName);
+		std::cout << "File: " << fileName << std::endl;
+	}
+
+	if (isCook) {
+		return cookAssets(fileNames, isForced, workerCount);
+	}
+
+	const MeshCookSettings settings;
+	ThreadPool threadPool;
+	threadPool.create(workerCount);
+
+	FbxAssetConverter converter(settings, &threadPool);
+	int result = 0;
+	for (const auto& fileName : fileNames) {
+		AssetCookResult cookResult;
+		result |= converter.convert(fileName, cookResult) ? 0 : 1;
+		std::cout << cookResult.log;
+	}
+
+	return result;
+}
@@ -0,0 +1,4 @@
+@echo off
+
+"%~dp0\FBXConverter/x64/Release/AssetTool" -pack -compress "%~dp0\..\LightnEngine\LightnEngine\Resources.pak" "%~dp0\..\LightnEngine\LightnEngine\Resources"
+pause
\ No newline at end of file
@@ -0,0 +1,6 @@
+@echo off
+
+for %%f in (%*) do (
+  "%~dp0\FBXConverter/x64/Release/AssetTool" -upgrade %%f
+)
+pause
\ No newline at end of file
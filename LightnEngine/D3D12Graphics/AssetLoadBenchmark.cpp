@@ -0,0 +1,212 @@
+#include "AssetLoadBenchmark.h"
+#include <AssetArchive.h>
+#include <Lz4Codec.h>
+#include <MappedFile.h>
+
+//キャッシュを通さない読み込みの位置、大きさ、バッファのアラインメント。アーカイブのエントリーはこの境界から始まる
+constexpr uint64 UnbufferedAlignment = ASSET_ARCHIVE_ALIGNMENT;
+
+//1回のReadFileで読む上限
+constexpr uint64 UnbufferedReadChunkSize = 16 * 1024 * 1024;
+
+static uint64 alignUnbuffered(uint64 size) {
+	return (size + UnbufferedAlignment - 1) & ~(UnbufferedAlignment - 1);
+}
+
+static float getElapsedSeconds(const LARGE_INTEGER& startTime, const LARGE_INTEGER& frequency) {
+	LARGE_INTEGER endTime;
+	QueryPerformanceCounter(&endTime);
+	return (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+}
+
+AssetLoadBenchmarkResult AssetLoadBenchmark::run(const String& archivePath, const String& directory) {
+	AssetLoadBenchmarkResult result;
+
+	AssetArchive archive;
+	if (!archive.open(archivePath.c_str())) {
+		return result;
+	}
+
+	//個別のファイルもあるエントリーだけを集める。ここではファイルの中身を読まない
+	VectorArray<uint32> entryIndices;
+	VectorArray<String> entryPaths;
+	VectorArray<String> loosePaths;
+	for (uint32 i = 0; i < archive.getEntryCount(); ++i) {
+		const AssetArchiveEntry& entry = archive.getEntry(i);
+		const String entryPath = archive.getEntryPath(entry);
+		const String loosePath = directory + entryPath;
+		WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+		if (!GetFileAttributesExA(loosePath.c_str(), GetFileExInfoStandard, &attributes)
+			|| ((static_cast<uint64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow) != entry.size) {
+			continue;
+		}
+
+		entryIndices.push_back(i);
+		entryPaths.push_back(entryPath);
+		loosePaths.push_back(loosePath);
+		result.compressedCount += entry.compression != ASSET_ARCHIVE_COMPRESSION_NONE ? 1 : 0;
+		result.totalSize += entry.size;
+		result.storedSize += entry.storedSize;
+	}
+	archive.close();
+
+	result.fileCount = static_cast<uint32>(entryIndices.size());
+	if (result.fileCount == 0) {
+		return result;
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER startTime;
+	QueryPerformanceFrequency(&frequency);
+	VectorArray<byte> buffer;
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& loosePath : loosePaths) {
+		loadLooseCold(loosePath, buffer);
+	}
+	result.coldLooseSeconds = getElapsedSeconds(startTime, frequency);
+
+	QueryPerformanceCounter(&startTime);
+	loadArchiveCold(archivePath, entryIndices, buffer);
+	result.coldArchiveSeconds = getElapsedSeconds(startTime, frequency);
+
+	//1回読んでキャッシュに載せてから計測する
+	for (const auto& loosePath : loosePaths) {
+		loadLooseWarm(loosePath);
+	}
+	loadArchiveWarm(archivePath, entryPaths);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& loosePath : loosePaths) {
+		loadLooseWarm(loosePath);
+	}
+	result.warmLooseSeconds = getElapsedSeconds(startTime, frequency);
+
+	QueryPerformanceCounter(&startTime);
+	loadArchiveWarm(archivePath, entryPaths);
+	result.warmArchiveSeconds = getElapsedSeconds(startTime, frequency);
+
+	//計測の後で内容を突き合わせる
+	result.isValid = archive.open(archivePath.c_str());
+	VectorArray<byte> entryData;
+	for (uint32 i = 0; i < result.fileCount && result.isValid; ++i) {
+		MappedFile looseFile;
+		const AssetArchiveEntry& entry = archive.getEntry(entryIndices[i]);
+		result.isValid = looseFile.open(loosePaths[i].c_str()) && archive.readEntry(entry, entryData)
+			&& looseFile.size() == entryData.size() && memcmp(looseFile.data(), entryData.data(), entryData.size()) == 0;
+	}
+
+	return result;
+}
+
+bool AssetLoadBenchmark::readUnbuffered(HANDLE file, uint64 offset, uint64 size, VectorArray<byte>& buffer, byte*& outData) {
+	const uint64 alignedSize = alignUnbuffered(size);
+	if (buffer.size() < alignedSize + UnbufferedAlignment) {
+		buffer.resize(static_cast<size_t>(alignedSize + UnbufferedAlignment));
+	}
+
+	const uint64 address = reinterpret_cast<uint64>(buffer.data());
+	outData = buffer.data() + (alignUnbuffered(address) - address);
+
+	//ファイルの末尾を越える分は読まれないだけなので、セクタに揃えた大きさで読んでよい
+	for (uint64 readOffset = 0; readOffset < alignedSize; readOffset += UnbufferedReadChunkSize) {
+		const uint64 readSize = min(UnbufferedReadChunkSize, alignedSize - readOffset);
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset + readOffset);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + readOffset) >> 32);
+
+		DWORD readBytes = 0;
+		if (!ReadFile(file, outData + readOffset, static_cast<DWORD>(readSize), &readBytes, &overlapped)) {
+			return false;
+		}
+
+		if (readBytes < readSize) {
+			return readOffset + readBytes >= size;
+		}
+	}
+
+	return true;
+}
+
+bool AssetLoadBenchmark::loadLooseCold(const String& filePath, VectorArray<byte>& buffer) {
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	byte* data = nullptr;
+	const bool isRead = GetFileSizeEx(file, &fileSize) && readUnbuffered(file, 0, static_cast<uint64>(fileSize.QuadPart), buffer, data);
+	CloseHandle(file);
+	return isRead;
+}
+
+bool AssetLoadBenchmark::loadArchiveCold(const String& archivePath, const VectorArray<uint32>& entryIndices, VectorArray<byte>& buffer) {
+	HANDLE file = CreateFileA(archivePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	//先頭のページからヘッダー、索引、パスを読む
+	byte* data = nullptr;
+	AssetArchiveHeader header = {};
+	bool isRead = readUnbuffered(file, 0, sizeof(AssetArchiveHeader), buffer, data);
+	if (isRead) {
+		memcpy(&header, data, sizeof(header));
+		isRead = readUnbuffered(file, 0, header.pathTableOffset + header.pathTableSize, buffer, data);
+	}
+
+	VectorArray<AssetArchiveEntry> entries(header.entryCount);
+	if (isRead) {
+		memcpy(entries.data(), data + header.indexOffset, sizeof(AssetArchiveEntry) * header.entryCount);
+	}
+
+	//エントリーはページ境界から始まるので、個別のファイルと同じくそのままキャッシュを通さずに読める
+	VectorArray<byte> decompressedData;
+	for (uint32 i = 0; i < entryIndices.size() && isRead; ++i) {
+		const AssetArchiveEntry& entry = entries[entryIndices[i]];
+		isRead = readUnbuffered(file, entry.offset, entry.storedSize, buffer, data);
+		if (isRead && entry.compression == ASSET_ARCHIVE_COMPRESSION_LZ4) {
+			decompressedData.resize(static_cast<size_t>(entry.size));
+			isRead = Lz4Codec::decompress(data, entry.storedSize, decompressedData.data(), entry.size);
+		}
+	}
+
+	CloseHandle(file);
+	return isRead;
+}
+
+bool AssetLoadBenchmark::loadLooseWarm(const String& filePath) {
+	MappedFile file;
+	if (!file.open(filePath.c_str())) {
+		return false;
+	}
+
+	file.prefetch(0, file.size());
+	return true;
+}
+
+bool AssetLoadBenchmark::loadArchiveWarm(const String& archivePath, const VectorArray<String>& entryPaths) {
+	//マウントと同じくアーカイブを開き、パスで引いてからエントリーの全ページに触れる
+	AssetArchive archive;
+	if (!archive.open(archivePath.c_str())) {
+		return false;
+	}
+
+	VectorArray<byte> decompressedData;
+	for (const auto& entryPath : entryPaths) {
+		const AssetArchiveEntry* entry = archive.findEntry(entryPath.c_str());
+		if (entry == nullptr) {
+			return false;
+		}
+
+		if (entry->compression != ASSET_ARCHIVE_COMPRESSION_NONE) {
+			archive.readEntry(*entry, decompressedData);
+		}
+		else {
+			archive.prefetch(*entry, 0, entry->size);
+		}
+	}
+
+	return true;
+}
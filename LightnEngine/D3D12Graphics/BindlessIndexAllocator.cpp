@@ -0,0 +1,84 @@
+#include "BindlessIndexAllocator.h"
+#include <cassert>
+
+BindlessIndexAllocator::BindlessIndexAllocator() :_nextUnusedIndex(0) {
+}
+
+void BindlessIndexAllocator::create(uint32 capacity) {
+	_generations.assign(capacity, 0);
+	_isAlive.assign(capacity, false);
+	_freeIndices.clear();
+	_nextUnusedIndex = 0;
+	_unsubmittedFrees.clear();
+	_pendingFrees.clear();
+
+	_statistics = Statistics();
+	_statistics.capacity = capacity;
+}
+
+BindlessHandle BindlessIndexAllocator::allocate() {
+	BindlessHandle handle;
+
+	//解放済みのインデックスを優先して使い、テーブルの使用範囲を小さく保つ
+	if (!_freeIndices.empty()) {
+		handle.index = _freeIndices.back();
+		_freeIndices.pop_back();
+	}
+	else if (_nextUnusedIndex < getCapacity()) {
+		handle.index = _nextUnusedIndex++;
+	}
+	else {
+		++_statistics.failedAllocationCount;
+		return handle;
+	}
+
+	handle.generation = _generations[handle.index];
+	_isAlive[handle.index] = true;
+
+	++_statistics.liveCount;
+	if (_statistics.liveCount > _statistics.peakLiveCount) {
+		_statistics.peakLiveCount = _statistics.liveCount;
+	}
+
+	return handle;
+}
+
+void BindlessIndexAllocator::free(const BindlessHandle& handle) {
+	//二重解放を空きリストに入れると同じインデックスを2回渡してしまうので、リリースビルドでも無視する
+	if (!isAlive(handle)) {
+		assert(false && "解放済みか世代の古いバインドレスハンドルを解放しようとしています");
+		return;
+	}
+
+	//ここで世代を進めるので、以降この古いハンドルはisAliveで弾かれる
+	++_generations[handle.index];
+	_isAlive[handle.index] = false;
+	_unsubmittedFrees.push_back(handle.index);
+
+	--_statistics.liveCount;
+	++_statistics.pendingFreeCount;
+}
+
+void BindlessIndexAllocator::submit(uint64 fenceValue) {
+	for (uint32 index : _unsubmittedFrees) {
+		_pendingFrees.push_back({ fenceValue, index });
+	}
+
+	_unsubmittedFrees.clear();
+}
+
+void BindlessIndexAllocator::reclaim(uint64 completedFenceValue) {
+	while (!_pendingFrees.empty() && _pendingFrees.front().fenceValue <= completedFenceValue) {
+		_freeIndices.push_back(_pendingFrees.front().index);
+		_pendingFrees.pop_front();
+		--_statistics.pendingFreeCount;
+	}
+}
+
+bool BindlessIndexAllocator::isAlive(const BindlessHandle& handle) const {
+	if (!handle.isValid() || handle.index >= getCapacity()) {
+		return false;
+	}
+
+	return _isAlive[handle.index] && _generations[handle.index] == handle.generation;
+}
@@ -1,4 +1,5 @@
 #include "CommandAllocatorPool.h"
+#include "CommandQueue.h"
 #include "D3D12Helper.h"
 
 CommandAllocatorPool::CommandAllocatorPool() :_commandListType(), _device(nullptr) {
@@ -8,42 +9,39 @@ CommandAllocatorPool::~CommandAllocatorPool() {
 	shutdown();
 }
 
-void CommandAllocatorPool::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type) {
+void CommandAllocatorPool::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, uint32 maxAllocatorCount) {
 	_commandListType = type;
 	_device = device;
+	_allocatorPool.create(maxAllocatorCount);
 }
 
 void CommandAllocatorPool::shutdown() {
-	for (size_t i = 0; i < _commandAllocatorPool.size(); ++i) {
-		_commandAllocatorPool[i]->Release();
+	const auto& allocators = _allocatorPool.getObjects();
+	for (size_t i = 0; i < allocators.size(); ++i) {
+		allocators[i]->Release();
 	}
 
-	_commandAllocatorPool.clear();
+	_allocatorPool.clear();
 }
 
-RefPtr<ID3D12CommandAllocator> CommandAllocatorPool::requestAllocator(UINT64 completedFenceValue) {
-	RefPtr<ID3D12CommandAllocator> allocator = nullptr;
-
-	//ԋpς݃AP[^[΂g
-	if (!_readyAllocators.empty()) {
-		auto& pair = _readyAllocators.front();
-
-		if (pair.first <= completedFenceValue) {
-			allocator = pair.second;
-			throwIfFailed(allocator->Reset());
-			_readyAllocators.pop();
-		}
-	}
-
-	//v[ȂvtFX̂̂ȂΐVĕԂ
-	if (allocator == nullptr) {
+RefPtr<ID3D12CommandAllocator> CommandAllocatorPool::requestAllocator(RefPtr<CommandQueue> commandQueue) {
+	//返却済みで完了しているものがなければ新しく生成する
+	//リセットはコマンドリストと合わせて要求側で行う
+	return _allocatorPool.request(*commandQueue, [this]() {
+		RefPtr<ID3D12CommandAllocator> allocator = nullptr;
 		throwIfFailed(_device->CreateCommandAllocator(_commandListType, IID_PPV_ARGS(&allocator)));
-		_commandAllocatorPool.push_back(allocator);
-	}
-
-	return allocator;
+		return allocator;
+	});
 }
 
 void CommandAllocatorPool::discardAllocator(UINT64 fenceValue, RefPtr<ID3D12CommandAllocator> allocator) {
-	_readyAllocators.push(std::make_pair(fenceValue, allocator));
+	_allocatorPool.discard(fenceValue, allocator);
+}
+
+size_t CommandAllocatorPool::size() {
+	return _allocatorPool.size();
+}
+
+FencedPoolStatistics CommandAllocatorPool::getStatistics() {
+	return _allocatorPool.getStatistics();
 }
@@ -3,6 +3,7 @@
 #include "CommandAllocatorPool.h"
 #include "CommandQueue.h"
 #include "D3D12Helper.h"
+#include "GraphicsConstantSettings.h"
 
 CommandContext::CommandContext():_commandListType(){
 }
@@ -13,8 +14,8 @@ CommandContext::~CommandContext() {
 void CommandContext::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type) {
 	_commandListType = type;
 
-	_commandListPool.create(device, _commandListType);
-	_commandAllocatorPool.create(device, _commandListType);
+	_commandListPool.create(device, _commandListType, MaxCommandAllocatorCountPerContext);
+	_commandAllocatorPool.create(device, _commandListType, MaxCommandAllocatorCountPerContext);
 	_commandQueue.create(device, _commandListType);
 }
 
@@ -23,8 +24,8 @@ void CommandContext::shutdown() {
 
 CommandListSet CommandContext::requestCommandListSet(RefPtr<ID3D12PipelineState> state) {
 	UINT64 fenceValue = _commandQueue.fenceValue();
-	auto allocator = _commandAllocatorPool.requestAllocator(fenceValue);
-	auto list = _commandListPool.requestCommandList(fenceValue, allocator);
+	auto allocator = _commandAllocatorPool.requestAllocator(&_commandQueue);
+	auto list = _commandListPool.requestCommandList(&_commandQueue, allocator);
 
 	throwIfFailed(allocator->Reset());
 	throwIfFailed(list->Reset(allocator, state));
@@ -33,7 +34,8 @@ CommandListSet CommandContext::requestCommandListSet(RefPtr<ID3D12PipelineState>
 }
 
 void CommandContext::discardCommandListSet(const CommandListSet & set) {
-	_commandListPool.discardCommandList(set.fenceValue, set.commandList);
+	//コマンドリストは実行に渡した時点で再利用できるのでフェンスを待たない
+	_commandListPool.discardCommandList(0, set.commandList);
 	_commandAllocatorPool.discardAllocator(set.fenceValue, set.allocator);
 }
 
@@ -45,10 +47,30 @@ void CommandContext::executeCommandList(CommandListSet & set) {
 	set.fenceValue = _commandQueue.executeCommandList(set.commandList);
 }
 
+void CommandContext::executeCommandLists(CommandListSet* sets, uint32 setCount) {
+	VectorArray<RefPtr<ID3D12CommandList>> commandLists(setCount);
+	for (uint32 i = 0; i < setCount; ++i) {
+		commandLists[i] = sets[i].commandList;
+	}
+
+	UINT64 fenceValue = _commandQueue.executeCommandLists(commandLists.data(), setCount);
+	for (uint32 i = 0; i < setCount; ++i) {
+		sets[i].fenceValue = fenceValue;
+	}
+}
+
 void CommandContext::waitForIdle() {
 	_commandQueue.waitForIdle();
 }
 
+FencedPoolStatistics CommandContext::getCommandAllocatorStatistics() {
+	return _commandAllocatorPool.getStatistics();
+}
+
+FencedPoolStatistics CommandContext::getCommandListStatistics() {
+	return _commandListPool.getStatistics();
+}
+
 RefPtr<CommandQueue> CommandContext::getCommandQueue(){
 	return &_commandQueue;
 }
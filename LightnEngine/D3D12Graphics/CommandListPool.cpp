@@ -1,4 +1,5 @@
 #include "CommandListPool.h"
+#include "CommandQueue.h"
 #include "D3D12Helper.h"
 
 CommandListPool::CommandListPool():_commandListType(), _device(nullptr) {
@@ -8,46 +9,39 @@ CommandListPool::~CommandListPool() {
 	shutdown();
 }
 
-void CommandListPool::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type) {
+void CommandListPool::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, uint32 maxCommandListCount) {
 	_commandListType = type;
 	_device = device;
+	_commandListPool.create(maxCommandListCount);
 }
 
 void CommandListPool::shutdown() {
-	for (size_t i = 0; i < _commandListPool.size(); ++i) {
-		_commandListPool[i]->Release();
+	const auto& commandLists = _commandListPool.getObjects();
+	for (size_t i = 0; i < commandLists.size(); ++i) {
+		commandLists[i]->Release();
 	}
 
 	_commandListPool.clear();
 }
 
-RefPtr<ID3D12GraphicsCommandList> CommandListPool::requestCommandList(UINT64 completedFenceValue, RefPtr<ID3D12CommandAllocator> allocator) {
-	RefPtr<ID3D12GraphicsCommandList> list = nullptr;
-
-	//ԋpς݃R}hXg΂g
-	if (!_readyCommandLists.empty()) {
-		auto& pair = _readyCommandLists.front();
-
-		if (pair.first <= completedFenceValue) {
-			list = pair.second;
-			_readyCommandLists.pop();
-		}
-	}
-
-	//v[ȂvtFX̂̂ȂΐVĕԂ
-	if (list == nullptr) {
+RefPtr<ID3D12GraphicsCommandList> CommandListPool::requestCommandList(RefPtr<CommandQueue> commandQueue, RefPtr<ID3D12CommandAllocator> allocator) {
+	//返却済みで完了しているものがなければ新しく生成して返す
+	return _commandListPool.request(*commandQueue, [this, allocator]() {
+		RefPtr<ID3D12GraphicsCommandList> list = nullptr;
 		throwIfFailed(_device->CreateCommandList(0, _commandListType, allocator, nullptr, IID_PPV_ARGS(&list)));
 		throwIfFailed(list->Close());
-		_commandListPool.push_back(list);
-	}
-
-	return list;
+		return list;
+	});
 }
 
 void CommandListPool::discardCommandList(UINT64 fenceValue, RefPtr<ID3D12GraphicsCommandList> list) {
-	_readyCommandLists.push(std::make_pair(fenceValue, list));
+	_commandListPool.discard(fenceValue, list);
 }
 
-inline size_t CommandListPool::getSize() const{
+size_t CommandListPool::getSize() {
 	return _commandListPool.size();
 }
+
+FencedPoolStatistics CommandListPool::getStatistics() {
+	return _commandListPool.getStatistics();
+}
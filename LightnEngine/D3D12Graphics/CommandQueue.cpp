@@ -1,8 +1,7 @@
 #include "CommandQueue.h"
 #include "D3D12Helper.h"
-#include "CommandAllocatorPool.h"
 
-CommandQueue::CommandQueue():_commandListType() {
+CommandQueue::CommandQueue():_commandQueue(nullptr), _nextFenceValue(1), _commandListType(), _lastFenceValue(0), _fence(nullptr) {
 }
 
 CommandQueue::~CommandQueue() {
@@ -12,71 +11,85 @@ CommandQueue::~CommandQueue() {
 void CommandQueue::create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type) {
 	_commandListType = type;
 
-	//R}hL[
+	//コマンドキュー生成
 	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
 	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
 	queueDesc.Type = _commandListType;
 	throwIfFailed(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&_commandQueue)));
 
-	//tFX
+	//フェンス生成
 	throwIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)));
-	_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-	if (_fenceEvent == nullptr) {
-		throwIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-	}
-
-	_commandAllocatorPool.create(device, _commandListType);
 }
 
 void CommandQueue::waitForFence(UINT64 fenceValue) {
-	//̃tFXlŐṼtFXlȉł΂łɏIĂ
+	//引数のフェンス値が最新のフェンス値以下であればすでに終了している
 	if (isFenceComplete(fenceValue)) {
 		return;
 	}
 
-	//tFX܂őҋ@
-	throwIfFailed(_fence->SetEventOnCompletion(fenceValue, _fenceEvent));
-	WaitForSingleObjectEx(_fenceEvent, INFINITE, FALSE);
-	_lastFenceValue = fenceValue;
+	//フェンスが完了するまで待機。コマンドプールは複数スレッドから同時に待つので、イベントを共有せずにこの呼び出しだけで待つ
+	throwIfFailed(_fence->SetEventOnCompletion(fenceValue, nullptr));
+	updateLastFenceValue(fenceValue);
 }
 
-//݂̃L[܂őҋ@
+//現在のキューが完了するまで待機
 void CommandQueue::waitForIdle() {
 	auto fenceValue = incrementFence();
 	waitForFence(fenceValue);
 }
 
-//tFXȉɂȂĂ邩H
+void CommandQueue::waitForQueue(RefPtr<CommandQueue> queue, UINT64 fenceValue) {
+	throwIfFailed(_commandQueue->Wait(queue->_fence, fenceValue));
+}
+
+//フェンスが引数以下になっているか？
 bool CommandQueue::isFenceComplete(UINT64 fenceValue) {
 	if (fenceValue > _lastFenceValue) {
-		_lastFenceValue = max(_lastFenceValue, _fence->GetCompletedValue());
+		updateLastFenceValue(_fence->GetCompletedValue());
 	}
 
 	return fenceValue <= _lastFenceValue;
 }
 
-//tFXɃVOioăCNg
+//他のスレッドがより新しい値にしていれば戻さない
+void CommandQueue::updateLastFenceValue(UINT64 fenceValue) {
+	UINT64 lastFenceValue = _lastFenceValue;
+	while (fenceValue > lastFenceValue && !_lastFenceValue.compare_exchange_weak(lastFenceValue, fenceValue)) {
+	}
+}
+
+//フェンスにシグナルを出してインクリメント
 UINT64 CommandQueue::incrementFence() {
 	throwIfFailed(_commandQueue->Signal(_fence, _nextFenceValue));
 	return _nextFenceValue++;
 }
 
 UINT64 CommandQueue::executeCommandList(RefPtr<ID3D12CommandList> commandList) {
-	//`R}hςݏÎŃR}hXg
+	//描画コマンドを積み終えたのでコマンドリストを閉じる
 	throwIfFailed((static_cast<ID3D12GraphicsCommandList*>(commandList))->Close());
 
-	//R}hL[ɃR}hXgnĎs
+	//コマンドキューにコマンドリストを渡して実行
 	_commandQueue->ExecuteCommandLists(1, &commandList);
 
 	return incrementFence();
 }
 
+UINT64 CommandQueue::executeCommandLists(RefPtr<ID3D12CommandList>* commandLists, uint32 commandListCount) {
+	for (uint32 i = 0; i < commandListCount; ++i) {
+		throwIfFailed((static_cast<ID3D12GraphicsCommandList*>(commandLists[i]))->Close());
+	}
+
+	//キュー内の実行順序でGPU側のパス間の依存関係を保証する
+	_commandQueue->ExecuteCommandLists(commandListCount, commandLists);
+
+	return incrementFence();
+}
+
 UINT64 CommandQueue::fenceValue() const{
 	return _fence->GetCompletedValue();
 }
 
 void CommandQueue::shutdown() {
-	CloseHandle(_fenceEvent);
 	_fence->Release();
 	_commandQueue->Release();
 	_fence = nullptr;
@@ -0,0 +1,296 @@
+#include "DdsLayout.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	constexpr uint32 makeFourCC(char c0, char c1, char c2, char c3) {
+		return static_cast<uint32>(static_cast<byte>(c0))
+			| (static_cast<uint32>(static_cast<byte>(c1)) << 8)
+			| (static_cast<uint32>(static_cast<byte>(c2)) << 16)
+			| (static_cast<uint32>(static_cast<byte>(c3)) << 24);
+	}
+
+	constexpr uint32 DdsMagic = makeFourCC('D', 'D', 'S', ' ');
+	constexpr uint32 DdsHeaderSize = 124;
+	constexpr uint32 DdsPixelFormatSize = 32;
+	constexpr uint32 Dx10HeaderSize = 20;
+
+	//DDS_HEADER内のオフセット(マジックの直後から)
+	constexpr uint32 HeaderHeightOffset = 8;
+	constexpr uint32 HeaderWidthOffset = 12;
+	constexpr uint32 HeaderDepthOffset = 20;
+	constexpr uint32 HeaderMipCountOffset = 24;
+	constexpr uint32 HeaderPixelFormatOffset = 72;
+	constexpr uint32 HeaderCaps2Offset = 108;
+
+	constexpr uint32 DdsHeaderFlagsVolume = 0x00800000;
+	constexpr uint32 DdsCaps2CubeMap = 0x00000200;
+	constexpr uint32 DdsPixelFormatFourCC = 0x00000004;
+	constexpr uint32 DdsPixelFormatRgb = 0x00000040;
+	constexpr uint32 DdsPixelFormatLuminance = 0x00020000;
+	constexpr uint32 Dx10MiscTextureCube = 0x4;
+	constexpr uint32 Dx10ResourceDimensionTexture3D = 4;
+
+	//使用するDXGI_FORMATの値。ヘッダーをD3D12なしで扱うため数値で持つ
+	enum DxgiFormat : uint32 {
+		DXGI_FORMAT_VALUE_UNKNOWN = 0,
+		DXGI_FORMAT_VALUE_R32G32B32A32_FLOAT = 2,
+		DXGI_FORMAT_VALUE_R16G16B16A16_FLOAT = 10,
+		DXGI_FORMAT_VALUE_R16G16B16A16_UNORM = 11,
+		DXGI_FORMAT_VALUE_R8G8B8A8_UNORM = 28,
+		DXGI_FORMAT_VALUE_R32_FLOAT = 41,
+		DXGI_FORMAT_VALUE_R16_FLOAT = 54,
+		DXGI_FORMAT_VALUE_R8_UNORM = 61,
+		DXGI_FORMAT_VALUE_BC1_UNORM = 71,
+		DXGI_FORMAT_VALUE_BC2_UNORM = 74,
+		DXGI_FORMAT_VALUE_BC3_UNORM = 77,
+		DXGI_FORMAT_VALUE_BC4_UNORM = 80,
+		DXGI_FORMAT_VALUE_BC4_SNORM = 81,
+		DXGI_FORMAT_VALUE_BC5_UNORM = 83,
+		DXGI_FORMAT_VALUE_BC5_SNORM = 84,
+		DXGI_FORMAT_VALUE_B8G8R8A8_UNORM = 87,
+		DXGI_FORMAT_VALUE_B8G8R8X8_UNORM = 88,
+	};
+
+	uint32 readUint32(const byte* data, uint64 offset) {
+		uint32 value = 0;
+		memcpy(&value, data + offset, sizeof(value));
+		return value;
+	}
+
+	//DX10拡張ヘッダーのない旧形式のピクセルフォーマットをDXGI_FORMATに変換する
+	uint32 convertLegacyPixelFormat(const byte* pixelFormat) {
+		const uint32 flags = readUint32(pixelFormat, 4);
+		const uint32 fourCC = readUint32(pixelFormat, 8);
+		const uint32 bitCount = readUint32(pixelFormat, 12);
+		const uint32 redMask = readUint32(pixelFormat, 16);
+		const uint32 greenMask = readUint32(pixelFormat, 20);
+		const uint32 blueMask = readUint32(pixelFormat, 24);
+		const uint32 alphaMask = readUint32(pixelFormat, 28);
+
+		if (flags & DdsPixelFormatFourCC) {
+			switch (fourCC) {
+			case makeFourCC('D', 'X', 'T', '1'): return DXGI_FORMAT_VALUE_BC1_UNORM;
+			case makeFourCC('D', 'X', 'T', '2'):
+			case makeFourCC('D', 'X', 'T', '3'): return DXGI_FORMAT_VALUE_BC2_UNORM;
+			case makeFourCC('D', 'X', 'T', '4'):
+			case makeFourCC('D', 'X', 'T', '5'): return DXGI_FORMAT_VALUE_BC3_UNORM;
+			case makeFourCC('A', 'T', 'I', '1'):
+			case makeFourCC('B', 'C', '4', 'U'): return DXGI_FORMAT_VALUE_BC4_UNORM;
+			case makeFourCC('B', 'C', '4', 'S'): return DXGI_FORMAT_VALUE_BC4_SNORM;
+			case makeFourCC('A', 'T', 'I', '2'):
+			case makeFourCC('B', 'C', '5', 'U'): return DXGI_FORMAT_VALUE_BC5_UNORM;
+			case makeFourCC('B', 'C', '5', 'S'): return DXGI_FORMAT_VALUE_BC5_SNORM;
+
+			//D3DFORMATの数値がそのまま入っている形式
+			case 36: return DXGI_FORMAT_VALUE_R16G16B16A16_UNORM;
+			case 111: return DXGI_FORMAT_VALUE_R16_FLOAT;
+			case 113: return DXGI_FORMAT_VALUE_R16G16B16A16_FLOAT;
+			case 114: return DXGI_FORMAT_VALUE_R32_FLOAT;
+			case 116: return DXGI_FORMAT_VALUE_R32G32B32A32_FLOAT;
+			default: return DXGI_FORMAT_VALUE_UNKNOWN;
+			}
+		}
+
+		if ((flags & DdsPixelFormatRgb) && bitCount == 32) {
+			if (redMask == 0x000000ff && greenMask == 0x0000ff00 && blueMask == 0x00ff0000 && alphaMask == 0xff000000) {
+				return DXGI_FORMAT_VALUE_R8G8B8A8_UNORM;
+			}
+
+			if (redMask == 0x00ff0000 && greenMask == 0x0000ff00 && blueMask == 0x000000ff) {
+				return alphaMask == 0xff000000 ? DXGI_FORMAT_VALUE_B8G8R8A8_UNORM : DXGI_FORMAT_VALUE_B8G8R8X8_UNORM;
+			}
+		}
+
+		if ((flags & DdsPixelFormatLuminance) && bitCount == 8) {
+			return DXGI_FORMAT_VALUE_R8_UNORM;
+		}
+
+		return DXGI_FORMAT_VALUE_UNKNOWN;
+	}
+}
+
+DdsLayout::DdsLayout() :
+	_width(0), _height(0), _depth(0), _mipCount(0), _arraySize(0), _format(0), _isCubeMap(false), _dataOffset(0), _fileSize(0) {
+}
+
+bool DdsLayout::parse(const void* headerData, uint64 headerDataSize) {
+	_subresources.clear();
+
+	const byte* data = reinterpret_cast<const byte*>(headerData);
+	if (headerDataSize < sizeof(uint32) + DdsHeaderSize || readUint32(data, 0) != DdsMagic) {
+		return false;
+	}
+
+	const byte* header = data + sizeof(uint32);
+	if (readUint32(header, 0) != DdsHeaderSize || readUint32(header, HeaderPixelFormatOffset) != DdsPixelFormatSize) {
+		return false;
+	}
+
+	const uint32 headerFlags = readUint32(header, 4);
+	_width = readUint32(header, HeaderWidthOffset);
+	_height = readUint32(header, HeaderHeightOffset);
+	_depth = (headerFlags & DdsHeaderFlagsVolume) ? std::max(readUint32(header, HeaderDepthOffset), 1u) : 1;
+	_mipCount = std::max(readUint32(header, HeaderMipCountOffset), 1u);
+	_arraySize = 1;
+	_isCubeMap = false;
+	_dataOffset = sizeof(uint32) + DdsHeaderSize;
+
+	const byte* pixelFormat = header + HeaderPixelFormatOffset;
+	const bool hasDx10Header = (readUint32(pixelFormat, 4) & DdsPixelFormatFourCC) && readUint32(pixelFormat, 8) == makeFourCC('D', 'X', '1', '0');
+
+	if (hasDx10Header) {
+		if (headerDataSize < _dataOffset + Dx10HeaderSize) {
+			return false;
+		}
+
+		const byte* dx10Header = data + _dataOffset;
+		_format = readUint32(dx10Header, 0);
+		_isCubeMap = (readUint32(dx10Header, 8) & Dx10MiscTextureCube) != 0;
+		_arraySize = std::max(readUint32(dx10Header, 12), 1u);
+		if (readUint32(dx10Header, 4) != Dx10ResourceDimensionTexture3D) {
+			_depth = 1;
+		}
+
+		_dataOffset += Dx10HeaderSize;
+	}
+	else {
+		_format = convertLegacyPixelFormat(pixelFormat);
+		_isCubeMap = (readUint32(header, HeaderCaps2Offset) & DdsCaps2CubeMap) != 0;
+	}
+
+	//キューブマップは6面をスライスとして並べる
+	if (_isCubeMap) {
+		_arraySize *= 6;
+	}
+
+	if (_width == 0 || _height == 0 || (getBlockSize(_format) == 0 && getBitsPerPixel(_format) == 0)) {
+		return false;
+	}
+
+	//ミップ数が幅・高さから作れる数を超えている壊れたヘッダーを弾く
+	uint32 maxMipCount = 1;
+	for (uint32 size = std::max(std::max(_width, _height), _depth); size > 1; size >>= 1) {
+		++maxMipCount;
+	}
+
+	if (_mipCount > maxMipCount) {
+		return false;
+	}
+
+	computeSubresources();
+	return true;
+}
+
+uint32 DdsLayout::getBlockSize(uint32 dxgiFormat) {
+	//BC1・BC4は8バイト、それ以外のBCは16バイトで4x4ピクセル
+	if (dxgiFormat >= 70 && dxgiFormat <= 72) {
+		return 8;
+	}
+
+	if (dxgiFormat >= 79 && dxgiFormat <= 81) {
+		return 8;
+	}
+
+	if ((dxgiFormat >= 73 && dxgiFormat <= 78) || (dxgiFormat >= 82 && dxgiFormat <= 84) || (dxgiFormat >= 94 && dxgiFormat <= 99)) {
+		return 16;
+	}
+
+	return 0;
+}
+
+uint32 DdsLayout::getBitsPerPixel(uint32 dxgiFormat) {
+	if (dxgiFormat >= 1 && dxgiFormat <= 4) {
+		return 128;
+	}
+
+	if (dxgiFormat >= 5 && dxgiFormat <= 8) {
+		return 96;
+	}
+
+	if (dxgiFormat >= 9 && dxgiFormat <= 22) {
+		return 64;
+	}
+
+	if ((dxgiFormat >= 23 && dxgiFormat <= 47) || dxgiFormat == 67 || (dxgiFormat >= 87 && dxgiFormat <= 93)) {
+		return 32;
+	}
+
+	if ((dxgiFormat >= 48 && dxgiFormat <= 59) || dxgiFormat == 85 || dxgiFormat == 86 || dxgiFormat == 115) {
+		return 16;
+	}
+
+	if (dxgiFormat >= 60 && dxgiFormat <= 65) {
+		return 8;
+	}
+
+	return 0;
+}
+
+uint64 DdsLayout::getMipChainSize(uint32 firstMip) const {
+	uint64 size = 0;
+	for (uint32 slice = 0; slice < _arraySize; ++slice) {
+		for (uint32 mip = firstMip; mip < _mipCount; ++mip) {
+			size += getSubresource(mip, slice).size;
+		}
+	}
+
+	return size;
+}
+
+bool DdsLayout::isStreamable() const {
+	return _arraySize == 1 && _depth == 1 && !_isCubeMap && _mipCount > 1;
+}
+
+bool DdsLayout::isValidTopMip(uint32 mipLevel) const {
+	if (mipLevel >= _mipCount) {
+		return false;
+	}
+
+	if (getBlockSize(_format) == 0) {
+		return true;
+	}
+
+	const DdsSubresourceLayout& subresource = getSubresource(mipLevel);
+	return subresource.width % 4 == 0 && subresource.height % 4 == 0;
+}
+
+void DdsLayout::computeSubresources() {
+	const uint32 blockSize = getBlockSize(_format);
+	const uint32 bitsPerPixel = getBitsPerPixel(_format);
+
+	_subresources.resize(static_cast<size_t>(_arraySize) * _mipCount);
+
+	uint64 offset = _dataOffset;
+	for (uint32 slice = 0; slice < _arraySize; ++slice) {
+		uint32 width = _width;
+		uint32 height = _height;
+		uint32 depth = _depth;
+
+		for (uint32 mip = 0; mip < _mipCount; ++mip) {
+			DdsSubresourceLayout& subresource = _subresources[slice * _mipCount + mip];
+			subresource.width = width;
+			subresource.height = height;
+			subresource.depth = depth;
+
+			if (blockSize > 0) {
+				subresource.rowPitch = std::max(1u, (width + 3) / 4) * blockSize;
+				subresource.rowCount = std::max(1u, (height + 3) / 4);
+			}
+			else {
+				subresource.rowPitch = (width * bitsPerPixel + 7) / 8;
+				subresource.rowCount = height;
+			}
+
+			subresource.offset = offset;
+			subresource.size = static_cast<uint64>(subresource.rowPitch) * subresource.rowCount * depth;
+			offset += subresource.size;
+
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+			depth = std::max(depth / 2, 1u);
+		}
+	}
+
+	_fileSize = offset;
+}
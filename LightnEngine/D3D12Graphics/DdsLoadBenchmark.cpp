@@ -0,0 +1,109 @@
+#include "DdsLoadBenchmark.h"
+#include "DdsLayout.h"
+#include <MappedFile.h>
+#include <fstream>
+
+DdsLoadBenchmarkResult DdsLoadBenchmark::run(const String& directory) {
+	DdsLoadBenchmarkResult result;
+
+	//ブロック圧縮のDDSだけを集める
+	VectorArray<String> filePaths;
+	WIN32_FIND_DATAA findData = {};
+	HANDLE findHandle = FindFirstFileA((directory + "*.dds").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE) {
+		return result;
+	}
+
+	do {
+		const String filePath = directory + findData.cFileName;
+		MappedFile file;
+		DdsLayout layout;
+		if (file.open(filePath.c_str()) && layout.parse(file.data(), min(file.size(), static_cast<uint64>(DdsLayout::MaxHeaderSize)))
+			&& DdsLayout::getBlockSize(layout.getFormat()) > 0) {
+			filePaths.push_back(filePath);
+			result.totalSize += file.size();
+		}
+	} while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+
+	VectorArray<byte> fileData;
+	VectorArray<byte> uploadData;
+	for (const auto& filePath : filePaths) {
+		loadWithRead(filePath, fileData, uploadData);
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER startTime;
+	LARGE_INTEGER endTime;
+	QueryPerformanceFrequency(&frequency);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& filePath : filePaths) {
+		result.fileCount += loadWithRead(filePath, fileData, uploadData) ? 1 : 0;
+	}
+	QueryPerformanceCounter(&endTime);
+	result.readSeconds = (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& filePath : filePaths) {
+		loadWithMapping(filePath, uploadData);
+	}
+	QueryPerformanceCounter(&endTime);
+	result.mappedSeconds = (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+
+	return result;
+}
+
+bool DdsLoadBenchmark::loadWithRead(const String& filePath, VectorArray<byte>& fileData, VectorArray<byte>& uploadData) {
+	std::ifstream file(filePath.c_str(), std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	const uint64 fileSize = static_cast<uint64>(file.tellg());
+	fileData.resize(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(fileData.data()), static_cast<std::streamsize>(fileSize));
+
+	return copyToUploadData(fileData.data(), fileSize, uploadData);
+}
+
+bool DdsLoadBenchmark::loadWithMapping(const String& filePath, VectorArray<byte>& uploadData) {
+	MappedFile file;
+	if (!file.open(filePath.c_str())) {
+		return false;
+	}
+
+	return copyToUploadData(file.data(), file.size(), uploadData);
+}
+
+bool DdsLoadBenchmark::copyToUploadData(const void* fileData, uint64 fileSize, VectorArray<byte>& uploadData) {
+	DdsLayout layout;
+	if (!layout.parse(fileData, min(fileSize, static_cast<uint64>(DdsLayout::MaxHeaderSize))) || fileSize < layout.getFileSize()) {
+		return false;
+	}
+
+	const byte* src = reinterpret_cast<const byte*>(fileData);
+	uint64 uploadOffset = 0;
+	for (uint32 slice = 0; slice < layout.getArraySize(); ++slice) {
+		for (uint32 mip = 0; mip < layout.getMipCount(); ++mip) {
+			const DdsSubresourceLayout& subresource = layout.getSubresource(mip, slice);
+			const uint32 uploadRowPitch = (subresource.rowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+			const uint64 uploadSize = static_cast<uint64>(uploadRowPitch) * subresource.rowCount * subresource.depth;
+
+			uploadOffset = (uploadOffset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~static_cast<uint64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+			if (uploadData.size() < uploadOffset + uploadSize) {
+				uploadData.resize(static_cast<size_t>(uploadOffset + uploadSize));
+			}
+
+			const uint32 rowCount = subresource.rowCount * subresource.depth;
+			for (uint32 row = 0; row < rowCount; ++row) {
+				memcpy(uploadData.data() + uploadOffset + static_cast<uint64>(uploadRowPitch) * row, src + subresource.offset + static_cast<uint64>(subresource.rowPitch) * row, subresource.rowPitch);
+			}
+
+			uploadOffset += uploadSize;
+		}
+	}
+
+	return true;
+}
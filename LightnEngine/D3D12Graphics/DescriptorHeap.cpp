@@ -1,102 +1,334 @@
 #include "DescriptorHeap.h"
 #include "D3D12Helper.h"
 #include "D3D12Util.h"
-
-#include <GenericAllocator.h>
+#include "GraphicsConstantSettings.h"
 
 DescriptorHeapManager* Singleton<DescriptorHeapManager>::_singleton = 0;
 
-DescriptorHeap::DescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) :_descriptorHeapType(type) {
+namespace {
+	D3D12_SHADER_RESOURCE_VIEW_DESC textureSrvDesc(RefPtr<ID3D12Resource> texture) {
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		auto desc = texture->GetDesc();
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Format = desc.Format;
+
+		//テクスチャ配列が６枚あればキューブマップとして処理する...
+		if (desc.DepthOrArraySize == 6) {
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MipLevels = desc.MipLevels;
+		}
+		else {
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = desc.MipLevels;
+		}
+
+		return srvDesc;
+	}
 }
 
+DescriptorStagingHeap::DescriptorStagingHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) :
+	_descriptorHeapType(type), _device(nullptr), _descriptorCountPerPage(0), _incrimentSize(0) {
+}
 
-DescriptorHeap::~DescriptorHeap() {
+DescriptorStagingHeap::~DescriptorStagingHeap() {
 	shutdown();
 }
 
-void DescriptorHeap::create(RefPtr<ID3D12Device> device, uint32 maxDescriptorCount) {
-	D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	if (_descriptorHeapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) {
-		flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+void DescriptorStagingHeap::create(RefPtr<ID3D12Device> device, uint32 descriptorCountPerPage) {
+	_device = device;
+	_descriptorCountPerPage = descriptorCountPerPage;
+	_incrimentSize = device->GetDescriptorHandleIncrementSize(_descriptorHeapType);
+
+	createPage(_descriptorCountPerPage);
+}
+
+void DescriptorStagingHeap::shutdown() {
+	_pages.clear();
+	_device = nullptr;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorStagingHeap::allocate(uint32 descriptorCount, DescriptorAllocation& outAllocation) {
+	assert(descriptorCount > 0 && "デスクリプタを0個確保しようとしています");
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	uint32 pageIndex = 0;
+	TlsfAllocator::Allocation block;
+	for (uint32 i = 0; i < _pages.size(); ++i) {
+		block = _pages[i]->allocator.allocate(descriptorCount, 1);
+		if (block.isValid()) {
+			pageIndex = i;
+			break;
+		}
+	}
+
+	//どのページにも入らなければページを追加する
+	if (!block.isValid()) {
+		pageIndex = createPage(max(descriptorCount, _descriptorCountPerPage));
+		block = _pages[pageIndex]->allocator.allocate(descriptorCount, 1);
 	}
 
+	outAllocation.page = pageIndex;
+	outAllocation.block = block;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = _pages[pageIndex]->cpuHandleStart;
+	handle.ptr += _incrimentSize * static_cast<SIZE_T>(block.offset);
+	return handle;
+}
+
+void DescriptorStagingHeap::free(const DescriptorAllocation& allocation) {
+	//シャットダウン後の破棄は無視する
+	if (!allocation.isValid() || _device == nullptr) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pages[allocation.page]->allocator.free(allocation.block);
+}
+
+DescriptorStagingHeap::Statistics DescriptorStagingHeap::getStatistics() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Statistics statistics;
+	statistics.pageCount = static_cast<uint32>(_pages.size());
+	for (const auto& page : _pages) {
+		statistics.capacity += page->allocator.getCapacity();
+		statistics.usedCount += page->allocator.getStatistics().usedSize;
+	}
+
+	return statistics;
+}
+
+uint32 DescriptorStagingHeap::createPage(uint32 descriptorCount) {
+	UniquePtr<Page> page = makeUnique<Page>();
+
 	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-	heapDesc.NumDescriptors = MAX_HEAP_NUM;
+	heapDesc.NumDescriptors = descriptorCount;
 	heapDesc.Type = _descriptorHeapType;
-	heapDesc.Flags = flags;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	throwIfFailed(_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&page->descriptorHeap)));
+	NAME_D3D12_OBJECT(page->descriptorHeap.Get());
+
+	page->cpuHandleStart = page->descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+	page->allocator.create(descriptorCount, 1);
+
+	_pages.emplace_back(std::move(page));
+	return static_cast<uint32>(_pages.size() - 1);
+}
+
+ShaderVisibleDescriptorHeap::ShaderVisibleDescriptorHeap() :
+	_device(nullptr), _cpuHandleStart(), _gpuHandleStart(), _incrimentSize(0), _persistentDescriptorCount(0), _ringCopyCount(0) {
+}
+
+ShaderVisibleDescriptorHeap::~ShaderVisibleDescriptorHeap() {
+	shutdown();
+}
+
+void ShaderVisibleDescriptorHeap::create(RefPtr<ID3D12Device> device, uint32 persistentDescriptorCount, uint32 ringDescriptorCount) {
+	_device = device;
+	_persistentDescriptorCount = persistentDescriptorCount;
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = persistentDescriptorCount + ringDescriptorCount;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	throwIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&_descriptorHeap)));
 	NAME_D3D12_OBJECT(_descriptorHeap.Get());
 
-	_incrimentSize = device->GetDescriptorHandleIncrementSize(_descriptorHeapType);
+	_incrimentSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	_cpuHandleStart = _descriptorHeap->GetCPUDescriptorHandleForHeapStart();
 	_gpuHandleStart = _descriptorHeap->GetGPUDescriptorHandleForHeapStart();
 
-	_allocator = new GenericAllocator(sizeof(BufferView));
-	_allocator->init(maxDescriptorCount);
+	_persistentAllocator.create(persistentDescriptorCount, 1);
+	_ringAllocator.create(ringDescriptorCount);
+	_ringCopyCount = 0;
 }
 
-void DescriptorHeap::shutdown() {
-	delete _allocator;
+void ShaderVisibleDescriptorHeap::shutdown() {
 	_descriptorHeap = nullptr;
+	_device = nullptr;
+}
+
+bool ShaderVisibleDescriptorHeap::allocatePersistent(uint32 descriptorCount, DescriptorAllocation& outAllocation) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	outAllocation.page = 0;
+	outAllocation.block = _persistentAllocator.allocate(descriptorCount, 1);
+	return outAllocation.isValid();
+}
+
+void ShaderVisibleDescriptorHeap::freePersistent(const DescriptorAllocation& allocation) {
+	if (!allocation.isValid() || _device == nullptr) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_persistentAllocator.free(allocation.block);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ShaderVisibleDescriptorHeap::copyToRing(D3D12_CPU_DESCRIPTOR_HANDLE srcHandle, uint32 descriptorCount) {
+	assert(srcHandle.ptr != 0 && descriptorCount > 0 && "無効なビューをリングにコピーしようとしています");
+
+	uint64 offset = FencedRingAllocator::InvalidOffset;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		offset = _ringAllocator.allocate(descriptorCount, 1);
+		++_ringCopyCount;
+	}
+
+	//記録中のフレームは自分自身の完了を待てないので、足りなければDescriptorRingCountを見直す
+	//無効なオフセットのままコピーするとヒープの外に書き込むので、リリースビルドでも例外で止める
+	if (offset == FencedRingAllocator::InvalidOffset) {
+		assert(false && "デスクリプタリングが不足しています");
+		throwIfFailed(E_OUTOFMEMORY);
+	}
+
+	//コピーはデバイスのフリースレッドなメソッドなのでロックの外で行う
+	const uint64 descriptorIndex = _persistentDescriptorCount + offset;
+	_device->CopyDescriptorsSimple(descriptorCount, cpuHandle(descriptorIndex), srcHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return gpuHandle(descriptorIndex);
+}
+
+void ShaderVisibleDescriptorHeap::submit(uint64 fenceValue) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_ringAllocator.submit(fenceValue);
+}
+
+void ShaderVisibleDescriptorHeap::reclaim(uint64 completedFenceValue) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_ringAllocator.reclaim(completedFenceValue);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ShaderVisibleDescriptorHeap::gpuHandle(uint64 descriptorIndex) const {
+	D3D12_GPU_DESCRIPTOR_HANDLE handle = _gpuHandleStart;
+	handle.ptr += _incrimentSize * descriptorIndex;
+	return handle;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ShaderVisibleDescriptorHeap::cpuHandle(uint64 descriptorIndex) const {
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = _cpuHandleStart;
+	handle.ptr += _incrimentSize * static_cast<SIZE_T>(descriptorIndex);
+	return handle;
+}
+
+ShaderVisibleDescriptorHeap::Statistics ShaderVisibleDescriptorHeap::getStatistics() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Statistics statistics;
+	statistics.persistentCapacity = _persistentAllocator.getCapacity();
+	statistics.persistentUsedCount = _persistentAllocator.getStatistics().usedSize;
+	statistics.ringCapacity = _ringAllocator.getCapacity();
+	statistics.ringUsedCount = _ringAllocator.getUsedSize();
+	statistics.ringPeakUsedCount = _ringAllocator.getStatistics().peakUsedSize;
+	statistics.ringCopyCount = _ringCopyCount;
+	return statistics;
+}
+
+BindlessDescriptorTable::BindlessDescriptorTable() :_heap(nullptr) {
+}
+
+void BindlessDescriptorTable::create(RefPtr<ShaderVisibleDescriptorHeap> heap, uint32 capacity) {
+	_heap = heap;
+
+	//テーブルは連続している必要があるので永続領域の先頭でまとめて確保する
+	const bool isAllocated = _heap->allocatePersistent(capacity, _tableAllocation);
+	assert(isAllocated && "バインドレステーブルを永続領域に確保できません");
+
+	_indexAllocator.create(capacity);
 }
 
-void DescriptorHeap::allocateBufferView(RefPtr<BufferView> bufferView, uint32 descriptorCount) {
-	void* bufferViewPtr = _allocator->divideMemory(descriptorCount);
-	Block* block = _allocator->getBlockFromDataPtr(bufferViewPtr);
+void BindlessDescriptorTable::shutdown() {
+	if (_heap != nullptr) {
+		_heap->freePersistent(_tableAllocation);
+	}
 
-	bufferView->location = _allocator->blockLocalIndex(block);
-	bufferView->size = block->size;
-	bufferView->gpuHandle = gpuHandle(bufferView->location);
-	bufferView->cpuHandle = cpuHandle(bufferView->location);
+	_heap = nullptr;
 }
 
-void DescriptorHeap::discardBufferView(const BufferView& bufferView) {
-	//fXNv^[̃CfbNX烁AP[^[̊Ǘf[^|C^𕜌
-	void* bufferViewPtr = _allocator->getDataPtrFromBlockLocation(bufferView.location);
-	_allocator->releaseMemory(bufferViewPtr);
+BindlessHandle BindlessDescriptorTable::allocate(D3D12_CPU_DESCRIPTOR_HANDLE& outCpuHandle) {
+	BindlessHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		handle = _indexAllocator.allocate();
+	}
+
+	//無効なインデックスのままハンドルを作るとヒープの外にビューを書き込むので、リングと同じくリリースビルドでも例外で止める
+	if (!handle.isValid()) {
+		assert(false && "バインドレステーブルが不足しています");
+		throwIfFailed(E_OUTOFMEMORY);
+	}
+
+	outCpuHandle = _heap->cpuHandle(_tableAllocation.block.offset + handle.index);
+	return handle;
 }
 
-D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::gpuHandle(ulong2 bufferViewLocation) const {
-	D3D12_GPU_DESCRIPTOR_HANDLE rtvHandle = _gpuHandleStart;
-	rtvHandle.ptr += _incrimentSize * static_cast<SIZE_T>(bufferViewLocation);
-	return rtvHandle;
+void BindlessDescriptorTable::free(const BindlessHandle& handle) {
+	//シャットダウン後の解放は無視する
+	if (!handle.isValid() || _heap == nullptr) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_indexAllocator.free(handle);
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::cpuHandle(ulong2 bufferViewLocation) const {
-	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = _cpuHandleStart;
-	rtvHandle.ptr += _incrimentSize * static_cast<SIZE_T>(bufferViewLocation);
-	return rtvHandle;
+void BindlessDescriptorTable::submit(uint64 fenceValue) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_indexAllocator.submit(fenceValue);
 }
 
-RefPtr<ID3D12DescriptorHeap> DescriptorHeap::descriptorHeap() const{
-	return _descriptorHeap.Get();
+void BindlessDescriptorTable::reclaim(uint64 completedFenceValue) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_indexAllocator.reclaim(completedFenceValue);
 }
 
-UINT DescriptorHeap::incrimentSize() const{
-	return _incrimentSize;
+bool BindlessDescriptorTable::isAlive(const BindlessHandle& handle) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _indexAllocator.isAlive(handle);
+}
+
+RefBufferView BindlessDescriptorTable::getRefBufferView() const {
+	const uint64 tableOffset = _tableAllocation.block.offset;
+	return RefBufferView(_heap->gpuHandle(tableOffset), _heap->cpuHandle(tableOffset), _indexAllocator.getCapacity());
+}
+
+BindlessIndexAllocator::Statistics BindlessDescriptorTable::getStatistics() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _indexAllocator.getStatistics();
+}
+
+uint32 BindlessDescriptorTable::getUsedRange() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _indexAllocator.getUsedRange();
 }
 
 DescriptorHeapManager::DescriptorHeapManager():
 	_rtvHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV),
 	_dsvHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV),
-	_cbvSrvHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) {
+	_cbvSrvStagingHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) {
 }
 
 DescriptorHeapManager::~DescriptorHeapManager() {
 }
 
 void DescriptorHeapManager::create(RefPtr<ID3D12Device> device) {
-	_rtvHeap.create(device);
-	_dsvHeap.create(device);
-	_cbvSrvHeap.create(device);
+	_rtvHeap.create(device, RenderTargetDescriptorPageSize);
+	_dsvHeap.create(device, RenderTargetDescriptorPageSize);
+	_cbvSrvStagingHeap.create(device, StagingDescriptorPageSize);
+	_cbvSrvHeap.create(device, PersistentDescriptorCount, DescriptorRingCount);
+	_bindlessTable.create(&_cbvSrvHeap, BindlessDescriptorCount);
 }
 
 void DescriptorHeapManager::shutdown() {
+	_bindlessTable.shutdown();
+	_cbvSrvHeap.shutdown();
+	_cbvSrvStagingHeap.shutdown();
+	_dsvHeap.shutdown();
+	_rtvHeap.shutdown();
 }
 
 void DescriptorHeapManager::createRenderTargetView(RefAddressOf<ID3D12Resource> textureBuffers, RefPtr<BufferView> dstView, uint32 viewCount) {
 	assert(viewCount > 0 && "Request RenderTarget View 0");
-	_rtvHeap.allocateBufferView(dstView, viewCount);
+	dstView->cpuHandle = _rtvHeap.allocate(viewCount, dstView->stagingAllocation);
+	dstView->size = viewCount;
 
 	ID3D12Device* device = nullptr;
 	textureBuffers[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
@@ -119,30 +351,27 @@ void DescriptorHeapManager::createRenderTargetView(RefAddressOf<ID3D12Resource>
 	device->Release();
 }
 
-void DescriptorHeapManager::createConstantBufferView(RefAddressOf<ID3D12Resource> constantBuffers, RefPtr<BufferView> dstView, uint32 viewCount) {
+void DescriptorHeapManager::createConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* viewDescs, RefPtr<BufferView> dstView, uint32 viewCount) {
 	assert(viewCount > 0 && "Request ConstantBuffer View 0");
-	_cbvSrvHeap.allocateBufferView(dstView, viewCount);
+	allocateCbvSrvUavView(dstView, viewCount);
 
 	ID3D12Device* device = nullptr;
-	constantBuffers[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
+	_cbvSrvHeap.descriptorHeap()->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = dstView->cpuHandle;
-	D3D12_CONSTANT_BUFFER_VIEW_DESC constantDesc = {};
 	for (uint32 i = 0; i < viewCount; ++i) {
-		auto desc = constantBuffers[i]->GetDesc();
-		constantDesc.BufferLocation = constantBuffers[i]->GetGPUVirtualAddress();
-		constantDesc.SizeInBytes = static_cast<UINT>(desc.Width);
-
-		device->CreateConstantBufferView(&constantDesc, descriptorHandle);
-		descriptorHandle.ptr += _cbvSrvHeap.incrimentSize();
+		device->CreateConstantBufferView(&viewDescs[i], descriptorHandle);
+		descriptorHandle.ptr += _cbvSrvStagingHeap.incrimentSize();
 	}
 
 	device->Release();
+
+	makeResident(dstView);
 }
 
 void DescriptorHeapManager::createShaderResourceView(RefAddressOf<ID3D12Resource> shaderResources, RefPtr<BufferView> dstView, uint32 viewCount, const VectorArray<D3D12_BUFFER_SRV>& buffers) {
 	assert(viewCount > 0 && "Request ShaderResource View 0");
-	_cbvSrvHeap.allocateBufferView(dstView, viewCount);
+	allocateCbvSrvUavView(dstView, viewCount);
 
 	ID3D12Device* device = nullptr;
 	shaderResources[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
@@ -157,46 +386,37 @@ void DescriptorHeapManager::createShaderResourceView(RefAddressOf<ID3D12Resource
 		srvDesc.Buffer = buffers[i];
 
 		device->CreateShaderResourceView(shaderResources[i], &srvDesc, descriptorHandle);
-		descriptorHandle.ptr += _cbvSrvHeap.incrimentSize();
+		descriptorHandle.ptr += _cbvSrvStagingHeap.incrimentSize();
 	}
 
 	device->Release();
+
+	makeResident(dstView);
 }
 
 void DescriptorHeapManager::createTextureShaderResourceView(RefAddressOf<ID3D12Resource> textureResources, RefPtr<BufferView> dstView, uint32 viewCount) {
 	assert(viewCount > 0 && "Request Texture ShaderResource View 0");
-	_cbvSrvHeap.allocateBufferView(dstView, viewCount);
+	allocateCbvSrvUavView(dstView, viewCount);
 
 	ID3D12Device* device = nullptr;
 	textureResources[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = dstView->cpuHandle;
 	for (uint32 i = 0; i < viewCount; ++i) {
-		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		auto desc = textureResources[i]->GetDesc();
-		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format = desc.Format;
-
-		//eNX`z񂪂U΃L[u}bvƂď...
-		if (desc.DepthOrArraySize == 6) {
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-			srvDesc.TextureCube.MipLevels = desc.MipLevels;
-		}
-		else {
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MipLevels = desc.MipLevels;
-		}
-
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = textureSrvDesc(textureResources[i]);
 		device->CreateShaderResourceView(textureResources[i], &srvDesc, descriptorHandle);
-		descriptorHandle.ptr += _cbvSrvHeap.incrimentSize();
+		descriptorHandle.ptr += _cbvSrvStagingHeap.incrimentSize();
 	}
 
 	device->Release();
+
+	makeResident(dstView);
 }
 
 void DescriptorHeapManager::createDepthStencilView(RefAddressOf<ID3D12Resource> depthStencils, RefPtr<BufferView> dstView, uint32 viewCount) {
 	assert(viewCount > 0 && "Request DepthStencil View 0");
-	_dsvHeap.allocateBufferView(dstView, viewCount);
+	dstView->cpuHandle = _dsvHeap.allocate(viewCount, dstView->stagingAllocation);
+	dstView->size = viewCount;
 
 	ID3D12Device* device = nullptr;
 	depthStencils[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
@@ -219,7 +439,7 @@ void DescriptorHeapManager::createDepthStencilView(RefAddressOf<ID3D12Resource>
 
 void DescriptorHeapManager::createUnorederdAcsessView(RefAddressOf<ID3D12Resource> unorederdAcsess, RefPtr<BufferView> dstView, uint32 viewCount, const VectorArray<D3D12_BUFFER_UAV>& buffers){
 	assert(viewCount > 0 && "Request UnorederdAcsess View 0");
-	_cbvSrvHeap.allocateBufferView(dstView, viewCount);
+	allocateCbvSrvUavView(dstView, viewCount);
 
 	ID3D12Device* device = nullptr;
 	unorederdAcsess[0]->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
@@ -234,45 +454,126 @@ void DescriptorHeapManager::createUnorederdAcsessView(RefAddressOf<ID3D12Resourc
 		uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
 
 		device->CreateUnorderedAccessView(unorederdAcsess[i], unorederdAcsess[i], &uavDesc, uavHandle);
-		uavHandle.ptr += _cbvSrvHeap.incrimentSize();
+		uavHandle.ptr += _cbvSrvStagingHeap.incrimentSize();
 	}
 
 	device->Release();
+
+	makeResident(dstView);
+}
+
+void DescriptorHeapManager::allocateShaderVisibleView(RefPtr<BufferView> dstView, uint32 viewCount) {
+	const bool isAllocated = _cbvSrvHeap.allocatePersistent(viewCount, dstView->persistentAllocation);
+	assert(isAllocated && "シェーダー可視ヒープの永続領域が不足しています");
+
+	const uint64 descriptorIndex = dstView->persistentAllocation.block.offset;
+	dstView->cpuHandle = _cbvSrvHeap.cpuHandle(descriptorIndex);
+	dstView->gpuHandle = _cbvSrvHeap.gpuHandle(descriptorIndex);
+	dstView->size = viewCount;
+}
+
+void DescriptorHeapManager::discardShaderVisibleView(const BufferView& bufferView) {
+	_cbvSrvHeap.freePersistent(bufferView.persistentAllocation);
+}
+
+BindlessHandle DescriptorHeapManager::registerBindlessTexture(RefPtr<ID3D12Resource> texture) {
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
+	BindlessHandle handle = _bindlessTable.allocate(cpuHandle);
+
+	//他のスロットをGPUが参照していても、このスロットは未使用なのでシェーダー可視ヒープに直接生成してよい
+	ID3D12Device* device = nullptr;
+	texture->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = textureSrvDesc(texture);
+	device->CreateShaderResourceView(texture, &srvDesc, cpuHandle);
+
+	device->Release();
+	return handle;
+}
+
+BindlessHandle DescriptorHeapManager::registerBindlessBuffer(RefPtr<ID3D12Resource> buffer, const D3D12_BUFFER_SRV& bufferDesc) {
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
+	BindlessHandle handle = _bindlessTable.allocate(cpuHandle);
+
+	ID3D12Device* device = nullptr;
+	buffer->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = bufferDesc.Flags == D3D12_BUFFER_SRV_FLAG_RAW ? DXGI_FORMAT_R32_TYPELESS : DXGI_FORMAT_UNKNOWN;
+	srvDesc.Buffer = bufferDesc;
+	device->CreateShaderResourceView(buffer, &srvDesc, cpuHandle);
+
+	device->Release();
+	return handle;
+}
+
+void DescriptorHeapManager::unregisterBindless(const BindlessHandle& handle) {
+	_bindlessTable.free(handle);
 }
 
 void DescriptorHeapManager::discardRenderTargetView(const BufferView& bufferView) {
-	_rtvHeap.discardBufferView(bufferView);
+	_rtvHeap.free(bufferView.stagingAllocation);
 }
 
 void DescriptorHeapManager::discardConstantBufferView(const BufferView& bufferView) {
-	_cbvSrvHeap.discardBufferView(bufferView);
+	discardCbvSrvUavView(bufferView);
 }
 
 void DescriptorHeapManager::discardShaderResourceView(const BufferView& bufferView) {
-	_cbvSrvHeap.discardBufferView(bufferView);
+	discardCbvSrvUavView(bufferView);
 }
 
 void DescriptorHeapManager::discardDepthStencilView(const BufferView& bufferView) {
-	_dsvHeap.discardBufferView(bufferView);
+	_dsvHeap.free(bufferView.stagingAllocation);
 }
 
 
-RefPtr<ID3D12DescriptorHeap> DescriptorHeapManager::getD3dDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) {
-	switch (type) {
-	case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV: return _cbvSrvHeap.descriptorHeap(); break;
-	case D3D12_DESCRIPTOR_HEAP_TYPE_RTV: return _rtvHeap.descriptorHeap(); break;
-	case D3D12_DESCRIPTOR_HEAP_TYPE_DSV: return _dsvHeap.descriptorHeap(); break;
-	}
+RefPtr<ID3D12DescriptorHeap> DescriptorHeapManager::getD3dDescriptorHeap() const {
+	return _cbvSrvHeap.descriptorHeap();
+}
 
-	return nullptr;
+RefPtr<ShaderVisibleDescriptorHeap> DescriptorHeapManager::getShaderVisibleHeap() {
+	return &_cbvSrvHeap;
 }
 
-RefPtr<DescriptorHeap> DescriptorHeapManager::getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) {
+RefPtr<BindlessDescriptorTable> DescriptorHeapManager::getBindlessTable() {
+	return &_bindlessTable;
+}
+
+RefPtr<DescriptorStagingHeap> DescriptorHeapManager::getStagingHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) {
 	switch (type) {
-	case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV: return &_cbvSrvHeap; break;
+	case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV: return &_cbvSrvStagingHeap; break;
 	case D3D12_DESCRIPTOR_HEAP_TYPE_RTV: return &_rtvHeap; break;
 	case D3D12_DESCRIPTOR_HEAP_TYPE_DSV: return &_dsvHeap; break;
 	}
 
 	return nullptr;
 }
+
+void DescriptorHeapManager::allocateCbvSrvUavView(RefPtr<BufferView> dstView, uint32 viewCount) {
+	dstView->cpuHandle = _cbvSrvStagingHeap.allocate(viewCount, dstView->stagingAllocation);
+	dstView->gpuHandle.ptr = 0;
+	dstView->size = viewCount;
+}
+
+void DescriptorHeapManager::makeResident(RefPtr<BufferView> dstView) {
+	if (!_cbvSrvHeap.allocatePersistent(dstView->size, dstView->persistentAllocation)) {
+		return;
+	}
+
+	ID3D12Device* device = nullptr;
+	_cbvSrvHeap.descriptorHeap()->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
+
+	const uint64 descriptorIndex = dstView->persistentAllocation.block.offset;
+	device->CopyDescriptorsSimple(dstView->size, _cbvSrvHeap.cpuHandle(descriptorIndex), dstView->cpuHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	dstView->gpuHandle = _cbvSrvHeap.gpuHandle(descriptorIndex);
+
+	device->Release();
+}
+
+void DescriptorHeapManager::discardCbvSrvUavView(const BufferView& bufferView) {
+	_cbvSrvHeap.freePersistent(bufferView.persistentAllocation);
+	_cbvSrvStagingHeap.free(bufferView.stagingAllocation);
+}
@@ -0,0 +1,90 @@
+#include "FencedRingAllocator.h"
+#include <cassert>
+
+FencedRingAllocator::FencedRingAllocator() :
+	_capacity(0), _head(0), _tail(0), _usedSize(0), _unsubmittedSize(0) {
+}
+
+void FencedRingAllocator::create(uint64 capacity) {
+	_capacity = capacity;
+	_head = 0;
+	_tail = 0;
+	_usedSize = 0;
+	_unsubmittedSize = 0;
+	_pendingSubmissions.clear();
+	_statistics = Statistics();
+}
+
+uint64 FencedRingAllocator::allocate(uint64 size, uint64 alignment) {
+	assert(alignment > 0 && "アライメントが0です");
+
+	//すべて回収済みなら先頭から使い直して断片化を防ぐ
+	if (_usedSize == 0) {
+		_head = 0;
+		_tail = 0;
+	}
+
+	const uint64 alignedHead = (_head + alignment - 1) / alignment * alignment;
+	uint64 offset = InvalidOffset;
+	uint64 newHead = 0;
+
+	if (_usedSize == 0 || _tail < _head) {
+		//使用中領域が[tail, head)の場合は末尾、収まらなければ先頭の[0, tail)を使う
+		if (alignedHead + size <= _capacity) {
+			offset = alignedHead;
+			newHead = alignedHead + size;
+		}
+		else if (size <= _tail || (_usedSize == 0 && size <= _capacity)) {
+			offset = 0;
+			newHead = size;
+		}
+	}
+	else if (alignedHead + size <= _tail) {
+		//折り返し済みで使用中領域が[tail, capacity)と[0, head)の場合はその間を使う
+		offset = alignedHead;
+		newHead = alignedHead + size;
+	}
+
+	if (offset == InvalidOffset) {
+		++_statistics.failedAllocationCount;
+		return InvalidOffset;
+	}
+
+	//折り返した場合は末尾の余りもこの確保の使用量に含める
+	const uint64 consumedSize = offset == 0 && _head != 0 ? (_capacity - _head) + newHead : newHead - _head;
+	_head = newHead;
+	_usedSize += consumedSize;
+	_unsubmittedSize += consumedSize;
+
+	++_statistics.allocationCount;
+	_statistics.allocatedSize += consumedSize;
+	if (_usedSize > _statistics.peakUsedSize) {
+		_statistics.peakUsedSize = _usedSize;
+	}
+
+	return offset;
+}
+
+void FencedRingAllocator::submit(uint64 fenceValue) {
+	if (_unsubmittedSize == 0) {
+		return;
+	}
+
+	assert((_pendingSubmissions.empty() || _pendingSubmissions.back().fenceValue <= fenceValue) && "フェンス値は単調増加である必要があります");
+	_pendingSubmissions.push_back({ fenceValue, _head, _unsubmittedSize });
+	_unsubmittedSize = 0;
+}
+
+void FencedRingAllocator::reclaim(uint64 completedFenceValue) {
+	while (!_pendingSubmissions.empty() && _pendingSubmissions.front().fenceValue <= completedFenceValue) {
+		const PendingSubmission& submission = _pendingSubmissions.front();
+		_tail = submission.endOffset;
+		_usedSize -= submission.size;
+		_pendingSubmissions.pop_front();
+	}
+}
+
+uint64 FencedRingAllocator::getOldestPendingFenceValue() const {
+	assert(!_pendingSubmissions.empty() && "提出済みの領域がありません");
+	return _pendingSubmissions.front().fenceValue;
+}
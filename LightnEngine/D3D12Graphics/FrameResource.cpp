@@ -4,7 +4,7 @@
 #include "DescriptorHeap.h"
 #include "GpuResource.h"
 
-FrameResource::FrameResource(){
+FrameResource::FrameResource():_fenceValue(0), _renderTarget(nullptr){
 }
 
 
@@ -14,7 +14,7 @@ FrameResource::~FrameResource() {
 void FrameResource::create(RefPtr<ID3D12Device> device, RefPtr<IDXGISwapChain3> swapChain, UINT frameResourceIndex){
 	DescriptorHeapManager& descriptorHeapManager = DescriptorHeapManager::instance();
 
-	//_[^[Qbg
+	//レンダーターゲット
 	_renderTarget = new Texture2D();
 	_renderTarget->createFromBackBuffer(swapChain, frameResourceIndex);
 	descriptorHeapManager.createRenderTargetView(_renderTarget->getAdressOf(), &_rtv, 1);
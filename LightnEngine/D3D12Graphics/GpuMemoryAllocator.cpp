@@ -0,0 +1,262 @@
+#include "GpuMemoryAllocator.h"
+#include "D3D12Helper.h"
+#include "D3D12Util.h"
+
+GpuMemoryAllocator* Singleton<GpuMemoryAllocator>::_singleton = 0;
+
+GpuMemoryAllocator::GpuMemoryAllocator() :_device(nullptr), _pools() {
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator() {
+	shutdown();
+}
+
+void GpuMemoryAllocator::create(RefPtr<ID3D12Device> device, uint64 pageSize, uint64 smallBufferPageSize) {
+	_device = device;
+
+	const D3D12_HEAP_TYPE heapTypes[POOL_COUNT] = {
+		D3D12_HEAP_TYPE_DEFAULT,
+		D3D12_HEAP_TYPE_DEFAULT,
+		D3D12_HEAP_TYPE_UPLOAD,
+		D3D12_HEAP_TYPE_UPLOAD
+	};
+
+	const D3D12_HEAP_FLAGS heapFlags[POOL_COUNT] = {
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_NONE
+	};
+
+	//バッファは常に64KB、テクスチャは小さいものなら4KB、定数バッファは256バイト単位で配置できる
+	const uint64 granularities[POOL_COUNT] = {
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+		D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+		D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+	};
+
+	for (uint32 i = 0; i < POOL_COUNT; ++i) {
+		PoolState& pool = _pools[i];
+		pool.heapType = heapTypes[i];
+		pool.heapFlags = heapFlags[i];
+		pool.pageSize = i == POOL_SMALL_UPLOAD_BUFFER ? smallBufferPageSize : pageSize;
+		pool.granularity = granularities[i];
+		pool.pages.clear();
+		pool.committedFallbackCount = 0;
+	}
+}
+
+void GpuMemoryAllocator::shutdown() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (uint32 i = 0; i < POOL_COUNT; ++i) {
+		for (auto&& page : _pools[i].pages) {
+			if (page != nullptr && page->buffer != nullptr) {
+				page->buffer->Unmap(0, nullptr);
+			}
+		}
+
+		_pools[i].pages.clear();
+	}
+
+	_device = nullptr;
+}
+
+void GpuMemoryAllocator::createBuffer(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState,
+	ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outAllocation) {
+	assert(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && "バッファ以外は生成できません");
+	assert((heapType == D3D12_HEAP_TYPE_DEFAULT || heapType == D3D12_HEAP_TYPE_UPLOAD) && "未対応のヒープタイプです");
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const Pool pool = heapType == D3D12_HEAP_TYPE_UPLOAD ? POOL_UPLOAD_BUFFER : POOL_DEFAULT_BUFFER;
+	const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = _device->GetResourceAllocationInfo(0, 1, &desc);
+
+	outAllocation = GpuMemoryAllocation();
+	if (allocateFromPool(pool, allocationInfo.SizeInBytes, allocationInfo.Alignment, outAllocation)) {
+		const Page& page = *_pools[pool].pages[outAllocation.page];
+		throwIfFailed(_device->CreatePlacedResource(page.heap.Get(), outAllocation.block.offset, &desc, initialState, nullptr, IID_PPV_ARGS(&outResource)));
+		return;
+	}
+
+	//ページに収まらない大きいバッファは専用のヒープを使う
+	throwIfFailed(_device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(heapType), D3D12_HEAP_FLAG_NONE, &desc, initialState, nullptr, IID_PPV_ARGS(&outResource)));
+	++_pools[pool].committedFallbackCount;
+}
+
+void GpuMemoryAllocator::createTexture(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+	ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outAllocation) {
+	assert(desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && "テクスチャ以外は生成できません");
+	assert((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) == 0 && "レンダーターゲット・デプスはコミットリソースで生成してください");
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	//小さいテクスチャは4KBアライメントで配置できるか問い合わせ、できなければ通常の64KBアライメントに戻す
+	D3D12_RESOURCE_DESC textureDesc = desc;
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+	if (textureDesc.SampleDesc.Count <= 1) {
+		textureDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		allocationInfo = _device->GetResourceAllocationInfo(0, 1, &textureDesc);
+	}
+
+	if (allocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) {
+		textureDesc.Alignment = 0;
+		allocationInfo = _device->GetResourceAllocationInfo(0, 1, &textureDesc);
+	}
+
+	outAllocation = GpuMemoryAllocation();
+	if (allocateFromPool(POOL_DEFAULT_TEXTURE, allocationInfo.SizeInBytes, allocationInfo.Alignment, outAllocation)) {
+		const Page& page = *_pools[POOL_DEFAULT_TEXTURE].pages[outAllocation.page];
+		throwIfFailed(_device->CreatePlacedResource(page.heap.Get(), outAllocation.block.offset, &textureDesc, initialState, nullptr, IID_PPV_ARGS(&outResource)));
+		return;
+	}
+
+	throwIfFailed(_device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &desc, initialState, nullptr, IID_PPV_ARGS(&outResource)));
+	++_pools[POOL_DEFAULT_TEXTURE].committedFallbackCount;
+}
+
+void GpuMemoryAllocator::allocateSmallUploadBuffer(uint64 size, GpuSmallBufferAllocation& outAllocation) {
+	assert(isSmallUploadBuffer(size) && "64KB以上のバッファはcreateBufferで生成してください");
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const bool isAllocated = allocateFromPool(POOL_SMALL_UPLOAD_BUFFER, size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, outAllocation.allocation);
+	assert(isAllocated && "小さいバッファの確保に失敗しました");
+
+	const Page& page = *_pools[POOL_SMALL_UPLOAD_BUFFER].pages[outAllocation.allocation.page];
+	outAllocation.resource = page.buffer.Get();
+	outAllocation.offset = outAllocation.allocation.block.offset;
+	outAllocation.cpuAddress = page.mappedPtr + outAllocation.offset;
+}
+
+void GpuMemoryAllocator::free(const GpuMemoryAllocation& allocation) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	//終了処理でヒープごと解放済み
+	if (_device == nullptr) {
+		return;
+	}
+
+	PoolState& pool = _pools[allocation.pool];
+	UniquePtr<Page>& page = pool.pages[allocation.page];
+	page->allocator.free(allocation.block);
+
+	if (!page->allocator.isEmpty()) {
+		return;
+	}
+
+	//確保と解放を繰り返したときにページの生成・破棄が続かないよう、最後の1枚は残す
+	uint32 livePageCount = 0;
+	for (const auto& p : pool.pages) {
+		livePageCount += p != nullptr ? 1 : 0;
+	}
+
+	if (livePageCount > 1) {
+		if (page->buffer != nullptr) {
+			page->buffer->Unmap(0, nullptr);
+		}
+
+		page.reset();
+	}
+}
+
+GpuHeapStatistics GpuMemoryAllocator::getStatistics(Pool pool) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	GpuHeapStatistics statistics;
+	for (const auto& page : _pools[pool].pages) {
+		if (page == nullptr) {
+			continue;
+		}
+
+		const TlsfAllocator::Statistics& pageStatistics = page->allocator.getStatistics();
+		++statistics.pageCount;
+		statistics.allocationCount += pageStatistics.liveAllocationCount;
+		statistics.reservedSize += page->allocator.getCapacity();
+		statistics.usedSize += pageStatistics.usedSize;
+
+		const uint64 largestFreeBlockSize = page->allocator.getLargestFreeBlockSize();
+		if (largestFreeBlockSize > statistics.largestFreeBlockSize) {
+			statistics.largestFreeBlockSize = largestFreeBlockSize;
+		}
+	}
+
+	statistics.committedFallbackCount = _pools[pool].committedFallbackCount;
+	return statistics;
+}
+
+const char* GpuMemoryAllocator::getPoolName(Pool pool) {
+	const char* names[POOL_COUNT] = { "DefaultBuffer", "DefaultTexture", "UploadBuffer", "SmallUploadBuffer" };
+	return names[pool];
+}
+
+bool GpuMemoryAllocator::allocateFromPool(Pool pool, uint64 size, uint64 alignment, GpuMemoryAllocation& outAllocation) {
+	PoolState& poolState = _pools[pool];
+
+	//ページのヒープは64KBアライメントなので、それより大きいアライメント(MSAA)やページより大きいものは扱わない
+	if (size > poolState.pageSize || alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) {
+		return false;
+	}
+
+	for (uint32 i = 0; i < poolState.pages.size(); ++i) {
+		if (poolState.pages[i] == nullptr) {
+			continue;
+		}
+
+		TlsfAllocator::Allocation block = poolState.pages[i]->allocator.allocate(size, alignment);
+		if (block.isValid()) {
+			outAllocation.pool = pool;
+			outAllocation.page = i;
+			outAllocation.block = block;
+			return true;
+		}
+	}
+
+	const uint32 pageIndex = createPage(pool);
+	outAllocation.pool = pool;
+	outAllocation.page = pageIndex;
+	outAllocation.block = poolState.pages[pageIndex]->allocator.allocate(size, alignment);
+	return outAllocation.isValid();
+}
+
+uint32 GpuMemoryAllocator::createPage(Pool pool) {
+	PoolState& poolState = _pools[pool];
+	UniquePtr<Page> page = makeUnique<Page>();
+
+	if (pool == POOL_SMALL_UPLOAD_BUFFER) {
+		D3D12_RESOURCE_DESC bufferDesc = {};
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Width = poolState.pageSize;
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+		throwIfFailed(_device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(poolState.heapType), D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&page->buffer)));
+		NAME_D3D12_OBJECT(page->buffer.Get());
+
+		//アップロードヒープは開いたままでよいので破棄するまでマップし続ける
+		D3D12_RANGE readRange = { 0, 0 };
+		throwIfFailed(page->buffer->Map(0, &readRange, reinterpret_cast<void**>(&page->mappedPtr)));
+	}
+	else {
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = poolState.pageSize;
+		heapDesc.Properties.Type = poolState.heapType;
+		heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = poolState.heapFlags;
+		throwIfFailed(_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&page->heap)));
+		SetNameIndexed(page->heap.Get(), L"GpuMemoryAllocatorPage", pool);
+	}
+
+	page->allocator.create(poolState.pageSize, poolState.granularity);
+
+	//解放済みのページ番号を使い回す
+	for (uint32 i = 0; i < poolState.pages.size(); ++i) {
+		if (poolState.pages[i] == nullptr) {
+			poolState.pages[i] = std::move(page);
+			return i;
+		}
+	}
+
+	poolState.pages.push_back(std::move(page));
+	return static_cast<uint32>(poolState.pages.size() - 1);
+}
@@ -6,7 +6,14 @@
 #include "SharedMaterial.h"
 #include "stdafx.h"
 #include "GpuResourceDataPool.h"
+#include "TextureStreamer.h"
 #include "AABB.h"
+#include "UploadRingBuffer.h"
+#include <ThreadPool.h>
+#include <IoService.h>
+#include <MeshFile.h>
+#include <MeshVertexCodec.h>
+#include <MeshIndexCodec.h>
 #include <cassert>
 #include <LMath.h>
 
@@ -23,7 +30,7 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//const String vertexShaderFullPath = "Shaders/" + settings.vertexShaderName;
 	//const String pixelShaderFullPath = "Shaders/" + settings.pixelShaderName;
 
-	////_VF[_[LbV΂gBȂΐVK
+	////頂点シェーダーキャッシュがあればそれを使う。なければ新規生成
 	//RefPtr<VertexShader> vertexShader = nullptr;
 	//if (_resourcePool->vertexShaders.count(vertexShaderFullPath) > 0) {
 	//	loadVertexShader(vertexShaderFullPath, &vertexShader);
@@ -32,7 +39,7 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//	vertexShader = createVertexShader(vertexShaderFullPath, settings.inputLayouts);
 	//}
 
-	////sNZVF[_[LbV΂gBȂΐVK
+	////ピクセルシェーダーキャッシュがあればそれを使う。なければ新規生成
 	//RefPtr<PixelShader> pixelShader = nullptr;
 	//if (_resourcePool->pixelShaders.count(pixelShaderFullPath) > 0) {
 	//	loadPixelShader(pixelShaderFullPath, &pixelShader);
@@ -41,7 +48,7 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//	pixelShader = createPixelShader(pixelShaderFullPath);
 	//}
 
-	////[gVOl`LbV΂gBȂΐVK
+	////ルートシグネチャキャッシュがあればそれを使う。なければ新規生成
 	//RefPtr<RootSignature> rootSignature = nullptr;
 	//if (_resourcePool->rootSignatures.count(settings.name) > 0) {
 	//	rootSignature = &_resourcePool->rootSignatures.at(settings.name);
@@ -55,7 +62,7 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//	rootSignature->create(device, vertexShader, pixelShader);
 	//}
 
-	////pCvCXe[gLbV΂gBȂΐVK
+	////パイプラインステートキャッシュがあればそれを使う。なければ新規生成
 	//RefPtr<PipelineState> pipelineState = nullptr;
 	//if (_resourcePool->pipelineStates.count(settings.name) > 0) {
 	//	pipelineState = &_resourcePool->pipelineStates.at(settings.name);
@@ -69,9 +76,9 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//	pipelineState->create(device, rootSignature, vertexShader, pixelShader, castTopologyToType(settings.topology));
 	//}
 
-	//assert(_resourcePool->sharedMaterials.count(settings.name) == 0 && "̖Õ}eA͂łɑ݂܂I");
+	//assert(_resourcePool->sharedMaterials.count(settings.name) == 0 && "その名前のマテリアルはすでに存在します！");
 
-	////}eALbVɓo^
+	////生成したマテリアルをキャッシュに登録
 	//const ShaderReflectionResult& vsReflection = vertexShader->shaderReflectionResult;
 	//const ShaderReflectionResult& psReflection = pixelShader->shaderReflectionResult;
 	//auto itr = _resourcePool->sharedMaterials.emplace(std::piecewise_construct,
@@ -85,7 +92,7 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//SingleMeshRenderPass& material = (*itr.first).second;
 	//DescriptorHeapManager& manager = DescriptorHeapManager::instance();
 
-	////_VF[_[eNX`SRV
+	////頂点シェーダーテクスチャSRV生成
 	//if (vsReflection.srvRangeDescs.size() > 0) {
 	//	VectorArray<RefPtr<ID3D12Resource>> textures(settings.vsTextures.size());
 
@@ -98,9 +105,9 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//	//settings.vsTextures.size()
 	//	manager.createTextureShaderResourceView(textures.data(), &material._srvVertex, static_cast<uint32>(settings.vsTextures.size()));
 	//}
-	////assert(vertexShader->shaderReflectionResult.srvRangeDescs.size()== settings.vsTextures.size() && "_VF[_[`Ǝw肵eNX`قȂ܂I");
+	////assert(vertexShader->shaderReflectionResult.srvRangeDescs.size()== settings.vsTextures.size() && "頂点シェーダー定義と指定したテクスチャ枚数が異なります！");
 
-	////sNZVF[_[eNX`SRV
+	////ピクセルシェーダーテクスチャSRV生成
 	//if (psReflection.srvRangeDescs.size() > 0) {
 	//	VectorArray<RefPtr<ID3D12Resource>> textures(settings.psTextures.size());
 
@@ -113,16 +120,16 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 
 	//	manager.createTextureShaderResourceView(textures.data(), &material._srvPixel, static_cast<uint32>(settings.psTextures.size()));
 	//}
-	////assert(pixelShader->shaderReflectionResult.srvRangeDescs.size() == settings.psTextures.size() && "sNZVF[_[`Ǝw肵eNX`قȂ܂I");
+	////assert(pixelShader->shaderReflectionResult.srvRangeDescs.size() == settings.psTextures.size() && "ピクセルシェーダー定義と指定したテクスチャ枚数が異なります！");
 
 
-	////_VF[_[̒萔obt@TCY擾Ē萔obt@{̂𐶐
+	////頂点シェーダーの定数バッファサイズを取得して定数バッファ本体を生成
 	//VectorArray<uint32> vertexCbSizes = vertexShader->getConstantBufferSizes();
 	//if (!vertexCbSizes.empty()) {
 	//	material._vertexConstantBuffer.create(device, vertexCbSizes);
 	//}
 
-	////sNZVF[_[̒萔obt@TCY擾Ē萔obt@{̂𐶐
+	////ピクセルシェーダーの定数バッファサイズを取得して定数バッファ本体を生成
 	//VectorArray<uint32> pixelCbSizes = pixelShader->getConstantBufferSizes();
 	//if (!pixelCbSizes.empty()) {
 	//	material._pixelConstantBuffer.create(device, pixelCbSizes);
@@ -131,35 +138,121 @@ void GpuResourceManager::createSharedMaterial(RefPtr<ID3D12Device> device, const
 	//material.setSizeInstance(device);
 }
 
-//eNX`܂Ƃ߂ĐB܂Ƃ߂đ̂CPUI[o[wbhȂ
-void GpuResourceManager::createTextures(RefPtr<ID3D12Device> device, CommandContext& commandContext, const VectorArray<String>& settings) {	
-	VectorArray<ComPtr<ID3D12Resource>> uploadHeaps(settings.size());
-	auto commandListSet = commandContext.requestCommandListSet();
-	RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
+//アップロード量がuploadSizesのアイテムを、リングに収まるバッチに分けて並列に記録する
+//バッチ内のアイテムはコンテキストの数で分け合い、バッチごとに1回だけ提出する。戻り値は提出した回数
+static uint32 recordUploads(CommandContext& commandContext, ThreadPool& threadPool, const VectorArray<uint64>& uploadSizes,
+	const std::function<void(UploadContext&, uint32)>& record, VectorArray<UINT64>& outFenceValues) {
+	const uint32 itemCount = static_cast<uint32>(uploadSizes.size());
+	const uint64 maxBatchSize = UploadBatch::getMaxBatchSize();
+	outFenceValues.resize(itemCount);
+
+	uint32 submitCount = 0;
+	uint64 batchSize = 0;
+	VectorArray<uint32> batchItems;
+
+	auto submitBatch = [&]() {
+		if (batchItems.empty()) {
+			return;
+		}
 
-	for (size_t i = 0; i < settings.size(); ++i) {
-		//łɂ̖ڂ̃eNX`݂Ȃ琶̓XLbv
-		if (_resourcePool->textures.count(settings[i]) > 0) {
+		const uint32 batchItemCount = static_cast<uint32>(batchItems.size());
+		const uint32 contextCount = min(threadPool.getWorkerCount() + 1, batchItemCount);
+		UploadBatch batch(&commandContext, contextCount);
+
+		threadPool.parallelFor(contextCount, [&](uint32 contextIndex) {
+			UploadContext& uploadContext = batch.getContext(contextIndex);
+			for (uint32 i = contextIndex; i < batchItemCount; i += contextCount) {
+				record(uploadContext, batchItems[i]);
+			}
+		});
+
+		const UINT64 fenceValue = batch.submit();
+		for (uint32 item : batchItems) {
+			outFenceValues[item] = fenceValue;
+		}
+
+		batchItems.clear();
+		batchSize = 0;
+		++submitCount;
+	};
+
+	for (uint32 i = 0; i < itemCount; ++i) {
+		//1つでバッチに収まらないアイテムは、途中で提出できるコンテキストでメインスレッドが単独で記録する
+		//記録前のバッチはまだリングを確保していないので、途中の提出に巻き込まれない
+		if (uploadSizes[i] > maxBatchSize) {
+			UploadContext uploadContext(&commandContext);
+			record(uploadContext, i);
+			outFenceValues[i] = uploadContext.submit();
+			++submitCount;
 			continue;
 		}
 
-		const String fullPath = "Resources/" + settings[i];
+		if (batchSize + uploadSizes[i] > maxBatchSize) {
+			submitBatch();
+		}
+
+		batchItems.push_back(i);
+		batchSize += uploadSizes[i];
+	}
+
+	submitBatch();
+	return submitCount;
+}
+
+//テクスチャをまとめて生成する。ファイルはIoServiceでまとめて読み、記録はワーカースレッドで並列に行ってバッチごとにまとめて送る
+void GpuResourceManager::createTextures(RefPtr<ID3D12Device> device, CommandContext& commandContext, ThreadPool& threadPool, const VectorArray<String>& settings) {
+	LARGE_INTEGER startTime;
+	QueryPerformanceCounter(&startTime);
 
-		//eNX`LbVɐ
+	//キャッシュへの追加はメインスレッドで先に済ませる。すでにその名目のテクスチャが存在するなら生成はスキップ
+	VectorArray<Texture2D*> textures;
+	VectorArray<String> fullPaths;
+	for (size_t i = 0; i < settings.size(); ++i) {
 		auto itr = _resourcePool->textures.emplace(std::piecewise_construct,
 			std::make_tuple(settings[i]),
 			std::make_tuple());
 
-		Texture2D& tex = (*itr.first).second;
-		tex.createDeferredFromName(device, commandList, &uploadHeaps[i], fullPath);
+		if (!itr.second) {
+			continue;
+		}
+
+		textures.push_back(&(*itr.first).second);
+		fullPaths.push_back("Resources/" + settings[i]);
 	}
 
-	//Abv[hobt@GPUI[obt@ɃRs[
-	commandContext.executeCommandList(commandList);
-	commandContext.discardCommandListSet(commandListSet);
+	const uint32 textureCount = static_cast<uint32>(textures.size());
+	if (textureCount == 0) {
+		return;
+	}
+
+	//ヘッダーの解析とロード時に転送するミップの読み込み
+	VectorArray<TextureStreamer::PreparedTexture> preparedTextures;
+	TextureStreamer::prepareTextures(fullPaths, preparedTextures);
+
+	//詳細なミップは画面サイズに応じてTextureStreamerが後から読み込む
+	TextureStreamer& textureStreamer = TextureStreamer::instance();
+	VectorArray<uint64> uploadSizes(textureCount);
+	uint64 loadedSize = 0;
+	for (uint32 i = 0; i < textureCount; ++i) {
+		uploadSizes[i] = preparedTextures[i].uploadSize;
+		loadedSize += preparedTextures[i].data.size();
+	}
+
+	VectorArray<UINT64> fenceValues;
+	const uint32 submitCount = recordUploads(commandContext, threadPool, uploadSizes, [&](UploadContext& uploadContext, uint32 i) {
+		textureStreamer.recordTexture(uploadContext, preparedTextures[i], *textures[i]);
+	}, fenceValues);
+
+	for (uint32 i = 0; i < textureCount; ++i) {
+		Texture2D& tex = *textures[i];
+		tex._uploadFenceValue = fenceValues[i];
+		textureStreamer.registerTexture(preparedTextures[i], tex);
+
+		//ロード時にバインドレステーブルの固定インデックスを割り当てる
+		tex._bindlessHandle = DescriptorHeapManager::instance().registerBindlessTexture(tex.get());
+	}
 
-	//Rs[I܂ŃAbv[hq[vjȂ
-	commandContext.waitForIdle();
+	addLoadStatistics(textureCount, loadedSize, submitCount, startTime);
 }
 
 struct RawVertex {
@@ -196,180 +289,241 @@ namespace std {
 	};
 }
 
-#include <fstream>
 //#include <fbxsdk.h>
 //using namespace fbxsdk;
-void GpuResourceManager::createVertexAndIndexBuffer(RefPtr<ID3D12Device> device, CommandContext& commandContext, const VectorArray<String>& fileNames) {
-	VectorArray<ComPtr<ID3D12Resource>> uploadHeaps(fileNames.size() * 2);//ǂݍރt@C~(_obt@{CfbNXobt@)
-	auto commandListSet = commandContext.requestCommandListSet();
-	RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
+//読み込んだメッシュファイル。アップロードを記録し終えるまでバッファを保持し、頂点とインデックスはバッファから直接リングにコピーする
+struct LoadedMeshFile {
+	IoBuffer buffer;
+	MeshFileReader reader;
+};
 
-	uint32 uploadHeapCounter = 0;
-	for (const auto& fileName : fileNames) {
-		{
-			assert(_resourcePool->vertexAndIndexBuffers.count(fileName) == 0 && "łɂ̃bV̓[hς");
-			//fbxsdk::FbxManager* manager = fbxsdk::FbxManager::Create();
-			//FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
-			//manager->SetIOSettings(ios);
-			//FbxScene* scene = FbxScene::Create(manager, "");
-
-			//FbxImporter* importer = FbxImporter::Create(manager, "");
-			//String fullPath = "Resources/" + fileName;
-			//bool isSuccsess = importer->Initialize(fullPath.c_str(), -1, manager->GetIOSettings());
-			//assert(isSuccsess && "FBXǂݍݎs");
-
-			//importer->Import(scene);
-			//importer->Destroy();
-
-			//FbxGeometryConverter geometryConverter(manager);
-			//geometryConverter.Triangulate(scene, true);
-
-			//FbxAxisSystem::DirectX.ConvertScene(scene);
-
-			//FbxMesh* mesh = scene->GetMember<FbxMesh>(0);
-			//const uint32 materialCount = scene->GetMaterialCount();
-			//const uint32 vertexCount = mesh->GetControlPointsCount();
-			//const uint32 polygonCount = mesh->GetPolygonCount();
-			//const uint32 polygonVertexCount = 3;
-			//const uint32 indexCount = polygonCount * polygonVertexCount;
-
-			//FbxStringList uvSetNames;
-			//bool bIsUnmapped = false;
-			//mesh->GetUVSetNames(uvSetNames);
-
-			//FbxLayerElementMaterial* meshMaterials = mesh->GetLayer(0)->GetMaterials();
-
-			////}eAƂ̒_CfbNX𒲂ׂ
-			//VectorArray<uint32> materialIndexSizes(materialCount);
-			//for (uint32 i = 0; i < polygonCount; ++i) {
-			//	const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
-			//	materialIndexSizes[materialId] += polygonVertexCount;
-			//}
-
-			////}eAƂ̃CfbNXItZbgvZ
-			//VectorArray<uint32> materialIndexOffsets(materialCount);
-			//for (size_t i = 0; i < materialIndexOffsets.size(); ++i) {
-			//	for (size_t j = 0; j < i; ++j) {
-			//		materialIndexOffsets[i] += materialIndexSizes[j];
-			//	}
-			//}
-
-			//UnorderedMap<RawVertex, uint32> optimizedVertices;//dȂ_ƐV_CfbNX
-			//VectorArray<UINT32> indices(indexCount);//V_CfbNXłłCfbNXobt@
-			//VectorArray<uint32> materialIndexCounter(materialCount);//}eAƂ̃CfbNXǗ
-
-			//optimizedVertices.reserve(indexCount);
-
-			//for (uint32 i = 0; i < polygonCount; ++i) {
-			//	const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
-			//	const uint32 materialIndexOffset = materialIndexOffsets[materialId];
-			//	uint32& indexCount = materialIndexCounter[materialId];
-
-			//	for (uint32 j = 0; j < polygonVertexCount; ++j) {
-			//		const uint32 vertexIndex = mesh->GetPolygonVertex(i, j);
-			//		FbxVector4 v = mesh->GetControlPointAt(vertexIndex);
-			//		FbxVector4 normal;
-			//		FbxVector2 texcoord;
-
-			//		FbxString uvSetName = uvSetNames.GetStringAt(0);//UVSet͂OԃCfbNX̂ݑΉ
-			//		mesh->GetPolygonVertexUV(i, j, uvSetName, texcoord, bIsUnmapped);
-			//		mesh->GetPolygonVertexNormal(i, j, normal);
-
-			//		RawVertex r;
-			//		r.position = { (float)v[0], (float)v[1], -(float)v[2] };//FBX͉EWnȂ̂ōWnɒ߂Z𔽓]
-			//		r.normal = { (float)normal[0], (float)normal[1], -(float)normal[2] };
-			//		r.texcoord = { (float)texcoord[0], 1 - (float)texcoord[1] };
-
-			//		const Vector3 vectorUp = { 0.0f, 1, EPSILON };
-			//		r.tangent = Vector3::cross(r.normal, vectorUp);
-
-			//		//Z𔽓]ƃ|SɂȂ̂ŉEɂȂ悤ɃCfbNX0,1,2  2,1,0ɂ
-			//		const uint32 indexInverseCorrectionedValue = indexCount + 2 - j;
-			//		const uint32 indexPerMaterial = materialIndexOffset + indexInverseCorrectionedValue;
-			//		if (optimizedVertices.count(r) == 0) {
-			//			uint32 vertexIndex = static_cast<uint32>(optimizedVertices.size());
-			//			indices[indexPerMaterial] = vertexIndex;
-			//			optimizedVertices.emplace(r, vertexIndex);
-			//		}
-			//		else {
-			//			indices[indexPerMaterial] = optimizedVertices.at(r);
-			//		}
-
-			//	}
-
-			//	indexCount += polygonVertexCount;
-			//}
-
-			////UnorederedMap̔z񂩂VectorArrayɕϊ
-			//VectorArray<RawVertex> vertices(optimizedVertices.size());
-			//for (const auto& vertex : optimizedVertices) {
-			//	vertices[vertex.second] = vertex.first;
-			//}
-
-			//manager->Destroy();
-
-			////}eA̕`͈͂ݒ
-			//VectorArray<MaterialDrawRange> materialSlots;
-			//materialSlots.reserve(materialCount);
-
-			//for (size_t i = 0; i < materialCount; ++i) {
-			//	materialSlots.emplace_back(materialIndexSizes[i], materialIndexOffsets[i]);
-			//}
-		}
+//IoServiceが読み込んだメッシュファイルを解析する。完了コールバックとしてワーカースレッドで呼ばれる
+static void readMeshFile(IoReadResult& result, LoadedMeshFile& outFile) {
+	{
+		//fbxsdk::FbxManager* manager = fbxsdk::FbxManager::Create();
+		//FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
+		//manager->SetIOSettings(ios);
+		//FbxScene* scene = FbxScene::Create(manager, "");
+
+		//FbxImporter* importer = FbxImporter::Create(manager, "");
+		//String fullPath = "Resources/" + fileName;
+		//bool isSuccsess = importer->Initialize(fullPath.c_str(), -1, manager->GetIOSettings());
+		//assert(isSuccsess && "FBX読み込み失敗");
+
+		//importer->Import(scene);
+		//importer->Destroy();
+
+		//FbxGeometryConverter geometryConverter(manager);
+		//geometryConverter.Triangulate(scene, true);
+
+		//FbxAxisSystem::DirectX.ConvertScene(scene);
+
+		//FbxMesh* mesh = scene->GetMember<FbxMesh>(0);
+		//const uint32 materialCount = scene->GetMaterialCount();
+		//const uint32 vertexCount = mesh->GetControlPointsCount();
+		//const uint32 polygonCount = mesh->GetPolygonCount();
+		//const uint32 polygonVertexCount = 3;
+		//const uint32 indexCount = polygonCount * polygonVertexCount;
+
+		//FbxStringList uvSetNames;
+		//bool bIsUnmapped = false;
+		//mesh->GetUVSetNames(uvSetNames);
+
+		//FbxLayerElementMaterial* meshMaterials = mesh->GetLayer(0)->GetMaterials();
+
+		////マテリアルごとの頂点インデックス数を調べる
+		//VectorArray<uint32> materialIndexSizes(materialCount);
+		//for (uint32 i = 0; i < polygonCount; ++i) {
+		//	const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
+		//	materialIndexSizes[materialId] += polygonVertexCount;
+		//}
+
+		////マテリアルごとのインデックスオフセットを計算
+		//VectorArray<uint32> materialIndexOffsets(materialCount);
+		//for (size_t i = 0; i < materialIndexOffsets.size(); ++i) {
+		//	for (size_t j = 0; j < i; ++j) {
+		//		materialIndexOffsets[i] += materialIndexSizes[j];
+		//	}
+		//}
+
+		//UnorderedMap<RawVertex, uint32> optimizedVertices;//重複しない頂点情報と新しい頂点インデックス
+		//VectorArray<UINT32> indices(indexCount);//新しい頂点インデックスでできたインデックスバッファ
+		//VectorArray<uint32> materialIndexCounter(materialCount);//マテリアルごとのインデックス数を管理
+
+		//optimizedVertices.reserve(indexCount);
+
+		//for (uint32 i = 0; i < polygonCount; ++i) {
+		//	const uint32 materialId = meshMaterials->GetIndexArray().GetAt(i);
+		//	const uint32 materialIndexOffset = materialIndexOffsets[materialId];
+		//	uint32& indexCount = materialIndexCounter[materialId];
+
+		//	for (uint32 j = 0; j < polygonVertexCount; ++j) {
+		//		const uint32 vertexIndex = mesh->GetPolygonVertex(i, j);
+		//		FbxVector4 v = mesh->GetControlPointAt(vertexIndex);
+		//		FbxVector4 normal;
+		//		FbxVector2 texcoord;
+
+		//		FbxString uvSetName = uvSetNames.GetStringAt(0);//UVSetは０番インデックスのみ対応
+		//		mesh->GetPolygonVertexUV(i, j, uvSetName, texcoord, bIsUnmapped);
+		//		mesh->GetPolygonVertexNormal(i, j, normal);
+
+		//		RawVertex r;
+		//		r.position = { (float)v[0], (float)v[1], -(float)v[2] };//FBXは右手座標系なので左手座標系に直すためにZを反転する
+		//		r.normal = { (float)normal[0], (float)normal[1], -(float)normal[2] };
+		//		r.texcoord = { (float)texcoord[0], 1 - (float)texcoord[1] };
+
+		//		const Vector3 vectorUp = { 0.0f, 1, EPSILON };
+		//		r.tangent = Vector3::cross(r.normal, vectorUp);
+
+		//		//Zを反転するとポリゴンが左回りになるので右回りになるようにインデックスを0,1,2 → 2,1,0にする
+		//		const uint32 indexInverseCorrectionedValue = indexCount + 2 - j;
+		//		const uint32 indexPerMaterial = materialIndexOffset + indexInverseCorrectionedValue;
+		//		if (optimizedVertices.count(r) == 0) {
+		//			uint32 vertexIndex = static_cast<uint32>(optimizedVertices.size());
+		//			indices[indexPerMaterial] = vertexIndex;
+		//			optimizedVertices.emplace(r, vertexIndex);
+		//		}
+		//		else {
+		//			indices[indexPerMaterial] = optimizedVertices.at(r);
+		//		}
+
+		//	}
+
+		//	indexCount += polygonVertexCount;
+		//}
+
+		////UnorederedMapの配列からVectorArrayに変換
+		//VectorArray<RawVertex> vertices(optimizedVertices.size());
+		//for (const auto& vertex : optimizedVertices) {
+		//	vertices[vertex.second] = vertex.first;
+		//}
+
+		//manager->Destroy();
+
+		////マテリアルの描画範囲を設定
+		//VectorArray<MaterialDrawRange> materialSlots;
+		//materialSlots.reserve(materialCount);
+
+		//for (size_t i = 0; i < materialCount; ++i) {
+		//	materialSlots.emplace_back(materialIndexSizes[i], materialIndexOffsets[i]);
+		//}
+	}
+
+	assert(result.isSucceeded() && "メッシュファイルが読み込めません");
+	outFile.buffer = std::move(result.buffer);
 
-		String fullPath = "Resources/" + fileName;
-		std::ifstream fin(fullPath.c_str(), std::ios::in | std::ios::binary);
-		fin.exceptions(std::ios::badbit);
+	const bool isParsed = outFile.reader.open(outFile.buffer.data(), outFile.buffer.size());
+	assert(isParsed && "メッシュファイルが壊れています");
+	assert(outFile.reader.verifyHashes() && "メッシュファイルのハッシュが一致しません");
+}
+
+String GpuResourceManager::getMeshName(const String& fileName, uint32 meshIndex) {
+	return meshIndex == 0 ? fileName : fileName + "#" + String(std::to_string(meshIndex).c_str());
+}
 
-		assert(!fin.fail() && "bVt@Cǂݍ߂܂");
+void GpuResourceManager::createVertexAndIndexBuffer(RefPtr<ID3D12Device> device, CommandContext& commandContext, ThreadPool& threadPool, const VectorArray<String>& fileNames) {
+	LARGE_INTEGER startTime;
+	QueryPerformanceCounter(&startTime);
 
-		uint32 allFileSize = 0;
-		uint32 verticesCount = 0;
-		uint32 indicesCount = 0;
-		uint32 materialCount = 0;
+	const uint32 fileCount = static_cast<uint32>(fileNames.size());
+	if (fileCount == 0) {
+		return;
+	}
 
-		fin.read(reinterpret_cast<char*>(&allFileSize), 4);
-		fin.read(reinterpret_cast<char*>(&verticesCount), 4);
-		fin.read(reinterpret_cast<char*>(&indicesCount), 4);
-		fin.read(reinterpret_cast<char*>(&materialCount), 4);
+	for (const auto& fileName : fileNames) {
+		assert(_resourcePool->vertexAndIndexBuffers.count(fileName) == 0 && "すでにこのメッシュはロード済み");
+	}
 
-		uint32 verticesSize = verticesCount * sizeof(RawVertex);
-		uint32 indicesSize = indicesCount * sizeof(uint32);
-		uint32 materialSize = materialCount * sizeof(MaterialDrawRange);
+	//ファイル全体をまとめて読む。解析とハッシュの照合は読み終えたファイルから完了コールバックで並列に行う
+	VectorArray<LoadedMeshFile> meshFiles(fileCount);
+	IoRequestGroup readGroup;
+	for (uint32 i = 0; i < fileCount; ++i) {
+		IoReadRequest request;
+		request.filePath = "Resources/" + fileNames[i];
+		request.priority = IO_PRIORITY_NORMAL;
+		request.callback = [&meshFiles, i](IoReadResult& result) {
+			readMeshFile(result, meshFiles[i]);
+		};
+
+		IoService::instance().read(request, &readGroup);
+	}
+	readGroup.wait();
 
-		VectorArray<RawVertex> vertices(verticesCount);
-		VectorArray<uint32> indices(indicesCount);
-		VectorArray<MaterialDrawRange> materialRanges(materialCount);
-		AABB boundingBox;
+	//メッシュ描画インスタンスを生成。1ファイルに複数のメッシュがあれば2つ目以降はgetMeshNameの名前で登録する
+	struct MeshUpload {
+		const MeshFileMesh* mesh;
+		VertexAndIndexBuffer* buffers;
+	};
 
-		fin.read(reinterpret_cast<char*>(vertices.data()), verticesSize);
-		fin.read(reinterpret_cast<char*>(indices.data()), indicesSize);
-		fin.read(reinterpret_cast<char*>(materialRanges.data()), materialSize);
-		fin.read(reinterpret_cast<char*>(&boundingBox), 24);
+	VectorArray<MeshUpload> meshUploads;
+	VectorArray<uint64> uploadSizes;
+	uint64 loadedSize = 0;
+	for (uint32 i = 0; i < fileCount; ++i) {
+		const MeshFileReader& reader = meshFiles[i].reader;
+		for (uint32 meshIndex = 0; meshIndex < reader.getMeshCount(); ++meshIndex) {
+			const MeshFileMesh& mesh = reader.getMesh(meshIndex);
+
+			const MaterialDrawRange* materialRanges = reinterpret_cast<const MaterialDrawRange*>(mesh.materialRanges);
+			auto itr = _resourcePool->vertexAndIndexBuffers.emplace(std::piecewise_construct,
+				std::make_tuple(getMeshName(fileNames[i], meshIndex)),
+				std::make_tuple(VectorArray<MaterialDrawRange>(materialRanges, materialRanges + mesh.materialRangeCount)));
+
+			VertexAndIndexBuffer& buffers = (*itr.first).second;
+			const MeshFileMeshInfo& info = mesh.info;
+			buffers.boundingBox = AABB(Vector3(info.boundsMin[0], info.boundsMin[1], info.boundsMin[2]), Vector3(info.boundsMax[0], info.boundsMax[1], info.boundsMax[2]));
+
+			//圧縮頂点はAABB内の0~1で入っているので、シェーダーで戻すための定数を持たせておく
+			float positionScale[3];
+			float positionOffset[3];
+			MeshVertexCodec::getPositionDequantization(info, positionScale, positionOffset);
+			buffers.vertexFormat = static_cast<MeshVertexFormat>(info.vertexFormat);
+			buffers.dequantization.positionScale = Vector4(positionScale[0], positionScale[1], positionScale[2], 0.0f);
+			buffers.dequantization.positionOffset = Vector4(positionOffset[0], positionOffset[1], positionOffset[2], 0.0f);
+
+			//バッファはアップロード後に返すので、CPUで判定するメッシュレットの境界はコピーしておく
+			buffers.meshlets.assign(mesh.meshlets, mesh.meshlets + mesh.meshletCount);
+
+			//LODのインデックスはLOD0の後ろに並んでいるので、インデックスバッファはそのまま全体をアップロードする
+			const MaterialDrawRange* lodMaterialRanges = reinterpret_cast<const MaterialDrawRange*>(mesh.lodMaterialRanges);
+			buffers.lods.assign(mesh.lods, mesh.lods + mesh.lodCount);
+			buffers.lodMaterialDrawRanges.assign(lodMaterialRanges, lodMaterialRanges + mesh.lodCount * mesh.materialRangeCount);
+
+			//バッファごとのアラインメント分の余裕を足しておく
+			meshUploads.push_back({ &mesh, &buffers });
+			uploadSizes.push_back(static_cast<uint64>(mesh.vertexCount) * mesh.vertexStride + static_cast<uint64>(mesh.indexCount) * mesh.indexStride + 8);
+		}
 
-		fin.close();
+		loadedSize += meshFiles[i].buffer.size();
+	}
 
-		//bV`CX^X𐶐
-		auto itr = _resourcePool->vertexAndIndexBuffers.emplace(std::piecewise_construct,
-			std::make_tuple(fileName),
-			std::make_tuple(materialRanges));
+	VectorArray<UINT64> fenceValues;
+	const uint32 submitCount = recordUploads(commandContext, threadPool, uploadSizes, [&](UploadContext& uploadContext, uint32 i) {
+		const MeshFileMesh& mesh = *meshUploads[i].mesh;
 
-		VertexAndIndexBuffer& buffers = (*itr.first).second;
-		buffers.boundingBox = boundingBox;
+		//頂点バッファ生成
+		meshUploads[i].buffers->vertexBuffer.createDeferred(device, uploadContext, mesh.vertices, mesh.vertexStride, mesh.vertexCount);
 
-		//_obt@
-		buffers.vertexBuffer.createDeferred<RawVertex>(device, commandList, &uploadHeaps[uploadHeapCounter++], vertices);
+		//インデックスバッファ。符号化されていればアップロードリングに直接戻す
+		IndexBuffer& indexBuffer = meshUploads[i].buffers->indexBuffer;
+		if (mesh.encodedIndices == nullptr) {
+			indexBuffer.createDeferred(device, uploadContext, mesh.indices, mesh.indexStride, mesh.indexCount);
+			return;
+		}
 
-		//CfbNXobt@
-		buffers.indexBuffer.createDeferred(device, commandList, &uploadHeaps[uploadHeapCounter++], indices);
+		MeshIndexDecoder decoder;
+		bool isDecoded = decoder.open(mesh.encodedIndices, mesh.encodedIndexSize);
+		indexBuffer.createDeferred(device, uploadContext, mesh.indexStride, mesh.indexCount, [&](void* dst, uint64 size) {
+			isDecoded = isDecoded && decoder.decode(dst, static_cast<uint32>(size / mesh.indexStride));
+		});
+		assert(isDecoded && "符号化されたインデックスを戻せません");
+	}, fenceValues);
+
+	for (uint32 i = 0; i < meshUploads.size(); ++i) {
+		meshUploads[i].buffers->vertexBuffer._uploadFenceValue = fenceValues[i];
+		meshUploads[i].buffers->indexBuffer._uploadFenceValue = fenceValues[i];
 	}
 
-	//Abv[hobt@GPUI[obt@ɃRs[
-	commandContext.executeCommandList(commandList);
-	commandContext.discardCommandListSet(commandListSet);
-
-	//Rs[I܂ŃAbv[hq[vjȂ
-	commandContext.waitForIdle();
+	addLoadStatistics(fileCount, loadedSize, submitCount, startTime);
 }
 
 RefPtr<GpuBuffer> GpuResourceManager::createOnlyGpuBuffer(const String& name){
@@ -431,6 +585,9 @@ RefPtr<BufferView> GpuResourceManager::createTextureBufferView(const String& vie
 	for (size_t i = 0; i < ppTextures.size(); ++i) {
 		RefPtr<Texture2D> texture;
 		loadTexture(textureNames[i], &texture);
+
+		//このビューはリソースを直接指すので、ストリーミングで差し替わらないように全ミップを読み込んで固定する
+		TextureStreamer::instance().pinTexture(*texture);
 		ppTextures[i] = texture->get();
 	}
 
@@ -471,36 +628,53 @@ RefPtr<PixelShader> GpuResourceManager::createPixelShader(const String& fileName
 }
 
 //void GpuResourceManager::loadSharedMaterial(const String & materialName, RefAddressOf<SingleMeshRenderPass> dstMaterial) const {
-//	assert(_resourcePool->sharedMaterials.count(materialName) > 0 && "}eA܂");
+//	assert(_resourcePool->sharedMaterials.count(materialName) > 0 && "マテリアルが見つかりません");
 //	*dstMaterial = &_resourcePool->sharedMaterials.at(materialName);
 //}
 
 void GpuResourceManager::loadConstantBuffer(const String& constantBufferName, RefAddressOf<ConstantBuffer> dstBuffer) const{
-	assert(_resourcePool->constantBuffers.count(constantBufferName) > 0 && "萔obt@܂");
+	assert(_resourcePool->constantBuffers.count(constantBufferName) > 0 && "定数バッファが見つかりません");
 	*dstBuffer = &_resourcePool->constantBuffers.at(constantBufferName);
 }
 
 void GpuResourceManager::loadTexture(const String & textureName, RefAddressOf<Texture2D> dstTexture) const {
-	assert(_resourcePool->textures.count(textureName) > 0 && "eNX`܂");
+	assert(_resourcePool->textures.count(textureName) > 0 && "テクスチャが見つかりません");
 	*dstTexture = &_resourcePool->textures.at(textureName);
 }
 
 void GpuResourceManager::loadVertexAndIndexBuffer(const String & meshName, RefAddressOf<VertexAndIndexBuffer> dstBuffers) const {
-	assert(_resourcePool->vertexAndIndexBuffers.count(meshName) > 0 && "bV܂");
+	assert(_resourcePool->vertexAndIndexBuffers.count(meshName) > 0 && "メッシュが見つかりません");
 	*dstBuffers = &_resourcePool->vertexAndIndexBuffers.at(meshName);
 }
 
 void GpuResourceManager::loadVertexShader(const String & shaderName, RefAddressOf<VertexShader> dstShader) const {
-	assert(_resourcePool->vertexShaders.count(shaderName) > 0 && "_VF[_[܂");
+	assert(_resourcePool->vertexShaders.count(shaderName) > 0 && "頂点シェーダーが見つかりません");
 	*dstShader = &_resourcePool->vertexShaders.at(shaderName);
 }
 
 void GpuResourceManager::loadPixelShader(const String & shaderName, RefAddressOf<PixelShader> dstShader) const {
-	assert(_resourcePool->pixelShaders.count(shaderName) > 0 && "sNZVF[_[܂");
+	assert(_resourcePool->pixelShaders.count(shaderName) > 0 && "ピクセルシェーダーが見つかりません");
 	*dstShader = &_resourcePool->pixelShaders.at(shaderName);
 }
 
+void GpuResourceManager::addLoadStatistics(uint32 fileCount, uint64 loadedSize, uint32 submitCount, const LARGE_INTEGER& startTime) {
+	LARGE_INTEGER endTime;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&endTime);
+	QueryPerformanceFrequency(&frequency);
+
+	_loadStatistics.fileCount += fileCount;
+	_loadStatistics.loadedSize += loadedSize;
+	_loadStatistics.submitCount += submitCount;
+	_loadStatistics.loadSeconds += static_cast<double>(endTime.QuadPart - startTime.QuadPart) / frequency.QuadPart;
+}
+
 void GpuResourceManager::shutdown() {
+	DescriptorHeapManager& descriptorHeapManager = DescriptorHeapManager::instance();
+	for (auto& texture : _resourcePool->textures) {
+		descriptorHeapManager.unregisterBindless(texture.second._bindlessHandle);
+	}
+
 	_resourcePool.reset();
 }
 
@@ -11,9 +11,22 @@ GraphicsCore::GraphicsCore() :
 	_width(1280),
 	_height(720),
 	_frameIndex(0),
+	_submittedFrameCount(0),
+	_frameFenceValues(),
+	_maxFramesInFlight(DefaultMaxFramesInFlight),
+	_maxRecordJobCount(1),
+	_timerFrequency(),
+	_lastFrameTime(),
 	_viewPort({}),
 	_scissorRect({}),
 	_dsv(),
+	_backBufferResource(InvalidRenderGraphResource),
+	_depthStencilResource(InvalidRenderGraphResource),
+	_clearPass(0),
+	_depthPrepass(0),
+	_mainPass(0),
+	_overlayPass(0),
+	_lastWaitedUploadFenceValue(0),
 	_currentFrameResource(nullptr) {
 }
 
@@ -42,34 +55,66 @@ void GraphicsCore::onInit(HWND hwnd) {
 		DXGI_ADAPTER_DESC1 desc;
 		adapter->GetDesc1(&desc);
 
-		//zDirect3D12ΉGPU͖
+		//仮想Direct3D12対応GPUは無視する
 		if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) {
 			continue;
 		}
 
-		//foCX̊mFI
+		//デバイス生成の確認が成功したら終了
 		if (SUCCEEDED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr))) {
 			break;
 		}
 	}
 
-	//foCX
+	//デバイス生成
 	throwIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&_device)));
 
-	//fXNv^q[v}l[W[
+	//GPUメモリアロケーター
+	_gpuMemoryAllocator.create(_device.Get(), GpuHeapPageSize, SmallUploadBufferPageSize);
+
+	//カメラ・ライト・ドローごとの定数を毎フレーム切り出すバッファ
+	_transientConstantAllocator.create(_device.Get(), TransientConstantBufferSizePerFrame);
+
+	//デスクリプタヒープマネージャー
 	_descriptorHeapManager.create(_device.Get());
 
-	//R}hReLXg
+	//コマンドコンテキスト生成
 	_graphicsCommandContext.create(_device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
 	_computeCommandContext.create(_device.Get(), D3D12_COMMAND_LIST_TYPE_COMPUTE);
 
-	//Imgui
+	//アップロードリングバッファ生成
+	_uploadRingBuffer.create(_device.Get(), UploadRingBufferSize);
+
+	//描画コマンド記録用ワーカースレッド 呼び出しスレッドも記録に参加するので論理コア数-1
+	const uint32 hardwareThreadCount = max(std::thread::hardware_concurrency(), 1u);
+	_commandRecordThreadPool.create(hardwareThreadCount - 1);
+	_maxRecordJobCount = hardwareThreadCount;
+
+	//アセットのアーカイブ。ファイルを読み込む前にマウントする
+	_assetFileSystem.mount(AssetArchivePath, AssetMountPoint);
+
+	//メッシュ、テクスチャ、シェーダーのファイル読み込み
+	IoServiceSettings ioServiceSettings;
+	ioServiceSettings.threadCount = IoThreadCount;
+	ioServiceSettings.readAheadBudget = IoReadAheadBudget;
+
+	//完了コールバックは専用のスレッドで呼ぶ。記録用のスレッドに積むと、parallelForの待ち中に拾われてフレームの記録が延びる
+	_ioCompletionThreadPool.create(IoCompletionThreadCount);
+	_ioService.create(ioServiceSettings, &_ioCompletionThreadPool);
+
+	//シェーダーを作る前に前回のコンパイル結果を読む。壊れていれば空にして、終了時に書き直す
+	_shaderCache.load(ShaderCachePath);
+
+	//テクスチャストリーミング。テクスチャの生成より先に初期化する
+	_textureStreamer.create(_device.Get(), &_graphicsCommandContext, TextureStreamingBudget);
+
+	//Imgui初期化
 	_imguiWindow.init(hwnd, _device.Get());
 
-	//fobO`@\
+	//デバッグ描画機能初期化
 	_debugGeometryRender.create(_device.Get(), &_graphicsCommandContext);
 
-	//Xbv`F[
+	//スワップチェーン生成
 	{
 		DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
 		swapChainDesc.BufferCount = FrameCount;
@@ -84,12 +129,12 @@ void GraphicsCore::onInit(HWND hwnd) {
 		throwIfFailed(factory->CreateSwapChainForHwnd(_graphicsCommandContext.getDirectQueue(), hwnd, &swapChainDesc, nullptr, nullptr, &swapChain));
 
 
-		//tXN[T|[gIt
+		//フルスクリーンサポートをオフ
 		throwIfFailed(factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
 		throwIfFailed(swapChain.As(&_swapChain));
 	}
 
-	//r[|[g
+	//ビューポート初期化
 	_viewPort.TopLeftX = 0.0f;
 	_viewPort.TopLeftY = 0.0f;
 	_viewPort.Width = static_cast<float>(_width);
@@ -99,18 +144,7 @@ void GraphicsCore::onInit(HWND hwnd) {
 
 	_scissorRect = { 0, 0, static_cast<LONG>(_width), static_cast<LONG>(_height) };
 
-	//fvXobt@
-	{
-		DepthTextureInfo depthInfo;
-		depthInfo.width = _width;
-		depthInfo.height = _height;
-		depthInfo.format = DepthStencilFormat;
-		_depthStencil.createDepth(_device.Get(), depthInfo);
-
-		_descriptorHeapManager.createDepthStencilView(_depthStencil.getAdressOf(), &_dsv, 1);
-	}
-
-	//t[\[X
+	//フレームリソース
 	for (int i = 0; i < FrameCount; ++i) {
 		_frameResources[i].create(_device.Get(), _swapChain.Get(), i);
 	}
@@ -118,9 +152,13 @@ void GraphicsCore::onInit(HWND hwnd) {
 	_frameIndex = _swapChain->GetCurrentBackBufferIndex();
 	_currentFrameResource = &_frameResources[_frameIndex];
 
-	_mainCameraConstantBuffer.create(_device.Get(), { sizeof(CameraConstantBuffer) });
-	_directionalLightBuffer.create(_device.Get(), { sizeof(DirectionalLightConstantBuffer) });
-	_pointlLightBuffer.create(_device.Get(), { sizeof(PointLightConstantBuffer) });
+	//フレームのパス構成 デプスバッファもここで生成する
+	_renderGraphExecutor.create(_device.Get());
+	setupRenderGraph();
+
+	//フレームペーシング計測用タイマー
+	QueryPerformanceFrequency(&_timerFrequency);
+	QueryPerformanceCounter(&_lastFrameTime);
 
 	String diffuseEnv("cubemapEnvHDR.dds");
 	createTextures({ diffuseEnv });
@@ -138,8 +176,13 @@ void GraphicsCore::onInit(HWND hwnd) {
 }
 
 void GraphicsCore::onUpdate() {
+	//このフレームインデックスの定数領域はmoveToNextFrameでGPUの完了を待っているので先頭から使い直せる
+	_transientConstantAllocator.beginFrame(_frameIndex);
+
 	_imguiWindow.startFrame();
 
+	drawFramePacingWindow();
+
 	static Vector3 positionC = -Vector3::forward * 15 + Vector3::up * 2.5f + Vector3::right * -10;
 	static float pitchC = -0.2f;
 	static float yawC = 1.0f;
@@ -170,8 +213,17 @@ void GraphicsCore::onUpdate() {
 	mainCamera->computeFlustomNormals();
 
 	CameraConstantBuffer cr = mainCamera->getCameraConstantBuffer();
-	_mainCameraConstantBuffer.writeBufferData(&cr, sizeof(CameraConstantBuffer));
-	_mainCameraConstantBuffer.flashBufferData(_frameIndex);
+	_frameConstantAddresses.addresses[FRAME_CONSTANT_CAMERA] = _transientConstantAllocator.push(cr);
+
+	//カメラが決まったのでミップの読み込みと解放を進め、このフレームのバインドレス変換表を確保する
+	{
+		_textureStreamer.update(*mainCamera, _height);
+
+		const uint32 remapCount = max(_descriptorHeapManager.getBindlessTable()->getUsedRange(), 1u);
+		TransientConstant remap = _transientConstantAllocator.allocate(remapCount * sizeof(uint32));
+		memcpy(remap.cpuAddress, _textureStreamer.getBindlessRemapTable(), remapCount * sizeof(uint32));
+		_frameConstantAddresses.addresses[FRAME_CONSTANT_BINDLESS_REMAP] = remap.gpuAddress;
+	}
 
 	static float pitchL = 1.0f;
 	static float yawL = 0.2f;
@@ -208,154 +260,211 @@ void GraphicsCore::onUpdate() {
 	pointLight.color = colorP;
 	pointLight.attenuation = atteration;
 
-	_directionalLightBuffer.writeBufferData(&directionalLight, sizeof(directionalLight));
-	_directionalLightBuffer.flashBufferData(_frameIndex);
-
-	_pointlLightBuffer.writeBufferData(&pointLight, sizeof(pointLight));
-	_pointlLightBuffer.flashBufferData(_frameIndex);
+	_frameConstantAddresses.addresses[FRAME_CONSTANT_DIRECTIONAL_LIGHT] = _transientConstantAllocator.push(directionalLight);
+	_frameConstantAddresses.addresses[FRAME_CONSTANT_POINT_LIGHT] = _transientConstantAllocator.push(pointLight);
 }
 
 void GraphicsCore::onRender() {
-	D3D12_GPU_VIRTUAL_ADDRESS cameraBufferAddress = _mainCameraConstantBuffer.constantBuffers[_frameIndex].getGpuVirtualAddress();
-	RefPtr<ID3D12DescriptorHeap> ppHeap[] = { _descriptorHeapManager.getD3dDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) };
-	
-	//GPUJO
+	RefPtr<ID3D12DescriptorHeap> ppHeap[] = { _descriptorHeapManager.getD3dDescriptorHeap() };
+
+	//GPUカリング
+	//コンピュートキューで実行し、前フレームのグラフィックス処理とオーバーラップさせる
 	{
-		auto commandListSet = _graphicsCommandContext.requestCommandListSet();
+		auto commandListSet = _computeCommandContext.requestCommandListSet();
 		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
 
-		//fXNv^q[vZbg
+		//デスクリプタヒープをセット
 		commandList->SetDescriptorHeaps(1, ppHeap);
 
-		//`ݒ
-		RenderSettings renderSettings(commandList, cameraBufferAddress, _frameIndex);
+		//描画設定
+		RenderSettings renderSettings(commandList, _frameConstantAddresses, &_transientConstantAllocator, _descriptorHeapManager.getShaderVisibleHeap(), _frameIndex);
 		for (auto&& multiMesh : _multiMeshes) {
 			multiMesh.onCompute(renderSettings);
 		}
 
-		//R}hL[ɃR}hXgnĎs
-		_graphicsCommandContext.executeCommandList(commandListSet);
-		_graphicsCommandContext.discardCommandListSet(commandListSet);
-		_graphicsCommandContext.waitForIdle();
-	}
+		//アップロードはグラフィックスキューで完了を待たずに提出しているので、コンピュートキュー側で転送完了を待たせる
+		UINT64 uploadFenceValue = _uploadRingBuffer.getLastSubmittedFenceValue();
+		if (uploadFenceValue != _lastWaitedUploadFenceValue) {
+			_computeCommandContext.getCommandQueue()->waitForQueue(_graphicsCommandContext.getCommandQueue(), uploadFenceValue);
+			_lastWaitedUploadFenceValue = uploadFenceValue;
+		}
 
-	//fvXvpX
-	{
-		auto commandListSet = _graphicsCommandContext.requestCommandListSet();
-		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
+		//コマンドキューにコマンドリストを渡して実行
+		_computeCommandContext.executeCommandList(commandListSet);
+		_computeCommandContext.discardCommandListSet(commandListSet);
 
-		//fXNv^q[vZbg
-		commandList->SetDescriptorHeaps(1, ppHeap);
+		//このフレームのカリング結果を使うパスより前にグラフィックスキュー側でカリング完了を待たせる
+		_graphicsCommandContext.getCommandQueue()->waitForQueue(_computeCommandContext.getCommandQueue(), commandListSet.fenceValue);
+	}
+
+	LARGE_INTEGER recordStartTime;
+	QueryPerformanceCounter(&recordStartTime);
+
+	//シングルメッシュの描画コマンドはチャンクに分割してワーカースレッドで並列に積む
+	//コマンドリストの並びは [クリア] [デプス開始] [デプスチャンク x N] [メイン開始] [メインチャンク x N] [オーバーレイ]
+	//各パスの開始リストの先頭でレンダーグラフが計算したバリアを発行する
+	//パス間の依存関係はキュー内の実行順序とリソースバリアで保証されるのでCPUは待機しない
+	const uint32 singleMeshCount = static_cast<uint32>(_singleMeshes.size());
+	const uint32 recordJobCount = computeRecordJobCount(singleMeshCount);
+	const uint32 commandListSetCount = recordJobCount * 2 + 4;
+	const uint32 depthChunkOffset = 2;
+	const uint32 mainChunkOffset = depthChunkOffset + recordJobCount + 1;
+
+	VectorArray<CommandListSet> commandListSets;
+	commandListSets.reserve(commandListSetCount);
+	for (uint32 i = 0; i < commandListSetCount; ++i) {
+		commandListSets.emplace_back(_graphicsCommandContext.requestCommandListSet());
+	}
 
-		//r[|[gݒ
-		commandList->RSSetViewports(1, &_viewPort);
-		commandList->RSSetScissorRects(1, &_scissorRect);
+	//バックバッファはフレームごとに入れ替わる
+	_renderGraphExecutor.setImportedResource(_backBufferResource, _currentFrameResource->_renderTarget->get());
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = _currentFrameResource->_rtv.cpuHandle;
 
-		//fvXpXȂ̂ŃfvXobt@̂݃oCh
-		commandList->OMSetRenderTargets(0, nullptr, FALSE, &_dsv.cpuHandle);
+	//レンダーターゲット・デプスバッファクリア
+	if (!_renderGraph.isPassCulled(_clearPass)) {
+		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSets[0].commandList;
+		_renderGraphExecutor.recordPassBarriers(commandList, _renderGraph, _clearPass);
 
-		//fvXobt@NA
+		const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+		commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 		commandList->ClearDepthStencilView(_dsv.cpuHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+	}
 
-		//fvXpX`
-		RenderSettings renderSettings(commandList, cameraBufferAddress, _frameIndex);
-		for (auto&& mesh : _singleMeshes) {
-			mesh.setupDepthPassCommand(renderSettings);
-		}
+	//GPU駆動メッシュのデプスパス
+	if (!_renderGraph.isPassCulled(_depthPrepass)) {
+		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSets[1].commandList;
+		_renderGraphExecutor.recordPassBarriers(commandList, _renderGraph, _depthPrepass);
+
+		//デプスパスなのでデプスバッファのみバインド
+		setupPassCommonState(commandList, true);
 
+		RenderSettings renderSettings(commandList, _frameConstantAddresses, &_transientConstantAllocator, _descriptorHeapManager.getShaderVisibleHeap(), _frameIndex);
 		for (auto&& mesh : _multiMeshes) {
 			mesh.setupDepthPassCommand(renderSettings);
 		}
-
-		_graphicsCommandContext.executeCommandList(commandListSet);
-		_graphicsCommandContext.discardCommandListSet(commandListSet);
-		_graphicsCommandContext.waitForIdle();
 	}
 
-	//CpX
-	{
-		auto commandListSet = _graphicsCommandContext.requestCommandListSet();
-		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
-
-		//fXNv^q[vZbg
-		commandList->SetDescriptorHeaps(1, ppHeap);
-
-		//r[|[gݒ
-		commandList->RSSetViewports(1, &_viewPort);
-		commandList->RSSetScissorRects(1, &_scissorRect);
+	//GPU駆動メッシュのメインパス
+	if (!_renderGraph.isPassCulled(_mainPass)) {
+		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSets[mainChunkOffset - 1].commandList;
+		_renderGraphExecutor.recordPassBarriers(commandList, _renderGraph, _mainPass);
+		setupPassCommonState(commandList, false);
 
-		//R}hςޗp̃\[XoAWJ
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_currentFrameResource->_renderTarget->get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-		//_[^[QbgEfvXXeVobt@Zbg
-		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = _currentFrameResource->_rtv.cpuHandle;
-		commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &_dsv.cpuHandle);
+		RenderSettings renderSettings(commandList, _frameConstantAddresses, &_transientConstantAllocator, _descriptorHeapManager.getShaderVisibleHeap(), _frameIndex);
+		for (auto&& mesh : _multiMeshes) {
+			mesh.setupMainPassCommand(renderSettings);
+		}
+	}
 
-		//_[^[QbgNA
-		const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-		commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+	//シングルメッシュのデプスプリパスとメインパス
+	_commandRecordThreadPool.parallelFor(recordJobCount * 2, [&](uint32 jobIndex) {
+		const bool isDepthPass = jobIndex < recordJobCount;
+		const uint32 chunkIndex = isDepthPass ? jobIndex : jobIndex - recordJobCount;
+		const uint32 meshStart = singleMeshCount * chunkIndex / recordJobCount;
+		const uint32 meshEnd = singleMeshCount * (chunkIndex + 1) / recordJobCount;
 
-		//CpX`
-		RenderSettings renderSettings(commandList, cameraBufferAddress, _frameIndex);
-		for (auto&& mesh : _singleMeshes) {
-			mesh.setupMainPassCommand(renderSettings);
+		if (_renderGraph.isPassCulled(isDepthPass ? _depthPrepass : _mainPass)) {
+			return;
 		}
 
-		for (auto&& mesh : _multiMeshes) {
-			mesh.setupMainPassCommand(renderSettings);
+		const uint32 commandListIndex = (isDepthPass ? depthChunkOffset : mainChunkOffset) + chunkIndex;
+		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSets[commandListIndex].commandList;
+		setupPassCommonState(commandList, isDepthPass);
+
+		RenderSettings renderSettings(commandList, _frameConstantAddresses, &_transientConstantAllocator, _descriptorHeapManager.getShaderVisibleHeap(), _frameIndex);
+		for (uint32 i = meshStart; i < meshEnd; ++i) {
+			if (isDepthPass) {
+				_singleMeshes[i].setupDepthPassCommand(renderSettings);
+			}
+			else {
+				_singleMeshes[i].setupMainPassCommand(renderSettings);
+			}
 		}
+	});
 
-		//fobO`R}h@1t[Ƃɕ`惊Xg̓N[Abv
-		_debugGeometryRender.updatePerInstanceData(_frameIndex);
-		_debugGeometryRender.setupRenderCommand(renderSettings);
-		_debugGeometryRender.clearDebugDatas();
+	//デバッグ描画、Imgui
+	{
+		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSets.back().commandList;
+		if (!_renderGraph.isPassCulled(_overlayPass)) {
+			_renderGraphExecutor.recordPassBarriers(commandList, _renderGraph, _overlayPass);
+			setupPassCommonState(commandList, false);
+
+			//デバッグ描画コマンド発効　1フレームごとに描画リストはクリーンアップされる
+			RenderSettings renderSettings(commandList, _frameConstantAddresses, &_transientConstantAllocator, _descriptorHeapManager.getShaderVisibleHeap(), _frameIndex);
+			_debugGeometryRender.updatePerInstanceData(_frameIndex);
+			_debugGeometryRender.setupRenderCommand(renderSettings);
+			_debugGeometryRender.clearDebugDatas();
+
+			//ImguiWindow描画
+			_imguiWindow.renderFrame(commandList);
+		}
 
-		//ImguiWindow`
-		_imguiWindow.renderFrame(commandList);
+		//バックバッファをPresent用のステートに戻す
+		_renderGraphExecutor.recordFinalBarriers(commandList, _renderGraph);
+	}
 
-		//`p\[XoAWJ
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_currentFrameResource->_renderTarget->get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	LARGE_INTEGER recordEndTime;
+	QueryPerformanceCounter(&recordEndTime);
+	const float recordTime = (recordEndTime.QuadPart - recordStartTime.QuadPart) * 1000.0f / static_cast<float>(_timerFrequency.QuadPart);
+	_framePacingStatistics.addRecordTime(recordTime, recordJobCount);
 
-		//R}hL[ɃR}hXgnĎs
-		_graphicsCommandContext.executeCommandList(commandListSet);
-		_graphicsCommandContext.discardCommandListSet(commandListSet); 
+	//コマンドキューに記録順のままコマンドリストを渡して1回で実行
+	_graphicsCommandContext.executeCommandLists(commandListSets.data(), commandListSetCount);
+	for (const auto& commandListSet : commandListSets) {
+		_graphicsCommandContext.discardCommandListSet(commandListSet);
 	}
 
-	//ʕ\
+	//画面表示
 	throwIfFailed(_swapChain->Present(1, 0));
 
-	//`抮܂őҋ@
+	//次のフレームリソースが使用可能になるまで待機
 	moveToNextFrame();
 }
 
 void GraphicsCore::onDestroy() {
-	//`撆ɔjĂ܂ƍ̂ő҂
+	//描画中に破棄してしまうと困るので待つ
+	_computeCommandContext.waitForIdle();
 	_graphicsCommandContext.waitForIdle();
 
+	//実行中にコンパイルし直したシェーダーがあれば次回のために書き出す
+	if (_shaderCache.isDirty()) {
+		_shaderCache.save(ShaderCachePath);
+	}
+
+	//読み込みの完了コールバックは専用のスレッドで呼ぶので、そのスレッドより先に止める
+	_ioService.shutdown();
+	_ioCompletionThreadPool.shutdown();
+	_commandRecordThreadPool.shutdown();
+	_renderGraphExecutor.shutdown();
+
 	for (int i = 0; i < FrameCount; ++i) {
 		_frameResources[i].shutdown();
 	}
 
-	_mainCameraConstantBuffer.shutdown();
 	_debugGeometryRender.destroy();
 
 	_imguiWindow.shutdown();
+	_textureStreamer.shutdown();
 	_gpuResourceManager.shutdown();
+	_assetFileSystem.unmountAll();
+	_uploadRingBuffer.shutdown();
 
 	_graphicsCommandContext.shutdown();
 	_computeCommandContext.shutdown();
 	_descriptorHeapManager.shutdown();
+	_transientConstantAllocator.shutdown();
+	_gpuMemoryAllocator.shutdown();
 
 	_swapChain = nullptr;
 	_device = nullptr;
 }
 
 void GraphicsCore::createTextures(const VectorArray<String>& textureNames) {
-	_gpuResourceManager.createTextures(_device.Get(), _graphicsCommandContext, textureNames);
+	_gpuResourceManager.createTextures(_device.Get(), _graphicsCommandContext, _commandRecordThreadPool, textureNames);
 }
 
 void GraphicsCore::createMeshSets(const VectorArray<String>& fileNames) {
-	_gpuResourceManager.createVertexAndIndexBuffer(_device.Get(), _graphicsCommandContext, fileNames);
+	_gpuResourceManager.createVertexAndIndexBuffer(_device.Get(), _graphicsCommandContext, _commandRecordThreadPool, fileNames);
 }
 
 void GraphicsCore::createSharedMaterial(const SharedMaterialCreateSettings& settings) {
@@ -373,7 +482,7 @@ void GraphicsCore::createSingleMeshMaterial(const String& name, const InitSettin
 
 SingleMeshRenderInstance GraphicsCore::createSingleMeshRenderInstance(const String& name, const VectorArray<InitSettingsPerSingleMesh>& materialInfos){
 	StaticSingleMesh singleMesh;
-	singleMesh.create(_device.Get(), name, _mainCameraConstantBuffer, materialInfos);
+	singleMesh.create(_device.Get(), name, materialInfos);
 
 	_singleMeshes.emplace_back(std::move(singleMesh));
 
@@ -382,6 +491,15 @@ SingleMeshRenderInstance GraphicsCore::createSingleMeshRenderInstance(const Stri
 	return instance;
 }
 
+SingleMeshRenderInstance GraphicsCore::duplicateSingleMeshRenderInstance(const SingleMeshRenderInstance& source) {
+	//マテリアルはワールド行列以外を参照で持っているのでコピーすればパイプラインステート等を共有できる
+	_singleMeshes.emplace_back(*source._mesh);
+
+	SingleMeshRenderInstance instance;
+	instance._mesh = &_singleMeshes.back();
+	return instance;
+}
+
 StaticMultiMeshRenderInstance GraphicsCore::createStaticMultiMeshRender(const String& name, const InitSettingsPerStaticMultiMesh& meshDatas){
 	//auto itr = _multiMeshRenderMaterials.emplace(std::piecewise_construct,
 	//	std::make_tuple(name),
@@ -390,10 +508,8 @@ StaticMultiMeshRenderInstance GraphicsCore::createStaticMultiMeshRender(const St
 	//RefPtr<StaticMultiMeshMaterial> material = &(*itr.first).second;
 	//material->create(_device.Get(), &_graphicsCommandContext, meshDatas);
 
-	InitBufferInfo bufferInfo = { _mainCameraConstantBuffer,_directionalLightBuffer,_pointlLightBuffer };
-
 	StaticMultiMesh multiMesh;
-	multiMesh.create(_device.Get(), &_graphicsCommandContext, bufferInfo, meshDatas);
+	multiMesh.create(_device.Get(), &_graphicsCommandContext, meshDatas);
 	_multiMeshes.emplace_back(std::move(multiMesh));
 
 	//return StaticMultiMeshRenderInstance(material);
@@ -408,14 +524,371 @@ RefPtr<DebugGeometryRender> GraphicsCore::getDebugGeometryRender() {
 	return &_debugGeometryRender;
 }
 
+void GraphicsCore::setMaxFramesInFlight(uint32 maxFramesInFlight) {
+	assert(maxFramesInFlight >= 1 && maxFramesInFlight <= FrameCount && "先行フレーム数は1～FrameCountの範囲で指定してください");
+	_maxFramesInFlight = maxFramesInFlight;
+}
+
+uint32 GraphicsCore::getMaxFramesInFlight() const {
+	return _maxFramesInFlight;
+}
+
 void GraphicsCore::moveToNextFrame() {
 	RefPtr<CommandQueue> commandQueue = _graphicsCommandContext.getCommandQueue();
-	const UINT64 currentFenceValue = _frameResources[_frameIndex]._fenceValue;
-	commandQueue->waitForFence(currentFenceValue);
+
+	//このフレームで発行したコマンドがすべて完了した時点のフェンス値を記録
+	const UINT64 submittedFenceValue = commandQueue->incrementFence();
+	_currentFrameResource->_fenceValue = submittedFenceValue;
+	_frameFenceValues[_submittedFrameCount % FrameCount] = submittedFenceValue;
+	++_submittedFrameCount;
+
+	//このフレームでリングにコピーしたデスクリプタテーブルと解除したバインドレスのスロットはフレームの完了で解放する
+	//コンピュートキューの処理はグラフィックスキューが待っているので、グラフィックスのフェンス値だけで判断できる
+	RefPtr<ShaderVisibleDescriptorHeap> shaderVisibleHeap = _descriptorHeapManager.getShaderVisibleHeap();
+	RefPtr<BindlessDescriptorTable> bindlessTable = _descriptorHeapManager.getBindlessTable();
+	shaderVisibleHeap->submit(submittedFenceValue);
+	bindlessTable->submit(submittedFenceValue);
+	_textureStreamer.submit(submittedFenceValue);
+
+	//GPUがまだ処理し終えていないフレーム数
+	uint32 framesInFlight = 0;
+	for (uint32 i = 0; i < FrameCount; ++i) {
+		if (!commandQueue->isFenceComplete(_frameFenceValues[i])) {
+			++framesInFlight;
+		}
+	}
 
 	_frameIndex = _swapChain->GetCurrentBackBufferIndex();
 	_currentFrameResource = &_frameResources[_frameIndex];
 
-	const UINT64 fenceValue = commandQueue->incrementFence();
-	_frameResources[_frameIndex]._fenceValue = fenceValue;
+	//次に書き込むフレームリソースをGPUが使い終えていること、
+	//かつCPUの先行フレーム数が上限を超えないことを待機条件にする
+	UINT64 waitFenceValue = _currentFrameResource->_fenceValue;
+	if (_submittedFrameCount >= _maxFramesInFlight) {
+		const UINT64 oldestAllowedFrame = _submittedFrameCount - _maxFramesInFlight;
+		waitFenceValue = max(waitFenceValue, _frameFenceValues[oldestAllowedFrame % FrameCount]);
+	}
+
+	LARGE_INTEGER waitStartTime;
+	LARGE_INTEGER waitEndTime;
+	QueryPerformanceCounter(&waitStartTime);
+	commandQueue->waitForFence(waitFenceValue);
+	QueryPerformanceCounter(&waitEndTime);
+
+	const UINT64 completedFenceValue = commandQueue->fenceValue();
+	shaderVisibleHeap->reclaim(completedFenceValue);
+	bindlessTable->reclaim(completedFenceValue);
+	_textureStreamer.reclaim(completedFenceValue);
+
+	//フレーム時間とフェンス待機時間(ms)を記録
+	const float frequency = static_cast<float>(_timerFrequency.QuadPart);
+	const float cpuFrameTime = (waitEndTime.QuadPart - _lastFrameTime.QuadPart) * 1000.0f / frequency;
+	const float fenceWaitTime = (waitEndTime.QuadPart - waitStartTime.QuadPart) * 1000.0f / frequency;
+	_framePacingStatistics.addFrame(cpuFrameTime, fenceWaitTime, framesInFlight);
+	_lastFrameTime = waitEndTime;
+}
+
+void GraphicsCore::drawFramePacingWindow() {
+	int maxFramesInFlight = static_cast<int>(_maxFramesInFlight);
+	int maxRecordJobCount = static_cast<int>(_maxRecordJobCount);
+
+	ImGui::Begin("FramePacing");
+	ImGui::SliderInt("MaxFramesInFlight", &maxFramesInFlight, 1, FrameCount);
+	ImGui::SliderInt("MaxRecordJobs", &maxRecordJobCount, 1, static_cast<int>(_commandRecordThreadPool.getWorkerCount() + 1));
+	ImGui::Text("SingleMeshes : %d", static_cast<int>(_singleMeshes.size()));
+	_framePacingStatistics.drawImgui();
+
+	if (ImGui::TreeNode("CommandPools")) {
+		drawFencedPoolStatistics("Graphics Allocator", _graphicsCommandContext.getCommandAllocatorStatistics());
+		drawFencedPoolStatistics("Graphics List", _graphicsCommandContext.getCommandListStatistics());
+		drawFencedPoolStatistics("Compute Allocator", _computeCommandContext.getCommandAllocatorStatistics());
+		drawFencedPoolStatistics("Compute List", _computeCommandContext.getCommandListStatistics());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("GpuHeaps")) {
+		for (uint32 i = 0; i < GpuMemoryAllocator::POOL_COUNT; ++i) {
+			const GpuMemoryAllocator::Pool pool = static_cast<GpuMemoryAllocator::Pool>(i);
+			const GpuHeapStatistics statistics = _gpuMemoryAllocator.getStatistics(pool);
+			ImGui::Text("%s : Pages %d / Allocations %d / Committed %d", GpuMemoryAllocator::getPoolName(pool),
+				static_cast<int>(statistics.pageCount), static_cast<int>(statistics.allocationCount), static_cast<int>(statistics.committedFallbackCount));
+			ImGui::Text("  Used %.2f MB / Reserved %.2f MB (Largest Free %.2f MB)", statistics.usedSize / (1024.0f * 1024.0f),
+				statistics.reservedSize / (1024.0f * 1024.0f), statistics.largestFreeBlockSize / (1024.0f * 1024.0f));
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Descriptors")) {
+		const ShaderVisibleDescriptorHeap::Statistics statistics = _descriptorHeapManager.getShaderVisibleHeap()->getStatistics();
+		ImGui::Text("Persistent %d / %d", static_cast<int>(statistics.persistentUsedCount), static_cast<int>(statistics.persistentCapacity));
+		ImGui::Text("Ring %d / %d (Peak %d, Copies %d)", static_cast<int>(statistics.ringUsedCount), static_cast<int>(statistics.ringCapacity),
+			static_cast<int>(statistics.ringPeakUsedCount), static_cast<int>(statistics.ringCopyCount));
+
+		const BindlessIndexAllocator::Statistics bindlessStatistics = _descriptorHeapManager.getBindlessTable()->getStatistics();
+		ImGui::Text("Bindless %d / %d (Peak %d, PendingFree %d)", static_cast<int>(bindlessStatistics.liveCount), static_cast<int>(bindlessStatistics.capacity),
+			static_cast<int>(bindlessStatistics.peakLiveCount), static_cast<int>(bindlessStatistics.pendingFreeCount));
+
+		const D3D12_DESCRIPTOR_HEAP_TYPE stagingTypes[] = { D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_DSV };
+		const char* stagingNames[] = { "CBV_SRV_UAV", "RTV", "DSV" };
+		for (uint32 i = 0; i < 3; ++i) {
+			const DescriptorStagingHeap::Statistics stagingStatistics = _descriptorHeapManager.getStagingHeap(stagingTypes[i])->getStatistics();
+			ImGui::Text("Staging %s : Pages %d / %d / %d", stagingNames[i], static_cast<int>(stagingStatistics.pageCount),
+				static_cast<int>(stagingStatistics.usedCount), static_cast<int>(stagingStatistics.capacity));
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("TransientConstants")) {
+		ImGui::Text("Used %.2f KB / Peak %.2f KB / Capacity %.2f KB", _transientConstantAllocator.getUsedSize() / 1024.0f,
+			_transientConstantAllocator.getPeakUsedSize() / 1024.0f, _transientConstantAllocator.getSizePerFrame() / 1024.0f);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("UploadRingBuffer")) {
+		FencedRingAllocator::Statistics statistics = _uploadRingBuffer.getStatistics();
+		ImGui::Text("Allocations %d (Failed %d)", static_cast<int>(statistics.allocationCount), static_cast<int>(statistics.failedAllocationCount));
+		ImGui::Text("Uploaded %.2f MB / Peak %.2f MB", statistics.allocatedSize / (1024.0f * 1024.0f), statistics.peakUsedSize / (1024.0f * 1024.0f));
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("TextureStreaming")) {
+		const TextureStreamer::Statistics statistics = _textureStreamer.getStatistics();
+		ImGui::Text("Textures %d (Pinned %d) / Pending %d / Retired %d", static_cast<int>(statistics.streamingTextureCount),
+			static_cast<int>(statistics.pinnedTextureCount), static_cast<int>(statistics.pendingLoadCount), static_cast<int>(statistics.retiredTextureCount));
+		ImGui::Text("Resident %.2f MB / Budget %.2f MB", statistics.residentSize / (1024.0f * 1024.0f), statistics.budget / (1024.0f * 1024.0f));
+		ImGui::Text("Mips Loaded %d / Evicted %d (%.2f MB)", static_cast<int>(statistics.loadedMipCount),
+			static_cast<int>(statistics.evictedMipCount), statistics.loadedSize / (1024.0f * 1024.0f));
+
+		int budgetMb = static_cast<int>(_textureStreamer.getBudget() / (1024 * 1024));
+		if (ImGui::SliderInt("Budget MB", &budgetMb, 16, 1024)) {
+			_textureStreamer.setBudget(static_cast<uint64>(budgetMb) * 1024 * 1024);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("ResourceLoading")) {
+		const ResourceLoadStatistics& statistics = _gpuResourceManager.getLoadStatistics();
+		ImGui::Text("Files %d / %.2f MB / Submits %d", static_cast<int>(statistics.fileCount),
+			statistics.loadedSize / (1024.0f * 1024.0f), static_cast<int>(statistics.submitCount));
+		ImGui::Text("%.2f ms (%.1f MB/s)", statistics.loadSeconds * 1000.0f, statistics.getThroughput());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("DdsLoadBenchmark")) {
+		if (ImGui::Button("Run")) {
+			_ddsLoadBenchmarkResult = DdsLoadBenchmark::run("Resources/");
+		}
+
+		const DdsLoadBenchmarkResult& result = _ddsLoadBenchmarkResult;
+		ImGui::Text("Files %d / %.2f MB", static_cast<int>(result.fileCount), result.totalSize / (1024.0f * 1024.0f));
+		ImGui::Text("Read %.2f ms (%.1f MB/s)", result.readSeconds * 1000.0f, result.getReadThroughput());
+		ImGui::Text("Mapped %.2f ms (%.1f MB/s)", result.mappedSeconds * 1000.0f, result.getMappedThroughput());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("MeshLoadBenchmark")) {
+		if (ImGui::Button("Run")) {
+			_meshLoadBenchmarkResult = MeshLoadBenchmark::run("Resources/");
+		}
+
+		const MeshLoadBenchmarkResult& result = _meshLoadBenchmarkResult;
+		ImGui::Text("Files %d (v1 %d) / Meshes %d / %.2f MB", static_cast<int>(result.fileCount), static_cast<int>(result.v1FileCount),
+			static_cast<int>(result.meshCount), result.totalSize / (1024.0f * 1024.0f));
+		ImGui::Text("Read %.2f ms (%.1f MB/s)", result.readSeconds * 1000.0f, result.getReadThroughput());
+		ImGui::Text("Mapped %.2f ms (%.1f MB/s)", result.mappedSeconds * 1000.0f, result.getMappedThroughput());
+		ImGui::Text("Verify Hashes %.2f ms", result.verifySeconds * 1000.0f);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("AssetLoadBenchmark")) {
+		if (ImGui::Button("Run")) {
+			_assetLoadBenchmarkResult = AssetLoadBenchmark::run(AssetArchivePath, AssetMountPoint);
+		}
+
+		const AssetLoadBenchmarkResult& result = _assetLoadBenchmarkResult;
+		ImGui::Text("Archive %s (Mounted %d)", AssetArchivePath, static_cast<int>(_assetFileSystem.getMountedArchiveCount()));
+		ImGui::Text("Files %d (Compressed %d) / %.2f MB -> %.2f MB", static_cast<int>(result.fileCount), static_cast<int>(result.compressedCount),
+			result.totalSize / (1024.0f * 1024.0f), result.storedSize / (1024.0f * 1024.0f));
+		ImGui::Text("Cold Loose %.2f ms / Archive %.2f ms", result.coldLooseSeconds * 1000.0f, result.coldArchiveSeconds * 1000.0f);
+		ImGui::Text("Warm Loose %.2f ms / Archive %.2f ms", result.warmLooseSeconds * 1000.0f, result.warmArchiveSeconds * 1000.0f);
+		ImGui::Text(result.isValid ? "Valid" : "Invalid");
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("IoLoadBenchmark")) {
+		if (ImGui::Button("Run")) {
+			_ioLoadBenchmarkResult = IoLoadBenchmark::run(AssetMountPoint);
+		}
+
+		const IoServiceStatistics statistics = _ioService.getStatistics();
+		ImGui::Text("IoService Pending %d / Read-ahead %.2f MB (Peak %.2f MB)", static_cast<int>(statistics.pendingRequestCount),
+			statistics.readAheadSize / (1024.0f * 1024.0f), statistics.maxReadAheadSize / (1024.0f * 1024.0f));
+
+		const IoLoadBenchmarkResult& result = _ioLoadBenchmarkResult;
+		ImGui::Text("Files %d / Requests %d / %.2f MB", static_cast<int>(result.fileCount), static_cast<int>(result.requestCount), result.totalSize / (1024.0f * 1024.0f));
+		ImGui::Text("Sequential %.2f ms (%.1f MB/s)", result.sequentialSeconds * 1000.0f, result.getSequentialThroughput());
+		ImGui::Text("IoService %.2f ms (%.1f MB/s) / Reads %d (Coalesced %d)", result.ioServiceSeconds * 1000.0f, result.getIoServiceThroughput(),
+			static_cast<int>(result.readCount), static_cast<int>(result.coalescedRequestCount));
+
+		const char* priorityNames[IO_PRIORITY_COUNT] = { "High", "Normal", "Low" };
+		for (uint32 i = 0; i < IO_PRIORITY_COUNT; ++i) {
+			const IoLoadPriorityResult& priorityResult = result.priorities[i];
+			ImGui::Text("  %s %d : Avg %.2f / P50 %.2f / P95 %.2f / Max %.2f ms", priorityNames[i], static_cast<int>(priorityResult.requestCount),
+				priorityResult.averageMilliseconds, priorityResult.p50Milliseconds, priorityResult.p95Milliseconds, priorityResult.maxMilliseconds);
+		}
+
+		ImGui::Text(result.isValid ? "Valid" : "Invalid");
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("ShaderCache")) {
+		const ShaderCacheStatistics statistics = _shaderCache.getStatistics();
+		ImGui::Text("Entries %d / Hit %d / Miss %d", static_cast<int>(statistics.entryCount), static_cast<int>(statistics.hitCount), static_cast<int>(statistics.missCount));
+		if (statistics.isDiscarded) {
+			ImGui::Text("Discarded invalid cache file");
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("RenderGraph")) {
+		const RenderGraphStatistics& statistics = _renderGraph.getStatistics();
+		ImGui::Text("Passes %d (Culled %d)", static_cast<int>(statistics.passCount), static_cast<int>(statistics.culledPassCount));
+		ImGui::Text("Barriers Transition %d / Aliasing %d / UAV %d", static_cast<int>(statistics.transitionBarrierCount),
+			static_cast<int>(statistics.aliasingBarrierCount), static_cast<int>(statistics.uavBarrierCount));
+		ImGui::Text("Discards %d", static_cast<int>(statistics.discardCount));
+		ImGui::Text("Transient %d : %.2f MB -> %.2f MB (Saved %.2f MB)", static_cast<int>(statistics.transientResourceCount),
+			statistics.transientMemoryWithoutAliasing / (1024.0f * 1024.0f), statistics.transientHeapSize / (1024.0f * 1024.0f),
+			statistics.getMemorySaved() / (1024.0f * 1024.0f));
+
+		for (uint32 i = 0; i < _renderGraph.getPassCount(); ++i) {
+			const bool isCulled = _renderGraph.isPassCulled(i);
+			ImGui::Text("  %s%s : %d barriers", _renderGraph.getPassDesc(i).name.c_str(), isCulled ? " (culled)" : "",
+				isCulled ? 0 : static_cast<int>(_renderGraph.getPassBarriers(i).size()));
+		}
+
+		ImGui::TreePop();
+	}
+
+	ImGui::End();
+
+	setMaxFramesInFlight(static_cast<uint32>(maxFramesInFlight));
+	_maxRecordJobCount = static_cast<uint32>(maxRecordJobCount);
+}
+
+void GraphicsCore::drawFencedPoolStatistics(const char* name, const FencedPoolStatistics& statistics) {
+	ImGui::Text("%s", name);
+	ImGui::Text("  Created %d / Reused %d / InUse %d (Peak %d)",
+		static_cast<int>(statistics.createCount), static_cast<int>(statistics.reuseCount),
+		static_cast<int>(statistics.inUseCount), static_cast<int>(statistics.highWatermark));
+	ImGui::Text("  FenceWait %d / Overflow %d", static_cast<int>(statistics.waitCount), static_cast<int>(statistics.overflowCount));
+}
+
+void GraphicsCore::setupRenderGraph() {
+	_renderGraph.clear();
+
+	//バックバッファはPresentで受け取りPresentで返す
+	_backBufferResource = _renderGraph.importResource("BackBuffer", RENDER_GRAPH_STATE_PRESENT, RENDER_GRAPH_STATE_PRESENT);
+
+	//デプスはフレームの外に内容を持ち越さないのでトランジェントにして、グラフのヒープに配置する
+	//Clearパスで最初に書き込むので、ほかのトランジェントとメモリを共有しても破棄とクリアで初期化される
+	{
+		D3D12_RESOURCE_DESC depthDesc = {};
+		depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		depthDesc.Width = _width;
+		depthDesc.Height = _height;
+		depthDesc.DepthOrArraySize = 1;
+		depthDesc.MipLevels = 1;
+		depthDesc.Format = DepthStencilFormat;
+		depthDesc.SampleDesc.Count = 1;
+		depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+		D3D12_CLEAR_VALUE depthClearValue = {};
+		depthClearValue.Format = DepthStencilFormat;
+		depthClearValue.DepthStencil.Depth = 1.0f;
+		depthClearValue.DepthStencil.Stencil = 0;
+
+		_depthStencilResource = _renderGraphExecutor.createTransientResource(_renderGraph, "DepthStencil", depthDesc, &depthClearValue);
+	}
+
+	_clearPass = _renderGraph.addPass("Clear");
+	_renderGraph.writeResource(_clearPass, _backBufferResource, RENDER_GRAPH_STATE_RENDER_TARGET);
+	_renderGraph.writeResource(_clearPass, _depthStencilResource, RENDER_GRAPH_STATE_DEPTH_WRITE);
+
+	_depthPrepass = _renderGraph.addPass("DepthPrepass");
+	_renderGraph.writeResource(_depthPrepass, _depthStencilResource, RENDER_GRAPH_STATE_DEPTH_WRITE);
+
+	_mainPass = _renderGraph.addPass("MainPass");
+	_renderGraph.writeResource(_mainPass, _backBufferResource, RENDER_GRAPH_STATE_RENDER_TARGET);
+	_renderGraph.writeResource(_mainPass, _depthStencilResource, RENDER_GRAPH_STATE_DEPTH_WRITE);
+
+	_overlayPass = _renderGraph.addPass("Overlay", true);
+	_renderGraph.writeResource(_overlayPass, _backBufferResource, RENDER_GRAPH_STATE_RENDER_TARGET);
+	_renderGraph.writeResource(_overlayPass, _depthStencilResource, RENDER_GRAPH_STATE_DEPTH_WRITE);
+
+	_renderGraph.compile();
+	_renderGraphExecutor.realize(_renderGraph);
+
+	//配置リソースはrealizeのたびに作り直されるので、ビューも作り直す
+	if (_dsv.isEnable()) {
+		_descriptorHeapManager.discardDepthStencilView(_dsv);
+	}
+
+	ID3D12Resource* depthStencil = _renderGraphExecutor.getResource(_depthStencilResource);
+	_descriptorHeapManager.createDepthStencilView(&depthStencil, &_dsv, 1);
+}
+
+void GraphicsCore::setupPassCommonState(RefPtr<ID3D12GraphicsCommandList> commandList, bool isDepthPass) {
+	RefPtr<ID3D12DescriptorHeap> ppHeap[] = { _descriptorHeapManager.getD3dDescriptorHeap() };
+
+	//デスクリプタヒープをセット
+	commandList->SetDescriptorHeaps(1, ppHeap);
+
+	//ビューポート設定
+	commandList->RSSetViewports(1, &_viewPort);
+	commandList->RSSetScissorRects(1, &_scissorRect);
+
+	//デプスパスはデプスバッファのみ、メインパスはレンダーターゲットとデプスバッファをバインド
+	if (isDepthPass) {
+		commandList->OMSetRenderTargets(0, nullptr, FALSE, &_dsv.cpuHandle);
+	}
+	else {
+		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = _currentFrameResource->_rtv.cpuHandle;
+		commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &_dsv.cpuHandle);
+	}
+}
+
+uint32 GraphicsCore::computeRecordJobCount(uint32 meshCount) const {
+	const uint32 jobCountByMesh = (meshCount + MinMeshCountPerRecordJob - 1) / MinMeshCountPerRecordJob;
+	return max(min(jobCountByMesh, _maxRecordJobCount), 1u);
+}
+
+void FramePacingStatistics::addFrame(float cpuFrameTime, float fenceWaitTime, uint32 framesInFlight) {
+	cpuFrameTimes[historyOffset] = cpuFrameTime;
+	fenceWaitTimes[historyOffset] = fenceWaitTime;
+	framesInFlights[historyOffset] = static_cast<float>(framesInFlight);
+	historyOffset = (historyOffset + 1) % HistoryCount;
+}
+
+void FramePacingStatistics::addRecordTime(float recordTime, uint32 recordJobCount) {
+	recordTimes[historyOffset] = recordTime;
+	lastRecordJobCount = recordJobCount;
+}
+
+void FramePacingStatistics::drawImgui() const {
+	const uint32 latestIndex = (historyOffset + HistoryCount - 1) % HistoryCount;
+	const float cpuFrameTime = cpuFrameTimes[latestIndex];
+	const float fenceWaitTime = fenceWaitTimes[latestIndex];
+
+	//フェンス待機以外の時間をCPUとGPUが並行して動いていた時間とみなす
+	const float overlapRate = cpuFrameTime > 0.0f ? 1.0f - fenceWaitTime / cpuFrameTime : 0.0f;
+
+	ImGui::Text("CPU Frame   : %.3f ms", cpuFrameTime);
+	ImGui::Text("Fence Wait  : %.3f ms", fenceWaitTime);
+	ImGui::Text("In Flight   : %.0f frames", framesInFlights[latestIndex]);
+	ImGui::Text("CPU/GPU Overlap : %.1f %%", overlapRate * 100.0f);
+	ImGui::Text("Record      : %.3f ms (%d jobs)", recordTimes[latestIndex], static_cast<int>(lastRecordJobCount));
+	ImGui::PlotLines("CPU Frame", cpuFrameTimes, HistoryCount, historyOffset, nullptr, 0.0f, 33.3f, ImVec2(0, 40));
+	ImGui::PlotLines("Fence Wait", fenceWaitTimes, HistoryCount, historyOffset, nullptr, 0.0f, 33.3f, ImVec2(0, 40));
+	ImGui::PlotLines("Record", recordTimes, HistoryCount, historyOffset, nullptr, 0.0f, 16.6f, ImVec2(0, 40));
+	ImGui::PlotHistogram("In Flight", framesInFlights, HistoryCount, historyOffset, nullptr, 0.0f, static_cast<float>(FrameCount), ImVec2(0, 40));
 }
@@ -20,7 +20,7 @@ void ImguiWindow::init(HWND& hwnd, ID3D12Device* device) {
 	ImGui::StyleColorsDark();
 
 	DescriptorHeapManager& manager = DescriptorHeapManager::instance();
-	manager.getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->allocateBufferView(&_imguiView,1);
+	manager.allocateShaderVisibleView(&_imguiView, 1);
 
 	// Setup Platform/Renderer bindings
 	ImGui_ImplWin32_Init(hwnd);
@@ -43,7 +43,7 @@ void ImguiWindow::renderFrame(ID3D12GraphicsCommandList * commandList) {
 
 void ImguiWindow::shutdown() {
 	DescriptorHeapManager& manager = DescriptorHeapManager::instance();
-	manager.getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->discardBufferView(_imguiView);
+	manager.discardShaderVisibleView(_imguiView);
 
 	ImGui_ImplDX12_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -0,0 +1,226 @@
+#include "IoLoadBenchmark.h"
+#include <algorithm>
+#include <random>
+
+//要求1つの大きさ。ストリーミングの1ミップ分から数ミップ分程度を順に使う
+constexpr uint64 IoLoadRangeSizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024 };
+
+static float getElapsedSeconds(const LARGE_INTEGER& startTime, const LARGE_INTEGER& frequency) {
+	LARGE_INTEGER endTime;
+	QueryPerformanceCounter(&endTime);
+	return (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+}
+
+//内容の照合に使うFNV-1a。空の範囲と読めなかった範囲を区別できるよう0にはしない
+static uint64 computeHash(const byte* data, uint64 size) {
+	uint64 hash = 14695981039346656037ull;
+	for (uint64 i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash != 0 ? hash : 1;
+}
+
+static bool isDdsFile(const String& fileName) {
+	String lowerName = fileName;
+	std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+
+	return lowerName.size() >= 4 && lowerName.compare(lowerName.size() - 4, 4, ".dds") == 0;
+}
+
+IoLoadBenchmarkResult IoLoadBenchmark::run(const String& directory) {
+	IoLoadBenchmarkResult result;
+
+	VectorArray<String> filePaths;
+	collectFiles(directory, filePaths);
+
+	VectorArray<ReadRange> ranges;
+	buildRanges(filePaths, ranges);
+
+	result.fileCount = static_cast<uint32>(filePaths.size());
+	result.requestCount = static_cast<uint32>(ranges.size());
+	if (ranges.empty()) {
+		return result;
+	}
+
+	for (const auto& range : ranges) {
+		result.totalSize += range.size;
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER startTime;
+	QueryPerformanceFrequency(&frequency);
+
+	//1回読んでキャッシュに載せてから計測する
+	VectorArray<uint64> expectedHashes;
+	if (!readSequential(filePaths, ranges, expectedHashes)) {
+		return result;
+	}
+
+	QueryPerformanceCounter(&startTime);
+	readSequential(filePaths, ranges, expectedHashes);
+	result.sequentialSeconds = getElapsedSeconds(startTime, frequency);
+
+	IoService& ioService = IoService::instance();
+	const IoServiceStatistics startStatistics = ioService.getStatistics();
+
+	VectorArray<uint64> hashes;
+	VectorArray<float> latencies;
+	QueryPerformanceCounter(&startTime);
+	readIoService(filePaths, ranges, hashes, latencies);
+	result.ioServiceSeconds = getElapsedSeconds(startTime, frequency);
+
+	const IoServiceStatistics endStatistics = ioService.getStatistics();
+	result.readCount = endStatistics.readCount - startStatistics.readCount;
+	result.coalescedRequestCount = endStatistics.coalescedRequestCount - startStatistics.coalescedRequestCount;
+	result.isValid = hashes == expectedHashes;
+
+	//優先度ごとに待ち時間を並べて分位点を取る
+	for (uint32 priority = 0; priority < IO_PRIORITY_COUNT; ++priority) {
+		VectorArray<float> priorityLatencies;
+		for (uint32 i = 0; i < ranges.size(); ++i) {
+			if (ranges[i].priority == priority) {
+				priorityLatencies.push_back(latencies[i]);
+			}
+		}
+
+		IoLoadPriorityResult& priorityResult = result.priorities[priority];
+		priorityResult.requestCount = static_cast<uint32>(priorityLatencies.size());
+		if (priorityLatencies.empty()) {
+			continue;
+		}
+
+		std::sort(priorityLatencies.begin(), priorityLatencies.end());
+		float totalLatency = 0.0f;
+		for (float latency : priorityLatencies) {
+			totalLatency += latency;
+		}
+
+		const size_t lastIndex = priorityLatencies.size() - 1;
+		priorityResult.averageMilliseconds = totalLatency / priorityLatencies.size();
+		priorityResult.p50Milliseconds = priorityLatencies[lastIndex / 2];
+		priorityResult.p95Milliseconds = priorityLatencies[lastIndex * 95 / 100];
+		priorityResult.maxMilliseconds = priorityLatencies[lastIndex];
+	}
+
+	return result;
+}
+
+void IoLoadBenchmark::collectFiles(const String& directory, VectorArray<String>& outFilePaths) {
+	WIN32_FIND_DATAA findData = {};
+	HANDLE findHandle = FindFirstFileA((directory + "*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	do {
+		const String fileName = findData.cFileName;
+		if (fileName == "." || fileName == "..") {
+			continue;
+		}
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			collectFiles(directory + fileName + "/", outFilePaths);
+		}
+		else if (isDdsFile(fileName)) {
+			outFilePaths.push_back(directory + fileName);
+		}
+	} while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+}
+
+void IoLoadBenchmark::buildRanges(const VectorArray<String>& filePaths, VectorArray<ReadRange>& outRanges) {
+	uint32 rangeIndex = 0;
+	for (uint32 fileIndex = 0; fileIndex < filePaths.size(); ++fileIndex) {
+		WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+		if (!GetFileAttributesExA(filePaths[fileIndex].c_str(), GetFileExInfoStandard, &attributes)) {
+			continue;
+		}
+
+		const uint64 fileSize = (static_cast<uint64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		uint64 offset = 0;
+		while (offset < fileSize) {
+			const uint64 rangeSize = IoLoadRangeSizes[rangeIndex % _countof(IoLoadRangeSizes)];
+
+			//1割を高い優先度、3割を通常、6割を低い優先度にする
+			const uint32 priorityIndex = rangeIndex % 10;
+			const IoPriority priority = priorityIndex == 0 ? IO_PRIORITY_HIGH : priorityIndex <= 3 ? IO_PRIORITY_NORMAL : IO_PRIORITY_LOW;
+
+			ReadRange range;
+			range.fileIndex = fileIndex;
+			range.offset = offset;
+			range.size = min(rangeSize, fileSize - offset);
+			range.priority = priority;
+			outRanges.push_back(range);
+
+			offset += range.size;
+			++rangeIndex;
+		}
+	}
+
+	//毎回同じ順にするため種は固定する。ファイルの順に出すとまとめる余地が大きすぎて実際のロードに近くない
+	std::mt19937 random(0);
+	std::shuffle(outRanges.begin(), outRanges.end(), random);
+}
+
+bool IoLoadBenchmark::readSequential(const VectorArray<String>& filePaths, const VectorArray<ReadRange>& ranges, VectorArray<uint64>& outHashes) {
+	//ファイルは先に開いておき、開く時間は計測に含めない
+	VectorArray<HANDLE> files(filePaths.size(), INVALID_HANDLE_VALUE);
+	bool isSucceeded = true;
+	for (uint32 i = 0; i < filePaths.size(); ++i) {
+		files[i] = CreateFileA(filePaths[i].c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		isSucceeded &= files[i] != INVALID_HANDLE_VALUE;
+	}
+
+	VectorArray<byte> buffer(IoLoadRangeSizes[_countof(IoLoadRangeSizes) - 1]);
+	outHashes.assign(ranges.size(), 0);
+	for (uint32 i = 0; i < ranges.size() && isSucceeded; ++i) {
+		const ReadRange& range = ranges[i];
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(range.offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(range.offset >> 32);
+
+		DWORD readSize = 0;
+		if (ReadFile(files[range.fileIndex], buffer.data(), static_cast<DWORD>(range.size), &readSize, &overlapped) && readSize == range.size) {
+			outHashes[i] = computeHash(buffer.data(), readSize);
+		}
+	}
+
+	for (HANDLE file : files) {
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+	}
+
+	return isSucceeded;
+}
+
+void IoLoadBenchmark::readIoService(const VectorArray<String>& filePaths, const VectorArray<ReadRange>& ranges, VectorArray<uint64>& outHashes, VectorArray<float>& outLatencies) {
+	outHashes.assign(ranges.size(), 0);
+	outLatencies.assign(ranges.size(), 0.0f);
+
+	//コールバックは要求ごとに別の要素に書くので、ロックは要らない
+	IoService& ioService = IoService::instance();
+	IoRequestGroup group;
+	for (uint32 i = 0; i < ranges.size(); ++i) {
+		const ReadRange& range = ranges[i];
+		IoReadRequest request;
+		request.filePath = filePaths[range.fileIndex];
+		request.offset = range.offset;
+		request.size = range.size;
+		request.priority = range.priority;
+		request.callback = [&outHashes, &outLatencies, i](IoReadResult& result) {
+			if (result.isSucceeded()) {
+				outHashes[i] = computeHash(result.buffer.data(), result.buffer.size());
+			}
+
+			outLatencies[i] = static_cast<float>(result.latencyMilliseconds);
+		};
+
+		ioService.read(request, &group);
+	}
+
+	group.wait();
+}
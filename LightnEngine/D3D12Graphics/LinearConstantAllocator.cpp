@@ -0,0 +1,43 @@
+#include "LinearConstantAllocator.h"
+#include "D3D12Helper.h"
+
+LinearConstantAllocator::LinearConstantAllocator() :
+	_sizePerFrame(0), _frameStart(0), _offset(0), _peakUsedSize(0) {
+}
+
+void LinearConstantAllocator::create(RefPtr<ID3D12Device> device, uint32 sizePerFrame) {
+	_sizePerFrame = (sizePerFrame + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+	_buffer.createDirectEmpty(device, _sizePerFrame * FrameCount);
+	_frameStart = 0;
+	_offset = 0;
+	_peakUsedSize = 0;
+}
+
+void LinearConstantAllocator::shutdown() {
+	_buffer.destroy();
+}
+
+void LinearConstantAllocator::beginFrame(uint32 frameIndex) {
+	//前に使った領域の使用量を記録してから切り替える
+	_peakUsedSize = max(_peakUsedSize, getUsedSize());
+	_frameStart = _sizePerFrame * frameIndex;
+	_offset = 0;
+}
+
+TransientConstant LinearConstantAllocator::allocate(uint32 size) {
+	const uint32 alignedSize = (size + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+	const uint32 offset = _offset.fetch_add(alignedSize);
+
+	//超えた領域を返すと次のフレームの領域やバッファの外に書き込んでしまうので、リリースビルドでも例外で止める
+	//オフセットは戻さないので、同じフレームでそれ以降に確保しようとしたスレッドもすべて失敗する
+	if (static_cast<uint64>(offset) + alignedSize > _sizePerFrame) {
+		assert(false && "1フレームで使用できる定数バッファの容量を超えました");
+		throwIfFailed(E_OUTOFMEMORY);
+	}
+
+	const uint32 bufferOffset = _frameStart + offset;
+	TransientConstant constant;
+	constant.cpuAddress = reinterpret_cast<byte*>(_buffer._dataPtr) + bufferOffset;
+	constant.gpuAddress = _buffer.getGpuVirtualAddress() + bufferOffset;
+	return constant;
+}
@@ -0,0 +1,148 @@
+#include "MeshLoadBenchmark.h"
+#include <MappedFile.h>
+#include <MeshFile.h>
+#include <MeshIndexCodec.h>
+#include <fstream>
+
+MeshLoadBenchmarkResult MeshLoadBenchmark::run(const String& directory) {
+	MeshLoadBenchmarkResult result;
+
+	//解析できるメッシュファイルだけを集める
+	VectorArray<String> filePaths;
+	WIN32_FIND_DATAA findData = {};
+	HANDLE findHandle = FindFirstFileA((directory + "*.mesh").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE) {
+		return result;
+	}
+
+	do {
+		const String filePath = directory + findData.cFileName;
+		MappedFile file;
+		MeshFileReader reader;
+		if (file.open(filePath.c_str()) && reader.open(file.data(), file.size())) {
+			filePaths.push_back(filePath);
+			result.totalSize += file.size();
+			result.meshCount += reader.getMeshCount();
+			result.v1FileCount += reader.getVersion() == 1 ? 1 : 0;
+		}
+	} while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+
+	VectorArray<byte> fileData;
+	VectorArray<byte> uploadData;
+	for (const auto& filePath : filePaths) {
+		loadWithRead(filePath, fileData, uploadData);
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER startTime;
+	LARGE_INTEGER endTime;
+	QueryPerformanceFrequency(&frequency);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& filePath : filePaths) {
+		result.fileCount += loadWithRead(filePath, fileData, uploadData) ? 1 : 0;
+	}
+	QueryPerformanceCounter(&endTime);
+	result.readSeconds = (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& filePath : filePaths) {
+		loadWithMapping(filePath, uploadData);
+	}
+	QueryPerformanceCounter(&endTime);
+	result.mappedSeconds = (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+
+	QueryPerformanceCounter(&startTime);
+	for (const auto& filePath : filePaths) {
+		verifyWithMapping(filePath);
+	}
+	QueryPerformanceCounter(&endTime);
+	result.verifySeconds = (endTime.QuadPart - startTime.QuadPart) / static_cast<float>(frequency.QuadPart);
+
+	return result;
+}
+
+//インデックスをdstに書き出す。符号化されていればここで戻す
+static bool copyIndices(const MeshFileMesh& mesh, byte* dst) {
+	if (mesh.encodedIndices != nullptr) {
+		return MeshIndexCodec::decode(mesh.encodedIndices, mesh.encodedIndexSize, dst);
+	}
+
+	memcpy(dst, mesh.indices, static_cast<size_t>(mesh.indexCount) * mesh.indexStride);
+	return true;
+}
+
+bool MeshLoadBenchmark::loadWithRead(const String& filePath, VectorArray<byte>& fileData, VectorArray<byte>& uploadData) {
+	std::ifstream file(filePath.c_str(), std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	const uint64 fileSize = static_cast<uint64>(file.tellg());
+	fileData.resize(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(fileData.data()), static_cast<std::streamsize>(fileSize));
+
+	MeshFileReader reader;
+	if (!reader.open(fileData.data(), fileSize)) {
+		return false;
+	}
+
+	uint64 uploadOffset = 0;
+	uploadData.resize(static_cast<size_t>(reader.getPayloadSize()));
+	for (uint32 i = 0; i < reader.getMeshCount(); ++i) {
+		const MeshFileMesh& mesh = reader.getMesh(i);
+		const uint64 verticesSize = static_cast<uint64>(mesh.vertexStride) * mesh.vertexCount;
+
+		//従来のローダーと同じく、いったん頂点とインデックスの配列に取り出す
+		const uint64 indicesSize = static_cast<uint64>(mesh.indexCount) * mesh.indexStride;
+		VectorArray<byte> vertices(mesh.vertices, mesh.vertices + verticesSize);
+		VectorArray<byte> indices(static_cast<size_t>(indicesSize));
+		if (!copyIndices(mesh, indices.data())) {
+			return false;
+		}
+
+		memcpy(uploadData.data() + uploadOffset, vertices.data(), static_cast<size_t>(verticesSize));
+		uploadOffset += verticesSize;
+		memcpy(uploadData.data() + uploadOffset, indices.data(), static_cast<size_t>(indicesSize));
+		uploadOffset += indicesSize;
+	}
+
+	return true;
+}
+
+bool MeshLoadBenchmark::loadWithMapping(const String& filePath, VectorArray<byte>& uploadData) {
+	MappedFile file;
+	MeshFileReader reader;
+	if (!file.open(filePath.c_str()) || !reader.open(file.data(), file.size())) {
+		return false;
+	}
+
+	uint64 uploadOffset = 0;
+	uploadData.resize(static_cast<size_t>(reader.getPayloadSize()));
+	for (uint32 i = 0; i < reader.getMeshCount(); ++i) {
+		const MeshFileMesh& mesh = reader.getMesh(i);
+		const uint64 verticesSize = static_cast<uint64>(mesh.vertexStride) * mesh.vertexCount;
+		const uint64 indicesSize = static_cast<uint64>(mesh.indexCount) * mesh.indexStride;
+
+		memcpy(uploadData.data() + uploadOffset, mesh.vertices, static_cast<size_t>(verticesSize));
+		uploadOffset += verticesSize;
+		if (!copyIndices(mesh, uploadData.data() + uploadOffset)) {
+			return false;
+		}
+		uploadOffset += indicesSize;
+	}
+
+	return true;
+}
+
+bool MeshLoadBenchmark::verifyWithMapping(const String& filePath) {
+	MappedFile file;
+	MeshFileReader reader;
+	if (!file.open(filePath.c_str()) || !reader.open(file.data(), file.size())) {
+		return false;
+	}
+
+	return reader.verifyHashes();
+}
@@ -2,8 +2,46 @@
 #include "DebugGeometry.h"
 #include "DescriptorHeap.h"
 #include "GpuResourceManager.h"
+#include "LinearConstantAllocator.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+
+//メッシュの頂点フォーマットごとの入力レイアウト。頂点はスロット0に置く
+static VectorArray<D3D12_INPUT_ELEMENT_DESC> getMeshInputLayouts(MeshVertexFormat vertexFormat) {
+	if (vertexFormat == MESH_VERTEX_FORMAT_COMPACT) {
+		return {
+			{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0,                            0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "NORMAL",   0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		};
+	}
+
+	return {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,                            0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+}
+
+//圧縮フォーマットの頂点シェーダーはVERTEX_FORMAT_COMPACTを定義してコンパイルする
+static const D3D_SHADER_MACRO* getMeshShaderDefines(MeshVertexFormat vertexFormat) {
+	static const D3D_SHADER_MACRO compactDefines[] = { { "VERTEX_FORMAT_COMPACT", "1" }, { nullptr, nullptr } };
+	return vertexFormat == MESH_VERTEX_FORMAT_COMPACT ? compactDefines : nullptr;
+}
+
+//同じシェーダーでも頂点フォーマットが違えば別のパイプラインステートとして登録する
+static String getVertexFormatSuffix(MeshVertexFormat vertexFormat) {
+	return vertexFormat == MESH_VERTEX_FORMAT_COMPACT ? String("_Compact") : String();
+}
+
+//StaticSingleMeshのドローごとの定数。シェーダーのcbuffer WorldMatrixと同じ並び
+struct SingleMeshConstant {
+	Matrix4 mtxWorld;
+	VertexDequantization dequantization;
+};
 
-void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshName, const ConstantBufferFrame& cameraBuffer, const VectorArray<InitSettingsPerSingleMesh>& materialInfos) {
+void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshName, const VectorArray<InitSettingsPerSingleMesh>& materialInfos) {
 	DescriptorHeapManager& descriptorManager = DescriptorHeapManager::instance();
 	GpuResourceManager& resourceManager = GpuResourceManager::instance();
 
@@ -11,21 +49,18 @@ void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshNam
 	_mainMaterials.resize(_mesh->materialDrawRanges.size());
 	_depthMaterials.resize(_mainMaterials.size());
 
+	//入力レイアウトはメッシュの頂点フォーマットで決まる
+	const MeshVertexFormat vertexFormat = _mesh->vertexFormat;
+	const VectorArray<D3D12_INPUT_ELEMENT_DESC> inputLayouts = getMeshInputLayouts(vertexFormat);
+
 	for (size_t i = 0; i < _mainMaterials.size(); ++i) {
 		const InitSettingsPerSingleMesh& initInfo = materialInfos[i];
-		const String shaderNameSet = initInfo.getShaderNameSet();
+		const String shaderNameSet = initInfo.getShaderNameSet() + getVertexFormatSuffix(vertexFormat);
 		MaterialCommandGraphics& material = _mainMaterials[i];
 
-		VectorArray<D3D12_INPUT_ELEMENT_DESC> inputLayouts = {
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,                            0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		};
-
 		VertexShader vs;
 		PixelShader ps;
-		vs.create(initInfo.vertexShaderName, inputLayouts);
+		vs.create(initInfo.vertexShaderName, inputLayouts, 0, getMeshShaderDefines(vertexFormat));
 		ps.create(initInfo.pixelShaderName);
 
 		D3D12_DESCRIPTOR_RANGE1 srvRange = {};
@@ -41,10 +76,11 @@ void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshNam
 		mainParameterDescs[0].Descriptor.ShaderRegister = 0;
 		mainParameterDescs[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
 
-		mainParameterDescs[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		//ワールド行列と頂点の復元定数はドローごとにリニアアロケーターから確保するのでルートCBVで渡す
+		mainParameterDescs[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		mainParameterDescs[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
-		mainParameterDescs[1].Constants.Num32BitValues = 16;
-		mainParameterDescs[1].Constants.ShaderRegister = 1;
+		mainParameterDescs[1].Descriptor.ShaderRegister = 1;
+		mainParameterDescs[1].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
 
 		mainParameterDescs[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 		mainParameterDescs[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
@@ -53,7 +89,7 @@ void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshNam
 
 		D3D12_STATIC_SAMPLER_DESC samplerDesc = WrapSamplerDesc();
 
-		//MainPassppCvCXe[g[gVOl`
+		//MainPass用パイプラインステート＆ルートシグネチャ
 		{
 			RefPtr<RootSignature> rootSignature;
 			RefPtr<PipelineState> pipelineState;
@@ -68,31 +104,22 @@ void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshNam
 			material._pipelineState = pipelineState->getRefPipelineState(); 
 		}
 
-		GpuResourcePerFrameSet cameraSet;
+		FrameConstantSet cameraSet;
 		cameraSet.rootParameterIndex = 0;
-		cameraSet.resourceAddress[0] = cameraBuffer.constantBuffers[0].getGpuVirtualAddress();
-		cameraSet.resourceAddress[1] = cameraBuffer.constantBuffers[1].getGpuVirtualAddress();
-		cameraSet.resourceAddress[2] = cameraBuffer.constantBuffers[2].getGpuVirtualAddress();
-		cameraSet.type = ResourceType::CONSTANT_BUFFER;
-		material._gpuResourcePerFrames.emplace_back(cameraSet);
+		cameraSet.type = FRAME_CONSTANT_CAMERA;
+		material._frameConstants.emplace_back(cameraSet);
 
 		material._descriptors.emplace_back(2, resourceManager.createTextureBufferView(shaderNameSet, initInfo.textureNames)->getRefBufferView());
-
-		RootConstantSet rootConstantSet;
-		rootConstantSet.rootParameterIndex = 1;
-		rootConstantSet.dataPtr.resize(sizeof(Matrix4));
-
-		material._rootConstants.emplace_back(rootConstantSet);
 		material._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
-		//ȉDepthPrePassp}eA
+		//以下DepthPrePass用マテリアル
 		const String depthShaderNameSet = shaderNameSet + String("_DepthPass");
 		MaterialCommandGraphics& depthMaterial = _depthMaterials[i];
 		VectorArray<D3D12_ROOT_PARAMETER1> depthParameterDescs(2);
 		depthParameterDescs[0] = mainParameterDescs[0];
 		depthParameterDescs[1] = mainParameterDescs[1];
 
-		//DepthppCvCXe[g[gVOl`
+		//Depth用パイプラインステート＆ルートシグネチャ
 		{
 			RefPtr<RootSignature> rootSignature;
 			RefPtr<PipelineState> pipelineState;
@@ -104,16 +131,19 @@ void StaticSingleMesh::create(RefPtr<ID3D12Device> device, const String& meshNam
 			depthMaterial._pipelineState = pipelineState->getRefPipelineState();
 		}
 
-		depthMaterial._gpuResourcePerFrames.emplace_back(cameraSet);
-		depthMaterial._rootConstants.emplace_back(rootConstantSet);
+		depthMaterial._frameConstants.emplace_back(cameraSet);
 		depthMaterial._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	}
 }
 
 void StaticSingleMesh::setupDepthPassCommand(RenderSettings& settings){
+	//ワールド行列は全マテリアルで共通なのでメッシュごとに1回だけ確保する
+	const D3D12_GPU_VIRTUAL_ADDRESS worldMatrixAddress = settings.constantAllocator->push(SingleMeshConstant{ _worldMatrix, _mesh->dequantization });
+
 	for (size_t i = 0; i < _mesh->materialDrawRanges.size(); ++i) {
 		RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
 		_depthMaterials[i].setupCommand(settings);
+		commandList->SetGraphicsRootConstantBufferView(1, worldMatrixAddress);
 
 		commandList->IASetVertexBuffers(0, 1, &_mesh->vertexBuffer._vertexBufferView);
 		commandList->IASetIndexBuffer(&_mesh->indexBuffer._indexBufferView);
@@ -122,9 +152,12 @@ void StaticSingleMesh::setupDepthPassCommand(RenderSettings& settings){
 }
 
 void StaticSingleMesh::setupMainPassCommand(RenderSettings& settings) {
+	const D3D12_GPU_VIRTUAL_ADDRESS worldMatrixAddress = settings.constantAllocator->push(SingleMeshConstant{ _worldMatrix, _mesh->dequantization });
+
 	for (size_t i = 0; i < _mesh->materialDrawRanges.size(); ++i) {
 		RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
 		_mainMaterials[i].setupCommand(settings);
+		commandList->SetGraphicsRootConstantBufferView(1, worldMatrixAddress);
 
 		commandList->IASetVertexBuffers(0, 1, &_mesh->vertexBuffer._vertexBufferView);
 		commandList->IASetIndexBuffer(&_mesh->indexBuffer._indexBufferView);
@@ -133,13 +166,10 @@ void StaticSingleMesh::setupMainPassCommand(RenderSettings& settings) {
 }
 
 void StaticSingleMesh::updateWorldMatrix(const Matrix4& worldMatrix) {
-	for (size_t i = 0; i < _mesh->materialDrawRanges.size(); ++i) {
-		memcpy(_mainMaterials[i]._rootConstants[0].dataPtr.data(), &worldMatrix, sizeof(worldMatrix));
-		memcpy(_depthMaterials[i]._rootConstants[0].dataPtr.data(), &worldMatrix, sizeof(worldMatrix));
-	}
+	_worldMatrix = worldMatrix;
 }
 
-void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const InitBufferInfo& bufferInfo, const InitSettingsPerStaticMultiMesh& initInfo) {
+void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const InitSettingsPerStaticMultiMesh& initInfo) {
 	DescriptorHeapManager& descriptorHeapManager = DescriptorHeapManager::instance();
 	GpuResourceManager& gpuResourceManager = GpuResourceManager::instance();
 
@@ -148,8 +178,15 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 	const auto& textureNames = initInfo.textureNames;
 	const uint32 textureCount = static_cast<uint32>(textureNames.size());
 
-	RefPtr<BufferView> textureSRV = gpuResourceManager.createTextureBufferView(materialName + String("_Textures"), textureNames);
-	_mainPassCommand._descriptors.emplace_back(3, textureSRV->getRefBufferView());
+	//テクスチャはバインドレステーブルから引くので、シーン内のテクスチャ番号をテーブルのインデックスに置き換える
+	VectorArray<uint32> bindlessTextureIndices(textureCount);
+	VectorArray<RefPtr<Texture2D>> textures(textureCount);
+	for (uint32 i = 0; i < textureCount; ++i) {
+		gpuResourceManager.loadTexture(textureNames[i], &textures[i]);
+		bindlessTextureIndices[i] = textures[i]->getBindlessIndex();
+	}
+
+	_mainPassCommand._descriptors.emplace_back(3, descriptorHeapManager.getBindlessTable()->getRefBufferView());
 
 	String diffuseEnv("cubemapEnvHDR.dds");
 	String specularEnv("cubemapSpecularHDR.dds");
@@ -157,40 +194,36 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 	RefPtr<BufferView> environmentSRV = gpuResourceManager.createTextureBufferView(materialName + String("_EnvTextures"), { diffuseEnv,specularEnv,specularBrdf });
 	_mainPassCommand._descriptors.emplace_back(2, environmentSRV->getRefBufferView());
 
-	GpuResourcePerFrameSet cameraSet;
-	bufferInfo.cameraBuffer.getVirtualAdresses(cameraSet.resourceAddress);
-	cameraSet.rootParameterIndex = 0;
-	cameraSet.type = ResourceType::CONSTANT_BUFFER;
-	_mainPassCommand._gpuResourcePerFrames.emplace_back(cameraSet);
-	_depthPassCommand._gpuResourcePerFrames.emplace_back(cameraSet);
-
-	GpuResourcePerFrameSet directionalLightSet;
-	bufferInfo.directionalLightBuffer.getVirtualAdresses(directionalLightSet.resourceAddress);
-	directionalLightSet.rootParameterIndex = 4;
-	directionalLightSet.type = ResourceType::CONSTANT_BUFFER;
-	_mainPassCommand._gpuResourcePerFrames.emplace_back(directionalLightSet);
-
-	GpuResourcePerFrameSet pointLightSet;
-	bufferInfo.pointLightBuffer.getVirtualAdresses(pointLightSet.resourceAddress);
-	pointLightSet.rootParameterIndex = 5;
-	pointLightSet.type = ResourceType::CONSTANT_BUFFER;
-	_mainPassCommand._gpuResourcePerFrames.emplace_back(pointLightSet);
+	//カメラとライトは毎フレームリニアアロケーターから確保されるので、アドレスは描画時にRenderSettingsから引く
+	_mainPassCommand._frameConstants.push_back({ 0, FRAME_CONSTANT_CAMERA });
+	_mainPassCommand._frameConstants.push_back({ 4, FRAME_CONSTANT_DIRECTIONAL_LIGHT });
+	_mainPassCommand._frameConstants.push_back({ 5, FRAME_CONSTANT_POINT_LIGHT });
+	_mainPassCommand._frameConstants.push_back({ 6, FRAME_CONSTANT_BINDLESS_REMAP, ResourceType::SHADER_RESOURCE });
+	_depthPassCommand._frameConstants.push_back({ 0, FRAME_CONSTANT_CAMERA });
+
+	//頂点フォーマットごとのサブメッシュの数をLODの分まで数え、使われているフォーマットだけパイプラインステートを作る
+	_meshCount = static_cast<uint32>(meshes.size());
+	_indirectArgumentCount = 0;
+	for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+		_indirectArgumentCounts[vertexFormat] = 0;
+	}
+
+	VectorArray<RefPtr<VertexAndIndexBuffer>> meshVertexAndIndices(_meshCount);
+	for (uint32 i = 0; i < _meshCount; ++i) {
+		gpuResourceManager.loadVertexAndIndexBuffer(initInfo.meshNames[i], &meshVertexAndIndices[i]);
+		const uint32 lodCount = static_cast<uint32>(meshVertexAndIndices[i]->lods.size()) + 1;
+		_indirectArgumentCounts[meshVertexAndIndices[i]->vertexFormat] += static_cast<uint32>(meshes[i].textureIndices.size()) * lodCount;
+	}
 
 	{
-		VectorArray<D3D12_INPUT_ELEMENT_DESC> inputLayouts = {
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,                            0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		const VectorArray<D3D12_INPUT_ELEMENT_DESC> instanceInputLayouts = {
 			{ "MATRIX",         0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1,  0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 			{ "MATRIX",         1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 			{ "MATRIX",         2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 			{ "MATRIX",         3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
 		};
 
-		VertexShader vs;
 		PixelShader ps;
-		vs.create("Shaders/Indirect.hlsl", inputLayouts);
 		ps.create("Shaders/Indirect.hlsl", D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES);
 
 		D3D12_DESCRIPTOR_RANGE1 environmentSrvRange = {};
@@ -200,14 +233,17 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		environmentSrvRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC;
 		environmentSrvRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
+		//バインドレステーブル全体を境界なし配列としてspace1に割り当てる。テクスチャ数によらずルートシグネチャは同じになる
+		//他のスロットへの登録はGPUの実行中にも起こるのでデスクリプタは揮発扱いにする
 		D3D12_DESCRIPTOR_RANGE1 textureSrvRange = {};
-		textureSrvRange.BaseShaderRegister = 3;
-		textureSrvRange.NumDescriptors = textureCount;
+		textureSrvRange.BaseShaderRegister = 0;
+		textureSrvRange.RegisterSpace = 1;
+		textureSrvRange.NumDescriptors = UINT_MAX;
 		textureSrvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-		textureSrvRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC;
+		textureSrvRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
 		textureSrvRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-		VectorArray<D3D12_ROOT_PARAMETER1> parameterDescs(6);
+		VectorArray<D3D12_ROOT_PARAMETER1> parameterDescs(7);
 		parameterDescs[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		parameterDescs[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 		parameterDescs[0].Descriptor.ShaderRegister = 0;
@@ -215,7 +251,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 
 		parameterDescs[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 		parameterDescs[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
-		parameterDescs[1].Constants.Num32BitValues = 4;
+		parameterDescs[1].Constants.Num32BitValues = INDIRECT_DRAW_CONSTANT_COUNT;
 		parameterDescs[1].Constants.ShaderRegister = 1;
 
 		parameterDescs[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -238,48 +274,90 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		parameterDescs[5].Descriptor.ShaderRegister = 1;
 		parameterDescs[5].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
 
-		D3D12_STATIC_SAMPLER_DESC samplerDesc = WrapSamplerDesc();
-
-		//fvXpX
-		{
-			VectorArray<D3D12_ROOT_PARAMETER1> depthParameterDescs(2);
-			depthParameterDescs[0] = parameterDescs[0];
-			depthParameterDescs[1] = parameterDescs[1];
-
-			DefaultPipelineStateDescSet psoDescSet;
-			RefPtr<RootSignature> rootSignature = gpuResourceManager.createRootSignature(device, materialName + "_DepthPass", depthParameterDescs, nullptr);
-			RefPtr<PipelineState> pipelineState = gpuResourceManager.createPipelineState(device, materialName + "_DepthPass", rootSignature, &vs, nullptr, psoDescSet);
+		//テクスチャストリーミングで差し替わったスロットへの変換表。毎フレームリニアアロケーターから確保する
+		parameterDescs[6].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		parameterDescs[6].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+		parameterDescs[6].Descriptor.ShaderRegister = 3;
+		parameterDescs[6].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
 
-			_depthPassCommand._rootSignature = rootSignature->getRefRootSignature();
-			_depthPassCommand._pipelineState = pipelineState->getRefPipelineState();
-			_depthPassCommand._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		}
+		D3D12_STATIC_SAMPLER_DESC samplerDesc = WrapSamplerDesc();
 
-		//CpX
-		{
-			DefaultPipelineStateDescSet psoDescSet;
-			psoDescSet.dsDesc.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
-			RefPtr<RootSignature> rootSignature = gpuResourceManager.createRootSignature(device, materialName + "_MainPass", parameterDescs, &samplerDesc);
-			RefPtr<PipelineState> pipelineState = gpuResourceManager.createPipelineState(device, materialName + "_MainPass", rootSignature, &vs, &ps, psoDescSet);
-
-			_mainPassCommand._rootSignature = rootSignature->getRefRootSignature();
-			_mainPassCommand._pipelineState = pipelineState->getRefPipelineState(); 
-			_mainPassCommand._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		//ルートシグネチャは頂点フォーマットによらず共通
+		VectorArray<D3D12_ROOT_PARAMETER1> depthParameterDescs(2);
+		depthParameterDescs[0] = parameterDescs[0];
+		depthParameterDescs[1] = parameterDescs[1];
+
+		RefPtr<RootSignature> depthRootSignature = gpuResourceManager.createRootSignature(device, materialName + "_DepthPass", depthParameterDescs, nullptr);
+		RefPtr<RootSignature> mainRootSignature = gpuResourceManager.createRootSignature(device, materialName + "_MainPass", parameterDescs, &samplerDesc);
+		_depthPassCommand._rootSignature = depthRootSignature->getRefRootSignature();
+		_depthPassCommand._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		_mainPassCommand._rootSignature = mainRootSignature->getRefRootSignature();
+		_mainPassCommand._topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+		for (uint32 formatIndex = 0; formatIndex < MESH_VERTEX_FORMAT_COUNT; ++formatIndex) {
+			if (_indirectArgumentCounts[formatIndex] == 0) {
+				continue;
+			}
+
+			const MeshVertexFormat vertexFormat = static_cast<MeshVertexFormat>(formatIndex);
+			const String formatSuffix = getVertexFormatSuffix(vertexFormat);
+			VectorArray<D3D12_INPUT_ELEMENT_DESC> inputLayouts = getMeshInputLayouts(vertexFormat);
+			inputLayouts.insert(inputLayouts.end(), instanceInputLayouts.begin(), instanceInputLayouts.end());
+
+			VertexShader vs;
+			vs.create("Shaders/Indirect.hlsl", inputLayouts, 0, getMeshShaderDefines(vertexFormat));
+
+			//デプスパス
+			{
+				DefaultPipelineStateDescSet psoDescSet;
+				RefPtr<PipelineState> pipelineState = gpuResourceManager.createPipelineState(device, materialName + "_DepthPass" + formatSuffix, depthRootSignature, &vs, nullptr, psoDescSet);
+				_depthPassPipelineStates[formatIndex] = pipelineState->getRefPipelineState();
+			}
+
+			//メインパス
+			{
+				DefaultPipelineStateDescSet psoDescSet;
+				psoDescSet.dsDesc.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
+				RefPtr<PipelineState> pipelineState = gpuResourceManager.createPipelineState(device, materialName + "_MainPass" + formatSuffix, mainRootSignature, &vs, &ps, psoDescSet);
+				_mainPassPipelineStates[formatIndex] = pipelineState->getRefPipelineState();
+			}
+
+			//setupCommandで設定するのは最初のフォーマットのもの。ExecuteIndirectの前にフォーマットごとに設定し直す
+			if (_depthPassCommand._pipelineState.pipelineState == nullptr) {
+				_depthPassCommand._pipelineState = _depthPassPipelineStates[formatIndex];
+				_mainPassCommand._pipelineState = _mainPassPipelineStates[formatIndex];
+			}
 		}
 
-		//`挳񂩂GPUJOIndirect`ɕKvȏ܂Ƃ߂
-		_meshCount = static_cast<uint32>(meshes.size());
-		_uavCounterOffsets.resize(_meshCount);
+		//描画元情報からGPUカリングとIndirect描画に必要な情報をまとめる
+		//どのインスタンスもどのLODに入りうるので、LODごとのカリング結果のバッファはすべてのインスタンス分の大きさにする
+		_lodSlotOffsets.resize(_meshCount);
+		_uavCounterOffsets.clear();
+		_cullingSlotCount = 0;
 
 		for (uint32 i = 0; i < _meshCount; ++i) {
-			_indirectArgumentCount += static_cast<uint32>(meshes[i].textureIndices.size());
-			_uavCounterOffsets[i] = AlignForUavCounter(static_cast<uint32>(meshes[i].matrices.size() * sizeof(InstacingVertexData)));
+			const uint32 lodCount = static_cast<uint32>(meshVertexAndIndices[i]->lods.size()) + 1;
+			const uint32 uavCounterOffset = AlignForUavCounter(static_cast<uint32>(meshes[i].matrices.size() * sizeof(InstacingVertexData)));
+			_indirectArgumentCount += static_cast<uint32>(meshes[i].textureIndices.size()) * lodCount;
+			_lodSlotOffsets[i] = _cullingSlotCount;
+			_uavCounterOffsets.insert(_uavCounterOffsets.end(), lodCount, uavCounterOffset);
+			_cullingSlotCount += lodCount;
 		}
 	}
 
-	//R}hVOl`
+	//コマンドシグネチャ生成
 	{
-		_indirectArgumentDstCounterOffset = AlignForUavCounter(_indirectArgumentCount * sizeof(IndirectCommand));
+		//IndirectBufferは頂点フォーマットごとの区間を並べ、その後ろにカウンタをフォーマットの数だけ置く
+		//UAVの要素数は0にできないので、使わないフォーマットにも1つ分の区間を割り当てる
+		UINT dstArgumentCount = 0;
+		for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+			_indirectArgumentDstOffsets[vertexFormat] = dstArgumentCount;
+			dstArgumentCount += max(_indirectArgumentCounts[vertexFormat], 1u);
+		}
+
+		for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+			_indirectArgumentDstCounterOffsets[vertexFormat] = AlignForUavCounter(dstArgumentCount * sizeof(IndirectCommand)) + vertexFormat * D3D12_UAV_COUNTER_PLACEMENT_ALIGNMENT;
+		}
 
 		// Each command consists of a CBV update and a DrawInstanced call.
 		VectorArray<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs(5);
@@ -291,7 +369,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		argumentDescs[2].VertexBuffer.Slot = 1;
 		argumentDescs[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
 		argumentDescs[3].Constant.RootParameterIndex = 1;
-		argumentDescs[3].Constant.Num32BitValuesToSet = 4;
+		argumentDescs[3].Constant.Num32BitValuesToSet = INDIRECT_DRAW_CONSTANT_COUNT;
 		argumentDescs[3].Constant.DestOffsetIn32BitValues = 0;
 		argumentDescs[4].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
 
@@ -299,7 +377,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		_mainPassCommandSignature.create(device, sizeof(IndirectCommand), argumentDescs, _mainPassCommand._rootSignature.rootSignature);
 	}
 
-	//GPUJOXe[g
+	//GPUカリングステート
 	D3D12_HEAP_PROPERTIES defaultHeapProperties = { D3D12_HEAP_TYPE_DEFAULT };
 	D3D12_HEAP_PROPERTIES uploadHeapProperties = { D3D12_HEAP_TYPE_UPLOAD };
 	{
@@ -325,7 +403,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 
 		D3D12_DESCRIPTOR_RANGE1 uavRange = {};
 		uavRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-		uavRange.NumDescriptors = _meshCount;
+		uavRange.NumDescriptors = _cullingSlotCount;
 		uavRange.BaseShaderRegister = 0;
 		uavRange.RegisterSpace = 0;
 		uavRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE;
@@ -351,7 +429,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		_gpuCullingCommand._rootSignature = rootSignature->getRefRootSignature();
 
 		ComputeShader computeShader;
-		computeShader.create("Shaders/GpuCulling_cs.hlsl", D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES);//DynamicIndexinggp
+		computeShader.create("Shaders/GpuCulling_cs.hlsl", D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES);//DynamicIndexingを使用
 
 		D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 		computePsoDesc.pRootSignature = rootSignature->_rootSignature.Get();
@@ -361,11 +439,11 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		_gpuCullingCommand._pipelineState = pipelineState->getRefPipelineState();
 	}
 
-	//IndirectCommandXe[g
+	//IndirectCommandステート
 	{
 		D3D12_DESCRIPTOR_RANGE1 srvRange = {};
 		srvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-		srvRange.NumDescriptors = _meshCount;
+		srvRange.NumDescriptors = _cullingSlotCount;
 		srvRange.BaseShaderRegister = 2;
 		srvRange.RegisterSpace = 0;
 		srvRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC;
@@ -373,7 +451,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 
 		D3D12_DESCRIPTOR_RANGE1 uavRange = {};
 		uavRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-		uavRange.NumDescriptors = 1;
+		uavRange.NumDescriptors = MESH_VERTEX_FORMAT_COUNT;
 		uavRange.BaseShaderRegister = 0;
 		uavRange.RegisterSpace = 0;
 		uavRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE;
@@ -404,7 +482,7 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		_setupIndirectArgumentCommand._rootSignature = rootSignature->getRefRootSignature();
 
 		ComputeShader computeShader;
-		computeShader.create("Shaders/SetupIndirectCommand_cs.hlsl", D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES);//DynamicIndexinggp
+		computeShader.create("Shaders/SetupIndirectCommand_cs.hlsl", D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES);//DynamicIndexingを使用
 
 		D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 		computePsoDesc.pRootSignature = rootSignature->_rootSignature.Get();
@@ -414,13 +492,10 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 		_setupIndirectArgumentCommand._pipelineState = pipelineState->getRefPipelineState();
 	}
 
-	ComPtr<ID3D12Resource> inCommandUploadBuffers;
-	ComPtr<ID3D12Resource> indirectCommandUploadBuffers;
+	//アップロード中にリングが埋まるとコマンドリストが切り替わるので、バリアは毎回アップロードコンテキストから取得したリストに積む
+	UploadContext uploadContext(commandContext);
 
-	auto commandListSet = commandContext->requestCommandListSet();
-	RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
-
-	//JOÕV[ɔzuĂIuWFNg̍sobt@
+	//カリング前のシーンに配置されているオブジェクトの行列バッファ
 	uint32 totalMaxInstanceCount = 0;
 	for (const auto& indirectMesh : meshes) {
 		totalMaxInstanceCount += static_cast<uint32>(indirectMesh.matrices.size());
@@ -433,37 +508,55 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 	_boundingBoxies.reserve(totalMaxInstanceCount);
 #endif
 
+	TextureStreamer& textureStreamer = TextureStreamer::instance();
 	for (uint32 i = 0; i < _meshCount; ++i) {
-		for (uint32 j = 0; j < meshes[i].matrices.size(); ++j) {
-			//oEfBO{bNX񂪕KvȂ̂Ŏ擾
-			RefPtr<VertexAndIndexBuffer> meshVertexAndIndex;
-			gpuResourceManager.loadVertexAndIndexBuffer(initInfo.meshNames[i], &meshVertexAndIndex);
+		//メッシュが参照するテクスチャ。ストリーミングの画面サイズ計算にインスタンスの境界球を登録する
+		VectorArray<uint32> usedTextures;
+		for (const auto& textureIndices : meshes[i].textureIndices) {
+			for (uint32 textureIndex : { textureIndices.t1, textureIndices.t2, textureIndices.t3, textureIndices.t4 }) {
+				if (std::find(usedTextures.begin(), usedTextures.end(), textureIndex) == usedTextures.end()) {
+					usedTextures.push_back(textureIndex);
+				}
+			}
+		}
 
-			//AABBW߂
+		for (uint32 j = 0; j < meshes[i].matrices.size(); ++j) {
+			//AABB情報を集める
 			const Matrix4& mtxWorld = meshes[i].matrices[j];
-			AABB boundingBox = meshVertexAndIndex->boundingBox.createTransformMatrix(mtxWorld);
+			AABB boundingBox = meshVertexAndIndices[i]->boundingBox.createTransformMatrix(mtxWorld);
 			boundingBox.translate(mtxWorld.translate());
 
 #ifdef ENABLE_AABB_DEBUG_DRAW
-			_boundingBoxies.emplace_back(boundingBox);//fobOp
+			_boundingBoxies.emplace_back(boundingBox);//デバッグ用
 #endif
 
-			PerInstanceMeshInfo info;
-			info.indirectArgumentIndex = i;
+			for (uint32 textureIndex : usedTextures) {
+				textureStreamer.addTextureUsage(*textures[textureIndex], boundingBox.center(), boundingBox.extent().length());
+			}
+
+			//LODはカリングと一緒に画面上の大きさから選び、LODごとのカリング結果に積む
+			const VectorArray<MeshFileLod>& lods = meshVertexAndIndices[i]->lods;
+			PerInstanceMeshInfo info = {};
+			info.indirectArgumentIndex = _lodSlotOffsets[i];
 			info.mtxWorld = mtxWorld.transpose();
 			info.boundingBox = boundingBox;
+			info.lodCount = static_cast<uint32>(lods.size()) + 1;
+			for (uint32 lodIndex = 1; lodIndex < info.lodCount; ++lodIndex) {
+				info.lodErrors[lodIndex] = lods[lodIndex - 1].error;
+			}
 
 			mergedMatrices.emplace_back(info);
+			_cpuCullingInstances.push_back({ meshVertexAndIndices[i], mtxWorld, boundingBox });
 		}
 	}
 
-	//g[^̃CX^X256̐(Thread X Num)ŃACĉDispatch邩߂
+	//トータルのインスタンス数を256の数(Thread X Num)でアラインして何回Dispatchするか決める
 	constexpr uint32 THREAD_BLOCK_SIZE = 256;
 	_gpuCullingDispatchCount = ((mergedMatrices.size() + (THREAD_BLOCK_SIZE - 1)) & ~(THREAD_BLOCK_SIZE - 1)) / THREAD_BLOCK_SIZE;
 
 	RefPtr<GpuBuffer> gpuDrivenInstanceMatrixBuffer = gpuResourceManager.createOnlyGpuBuffer(materialName + "_GpuDrivenInstanceMatrix");
-	gpuDrivenInstanceMatrixBuffer->createDeferredGpuOnly<PerInstanceMeshInfo>(device, commandList, &inCommandUploadBuffers, mergedMatrices);
-	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(gpuDrivenInstanceMatrixBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	gpuDrivenInstanceMatrixBuffer->createDeferredGpuOnly<PerInstanceMeshInfo>(device, uploadContext, mergedMatrices);
+	uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(gpuDrivenInstanceMatrixBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
 
 	D3D12_BUFFER_SRV matrixSrvDesc = {};
 	matrixSrvDesc.FirstElement = 0;
@@ -476,149 +569,152 @@ void StaticMultiMesh::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext>
 	_gpuCullingCommand._descriptors.emplace_back(0, gpuDrivenInstanceMatrixSRV->getRefBufferView());
 
 
-	//CX^Xps񒸓_obt@ƂUAV𐶐
-	VectorArray<D3D12_BUFFER_UAV> gpuDrivenInstanceCulledBufferUavs(_meshCount);
-	VectorArray<D3D12_BUFFER_SRV> gpuDrivenInstanceCulledBufferSrvs(_meshCount);
+	//インスタンス用行列頂点バッファとそのUAVをメッシュとLODの組ごとに生成
+	VectorArray<D3D12_BUFFER_UAV> gpuDrivenInstanceCulledBufferUavs(_cullingSlotCount);
+	VectorArray<D3D12_BUFFER_SRV> gpuDrivenInstanceCulledBufferSrvs(_cullingSlotCount);
 
-	for (size_t i = 0; i < gpuDrivenInstanceCulledBufferUavs.size(); ++i) {
+	for (uint32 i = 0; i < _cullingSlotCount; ++i) {
+		const uint32 meshIndex = static_cast<uint32>(std::upper_bound(_lodSlotOffsets.begin(), _lodSlotOffsets.end(), i) - _lodSlotOffsets.begin()) - 1;
 		D3D12_BUFFER_UAV& bufferUav = gpuDrivenInstanceCulledBufferUavs[i];
 		bufferUav.FirstElement = 0;
-		bufferUav.NumElements = static_cast<uint32>(meshes[i].matrices.size());
+		bufferUav.NumElements = static_cast<uint32>(meshes[meshIndex].matrices.size());
 		bufferUav.StructureByteStride = sizeof(InstacingVertexData);
 		bufferUav.CounterOffsetInBytes = _uavCounterOffsets[i];
 
-		//ByteAddressBufferƂēǂݍAppendStructuredBuffer̃JE^̒lǂݎ
+		//ByteAddressBufferとして読み込んでAppendStructuredBufferのカウンタの値を読み取る
 		constexpr UINT CountLength = 1;
 		D3D12_BUFFER_SRV& bufferSrv = gpuDrivenInstanceCulledBufferSrvs[i];
 		bufferSrv.FirstElement = 0;
-		bufferSrv.NumElements = static_cast<UINT>(bufferUav.CounterOffsetInBytes / sizeof(UINT) + CountLength);//4byteItZbg̐Ŏw肷
+		bufferSrv.NumElements = static_cast<UINT>(bufferUav.CounterOffsetInBytes / sizeof(UINT) + CountLength);//4byteオフセットの数で指定する
 		bufferSrv.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
 	}
 
-	//GPUJÕobt@oCh邽߂SRVUAV쐬
-	VectorArray<RefPtr<ID3D12Resource>> ppCulledBuffers(_meshCount);
-	_gpuDrivenInstanceCulledBuffers.resize(_meshCount);
+	//ExecuteIndirectに渡すIndirectBufferの元データ
+	VectorArray<InIndirectCommand> commands(_indirectArgumentCount);
 
-	for (uint32 i = 0; i < _meshCount; ++i) {
-		char str = i;
-		_gpuDrivenInstanceCulledBuffers[i] = gpuResourceManager.createOnlyGpuBuffer(materialName + "_GpuDrivenInstanceCulled_" + String(&str));
-		_gpuDrivenInstanceCulledBuffers[i]->createDirectGpuOnlyEmpty(device, _uavCounterOffsets[i] + sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-		ppCulledBuffers[i] = _gpuDrivenInstanceCulledBuffers[i]->get();
+	//IndirectArgumentバッファのUAV。頂点フォーマットごとの区間に別々のカウンタで積む
+	VectorArray<D3D12_BUFFER_UAV> indirectArgumentUavs(MESH_VERTEX_FORMAT_COUNT);
+	for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+		D3D12_BUFFER_UAV& indirectArgumentUav = indirectArgumentUavs[vertexFormat];
+		indirectArgumentUav.FirstElement = _indirectArgumentDstOffsets[vertexFormat];
+		indirectArgumentUav.NumElements = max(_indirectArgumentCounts[vertexFormat], 1u);
+		indirectArgumentUav.StructureByteStride = sizeof(IndirectCommand);
+		indirectArgumentUav.CounterOffsetInBytes = _indirectArgumentDstCounterOffsets[vertexFormat];
 	}
 
-	RefPtr<BufferView> gpuDriventInstanceCulledUAV = gpuResourceManager.createOnlyBufferView(materialName + "_GpuDrivenInstanceCulled_UAV");
-	RefPtr<BufferView> gpuDriventInstanceCulledSRV = gpuResourceManager.createOnlyBufferView(materialName + "_GpuDrivenInstanceCulled_SRV");
-	descriptorHeapManager.createUnorederdAcsessView(ppCulledBuffers.data(), gpuDriventInstanceCulledUAV, _meshCount, gpuDrivenInstanceCulledBufferUavs);
-	descriptorHeapManager.createShaderResourceView(ppCulledBuffers.data(), gpuDriventInstanceCulledSRV, _meshCount, gpuDrivenInstanceCulledBufferSrvs);
-	_gpuCullingCommand._descriptors.emplace_back(1, gpuDriventInstanceCulledUAV->getRefBufferView());
-	_setupIndirectArgumentCommand._descriptors.emplace_back(2, gpuDriventInstanceCulledSRV->getRefBufferView());
-
-	//ExecuteIndirectɓnIndirectBuffer𐶐
-	VectorArray<InIndirectCommand> commands(_indirectArgumentCount);
-
-	uint32 counter = 0;
-	for (uint32 i = 0; i < _meshCount; ++i) {
-		const uint32 culledBufferIndex = static_cast<uint32>(i);
-		const PerMeshData& meshInfo = meshes[i];
-		D3D12_VERTEX_BUFFER_VIEW perInstanceVertexBufferView = {};
-		perInstanceVertexBufferView.BufferLocation = _gpuDrivenInstanceCulledBuffers[culledBufferIndex]->getGpuVirtualAddress();
-		perInstanceVertexBufferView.StrideInBytes = sizeof(InstacingVertexData);
-		perInstanceVertexBufferView.SizeInBytes = _uavCounterOffsets[i] + sizeof(UINT);
-
-		//_obt@ƃCfbNXobt@̃\[X[h
-		RefPtr<VertexAndIndexBuffer> meshVertexAndIndex;
-		gpuResourceManager.loadVertexAndIndexBuffer(initInfo.meshNames[i], &meshVertexAndIndex);
-
-		//bṼTubVƂIndirectArgument\z
-		for (size_t j = 0; j < meshInfo.textureIndices.size(); ++j) {
-			const TextureIndex& textureIndices = meshInfo.textureIndices[j];
-
-			IndirectCommand& command = commands[counter].indirectCommand;
-			commands[counter].meshIndex[0] = i;
-			command.vertexBufferView = meshVertexAndIndex->vertexBuffer._vertexBufferView;
-			command.indexBufferView = meshVertexAndIndex->indexBuffer._indexBufferView;
-			command.perInstanceVertexBufferView = perInstanceVertexBufferView;
-			command.textureIndices = textureIndices;
-			command.drawArguments.IndexCountPerInstance = meshVertexAndIndex->materialDrawRanges[j].indexCount;
-			command.drawArguments.StartIndexLocation = meshVertexAndIndex->materialDrawRanges[j].indexOffset;
-			command.drawArguments.InstanceCount = 0;
-			command.drawArguments.BaseVertexLocation = 0;
-			command.drawArguments.StartInstanceLocation = 0;
-
-			counter++;
+	DescriptorPerFrameSet culledUavSet = { 1 };
+	DescriptorPerFrameSet culledSrvSet = { 2 };
+	DescriptorPerFrameSet setupCommandUavSet = { 3 };
+	GpuResourcePerFrameSet indirectArgumentSourceSet = { 0 };
+	indirectArgumentSourceSet.type = ResourceType::SHADER_RESOURCE;
+
+	//GPUカリング結果とIndirectBufferはフレームバッファリング数分生成する
+	for (uint32 frameIndex = 0; frameIndex < FrameCount; ++frameIndex) {
+		const String frameName = materialName + "_" + String(std::to_string(frameIndex).c_str());
+
+		//GPUカリング後のバッファをバインドするためのSRVとUAVを作成
+		VectorArray<RefPtr<GpuBuffer>>& culledBuffers = _gpuDrivenInstanceCulledBuffers[frameIndex];
+		VectorArray<RefPtr<ID3D12Resource>> ppCulledBuffers(_cullingSlotCount);
+		culledBuffers.resize(_cullingSlotCount);
+
+		for (uint32 i = 0; i < _cullingSlotCount; ++i) {
+			culledBuffers[i] = gpuResourceManager.createOnlyGpuBuffer(frameName + "_GpuDrivenInstanceCulled_" + String(std::to_string(i).c_str()));
+			culledBuffers[i]->createDirectGpuOnlyEmpty(device, _uavCounterOffsets[i] + sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+			ppCulledBuffers[i] = culledBuffers[i]->get();
 		}
-	}
 
-	RefPtr<GpuBuffer> indirectArgumentSourceBuffer = gpuResourceManager.createOnlyGpuBuffer(materialName + "_IndirectArgumentSource");
-	indirectArgumentSourceBuffer->createDeferredGpuOnly<InIndirectCommand>(device, commandList, &indirectCommandUploadBuffers, commands);
-	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentSourceBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		RefPtr<BufferView> gpuDriventInstanceCulledUAV = gpuResourceManager.createOnlyBufferView(frameName + "_GpuDrivenInstanceCulled_UAV");
+		RefPtr<BufferView> gpuDriventInstanceCulledSRV = gpuResourceManager.createOnlyBufferView(frameName + "_GpuDrivenInstanceCulled_SRV");
+		descriptorHeapManager.createUnorederdAcsessView(ppCulledBuffers.data(), gpuDriventInstanceCulledUAV, _cullingSlotCount, gpuDrivenInstanceCulledBufferUavs);
+		descriptorHeapManager.createShaderResourceView(ppCulledBuffers.data(), gpuDriventInstanceCulledSRV, _cullingSlotCount, gpuDrivenInstanceCulledBufferSrvs);
+		culledUavSet.viewAddresses[frameIndex] = gpuDriventInstanceCulledUAV->getRefBufferView();
+		culledSrvSet.viewAddresses[frameIndex] = gpuDriventInstanceCulledSRV->getRefBufferView();
+
+		uint32 counter = 0;
+		for (uint32 slot = 0; slot < _cullingSlotCount; ++slot) {
+			const uint32 i = static_cast<uint32>(std::upper_bound(_lodSlotOffsets.begin(), _lodSlotOffsets.end(), slot) - _lodSlotOffsets.begin()) - 1;
+			const uint32 lodIndex = slot - _lodSlotOffsets[i];
+			const PerMeshData& meshInfo = meshes[i];
+			D3D12_VERTEX_BUFFER_VIEW perInstanceVertexBufferView = {};
+			perInstanceVertexBufferView.BufferLocation = culledBuffers[slot]->getGpuVirtualAddress();
+			perInstanceVertexBufferView.StrideInBytes = sizeof(InstacingVertexData);
+			perInstanceVertexBufferView.SizeInBytes = _uavCounterOffsets[slot] + sizeof(UINT);
+
+			//LOD1以降はLOD0の後ろに並んだインデックスの描画範囲を使う。頂点バッファはLOD0と共有する
+			RefPtr<VertexAndIndexBuffer> meshVertexAndIndex = meshVertexAndIndices[i];
+			const MaterialDrawRange* drawRanges = lodIndex == 0 ? meshVertexAndIndex->materialDrawRanges.data()
+				: &meshVertexAndIndex->lodMaterialDrawRanges[(lodIndex - 1) * meshVertexAndIndex->materialDrawRanges.size()];
+
+			//メッシュ内のサブメッシュごとにIndirectArgument情報を構築
+			for (size_t j = 0; j < meshInfo.textureIndices.size(); ++j) {
+				const TextureIndex& textureIndices = meshInfo.textureIndices[j];
+				TextureIndex bindlessIndices;
+				bindlessIndices.t1 = bindlessTextureIndices[textureIndices.t1];
+				bindlessIndices.t2 = bindlessTextureIndices[textureIndices.t2];
+				bindlessIndices.t3 = bindlessTextureIndices[textureIndices.t3];
+				bindlessIndices.t4 = bindlessTextureIndices[textureIndices.t4];
+
+				IndirectCommand& command = commands[counter].indirectCommand;
+				commands[counter].meshIndex[0] = slot;
+				commands[counter].meshIndex[1] = meshVertexAndIndex->vertexFormat;
+				command.vertexBufferView = meshVertexAndIndex->vertexBuffer._vertexBufferView;
+				command.indexBufferView = meshVertexAndIndex->indexBuffer._indexBufferView;
+				command.perInstanceVertexBufferView = perInstanceVertexBufferView;
+				command.textureIndices = bindlessIndices;
+				command.dequantization = meshVertexAndIndex->dequantization;
+				command.drawArguments.IndexCountPerInstance = drawRanges[j].indexCount;
+				command.drawArguments.StartIndexLocation = drawRanges[j].indexOffset;
+				command.drawArguments.InstanceCount = 0;
+				command.drawArguments.BaseVertexLocation = 0;
+				command.drawArguments.StartInstanceLocation = 0;
+
+				counter++;
+			}
+		}
 
-	GpuResourceSet gSet = { 0, indirectArgumentSourceBuffer->getGpuVirtualAddress(), ResourceType::SHADER_RESOURCE };
-	_setupIndirectArgumentCommand._gpuResources.emplace_back(gSet);
+		RefPtr<GpuBuffer> indirectArgumentSourceBuffer = gpuResourceManager.createOnlyGpuBuffer(frameName + "_IndirectArgumentSource");
+		indirectArgumentSourceBuffer->createDeferredGpuOnly<InIndirectCommand>(device, uploadContext, commands);
+		uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentSourceBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		indirectArgumentSourceSet.resourceAddress[frameIndex] = indirectArgumentSourceBuffer->getGpuVirtualAddress();
 
-	//GPUJOIndirectBuffer
-	_indirectArgumentDstBuffer = gpuResourceManager.createOnlyGpuBuffer(materialName + "_IndirectArgumentDst");
-	_indirectArgumentDstBuffer->createDirectGpuOnlyEmpty(device, _indirectArgumentDstCounterOffset + sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		//GPUカリング後のIndirectBuffer
+		_indirectArgumentDstBuffers[frameIndex] = gpuResourceManager.createOnlyGpuBuffer(frameName + "_IndirectArgumentDst");
+		_indirectArgumentDstBuffers[frameIndex]->createDirectGpuOnlyEmpty(device, _indirectArgumentDstCounterOffsets[MESH_VERTEX_FORMAT_COUNT - 1] + sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
-	//IndirectArgumentobt@UAV쐬
-	D3D12_BUFFER_UAV bufferUav;
-	bufferUav.FirstElement = 0;
-	bufferUav.NumElements = _indirectArgumentCount;
-	bufferUav.StructureByteStride = sizeof(IndirectCommand);
-	bufferUav.CounterOffsetInBytes = _indirectArgumentDstCounterOffset;
+		VectorArray<RefPtr<ID3D12Resource>> ppIndirectArgumentDstBuffers(MESH_VERTEX_FORMAT_COUNT, _indirectArgumentDstBuffers[frameIndex]->get());
+		RefPtr<BufferView> setupCommandUAV = gpuResourceManager.createOnlyBufferView(frameName + "_SetupCommand_UAV");
+		descriptorHeapManager.createUnorederdAcsessView(ppIndirectArgumentDstBuffers.data(), setupCommandUAV, MESH_VERTEX_FORMAT_COUNT, indirectArgumentUavs);
+		setupCommandUavSet.viewAddresses[frameIndex] = setupCommandUAV->getRefBufferView();
+	}
 
-	RefPtr<BufferView> setupCommandUAV = gpuResourceManager.createOnlyBufferView(materialName + "_SetupCommand_UAV");
-	descriptorHeapManager.createUnorederdAcsessView(_indirectArgumentDstBuffer->getAdressOf(), setupCommandUAV, 1, { bufferUav });
-	_setupIndirectArgumentCommand._descriptors.emplace_back(3, setupCommandUAV->getRefBufferView());
+	_gpuCullingCommand._descriptorPerFrames.emplace_back(culledUavSet);
+	_setupIndirectArgumentCommand._descriptorPerFrames.emplace_back(culledSrvSet);
+	_setupIndirectArgumentCommand._descriptorPerFrames.emplace_back(setupCommandUavSet);
+	_setupIndirectArgumentCommand._gpuResourcePerFrames.emplace_back(indirectArgumentSourceSet);
 
-	//CulledBuffer̃JE^܂ł̃oCgItZbgi[obt@
+	//CulledBufferのカウンタまでのバイトオフセットを格納するバッファ
 	RefPtr<GpuBuffer> indirectArgumentOffsetsBuffer = gpuResourceManager.createOnlyGpuBuffer(materialName + "_IndirectArgumentOffsets");
-	ComPtr<ID3D12Resource> offsetsUpload;
-	indirectArgumentOffsetsBuffer->createDeferredGpuOnly<uint32>(device, commandList, &offsetsUpload, _uavCounterOffsets);
+	indirectArgumentOffsetsBuffer->createDeferredGpuOnly<uint32>(device, uploadContext, _uavCounterOffsets);
+	uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentOffsetsBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
 
 	GpuResourceSet gSet2 = { 1, indirectArgumentOffsetsBuffer->getGpuVirtualAddress(), ResourceType::SHADER_RESOURCE };
 	_setupIndirectArgumentCommand._gpuResources.emplace_back(gSet2);
 
-	//UAVJE^Zbg邽߂(UINT)0̃obt@𐶐
-	ComPtr<ID3D12Resource> uavCounterUpload;
+	//UAVカウンタをリセットするための(UINT)0のバッファを生成
 	_uavCounterReset = gpuResourceManager.createOnlyGpuBuffer(materialName + "_UavCounterReset");
-	_uavCounterReset->createDeferredGpuOnly<UINT>(device, commandList, &uavCounterUpload, { 0 });
+	_uavCounterReset->createDeferredGpuOnly<UINT>(device, uploadContext, { 0 });
+	uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_uavCounterReset->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE));
 
-	//R}hs(Abv[hobt@̃eNX`GPUǂݏobt@ɃRs[)
-	commandContext->executeCommandList(commandList);
-	commandContext->discardCommandListSet(commandListSet);
-
-	//Rs[I܂ŃAbv[hq[vjȂ
-	commandContext->waitForIdle();
+	//コマンド実行(アップロードリングからGPU読み書き限定バッファにコピー)
+	//コンピュートキューはGraphicsCoreがアップロードのフェンスをGPU上で待ってから使う
+	uploadContext.submit();
 }
 
+#include "ThirdParty/Imgui/imgui.h"
 void StaticMultiMesh::onCompute(RenderSettings & settings) {
 	RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
 	const uint32 frameIndex = settings.frameIndex;
 
-	//AppendStructuredBuffer̃JE^0ɃZbg
-	for (uint32 i = 0; i < _meshCount; ++i) {
-		commandList->CopyBufferRegion(_gpuDrivenInstanceCulledBuffers[i]->get(), _uavCounterOffsets[i], _uavCounterReset->get(), 0, sizeof(UINT));
-	}
-
-	_gpuCullingCommand.setupCommand(settings);
-	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, frameIndex);
-	commandList->Dispatch(_gpuCullingDispatchCount, 1, 1);
-
-	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, frameIndex);
-	_setupIndirectArgumentCommand.setupCommand(settings);
-
-	//AppendStructuredBuffer̃JE^0ɃZbg
-	commandList->CopyBufferRegion(_indirectArgumentDstBuffer->get(), _indirectArgumentDstCounterOffset, _uavCounterReset->get(), 0, sizeof(UINT));
-	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
-	commandList->Dispatch(_indirectArgumentCount, 1, 1);
-}
-
-#include "ThirdParty/Imgui/imgui.h"
-void StaticMultiMesh::setupDepthPassCommand(RenderSettings& settings){
-	RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
-	uint32 frameIndex = settings.frameIndex;
-
 	static Vector3 positionV = -Vector3::forward * 40 + Vector3::up * 5;
 	static float pitchV = 0;
 	static float yawV = 0;
@@ -626,6 +722,12 @@ void StaticMultiMesh::setupDepthPassCommand(RenderSettings& settings){
 	static float fovV = 60;
 	static float farZV = 10;
 	static float nearZV = 0.5f;
+	static bool isMeshletCullingStatisticsEnabled = false;
+	static bool isLodSelectionStatisticsEnabled = false;
+	static float lodErrorPixelsV = 1.0f;
+
+	//仮想カメラはメインの画面と同じ1280x720を想定する
+	constexpr uint32 VIRTUAL_SCREEN_HEIGHT = 720;
 
 	ImGui::Begin("Virtual Camera");
 	ImGui::DragFloat3("Position", (float*)& positionV, 0.05f);
@@ -635,7 +737,9 @@ void StaticMultiMesh::setupDepthPassCommand(RenderSettings& settings){
 	ImGui::SliderFloat("Fov", &fovV, 0, 120);
 	ImGui::SliderFloat("NearZ", &nearZV, 0.001f, 10);
 	ImGui::SliderFloat("FarZ", &farZV, 10, 1000);
-	ImGui::End();
+	ImGui::SliderFloat("LOD Error Pixels", &lodErrorPixelsV, 0, 8);
+	ImGui::Checkbox("Meshlet Culling Statistics", &isMeshletCullingStatisticsEnabled);
+	ImGui::Checkbox("LOD Selection Statistics", &isLodSelectionStatisticsEnabled);
 
 	Camera virtualCamera;
 	virtualCamera.setPosition(positionV);
@@ -649,44 +753,114 @@ void StaticMultiMesh::setupDepthPassCommand(RenderSettings& settings){
 	virtualCamera.computeFlustomNormals();
 	virtualCamera.debugDrawFlustom();
 
-	updateCullingCameraInfo(virtualCamera, frameIndex);
+	//インスタンスカリングの後にメッシュレット単位でどれだけ三角形を減らせるか
+	if (isMeshletCullingStatisticsEnabled) {
+		updateMeshletCullingStatistics(virtualCamera);
 
-	_depthPassCommand.setupCommand(settings);
+		const MeshletCullingStatistics& statistics = _meshletCullingStatistics;
+		const double triangleCount = static_cast<double>(max(statistics.triangleCount, 1ull));
+		ImGui::Text("Meshlets %u (frustum %u, backface %u)", statistics.meshletCount, statistics.frustumCulledMeshletCount, statistics.backfaceCulledMeshletCount);
+		ImGui::Text("Triangles %llu -> %llu", statistics.triangleCount, statistics.getVisibleTriangleCount());
+		ImGui::Text("Frustum culled %.1f%%", statistics.frustumCulledTriangleCount * 100.0 / triangleCount);
+		ImGui::Text("Backface culled %.1f%%", statistics.backfaceCulledTriangleCount * 100.0 / triangleCount);
+	}
+
+	//インスタンスカリングを通ったインスタンスをすべてLOD0で描いた場合に比べ、LODの選択でどれだけ三角形を減らせるか
+	if (isLodSelectionStatisticsEnabled) {
+		updateLodSelectionStatistics(virtualCamera, VIRTUAL_SCREEN_HEIGHT, lodErrorPixelsV);
 
+		const LodSelectionStatistics& statistics = _lodSelectionStatistics;
+		const double triangleCount = static_cast<double>(max(statistics.lod0TriangleCount, 1ull));
+		ImGui::Text("Instances %u (LOD0 %u, LOD1 %u, LOD2 %u, LOD3 %u)", statistics.instanceCount,
+			statistics.lodInstanceCounts[0], statistics.lodInstanceCounts[1], statistics.lodInstanceCounts[2], statistics.lodInstanceCounts[3]);
+		ImGui::Text("Triangles %llu -> %llu", statistics.lod0TriangleCount, statistics.selectedTriangleCount);
+		ImGui::Text("LOD reduced %.1f%%", (statistics.lod0TriangleCount - statistics.selectedTriangleCount) * 100.0 / triangleCount);
+	}
+	ImGui::End();
+
+	//カリング用カメラ情報はコンピュートパスの発行前に書き込む
+	updateCullingCameraInfo(virtualCamera, VIRTUAL_SCREEN_HEIGHT, lodErrorPixelsV, frameIndex);
+
+	const VectorArray<RefPtr<GpuBuffer>>& culledBuffers = _gpuDrivenInstanceCulledBuffers[frameIndex];
+	RefPtr<GpuBuffer> indirectArgumentDstBuffer = _indirectArgumentDstBuffers[frameIndex];
+
+	//AppendStructuredBufferのカウンタを0にリセットする
+	for (uint32 i = 0; i < _cullingSlotCount; ++i) {
+		commandList->CopyBufferRegion(culledBuffers[i]->get(), _uavCounterOffsets[i], _uavCounterReset->get(), 0, sizeof(UINT));
+	}
+
+	_gpuCullingCommand.setupCommand(settings);
+	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, frameIndex);
+	commandList->Dispatch(_gpuCullingDispatchCount, 1, 1);
+
+	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, frameIndex);
+	_setupIndirectArgumentCommand.setupCommand(settings);
+
+	//AppendStructuredBufferのカウンタを0にリセットする
+	for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+		commandList->CopyBufferRegion(indirectArgumentDstBuffer->get(), _indirectArgumentDstCounterOffsets[vertexFormat], _uavCounterReset->get(), 0, sizeof(UINT));
+	}
+	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+	commandList->Dispatch(_indirectArgumentCount, 1, 1);
+
+	//グラフィックスキューはフェンスを待つだけで使えるようにここで描画用のステートに遷移しておく
 	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, frameIndex);
-	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT));
+	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT));
+}
+
+void StaticMultiMesh::setupDepthPassCommand(RenderSettings& settings){
+	RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
+	RefPtr<GpuBuffer> indirectArgumentDstBuffer = _indirectArgumentDstBuffers[settings.frameIndex];
+
+	_depthPassCommand.setupCommand(settings);
 
 	//EXECUTION WARNING #1044: GPU_BASED_VALIDATION_RESOURCE_STATE_IMPRECISE
-	//IndirectAtgumentobt@Ɋ܂܂o[ebNXobt@xUAVƂĈ̂GPUfobOC[Ń\[X̒ǐՂłȂƌx
-	commandList->ExecuteIndirect(
-		_depthPassCommandSignature._commandSignature.Get(),
-		_indirectArgumentCount,
-		_indirectArgumentDstBuffer->get(),
-		0,
-		_indirectArgumentDstBuffer->get(),
-		_indirectArgumentDstCounterOffset);
+	//IndirectAtgumentバッファに含まれるバーテックスバッファを一度UAVとして扱うのでGPUデバッグレイヤー上でリソースの追跡ができないと警告
+	for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+		if (_indirectArgumentCounts[vertexFormat] == 0) {
+			continue;
+		}
+
+		commandList->SetPipelineState(_depthPassPipelineStates[vertexFormat].pipelineState);
+		commandList->ExecuteIndirect(
+			_depthPassCommandSignature._commandSignature.Get(),
+			_indirectArgumentCounts[vertexFormat],
+			indirectArgumentDstBuffer->get(),
+			_indirectArgumentDstOffsets[vertexFormat] * sizeof(IndirectCommand),
+			indirectArgumentDstBuffer->get(),
+			_indirectArgumentDstCounterOffsets[vertexFormat]);
+	}
 }
 
 void StaticMultiMesh::setupMainPassCommand(RenderSettings & settings) {
 	RefPtr<ID3D12GraphicsCommandList> commandList = settings.commandList;
 	uint32 frameIndex = settings.frameIndex;
+	RefPtr<GpuBuffer> indirectArgumentDstBuffer = _indirectArgumentDstBuffers[frameIndex];
 
 	_mainPassCommand.setupCommand(settings);
 
 	//EXECUTION WARNING #1044: GPU_BASED_VALIDATION_RESOURCE_STATE_IMPRECISE
-	//IndirectAtgumentobt@Ɋ܂܂o[ebNXobt@xUAVƂĈ̂GPUfobOC[Ń\[X̒ǐՂłȂƌx
-	commandList->ExecuteIndirect(
-		_mainPassCommandSignature._commandSignature.Get(),
-		_indirectArgumentCount,
-		_indirectArgumentDstBuffer->get(),
-		0,
-		_indirectArgumentDstBuffer->get(),
-		_indirectArgumentDstCounterOffset);
+	//IndirectAtgumentバッファに含まれるバーテックスバッファを一度UAVとして扱うのでGPUデバッグレイヤー上でリソースの追跡ができないと警告
+	for (uint32 vertexFormat = 0; vertexFormat < MESH_VERTEX_FORMAT_COUNT; ++vertexFormat) {
+		if (_indirectArgumentCounts[vertexFormat] == 0) {
+			continue;
+		}
+
+		commandList->SetPipelineState(_mainPassPipelineStates[vertexFormat].pipelineState);
+		commandList->ExecuteIndirect(
+			_mainPassCommandSignature._commandSignature.Get(),
+			_indirectArgumentCounts[vertexFormat],
+			indirectArgumentDstBuffer->get(),
+			_indirectArgumentDstOffsets[vertexFormat] * sizeof(IndirectCommand),
+			indirectArgumentDstBuffer->get(),
+			_indirectArgumentDstCounterOffsets[vertexFormat]);
+	}
 
+	//次にこのフレームのバッファを使うコンピュートキューのためにコピー先ステートへ戻す
 	culledBufferBarrier(commandList, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST, frameIndex);
-	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST));
+	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(indirectArgumentDstBuffer->get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST));
 
-	//DebugpoEfBO{bNXAABB`
+	//Debug用バウンディングボックスAABBを描画
 #ifdef ENABLE_AABB_DEBUG_DRAW
 	DebugGeometryRender& debug = DebugGeometryRender::instance();
 	for (const auto& aabb : _boundingBoxies) {
@@ -695,7 +869,100 @@ void StaticMultiMesh::setupMainPassCommand(RenderSettings & settings) {
 #endif
 }
 
-void StaticMultiMesh::updateCullingCameraInfo(const Camera & camera, uint32 frameIndex) {
+//GpuCulling_cs.hlslと同じく、AABBの平面方向に最も近い角が1つでも外側にあるインスタンスは描画されない
+static bool isInstanceVisible(const Camera& camera, const AABB& boundingBox) {
+	const Vector3 cameraPosition = camera.getPosition();
+	for (uint32 i = 0; i < 4; ++i) {
+		const Vector3 planeNormal = camera.getFrustumPlaneNormal(i);
+		const Vector3 positivePoint(
+			planeNormal.x > 0 ? boundingBox.max.x : boundingBox.min.x,
+			planeNormal.y > 0 ? boundingBox.max.y : boundingBox.min.y,
+			planeNormal.z > 0 ? boundingBox.max.z : boundingBox.min.z);
+		if (Vector3::dot(planeNormal, positivePoint - cameraPosition) <= 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//AABBを囲む境界球の画面上の直径(ピクセル)。カメラが球の中にあれば画面の高さより大きくしない
+static float computeScreenSize(const Vector3& cameraPosition, const AABB& boundingBox, float screenScale) {
+	const float radius = boundingBox.extent().length();
+	const float distance = max((boundingBox.center() - cameraPosition).length(), radius);
+	return distance > 0.0f ? radius / distance * screenScale : 0.0f;
+}
+
+void StaticMultiMesh::updateMeshletCullingStatistics(const Camera& camera) {
+	_meshletCullingStatistics = MeshletCullingStatistics();
+
+	const Vector3 cameraPosition = camera.getPosition();
+	for (const auto& instance : _cpuCullingInstances) {
+		if (instance.mesh->meshlets.empty() || !isInstanceVisible(camera, instance.boundingBox)) {
+			continue;
+		}
+
+		//メッシュレットの境界はローカル空間なので、カメラをインスタンスのローカル空間に移す
+		//平面の法線はワールド行列の基底との内積で移し、拡大縮小で伸びた分を正規化する
+		const Matrix4& mtxWorld = instance.mtxWorld;
+		const Vector3 basisX(mtxWorld.m[0][0], mtxWorld.m[0][1], mtxWorld.m[0][2]);
+		const Vector3 basisY(mtxWorld.m[1][0], mtxWorld.m[1][1], mtxWorld.m[1][2]);
+		const Vector3 basisZ(mtxWorld.m[2][0], mtxWorld.m[2][1], mtxWorld.m[2][2]);
+		const Vector3 localCameraPosition = Matrix4::transform(cameraPosition, mtxWorld.inverse());
+
+		MeshletCullingView view;
+		view.cameraPosition[0] = localCameraPosition.x;
+		view.cameraPosition[1] = localCameraPosition.y;
+		view.cameraPosition[2] = localCameraPosition.z;
+		for (uint32 i = 0; i < 4; ++i) {
+			const Vector3 planeNormal = camera.getFrustumPlaneNormal(i);
+			const Vector3 localNormal = Vector3(Vector3::dot(basisX, planeNormal), Vector3::dot(basisY, planeNormal), Vector3::dot(basisZ, planeNormal)).normalize();
+			view.frustumPlanes[i][0] = localNormal.x;
+			view.frustumPlanes[i][1] = localNormal.y;
+			view.frustumPlanes[i][2] = localNormal.z;
+		}
+
+		//非一様な拡大縮小ではコーンが歪み、反転では三角形の表裏が入れ替わるので裏面の判定をしない
+		constexpr float UNIFORM_SCALE_TOLERANCE = 1e-3f;
+		const float determinant = Vector3::dot(Vector3::cross(basisX, basisY), basisZ);
+		const float scaleX = basisX.length();
+		view.isBackfaceCullingEnabled = determinant > 0.0f
+			&& std::abs(basisY.length() - scaleX) <= scaleX * UNIFORM_SCALE_TOLERANCE
+			&& std::abs(basisZ.length() - scaleX) <= scaleX * UNIFORM_SCALE_TOLERANCE;
+
+		const VectorArray<MeshFileMeshlet>& meshlets = instance.mesh->meshlets;
+		MeshletBuilder::cullMeshlets(meshlets.data(), static_cast<uint32>(meshlets.size()), view, _meshletCullingStatistics);
+	}
+}
+
+void StaticMultiMesh::updateLodSelectionStatistics(const Camera& camera, uint32 screenHeight, float lodErrorPixels) {
+	_lodSelectionStatistics = LodSelectionStatistics();
+
+	const Vector3 cameraPosition = camera.getPosition();
+	const float screenScale = static_cast<float>(screenHeight) / camera.getTanHeightXY().y;
+	for (const auto& instance : _cpuCullingInstances) {
+		if (!isInstanceVisible(camera, instance.boundingBox)) {
+			continue;
+		}
+
+		const VertexAndIndexBuffer& mesh = *instance.mesh;
+		uint64 lod0TriangleCount = 0;
+		for (const auto& drawRange : mesh.materialDrawRanges) {
+			lod0TriangleCount += drawRange.indexCount / 3;
+		}
+
+		const float screenSize = computeScreenSize(cameraPosition, instance.boundingBox, screenScale);
+		const uint32 lodIndex = MeshSimplifier::selectLod(mesh.lods.data(), static_cast<uint32>(mesh.lods.size()), screenSize, lodErrorPixels);
+
+		LodSelectionStatistics& statistics = _lodSelectionStatistics;
+		++statistics.instanceCount;
+		++statistics.lodInstanceCounts[lodIndex];
+		statistics.lod0TriangleCount += lod0TriangleCount;
+		statistics.selectedTriangleCount += lodIndex == 0 ? lod0TriangleCount : mesh.lods[lodIndex - 1].triangleCount;
+	}
+}
+
+void StaticMultiMesh::updateCullingCameraInfo(const Camera & camera, uint32 screenHeight, float lodErrorPixels, uint32 frameIndex) {
 	GpuCullingCameraConstant gpuCullingConstant;
 	gpuCullingConstant.cameraPosition = camera.getPosition();
 
@@ -703,18 +970,20 @@ void StaticMultiMesh::updateCullingCameraInfo(const Camera & camera, uint32 fram
 		gpuCullingConstant.frustumPlanes[i] = camera.getFrustumPlaneNormal(i);
 	}
 
+	gpuCullingConstant.lodParameters = Vector4(static_cast<float>(screenHeight) / camera.getTanHeightXY().y, lodErrorPixels, 0.0f, 0.0f);
+
 	_gpuCullingCameraConstantBuffers[frameIndex]->writeData(&gpuCullingConstant, sizeof(gpuCullingConstant));
 }
 
 void StaticMultiMesh::culledBufferBarrier(RefPtr<ID3D12GraphicsCommandList> commandList, D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, uint32 frameIndex) const {
-	VectorArray<D3D12_RESOURCE_BARRIER> barriers(_meshCount);
-	for (uint32 i = 0; i < _meshCount; ++i) {
+	VectorArray<D3D12_RESOURCE_BARRIER> barriers(_cullingSlotCount);
+	for (uint32 i = 0; i < _cullingSlotCount; ++i) {
 		barriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
 		barriers[i].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 		barriers[i].Transition.StateBefore = StateBefore;
 		barriers[i].Transition.StateAfter = StateAfter;
-		barriers[i].Transition.pResource = _gpuDrivenInstanceCulledBuffers[i]->get();
+		barriers[i].Transition.pResource = _gpuDrivenInstanceCulledBuffers[frameIndex][i]->get();
 	}
 
-	commandList->ResourceBarrier(_meshCount, barriers.data());
+	commandList->ResourceBarrier(_cullingSlotCount, barriers.data());
 }
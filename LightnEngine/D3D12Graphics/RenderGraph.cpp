@@ -0,0 +1,385 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+	//同じパス内で同じリソースへのアクセスが複数あれば1つにまとめる。書き込みがあれば書き込みステート、読み込みのみならステートを合成
+	void mergePassAccesses(const RenderGraphPassDesc& pass, VectorArray<RenderGraphResourceAccess>& mergedAccesses) {
+		mergedAccesses.clear();
+		for (const auto& access : pass.accesses) {
+			auto itr = std::find_if(mergedAccesses.begin(), mergedAccesses.end(),
+				[&access](const RenderGraphResourceAccess& merged) { return merged.resource == access.resource; });
+
+			if (itr == mergedAccesses.end()) {
+				mergedAccesses.push_back(access);
+				continue;
+			}
+
+			if (access.isWrite) {
+				assert((!itr->isWrite || itr->state == access.state) && "1つのパスで同じリソースに異なるステートで書き込むことはできません");
+				itr->state = access.state;
+				itr->isWrite = true;
+			}
+			else if (!itr->isWrite) {
+				itr->state |= access.state;
+			}
+		}
+	}
+
+	bool isReadOnlyState(uint32 state) {
+		return (state & RenderGraphWriteStates) == 0;
+	}
+
+	uint64 alignUp(uint64 value, uint64 alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	bool isLifetimeOverlapped(const RenderGraphResourcePlacement& a, const RenderGraphResourcePlacement& b) {
+		return !(a.lastPass < b.firstPass || b.lastPass < a.firstPass);
+	}
+
+	bool isMemoryOverlapped(uint64 offsetA, uint64 sizeA, uint64 offsetB, uint64 sizeB) {
+		return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+	}
+}
+
+RenderGraph::RenderGraph() :_isCompiled(false) {
+}
+
+RenderGraphResourceHandle RenderGraph::importResource(const String& name, uint32 initialState, uint32 finalState) {
+	RenderGraphResourceDesc desc = {};
+	desc.name = name;
+	desc.isImported = true;
+	desc.initialState = initialState;
+	desc.finalState = finalState;
+
+	_resources.push_back(desc);
+	_isCompiled = false;
+	return static_cast<RenderGraphResourceHandle>(_resources.size() - 1);
+}
+
+RenderGraphResourceHandle RenderGraph::createTransientResource(const String& name, uint64 size, uint64 alignment, uint32 heapGroup) {
+	assert(alignment > 0 && "アライメントが0です");
+
+	RenderGraphResourceDesc desc = {};
+	desc.name = name;
+	desc.isImported = false;
+	desc.size = size;
+	desc.alignment = alignment;
+	desc.heapGroup = heapGroup;
+
+	_resources.push_back(desc);
+	_isCompiled = false;
+	return static_cast<RenderGraphResourceHandle>(_resources.size() - 1);
+}
+
+uint32 RenderGraph::addPass(const String& name, bool hasSideEffect) {
+	RenderGraphPassDesc desc;
+	desc.name = name;
+	desc.hasSideEffect = hasSideEffect;
+
+	_passes.push_back(desc);
+	_isCompiled = false;
+	return static_cast<uint32>(_passes.size() - 1);
+}
+
+void RenderGraph::readResource(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state) {
+	assert(isReadOnlyState(state) && "読み込みに書き込みステートが指定されました");
+	addAccess(passIndex, resource, state, false);
+}
+
+void RenderGraph::writeResource(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state) {
+	assert(!isReadOnlyState(state) && "書き込みに読み込みステートが指定されました");
+	addAccess(passIndex, resource, state, true);
+}
+
+void RenderGraph::addAccess(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state, bool isWrite) {
+	assert(passIndex < _passes.size() && "存在しないパスです");
+	assert(resource < _resources.size() && "存在しないリソースです");
+
+	_passes[passIndex].accesses.push_back({ resource, state, isWrite });
+	_isCompiled = false;
+}
+
+void RenderGraph::compile() {
+	const size_t passCount = _passes.size();
+	const size_t resourceCount = _resources.size();
+
+	_passCulled.assign(passCount, false);
+	_passBarriers.assign(passCount, VectorArray<RenderGraphBarrier>());
+	_passDiscards.assign(passCount, VectorArray<RenderGraphResourceAccess>());
+	_finalBarriers.clear();
+	_placements.assign(resourceCount, RenderGraphResourcePlacement());
+	_heapSizes.clear();
+	_statistics = RenderGraphStatistics();
+	_statistics.passCount = static_cast<uint32>(passCount);
+
+	cullPasses();
+	computeLifetimes();
+	computeTransientStates();
+	allocateTransientResources();
+	computeBarriers();
+
+	_isCompiled = true;
+}
+
+void RenderGraph::clear() {
+	_resources.clear();
+	_passes.clear();
+	_passCulled.clear();
+	_passBarriers.clear();
+	_passDiscards.clear();
+	_finalBarriers.clear();
+	_placements.clear();
+	_heapSizes.clear();
+	_statistics = RenderGraphStatistics();
+	_isCompiled = false;
+}
+
+bool RenderGraph::isPassCulled(uint32 passIndex) const {
+	assert(_isCompiled && "レンダーグラフがコンパイルされていません");
+	return _passCulled[passIndex];
+}
+
+const VectorArray<RenderGraphBarrier>& RenderGraph::getPassBarriers(uint32 passIndex) const {
+	assert(_isCompiled && "レンダーグラフがコンパイルされていません");
+	return _passBarriers[passIndex];
+}
+
+const VectorArray<RenderGraphResourceAccess>& RenderGraph::getPassDiscards(uint32 passIndex) const {
+	assert(_isCompiled && "レンダーグラフがコンパイルされていません");
+	return _passDiscards[passIndex];
+}
+
+//後ろのパスから辿り、インポートリソースか後段で使われるリソースに書き込むパスだけを残す
+//書き込みは前の内容を読み込む可能性があるので、残したパスがアクセスするリソースはすべて必要とみなす
+void RenderGraph::cullPasses() {
+	VectorArray<bool> isResourceNeeded(_resources.size(), false);
+
+	for (size_t i = _passes.size(); i > 0; --i) {
+		const size_t passIndex = i - 1;
+		const RenderGraphPassDesc& pass = _passes[passIndex];
+
+		bool isAlive = pass.hasSideEffect;
+		for (const auto& access : pass.accesses) {
+			if (access.isWrite && (_resources[access.resource].isImported || isResourceNeeded[access.resource])) {
+				isAlive = true;
+			}
+		}
+
+		if (!isAlive) {
+			_passCulled[passIndex] = true;
+			++_statistics.culledPassCount;
+			continue;
+		}
+
+		for (const auto& access : pass.accesses) {
+			isResourceNeeded[access.resource] = true;
+		}
+	}
+}
+
+void RenderGraph::computeLifetimes() {
+	for (uint32 passIndex = 0; passIndex < _passes.size(); ++passIndex) {
+		if (_passCulled[passIndex]) {
+			continue;
+		}
+
+		for (const auto& access : _passes[passIndex].accesses) {
+			const RenderGraphResourceDesc& resource = _resources[access.resource];
+			if (resource.isImported) {
+				continue;
+			}
+
+			RenderGraphResourcePlacement& placement = _placements[access.resource];
+			if (!placement.isAllocated) {
+				placement.isAllocated = true;
+				placement.heapGroup = resource.heapGroup;
+				placement.firstPass = passIndex;
+			}
+
+			placement.lastPass = passIndex;
+		}
+	}
+}
+
+//トランジェントリソースは最後に使われるステートで生成しておき、毎フレームそのステートから始める
+void RenderGraph::computeTransientStates() {
+	VectorArray<RenderGraphResourceAccess> mergedAccesses;
+	for (uint32 passIndex = 0; passIndex < _passes.size(); ++passIndex) {
+		if (_passCulled[passIndex]) {
+			continue;
+		}
+
+		mergePassAccesses(_passes[passIndex], mergedAccesses);
+		for (const auto& access : mergedAccesses) {
+			if (!_resources[access.resource].isImported) {
+				_resources[access.resource].initialState = access.state;
+			}
+		}
+	}
+}
+
+//寿命が重なるもの同士はメモリが重ならないように、大きいものから順に一番低いオフセットへ配置する
+void RenderGraph::allocateTransientResources() {
+	VectorArray<RenderGraphResourceHandle> transientResources;
+	for (RenderGraphResourceHandle i = 0; i < _resources.size(); ++i) {
+		if (_placements[i].isAllocated) {
+			transientResources.push_back(i);
+		}
+	}
+
+	std::stable_sort(transientResources.begin(), transientResources.end(),
+		[this](RenderGraphResourceHandle a, RenderGraphResourceHandle b) { return _resources[a].size > _resources[b].size; });
+
+	VectorArray<RenderGraphResourceHandle> placedResources;
+	VectorArray<uint64> candidateOffsets;
+	for (RenderGraphResourceHandle resource : transientResources) {
+		const RenderGraphResourceDesc& desc = _resources[resource];
+		RenderGraphResourcePlacement& placement = _placements[resource];
+
+		//寿命が重なる配置済みリソースの直後を候補にする
+		candidateOffsets.clear();
+		candidateOffsets.push_back(0);
+		for (RenderGraphResourceHandle placed : placedResources) {
+			const RenderGraphResourcePlacement& placedPlacement = _placements[placed];
+			if (placedPlacement.heapGroup == placement.heapGroup && isLifetimeOverlapped(placedPlacement, placement)) {
+				candidateOffsets.push_back(alignUp(placedPlacement.heapOffset + _resources[placed].size, desc.alignment));
+			}
+		}
+
+		std::sort(candidateOffsets.begin(), candidateOffsets.end());
+
+		for (uint64 offset : candidateOffsets) {
+			bool isOverlapped = false;
+			for (RenderGraphResourceHandle placed : placedResources) {
+				const RenderGraphResourcePlacement& placedPlacement = _placements[placed];
+				if (placedPlacement.heapGroup == placement.heapGroup &&
+					isLifetimeOverlapped(placedPlacement, placement) &&
+					isMemoryOverlapped(offset, desc.size, placedPlacement.heapOffset, _resources[placed].size)) {
+					isOverlapped = true;
+					break;
+				}
+			}
+
+			if (!isOverlapped) {
+				placement.heapOffset = offset;
+				break;
+			}
+		}
+
+		if (_heapSizes.size() <= placement.heapGroup) {
+			_heapSizes.resize(placement.heapGroup + 1, 0);
+		}
+
+		_heapSizes[placement.heapGroup] = std::max(_heapSizes[placement.heapGroup], placement.heapOffset + desc.size);
+		placedResources.push_back(resource);
+
+		++_statistics.transientResourceCount;
+		_statistics.transientMemoryWithoutAliasing += desc.size;
+	}
+
+	for (uint64 heapSize : _heapSizes) {
+		_statistics.transientHeapSize += heapSize;
+	}
+}
+
+//パスごとに必要なバリアを1つの配列にまとめる。読み込み同士でステートが包含されていれば遷移しない
+void RenderGraph::computeBarriers() {
+	const size_t resourceCount = _resources.size();
+	VectorArray<uint32> currentStates(resourceCount);
+	VectorArray<bool> isLastAccessUav(resourceCount, false);
+	VectorArray<bool> isLastAccessUavWrite(resourceCount, false);
+	for (size_t i = 0; i < resourceCount; ++i) {
+		currentStates[i] = _resources[i].initialState;
+	}
+
+	VectorArray<RenderGraphResourceAccess> mergedAccesses;
+	for (uint32 passIndex = 0; passIndex < _passes.size(); ++passIndex) {
+		if (_passCulled[passIndex]) {
+			continue;
+		}
+
+		VectorArray<RenderGraphBarrier>& barriers = _passBarriers[passIndex];
+		mergePassAccesses(_passes[passIndex], mergedAccesses);
+
+		//エイリアスバリア 同じメモリを直前まで使っていたトランジェントリソースから切り替える
+		//このフレームで先に使ったものがなければ、前フレームで最後に使ったものから切り替える
+		for (const auto& access : mergedAccesses) {
+			const RenderGraphResourcePlacement& placement = _placements[access.resource];
+			if (!placement.isAllocated || placement.firstPass != passIndex) {
+				continue;
+			}
+
+			RenderGraphResourceHandle aliasBefore = InvalidRenderGraphResource;
+			size_t latestUseOrder = 0;
+			for (RenderGraphResourceHandle other = 0; other < resourceCount; ++other) {
+				const RenderGraphResourcePlacement& otherPlacement = _placements[other];
+				if (other == access.resource || !otherPlacement.isAllocated || otherPlacement.heapGroup != placement.heapGroup) {
+					continue;
+				}
+
+				if (!isMemoryOverlapped(placement.heapOffset, _resources[access.resource].size, otherPlacement.heapOffset, _resources[other].size)) {
+					continue;
+				}
+
+				const size_t useOrder = otherPlacement.lastPass < placement.firstPass ? otherPlacement.lastPass + _passes.size() : otherPlacement.lastPass;
+				if (aliasBefore == InvalidRenderGraphResource || latestUseOrder < useOrder) {
+					aliasBefore = other;
+					latestUseOrder = useOrder;
+				}
+			}
+
+			if (aliasBefore != InvalidRenderGraphResource) {
+				barriers.push_back({ RenderGraphBarrierType::ALIASING, access.resource, 0, 0, aliasBefore });
+				++_statistics.aliasingBarrierCount;
+			}
+
+			//切り替えた直後のメモリには前のリソースの内容が残っているので、最初の書き込みの前に破棄する
+			//読み込みから始まるリソースは不定な内容を読むことになる
+			assert((aliasBefore == InvalidRenderGraphResource || access.isWrite) && "エイリアスしたトランジェントリソースを書き込む前に読んでいます");
+			if (access.isWrite) {
+				_passDiscards[passIndex].push_back(access);
+				++_statistics.discardCount;
+			}
+		}
+
+		//ステート遷移
+		for (const auto& access : mergedAccesses) {
+			uint32& currentState = currentStates[access.resource];
+			const bool isCovered = isReadOnlyState(access.state) && isReadOnlyState(currentState) && (currentState & access.state) == access.state;
+			if (currentState == access.state || isCovered) {
+				continue;
+			}
+
+			barriers.push_back({ RenderGraphBarrierType::TRANSITION, access.resource, currentState, access.state, InvalidRenderGraphResource });
+			++_statistics.transitionBarrierCount;
+			currentState = access.state;
+		}
+
+		//UAVバリア 連続するUAVアクセスのどちらかが書き込みなら前のパスの書き込み完了を待つ
+		for (const auto& access : mergedAccesses) {
+			const bool isUavAccess = access.state == RENDER_GRAPH_STATE_UNORDERED_ACCESS;
+			const bool isTransitioned = std::any_of(barriers.begin(), barriers.end(), [&access](const RenderGraphBarrier& barrier) {
+				return barrier.type == RenderGraphBarrierType::TRANSITION && barrier.resource == access.resource;
+			});
+
+			if (isUavAccess && !isTransitioned && isLastAccessUav[access.resource] && (isLastAccessUavWrite[access.resource] || access.isWrite)) {
+				barriers.push_back({ RenderGraphBarrierType::UAV, access.resource, 0, 0, InvalidRenderGraphResource });
+				++_statistics.uavBarrierCount;
+			}
+
+			isLastAccessUav[access.resource] = isUavAccess;
+			isLastAccessUavWrite[access.resource] = isUavAccess && access.isWrite;
+		}
+	}
+
+	//インポートリソースを外部が期待するステートへ戻す
+	for (RenderGraphResourceHandle i = 0; i < resourceCount; ++i) {
+		const RenderGraphResourceDesc& desc = _resources[i];
+		if (desc.isImported && currentStates[i] != desc.finalState) {
+			_finalBarriers.push_back({ RenderGraphBarrierType::TRANSITION, i, currentStates[i], desc.finalState, InvalidRenderGraphResource });
+			++_statistics.transitionBarrierCount;
+		}
+	}
+}
@@ -0,0 +1,177 @@
+#include "RenderGraphExecutor.h"
+#include "D3D12Helper.h"
+#include "D3D12Util.h"
+
+//RenderGraphのステートはD3D12_RESOURCE_STATESをそのままキャストして使う
+static_assert(RENDER_GRAPH_STATE_RENDER_TARGET == D3D12_RESOURCE_STATE_RENDER_TARGET, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_UNORDERED_ACCESS == D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_DEPTH_WRITE == D3D12_RESOURCE_STATE_DEPTH_WRITE, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_DEPTH_READ == D3D12_RESOURCE_STATE_DEPTH_READ, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_INDIRECT_ARGUMENT == D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_COPY_DEST == D3D12_RESOURCE_STATE_COPY_DEST, "レンダーグラフのステート定義がD3D12と一致しません");
+static_assert(RENDER_GRAPH_STATE_COPY_SOURCE == D3D12_RESOURCE_STATE_COPY_SOURCE, "レンダーグラフのステート定義がD3D12と一致しません");
+
+RenderGraphExecutor::RenderGraphExecutor() :_device(nullptr) {
+}
+
+RenderGraphExecutor::~RenderGraphExecutor() {
+	shutdown();
+}
+
+void RenderGraphExecutor::create(RefPtr<ID3D12Device> device) {
+	_device = device;
+}
+
+void RenderGraphExecutor::shutdown() {
+	_transientResources.clear();
+	for (uint32 i = 0; i < HEAP_GROUP_COUNT; ++i) {
+		_heaps[i] = nullptr;
+	}
+
+	_resources.clear();
+	_transientDescs.clear();
+}
+
+RenderGraphResourceHandle RenderGraphExecutor::createTransientResource(RenderGraph& graph, const String& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue) {
+	const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = _device->GetResourceAllocationInfo(0, 1, &desc);
+
+	uint32 heapGroup = HEAP_GROUP_BUFFER;
+	if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER) {
+		const bool isRtDs = (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+		heapGroup = isRtDs ? HEAP_GROUP_RT_DS_TEXTURE : HEAP_GROUP_NON_RT_DS_TEXTURE;
+	}
+
+	RenderGraphResourceHandle handle = graph.createTransientResource(name, allocationInfo.SizeInBytes, allocationInfo.Alignment, heapGroup);
+
+	if (_transientDescs.size() <= handle) {
+		_transientDescs.resize(handle + 1);
+	}
+
+	TransientResourceDesc& transientDesc = _transientDescs[handle];
+	transientDesc.desc = desc;
+	transientDesc.hasClearValue = clearValue != nullptr;
+	transientDesc.clearValue = clearValue != nullptr ? *clearValue : D3D12_CLEAR_VALUE();
+
+	return handle;
+}
+
+void RenderGraphExecutor::realize(const RenderGraph& graph) {
+	assert(graph.isCompiled() && "レンダーグラフがコンパイルされていません");
+
+	//インポートリソースの設定は残し、トランジェントリソースだけ作り直す
+	const uint32 resourceCount = graph.getResourceCount();
+	_resources.resize(resourceCount, nullptr);
+	_transientResources.clear();
+	_transientResources.resize(resourceCount);
+
+	const D3D12_HEAP_FLAGS heapFlags[HEAP_GROUP_COUNT] = {
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES
+	};
+
+	const VectorArray<uint64>& heapSizes = graph.getHeapSizes();
+	for (uint32 i = 0; i < HEAP_GROUP_COUNT; ++i) {
+		_heaps[i] = nullptr;
+		if (i >= heapSizes.size() || heapSizes[i] == 0) {
+			continue;
+		}
+
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = heapSizes[i];
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = heapFlags[i];
+		throwIfFailed(_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&_heaps[i])));
+		SetNameIndexed(_heaps[i].Get(), L"RenderGraphTransientHeap", i);
+	}
+
+	for (RenderGraphResourceHandle i = 0; i < resourceCount; ++i) {
+		const RenderGraphResourcePlacement& placement = graph.getPlacement(i);
+		if (graph.getResourceDesc(i).isImported) {
+			continue;
+		}
+
+		//どのパスからも使われなかったトランジェントリソースは生成しない
+		if (!placement.isAllocated) {
+			_resources[i] = nullptr;
+			continue;
+		}
+
+		const TransientResourceDesc& transientDesc = _transientDescs[i];
+		throwIfFailed(_device->CreatePlacedResource(
+			_heaps[placement.heapGroup].Get(),
+			placement.heapOffset,
+			&transientDesc.desc,
+			static_cast<D3D12_RESOURCE_STATES>(graph.getResourceDesc(i).initialState),
+			transientDesc.hasClearValue ? &transientDesc.clearValue : nullptr,
+			IID_PPV_ARGS(&_transientResources[i])));
+
+		_transientResources[i]->SetName(convertWString(graph.getResourceDesc(i).name).c_str());
+		_resources[i] = _transientResources[i].Get();
+	}
+}
+
+void RenderGraphExecutor::setImportedResource(RenderGraphResourceHandle resource, RefPtr<ID3D12Resource> d3dResource) {
+	if (_resources.size() <= resource) {
+		_resources.resize(resource + 1, nullptr);
+	}
+
+	_resources[resource] = d3dResource;
+}
+
+RefPtr<ID3D12Resource> RenderGraphExecutor::getResource(RenderGraphResourceHandle resource) const {
+	return _resources[resource];
+}
+
+void RenderGraphExecutor::recordPassBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const RenderGraph& graph, uint32 passIndex) const {
+	recordBarriers(commandList, graph.getPassBarriers(passIndex));
+
+	//エイリアスした直後のテクスチャは圧縮メタデータも不定なので、書き込む前に破棄して初期化する
+	//DiscardResourceはレンダーターゲット、デプス、UAVのステートでしか使えない。バッファは最初のパスがすべて書き込む
+	for (const auto& discard : graph.getPassDiscards(passIndex)) {
+		const D3D12_RESOURCE_DESC& desc = _transientDescs[discard.resource].desc;
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+			continue;
+		}
+
+		const bool isRenderTarget = discard.state == RENDER_GRAPH_STATE_RENDER_TARGET && (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) != 0;
+		const bool isDepthStencil = discard.state == RENDER_GRAPH_STATE_DEPTH_WRITE && (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0;
+		const bool isUnorderedAccess = discard.state == RENDER_GRAPH_STATE_UNORDERED_ACCESS && (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) != 0;
+		if (isRenderTarget || isDepthStencil || isUnorderedAccess) {
+			commandList->DiscardResource(_resources[discard.resource], nullptr);
+		}
+	}
+}
+
+void RenderGraphExecutor::recordFinalBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const RenderGraph& graph) const {
+	recordBarriers(commandList, graph.getFinalBarriers());
+}
+
+void RenderGraphExecutor::recordBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const VectorArray<RenderGraphBarrier>& barriers) const {
+	if (barriers.empty()) {
+		return;
+	}
+
+	VectorArray<D3D12_RESOURCE_BARRIER> d3dBarriers(barriers.size());
+	for (size_t i = 0; i < barriers.size(); ++i) {
+		const RenderGraphBarrier& barrier = barriers[i];
+		switch (barrier.type) {
+		case RenderGraphBarrierType::TRANSITION:
+			d3dBarriers[i] = LTND3D12_RESOURCE_BARRIER::transition(_resources[barrier.resource],
+				static_cast<D3D12_RESOURCE_STATES>(barrier.stateBefore),
+				static_cast<D3D12_RESOURCE_STATES>(barrier.stateAfter));
+			break;
+		case RenderGraphBarrierType::ALIASING:
+			d3dBarriers[i] = LTND3D12_RESOURCE_BARRIER::aliasing(_resources[barrier.aliasBefore], _resources[barrier.resource]);
+			break;
+		case RenderGraphBarrierType::UAV:
+			d3dBarriers[i] = LTND3D12_RESOURCE_BARRIER::uav(_resources[barrier.resource]);
+			break;
+		}
+	}
+
+	commandList->ResourceBarrier(static_cast<UINT>(d3dBarriers.size()), d3dBarriers.data());
+}
@@ -10,11 +10,11 @@ SingleMeshRenderInstance::SingleMeshRenderInstance() :_materials{}, _mtxWorld(Ma
 void SingleMeshRenderInstance::loadInstance(const String& name, const VectorArray<String>& materialNames){
 	GpuResourceManager& manager = GpuResourceManager::instance();
 	
-	//bVCX^X[h
+	//メッシュインスタンスロード
 	RefPtr<VertexAndIndexBuffer> vertexAndIndex;
 	manager.loadVertexAndIndexBuffer(name, &vertexAndIndex);
 
-	//}eAXbgɃ}eAZbg
+	//マテリアルスロットにマテリアルをセット
 	const size_t materialCount = vertexAndIndex->materialDrawRanges.size();
 	_materials.resize(materialCount);
 }
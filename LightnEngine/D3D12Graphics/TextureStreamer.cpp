@@ -0,0 +1,561 @@
+#include "TextureStreamer.h"
+#include "D3D12Helper.h"
+#include "D3D12Util.h"
+#include "DescriptorHeap.h"
+#include "Camera.h"
+#include "GraphicsConstantSettings.h"
+
+TextureStreamer* Singleton<TextureStreamer>::_singleton = 0;
+
+TextureStreamer::TextureStreamer() :_device(nullptr), _commandContext(nullptr), _pendingLoadCount(0) {
+}
+
+TextureStreamer::~TextureStreamer() {
+}
+
+void TextureStreamer::create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, uint64 budget) {
+	_device = device;
+	_commandContext = commandContext;
+	_policy.create(budget, 0.0f);
+
+	//差し替えていないテクスチャは固定インデックスのスロットをそのまま引く
+	_bindlessRemapTable.resize(BindlessDescriptorCount);
+	for (uint32 i = 0; i < BindlessDescriptorCount; ++i) {
+		_bindlessRemapTable[i] = i;
+	}
+}
+
+void TextureStreamer::shutdown() {
+	//キューに残っている読み込みを取り消し、読み込み中の要求はコールバックを抜けるまで待つ
+	IoService& ioService = IoService::instance();
+	for (const auto& streamingTexture : _textures) {
+		if (streamingTexture.isLoading) {
+			ioService.cancel(streamingTexture.loadRequestId);
+		}
+	}
+	_loadGroup.wait();
+
+	//固定インデックスのスロットはGpuResourceManagerが解除するので、差し替え後のスロットだけを解除する
+	DescriptorHeapManager& descriptorHeapManager = DescriptorHeapManager::instance();
+	for (auto& streamingTexture : _textures) {
+		if (streamingTexture.currentHandle.isValid()) {
+			descriptorHeapManager.unregisterBindless(streamingTexture.currentHandle);
+		}
+	}
+
+	//GPUの完了は呼び出し側で待っているので、退避中のテクスチャはすべて解放してよい
+	submit(0);
+	reclaim(~0ull);
+
+	_textures.clear();
+	_textureIndices.clear();
+	_loadedMips.clear();
+	_pendingLoadCount = 0;
+	_device = nullptr;
+}
+
+void TextureStreamer::prepareTextures(const VectorArray<String>& filePaths, VectorArray<PreparedTexture>& outTextures) {
+	IoService& ioService = IoService::instance();
+	const uint32 textureCount = static_cast<uint32>(filePaths.size());
+	outTextures.resize(textureCount);
+
+	//DX10拡張ヘッダーの有無で長さが変わるので、最大長まで読んで解析する。短いファイルは終端までしか読まれない
+	VectorArray<byte> isParsed(textureCount, 0);
+	IoRequestGroup headerGroup;
+	for (uint32 i = 0; i < textureCount; ++i) {
+		outTextures[i].filePath = filePaths[i];
+
+		IoReadRequest request;
+		request.filePath = filePaths[i];
+		request.size = DdsLayout::MaxHeaderSize;
+		request.priority = IO_PRIORITY_NORMAL;
+		request.callback = [&outTextures, &isParsed, i](IoReadResult& result) {
+			PreparedTexture& preparedTexture = outTextures[i];
+			if (result.isSucceeded() && preparedTexture.layout.parse(result.buffer.data(), result.buffer.size())) {
+				preparedTexture.topMip = computeMinResidentMip(preparedTexture.layout);
+				isParsed[i] = 1;
+			}
+		};
+
+		ioService.read(request, &headerGroup);
+	}
+	headerGroup.wait();
+
+	//ストリーミングするテクスチャは低解像度のミップの範囲だけを読む。それ以外とヘッダーを解析できなかったファイルは全体を読む
+	IoRequestGroup dataGroup;
+	for (uint32 i = 0; i < textureCount; ++i) {
+		PreparedTexture& preparedTexture = outTextures[i];
+		const DdsLayout& layout = preparedTexture.layout;
+
+		IoReadRequest request;
+		request.filePath = filePaths[i];
+		request.priority = IO_PRIORITY_NORMAL;
+		if (preparedTexture.topMip != InvalidMip) {
+			request.offset = layout.getSubresource(preparedTexture.topMip).offset;
+			request.size = layout.getFileSize() - request.offset;
+		}
+
+		const uint64 expectedSize = request.size;
+		request.callback = [&outTextures, i, expectedSize](IoReadResult& result) {
+			PreparedTexture& preparedTexture = outTextures[i];
+			if (!result.isSucceeded()) {
+				return;
+			}
+
+			//ヘッダーから求めたサイズに足りなければストリーミングせず、記録時にファイル全体から読み直させる
+			if (preparedTexture.topMip != InvalidMip && result.buffer.size() != expectedSize) {
+				preparedTexture.topMip = InvalidMip;
+				return;
+			}
+
+			preparedTexture.data = std::move(result.buffer);
+		};
+
+		preparedTexture.dataOffset = request.offset;
+		ioService.read(request, &dataGroup);
+	}
+	dataGroup.wait();
+
+	//ファイル全体を読めたときだけ、ヘッダーから求めた量をアップロードリングに確保する
+	for (uint32 i = 0; i < textureCount; ++i) {
+		PreparedTexture& preparedTexture = outTextures[i];
+		if (isParsed[i] && preparedTexture.data.isValid() && preparedTexture.data.size() + preparedTexture.dataOffset >= preparedTexture.layout.getFileSize()) {
+			preparedTexture.uploadSize = computeUploadSize(preparedTexture.layout, preparedTexture.topMip == InvalidMip ? 0 : preparedTexture.topMip);
+		}
+	}
+}
+
+void TextureStreamer::recordTexture(UploadContext& uploadContext, const PreparedTexture& preparedTexture, Texture2D& texture) const {
+	if (preparedTexture.topMip == InvalidMip) {
+		if (preparedTexture.data.isValid()) {
+			texture.createDeferredFromMemory(_device, uploadContext, preparedTexture.data.data(), preparedTexture.data.size());
+		}
+		else {
+			texture.createDeferredFromName(_device, uploadContext, preparedTexture.filePath);
+		}
+		return;
+	}
+
+	//読み込んだ低解像度のミップだけを転送する。詳細なミップはファイルから読んでいない
+	const DdsLayout& layout = preparedTexture.layout;
+	const uint32 topMip = preparedTexture.topMip;
+	texture.destroy();
+	createMipRange(layout, topMip, texture._resource, texture._memoryAllocation);
+	uploadMips(uploadContext, texture.get(), layout, topMip, layout.getMipCount(), preparedTexture.data.data(), preparedTexture.dataOffset, 0);
+	uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(texture.get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+}
+
+void TextureStreamer::registerTexture(const PreparedTexture& preparedTexture, Texture2D& texture) {
+	if (preparedTexture.topMip == InvalidMip) {
+		return;
+	}
+
+	const DdsLayout& layout = preparedTexture.layout;
+	const uint32 topMip = preparedTexture.topMip;
+
+	StreamingTexture streamingTexture;
+	streamingTexture.texture = &texture;
+	streamingTexture.filePath = preparedTexture.filePath;
+	streamingTexture.layout = layout;
+	streamingTexture.isPinned = false;
+	streamingTexture.isLoading = false;
+	streamingTexture.loadRequestId = INVALID_IO_REQUEST_ID;
+
+	StreamingTextureState& state = streamingTexture.state;
+	state.size = max(layout.getWidth(), layout.getHeight());
+	state.mipCount = layout.getMipCount();
+	state.minResidentMip = topMip;
+	state.residentMip = topMip;
+	state.mipSizes.resize(state.mipCount);
+	for (uint32 mip = 0; mip < state.mipCount; ++mip) {
+		state.mipSizes[mip] = layout.getSubresource(mip).size;
+	}
+
+	_textureIndices[&texture] = static_cast<uint32>(_textures.size());
+	_textures.emplace_back(std::move(streamingTexture));
+}
+
+void TextureStreamer::pinTexture(Texture2D& texture) {
+	auto itr = _textureIndices.find(&texture);
+	if (itr == _textureIndices.end()) {
+		return;
+	}
+
+	const uint32 textureIndex = itr->second;
+	StreamingTexture& streamingTexture = _textures[textureIndex];
+	if (streamingTexture.isPinned) {
+		return;
+	}
+
+	//読み込み中のミップは反映時に捨てられる。まだ読み始めていなければ取り消す
+	streamingTexture.isPinned = true;
+	if (streamingTexture.isLoading) {
+		IoService::instance().cancel(streamingTexture.loadRequestId);
+	}
+
+	const uint32 residentMip = streamingTexture.state.residentMip;
+	if (residentMip == 0) {
+		return;
+	}
+
+	//ビューの生成に間に合わせるため、ストリーミングの要求より先に読む優先度でこの場で読み込む
+	const DdsLayout& layout = streamingTexture.layout;
+	const uint64 offset = layout.getSubresource(0).offset;
+	const uint64 size = layout.getSubresource(residentMip).offset - offset;
+	IoBuffer buffer;
+	if (!IoService::instance().readBlocking(streamingTexture.filePath, offset, size, IO_PRIORITY_HIGH, buffer) || buffer.size() != size) {
+		return;
+	}
+
+	UploadContext uploadContext(_commandContext);
+	changeResidentMip(uploadContext, textureIndex, 0, buffer.data());
+	uploadContext.submit();
+}
+
+void TextureStreamer::addTextureUsage(const Texture2D& texture, const Vector3& center, float radius) {
+	auto itr = _textureIndices.find(&texture);
+	if (itr == _textureIndices.end()) {
+		return;
+	}
+
+	_textures[itr->second].usages.push_back({ center, radius });
+}
+
+void TextureStreamer::update(const Camera& camera, uint32 screenHeight) {
+	if (_textures.empty()) {
+		return;
+	}
+
+	applyLoadedMips();
+	updateScreenSizes(camera, screenHeight);
+
+	//固定したテクスチャを除いてポリシーに渡す
+	VectorArray<StreamingTextureState> states;
+	VectorArray<uint32> textureIndices;
+	states.reserve(_textures.size());
+	textureIndices.reserve(_textures.size());
+	for (uint32 i = 0; i < _textures.size(); ++i) {
+		if (!_textures[i].isPinned) {
+			states.push_back(_textures[i].state);
+			textureIndices.push_back(i);
+		}
+	}
+
+	VectorArray<uint32> targetMips;
+	VectorArray<StreamingRequest> evictions;
+	VectorArray<StreamingRequest> loads;
+	_policy.computeTargetMips(states, targetMips);
+	_policy.buildRequests(states, targetMips, TextureStreamingMaxPendingLoadCount - _pendingLoadCount, evictions, loads);
+
+	//予算を超えた分は読み込みより先に解放する。解放はファイルを読まないのでこの場で差し替える
+	bool hasEviction = false;
+	for (const auto& eviction : evictions) {
+		hasEviction |= !_textures[textureIndices[eviction.textureIndex]].isLoading;
+	}
+
+	if (hasEviction) {
+		UploadContext uploadContext(_commandContext);
+		for (const auto& eviction : evictions) {
+			const uint32 textureIndex = textureIndices[eviction.textureIndex];
+			StreamingTexture& streamingTexture = _textures[textureIndex];
+			if (streamingTexture.isLoading) {
+				continue;
+			}
+
+			_statistics.evictedMipCount += eviction.targetMip - streamingTexture.state.residentMip;
+			changeResidentMip(uploadContext, textureIndex, eviction.targetMip, nullptr);
+		}
+		uploadContext.submit();
+	}
+
+	for (const auto& load : loads) {
+		const uint32 textureIndex = textureIndices[load.textureIndex];
+		if (!_textures[textureIndex].isLoading) {
+			requestLoad(textureIndex, load.targetMip);
+		}
+	}
+}
+
+void TextureStreamer::submit(uint64 fenceValue) {
+	for (auto& retiredTexture : _unsubmittedRetiredTextures) {
+		retiredTexture.fenceValue = fenceValue;
+		_retiredTextures.push_back(std::move(retiredTexture));
+	}
+
+	_unsubmittedRetiredTextures.clear();
+}
+
+void TextureStreamer::reclaim(uint64 completedFenceValue) {
+	while (!_retiredTextures.empty() && _retiredTextures.front().fenceValue <= completedFenceValue) {
+		RetiredTexture& retiredTexture = _retiredTextures.front();
+		retiredTexture.resource = nullptr;
+		if (retiredTexture.memoryAllocation.isValid()) {
+			GpuMemoryAllocator::instance().free(retiredTexture.memoryAllocation);
+		}
+
+		_retiredTextures.pop_front();
+	}
+}
+
+void TextureStreamer::setBudget(uint64 budget) {
+	_policy.create(budget, 0.0f);
+}
+
+TextureStreamer::Statistics TextureStreamer::getStatistics() const {
+	Statistics statistics = _statistics;
+	statistics.streamingTextureCount = static_cast<uint32>(_textures.size());
+	statistics.pendingLoadCount = _pendingLoadCount;
+	statistics.retiredTextureCount = static_cast<uint32>(_retiredTextures.size() + _unsubmittedRetiredTextures.size());
+	statistics.budget = _policy.getBudget();
+
+	for (const auto& streamingTexture : _textures) {
+		if (streamingTexture.isPinned) {
+			++statistics.pinnedTextureCount;
+			continue;
+		}
+
+		statistics.residentSize += TextureStreamingPolicy::computeResidentSize(streamingTexture.state, streamingTexture.state.residentMip);
+	}
+
+	return statistics;
+}
+
+uint32 TextureStreamer::computeMinResidentMip(const DdsLayout& layout) {
+	if (!layout.isStreamable()) {
+		return InvalidMip;
+	}
+
+	//TextureStreamingMinResidentSize以下になる最初のミップまでをロード時に読む
+	uint32 topMip = 0;
+	while (topMip + 1 < layout.getMipCount()) {
+		const DdsSubresourceLayout& subresource = layout.getSubresource(topMip);
+		if (max(subresource.width, subresource.height) <= TextureStreamingMinResidentSize) {
+			break;
+		}
+
+		++topMip;
+	}
+
+	//すべて小さいテクスチャはストリーミングしても意味がない
+	if (topMip == 0) {
+		return InvalidMip;
+	}
+
+	//途中のどのミップを先頭にしてもテクスチャを作れる必要がある
+	for (uint32 mip = 0; mip <= topMip; ++mip) {
+		if (!layout.isValidTopMip(mip)) {
+			return InvalidMip;
+		}
+	}
+
+	return topMip;
+}
+
+uint64 TextureStreamer::computeUploadSize(const DdsLayout& layout, uint32 firstMip) {
+	//アップロードリングでは行ピッチが256バイト、サブリソースの先頭が512バイトにそろえられる
+	uint64 uploadSize = 0;
+	for (uint32 slice = 0; slice < layout.getArraySize(); ++slice) {
+		for (uint32 mip = firstMip; mip < layout.getMipCount(); ++mip) {
+			const DdsSubresourceLayout& subresource = layout.getSubresource(mip, slice);
+			const uint64 rowPitch = (subresource.rowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~static_cast<uint64>(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+			uploadSize += rowPitch * subresource.rowCount * subresource.depth + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+		}
+	}
+
+	return uploadSize;
+}
+
+void TextureStreamer::createMipRange(const DdsLayout& layout, uint32 topMip, ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outMemoryAllocation) const {
+	const DdsSubresourceLayout& topSubresource = layout.getSubresource(topMip);
+
+	D3D12_RESOURCE_DESC textureDesc = {};
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	textureDesc.Width = topSubresource.width;
+	textureDesc.Height = topSubresource.height;
+	textureDesc.DepthOrArraySize = 1;
+	textureDesc.MipLevels = static_cast<UINT16>(layout.getMipCount() - topMip);
+	textureDesc.Format = static_cast<DXGI_FORMAT>(layout.getFormat());
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	GpuMemoryAllocator::instance().createTexture(textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, outResource, outMemoryAllocation);
+	NAME_D3D12_OBJECT(outResource.Get());
+}
+
+void TextureStreamer::uploadMips(UploadContext& uploadContext, RefPtr<ID3D12Resource> resource, const DdsLayout& layout, uint32 firstMip, uint32 endMip,
+	const byte* data, uint64 dataOffset, uint32 firstSubresource) {
+	VectorArray<D3D12_SUBRESOURCE_DATA> subresources(endMip - firstMip);
+	for (uint32 mip = firstMip; mip < endMip; ++mip) {
+		const DdsSubresourceLayout& subresource = layout.getSubresource(mip);
+		D3D12_SUBRESOURCE_DATA& subresourceData = subresources[mip - firstMip];
+		subresourceData.pData = data + (subresource.offset - dataOffset);
+		subresourceData.RowPitch = subresource.rowPitch;
+		subresourceData.SlicePitch = static_cast<LONG_PTR>(subresource.rowPitch) * subresource.rowCount;
+	}
+
+	uploadContext.uploadTexture(resource, subresources.data(), static_cast<uint32>(subresources.size()), firstSubresource);
+}
+
+void TextureStreamer::changeResidentMip(UploadContext& uploadContext, uint32 textureIndex, uint32 newTopMip, const byte* data) {
+	StreamingTexture& streamingTexture = _textures[textureIndex];
+	Texture2D& texture = *streamingTexture.texture;
+	const DdsLayout& layout = streamingTexture.layout;
+	const uint32 oldTopMip = streamingTexture.state.residentMip;
+	const uint32 mipCount = layout.getMipCount();
+
+	ComPtr<ID3D12Resource> resource;
+	GpuMemoryAllocation memoryAllocation;
+	createMipRange(layout, newTopMip, resource, memoryAllocation);
+
+	//両方に含まれるミップはGPU上でコピーする
+	RefPtr<ID3D12GraphicsCommandList> commandList = uploadContext.getCommandList();
+	commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(texture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	for (uint32 mip = max(newTopMip, oldTopMip); mip < mipCount; ++mip) {
+		LTND3D12_TEXTURE_COPY_LOCATION dst(resource.Get(), mip - newTopMip);
+		LTND3D12_TEXTURE_COPY_LOCATION src(texture.get(), mip - oldTopMip);
+		commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+
+	//増えたミップだけをファイルの内容から転送する
+	if (newTopMip < oldTopMip) {
+		uploadMips(uploadContext, resource.Get(), layout, newTopMip, oldTopMip, data, layout.getSubresource(newTopMip).offset, 0);
+	}
+
+	uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	//古いテクスチャは処理中のフレームが参照しているので、このフレームの完了まで解放しない
+	RetiredTexture retiredTexture;
+	retiredTexture.fenceValue = 0;
+	retiredTexture.resource = std::move(texture._resource);
+	retiredTexture.memoryAllocation = texture._memoryAllocation;
+	_unsubmittedRetiredTextures.emplace_back(std::move(retiredTexture));
+
+	texture._resource = std::move(resource);
+	texture._memoryAllocation = memoryAllocation;
+
+	//処理中のフレームが参照しているスロットは書き換えられないので、新しいスロットに登録して変換表を向け直す
+	DescriptorHeapManager& descriptorHeapManager = DescriptorHeapManager::instance();
+	const BindlessHandle handle = descriptorHeapManager.registerBindlessTexture(texture.get());
+	if (streamingTexture.currentHandle.isValid()) {
+		descriptorHeapManager.unregisterBindless(streamingTexture.currentHandle);
+	}
+
+	streamingTexture.currentHandle = handle;
+	_bindlessRemapTable[texture.getBindlessIndex()] = handle.index;
+	streamingTexture.state.residentMip = newTopMip;
+}
+
+void TextureStreamer::requestLoad(uint32 textureIndex, uint32 topMip) {
+	StreamingTexture& streamingTexture = _textures[textureIndex];
+	const DdsLayout& layout = streamingTexture.layout;
+	const uint32 endMip = streamingTexture.state.residentMip;
+	const uint64 offset = layout.getSubresource(topMip).offset;
+	const uint64 size = layout.getSubresource(endMip).offset - offset;
+
+	streamingTexture.isLoading = true;
+	++_pendingLoadCount;
+
+	//遅れても粗いミップが表示されるだけなので、ロードや固定の読み込みより後に回す先読みとして出す
+	IoReadRequest request;
+	request.filePath = streamingTexture.filePath;
+	request.offset = offset;
+	request.size = size;
+	request.priority = IO_PRIORITY_LOW;
+	request.callback = [this, textureIndex, topMip, endMip, size](IoReadResult& result) {
+		LoadedMips loadedMips;
+		loadedMips.textureIndex = textureIndex;
+		loadedMips.topMip = topMip;
+		loadedMips.endMip = endMip;
+		loadedMips.size = size;
+
+		//ロード後にファイルが差し替えられて短くなっていれば失敗にする
+		loadedMips.isSucceeded = result.isSucceeded() && result.buffer.size() == size;
+		loadedMips.buffer = std::move(result.buffer);
+
+		std::lock_guard<std::mutex> lock(_loadedMipsMutex);
+		_loadedMips.emplace_back(std::move(loadedMips));
+	};
+
+	streamingTexture.loadRequestId = IoService::instance().read(request, &_loadGroup);
+}
+
+void TextureStreamer::takeLoadedMips(VectorArray<LoadedMips>& outLoadedMips) {
+	std::lock_guard<std::mutex> lock(_loadedMipsMutex);
+
+	//転送量が多すぎるとアップロードリングの待ちでフレームが止まるので、残りは次のフレームに回す
+	uint64 uploadSize = 0;
+	while (!_loadedMips.empty() && (outLoadedMips.empty() || uploadSize + _loadedMips.front().size <= TextureStreamingUploadSizePerFrame)) {
+		uploadSize += _loadedMips.front().size;
+		outLoadedMips.emplace_back(std::move(_loadedMips.front()));
+		_loadedMips.pop_front();
+	}
+}
+
+void TextureStreamer::applyLoadedMips() {
+	VectorArray<LoadedMips> loadedMipsList;
+	takeLoadedMips(loadedMipsList);
+	if (loadedMipsList.empty()) {
+		return;
+	}
+
+	UploadContext uploadContext(_commandContext);
+	for (const auto& loadedMips : loadedMipsList) {
+		StreamingTexture& streamingTexture = _textures[loadedMips.textureIndex];
+		streamingTexture.isLoading = false;
+		--_pendingLoadCount;
+
+		//読み込めなかったテクスチャは今のミップのまま固定する
+		if (!loadedMips.isSucceeded) {
+			streamingTexture.isPinned = true;
+			continue;
+		}
+
+		//待っている間に固定されたテクスチャは全ミップを読み込み済み
+		if (streamingTexture.isPinned || streamingTexture.state.residentMip != loadedMips.endMip) {
+			continue;
+		}
+
+		changeResidentMip(uploadContext, loadedMips.textureIndex, loadedMips.topMip, loadedMips.buffer.data());
+		_statistics.loadedMipCount += loadedMips.endMip - loadedMips.topMip;
+		_statistics.loadedSize += loadedMips.size;
+	}
+
+	//バッファはコピーを積み終えた時点で不要になる。ここを抜けるとIoServiceに返され、次の先読みが発行される
+	uploadContext.submit();
+}
+
+void TextureStreamer::updateScreenSizes(const Camera& camera, uint32 screenHeight) {
+	const Vector3 cameraPosition = camera.getPosition();
+	const FrustumPlanes& frustumPlanes = camera.getFrustumPlaneNormals();
+	const float tanHalfFovY = camera.getTanHeightXY().y;
+	const float screenHeightF = static_cast<float>(screenHeight);
+
+	for (auto& streamingTexture : _textures) {
+		float screenSize = 0.0f;
+		for (const auto& usage : streamingTexture.usages) {
+			const Vector3 toCenter = usage.center - cameraPosition;
+
+			//視錐台の外にある境界球は数えない。法線は内向き
+			bool isVisible = true;
+			for (uint32 i = 0; i < 4; ++i) {
+				if (Vector3::dot(frustumPlanes.normals[i], toCenter) < -usage.radius) {
+					isVisible = false;
+					break;
+				}
+			}
+
+			if (!isVisible) {
+				continue;
+			}
+
+			//UVがオブジェクト全体に1回貼られていると仮定して、境界球の画面上の直径をテクスチャの表示サイズとみなす
+			const float distance = toCenter.length();
+			const float size = distance <= usage.radius ? screenHeightF : usage.radius / (distance * tanHalfFovY) * screenHeightF;
+			screenSize = max(screenSize, size);
+		}
+
+		streamingTexture.state.screenSize = screenSize;
+	}
+}
@@ -0,0 +1,117 @@
+#include "TextureStreamingPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+TextureStreamingPolicy::TextureStreamingPolicy() :_budget(0), _mipBias(0.0f) {
+}
+
+void TextureStreamingPolicy::create(uint64 budget, float mipBias) {
+	_budget = budget;
+	_mipBias = mipBias;
+}
+
+int32 TextureStreamingPolicy::computeWantedMip(const StreamingTextureState& texture) const {
+	if (texture.screenSize <= 0.0f) {
+		return -1;
+	}
+
+	//画面上の大きさがテクスチャの半分ならミップ1で足りる
+	const float mip = std::log2(static_cast<float>(texture.size) / texture.screenSize) + _mipBias;
+	const int32 wantedMip = static_cast<int32>(std::floor(std::max(mip, 0.0f)));
+	return std::min(wantedMip, static_cast<int32>(texture.minResidentMip));
+}
+
+void TextureStreamingPolicy::computeTargetMips(const VectorArray<StreamingTextureState>& textures, VectorArray<uint32>& outTargetMips) const {
+	const uint32 textureCount = static_cast<uint32>(textures.size());
+	outTargetMips.resize(textureCount);
+
+	uint64 totalSize = 0;
+	for (uint32 i = 0; i < textureCount; ++i) {
+		const int32 wantedMip = computeWantedMip(textures[i]);
+		outTargetMips[i] = wantedMip < 0 ? textures[i].residentMip : static_cast<uint32>(wantedMip);
+		totalSize += computeResidentSize(textures[i], outTargetMips[i]);
+	}
+
+	if (totalSize <= _budget) {
+		return;
+	}
+
+	//優先度の低い順に取り出せるキュー。削ったテクスチャは次の段の優先度で入れ直す
+	struct Candidate {
+		float priority;
+		uint32 textureIndex;
+
+		bool operator<(const Candidate& other) const {
+			return priority > other.priority;
+		}
+	};
+
+	std::priority_queue<Candidate> candidates;
+	for (uint32 i = 0; i < textureCount; ++i) {
+		if (outTargetMips[i] < textures[i].minResidentMip) {
+			candidates.push({ computePriority(textures[i], outTargetMips[i]), i });
+		}
+	}
+
+	while (totalSize > _budget && !candidates.empty()) {
+		const Candidate candidate = candidates.top();
+		candidates.pop();
+
+		const StreamingTextureState& texture = textures[candidate.textureIndex];
+		uint32& targetMip = outTargetMips[candidate.textureIndex];
+
+		totalSize -= texture.mipSizes[targetMip];
+		++targetMip;
+
+		if (targetMip < texture.minResidentMip) {
+			candidates.push({ computePriority(texture, targetMip), candidate.textureIndex });
+		}
+	}
+}
+
+void TextureStreamingPolicy::buildRequests(const VectorArray<StreamingTextureState>& textures, const VectorArray<uint32>& targetMips, uint32 maxLoadCount,
+	VectorArray<StreamingRequest>& outEvictions, VectorArray<StreamingRequest>& outLoads) const {
+	outEvictions.clear();
+	outLoads.clear();
+
+	for (uint32 i = 0; i < textures.size(); ++i) {
+		const StreamingTextureState& texture = textures[i];
+		if (targetMips[i] > texture.residentMip) {
+			outEvictions.push_back({ i, targetMips[i], computePriority(texture, texture.residentMip) });
+		}
+		else if (targetMips[i] < texture.residentMip) {
+			//1段ずつ上げるので、粗いミップから順に見た目が改善していく
+			const uint32 nextMip = texture.residentMip - 1;
+			outLoads.push_back({ i, nextMip, computePriority(texture, nextMip) });
+		}
+	}
+
+	//ロードは優先度の高い順。解放は予算を空けるのが目的なので順序を問わない
+	std::sort(outLoads.begin(), outLoads.end(), [](const StreamingRequest& a, const StreamingRequest& b) {
+		return a.priority > b.priority;
+	});
+
+	if (outLoads.size() > maxLoadCount) {
+		outLoads.resize(maxLoadCount);
+	}
+}
+
+uint64 TextureStreamingPolicy::computeResidentSize(const StreamingTextureState& texture, uint32 mostDetailedMip) {
+	uint64 size = 0;
+	for (uint32 mip = mostDetailedMip; mip < texture.mipCount; ++mip) {
+		size += texture.mipSizes[mip];
+	}
+
+	return size;
+}
+
+float TextureStreamingPolicy::computePriority(const StreamingTextureState& texture, uint32 mip) {
+	if (texture.screenSize <= 0.0f) {
+		return 0.0f;
+	}
+
+	//そのミップの1テクセルが画面の何ピクセルに広がるか。1を超えていれば解像度が足りていない
+	const float mipSize = static_cast<float>(std::max(texture.size >> mip, 1u));
+	return texture.screenSize / mipSize;
+}
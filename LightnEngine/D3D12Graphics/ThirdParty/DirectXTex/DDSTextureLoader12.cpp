@@ -1015,6 +1015,7 @@ namespace
 		DXGI_FORMAT format,
 		D3D12_RESOURCE_FLAGS resFlags,
 		unsigned int loadFlags,
+		_In_opt_ const DDSResourceCreateFunc* createFunc,
 		_Outptr_ ID3D12Resource** texture) {
 		if (!d3dDevice)
 			return E_POINTER;
@@ -1036,16 +1037,21 @@ namespace
 		desc.SampleDesc.Quality = 0;
 		desc.Dimension = resDim;
 
-		//CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
-		D3D12_HEAP_PROPERTIES defaultHeapProperties = { D3D12_HEAP_TYPE_DEFAULT };
-
-        hr = d3dDevice->CreateCommittedResource(
-            &defaultHeapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &desc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(texture));
+		if (createFunc && *createFunc) {
+			hr = (*createFunc)(desc, texture);
+		}
+		else {
+			//CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+			D3D12_HEAP_PROPERTIES defaultHeapProperties = { D3D12_HEAP_TYPE_DEFAULT };
+
+			hr = d3dDevice->CreateCommittedResource(
+				&defaultHeapProperties,
+				D3D12_HEAP_FLAG_NONE,
+				&desc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(texture));
+		}
         if (SUCCEEDED(hr))
         {
             _Analysis_assume_(*texture != 0);
@@ -1066,7 +1072,8 @@ namespace
         unsigned int loadFlags,
         _Outptr_ ID3D12Resource** texture,
         VectorArray<D3D12_SUBRESOURCE_DATA>& subresources,
-        _Out_opt_ bool* outIsCubeMap)
+        _Out_opt_ bool* outIsCubeMap,
+        _In_opt_ const DDSResourceCreateFunc* createFunc)
     {
         HRESULT hr = S_OK;
 
@@ -1280,7 +1287,7 @@ namespace
             }
 
             hr = CreateTextureResource(d3dDevice, resDim, twidth, theight, tdepth, reservedMips - skipMip, arraySize,
-                format, resFlags, loadFlags, texture);
+                format, resFlags, loadFlags, createFunc, texture);
 
             if (FAILED(hr) && !maxsize && (mipCount > 1))
             {
@@ -1297,7 +1304,7 @@ namespace
                 if (SUCCEEDED(hr))
                 {
                     hr = CreateTextureResource(d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
-                        format, resFlags, loadFlags, texture);
+                        format, resFlags, loadFlags, createFunc, texture);
                 }
             }
         }
@@ -1377,7 +1384,8 @@ HRESULT DirectX::LoadDDSTextureFromMemoryEx(
     ID3D12Resource** texture,
     VectorArray<D3D12_SUBRESOURCE_DATA>& subresources,
     DDS_ALPHA_MODE* alphaMode,
-    bool* isCubeMap)
+    bool* isCubeMap,
+    const DDSResourceCreateFunc* createFunc)
 {
     if (texture)
     {
@@ -1439,7 +1447,7 @@ HRESULT DirectX::LoadDDSTextureFromMemoryEx(
     HRESULT hr = CreateTextureFromDDS(d3dDevice,
         header, ddsData + offset, ddsDataSize - offset, maxsize,
         resFlags, loadFlags,
-        texture, subresources, isCubeMap);
+        texture, subresources, isCubeMap, createFunc);
     if (SUCCEEDED(hr))
     {
         if (texture != 0 && *texture != 0)
@@ -1491,7 +1499,8 @@ HRESULT DirectX::LoadDDSTextureFromFileEx(
     UniquePtr<uint8_t[]>& ddsData,
     VectorArray<D3D12_SUBRESOURCE_DATA>& subresources,
     DDS_ALPHA_MODE* alphaMode,
-    bool* isCubeMap)
+    bool* isCubeMap,
+    const DDSResourceCreateFunc* createFunc)
 {
     if (texture)
     {
@@ -1529,7 +1538,7 @@ HRESULT DirectX::LoadDDSTextureFromFileEx(
     hr = CreateTextureFromDDS(d3dDevice,
         header, bitData, bitSize, maxsize,
         resFlags, loadFlags,
-        texture, subresources, isCubeMap);
+        texture, subresources, isCubeMap, createFunc);
 
     if (SUCCEEDED(hr))
     {
@@ -0,0 +1,252 @@
+#include "UploadRingBuffer.h"
+#include "D3D12Helper.h"
+#include "D3D12Util.h"
+
+UploadRingBuffer* Singleton<UploadRingBuffer>::_singleton = 0;
+
+UploadRingBuffer::UploadRingBuffer() :_device(nullptr), _mappedPtr(nullptr), _lastSubmittedFenceValue(0) {
+}
+
+UploadRingBuffer::~UploadRingBuffer() {
+	shutdown();
+}
+
+void UploadRingBuffer::create(RefPtr<ID3D12Device> device, uint64 size) {
+	_device = device;
+
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Width = size;
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	throwIfFailed(device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&_buffer)));
+	NAME_D3D12_OBJECT(_buffer.Get());
+
+	//アップロードヒープは開いたままでよいので破棄するまでマップし続ける
+	D3D12_RANGE readRange = { 0, 0 };
+	throwIfFailed(_buffer->Map(0, &readRange, reinterpret_cast<void**>(&_mappedPtr)));
+
+	_allocator.create(size);
+}
+
+void UploadRingBuffer::shutdown() {
+	if (_buffer != nullptr) {
+		_buffer->Unmap(0, nullptr);
+	}
+
+	_buffer = nullptr;
+	_mappedPtr = nullptr;
+}
+
+bool UploadRingBuffer::allocate(RefPtr<CommandQueue> commandQueue, uint64 size, uint64 alignment, UploadAllocation& outAllocation) {
+	assert(size <= _allocator.getCapacity() && "アップロードリングより大きい領域は確保できません");
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	while (true) {
+		_allocator.reclaim(commandQueue->fenceValue());
+
+		const uint64 offset = _allocator.allocate(size, alignment);
+		if (offset != FencedRingAllocator::InvalidOffset) {
+			outAllocation.resource = _buffer.Get();
+			outAllocation.offset = offset;
+			outAllocation.cpuAddress = _mappedPtr + offset;
+			return true;
+		}
+
+		//回収できるものがなければ未提出のデータで埋まっている
+		if (!_allocator.hasPendingSubmission()) {
+			return false;
+		}
+
+		commandQueue->waitForFence(_allocator.getOldestPendingFenceValue());
+	}
+}
+
+void UploadRingBuffer::submit(UINT64 fenceValue) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_allocator.submit(fenceValue);
+	_lastSubmittedFenceValue = fenceValue;
+}
+
+uint64 UploadRingBuffer::getMaxChunkSize() const {
+	//提出しさえすれば必ず確保できるように、アライメントのパディング分を残した大きさにする
+	return _allocator.getCapacity() / 4;
+}
+
+UINT64 UploadRingBuffer::getLastSubmittedFenceValue() const {
+	return _lastSubmittedFenceValue;
+}
+
+RefPtr<ID3D12Device> UploadRingBuffer::getDevice() const {
+	return _device;
+}
+
+FencedRingAllocator::Statistics UploadRingBuffer::getStatistics() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _allocator.getStatistics();
+}
+
+UploadContext::UploadContext(RefPtr<CommandContext> commandContext, bool isFlushEnabled) :
+	_commandContext(commandContext),
+	_commandListSet(commandContext->requestCommandListSet()),
+	_isFlushEnabled(isFlushEnabled),
+	_isSubmitted(false) {
+}
+
+UploadContext::~UploadContext() {
+	assert(_isSubmitted && "アップロードコマンドが提出されていません");
+}
+
+RefPtr<ID3D12GraphicsCommandList> UploadContext::getCommandList() const {
+	return _commandListSet.commandList;
+}
+
+void UploadContext::uploadBuffer(RefPtr<ID3D12Resource> dstResource, uint64 dstOffset, const void* srcData, uint64 size) {
+	const byte* srcPtr = reinterpret_cast<const byte*>(srcData);
+	uploadBuffer(dstResource, dstOffset, size, [&srcPtr](void* dst, uint64 chunkSize) {
+		memcpy(dst, srcPtr, static_cast<size_t>(chunkSize));
+		srcPtr += chunkSize;
+	});
+}
+
+void UploadContext::uploadBuffer(RefPtr<ID3D12Resource> dstResource, uint64 dstOffset, uint64 size, const std::function<void(void* dst, uint64 size)>& writeData) {
+	const uint64 maxChunkSize = UploadRingBuffer::instance().getMaxChunkSize() & ~3ull;
+
+	for (uint64 copiedSize = 0; copiedSize < size;) {
+		const uint64 chunkSize = min(size - copiedSize, maxChunkSize);
+		UploadAllocation allocation = allocate(chunkSize, 4);
+
+		writeData(allocation.cpuAddress, chunkSize);
+		_commandListSet.commandList->CopyBufferRegion(dstResource, dstOffset + copiedSize, allocation.resource, allocation.offset, chunkSize);
+		copiedSize += chunkSize;
+	}
+}
+
+void UploadContext::uploadTexture(RefPtr<ID3D12Resource> dstResource, const D3D12_SUBRESOURCE_DATA* subresources, uint32 subresourceCount, uint32 firstSubresource) {
+	RefPtr<ID3D12Device> device = UploadRingBuffer::instance().getDevice();
+	const uint64 maxChunkSize = UploadRingBuffer::instance().getMaxChunkSize();
+	const D3D12_RESOURCE_DESC desc = dstResource->GetDesc();
+
+	for (uint32 i = 0; i < subresourceCount; ++i) {
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+		UINT rowCount = 0;
+		UINT64 rowSize = 0;
+		const uint32 subresourceIndex = firstSubresource + i;
+		device->GetCopyableFootprints(&desc, subresourceIndex, 1, 0, &footprint, &rowCount, &rowSize, nullptr);
+
+		//ブロック圧縮フォーマットは1行が4ピクセル分になる
+		const uint32 depth = footprint.Footprint.Depth;
+		const uint32 rowPitch = footprint.Footprint.RowPitch;
+		const uint32 blockHeight = max(footprint.Footprint.Height / rowCount, 1u);
+		const uint32 maxRowsPerChunk = static_cast<uint32>(max(maxChunkSize / (static_cast<uint64>(rowPitch) * depth), 1ull));
+
+		for (uint32 row = 0; row < rowCount;) {
+			const uint32 chunkRowCount = min(rowCount - row, maxRowsPerChunk);
+			UploadAllocation allocation = allocate(static_cast<uint64>(rowPitch) * chunkRowCount * depth, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+			//サブリソースのピッチからアップロードヒープのピッチに詰め替え
+			for (uint32 z = 0; z < depth; ++z) {
+				const byte* srcSlice = reinterpret_cast<const byte*>(subresources[i].pData) + subresources[i].SlicePitch * z;
+				byte* dstSlice = reinterpret_cast<byte*>(allocation.cpuAddress) + static_cast<uint64>(rowPitch) * chunkRowCount * z;
+				for (uint32 y = 0; y < chunkRowCount; ++y) {
+					memcpy(dstSlice + static_cast<uint64>(rowPitch) * y, srcSlice + subresources[i].RowPitch * (row + y), static_cast<size_t>(rowSize));
+				}
+			}
+
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT chunkFootprint = footprint;
+			chunkFootprint.Offset = allocation.offset;
+			chunkFootprint.Footprint.Height = min(chunkRowCount * blockHeight, footprint.Footprint.Height - row * blockHeight);
+
+			LTND3D12_TEXTURE_COPY_LOCATION dst(dstResource, subresourceIndex);
+			LTND3D12_TEXTURE_COPY_LOCATION src(allocation.resource, chunkFootprint);
+			_commandListSet.commandList->CopyTextureRegion(&dst, 0, row * blockHeight, 0, &src, nullptr);
+
+			row += chunkRowCount;
+		}
+	}
+}
+
+UINT64 UploadContext::submit() {
+	_commandContext->executeCommandList(_commandListSet);
+	UploadRingBuffer::instance().submit(_commandListSet.fenceValue);
+	_commandContext->discardCommandListSet(_commandListSet);
+
+	_isSubmitted = true;
+	return _commandListSet.fenceValue;
+}
+
+UploadAllocation UploadContext::allocate(uint64 size, uint64 alignment) {
+	UploadRingBuffer& uploadRingBuffer = UploadRingBuffer::instance();
+	RefPtr<CommandQueue> commandQueue = _commandContext->getCommandQueue();
+
+	UploadAllocation allocation = {};
+	if (!uploadRingBuffer.allocate(commandQueue, size, alignment, allocation)) {
+		//バッチのコンテキストは途中で提出しない約束なので、提出せずにリングの容量不足として止める
+		if (!_isFlushEnabled) {
+			assert(false && "バッチのアップロードがリングに収まりません");
+			throwIfFailed(E_OUTOFMEMORY);
+		}
+
+		//未提出のコピーでリングが埋まったので、ここまでを提出して完了を待てるようにする
+		flush();
+
+		//空のリングにも収まらない大きさなら、ヌルのアドレスを返さずに止める
+		if (!uploadRingBuffer.allocate(commandQueue, size, alignment, allocation)) {
+			assert(false && "アップロードリングの確保に失敗しました");
+			throwIfFailed(E_OUTOFMEMORY);
+		}
+	}
+
+	return allocation;
+}
+
+void UploadContext::flush() {
+	submit();
+	_commandListSet = _commandContext->requestCommandListSet();
+	_isSubmitted = false;
+}
+
+UploadBatch::UploadBatch(RefPtr<CommandContext> commandContext, uint32 contextCount) :_commandContext(commandContext) {
+	_contexts.resize(contextCount);
+	for (uint32 i = 0; i < contextCount; ++i) {
+		_contexts[i] = makeUnique<UploadContext>(commandContext, false);
+	}
+}
+
+UploadBatch::~UploadBatch() {
+}
+
+UploadContext& UploadBatch::getContext(uint32 index) {
+	return *_contexts[index];
+}
+
+UINT64 UploadBatch::submit() {
+	const uint32 contextCount = static_cast<uint32>(_contexts.size());
+	VectorArray<CommandListSet> commandListSets;
+	commandListSets.reserve(contextCount);
+	for (uint32 i = 0; i < contextCount; ++i) {
+		commandListSets.push_back(_contexts[i]->_commandListSet);
+	}
+
+	_commandContext->executeCommandLists(commandListSets.data(), contextCount);
+
+	const UINT64 fenceValue = commandListSets[0].fenceValue;
+	UploadRingBuffer::instance().submit(fenceValue);
+
+	for (uint32 i = 0; i < contextCount; ++i) {
+		_contexts[i]->_commandListSet.fenceValue = fenceValue;
+		_commandContext->discardCommandListSet(commandListSets[i]);
+		_contexts[i]->_isSubmitted = true;
+	}
+
+	return fenceValue;
+}
+
+uint64 UploadBatch::getMaxBatchSize() {
+	//折り返しで末尾に残る余りは最大でも1回の確保分なので、半分までなら記録中に提出しなくても必ず確保できる
+	return UploadRingBuffer::instance().getMaxChunkSize() * 2;
+}
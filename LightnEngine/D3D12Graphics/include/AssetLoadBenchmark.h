@@ -0,0 +1,39 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+
+class AssetArchive;
+
+struct AssetLoadBenchmarkResult {
+	uint32 fileCount = 0;
+	uint32 compressedCount = 0;
+	uint64 totalSize = 0;
+	uint64 storedSize = 0;
+
+	//システムのファイルキャッシュを通さずに読む。起動直後のキャッシュが空の状態に近い
+	float coldLooseSeconds = 0.0f;
+	float coldArchiveSeconds = 0.0f;
+
+	//キャッシュに載った状態でマップし、全ページに触れる。2回目以降の起動に近い
+	float warmLooseSeconds = 0.0f;
+	float warmArchiveSeconds = 0.0f;
+
+	//アーカイブの内容が個別のファイルと一致したか
+	bool isValid = false;
+};
+
+//アーカイブに入れたファイルを、個別のファイルを開く経路とアーカイブから読む経路で読み、起動時のロードにかかる時間を比べる
+//アーカイブにあって個別のファイルもあるものだけを対象にし、圧縮したエントリーは展開の時間も含める。GPUへの転送は含まない
+class AssetLoadBenchmark {
+public:
+	static AssetLoadBenchmarkResult run(const String& archivePath, const String& directory);
+
+private:
+	//キャッシュを通さずにファイル全体を読む。読み込み先はセクタに揃えたバッファ
+	static bool readUnbuffered(HANDLE file, uint64 offset, uint64 size, VectorArray<byte>& buffer, byte*& outData);
+	static bool loadLooseCold(const String& filePath, VectorArray<byte>& buffer);
+	static bool loadArchiveCold(const String& archivePath, const VectorArray<uint32>& entryIndices, VectorArray<byte>& buffer);
+	static bool loadLooseWarm(const String& filePath);
+	static bool loadArchiveWarm(const String& archivePath, const VectorArray<String>& entryPaths);
+};
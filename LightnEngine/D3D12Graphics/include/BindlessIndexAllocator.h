@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Utility.h>
+
+//バインドレステーブルのスロット。シェーダーにはindexだけを渡す
+//generationはスロットを再利用するたびに進むので、解放済みのハンドルを使い続けていないかを検出できる
+struct BindlessHandle {
+	static constexpr uint32 InvalidIndex = 0xffffffff;
+
+	uint32 index = InvalidIndex;
+	uint32 generation = 0;
+
+	bool isValid() const { return index != InvalidIndex; }
+};
+
+//バインドレステーブルのインデックスを管理する
+//解放したインデックスはGPUが参照し終えるまで再利用できないので、FencedRingAllocatorと同じくsubmitでフェンス値に紐づけ、reclaimで回収する
+//D3D12に依存しないのでフェンスを模擬して検証できる
+class BindlessIndexAllocator {
+public:
+	struct Statistics {
+		uint32 capacity = 0;
+		uint32 liveCount = 0;
+		uint32 peakLiveCount = 0;
+		uint32 pendingFreeCount = 0;
+		uint64 failedAllocationCount = 0;
+	};
+
+	BindlessIndexAllocator();
+
+	void create(uint32 capacity);
+
+	//空きがなければ無効なハンドルを返す
+	BindlessHandle allocate();
+
+	//世代を進めてから解放待ちに入れる。インデックスが再利用されるのはsubmitしたフェンスの完了後
+	//解放済みや世代の古いハンドルは何もしない
+	void free(const BindlessHandle& handle);
+
+	//前回のsubmit以降に解放したインデックスを、このフェンス値の完了で再利用できるものとして登録
+	void submit(uint64 fenceValue);
+
+	//完了したフェンス値までの解放待ちを空きリストに戻す
+	void reclaim(uint64 completedFenceValue);
+
+	//ハンドルがまだ生きているスロットを指しているか
+	bool isAlive(const BindlessHandle& handle) const;
+
+	uint32 getCapacity() const { return static_cast<uint32>(_generations.size()); }
+
+	//一度でも確保したことのあるインデックスの範囲。インデックスで引く表はこの長さがあれば足りる
+	uint32 getUsedRange() const { return _nextUnusedIndex; }
+	const Statistics& getStatistics() const { return _statistics; }
+
+private:
+	struct PendingFree {
+		uint64 fenceValue;
+		uint32 index;
+	};
+
+	VectorArray<uint32> _generations;
+	VectorArray<bool> _isAlive;
+
+	//再利用できるインデックス。一度も使っていない末尾はまとめて_nextUnusedIndexで管理する
+	VectorArray<uint32> _freeIndices;
+	uint32 _nextUnusedIndex;
+
+	VectorArray<uint32> _unsubmittedFrees;
+	DequeArray<PendingFree> _pendingFrees;
+
+	Statistics _statistics;
+};
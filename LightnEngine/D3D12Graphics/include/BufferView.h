@@ -1,30 +1,46 @@
 #pragma once
 #include <d3d12.h>
 #include <Utility.h>
+#include <TlsfAllocator.h>
 
-//obt@r[QƗpRs[Aobt@r[̂̎͊ǗȂ
+//デスクリプタヒープ上の確保位置。pageはステージングヒープのページ番号で、シェーダー可視ヒープでは常に0
+struct DescriptorAllocation {
+	uint32 page = 0;
+	TlsfAllocator::Allocation block;
+
+	bool isValid() const { return block.isValid(); }
+};
+
+//バッファビュー参照用コピー、バッファビュー自体の寿命は管理しない
+//gpuHandleが無効な場合はシェーダー可視ヒープの永続領域に載っていないので、描画時にcpuHandleからリングへコピーして使う
 struct RefBufferView {
-	RefBufferView() {}
-	RefBufferView(D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle) : gpuHandle(gpuHandle) {}
+	RefBufferView() :gpuHandle(), cpuHandle(), descriptorCount(0) {}
+	RefBufferView(D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle, D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle, uint32 descriptorCount) :
+		gpuHandle(gpuHandle), cpuHandle(cpuHandle), descriptorCount(descriptorCount) {}
 
-	inline constexpr bool isEnable() const { return gpuHandle.ptr != 0; }
+	inline constexpr bool isEnable() const { return gpuHandle.ptr != 0 || cpuHandle.ptr != 0; }
+	inline constexpr bool isResident() const { return gpuHandle.ptr != 0; }
 
 	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
+	uint32 descriptorCount;
 };
 
-//obt@[r[{́A̖{̂̂݃obt@r[̔jł
+//バッファービュー本体、この本体のみバッファビューの破棄ができる
+//cpuHandleはCPU専用のステージングヒープ、gpuHandleはシェーダー可視ヒープの永続領域を指す
 struct BufferView :private NonCopyable {
-	BufferView() :cpuHandle(), gpuHandle(), location(0), size(0) {}
+	BufferView() :cpuHandle(), gpuHandle(), size(0) {}
 	virtual ~BufferView() {}
 
-	inline bool isEnable() const { return cpuHandle.ptr != 0 && gpuHandle.ptr != 0 && location != 0 && size != 0; }
+	inline bool isEnable() const { return cpuHandle.ptr != 0 && size != 0; }
 
 	RefBufferView getRefBufferView() const {
-		return RefBufferView(gpuHandle);
+		return RefBufferView(gpuHandle, cpuHandle, size);
 	}
 
 	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
 	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
-	ulong2 location;
+	DescriptorAllocation stagingAllocation;
+	DescriptorAllocation persistentAllocation;
 	uint32 size;
 };
\ No newline at end of file
@@ -8,14 +8,14 @@ struct FrustumPlanes {
 	Vector3 normals[4];
 };
 
-//_VF[_[ŃJƂ̍\
+//頂点シェーダーでカメラ情報を扱うときの構造体
 struct CameraConstantBuffer {
 	Matrix4 mtxView;
 	Matrix4 mtxProj;
 	Vector3 cameraPosition;
 };
 
-//tp@ړ悤
+//平衡光源用　移動しようね
 struct DirectionalLightConstantBuffer {
 	float intensity;
 	Vector3 direction;
@@ -41,10 +41,10 @@ public:
 		_farZ(0) {
 	}
 
-	//pݒ(fO[)
+	//視野角を設定(デグリー)
 	void setFieldOfView(float fieldOfViewDegree);
 
-	//Əc̉𑜓xAXyNgvZ
+	//横幅と縦の解像度からアスペクト比を計算
 	void setAspectRate(uint32 width, uint32 height);
 	void setAspectRate(float aspectRate);
 
@@ -56,27 +56,27 @@ public:
 
 	void setRotation(const Quaternion& rotation);
 
-	//IC[px]ݒ
+	//オイラー角度から回転を設定
 	void setRotationEuler(float x, float y, float z, float isRadian = false);
 
-	//ˉeϊs𐶐
+	//射影変換行列を生成
 	void computeProjectionMatrix();
 
-	//r[svZ
+	//ビュー行列を計算
 	void computeViewMatrix();
 
-	//䕽ʂ̖@xNg݂̃r[s񂩂vZ
+	//視錐台平面の法線ベクトルを現在のビュー行列から計算する
 	void computeFlustomNormals();
 
 	void debugDrawFlustom();
 
-	//]uς݃r[s擾
+	//転置済みビュー行列を取得
 	Matrix4 getViewMatrixTransposed() const;
 
-	//]uς݃vWFNVs擾
+	//転置済みプロジェクション行列を取得
 	Matrix4 getProjectionMatrixTransposed() const;
 
-	//J擾
+	//カメラ情報を取得
 	Matrix4 getViewMatrix() const;
 	Matrix4 getProjectionMatrix() const;
 	Vector3 getPosition() const;
@@ -84,14 +84,14 @@ public:
 	float getFarZ() const;
 	float getNearZ() const;
 
-	//䕽ʂ̖@xNg擾
+	//視錐台平面の法線ベクトルを取得
 	const FrustumPlanes& getFrustumPlaneNormals() const;
 	Vector3 getFrustumPlaneNormal(uint32 index) const;
 
-	//݂FOVɂ1/Tan(fov/2)擾
+	//現在のFOVにおける1/Tan(fov/2)を取得する
 	Vector2 getTanHeightXY() const;
 
-	//VF[_[ŎgJ\̃f[^擾
+	//シェーダーで使うカメラ構造体データを取得
 	CameraConstantBuffer getCameraConstantBuffer() const;
 
 private:
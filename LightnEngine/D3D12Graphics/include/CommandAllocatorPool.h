@@ -2,29 +2,35 @@
 
 #include "stdafx.h"
 #include <Utility.h>
-#include <queue>
+#include "FencedObjectPool.h"
 
+class CommandQueue;
+
+//複数スレッドからの要求・返却はFencedObjectPoolが保護する。フェンスの完了待ちはロックを外して行う
 class CommandAllocatorPool {
 public:
 	CommandAllocatorPool();
 	~CommandAllocatorPool();
 
-	void create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type);
+	void create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, uint32 maxAllocatorCount);
 	void shutdown();
 
-	//ɎsĂAP[^[v
-	RefPtr<ID3D12CommandAllocator> requestAllocator(UINT64 completedFenceValue);
+	//既に実行完了しているアロケーターを要求
+	//プールが上限に達している場合は最も古いアロケーターの完了をキューのフェンスで待つ
+	RefPtr<ID3D12CommandAllocator> requestAllocator(RefPtr<CommandQueue> commandQueue);
 
-	//sAP[^ԋp
+	//実行完了したアロケータを返却
 	void discardAllocator(UINT64 fenceValue, RefPtr<ID3D12CommandAllocator> allocator);
 
-	//AP[^[v[̗vf
-	inline size_t size() { return _commandAllocatorPool.size(); }
+	//アロケータープールの要素数
+	size_t size();
+
+	//再利用状況の統計
+	FencedPoolStatistics getStatistics();
 
 private:
 	D3D12_COMMAND_LIST_TYPE _commandListType;
 
 	RefPtr<ID3D12Device> _device;
-	VectorArray<ID3D12CommandAllocator*> _commandAllocatorPool;
-	std::queue<std::pair<UINT64, RefPtr<ID3D12CommandAllocator>>> _readyAllocators;
-};
\ No newline at end of file
+	FencedObjectPool<RefPtr<ID3D12CommandAllocator>> _allocatorPool;
+};
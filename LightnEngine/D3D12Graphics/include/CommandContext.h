@@ -26,23 +26,31 @@ public:
 	void create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type);
 	void shutdown();
 
-	//R}hɕKvȃR}hXgAAP[^[̃f[^擾
-	//̃pCvCXe[ǵAvR}hXg̃pCvCXe[ĝ݂gpȂȂǃhCoœKłꍇɎw肷B
-	//ႦBundlê݂̕`sB(https://docs.microsoft.com/en-us/windows/desktop/api/d3d12/nf-d3d12-id3d12graphicscommandlist-reset)
+	//コマンド発効に必要なコマンドリスト、アロケーター等のデータを取得
+	//引数のパイプラインステートは、要求コマンドリストが引数のパイプラインステートのみしか使用しないなどドライバが最適化できる場合に指定する。
+	//例えばBundleのみの描画を行う時。(https://docs.microsoft.com/en-us/windows/desktop/api/d3d12/nf-d3d12-id3d12graphicscommandlist-reset)
+	//プールはスレッドセーフなのでワーカースレッドから要求・返却してよい
 	CommandListSet requestCommandListSet(RefPtr<ID3D12PipelineState> state = nullptr);
 
-	//R}hXgZbg̃R}hXgƃR}hAP[^[ԋp
+	//コマンドリストセットのコマンドリストとコマンドアロケーターを返却する
 	void discardCommandListSet(const CommandListSet& set);
 
-	//R}hXgR}hL[ɓnĎsB߂l͓nR}hXg̃tFXl
+	//コマンドリストをコマンドキューに渡して実行する。戻り値は渡したコマンドリストのフェンス値
 	UINT64 executeCommandList(RefPtr<ID3D12GraphicsCommandList> commandList);
 
-	//R}hXgZbg̃tFXlCNgs
+	//コマンドリストセットのフェンス値インクリメントも行う
 	void executeCommandList(CommandListSet& set);
 
-	//ׂẴR}hL[܂őҋ@
+	//複数のコマンドリストセットをまとめて実行し、すべてのセットに同じフェンス値を設定する
+	void executeCommandLists(CommandListSet* sets, uint32 setCount);
+
+	//すべてのコマンドキューが完了するまで待機
 	void waitForIdle();
 
+	//コマンドアロケーター・コマンドリストの再利用状況
+	FencedPoolStatistics getCommandAllocatorStatistics();
+	FencedPoolStatistics getCommandListStatistics();
+
 	RefPtr<CommandQueue> getCommandQueue();
 	RefPtr<ID3D12CommandQueue> getDirectQueue() const;
 
@@ -1,30 +1,36 @@
 #pragma once
 
 #include "stdafx.h"
-#include <queue>
 #include "Utility.h"
+#include "FencedObjectPool.h"
 
+class CommandQueue;
+
+//複数スレッドからの要求・返却はFencedObjectPoolが保護する。フェンスの完了待ちはロックを外して行う
 class CommandListPool {
 public:
 	CommandListPool();
 	~CommandListPool();
 
-	void create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type);
+	void create(RefPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, uint32 maxCommandListCount);
 	void shutdown();
 
-	//ɎsĂR}hXgv
-	RefPtr<ID3D12GraphicsCommandList> requestCommandList(UINT64 completedFenceValue, RefPtr<ID3D12CommandAllocator> allocator);
+	//既に実行完了しているコマンドリストを要求
+	RefPtr<ID3D12GraphicsCommandList> requestCommandList(RefPtr<CommandQueue> commandQueue, RefPtr<ID3D12CommandAllocator> allocator);
 
-	//sR}hXgԋp
+	//実行完了したコマンドリストを返却
+	//コマンドリストはExecuteCommandListsに渡した直後からリセットできるので、実行済みなら0を渡してよい
 	void discardCommandList(UINT64 fenceValue, RefPtr<ID3D12GraphicsCommandList> list);
 
-	//AP[^[v[̗vf
-	inline size_t getSize() const;
+	//コマンドリストプールの要素数
+	size_t getSize();
+
+	//再利用状況の統計
+	FencedPoolStatistics getStatistics();
 
 private:
 	D3D12_COMMAND_LIST_TYPE _commandListType;
 
 	RefPtr<ID3D12Device> _device;
-	VectorArray<ID3D12GraphicsCommandList*> _commandListPool;
-	std::queue<std::pair<UINT64, RefPtr<ID3D12GraphicsCommandList>>> _readyCommandLists;
-};
\ No newline at end of file
+	FencedObjectPool<RefPtr<ID3D12GraphicsCommandList>> _commandListPool;
+};
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "stdafx.h"
-#include "CommandAllocatorPool.h"
 #include <Utility.h>
+#include <atomic>
 class GpuResource;
 
 using namespace Microsoft::WRL;
@@ -16,20 +16,27 @@ public:
 	void waitForFence(UINT64 fenceValue);
 	void waitForIdle();
 	bool isFenceComplete(UINT64 fenceValue);
+
+	//別キューのフェンスが指定値に達するまでGPU上でこのキューを待機させる(CPUはブロックしない)
+	void waitForQueue(RefPtr<CommandQueue> queue, UINT64 fenceValue);
+
 	UINT64 incrementFence();
 	UINT64 executeCommandList(RefPtr<ID3D12CommandList> commandList);
 
+	//複数のコマンドリストを1回のExecuteCommandListsでまとめて実行する。戻り値は全コマンドリスト完了時のフェンス値
+	UINT64 executeCommandLists(RefPtr<ID3D12CommandList>* commandLists, uint32 commandListCount);
+
 	UINT64 fenceValue() const;
 
 	void shutdown();
 
 private:
-	CommandAllocatorPool _commandAllocatorPool;
+	void updateLastFenceValue(UINT64 fenceValue);
+
 	GETSET(ID3D12CommandQueue*, commandQueue);
 	GETSET(UINT64, nextFenceValue);
 
 	D3D12_COMMAND_LIST_TYPE _commandListType;
-	UINT64 _lastFenceValue;
+	std::atomic<UINT64> _lastFenceValue;
 	ID3D12Fence* _fence;
-	HANDLE _fenceEvent;
 };
\ No newline at end of file
@@ -25,7 +25,7 @@ inline void throwIfFailed(HRESULT hr) {
 	}
 }
 
-//g|W[̎ނg|W[̃^Cvɕϊ(TriangleList, TriangleStrip  TypeTriangle)
+//トポロジーの種類からトポロジーのタイプに変換(TriangleList, TriangleStrip → TypeTriangle)
 inline D3D12_PRIMITIVE_TOPOLOGY_TYPE castTopologyToType(D3D_PRIMITIVE_TOPOLOGY topology) {
 	switch (topology) {
 		case D3D_PRIMITIVE_TOPOLOGY_LINELIST: return D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; break;
@@ -54,7 +54,7 @@ inline void SetNameIndexed(ID3D12Object* pObject, LPCWSTR name, UINT index) {}
 #define NAME_D3D12_OBJECT(x) SetName(x, L#x)
 #define NAME_D3D12_OBJECT_INDEXED(x, n) SetNameIndexed((x)[n], L#x, n)
 
-//UAVJE^𓯂obt@Ɋ܂߂Bobt@4KɃAC
+//UAVカウンタを同じバッファ内に含める。バッファを4Kにアラインする
 inline constexpr UINT AlignForUavCounter(UINT bufferSize){
 	const UINT alignment = D3D12_UAV_COUNTER_PLACEMENT_ALIGNMENT;
 	return (bufferSize + (alignment - 1)) & ~(alignment - 1);
@@ -20,7 +20,7 @@ constexpr D3D12_STATIC_SAMPLER_DESC WrapSamplerDesc() {
 	return samplerDesc;
 }
 
-//q[v
+//ヒープ属性
 struct LTND3D12_HEAP_PROPERTIES :public D3D12_HEAP_PROPERTIES {
 	LTND3D12_HEAP_PROPERTIES() = default;
 	explicit LTND3D12_HEAP_PROPERTIES(const D3D12_HEAP_PROPERTIES& o) :D3D12_HEAP_PROPERTIES(o) {}
@@ -49,7 +49,7 @@ struct LTND3D12_HEAP_PROPERTIES :public D3D12_HEAP_PROPERTIES {
 	}
 };
 
-//\[XoA
+//リソースバリア
 struct LTND3D12_RESOURCE_BARRIER :public D3D12_RESOURCE_BARRIER {
 	LTND3D12_RESOURCE_BARRIER() = default;
 	explicit LTND3D12_RESOURCE_BARRIER(const D3D12_RESOURCE_BARRIER& o) :D3D12_RESOURCE_BARRIER(o) {}
@@ -93,7 +93,7 @@ struct LTND3D12_RESOURCE_BARRIER :public D3D12_RESOURCE_BARRIER {
 	}
 };
 
-//eNX`Rs[p̒`
+//テクスチャコピー用の定義
 struct LTND3D12_TEXTURE_COPY_LOCATION :public D3D12_TEXTURE_COPY_LOCATION {
 	LTND3D12_TEXTURE_COPY_LOCATION() = default;
 
@@ -163,7 +163,7 @@ inline UINT64 updateSubresources(
 		return 0;
 	}
 
-	//Rs[s
+	//メモリコピー実行
 	for (UINT i = 0; i < numSubresources; ++i) {
 		if (pRowSizesInBytes[i] > SIZE_T(-1)) {
 			return 0;
@@ -188,7 +188,7 @@ inline UINT64 updateSubresources(
 	return requiredSize;
 }
 
-//q[v̈VɊmۂĂXV
+//ヒープ領域を新たに確保してから更新
 inline UINT64 updateSubresources(
 	_In_ ID3D12GraphicsCommandList * pCmdList,
 	_In_ ID3D12Resource * pDestinationResource,
@@ -224,7 +224,7 @@ inline UINT64 updateSubresources(
 	return result;
 }
 
-//X^bN̈悩XV
+//スタック領域から更新
 template<UINT MaxSubresources>
 inline UINT64 updateSubresources(
 	_In_ ID3D12GraphicsCommandList * pCmdList,
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Utility.h>
+
+//DDSファイル内のサブリソース1つ分の配置
+struct DdsSubresourceLayout {
+	uint64 offset = 0;
+	uint64 size = 0;
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 depth = 0;
+
+	//ブロック圧縮フォーマットは4x4ピクセルで1行
+	uint32 rowPitch = 0;
+	uint32 rowCount = 0;
+};
+
+//DDSのヘッダーだけを解析して、各ミップがファイルのどこにあるかを求める
+//ファイル全体を読まずに一部のミップだけをロードするために使う。D3D12に依存しないので単体で検証できる
+class DdsLayout {
+public:
+	//マジック + DDS_HEADER + DDS_HEADER_DXT10
+	static constexpr uint32 MaxHeaderSize = 4 + 124 + 20;
+
+	DdsLayout();
+
+	//ファイル先頭のバイト列を解析する。対応していないフォーマットや壊れたヘッダーならfalse
+	bool parse(const void* headerData, uint64 headerDataSize);
+
+	//ブロック圧縮フォーマットならブロック1つのバイト数、そうでなければ0
+	static uint32 getBlockSize(uint32 dxgiFormat);
+
+	//非圧縮フォーマットの1ピクセルのビット数。対応していなければ0
+	static uint32 getBitsPerPixel(uint32 dxgiFormat);
+
+	const DdsSubresourceLayout& getSubresource(uint32 mipLevel, uint32 arraySlice = 0) const {
+		return _subresources[arraySlice * _mipCount + mipLevel];
+	}
+
+	//firstMip以降の全ミップ(全スライス)のバイト数
+	uint64 getMipChainSize(uint32 firstMip) const;
+
+	//ミップを個別に読み込めるか。2Dの単一テクスチャで、ミップが2つ以上あるもの
+	bool isStreamable() const;
+
+	//このミップを先頭にしたテクスチャを生成できるか。ブロック圧縮フォーマットは先頭ミップの幅と高さが4の倍数である必要がある
+	bool isValidTopMip(uint32 mipLevel) const;
+
+	uint32 getWidth() const { return _width; }
+	uint32 getHeight() const { return _height; }
+	uint32 getDepth() const { return _depth; }
+	uint32 getMipCount() const { return _mipCount; }
+	uint32 getArraySize() const { return _arraySize; }
+	uint32 getFormat() const { return _format; }
+	bool isCubeMap() const { return _isCubeMap; }
+
+	//ピクセルデータの先頭位置
+	uint64 getDataOffset() const { return _dataOffset; }
+	uint64 getFileSize() const { return _fileSize; }
+
+private:
+	void computeSubresources();
+
+	uint32 _width;
+	uint32 _height;
+	uint32 _depth;
+	uint32 _mipCount;
+	uint32 _arraySize;
+	uint32 _format;
+	bool _isCubeMap;
+	uint64 _dataOffset;
+	uint64 _fileSize;
+
+	//スライスごとにミップが並ぶDDSの格納順
+	VectorArray<DdsSubresourceLayout> _subresources;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+
+struct DdsLoadBenchmarkResult {
+	uint32 fileCount = 0;
+	uint64 totalSize = 0;
+
+	//ファイル全体をバッファに読んでからコピーする従来の経路
+	float readSeconds = 0.0f;
+
+	//マップした領域から直接コピーする経路
+	float mappedSeconds = 0.0f;
+
+	float getReadThroughput() const { return readSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / readSeconds : 0.0f; }
+	float getMappedThroughput() const { return mappedSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / mappedSeconds : 0.0f; }
+};
+
+//フォルダ内のブロック圧縮DDSを2つの経路で読み込み、CPU側のロードのスループットを比べる
+//各サブリソースを256バイトピッチに詰め替えてアップロードバッファ相当のメモリに書き込むところまでを計測し、GPUへの転送は含まない
+//初回の読み込みでページキャッシュに載せてから計測するので、ディスク速度ではなくコピーの回数の差が出る
+class DdsLoadBenchmark {
+public:
+	static DdsLoadBenchmarkResult run(const String& directory);
+
+private:
+	static bool loadWithRead(const String& filePath, VectorArray<byte>& fileData, VectorArray<byte>& uploadData);
+	static bool loadWithMapping(const String& filePath, VectorArray<byte>& uploadData);
+
+	//サブリソースをアップロードバッファのピッチに詰め替えてコピーする
+	static bool copyToUploadData(const void* fileData, uint64 fileSize, VectorArray<byte>& uploadData);
+};
@@ -38,12 +38,12 @@ struct DebugCapsuleVertex {
 	float height;
 };
 
-//fobO`NX@obNobt@Ƃ̓I_obt@Ă
+//デバッグ描画基底クラス　バックバッファごとの動的頂点バッファを持っている
 class DebugRender :private NonCopyable {
 public:
 	virtual ~DebugRender();
 
-	//CX^Xobt@Ƀf[^
+	//インスタンスバッファにデータを書き込み
 	void writeBufferDara(uint32 frameIndex, void* srcPtr, size_t bufferLength);
 	virtual void destroy();
 
@@ -53,7 +53,7 @@ protected:
 	VertexBufferDynamic _perInstanceData[FrameCount];
 };
 
-//fobOC[C`NX
+//デバッグワイヤーライン描画クラス
 class DebugLineRender :public DebugRender{
 public:
 	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext);
@@ -61,7 +61,7 @@ public:
 	void destroy() override;
 };
 
-//fobOC[L[u`NX
+//デバッグワイヤーキューブ描画クラス
 class DebugCubeRender :public DebugRender{
 public:
 	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext);
@@ -72,7 +72,7 @@ private:
 	VertexBuffer _geometryVertexBuffer;
 };
 
-//fobOC[XtBA`NX
+//デバッグワイヤースフィア描画クラス
 class DebugSphereRender :public DebugRender {
 public:
 	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext);
@@ -83,7 +83,7 @@ private:
 	VertexBuffer _geometryVertexBuffer;
 };
 
-//fobOC[JvZ`NX
+//デバッグワイヤーカプセル描画クラス
 class DebugCapsuleRender :public DebugRender {
 public:
 	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext);
@@ -98,25 +98,25 @@ class DebugGeometryRender :public Singleton<DebugGeometryRender> {
 public:
 	DebugGeometryRender();
 
-	//fobOWIgCX^X
+	//デバッグジオメトリインスタンスを初期化＆生成
 	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext);
 
-	//CX^XƂ̃f[^}bv
+	//インスタンスごとのデータをマップする
 	void updatePerInstanceData(uint32 frameIndex);
 
-	//fobOWIg̕`R}h𔭍s
+	//デバッグジオメトリの描画コマンドを発行
 	void setupRenderCommand(RenderSettings& settings) const;
 
-	//fobOWIg̕`惊Xgǉ
+	//デバッグジオメトリの描画リストを追加
 	void debugDrawLine(const Vector3& startPos, const Vector3& endPos, const Color& color = Color::red);
 	void debugDrawCube(const Vector3& position, const Quaternion& rotation, const Vector3& extent, const Color& color = Color::red);
 	void debugDrawSphere(const Vector3& position, const Quaternion& rotation, float radius, const Color& color = Color::red);
 	void debugDrawCapsule(const Vector3& position, const Quaternion& rotation, float radius, float height, const Color& color = Color::red);
 
-	//fobOWIg̃f[^zN[Abv
+	//デバッグジオメトリのデータ配列をクリーンアップ
 	void clearDebugDatas();
 
-	//j
+	//破棄
 	void destroy();
 
 private:
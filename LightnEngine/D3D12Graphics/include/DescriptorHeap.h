@@ -3,37 +3,148 @@
 #include "stdafx.h"
 #include "Utility.h"
 #include "BufferView.h"
-
-constexpr UINT MAX_HEAP_NUM = 1024;
-class GenericAllocator;
-
-class DescriptorHeap {
+#include <TlsfAllocator.h>
+#include "FencedRingAllocator.h"
+#include "BindlessIndexAllocator.h"
+#include <mutex>
+
+//CPU専用のデスクリプタヒープ。ビューはまずここに生成する
+//ページが埋まったら新しいページを追加するので上限がない。ページ内の配置はTlsfAllocatorで管理する
+class DescriptorStagingHeap :private NonCopyable {
 public:
-	explicit DescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
-	~DescriptorHeap();
+	struct Statistics {
+		uint32 pageCount = 0;
+		uint64 capacity = 0;
+		uint64 usedCount = 0;
+	};
 
-	void create(RefPtr<ID3D12Device> device, uint32 maxDescriptorCount = MAX_HEAP_NUM);
-	void shutdown();
+	explicit DescriptorStagingHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
+	~DescriptorStagingHeap();
 
-	void allocateBufferView(RefPtr<BufferView> bufferView, uint32 descriptorCount);
-	void discardBufferView(const BufferView& bufferView);
+	void create(RefPtr<ID3D12Device> device, uint32 descriptorCountPerPage);
+	void shutdown();
 
-	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle(ulong2 bufferViewLocation) const;
-	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle(ulong2 bufferViewLocation) const;
+	//連続したデスクリプタを確保して先頭のハンドルを返す。ページより大きい要求はその数だけのページを作る
+	D3D12_CPU_DESCRIPTOR_HANDLE allocate(uint32 descriptorCount, DescriptorAllocation& outAllocation);
+	void free(const DescriptorAllocation& allocation);
 
-	RefPtr<ID3D12DescriptorHeap> descriptorHeap() const;
-	UINT incrimentSize() const;
+	UINT incrimentSize() const { return _incrimentSize; }
+	Statistics getStatistics();
 
 private:
+	struct Page {
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+		D3D12_CPU_DESCRIPTOR_HANDLE cpuHandleStart;
+		TlsfAllocator allocator;
+	};
+
+	uint32 createPage(uint32 descriptorCount);
+
 	const D3D12_DESCRIPTOR_HEAP_TYPE _descriptorHeapType;
 
+	RefPtr<ID3D12Device> _device;
+	uint32 _descriptorCountPerPage;
+	UINT _incrimentSize;
+	VectorArray<UniquePtr<Page>> _pages;
+	std::mutex _mutex;
+};
+
+//シェーダー可視のCBV_SRV_UAVヒープ。前半を永続領域、後半をリングとして使う
+//永続領域には生成時に1度だけコピーする静的なテーブルを置き、載りきらないテーブルは描画時にステージングヒープからリングへコピーする
+//リングはフレームごとのフェンス値で回収する
+class ShaderVisibleDescriptorHeap :private NonCopyable {
+public:
+	struct Statistics {
+		uint64 persistentCapacity = 0;
+		uint64 persistentUsedCount = 0;
+		uint64 ringCapacity = 0;
+		uint64 ringUsedCount = 0;
+		uint64 ringPeakUsedCount = 0;
+		uint64 ringCopyCount = 0;
+	};
+
+	ShaderVisibleDescriptorHeap();
+	~ShaderVisibleDescriptorHeap();
+
+	void create(RefPtr<ID3D12Device> device, uint32 persistentDescriptorCount, uint32 ringDescriptorCount);
+	void shutdown();
+
+	//永続領域から確保する。空きがなければfalse
+	bool allocatePersistent(uint32 descriptorCount, DescriptorAllocation& outAllocation);
+	void freePersistent(const DescriptorAllocation& allocation);
+
+	//ステージングヒープのデスクリプタをリングにコピーしてテーブルの先頭を返す。描画コマンドの並列記録中に呼んでよい
+	//リングが足りなければコピーせずにHrException(E_OUTOFMEMORY)を投げる
+	D3D12_GPU_DESCRIPTOR_HANDLE copyToRing(D3D12_CPU_DESCRIPTOR_HANDLE srcHandle, uint32 descriptorCount);
+
+	//永続領域に載っていればそのまま、載っていなければリングにコピーしたテーブルを返す
+	D3D12_GPU_DESCRIPTOR_HANDLE getDescriptorTable(const RefBufferView& view) {
+		if (view.isResident()) {
+			return view.gpuHandle;
+		}
+
+		return copyToRing(view.cpuHandle, view.descriptorCount);
+	}
+
+	//前回のsubmit以降にリングへコピーしたテーブルを、このフェンス値の完了で解放されるものとして登録
+	void submit(uint64 fenceValue);
+
+	//完了したフェンス値までのリング領域を回収
+	void reclaim(uint64 completedFenceValue);
+
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle(uint64 descriptorIndex) const;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle(uint64 descriptorIndex) const;
+
+	RefPtr<ID3D12DescriptorHeap> descriptorHeap() const { return _descriptorHeap.Get(); }
+	UINT incrimentSize() const { return _incrimentSize; }
+	Statistics getStatistics();
+
+private:
+	RefPtr<ID3D12Device> _device;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _descriptorHeap;
 	D3D12_CPU_DESCRIPTOR_HANDLE _cpuHandleStart;
 	D3D12_GPU_DESCRIPTOR_HANDLE _gpuHandleStart;
 	UINT _incrimentSize;
 
+	uint32 _persistentDescriptorCount;
+	TlsfAllocator _persistentAllocator;
+	FencedRingAllocator _ringAllocator;
+	uint64 _ringCopyCount;
+	std::mutex _mutex;
+};
+
+//シェーダー可視ヒープの永続領域に確保した1本の大きなテーブル。テクスチャやバッファのSRVはロード時にここへ安定したインデックスで登録する
+//シェーダーは境界なし配列をインデックスで参照するので、マテリアルが変わってもルートシグネチャやPSOを作り直す必要がない
+class BindlessDescriptorTable :private NonCopyable {
+public:
+	BindlessDescriptorTable();
+
+	void create(RefPtr<ShaderVisibleDescriptorHeap> heap, uint32 capacity);
+	void shutdown();
+
+	//スロットを確保する。ビューは返したCPUハンドルへ直接生成する
+	//テーブルが足りなければHrException(E_OUTOFMEMORY)を投げる
+	BindlessHandle allocate(D3D12_CPU_DESCRIPTOR_HANDLE& outCpuHandle);
 
-	GenericAllocator* _allocator;
+	//GPUが参照し終えるまでスロットは再利用されない
+	void free(const BindlessHandle& handle);
+
+	//リングと同じくフレームのフェンス値で解放待ちを登録し、完了したものを回収する
+	void submit(uint64 fenceValue);
+	void reclaim(uint64 completedFenceValue);
+
+	bool isAlive(const BindlessHandle& handle);
+
+	//ルートパラメーターにセットするテーブル全体
+	RefBufferView getRefBufferView() const;
+	BindlessIndexAllocator::Statistics getStatistics();
+	uint32 getUsedRange();
+
+private:
+	RefPtr<ShaderVisibleDescriptorHeap> _heap;
+	DescriptorAllocation _tableAllocation;
+	BindlessIndexAllocator _indexAllocator;
+	std::mutex _mutex;
 };
 
 class DescriptorHeapManager : public Singleton<DescriptorHeapManager> {
@@ -45,24 +156,45 @@ public:
 	void shutdown();
 
 	void createRenderTargetView(RefAddressOf<ID3D12Resource> textureBuffers, RefPtr<BufferView> dstView, uint32 viewCount);
-	void createConstantBufferView(RefAddressOf<ID3D12Resource> constantBuffers, RefPtr<BufferView> dstView, uint32 viewCount);
+	//定数バッファは共有バッファから切り出されている場合があるので、リソースではなくアドレスとサイズから生成する
+	void createConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* viewDescs, RefPtr<BufferView> dstView, uint32 viewCount);
 	void createShaderResourceView(RefAddressOf<ID3D12Resource> shaderResources, RefPtr<BufferView> dstView, uint32 viewCount, const VectorArray<D3D12_BUFFER_SRV>& buffers);
 	void createTextureShaderResourceView(RefAddressOf<ID3D12Resource> textureResources, RefPtr<BufferView> dstView, uint32 viewCount);
 	void createDepthStencilView(RefAddressOf<ID3D12Resource> depthStencils, RefPtr<BufferView> dstView, uint32 viewCount);
 	void createUnorederdAcsessView(RefAddressOf<ID3D12Resource> unorederdAcsess, RefPtr<BufferView> dstView, uint32 viewCount, const VectorArray<D3D12_BUFFER_UAV>& buffers);
 
+	//Imguiのようにシェーダー可視ヒープへ直接書き込む外部ライブラリ用。ステージングヒープを持たない
+	void allocateShaderVisibleView(RefPtr<BufferView> dstView, uint32 viewCount);
+	void discardShaderVisibleView(const BufferView& bufferView);
+
+	//バインドレステーブルにSRVを登録し、シェーダーから参照するインデックスを返す
+	BindlessHandle registerBindlessTexture(RefPtr<ID3D12Resource> texture);
+	BindlessHandle registerBindlessBuffer(RefPtr<ID3D12Resource> buffer, const D3D12_BUFFER_SRV& bufferDesc);
+	void unregisterBindless(const BindlessHandle& handle);
+
 	void discardRenderTargetView(const BufferView& bufferView);
 	void discardConstantBufferView(const BufferView& bufferView);
 	void discardShaderResourceView(const BufferView& bufferView);
 	void discardDepthStencilView(const BufferView& bufferView);
 
-	//Direct3D̃fXNv^q[v^Cv璼ڎ擾
-	RefPtr<ID3D12DescriptorHeap> getD3dDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
-	RefPtr<DescriptorHeap> getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
+	//コマンドリストにセットするシェーダー可視ヒープ
+	RefPtr<ID3D12DescriptorHeap> getD3dDescriptorHeap() const;
+	RefPtr<ShaderVisibleDescriptorHeap> getShaderVisibleHeap();
+	RefPtr<DescriptorStagingHeap> getStagingHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
+	RefPtr<BindlessDescriptorTable> getBindlessTable();
 
 private:
+	//CBV_SRV_UAVのビューをステージングヒープに確保する
+	void allocateCbvSrvUavView(RefPtr<BufferView> dstView, uint32 viewCount);
+
+	//ステージングヒープに生成したビューを永続領域にコピーする。空きがなければリング経由で使う
+	void makeResident(RefPtr<BufferView> dstView);
+
+	void discardCbvSrvUavView(const BufferView& bufferView);
 
-	DescriptorHeap _rtvHeap;
-	DescriptorHeap _dsvHeap;
-	DescriptorHeap _cbvSrvHeap;
+	DescriptorStagingHeap _rtvHeap;
+	DescriptorStagingHeap _dsvHeap;
+	DescriptorStagingHeap _cbvSrvStagingHeap;
+	ShaderVisibleDescriptorHeap _cbvSrvHeap;
+	BindlessDescriptorTable _bindlessTable;
 };
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Utility.h>
+#include <deque>
+#include <mutex>
+#include <iterator>
+#include <cassert>
+
+//フェンス付きプールの利用統計
+struct FencedPoolStatistics {
+	uint32 createCount = 0;			//新規生成した数
+	uint32 reuseCount = 0;			//返却済みのものを再利用した数
+	uint32 waitCount = 0;			//上限到達でフェンス待機した数
+	uint32 overflowCount = 0;		//上限到達かつ待機対象がなく上限を超えて生成した数
+	uint32 inUseCount = 0;			//貸し出し中の数
+	uint32 highWatermark = 0;		//貸し出し中の数の最大値
+};
+
+//GPUの実行完了をフェンス値で管理するオブジェクトプール
+//返却されたものはフェンス値の順に並べておき、先頭から完了したものを再利用する
+//複数スレッドから要求・返却できる。フェンスの完了待ちと生成はロックを外して行うので、待っている間も他のスレッドは返却や再利用ができる
+//D3D12に依存しないので、フェンスは fenceValue() と waitForFence(uint64) を持つ任意の型で差し替えられる
+template <class T>
+class FencedObjectPool {
+public:
+	struct PendingObject {
+		uint64 fenceValue;
+		T object;
+	};
+
+	FencedObjectPool() :_maxObjectCount(0), _creatingCount(0) {}
+
+	void create(uint32 maxObjectCount) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_maxObjectCount = maxObjectCount;
+	}
+
+	//返却済みの中から完了済みのものを探し、なければ生成、上限に達していれば最も古いものの完了を待って再利用する
+	//createFuncは新規生成時のみ呼ばれる
+	template <class FenceT, class CreateFuncT>
+	T request(FenceT& fence, CreateFuncT&& createFunc) {
+		const uint64 completedFenceValue = fence.fenceValue();
+
+		T object = T();
+		uint64 waitFenceValue = 0;
+		bool isCreateRequired = false;
+		bool isWaitRequired = false;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			const size_t objectCount = _objects.size() + _creatingCount;
+			if (tryReuse(completedFenceValue, object)) {
+				++_statistics.reuseCount;
+			}
+			else if (objectCount < _maxObjectCount || _pendingObjects.empty()) {
+				//上限未満か、待機しても戻ってくるものがない場合は生成する
+				if (objectCount >= _maxObjectCount) {
+					++_statistics.overflowCount;
+				}
+
+				++_creatingCount;
+				isCreateRequired = true;
+			}
+			else {
+				//最も早く完了するものをこのスレッドの分として取り出してから待つ。他のスレッドは次に古いものを選ぶ
+				waitFenceValue = _pendingObjects.front().fenceValue;
+				object = _pendingObjects.front().object;
+				_pendingObjects.pop_front();
+				isWaitRequired = true;
+				++_statistics.reuseCount;
+				++_statistics.waitCount;
+			}
+
+			++_statistics.inUseCount;
+			if (_statistics.inUseCount > _statistics.highWatermark) {
+				_statistics.highWatermark = _statistics.inUseCount;
+			}
+		}
+
+		if (isWaitRequired) {
+			fence.waitForFence(waitFenceValue);
+		}
+
+		if (isCreateRequired) {
+			object = createFunc();
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_objects.push_back(object);
+			--_creatingCount;
+			++_statistics.createCount;
+		}
+
+		return object;
+	}
+
+	//フェンス値がfenceValueに達したら再利用できるものとして返却
+	void discard(uint64 fenceValue, T object) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		assert(_statistics.inUseCount > 0 && "貸し出していないオブジェクトが返却されました");
+
+		//複数スレッドから返却されると前後することがあるので、フェンス値の順になる位置に入れる。ほとんどは末尾
+		auto itr = _pendingObjects.end();
+		while (itr != _pendingObjects.begin() && std::prev(itr)->fenceValue > fenceValue) {
+			--itr;
+		}
+
+		_pendingObjects.insert(itr, { fenceValue, object });
+		--_statistics.inUseCount;
+	}
+
+	//生成したすべてのオブジェクト(解放用)。他のスレッドが要求していないときに使う
+	const VectorArray<T>& getObjects() const { return _objects; }
+
+	void clear() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_objects.clear();
+		_pendingObjects.clear();
+		_creatingCount = 0;
+		_statistics = FencedPoolStatistics();
+	}
+
+	size_t size() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _objects.size();
+	}
+
+	size_t pendingSize() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _pendingObjects.size();
+	}
+
+	uint32 getMaxObjectCount() const { return _maxObjectCount; }
+
+	FencedPoolStatistics getStatistics() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _statistics;
+	}
+
+private:
+	//返却済みはフェンス値の順なので、先頭が完了していなければ完了しているものはない
+	bool tryReuse(uint64 completedFenceValue, T& outObject) {
+		if (_pendingObjects.empty() || _pendingObjects.front().fenceValue > completedFenceValue) {
+			return false;
+		}
+
+		outObject = _pendingObjects.front().object;
+		_pendingObjects.pop_front();
+		return true;
+	}
+
+	uint32 _maxObjectCount;
+
+	//ロックを外して生成している数。上限の判定に含める
+	uint32 _creatingCount;
+	VectorArray<T> _objects;
+	DequeArray<PendingObject> _pendingObjects;
+	FencedPoolStatistics _statistics;
+	mutable std::mutex _mutex;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Utility.h>
+
+//フェンス値で解放タイミングを管理するリングアロケーター
+//確保はオフセットを返すだけでメモリは持たないので、D3D12なしでフェンスを模擬して検証できる
+//submitで直前までの確保をフェンス値に紐づけ、reclaimで完了したフェンスの領域を先頭から回収する
+class FencedRingAllocator {
+public:
+	static constexpr uint64 InvalidOffset = ~0ull;
+
+	struct Statistics {
+		uint64 allocationCount = 0;
+		uint64 failedAllocationCount = 0;
+		uint64 allocatedSize = 0;		//パディングを含めた累計確保サイズ
+		uint64 peakUsedSize = 0;
+	};
+
+	FencedRingAllocator();
+
+	void create(uint64 capacity);
+
+	//アライメントしたオフセットを返す。空きがなければInvalidOffset
+	//末尾に収まらない場合は先頭に折り返し、末尾の余りはパディングとして次の回収まで使わない
+	uint64 allocate(uint64 size, uint64 alignment);
+
+	//前回のsubmit以降に確保した領域を、このフェンス値の完了で解放されるものとして登録
+	void submit(uint64 fenceValue);
+
+	//完了したフェンス値までの領域を回収
+	void reclaim(uint64 completedFenceValue);
+
+	//提出済みで未回収の領域があるか
+	bool hasPendingSubmission() const { return !_pendingSubmissions.empty(); }
+
+	//提出済みで未回収のうち最も古いフェンス値
+	uint64 getOldestPendingFenceValue() const;
+
+	uint64 getCapacity() const { return _capacity; }
+	uint64 getUsedSize() const { return _usedSize; }
+	uint64 getUnsubmittedSize() const { return _unsubmittedSize; }
+	const Statistics& getStatistics() const { return _statistics; }
+
+private:
+	struct PendingSubmission {
+		uint64 fenceValue;
+		uint64 endOffset;
+		uint64 size;
+	};
+
+	uint64 _capacity;
+	uint64 _head;
+	uint64 _tail;
+	uint64 _usedSize;
+	uint64 _unsubmittedSize;
+	DequeArray<PendingSubmission> _pendingSubmissions;
+	Statistics _statistics;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include <mutex>
+#include <TlsfAllocator.h>
+
+using namespace Microsoft::WRL;
+
+//ヒープ上の確保位置。解放時にどのプールのどのページかを引く
+struct GpuMemoryAllocation {
+	uint32 pool = 0;
+	uint32 page = 0;
+	TlsfAllocator::Allocation block;
+
+	bool isValid() const { return block.isValid(); }
+};
+
+//小さいアップロードバッファを切り出した結果
+struct GpuSmallBufferAllocation {
+	RefPtr<ID3D12Resource> resource = nullptr;
+	uint64 offset = 0;
+	void* cpuAddress = nullptr;
+	GpuMemoryAllocation allocation;
+};
+
+struct GpuHeapStatistics {
+	uint32 pageCount = 0;
+	uint32 allocationCount = 0;
+	uint64 reservedSize = 0;
+	uint64 usedSize = 0;
+	uint64 largestFreeBlockSize = 0;
+
+	//ページに収まらずコミットリソースで生成した数
+	uint32 committedFallbackCount = 0;
+};
+
+//リソースごとにコミットリソースを作らず、大きなID3D12Heapのページに配置リソースとして詰める
+//ページ内の配置はTlsfAllocatorで管理し、空になったページは1枚を残して解放する
+//64KBに満たないアップロードバッファは64KBアライメントの無駄が大きいので、まとめたバッファから256バイト単位で切り出す
+class GpuMemoryAllocator :public Singleton<GpuMemoryAllocator> {
+public:
+	//リソースヒープティア1でも共存できるようにリソースの種類とヒープタイプごとにプールを分ける
+	enum Pool {
+		POOL_DEFAULT_BUFFER = 0,
+		POOL_DEFAULT_TEXTURE,
+		POOL_UPLOAD_BUFFER,
+		POOL_SMALL_UPLOAD_BUFFER,
+		POOL_COUNT
+	};
+
+	GpuMemoryAllocator();
+	~GpuMemoryAllocator();
+
+	void create(RefPtr<ID3D12Device> device, uint64 pageSize, uint64 smallBufferPageSize);
+	void shutdown();
+
+	//バッファを配置リソースとして生成する。ページより大きい場合はコミットリソースになり、outAllocationは無効のまま
+	void createBuffer(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState,
+		ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outAllocation);
+
+	//レンダーターゲット・デプス以外のテクスチャを配置リソースとして生成する。小さいテクスチャは4KBアライメントで詰める
+	void createTexture(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+		ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outAllocation);
+
+	//まとめたアップロードバッファから切り出す。CPUアドレスは永続的にマップされている
+	void allocateSmallUploadBuffer(uint64 size, GpuSmallBufferAllocation& outAllocation);
+
+	//GPUが使用していないことは呼び出し側で保証する
+	void free(const GpuMemoryAllocation& allocation);
+
+	bool isSmallUploadBuffer(uint64 size) const { return size < D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT; }
+
+	GpuHeapStatistics getStatistics(Pool pool);
+	static const char* getPoolName(Pool pool);
+
+private:
+	struct Page {
+		ComPtr<ID3D12Heap> heap;
+
+		//小さいバッファのプールはページ全体を1つのバッファとして持つ
+		ComPtr<ID3D12Resource> buffer;
+		byte* mappedPtr = nullptr;
+
+		TlsfAllocator allocator;
+	};
+
+	struct PoolState {
+		D3D12_HEAP_TYPE heapType;
+		D3D12_HEAP_FLAGS heapFlags;
+		uint64 pageSize;
+		uint64 granularity;
+		VectorArray<UniquePtr<Page>> pages;
+		uint32 committedFallbackCount;
+	};
+
+	//空きのあるページから確保し、どこにも入らなければページを追加する
+	bool allocateFromPool(Pool pool, uint64 size, uint64 alignment, GpuMemoryAllocation& outAllocation);
+	uint32 createPage(Pool pool);
+
+	RefPtr<ID3D12Device> _device;
+	PoolState _pools[POOL_COUNT];
+	std::mutex _mutex;
+};
@@ -4,19 +4,36 @@
 #include "D3D12Helper.h"
 #include "D3D12Util.h"
 #include "CommandContext.h"
+#include "UploadRingBuffer.h"
+#include "GpuMemoryAllocator.h"
+#include "BindlessIndexAllocator.h"
 #include "ThirdParty/DirectXTex/DDSTextureLoader12.h"
 
+#include <AssetFileSystem.h>
+
 #include <Utility.h>
+#include <functional>
 using namespace Microsoft::WRL;
 
 class GpuResource :private NonCopyable {
 public:
+	GpuResource() :_bufferOffset(0), _uploadFenceValue(0) {
+	}
+
 	virtual ~GpuResource() {
 		destroy();
 	}
 
+	//配置リソースならヒープ上の領域も返す。GPUが使用していないことは呼び出し側で保証する
 	void destroy() {
 		_resource = nullptr;
+
+		if (_memoryAllocation.isValid()) {
+			GpuMemoryAllocator::instance().free(_memoryAllocation);
+			_memoryAllocation = GpuMemoryAllocation();
+		}
+
+		_bufferOffset = 0;
 	}
 
 	ID3D12Resource* get() {
@@ -27,12 +44,20 @@ public:
 		return _resource.GetAddressOf();
 	}
 
-	//GPỦzAhX擾
+	//GPUの仮想アドレスを取得
 	D3D12_GPU_VIRTUAL_ADDRESS getGpuVirtualAddress() const {
-		return _resource->GetGPUVirtualAddress();
+		return _resource->GetGPUVirtualAddress() + _bufferOffset;
 	}
 
 	ComPtr<ID3D12Resource> _resource;
+	GpuMemoryAllocation _memoryAllocation;
+
+	//まとめたバッファから切り出した場合は_resourceが共有バッファを指すので、その中のオフセット
+	uint64 _bufferOffset;
+
+	//初期データのコピーが完了するグラフィックスキューのフェンス値。0なら待つものはない
+	//同じキューの後続コマンドはコピーの後に実行されるので、別のキューから使うときだけこの値を待てばよい
+	UINT64 _uploadFenceValue;
 };
 
 struct DepthTextureInfo {
@@ -53,49 +78,53 @@ struct TextureInfo {
 class GpuBuffer :public GpuResource {
 public:
 
-	//GPUI[obt@𐶐āAR}hXgɈzf[^̏R}hL^
+	//GPUオンリーバッファを生成して、アップロードコンテキストに引数配列データの初期化コマンドを記録
 	template<class T>
-	void createDeferredGpuOnly(RefPtr<ID3D12Device> device, RefPtr<ID3D12GraphicsCommandList> commandList, RefAddressOf<ID3D12Resource> uploadHeap, const VectorArray<T>& initData) {
-		D3D12_HEAP_PROPERTIES defaultHeapProperties = { D3D12_HEAP_TYPE_DEFAULT };
-		D3D12_HEAP_PROPERTIES uploadHeapProperties = { D3D12_HEAP_TYPE_UPLOAD };
+	void createDeferredGpuOnly(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const VectorArray<T>& initData) {
+		createDeferredGpuOnly(device, uploadContext, initData.data(), initData.size() * sizeof(T));
+	}
+
+	//マップしたファイルなどの任意のメモリから初期化する。initDataはアップロードリングに1回だけコピーされる
+	void createDeferredGpuOnly(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const void* initData, uint64 size) {
+		destroy();
 
 		D3D12_RESOURCE_DESC bufferDesc = {};
 		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		bufferDesc.Width = initData.size() * sizeof(T);
+		bufferDesc.Width = size;
 		bufferDesc.Height = 1;
 		bufferDesc.DepthOrArraySize = 1;
 		bufferDesc.MipLevels = 1;
 		bufferDesc.SampleDesc.Count = 1;
 		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-		throwIfFailed(device->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&bufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(uploadHeap)));
+		GpuMemoryAllocator::instance().createBuffer(bufferDesc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, _resource, _memoryAllocation);
+		NAME_D3D12_OBJECT(_resource.Get());
 
-		throwIfFailed(device->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&bufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&_resource)));
+		uploadContext.uploadBuffer(_resource.Get(), 0, initData, bufferDesc.Width);
+	}
 
-		NAME_D3D12_OBJECT(_resource.Get());
+	//初期値をアップロードリングに直接書き込む。ファイル上で符号化されたデータを戻しながら転送するのに使う
+	void createDeferredGpuOnly(RefPtr<ID3D12Device> device, UploadContext& uploadContext, uint64 size, const std::function<void(void* dst, uint64 size)>& writeData) {
+		destroy();
+
+		D3D12_RESOURCE_DESC bufferDesc = {};
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Width = size;
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-		T* mapPtrC = nullptr;
-		(*uploadHeap)->Map(0, nullptr, reinterpret_cast<void**>(&mapPtrC));
-		memcpy(mapPtrC, initData.data(), bufferDesc.Width);
+		GpuMemoryAllocator::instance().createBuffer(bufferDesc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, _resource, _memoryAllocation);
+		NAME_D3D12_OBJECT(_resource.Get());
 
-		commandList->CopyBufferRegion(_resource.Get(), 0, *uploadHeap, 0, bufferDesc.Width);
+		uploadContext.uploadBuffer(_resource.Get(), 0, bufferDesc.Width, writeData);
 	}
 
-	//GPUI[obt@̒lݒ肹ɐ
+	//GPUオンリーバッファを初期化の値を設定せずに生成する
 	void createDirectGpuOnlyEmpty(RefPtr<ID3D12Device> device, uint32 length, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE) {
-		D3D12_HEAP_PROPERTIES defaultHeapProperties = { D3D12_HEAP_TYPE_DEFAULT };
+		destroy();
 
 		D3D12_RESOURCE_DESC bufferDesc = {};
 		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -107,17 +136,11 @@ public:
 		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 		bufferDesc.Flags = flags;
 
-		throwIfFailed(device->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&bufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&_resource)));
+		GpuMemoryAllocator::instance().createBuffer(bufferDesc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, _resource, _memoryAllocation);
 	}
 };
 
-//CPUœǂݏ\ȃobt@𐶐BCPUGPUǂ߂钆ԃɔzûGPUI[obt@ɔׂƓǂݏx
+//CPU上で読み書き可能なバッファを生成する。CPUもGPUも読める中間メモリに配置されるのでGPUオンリーバッファに比べると読み書きが遅い
 class GpuBufferDynamic :public GpuResource {
 public:
 	void createDirect(RefPtr<ID3D12Device> device, const void* sourceDataPtr, uint32 length) {
@@ -125,9 +148,20 @@ public:
 		writeData(sourceDataPtr, length);
 	}
 
-	//̃obt@𐶐
+	//空のバッファを生成。64KBに満たないものは共有のアップロードバッファから切り出す
 	void createDirectEmpty(RefPtr<ID3D12Device> device, uint32 size) {
-		D3D12_HEAP_PROPERTIES uploadHeapProperties = { D3D12_HEAP_TYPE_UPLOAD };
+		destroy();
+
+		GpuMemoryAllocator& allocator = GpuMemoryAllocator::instance();
+		if (allocator.isSmallUploadBuffer(size)) {
+			GpuSmallBufferAllocation smallAllocation;
+			allocator.allocateSmallUploadBuffer(size, smallAllocation);
+			_resource = smallAllocation.resource;
+			_memoryAllocation = smallAllocation.allocation;
+			_bufferOffset = smallAllocation.offset;
+			_dataPtr = smallAllocation.cpuAddress;
+			return;
+		}
 
 		D3D12_RESOURCE_DESC bufferDesc = {};
 		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -138,18 +172,11 @@ public:
 		bufferDesc.SampleDesc.Count = 1;
 		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-		throwIfFailed(device->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&bufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&_resource)));
-
+		allocator.createBuffer(bufferDesc, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, _resource, _memoryAllocation);
 		throwIfFailed(_resource->Map(0, nullptr, reinterpret_cast<void**>(&_dataPtr)));
 	}
 
-	//}bvꂽ̈ɂɏ
+	//マップされた領域にに書き込み
 	void writeData(const void* bufferPtr, uint32 size, uint32 startOffset = 0) const {
 		memcpy(_dataPtr, reinterpret_cast<const byte*>(bufferPtr) + startOffset, size);
 	}
@@ -159,12 +186,12 @@ public:
 
 class Texture2D :public GpuResource {
 public:
-	//obNobt@eNX`𐶐
+	//バックバッファからテクスチャを生成
 	void createFromBackBuffer(RefPtr<IDXGISwapChain3> swapChain, uint32 index) {
 		throwIfFailed(swapChain->GetBuffer(index, IID_PPV_ARGS(&_resource)));
 	}
 
-	//fvXeNX`ƂĐ
+	//デプステクスチャとして生成。レンダーターゲット・デプスはドライバーの最適化が効くようにコミットリソースのまま
 	void createDepth(RefPtr<ID3D12Device> device, const DepthTextureInfo& info) {
 		D3D12_CLEAR_VALUE depthOptimizedClearValue = {};
 		depthOptimizedClearValue.Format = info.format;
@@ -193,29 +220,20 @@ public:
 		NAME_D3D12_OBJECT(_resource.Get());
 	}
 
-	//ɃeNX`𐶐A삪܂ŃXbh~
+	//直ちにテクスチャを生成してコピーを提出する。同じキューの後続コマンドより先にコピーが完了するのでCPUは待たない
 	void createDirectFromDataPtr(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const TextureInfo& info) {
-		//eNX`Rs[R}h𔭍sp̃AP[^[ƃXg
-		auto commandListSet = commandContext->requestCommandListSet();
-		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
-
-		ComPtr<ID3D12Resource> textureUploadHeap;
-
-		createDeferredFromDataPtr(device, commandList, textureUploadHeap.ReleaseAndGetAddressOf(), info);
-
-		//R}hs(Abv[hobt@̃eNX`GPUǂݏobt@ɃRs[)
-		commandContext->executeCommandList(commandList);
-		commandContext->discardCommandListSet(commandListSet);
+		UploadContext uploadContext(commandContext);
+		createDeferredFromDataPtr(device, uploadContext, info);
 
-		//Rs[I܂ŃAbv[hq[vjȂ
-		commandContext->waitForIdle();
+		//コマンド実行(アップロードリングからGPU読み書き限定バッファにコピー)
+		uploadContext.submit();
 	}
 
-	//łɃ[hꂽeNX`f[^琶
-	void createDeferredFromDataPtr(RefPtr<ID3D12Device> device, RefPtr<ID3D12GraphicsCommandList> commandList, ID3D12Resource** uploadHeap, const TextureInfo& info) {
+	//すでにロードされたテクスチャデータから生成
+	void createDeferredFromDataPtr(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const TextureInfo& info) {
 		const uint32 texturePixelSize = 4;
 
-		//GPUǂݏopeNX`{̂𐶐
+		//GPU読み出し専用テクスチャ本体を生成
 		D3D12_RESOURCE_DESC textureDesc = {};
 		textureDesc.MipLevels = 1;
 		textureDesc.Format = info.format;
@@ -227,67 +245,65 @@ public:
 		textureDesc.SampleDesc.Quality = 0;
 		textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-		throwIfFailed(device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&_resource)));
-
-		UINT64 requiredSize = 0;
-		device->GetCopyableFootprints(&_resource->GetDesc(), 0, 1, 0, nullptr, nullptr, nullptr, &requiredSize);
-
-		//eNX`Ƀf[^Zbg邽߂CPU݉\ȃobt@𐶐
-		D3D12_RESOURCE_DESC textureBufferDesc = {};
-		textureBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		textureBufferDesc.Alignment = 0;
-		textureBufferDesc.Width = requiredSize;
-		textureBufferDesc.Height = 1;
-		textureBufferDesc.DepthOrArraySize = 1;
-		textureBufferDesc.MipLevels = 1;
-		textureBufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-		textureBufferDesc.SampleDesc.Count = 1;
-		textureBufferDesc.SampleDesc.Quality = 0;
-		textureBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		textureBufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-		throwIfFailed(device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &textureBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(uploadHeap)));
+		destroy();
+		GpuMemoryAllocator::instance().createTexture(textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, _resource, _memoryAllocation);
 		NAME_D3D12_OBJECT(_resource.Get());
 
-		//eNX`f[^Zbg
+		//テクスチャデータをセット
 		D3D12_SUBRESOURCE_DATA textureData = {};
 		textureData.pData = info.dataPtr;
 		textureData.RowPitch = info.width * texturePixelSize;
 		textureData.SlicePitch = textureData.RowPitch * info.height;
 
-		//GPUǂݏopobt@ɃRs[R}h𔭍s
-		updateSubresources(commandList, _resource.Get(), *uploadHeap, 0, 0, 1, &textureData);
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+		//アップロードリング経由でGPU読み出し専用バッファにコピーコマンドを発行
+		uploadContext.uploadTexture(_resource.Get(), &textureData, 1);
+		uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	}
+
+	//テクスチャ名からロード
+	void createDeferredFromName(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const String& textureName) {
+		AssetFile ddsFile;
+		if (!ddsFile.open(textureName.c_str())) {
+			throwIfFailed(HRESULT_FROM_WIN32(ERROR_OPEN_FAILED));
+		}
+
+		createDeferredFromMemory(device, uploadContext, ddsFile.data(), ddsFile.size());
 	}
 
-	//eNX`烍[h
-	void createDeferredFromName(RefPtr<ID3D12Device> device, RefPtr<ID3D12GraphicsCommandList> commandList, ID3D12Resource** uploadHeap, const String& textureName) {
-		UniquePtr<uint8_t[]> ddsData;
+	//メモリ上のDDSファイルの内容からロード。マップしたファイルでもIoServiceで読み込んだバッファでもよい
+	//サブリソースはdataを直接指すので、ファイルの内容は別のバッファを経由せずアップロードリングに1回だけコピーされる
+	void createDeferredFromMemory(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const byte* data, uint64 size) {
+		destroy();
+
+		//テクスチャ本体はローダーに生成させず、ヒープのページに配置する
+		DirectX::DDSResourceCreateFunc createFunc = [this](const D3D12_RESOURCE_DESC& desc, ID3D12Resource** texture) {
+			ComPtr<ID3D12Resource> resource;
+			GpuMemoryAllocator::instance().createTexture(desc, D3D12_RESOURCE_STATE_COPY_DEST, resource, _memoryAllocation);
+			*texture = resource.Detach();
+			return S_OK;
+		};
+
 		VectorArray<D3D12_SUBRESOURCE_DATA> subresouceData;
-		throwIfFailed(DirectX::LoadDDSTextureFromFile(device, convertWString(textureName).c_str(), _resource.ReleaseAndGetAddressOf(), ddsData, subresouceData));
+		throwIfFailed(DirectX::LoadDDSTextureFromMemoryEx(device, data, static_cast<size_t>(size), 0, D3D12_RESOURCE_FLAG_NONE, DirectX::DDS_LOADER_DEFAULT,
+			_resource.ReleaseAndGetAddressOf(), subresouceData, nullptr, nullptr, &createFunc));
 
 		const UINT subresouceSize = static_cast<UINT>(subresouceData.size());
 
-		UINT64 requiredSize = 0;
-		device->GetCopyableFootprints(&_resource->GetDesc(), 0, subresouceSize, 0, nullptr, nullptr, nullptr, &requiredSize);
-
-		//eNX`Ƀf[^Zbg邽߂CPU݉\ȃobt@𐶐
-		D3D12_RESOURCE_DESC textureBufferDesc = {};
-		textureBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		textureBufferDesc.Width = requiredSize;
-		textureBufferDesc.Height = 1;
-		textureBufferDesc.DepthOrArraySize = 1;
-		textureBufferDesc.MipLevels = 1;
-		textureBufferDesc.SampleDesc.Count = 1;
-		textureBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		throwIfFailed(device->CreateCommittedResource(&LTND3D12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &textureBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(uploadHeap)));
+		//アップロードリング経由でGPU読み出し専用バッファにコピーコマンドを発行
+		uploadContext.uploadTexture(_resource.Get(), subresouceData.data(), subresouceSize);
+		uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	}
 
-		//GPUǂݏopobt@ɃRs[R}h𔭍s
-		updateSubresources(commandList, _resource.Get(), *uploadHeap, 0, 0, subresouceSize, subresouceData.data());
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	//シェーダーがバインドレステーブルから参照するインデックス
+	uint32 getBindlessIndex() const {
+		return _bindlessHandle.index;
 	}
+
+	//登録と解除はGpuResourceManagerが行う
+	BindlessHandle _bindlessHandle;
 };
 
-//obt@[r[̎Q(͎)\́B̊Ǘ͂Ȃ
+//バッファービューの参照(扱いは実体)を持った構造体。寿命の管理はしない
 struct RefVertexBufferView {
 	RefVertexBufferView(D3D12_VERTEX_BUFFER_VIEW view) :view(view) {}
 	D3D12_VERTEX_BUFFER_VIEW view;
@@ -300,33 +316,31 @@ struct RefIndexBufferView {
 
 class VertexBuffer :public GpuBuffer {
 public:
-	//ɒ_obt@𐶐A삪܂ŃXbh~
+	//直ちに頂点バッファを生成してコピーを提出する。同じキューの後続コマンドより先にコピーが完了するのでCPUは待たない
 	template <typename T>
 	void createDirect(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const VectorArray<T>& vertices) {
-		ComPtr<ID3D12Resource> vertexUploadHeap;
-		auto commandListSet = commandContext->requestCommandListSet();
-		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
-
-		createDeferred<T>(device, commandList, vertexUploadHeap.ReleaseAndGetAddressOf(), vertices);
-
-		//R}hs(Abv[hobt@̃eNX`GPUǂݏobt@ɃRs[)
-		commandContext->executeCommandList(commandList);
-		commandContext->discardCommandListSet(commandListSet);
+		UploadContext uploadContext(commandContext);
+		createDeferred<T>(device, uploadContext, vertices);
 
-		//Rs[I܂ŃAbv[hq[vjȂ
-		commandContext->waitForIdle();
+		//コマンド実行(アップロードリングからGPU読み書き限定バッファにコピー)
+		uploadContext.submit();
 	}
 
-	//R}hXgɒ_obt@R}h𔭍s(ŝ݂Ŏs͂Ȃ)
+	//アップロードコンテキストに頂点バッファ生成コマンドを発行(発行のみで実行はしない)
 	template <typename T>
-	void createDeferred(RefPtr<ID3D12Device> device, RefPtr<ID3D12GraphicsCommandList> commandList, RefAddressOf<ID3D12Resource> uploadHeap, const VectorArray<T>& vertices) {
-		GpuBuffer::createDeferredGpuOnly<T>(device, commandList, uploadHeap, vertices);
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const VectorArray<T>& vertices) {
+		createDeferred(device, uploadContext, vertices.data(), sizeof(T), static_cast<uint32>(vertices.size()));
+	}
+
+	//頂点の型を持たないメモリから生成する。ストライドはファイルに記録された値を使う
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const void* vertices, uint32 strideInBytes, uint32 vertexCount) {
+		GpuBuffer::createDeferredGpuOnly(device, uploadContext, vertices, static_cast<uint64>(strideInBytes) * vertexCount);
 
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+		uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
 
 		_vertexBufferView.BufferLocation = _resource->GetGPUVirtualAddress();
-		_vertexBufferView.StrideInBytes = sizeof(T);
-		_vertexBufferView.SizeInBytes = static_cast<UINT>(sizeof(T) * vertices.size());
+		_vertexBufferView.StrideInBytes = strideInBytes;
+		_vertexBufferView.SizeInBytes = strideInBytes * vertexCount;
 	}
 
 	RefVertexBufferView getRefVertexBufferView() const {
@@ -361,32 +375,34 @@ public:
 
 class IndexBuffer :public GpuBuffer {
 public:
+	//直ちにインデックスバッファを生成してコピーを提出する。同じキューの後続コマンドより先にコピーが完了するのでCPUは待たない
 	void createDirect(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const VectorArray<UINT32>& indices) {
-		ComPtr<ID3D12Resource> indexUploadHeap;
+		UploadContext uploadContext(commandContext);
+		createDeferred(device, uploadContext, indices);
 
-		auto commandListSet = commandContext->requestCommandListSet();
-		RefPtr<ID3D12GraphicsCommandList> commandList = commandListSet.commandList;
-
-		createDeferred(device, commandList, indexUploadHeap.ReleaseAndGetAddressOf(), indices);
-
-		//R}hs(Abv[hobt@̃eNX`GPUǂݏobt@ɃRs[)
-		commandContext->executeCommandList(commandList);
-		commandContext->discardCommandListSet(commandListSet);
+		//コマンド実行(アップロードリングからGPU読み書き限定バッファにコピー)
+		uploadContext.submit();
+	}
 
-		//Rs[I܂ŃAbv[hq[vjȂ
-		commandContext->waitForIdle();
+	//アップロードコンテキストにインデックスバッファ生成コマンドを発行(発行のみで実行はしない)
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const VectorArray<UINT32>& indices) {
+		createDeferred(device, uploadContext, indices.data(), static_cast<uint32>(indices.size()));
 	}
 
-	//R}hXgɃCfbNXobt@R}h𔭍s(ŝ݂Ŏs͂Ȃ)
-	void createDeferred(RefPtr<ID3D12Device> device, RefPtr<ID3D12GraphicsCommandList> commandList, ID3D12Resource** uploadHeap, const VectorArray<UINT32>& indices) {
-		GpuBuffer::createDeferredGpuOnly<UINT32>(device, commandList, uploadHeap, indices);
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const UINT32* indices, uint32 indexCount) {
+		createDeferred(device, uploadContext, indices, sizeof(UINT32), indexCount);
+	}
 
-		commandList->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+	//インデックスの型を持たないメモリから生成する。strideInBytesが2なら16ビット、4なら32ビットのインデックスになる
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, const void* indices, uint32 strideInBytes, uint32 indexCount) {
+		GpuBuffer::createDeferredGpuOnly(device, uploadContext, indices, static_cast<uint64>(strideInBytes) * indexCount);
+		setupView(uploadContext, strideInBytes, indexCount);
+	}
 
-		_indexBufferView.BufferLocation = _resource->GetGPUVirtualAddress();
-		_indexBufferView.Format = DXGI_FORMAT_R32_UINT;
-		_indexBufferView.SizeInBytes = static_cast<UINT>(sizeof(UINT32) * indices.size());
-		_indexCount = static_cast<uint32>(indices.size());
+	//インデックスをアップロードリングに直接書き込んで生成する。writeIndicesはチャンクごとに先頭から順に呼ばれる
+	void createDeferred(RefPtr<ID3D12Device> device, UploadContext& uploadContext, uint32 strideInBytes, uint32 indexCount, const std::function<void(void* dst, uint64 size)>& writeIndices) {
+		GpuBuffer::createDeferredGpuOnly(device, uploadContext, static_cast<uint64>(strideInBytes) * indexCount, writeIndices);
+		setupView(uploadContext, strideInBytes, indexCount);
 	}
 
 	RefIndexBufferView getRefIndexBufferView() const {
@@ -395,17 +411,34 @@ public:
 
 	uint32 _indexCount;
 	D3D12_INDEX_BUFFER_VIEW _indexBufferView;
+
+private:
+	void setupView(UploadContext& uploadContext, uint32 strideInBytes, uint32 indexCount) {
+		uploadContext.getCommandList()->ResourceBarrier(1, &LTND3D12_RESOURCE_BARRIER::transition(_resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+
+		_indexBufferView.BufferLocation = _resource->GetGPUVirtualAddress();
+		_indexBufferView.Format = strideInBytes == sizeof(uint16) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		_indexBufferView.SizeInBytes = strideInBytes * indexCount;
+		_indexCount = indexCount;
+	}
 };
 
 class ConstantBuffer :public GpuBufferDynamic {
 public:
 	void create(RefPtr<ID3D12Device> device, uint32 size) {
-		//256oCgŃAC
+		//256バイトでアライン
 		this->size = size;
 		const UINT32 constantBufferSize = (size + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
 
 		GpuBufferDynamic::createDirectEmpty(device, constantBufferSize);
 	}
 
+	D3D12_CONSTANT_BUFFER_VIEW_DESC getConstantBufferViewDesc() const {
+		D3D12_CONSTANT_BUFFER_VIEW_DESC viewDesc = {};
+		viewDesc.BufferLocation = getGpuVirtualAddress();
+		viewDesc.SizeInBytes = (size + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+		return viewDesc;
+	}
+
 	uint32 size;
 };
@@ -22,6 +22,20 @@ class Texture2D;
 class SingleMeshRenderMaterial;
 class CommandContext;
 class StaticSingleMeshRCG;
+class ThreadPool;
+
+//起動後に読み込んだテクスチャとメッシュの累計
+struct ResourceLoadStatistics {
+	uint32 fileCount = 0;
+	uint32 submitCount = 0;
+	uint64 loadedSize = 0;
+	double loadSeconds = 0.0;
+
+	//ファイルの読み込みからGPUへの提出までを含めたMB/s
+	double getThroughput() const {
+		return loadSeconds > 0.0 ? loadedSize / (1024.0 * 1024.0) / loadSeconds : 0.0;
+	}
+};
 
 class GpuResourceManager :public Singleton<GpuResourceManager> {
 public:
@@ -29,8 +43,13 @@ public:
 	~GpuResourceManager();
 
 	void createSharedMaterial(RefPtr<ID3D12Device> device, const SharedMaterialCreateSettings& settings);
-	void createTextures(RefPtr<ID3D12Device> device, CommandContext& commandContext, const VectorArray<String>& settings);
-	void createVertexAndIndexBuffer(RefPtr<ID3D12Device> device, CommandContext& commandContext, const VectorArray<String>& fileName);
+
+	//ファイルはIoServiceでまとめて読み、アップロードの記録はthreadPoolで並列に行う。コピーの完了は待たず、各リソースにコピーが完了するフェンス値を記録する
+	void createTextures(RefPtr<ID3D12Device> device, CommandContext& commandContext, ThreadPool& threadPool, const VectorArray<String>& settings);
+	void createVertexAndIndexBuffer(RefPtr<ID3D12Device> device, CommandContext& commandContext, ThreadPool& threadPool, const VectorArray<String>& fileName);
+
+	//メッシュファイル内のmeshIndex番目のメッシュをキャッシュから引く名前。先頭のメッシュはファイル名のまま
+	static String getMeshName(const String& fileName, uint32 meshIndex);
 	RefPtr<ConstantBuffer> createConstantBuffer(RefPtr<ID3D12Device> device, const String& name, uint32 size);
 
 	RefPtr<PipelineState> createComputePipelineState(RefPtr<ID3D12Device> device, const String& name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
@@ -56,8 +75,12 @@ public:
 
 	//UnorderedMap<String, SingleMeshRenderPass>& getMaterials() const;
 	RefPtr<Camera> getMainCamera();
+	const ResourceLoadStatistics& getLoadStatistics() const { return _loadStatistics; }
 
 private:
+	void addLoadStatistics(uint32 fileCount, uint64 loadedSize, uint32 submitCount, const LARGE_INTEGER& startTime);
+
 	UniquePtr<GpuResourceDataPool> _resourcePool;
 	Camera _mainCamera;
+	ResourceLoadStatistics _loadStatistics;
 };
\ No newline at end of file
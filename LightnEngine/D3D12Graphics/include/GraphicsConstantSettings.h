@@ -2,5 +2,64 @@
 #include <dxgiformat.h>
 
 constexpr unsigned int FrameCount = 3;
+
+//CPUがGPUに先行できる最大フレーム数の初期値 (1～FrameCount)
+constexpr unsigned int DefaultMaxFramesInFlight = 2;
+
+//描画コマンドを並列に積む際、1ジョブに割り当てる最小メッシュ数
+constexpr unsigned int MinMeshCountPerRecordJob = 128;
+
+//コマンドコンテキストごとのコマンドアロケーター・コマンドリストの上限数
+//(開始+終了+デプス・メインの記録ジョブ) x 論理コア数 x FrameCount を十分に賄える値
+constexpr unsigned int MaxCommandAllocatorCountPerContext = 256;
+
+//アップロード用リングバッファのサイズ。1回のコピーはこの1/4ごとに分割される
+constexpr unsigned int UploadRingBufferSize = 64 * 1024 * 1024;
+
+//配置リソース用ヒープの1ページのサイズ。これより大きいリソースはコミットリソースで生成する
+constexpr unsigned int GpuHeapPageSize = 64 * 1024 * 1024;
+
+//64KBに満たないアップロードバッファ(定数バッファなど)をまとめるバッファの1ページのサイズ
+constexpr unsigned int SmallUploadBufferPageSize = 4 * 1024 * 1024;
+
+//CPU専用デスクリプタヒープの1ページのデスクリプタ数。埋まるとページを追加する
+constexpr unsigned int StagingDescriptorPageSize = 4096;
+constexpr unsigned int RenderTargetDescriptorPageSize = 256;
+
+//シェーダー可視ヒープの永続領域と、描画時にテーブルをコピーするリングのデスクリプタ数
+//リングは処理中の全フレーム分を賄う必要がある
+constexpr unsigned int PersistentDescriptorCount = 64 * 1024;
+constexpr unsigned int DescriptorRingCount = 64 * 1024;
+
+//バインドレステーブルのスロット数。永続領域から確保する
+constexpr unsigned int BindlessDescriptorCount = 16 * 1024;
+
+//1フレームで使い捨てる定数バッファ(カメラ・ライト・ドローごとのワールド行列)の領域サイズ
+constexpr unsigned int TransientConstantBufferSizePerFrame = 8 * 1024 * 1024;
+
+//ストリーミングするテクスチャの常駐メモリの予算。ロード時にすべて読み込むテクスチャは含まない
+constexpr unsigned int TextureStreamingBudget = 256 * 1024 * 1024;
+
+//ロード時に読み込むミップの最大サイズ(幅と高さの大きい方)。これより詳細なミップは必要になってから読み込む
+constexpr unsigned int TextureStreamingMinResidentSize = 64;
+
+//IoServiceに同時に出すストリーミングの読み込み要求の数と、1フレームでGPUに転送するミップの量
+constexpr unsigned int TextureStreamingMaxPendingLoadCount = 8;
+constexpr unsigned int TextureStreamingUploadSizePerFrame = 16 * 1024 * 1024;
+
+//Resources以下のファイルをまとめたアーカイブ。なければResources以下のファイルを直接読む
+constexpr const char* AssetArchivePath = "Resources.pak";
+constexpr const char* AssetMountPoint = "Resources/";
+
+//ファイルを読むI/Oスレッドの数と、ストリーミングなど優先度の低い読み込みが返さずに持てるバッファの合計
+constexpr unsigned int IoThreadCount = 2;
+
+//読み込みの完了コールバックを呼ぶスレッドの数。描画コマンドの記録とは別のスレッドで処理する
+constexpr unsigned int IoCompletionThreadCount = 2;
+constexpr unsigned int IoReadAheadBudget = 64 * 1024 * 1024;
+
+//コンパイルしたシェーダーとリフレクション結果のキャッシュ。ソースかインクルードを書き換えたシェーダーだけコンパイルし直す
+constexpr const char* ShaderCachePath = "ShaderCache.bin";
+
 constexpr DXGI_FORMAT RenderTargetFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 constexpr DXGI_FORMAT DepthStencilFormat = DXGI_FORMAT_D32_FLOAT;
\ No newline at end of file
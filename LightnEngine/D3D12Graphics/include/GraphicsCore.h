@@ -8,12 +8,26 @@
 #include "DescriptorHeap.h"
 #include "FrameResource.h"
 #include "CommandContext.h"
+#include "UploadRingBuffer.h"
+#include "TextureStreamer.h"
+#include "DdsLoadBenchmark.h"
+#include "MeshLoadBenchmark.h"
+#include "AssetLoadBenchmark.h"
+#include "IoLoadBenchmark.h"
+#include "GpuMemoryAllocator.h"
+#include "LinearConstantAllocator.h"
+#include "RenderGraph.h"
+#include "RenderGraphExecutor.h"
 #include "ImguiWindow.h"
 #include "RenderableEntity.h"
 #include "DebugGeometry.h"
 
 #include "RenderCommand.h"
 #include <LinerAllocator.h>
+#include <ThreadPool.h>
+#include <AssetFileSystem.h>
+#include <IoService.h>
+#include <ShaderCache.h>
 
 #ifdef _DEBUG
 #define DEBUG
@@ -21,6 +35,27 @@
 
 using namespace Microsoft::WRL;
 
+//フレームごとのCPUとGPUの並列度を計測する統計情報
+struct FramePacingStatistics {
+	static constexpr uint32 HistoryCount = 120;
+
+	//1フレーム分の計測結果を履歴に追加
+	void addFrame(float cpuFrameTime, float fenceWaitTime, uint32 framesInFlight);
+
+	//コマンド記録にかかった時間を記録
+	void addRecordTime(float recordTime, uint32 recordJobCount);
+
+	//履歴をImguiで表示
+	void drawImgui() const;
+
+	float cpuFrameTimes[HistoryCount] = {};
+	float fenceWaitTimes[HistoryCount] = {};
+	float framesInFlights[HistoryCount] = {};
+	float recordTimes[HistoryCount] = {};
+	uint32 historyOffset = 0;
+	uint32 lastRecordJobCount = 0;
+};
+
 class GraphicsCore :private NonCopyable {
 public:
 	GraphicsCore();
@@ -38,33 +73,100 @@ public:
 	void createSingleMeshMaterial(const String& name, const InitSettingsPerSingleMesh& singleMeshMaterialInfo);
 
 	SingleMeshRenderInstance createSingleMeshRenderInstance(const String& name, const VectorArray<InitSettingsPerSingleMesh>& materialInfos);
+
+	//既存インスタンスとパイプラインステートやデスクリプタを共有する描画インスタンスを生成
+	SingleMeshRenderInstance duplicateSingleMeshRenderInstance(const SingleMeshRenderInstance& source);
 	StaticMultiMeshRenderInstance createStaticMultiMeshRender(const String& name, const InitSettingsPerStaticMultiMesh& meshDatas);
 
 	RefPtr<GpuResourceManager> getGpuResourceManager();
 	RefPtr<DebugGeometryRender> getDebugGeometryRender();
 
+	//CPUがGPUに先行できる最大フレーム数を設定 (1～FrameCount)
+	void setMaxFramesInFlight(uint32 maxFramesInFlight);
+	uint32 getMaxFramesInFlight() const;
+
 public:
 	UINT _width;
 	UINT _height;
 
 private:
 
-	//̃t[܂őҋ@
+	//次のフレームまで待機
 	void moveToNextFrame();
 
+	//フレームペーシングの計測結果を表示
+	void drawFramePacingWindow();
+
+	//コマンドアロケーター等のプールの再利用状況を表示
+	static void drawFencedPoolStatistics(const char* name, const FencedPoolStatistics& statistics);
+
+	//フレームのパス構成をレンダーグラフで宣言してコンパイルする
+	void setupRenderGraph();
+
+	//ワーカースレッドで記録するコマンドリストにパス共通のステートを設定
+	void setupPassCommonState(RefPtr<ID3D12GraphicsCommandList> commandList, bool isDepthPass);
+
+	//シングルメッシュ数から描画コマンドを記録するジョブ数を決める
+	uint32 computeRecordJobCount(uint32 meshCount) const;
+
 	UINT _frameIndex;
 
+	//提出済みフレーム数と直近フレームの完了フェンス値
+	UINT64 _submittedFrameCount;
+	UINT64 _frameFenceValues[FrameCount];
+	uint32 _maxFramesInFlight;
+
+	//描画コマンドの並列記録用スレッドとジョブ数の上限
+	ThreadPool _commandRecordThreadPool;
+	uint32 _maxRecordJobCount;
+
+	//ファイル読み込みの完了コールバック用スレッド。IoServiceより先に宣言して後から破棄する
+	ThreadPool _ioCompletionThreadPool;
+
+	LARGE_INTEGER _timerFrequency;
+	LARGE_INTEGER _lastFrameTime;
+	FramePacingStatistics _framePacingStatistics;
+
 	D3D12_VIEWPORT _viewPort;
 	D3D12_RECT _scissorRect;
 
 	ComPtr<IDXGISwapChain3> _swapChain;
 	ComPtr<ID3D12Device> _device;
 
-	Texture2D _depthStencil;
+	//GPUリソースより先に宣言して、リソースの破棄が終わってから破棄されるようにする
+	GpuMemoryAllocator _gpuMemoryAllocator;
+
 	BufferView _dsv;
 
+	//フレームのパス構成とバリアはレンダーグラフで管理する
+	RenderGraph _renderGraph;
+	RenderGraphExecutor _renderGraphExecutor;
+	RenderGraphResourceHandle _backBufferResource;
+	RenderGraphResourceHandle _depthStencilResource;
+	uint32 _clearPass;
+	uint32 _depthPrepass;
+	uint32 _mainPass;
+	uint32 _overlayPass;
+
 	CommandContext _graphicsCommandContext;
 	CommandContext _computeCommandContext;
+	UploadRingBuffer _uploadRingBuffer;
+
+	//ロードしたファイルがアーカイブの領域を指すので、テクスチャストリーミングより先に宣言して後から破棄する
+	//ストリーミングが読み込んだバッファはIoServiceに返すので、IoServiceもテクスチャストリーミングより先に宣言する
+	AssetFileSystem _assetFileSystem;
+	IoService _ioService;
+	ShaderCache _shaderCache;
+	TextureStreamer _textureStreamer;
+
+	//デバッグウィンドウから実行したDDSロードの計測結果
+	DdsLoadBenchmarkResult _ddsLoadBenchmarkResult;
+	MeshLoadBenchmarkResult _meshLoadBenchmarkResult;
+	AssetLoadBenchmarkResult _assetLoadBenchmarkResult;
+	IoLoadBenchmarkResult _ioLoadBenchmarkResult;
+
+	//コンピュートキューに待たせた最後のアップロードフェンス値
+	UINT64 _lastWaitedUploadFenceValue;
 	FrameResource _frameResources[FrameCount];
 	DescriptorHeapManager _descriptorHeapManager;
 	GpuResourceManager _gpuResourceManager;
@@ -73,10 +175,11 @@ private:
 
 	RefPtr<FrameResource> _currentFrameResource;
 
-	VectorArray<StaticSingleMesh> _singleMeshes;
+	//インスタンスが要素のポインタを保持するので追加しても再配置されないコンテナを使う
+	DequeArray<StaticSingleMesh> _singleMeshes;
 	VectorArray<StaticMultiMesh> _multiMeshes;
 
-	ConstantBufferFrame _mainCameraConstantBuffer;
-	ConstantBufferFrame _directionalLightBuffer;
-	ConstantBufferFrame _pointlLightBuffer;
+	//フレーム定数と描画ごとの定数を毎フレーム切り出す
+	LinearConstantAllocator _transientConstantAllocator;
+	FrameConstantAddresses _frameConstantAddresses;
 };
\ No newline at end of file
@@ -11,16 +11,16 @@ class ImguiWindow {
 public:
 	~ImguiWindow();
 
-	//ImguiWIndow
+	//ImguiWIndow初期化
 	void init(HWND& hwnd, ID3D12Device* device);
 
-	//Imgui`揉
+	//Imgui描画初期化処理
 	void startFrame();
 
-	//ImguiWIndow`
+	//ImguiWIndowを描画
 	void renderFrame(ID3D12GraphicsCommandList* commandList);
 
-	//Imguij
+	//Imgui破棄
 	void shutdown();
 
 private:
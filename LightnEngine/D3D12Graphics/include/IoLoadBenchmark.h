@@ -0,0 +1,61 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include <IoService.h>
+
+struct IoLoadPriorityResult {
+	uint32 requestCount = 0;
+
+	//要求してから完了コールバックが呼ばれるまで
+	float averageMilliseconds = 0.0f;
+	float p50Milliseconds = 0.0f;
+	float p95Milliseconds = 0.0f;
+	float maxMilliseconds = 0.0f;
+};
+
+struct IoLoadBenchmarkResult {
+	uint32 fileCount = 0;
+	uint32 requestCount = 0;
+	uint64 totalSize = 0;
+
+	//IoServiceに優先度を混ぜてまとめて出したときと、同じ要求を1スレッドで順に読んだとき
+	float ioServiceSeconds = 0.0f;
+	float sequentialSeconds = 0.0f;
+
+	//IoServiceが実際に発行した読み込みの数と、ほかの要求とまとめて読んだ要求の数
+	uint32 readCount = 0;
+	uint32 coalescedRequestCount = 0;
+
+	IoLoadPriorityResult priorities[IO_PRIORITY_COUNT];
+
+	//IoServiceで読んだ内容が順に読んだ内容と一致したか
+	bool isValid = false;
+
+	float getIoServiceThroughput() const { return ioServiceSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / ioServiceSeconds : 0.0f; }
+	float getSequentialThroughput() const { return sequentialSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / sequentialSeconds : 0.0f; }
+};
+
+//ディレクトリ以下のDDSを、ミップのストリーミングのようにファイルの一部の範囲ずつ読む要求に分けて、IoServiceの読み込みを計測する
+//要求は1割を高い優先度、3割を通常、6割を低い優先度にしてまとめて出し、優先度ごとの待ち時間と全体のスループットを求める
+//比較として同じ要求をIoServiceを通さずに呼び出しスレッドで順に読む。どちらもキャッシュに載せてから計測する
+//アーカイブをマウントしていればIoServiceはアーカイブから読む。DDSはアーカイブでも圧縮しないので内容は個別のファイルと同じ
+class IoLoadBenchmark {
+public:
+	static IoLoadBenchmarkResult run(const String& directory);
+
+private:
+	struct ReadRange {
+		uint32 fileIndex;
+		uint64 offset;
+		uint64 size;
+		IoPriority priority;
+	};
+
+	static void collectFiles(const String& directory, VectorArray<String>& outFilePaths);
+	static void buildRanges(const VectorArray<String>& filePaths, VectorArray<ReadRange>& outRanges);
+
+	//要求ごとの内容のハッシュを返す。読めなかった要求は0
+	static bool readSequential(const VectorArray<String>& filePaths, const VectorArray<ReadRange>& ranges, VectorArray<uint64>& outHashes);
+	static void readIoService(const VectorArray<String>& filePaths, const VectorArray<ReadRange>& ranges, VectorArray<uint64>& outHashes, VectorArray<float>& outLatencies);
+};
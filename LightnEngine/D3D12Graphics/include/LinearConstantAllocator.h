@@ -0,0 +1,50 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include <atomic>
+#include "GraphicsConstantSettings.h"
+#include "GpuResource.h"
+
+//リニアアロケーターから確保した定数バッファ領域
+struct TransientConstant {
+	void* cpuAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+};
+
+//フレームごとに使い捨てる定数バッファを1つの大きなアップロードバッファから切り出す
+//バッファはフレームバッファリング数の領域に分かれていて、フレームの先頭でその領域の先頭に戻すだけなので解放処理がない
+//CPU側のコピーを持たず確保した領域に直接書き込むので、ドローごとの定数も256バイトのバンプ確保1回で済む
+class LinearConstantAllocator :private NonCopyable {
+public:
+	LinearConstantAllocator();
+
+	void create(RefPtr<ID3D12Device> device, uint32 sizePerFrame);
+	void shutdown();
+
+	//フレームの先頭で呼ぶ。このフレームインデックスの領域をGPUが使い終えていることは呼び出し側で保証する
+	void beginFrame(uint32 frameIndex);
+
+	//256バイトアラインで確保する。描画コマンドの並列記録中に複数スレッドから呼んでよい
+	//フレームの領域が足りなければHrException(E_OUTOFMEMORY)を投げる
+	TransientConstant allocate(uint32 size);
+
+	//確保してデータを書き込み、GPU仮想アドレスを返す
+	template <class T>
+	D3D12_GPU_VIRTUAL_ADDRESS push(const T& data) {
+		TransientConstant constant = allocate(sizeof(T));
+		memcpy(constant.cpuAddress, &data, sizeof(T));
+		return constant.gpuAddress;
+	}
+
+	uint32 getSizePerFrame() const { return _sizePerFrame; }
+	uint32 getUsedSize() const { return min(static_cast<uint32>(_offset.load()), _sizePerFrame); }
+	uint32 getPeakUsedSize() const { return _peakUsedSize; }
+
+private:
+	GpuBufferDynamic _buffer;
+	uint32 _sizePerFrame;
+	uint32 _frameStart;
+	std::atomic<uint32> _offset;
+	uint32 _peakUsedSize;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+
+struct MeshLoadBenchmarkResult {
+	uint32 fileCount = 0;
+	uint32 meshCount = 0;
+	uint32 v1FileCount = 0;
+	uint64 totalSize = 0;
+
+	//ファイルをストリームで読み、頂点とインデックスを配列に取り出してからコピーする従来の経路
+	float readSeconds = 0.0f;
+
+	//マップした領域のセクションから直接コピーする経路
+	float mappedSeconds = 0.0f;
+
+	//v2のセクションのハッシュを照合する時間。デバッグビルドのロードで追加される分
+	float verifySeconds = 0.0f;
+
+	float getReadThroughput() const { return readSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / readSeconds : 0.0f; }
+	float getMappedThroughput() const { return mappedSeconds > 0.0f ? totalSize / (1024.0f * 1024.0f) / mappedSeconds : 0.0f; }
+};
+
+//フォルダ内のメッシュファイルを2つの経路で解析し、CPU側のロードのスループットを比べる
+//頂点とインデックスをアップロードバッファ相当のメモリに書き込むところまでを計測し、GPUへの転送は含まない
+class MeshLoadBenchmark {
+public:
+	static MeshLoadBenchmarkResult run(const String& directory);
+
+private:
+	static bool loadWithRead(const String& filePath, VectorArray<byte>& fileData, VectorArray<byte>& uploadData);
+	static bool loadWithMapping(const String& filePath, VectorArray<byte>& uploadData);
+	static bool verifyWithMapping(const String& filePath);
+};
@@ -5,13 +5,16 @@
 #include <locale> 
 #include <codecvt> 
 #include <cstdio>
+#include <cstring>
 #include <Utility.h>
+#include <IoService.h>
+#include <ShaderCache.h>
 #include "stdafx.h"
 #include "D3D12Helper.h"
 #include "D3D12Util.h"
 #include "GraphicsConstantSettings.h"
 
-//QƂ݂̂̃IuWFNg
+//参照のみのオブジェクト
 struct RefRootSignature {
 	RefRootSignature() :rootSignature(nullptr) {}
 	RefRootSignature(RefPtr<ID3D12RootSignature> rootSignature) :rootSignature(rootSignature) {}
@@ -24,6 +27,9 @@ struct RefPipelineState {
 	RefPtr<ID3D12PipelineState> pipelineState;
 };
 
+//シェーダーキャッシュに入れるリフレクション結果の書式のバージョン。下の構造体の書き出しを変えたら上げる
+constexpr uint32 ShaderReflectionFormatVersion = 1;
+
 struct ShaderReflectionCBV {
 	String name;
 	String type;
@@ -31,7 +37,19 @@ struct ShaderReflectionCBV {
 	uint32 size;
 	uint32 elements;
 
-	//ϐ̌^TCYƌ^Zbg
+	void serialize(ShaderCacheWriter& writer) const {
+		writer.writeString(name);
+		writer.writeString(type);
+		writer.write(startOffset);
+		writer.write(size);
+		writer.write(elements);
+	}
+
+	bool deserialize(ShaderCacheReader& reader) {
+		return reader.readString(name) && reader.readString(type) && reader.read(startOffset) && reader.read(size) && reader.read(elements);
+	}
+
+	//変数の型名からサイズと型名をセット
 	void setSizeAndType(const String& name) {
 		this->type = name;
 
@@ -57,7 +75,32 @@ struct ShaderReflectionCB {
 	String name;
 	VectorArray<ShaderReflectionCBV> variables;
 
-	//萔obt@Ɋ܂܂ϐ̑TCY擾
+	void serialize(ShaderCacheWriter& writer) const {
+		writer.write(bindPoint);
+		writer.writeString(name);
+		writer.write(static_cast<uint32>(variables.size()));
+		for (const auto& variable : variables) {
+			variable.serialize(writer);
+		}
+	}
+
+	bool deserialize(ShaderCacheReader& reader) {
+		uint32 variableCount = 0;
+		if (!reader.read(bindPoint) || !reader.readString(name) || !reader.read(variableCount) || variableCount > reader.getRemainingSize()) {
+			return false;
+		}
+
+		variables.resize(variableCount);
+		for (auto& variable : variables) {
+			if (!variable.deserialize(reader)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//定数バッファに含まれる変数の総サイズを取得
 	uint32 getBufferSize() const {
 		uint32 size = 0;
 		for (const auto& variable : variables) {
@@ -67,7 +110,7 @@ struct ShaderReflectionCB {
 		return size;
 	}
 
-	//O萔obt@Ɋ܂܂ϐ擾
+	//名前から定数バッファに含まれる変数を取得
 	const RefPtr<const ShaderReflectionCBV> getVariable(const String& name) const {
 		for (const auto& variable : variables) {
 			if (variable.name == name) {
@@ -80,22 +123,217 @@ struct ShaderReflectionCB {
 };
 
 struct ShaderReflectionResult {
-	//Root32bitConstantɊ܂܂l̐擾(4byteϐ邩)
+	//Root32bitConstantに含まれる値の数を取得(4byte変数がいくつあるか)
 	uint32 getRoot32bitConstantNum(uint32 index) const {
 		return root32bitConstants[index].getBufferSize() / 4;
 	}
 
+	void serialize(ShaderCacheWriter& writer) const {
+		serializeBuffers(writer, constantBuffers);
+		serializeBuffers(writer, root32bitConstants);
+		serializeRanges(writer, cbvRangeDescs);
+		serializeRanges(writer, srvRangeDescs);
+	}
+
+	//途中で壊れていればfalse。その場合の中身は使わない
+	bool deserialize(ShaderCacheReader& reader) {
+		return deserializeBuffers(reader, constantBuffers) && deserializeBuffers(reader, root32bitConstants)
+			&& deserializeRanges(reader, cbvRangeDescs) && deserializeRanges(reader, srvRangeDescs);
+	}
+
 	VectorArray<ShaderReflectionCB> constantBuffers;
 	VectorArray<ShaderReflectionCB> root32bitConstants;
 	VectorArray<D3D12_DESCRIPTOR_RANGE1> cbvRangeDescs;
 	VectorArray<D3D12_DESCRIPTOR_RANGE1> srvRangeDescs;
+
+private:
+	static void serializeBuffers(ShaderCacheWriter& writer, const VectorArray<ShaderReflectionCB>& buffers) {
+		writer.write(static_cast<uint32>(buffers.size()));
+		for (const auto& buffer : buffers) {
+			buffer.serialize(writer);
+		}
+	}
+
+	static bool deserializeBuffers(ShaderCacheReader& reader, VectorArray<ShaderReflectionCB>& outBuffers) {
+		uint32 bufferCount = 0;
+		if (!reader.read(bufferCount) || bufferCount > reader.getRemainingSize()) {
+			return false;
+		}
+
+		outBuffers.resize(bufferCount);
+		for (auto& buffer : outBuffers) {
+			if (!buffer.deserialize(reader)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//ディスクリプタレンジはメモリ上の表現のまま書く
+	static void serializeRanges(ShaderCacheWriter& writer, const VectorArray<D3D12_DESCRIPTOR_RANGE1>& ranges) {
+		writer.write(static_cast<uint32>(ranges.size()));
+		writer.writeBytes(ranges.data(), ranges.size() * sizeof(D3D12_DESCRIPTOR_RANGE1));
+	}
+
+	static bool deserializeRanges(ShaderCacheReader& reader, VectorArray<D3D12_DESCRIPTOR_RANGE1>& outRanges) {
+		uint32 rangeCount = 0;
+		if (!reader.read(rangeCount) || rangeCount > reader.getRemainingSize() / sizeof(D3D12_DESCRIPTOR_RANGE1)) {
+			return false;
+		}
+
+		outRanges.resize(rangeCount);
+		return reader.readBytes(outRanges.data(), rangeCount * sizeof(D3D12_DESCRIPTOR_RANGE1));
+	}
 };
 
 using namespace Microsoft::WRL;
 
+//シェーダーのソースとインクルードをIoServiceで読むインクルードハンドラー
+//ローカルのインクルードはインクルードしたファイルのあるディレクトリ、作業ディレクトリの順に探す
+class ShaderIncludeHandler :public ID3DInclude {
+public:
+	explicit ShaderIncludeHandler(const String& rootDirectory) :_rootDirectory(rootDirectory) {}
+
+	HRESULT __stdcall Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* outData, UINT* outSize) override {
+		String directory = _rootDirectory;
+		for (const auto& includedFile : _includedFiles) {
+			if (includedFile.source.data() == parentData) {
+				directory = includedFile.directory;
+				break;
+			}
+		}
+
+		IncludedFile includedFile;
+		String filePath = directory + fileName;
+		if (!readSource(filePath, includedFile.source)) {
+			filePath = fileName;
+			if (!readSource(filePath, includedFile.source)) {
+				return E_FAIL;
+			}
+		}
+
+		includedFile.directory = ShaderSourceScanner::getDirectory(filePath);
+		*outData = includedFile.source.data();
+		*outSize = static_cast<UINT>(includedFile.source.size());
+		_includedFiles.emplace_back(std::move(includedFile));
+		return S_OK;
+	}
+
+	HRESULT __stdcall Close(LPCVOID data) override {
+		for (auto itr = _includedFiles.begin(); itr != _includedFiles.end(); ++itr) {
+			if (itr->source.data() == data) {
+				_includedFiles.erase(itr);
+				break;
+			}
+		}
+
+		return S_OK;
+	}
+
+	//コンパイルを待っているので、ストリーミングより先に読む優先度で読む
+	static bool readSource(const String& filePath, IoBuffer& outSource) {
+		return IoService::instance().readBlocking(filePath, 0, IO_READ_TO_END, IO_PRIORITY_HIGH, outSource);
+	}
+
+	//シェーダーキャッシュのキーを作るときにインクルードをたどるのに使う。IoServiceを作っていなければファイルから直接読む
+	static bool readSourceData(const String& filePath, VectorArray<byte>& outData) {
+		if (!IoService::isCreated()) {
+			return ShaderSourceScanner::readFile(filePath, outData);
+		}
+
+		IoBuffer source;
+		if (!readSource(filePath, source)) {
+			return false;
+		}
+
+		outData.assign(source.data(), source.data() + source.size());
+		return true;
+	}
+
+private:
+	struct IncludedFile {
+		String directory;
+		IoBuffer source;
+	};
+
+	String _rootDirectory;
+	VectorArray<IncludedFile> _includedFiles;
+};
+
 class Shader :private NonCopyable {
 public:
-	//VF[_[oCi烊tNVʂ擾
+	//ソースをIoServiceで読んでコンパイルする。IoServiceを作っていなければファイルから直接コンパイルする
+	static void compileFromFile(const String& fileName, const D3D_SHADER_MACRO* defines, const char* entryPoint, const char* target, UINT flags, ComPtr<ID3DBlob>& outShader) {
+		if (!IoService::isCreated()) {
+			throwIfFailed(D3DCompileFromFile(convertWString(fileName).c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, target, flags, 0, &outShader, nullptr));
+			return;
+		}
+
+		IoBuffer source;
+		if (!ShaderIncludeHandler::readSource(fileName, source)) {
+			throwIfFailed(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
+		}
+
+		ShaderIncludeHandler includeHandler(ShaderSourceScanner::getDirectory(fileName));
+		throwIfFailed(D3DCompile(source.data(), static_cast<SIZE_T>(source.size()), fileName.c_str(), defines, &includeHandler, entryPoint, target, flags, 0, &outShader, nullptr));
+	}
+
+	//ソースとインクルードの内容がキャッシュしたときと同じなら、バイトコードとリフレクション結果をシェーダーキャッシュから読む
+	//違えばコンパイルしてキャッシュを置き換える。isReflectedでなければリフレクションしない
+	void compile(const String& fileName, const D3D_SHADER_MACRO* defines, const char* entryPoint, const char* target, UINT flags, bool isReflected) {
+		if (!ShaderCache::isCreated()) {
+			compileFromFile(fileName, defines, entryPoint, target, flags, shader);
+			if (isReflected) {
+				shaderReflectionResult = getShaderReflection(getByteCode());
+			}
+			return;
+		}
+
+		ShaderCompileDesc desc;
+		desc.filePath = fileName;
+		desc.entryPoint = entryPoint;
+		desc.target = target;
+		desc.flags = flags;
+		desc.compilerVersion = D3D_COMPILER_VERSION;
+		desc.settingsHash = isReflected ? ShaderReflectionFormatVersion : 0;
+		for (const D3D_SHADER_MACRO* define = defines; define != nullptr && define->Name != nullptr; ++define) {
+			desc.defines.emplace_back(define->Name, define->Definition != nullptr ? define->Definition : "");
+		}
+
+		//ソースが読めなければキャッシュを使わず、コンパイルで失敗させる
+		ShaderCache& shaderCache = ShaderCache::instance();
+		VectorArray<ShaderSourceFile> sourceFiles;
+		const bool isScanned = ShaderSourceScanner::scan(fileName, ShaderIncludeHandler::readSourceData, sourceFiles);
+		const uint64 identityHash = ShaderCache::computeIdentityHash(desc);
+		const uint64 key = ShaderCache::computeKey(desc, sourceFiles);
+
+		VectorArray<byte> byteCode;
+		VectorArray<byte> reflection;
+		if (isScanned && shaderCache.find(identityHash, key, byteCode, reflection)) {
+			ShaderCacheReader reader(reflection.data(), reflection.size());
+			if (!isReflected || (shaderReflectionResult.deserialize(reader) && reader.isEnd())) {
+				throwIfFailed(D3DCreateBlob(static_cast<SIZE_T>(byteCode.size()), &shader));
+				memcpy(shader->GetBufferPointer(), byteCode.data(), byteCode.size());
+				return;
+			}
+		}
+
+		compileFromFile(fileName, defines, entryPoint, target, flags, shader);
+
+		reflection.clear();
+		if (isReflected) {
+			shaderReflectionResult = getShaderReflection(getByteCode());
+			ShaderCacheWriter writer(reflection);
+			shaderReflectionResult.serialize(writer);
+		}
+
+		if (isScanned) {
+			shaderCache.store(identityHash, key, shader->GetBufferPointer(), shader->GetBufferSize(), reflection);
+		}
+	}
+
+	//シェーダーバイナリからリフレクション結果を取得する
 	ShaderReflectionResult getShaderReflection(const D3D12_SHADER_BYTECODE& byteCode) {
 		ShaderReflectionResult result;
 		ComPtr<ID3D12ShaderReflection> shaderReflector;
@@ -106,7 +344,7 @@ public:
 
 		result.constantBuffers.reserve(shaderDesc.ConstantBuffers);
 
-		//萔obt@擾
+		//定数バッファ取得
 		for (UINT i = 0; i < shaderDesc.ConstantBuffers; ++i) {
 			ID3D12ShaderReflectionConstantBuffer* constantBuffer = shaderReflector->GetConstantBufferByIndex(i);
 			D3D12_SHADER_BUFFER_DESC constantBufferDesc = {};
@@ -132,7 +370,7 @@ public:
 				shaderReflectionCb.variables[j].setSizeAndType(cbVariableTypeDesc.Name);
 			}
 
-			//萔obt@ƂĈ̂32bit萔ƂĂ̂萔obt@̐擪Ŕf
+			//定数バッファとして扱うのか32bit定数としてあつかうのか定数バッファの先頭文字で判断
 			if (shaderReflectionCb.name.substr(0, 20) == "ROOT_32BIT_CONSTANTS") {
 				result.root32bitConstants.emplace_back(shaderReflectionCb);
 			}
@@ -141,7 +379,7 @@ public:
 			}
 		}
 
-		//܂͂̃VF[_[Ɋ܂܂郊\[X̐𒲂ׂ
+		//まずはこのシェーダーに含まれるリソースの数を調べる
 		uint32 textureCount = 0;
 		for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
 			D3D12_SHADER_INPUT_BIND_DESC bindDesc = {};
@@ -164,13 +402,13 @@ public:
 		uint32 root32bitCounter = 0;
 		uint32 textureCounter = 0;
 
-		//ׂ\[XDescriptorRangeDesc\z
+		//調べたリソース数からDescriptorRangeDescを構築
 		for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
 			D3D12_SHADER_INPUT_BIND_DESC bindDesc = {};
 			shaderReflector->GetResourceBindingDesc(i, &bindDesc);
 
 			switch (bindDesc.Type) {
-				//萔obt@Ȃ烌WX^ԍ𒲂ׂēo^
+				//定数バッファならレジスタ番号を調べて登録
 			case D3D_SHADER_INPUT_TYPE::D3D_SIT_CBUFFER:
 				for (size_t j = 0; j < result.constantBuffers.size(); ++j) {
 					auto& cb = result.constantBuffers[j];
@@ -189,7 +427,7 @@ public:
 					cbCounter++;
 				}
 
-				//[g32bit萔ȂoCh|Cĝ݂Zbg
+				//ルート32bit定数ならバインドポイントのみをセット
 				for (size_t j = 0; j < result.root32bitConstants.size(); ++j) {
 					if (result.root32bitConstants[j].name != bindDesc.Name) {
 						continue;
@@ -201,7 +439,7 @@ public:
 
 				break;
 
-				//eNX`ȂSRVƂēo^
+				//テクスチャならSRVとして登録
 			case D3D_SHADER_INPUT_TYPE::D3D_SIT_TEXTURE:
 				result.srvRangeDescs[textureCounter].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
 				result.srvRangeDescs[textureCounter].NumDescriptors = 1;
@@ -217,7 +455,7 @@ public:
 		return result;
 	}
 
-	//萔obt@̃TCY萔obt@ƂɔzŎ擾
+	//定数バッファのサイズを定数バッファごとに配列で取得
 	VectorArray<uint32> getConstantBufferSizes() const {
 		VectorArray<uint32> cbSizes(shaderReflectionResult.constantBuffers.size());
 		for (size_t i = 0; i < cbSizes.size(); ++i) {
@@ -227,7 +465,7 @@ public:
 		return cbSizes;
 	}
 
-	//萔obt@̃TCY萔obt@ƂɔzŎ擾
+	//定数バッファのサイズを定数バッファごとに配列で取得
 	VectorArray<uint32> getRoot32bitConstantSizes() const {
 		VectorArray<uint32> cbSizes(shaderReflectionResult.root32bitConstants.size());
 		for (size_t i = 0; i < cbSizes.size(); ++i) {
@@ -237,7 +475,7 @@ public:
 		return cbSizes;
 	}
 
-	//VF[_[oCiD3D12_SHADER_BYTECODEŎ擾
+	//シェーダーバイナリをD3D12_SHADER_BYTECODEで取得
 	D3D12_SHADER_BYTECODE getByteCode() const {
 		D3D12_SHADER_BYTECODE byteCode = {};
 		byteCode.BytecodeLength = shader->GetBufferSize();
@@ -245,7 +483,7 @@ public:
 		return byteCode;
 	}
 
-	//VF[_[\[Xr[RootParameter𐶐
+	//シェーダーリソースビューのRootParameterを生成
 	D3D12_ROOT_PARAMETER1 getSrvRootParameter(D3D12_SHADER_VISIBILITY visibility) const {
 		D3D12_ROOT_PARAMETER1 parameterDesc = {};
 		parameterDesc.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -256,7 +494,7 @@ public:
 		return parameterDesc;
 	}
 
-	//萔obt@RootParameter𐶐
+	//定数バッファのRootParameterを生成
 	D3D12_ROOT_PARAMETER1 getCbvRootParameter(D3D12_SHADER_VISIBILITY visibility) const {
 		D3D12_ROOT_PARAMETER1 parameterDesc = {};
 		parameterDesc.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -267,15 +505,15 @@ public:
 		return parameterDesc;
 	}
 
-	//[g32bit萔RootParameter𐶐
+	//ルート32bit定数のRootParameterを生成
 	VectorArray<D3D12_ROOT_PARAMETER1> getRoot32bitRootParameter(D3D12_SHADER_VISIBILITY visibility) const {
 		VectorArray <D3D12_ROOT_PARAMETER1> parameterDescs(shaderReflectionResult.root32bitConstants.size());
 
-		//[g32bit萔RANGEł܂Ƃ߂Ȃ̂ROOT_PARAMETER鐔
+		//ルート32bit定数はRANGEでまとめられないのでROOT_PARAMETERをある数分生成する
 		for (size_t i = 0; i < parameterDescs.size(); ++i) {
 			parameterDescs[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 			parameterDescs[i].ShaderVisibility = visibility;
-			parameterDescs[i].Constants.Num32BitValues = shaderReflectionResult.root32bitConstants[i].getBufferSize() / 4;//32bitƂ̐Ȃ̂4byteŊ
+			parameterDescs[i].Constants.Num32BitValues = shaderReflectionResult.root32bitConstants[i].getBufferSize() / 4;//32bitごとの数なので4byteで割る
 			parameterDescs[i].Constants.RegisterSpace = 0;
 			parameterDescs[i].Constants.ShaderRegister = shaderReflectionResult.root32bitConstants[i].bindPoint;
 		}
@@ -289,11 +527,10 @@ public:
 
 class VertexShader :public Shader {
 public:
-	void create(const String& fileName, const VectorArray<D3D12_INPUT_ELEMENT_DESC>& layouts, UINT flags = 0) {
-		throwIfFailed(D3DCompileFromFile(convertWString(fileName).c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1", flags, 0, &shader, nullptr));
+	//definesは頂点フォーマットの切り替えなどに使う。末尾は{ nullptr, nullptr }で終える
+	void create(const String& fileName, const VectorArray<D3D12_INPUT_ELEMENT_DESC>& layouts, UINT flags = 0, const D3D_SHADER_MACRO* defines = nullptr) {
+		compile(fileName, defines, "VSMain", "vs_5_1", flags, true);
 		inputLayouts = layouts;
-
-		shaderReflectionResult = getShaderReflection(getByteCode());
 	}
 
 	D3D12_ROOT_PARAMETER1 getSrvRootParameter() const {
@@ -314,8 +551,7 @@ public:
 class PixelShader :public Shader {
 public:
 	void create(const String& fileName, UINT flags = 0) {
-		throwIfFailed(D3DCompileFromFile(convertWString(fileName).c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1", flags, 0, &shader, nullptr));
-		shaderReflectionResult = getShaderReflection(getByteCode());
+		compile(fileName, nullptr, "PSMain", "ps_5_1", flags, true);
 	}
 
 	D3D12_ROOT_PARAMETER1 getSrvRootParameter() const {
@@ -334,7 +570,7 @@ public:
 class ComputeShader :public Shader {
 public:
 	void create(const String& fileName, UINT flags = 0) {
-		throwIfFailed(D3DCompileFromFile(convertWString(fileName).c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "CSMain", "cs_5_1", flags, 0, &shader, nullptr));
+		compile(fileName, nullptr, "CSMain", "cs_5_1", flags, false);
 	}
 };
 
@@ -384,7 +620,7 @@ public:
 	void create(RefPtr<ID3D12Device> device, const RefPtr<VertexShader> vertexShader, const RefPtr<PixelShader> pixelShader) {
 		VectorArray<D3D12_ROOT_PARAMETER1> rootParameters;
 
-		//sNZVF[_[
+		//ピクセルシェーダー
 		if (pixelShader) {
 			const ShaderReflectionResult& result = pixelShader->shaderReflectionResult;
 			if (!result.srvRangeDescs.empty()) {
@@ -401,7 +637,7 @@ public:
 			}
 		}
 
-		//_VF[_[
+		//頂点シェーダー
 		if (vertexShader) {
 			const ShaderReflectionResult& result = vertexShader->shaderReflectionResult;
 			if (!result.srvRangeDescs.empty()) {
@@ -418,10 +654,10 @@ public:
 			}
 		}
 
-		//Ƃ肠̐ÓITv[gp(݂͂ŌŒ)
+		//とりあえずこの静的サンプラーを使用(現在はこれで固定)
 		D3D12_STATIC_SAMPLER_DESC samplerDesc = WrapSamplerDesc();
 
-		//[gVOl`̃T|[go[W`FbN(Ă邾BBB)
+		//ルートシグネチャのサポートバージョンをチェック(してるだけ。。。)
 		D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
 		if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData)))) {
@@ -431,7 +667,7 @@ public:
 		create(device, rootParameters, &samplerDesc);
 	}
 
-	//QƂ݂̂̃Rs[IuWFNg擾
+	//参照のみのコピーオブジェクトを取得
 	RefRootSignature getRefRootSignature() const {
 		return RefRootSignature(_rootSignature.Get());
 	}
@@ -542,13 +778,13 @@ public:
 		NAME_D3D12_OBJECT(_pipelineState.Get());
 	}
 
-	//ComputePupelineState쐬
+	//ComputePupelineStateを作成
 	void createCompute(RefPtr<ID3D12Device> device, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) {
 		throwIfFailed(device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&_pipelineState)));
 		NAME_D3D12_OBJECT(_pipelineState.Get());
 	}
 
-	//QƂ݂̂̃Rs[IuWFNg擾
+	//参照のみのコピーオブジェクトを取得
 	RefPipelineState getRefPipelineState() const {
 		return RefPipelineState(_pipelineState.Get());
 	}
@@ -6,29 +6,40 @@
 
 #include "AABB.h"
 #include "Camera.h"
+#include <MeshletBuilder.h>
+#include <MeshSimplifier.h>
 
 //#define ENABLE_AABB_DEBUG_DRAW
 
 class StaticSingleMesh {
 public:
-	void create(RefPtr<ID3D12Device> device, const String& meshName, const ConstantBufferFrame& cameraBuffer, const VectorArray<InitSettingsPerSingleMesh>& materialInfos);
+	void create(RefPtr<ID3D12Device> device, const String& meshName, const VectorArray<InitSettingsPerSingleMesh>& materialInfos);
 	
-	//e_OpX
+	//各レンダリングパス
 	void setupDepthPassCommand(RenderSettings& settings);
 	void setupMainPassCommand(RenderSettings& settings);
 
-	//eCX^XƂ̃[hsXV
+	//各インスタンスごとのワールド行列を更新
 	void updateWorldMatrix(const Matrix4& worldMatrix);
 
 	VectorArray<MaterialCommandGraphics> _depthMaterials;
 	VectorArray<MaterialCommandGraphics> _mainMaterials;
 	RefPtr<VertexAndIndexBuffer> _mesh;
+
+	//描画時にメッシュの頂点の復元定数と一緒にドローごとの定数として書き込む
+	Matrix4 _worldMatrix;
 };
 
 struct PerInstanceMeshInfo {
 	Matrix4 mtxWorld;
 	AABB boundingBox;
+
+	//メッシュのLOD0のカリング結果の番号。LODごとの結果はその後ろに続く
 	uint32 indirectArgumentIndex;
+
+	//LOD0を含めたLODの数と、LODごとのAABBの対角線に対するずれ。[0]はLOD0なので0
+	uint32 lodCount;
+	float lodErrors[MESH_MAX_LOD_COUNT];
 };
 
 struct InstacingVertexData {
@@ -46,6 +57,9 @@ struct TextureIndex {
 struct GpuCullingCameraConstant {
 	Vector4 cameraPosition;
 	Vector4 frustumPlanes[4];
+
+	//xは画面の高さ/tan(fovY/2)で、境界球の半径/距離に掛けると画面上の直径(ピクセル)になる。yは許すずれのピクセル数
+	Vector4 lodParameters;
 };
 
 struct IndirectCommand {
@@ -53,10 +67,15 @@ struct IndirectCommand {
 	D3D12_INDEX_BUFFER_VIEW indexBufferView;
 	D3D12_VERTEX_BUFFER_VIEW perInstanceVertexBufferView;
 	TextureIndex textureIndices;
+	VertexDequantization dequantization;
 	D3D12_DRAW_INDEXED_ARGUMENTS drawArguments;
 };
 
+//ルート定数で渡すテクスチャインデックスと頂点の復元定数のDWORD数
+constexpr UINT INDIRECT_DRAW_CONSTANT_COUNT = (sizeof(TextureIndex) + sizeof(VertexDequantization)) / sizeof(UINT);
+
 struct InIndirectCommand {
+	//[0]がメッシュとLODの組の番号、[1]が頂点フォーマット
 	uint32 meshIndex[4];
 	IndirectCommand indirectCommand;
 };
@@ -66,38 +85,64 @@ struct PerMeshData {
 	VectorArray<TextureIndex> textureIndices;
 };
 
+//CPUでクラスター単位のカリングやLODの選択を見積もるのに使うインスタンス
+struct CpuCullingInstance {
+	RefPtr<VertexAndIndexBuffer> mesh;
+	Matrix4 mtxWorld;
+	AABB boundingBox;
+};
+
+//インスタンスカリングを通ったインスタンスのLODの選択結果
+struct LodSelectionStatistics {
+	uint32 instanceCount = 0;
+	uint32 lodInstanceCounts[MESH_MAX_LOD_COUNT] = {};
+	uint64 lod0TriangleCount = 0;
+	uint64 selectedTriangleCount = 0;
+};
+
 struct InitSettingsPerStaticMultiMesh {
 	VectorArray<String> meshNames;
 	VectorArray<PerMeshData> meshes;
 	VectorArray<String> textureNames;
 };
 
-struct InitBufferInfo {
-	ConstantBufferFrame& cameraBuffer;
-	ConstantBufferFrame& directionalLightBuffer;
-	ConstantBufferFrame& pointLightBuffer;
-};
-
 class StaticMultiMesh {
 public:
-	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const InitBufferInfo& bufferInfo, const InitSettingsPerStaticMultiMesh& initInfo);
+	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, const InitSettingsPerStaticMultiMesh& initInfo);
 	
-	//GPUJO
+	//GPUカリング　コンピュートキュー用のコマンドリストに積む
 	void onCompute(RenderSettings& settings);
 
-	//e_OpX
+	//各レンダリングパス
 	void setupDepthPassCommand(RenderSettings& settings);
 	void setupMainPassCommand(RenderSettings& settings);
 
-	//VF[_[ɓn߂̎XV
-	void updateCullingCameraInfo(const Camera& camera, uint32 frameIndex);
+	//シェーダーに渡すための視錐台とLOD選択の情報を更新
+	void updateCullingCameraInfo(const Camera& camera, uint32 screenHeight, float lodErrorPixels, uint32 frameIndex);
+
+	//インスタンスカリングを通ったメッシュをメッシュレット単位でカリングし、除外できる三角形を数える
+	//シェーダーのIsMeshletVisibleと同じ判定をCPUで行う
+	void updateMeshletCullingStatistics(const Camera& camera);
+
+	//インスタンスカリングを通ったメッシュのLODを選び、LOD0で描いた場合と三角形の数を比べる
+	//GpuCulling_cs.hlslと同じくMeshSimplifier::selectLodで選ぶ
+	void updateLodSelectionStatistics(const Camera& camera, uint32 screenHeight, float lodErrorPixels);
 
-	//GPUJǑʂi[obt@̃\[XoAݒ
+	//GPUカリングの結果を格納するバッファのリソースバリアを設定
 	void culledBufferBarrier(RefPtr<ID3D12GraphicsCommandList> commandList, D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, uint32 frameIndex) const;
 
 	UINT _indirectArgumentCount;
 	UINT _meshCount;
-	UINT _indirectArgumentDstCounterOffset;
+
+	//カリング結果はメッシュとLODの組ごとに別のバッファに積み、LODごとに別のドローにする
+	//_lodSlotOffsetsはメッシュごとのLOD0の番号で、_uavCounterOffsetsは組ごとに持つ
+	UINT _cullingSlotCount;
+	VectorArray<uint32> _lodSlotOffsets;
+
+	//頂点フォーマットごとにIndirectBufferを区切り、別々のカウンタで積んでExecuteIndirectを分ける
+	UINT _indirectArgumentCounts[MESH_VERTEX_FORMAT_COUNT];
+	UINT _indirectArgumentDstOffsets[MESH_VERTEX_FORMAT_COUNT];
+	UINT _indirectArgumentDstCounterOffsets[MESH_VERTEX_FORMAT_COUNT];
 	UINT _gpuCullingDispatchCount;
 	VectorArray<uint32> _uavCounterOffsets;
 
@@ -108,11 +153,20 @@ public:
 	MaterialCommandGraphics _depthPassCommand;
 	MaterialCommandGraphics _mainPassCommand;
 
-	VectorArray<RefPtr<GpuBuffer>> _gpuDrivenInstanceCulledBuffers;
+	//頂点フォーマットごとの入力レイアウトのパイプラインステート。使われないフォーマットは生成しない
+	RefPipelineState _depthPassPipelineStates[MESH_VERTEX_FORMAT_COUNT];
+	RefPipelineState _mainPassPipelineStates[MESH_VERTEX_FORMAT_COUNT];
+
+	//コンピュートキューで次フレームのカリングと並行実行できるようにフレームごとに持つ
+	VectorArray<RefPtr<GpuBuffer>> _gpuDrivenInstanceCulledBuffers[FrameCount];
 	RefPtr<ConstantBuffer> _gpuCullingCameraConstantBuffers[FrameCount];
-	RefPtr<GpuBuffer> _indirectArgumentDstBuffer;
+	RefPtr<GpuBuffer> _indirectArgumentDstBuffers[FrameCount];
 	RefPtr<GpuBuffer> _uavCounterReset;
 
+	VectorArray<CpuCullingInstance> _cpuCullingInstances;
+	MeshletCullingStatistics _meshletCullingStatistics;
+	LodSelectionStatistics _lodSelectionStatistics;
+
 #ifdef ENABLE_AABB_DEBUG_DRAW
 	VectorArray<AABB> _boundingBoxies;
 #endif
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <Utility.h>
+
+//パスが読み書きするリソースを宣言し、バリア・不要パスの除去・トランジェントリソースのメモリエイリアスを計算するレンダーグラフ
+//デバイスに依存しないので、コンパイル結果はD3D12なしで検証できる。実際のバリア発行とリソース生成はRenderGraphExecutorが行う
+
+using RenderGraphResourceHandle = uint32;
+constexpr RenderGraphResourceHandle InvalidRenderGraphResource = 0xffffffff;
+
+//リソースステート D3D12_RESOURCE_STATESと同じビット値
+enum RenderGraphResourceState : uint32 {
+	RENDER_GRAPH_STATE_COMMON = 0,
+	RENDER_GRAPH_STATE_PRESENT = 0,
+	RENDER_GRAPH_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	RENDER_GRAPH_STATE_INDEX_BUFFER = 0x2,
+	RENDER_GRAPH_STATE_RENDER_TARGET = 0x4,
+	RENDER_GRAPH_STATE_UNORDERED_ACCESS = 0x8,
+	RENDER_GRAPH_STATE_DEPTH_WRITE = 0x10,
+	RENDER_GRAPH_STATE_DEPTH_READ = 0x20,
+	RENDER_GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	RENDER_GRAPH_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	RENDER_GRAPH_STATE_INDIRECT_ARGUMENT = 0x200,
+	RENDER_GRAPH_STATE_COPY_DEST = 0x400,
+	RENDER_GRAPH_STATE_COPY_SOURCE = 0x800,
+};
+
+//書き込みステートは他のステートと組み合わせられない
+constexpr uint32 RenderGraphWriteStates = RENDER_GRAPH_STATE_RENDER_TARGET | RENDER_GRAPH_STATE_UNORDERED_ACCESS | RENDER_GRAPH_STATE_DEPTH_WRITE | RENDER_GRAPH_STATE_COPY_DEST;
+
+struct RenderGraphResourceDesc {
+	String name;
+	bool isImported;
+
+	//グラフ開始時のステート。トランジェントはコンパイル時に最後に使われるステートが入り、そのステートで生成する
+	//毎フレーム同じステートで始まり同じステートで終わるので、フレーム間の戻しバリアが不要になる
+	//ステートは引き継ぐが内容は引き継がない。トランジェントは最初のパスで破棄してから書き込む
+	uint32 initialState;
+
+	//グラフ終了時に戻しておくステート(インポートのみ)
+	uint32 finalState;
+
+	//ヒープ上のサイズとアライメント(トランジェントのみ)
+	uint64 size;
+	uint64 alignment;
+
+	//同じグループのリソース同士だけがメモリを共有する(バッファとレンダーターゲットを同じヒープに置けない環境向け)
+	uint32 heapGroup;
+};
+
+struct RenderGraphResourceAccess {
+	RenderGraphResourceHandle resource;
+	uint32 state;
+	bool isWrite;
+};
+
+struct RenderGraphPassDesc {
+	String name;
+	VectorArray<RenderGraphResourceAccess> accesses;
+
+	//出力を誰も読まなくても除去しないパス(Presentやデバッグ出力など)
+	bool hasSideEffect;
+};
+
+enum class RenderGraphBarrierType {
+	TRANSITION,
+	ALIASING,
+	UAV
+};
+
+struct RenderGraphBarrier {
+	RenderGraphBarrierType type;
+	RenderGraphResourceHandle resource;
+
+	//TRANSITIONのみ
+	uint32 stateBefore;
+	uint32 stateAfter;
+
+	//ALIASINGのみ 直前に同じメモリを使っていたリソース
+	RenderGraphResourceHandle aliasBefore;
+};
+
+//トランジェントリソースのヒープ上の配置
+struct RenderGraphResourcePlacement {
+	bool isAllocated;
+	uint32 heapGroup;
+	uint64 heapOffset;
+
+	//使用する最初と最後のパス(コンパイル後のパス順)
+	uint32 firstPass;
+	uint32 lastPass;
+};
+
+struct RenderGraphStatistics {
+	uint32 passCount = 0;
+	uint32 culledPassCount = 0;
+	uint32 transitionBarrierCount = 0;
+	uint32 aliasingBarrierCount = 0;
+	uint32 uavBarrierCount = 0;
+	uint32 discardCount = 0;
+	uint32 transientResourceCount = 0;
+
+	//エイリアスしなかった場合の合計サイズと、実際に必要なヒープサイズの合計
+	uint64 transientMemoryWithoutAliasing = 0;
+	uint64 transientHeapSize = 0;
+
+	uint64 getMemorySaved() const { return transientMemoryWithoutAliasing - transientHeapSize; }
+};
+
+class RenderGraph {
+public:
+	RenderGraph();
+
+	//外部で管理されているリソース(バックバッファなど)を登録
+	RenderGraphResourceHandle importResource(const String& name, uint32 initialState, uint32 finalState);
+
+	//グラフ内でのみ使うリソースを登録。寿命が重ならないもの同士で同じメモリを共有する
+	RenderGraphResourceHandle createTransientResource(const String& name, uint64 size, uint64 alignment, uint32 heapGroup = 0);
+
+	//パスを追加して読み書きするリソースを宣言する。パスは宣言順に実行される
+	uint32 addPass(const String& name, bool hasSideEffect = false);
+	void readResource(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state);
+	void writeResource(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state);
+
+	//不要パスの除去、バリア計算、トランジェントリソースの配置を行う
+	void compile();
+
+	//宣言とコンパイル結果をすべて破棄
+	void clear();
+
+	bool isCompiled() const { return _isCompiled; }
+	bool isPassCulled(uint32 passIndex) const;
+
+	//パス実行前に発行するバリア
+	const VectorArray<RenderGraphBarrier>& getPassBarriers(uint32 passIndex) const;
+
+	//パス実行前、バリアの後に内容を破棄するトランジェントリソースとそのステート
+	//生成直後とエイリアスバリアの直後は内容が不定なので、最初に書き込むパスで破棄してから使う
+	const VectorArray<RenderGraphResourceAccess>& getPassDiscards(uint32 passIndex) const;
+
+	//全パス終了後にインポートリソースを最終ステートへ戻すバリア
+	const VectorArray<RenderGraphBarrier>& getFinalBarriers() const { return _finalBarriers; }
+
+	uint32 getPassCount() const { return static_cast<uint32>(_passes.size()); }
+	uint32 getResourceCount() const { return static_cast<uint32>(_resources.size()); }
+	const RenderGraphPassDesc& getPassDesc(uint32 passIndex) const { return _passes[passIndex]; }
+	const RenderGraphResourceDesc& getResourceDesc(RenderGraphResourceHandle resource) const { return _resources[resource]; }
+	const RenderGraphResourcePlacement& getPlacement(RenderGraphResourceHandle resource) const { return _placements[resource]; }
+
+	//ヒープグループごとに必要なヒープサイズ
+	const VectorArray<uint64>& getHeapSizes() const { return _heapSizes; }
+
+	const RenderGraphStatistics& getStatistics() const { return _statistics; }
+
+private:
+	void addAccess(uint32 passIndex, RenderGraphResourceHandle resource, uint32 state, bool isWrite);
+	void cullPasses();
+	void computeLifetimes();
+	void computeTransientStates();
+	void allocateTransientResources();
+	void computeBarriers();
+
+	VectorArray<RenderGraphResourceDesc> _resources;
+	VectorArray<RenderGraphPassDesc> _passes;
+
+	bool _isCompiled;
+	VectorArray<bool> _passCulled;
+	VectorArray<VectorArray<RenderGraphBarrier>> _passBarriers;
+	VectorArray<VectorArray<RenderGraphResourceAccess>> _passDiscards;
+	VectorArray<RenderGraphBarrier> _finalBarriers;
+	VectorArray<RenderGraphResourcePlacement> _placements;
+	VectorArray<uint64> _heapSizes;
+	RenderGraphStatistics _statistics;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include "RenderGraph.h"
+
+using namespace Microsoft::WRL;
+
+//コンパイル済みレンダーグラフをD3D12で実行する
+//トランジェントリソースをヒープグループごとのヒープに配置リソースとして生成し、パスごとのバリアをまとめて発行する
+class RenderGraphExecutor :private NonCopyable {
+public:
+	//リソースヒープティア1でも共存できるようにリソースの種類ごとにヒープを分ける
+	enum HeapGroup {
+		HEAP_GROUP_BUFFER = 0,
+		HEAP_GROUP_RT_DS_TEXTURE,
+		HEAP_GROUP_NON_RT_DS_TEXTURE,
+		HEAP_GROUP_COUNT
+	};
+
+	RenderGraphExecutor();
+	~RenderGraphExecutor();
+
+	void create(RefPtr<ID3D12Device> device);
+	void shutdown();
+
+	//リソース記述からサイズとアライメントをデバイスに問い合わせ、トランジェントリソースとしてグラフに登録する
+	RenderGraphResourceHandle createTransientResource(RenderGraph& graph, const String& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+	//コンパイル済みグラフのトランジェントリソースをヒープ上に生成する
+	//以前のリソースは破棄されるので、GPUが使用していないことは呼び出し側で保証する
+	void realize(const RenderGraph& graph);
+
+	//インポートリソースの実体を設定(バックバッファのようにフレームごとに変わるものは毎フレーム設定する)
+	void setImportedResource(RenderGraphResourceHandle resource, RefPtr<ID3D12Resource> d3dResource);
+	RefPtr<ID3D12Resource> getResource(RenderGraphResourceHandle resource) const;
+
+	//パス実行前のバリアを1回のResourceBarrierで発行し、最初に書き込むトランジェントテクスチャを破棄する
+	void recordPassBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const RenderGraph& graph, uint32 passIndex) const;
+
+	//インポートリソースを最終ステートに戻すバリアを発行
+	void recordFinalBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const RenderGraph& graph) const;
+
+private:
+	struct TransientResourceDesc {
+		D3D12_RESOURCE_DESC desc;
+		bool hasClearValue;
+		D3D12_CLEAR_VALUE clearValue;
+	};
+
+	void recordBarriers(RefPtr<ID3D12GraphicsCommandList> commandList, const VectorArray<RenderGraphBarrier>& barriers) const;
+
+	RefPtr<ID3D12Device> _device;
+	VectorArray<TransientResourceDesc> _transientDescs;
+	VectorArray<RefPtr<ID3D12Resource>> _resources;
+	VectorArray<ComPtr<ID3D12Resource>> _transientResources;
+	ComPtr<ID3D12Heap> _heaps[HEAP_GROUP_COUNT];
+};
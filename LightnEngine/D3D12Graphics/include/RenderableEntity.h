@@ -11,13 +11,13 @@ public:
 
 	void loadInstance(const String& name, const VectorArray<String>& materialNames);
 	
-	//}eACfbNXŎ擾
+	//マテリアルをインデックスで取得
 	RefPtr<SingleMeshRenderMaterial> getMaterial(uint32 index) const;
 
-	//}eAz擾
+	//マテリアル配列を取得
 	VectorArray<RefPtr<SingleMeshRenderMaterial>>& getMaterials();
 
-	//̃bV̕`p[hsXV
+	//このメッシュの描画用ワールド行列を更新
 	void updateWorldMatrix(const Matrix4& worldMatrix);
 
 	VectorArray<RefPtr<SingleMeshRenderMaterial>> _materials;
@@ -3,20 +3,23 @@
 #include <Utility.h>
 #include <d3d12.h>
 #include <LMath.h>
+#include <MeshFile.h>
 #include "GraphicsConstantSettings.h"
 #include "GpuResource.h"
 #include "BufferView.h"
+#include "DescriptorHeap.h"
 #include "AABB.h"
 
 struct ID3D12Device;
 struct ID3D12GraphicsCommandList;
 class ConstantBuffer;
+class LinearConstantAllocator;
 class VertexShader;
 class PixelShader;
 
 #include "PipelineState.h"
 
-//ȉOtBbNXC^[tF[X`BOtBbNXAPIC^[tF[Xwb_[Ɉړ
+//以下グラフィックスインターフェース定義。グラフィックスAPIインターフェースヘッダーに移動する
 struct SharedMaterialCreateSettings {
 	String name;
 	String vertexShaderName;
@@ -30,38 +33,13 @@ struct SharedMaterialCreateSettings {
 struct RefConstantBufferViews {
 	RefBufferView views[FrameCount];
 
-	//̃RX^gobt@[LH
+	//このコンスタントバッファーたちが有効か？
 	inline constexpr bool isEnableBuffers() const {
-		return views[0].isEnable();//Lł΃t[JEg̂łOԂ΂悢
+		return views[0].isEnable();//有効であればフレームカウントずつ生成するので０番だけ見ればよい
 	}
 };
 
-struct ConstantBufferFrame {
-	ConstantBufferFrame();
-	~ConstantBufferFrame();
-
-	void shutdown();
-
-	void create(RefPtr<ID3D12Device> device, uint32 bufferSize);//vfƂɃTCYw
-
-	//̒萔obt@͗LH(ĂΔz񂪂OȏȂ̂łŔf)
-	bool isEnableBuffer() const;
-
-	//ݐݒ肳Ă萔obt@̃f[^wt[̒萔obt@ɍXV
-	void flashBufferData(uint32 frameIndex);
-
-	//obt@̃f[^|C^XV
-	void writeBufferData(const void* dataPtr, uint32 length);
-
-	//GPUzAhXt[obt@擾
-	void getVirtualAdresses(RefPtr<D3D12_GPU_VIRTUAL_ADDRESS> dstArray) const;
-
-	VectorArray<byte> dataPtrs;
-	ConstantBuffer constantBuffers[FrameCount];
-	BufferView constantBufferViews[FrameCount];
-};
-
-//}eA̕`͈͒`
+//マテリアルの描画範囲定義
 struct MaterialDrawRange {
 	MaterialDrawRange() :indexCount(0), indexOffset(0) {}
 	MaterialDrawRange(uint32 indexCount, uint32 indexOffset) :indexCount(indexCount), indexOffset(indexOffset) {}
@@ -82,9 +60,18 @@ struct RefVertexAndIndexBuffer {
 	MaterialDrawRange drawRange;
 };
 
-//_obt@ƃCfbNXobt@̃\[XǗ
+//圧縮頂点の位置を戻す定数。シェーダーでposition * positionScale + positionOffsetとして使う。wは使わない
+struct VertexDequantization {
+	VertexDequantization() :positionScale(1.0f, 1.0f, 1.0f, 0.0f), positionOffset() {}
+
+	Vector4 positionScale;
+	Vector4 positionOffset;
+};
+
+//頂点バッファとインデックスバッファのリソース管理
 struct VertexAndIndexBuffer {
-	VertexAndIndexBuffer(const VectorArray<MaterialDrawRange>& materialDrawRanges) :materialDrawRanges(materialDrawRanges) {}
+	VertexAndIndexBuffer(const VectorArray<MaterialDrawRange>& materialDrawRanges) :
+		materialDrawRanges(materialDrawRanges), vertexFormat(MESH_VERTEX_FORMAT_FLOAT) {}
 
 	RefVertexAndIndexBuffer getRefVertexAndIndexBuffer(uint32 materialIndex) const {
 		return RefVertexAndIndexBuffer(vertexBuffer.getRefVertexBufferView(), indexBuffer.getRefIndexBufferView(), materialDrawRanges[materialIndex]);
@@ -102,14 +89,47 @@ struct VertexAndIndexBuffer {
 	IndexBuffer indexBuffer;
 	AABB boundingBox;
 	VectorArray<MaterialDrawRange> materialDrawRanges;
+
+	//頂点バッファの並び。フォーマットごとに入力レイアウトとシェーダーが変わる
+	MeshVertexFormat vertexFormat;
+	VertexDequantization dequantization;
+
+	//クラスター単位のカリングに使うメッシュレットの境界とコーン。メッシュレットを持たないメッシュは空
+	VectorArray<MeshFileMeshlet> meshlets;
+
+	//LOD1以降のずれと三角形の数。描画範囲はLODごとにマテリアルの数だけ並ぶ。LODを持たないメッシュは空
+	VectorArray<MeshFileLod> lods;
+	VectorArray<MaterialDrawRange> lodMaterialDrawRanges;
+};
+
+//フレームごとにリニアアロケーターから確保する定数バッファ
+enum FrameConstantType {
+	FRAME_CONSTANT_CAMERA = 0,
+	FRAME_CONSTANT_DIRECTIONAL_LIGHT,
+	FRAME_CONSTANT_POINT_LIGHT,
+	FRAME_CONSTANT_BINDLESS_REMAP,
+	FRAME_CONSTANT_COUNT
+};
+
+struct FrameConstantAddresses {
+	D3D12_GPU_VIRTUAL_ADDRESS addresses[FRAME_CONSTANT_COUNT];
 };
 
 struct RenderSettings {
-	RenderSettings(RefPtr<ID3D12GraphicsCommandList> commandList, D3D12_GPU_VIRTUAL_ADDRESS cameraConstantBuffer, uint32 frameIndex) :
-		commandList(commandList), cameraConstantBuffer(cameraConstantBuffer), frameIndex(frameIndex) {}
+	RenderSettings(RefPtr<ID3D12GraphicsCommandList> commandList, const FrameConstantAddresses& frameConstants, RefPtr<LinearConstantAllocator> constantAllocator,
+		RefPtr<ShaderVisibleDescriptorHeap> descriptorHeap, uint32 frameIndex) :
+		commandList(commandList), cameraConstantBuffer(frameConstants.addresses[FRAME_CONSTANT_CAMERA]), frameConstants(frameConstants), constantAllocator(constantAllocator),
+		descriptorHeap(descriptorHeap), frameIndex(frameIndex) {}
 
 	RefPtr<ID3D12GraphicsCommandList> commandList;
 	const D3D12_GPU_VIRTUAL_ADDRESS cameraConstantBuffer;
+	const FrameConstantAddresses frameConstants;
+
+	//ドローごとの定数はここから確保して直接書き込む
+	RefPtr<LinearConstantAllocator> constantAllocator;
+
+	//永続領域に載っていないテーブルはここからリングにコピーする
+	RefPtr<ShaderVisibleDescriptorHeap> descriptorHeap;
 	const uint32 frameIndex;
 };
 
@@ -144,12 +164,26 @@ struct DescriptorSet {
 	RefBufferView viewAddress;
 };
 
+//フレームバッファリングされたリソースのデスクリプタテーブル
+struct DescriptorPerFrameSet {
+	uint32 rootParameterIndex;
+	RefBufferView viewAddresses[FrameCount];
+};
+
 struct GpuResourcePerFrameSet {
 	uint32 rootParameterIndex;
 	D3D12_GPU_VIRTUAL_ADDRESS resourceAddress[FrameCount];
 	ResourceType type;
 };
 
+//フレーム定数を毎フレームRenderSettingsから引いてセットする
+//バインドレスの変換表のような構造化バッファはSHADER_RESOURCEとしてルートSRVにセットする
+struct FrameConstantSet {
+	uint32 rootParameterIndex;
+	FrameConstantType type;
+	ResourceType resourceType = ResourceType::CONSTANT_BUFFER;
+};
+
 struct GpuResourceSet {
 	uint32 rootParameterIndex;
 	D3D12_GPU_VIRTUAL_ADDRESS resourceAddress;
@@ -167,8 +201,10 @@ struct MaterialCommandBase {
 	virtual void setupCommand(RenderSettings& settings) = 0;
 
 	VectorArray<DescriptorSet> _descriptors;
+	VectorArray<DescriptorPerFrameSet> _descriptorPerFrames;
 	VectorArray<GpuResourcePerFrameSet> _gpuResourcePerFrames;
 	VectorArray<GpuResourceSet> _gpuResources;
+	VectorArray<FrameConstantSet> _frameConstants;
 	VectorArray<RootConstantSet> _rootConstants;
 	D3D12_PRIMITIVE_TOPOLOGY _topology;
 	RefRootSignature _rootSignature;
@@ -185,7 +221,11 @@ struct MaterialCommandGraphics :public MaterialCommandBase {
 		commandList->IASetPrimitiveTopology(_topology);
 
 		for (const auto& descriptor : _descriptors) {
-			commandList->SetGraphicsRootDescriptorTable(descriptor.rootParameterIndex, descriptor.viewAddress.gpuHandle);
+			commandList->SetGraphicsRootDescriptorTable(descriptor.rootParameterIndex, settings.descriptorHeap->getDescriptorTable(descriptor.viewAddress));
+		}
+
+		for (const auto& descriptor : _descriptorPerFrames) {
+			commandList->SetGraphicsRootDescriptorTable(descriptor.rootParameterIndex, settings.descriptorHeap->getDescriptorTable(descriptor.viewAddresses[frameIndex]));
 		}
 
 		for (const auto& descriptor : _gpuResourcePerFrames) {
@@ -212,6 +252,18 @@ struct MaterialCommandGraphics :public MaterialCommandBase {
 			}
 		}
 
+		for (const auto& frameConstant : _frameConstants) {
+			switch (frameConstant.resourceType) {
+			case ResourceType::CONSTANT_BUFFER:
+				commandList->SetGraphicsRootConstantBufferView(frameConstant.rootParameterIndex, settings.frameConstants.addresses[frameConstant.type]);
+				break;
+
+			case ResourceType::SHADER_RESOURCE:
+				commandList->SetGraphicsRootShaderResourceView(frameConstant.rootParameterIndex, settings.frameConstants.addresses[frameConstant.type]);
+				break;
+			}
+		}
+
 		for (const auto& rootConstant : _rootConstants) {
 			const uint32 num32bitCount = static_cast<uint32>(rootConstant.dataPtr.size() / 4);
 			commandList->SetGraphicsRoot32BitConstants(rootConstant.rootParameterIndex, num32bitCount, rootConstant.dataPtr.data(), 0);
@@ -228,7 +280,11 @@ struct MaterialCommandCompute :public MaterialCommandBase {
 		commandList->SetComputeRootSignature(_rootSignature.rootSignature);
 
 		for (const auto& descriptor : _descriptors) {
-			commandList->SetComputeRootDescriptorTable(descriptor.rootParameterIndex, descriptor.viewAddress.gpuHandle);
+			commandList->SetComputeRootDescriptorTable(descriptor.rootParameterIndex, settings.descriptorHeap->getDescriptorTable(descriptor.viewAddress));
+		}
+
+		for (const auto& descriptor : _descriptorPerFrames) {
+			commandList->SetComputeRootDescriptorTable(descriptor.rootParameterIndex, settings.descriptorHeap->getDescriptorTable(descriptor.viewAddresses[frameIndex]));
 		}
 
 		for (const auto& descriptor : _gpuResourcePerFrames) {
@@ -255,6 +311,18 @@ struct MaterialCommandCompute :public MaterialCommandBase {
 			}
 		}
 
+		for (const auto& frameConstant : _frameConstants) {
+			switch (frameConstant.resourceType) {
+			case ResourceType::CONSTANT_BUFFER:
+				commandList->SetComputeRootConstantBufferView(frameConstant.rootParameterIndex, settings.frameConstants.addresses[frameConstant.type]);
+				break;
+
+			case ResourceType::SHADER_RESOURCE:
+				commandList->SetComputeRootShaderResourceView(frameConstant.rootParameterIndex, settings.frameConstants.addresses[frameConstant.type]);
+				break;
+			}
+		}
+
 		for (const auto& rootConstant : _rootConstants) {
 			const uint32 num32bitCount = static_cast<uint32>(rootConstant.dataPtr.size() / 4);
 			commandList->SetComputeRoot32BitConstants(rootConstant.rootParameterIndex, num32bitCount, rootConstant.dataPtr.data(), 0);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include <IoService.h>
+#include <LMath.h>
+#include <mutex>
+#include "DdsLayout.h"
+#include "TextureStreamingPolicy.h"
+#include "GpuResource.h"
+
+class Camera;
+class CommandContext;
+
+//DDSテクスチャのミップを必要な分だけ常駐させる
+//ロード時はヘッダーと低解像度のミップだけを読み、カメラから見た画面サイズとメモリ予算に応じて詳細なミップを追加・解放する
+//ファイルはIoServiceで必要なミップの範囲だけを読み、読み込んだバッファから直接アップロードリングにコピーする
+//アーカイブに入っていればIoServiceがアーカイブ上の範囲に読み替える
+//ストリーミングの読み込みは優先度の低い要求として出し、GPUへの転送とテクスチャの差し替えはフレームの先頭にメインスレッドで行う
+//ミップ数の違うテクスチャを作り直して差し替えるので、描画中のフレームが参照するスロットを書き換えないよう
+//差し替え後のテクスチャは新しいバインドレススロットに登録し、固定インデックスからの変換表をフレームごとにシェーダーへ渡す
+class TextureStreamer :public Singleton<TextureStreamer> {
+public:
+	struct Statistics {
+		uint32 streamingTextureCount = 0;
+		uint32 pinnedTextureCount = 0;
+		uint32 pendingLoadCount = 0;
+		uint32 retiredTextureCount = 0;
+		uint64 budget = 0;
+		uint64 residentSize = 0;
+		uint64 loadedMipCount = 0;
+		uint64 evictedMipCount = 0;
+		uint64 loadedSize = 0;
+	};
+
+	static constexpr uint32 InvalidMip = 0xffffffff;
+
+	//ロード前にヘッダーを解析し、ロード時に転送する範囲を読み込んだ結果
+	struct PreparedTexture {
+		String filePath;
+		DdsLayout layout;
+
+		//ストリーミングするテクスチャは低解像度のミップの範囲、それ以外はファイル全体。読めなければ無効
+		IoBuffer data;
+		uint64 dataOffset = 0;
+
+		//ロード時に常駐させる最も詳細なミップ。ストリーミングできなければInvalidMipで、すべてのミップを読み込む
+		uint32 topMip = InvalidMip;
+
+		//アップロードリングに確保する量の上限。ヘッダーを解析できなければ分からないので最大値
+		uint64 uploadSize = ~0ull;
+	};
+
+	TextureStreamer();
+	~TextureStreamer();
+
+	void create(RefPtr<ID3D12Device> device, RefPtr<CommandContext> commandContext, uint64 budget);
+	void shutdown();
+
+	//テクスチャのロードは準備、記録、登録の3段階に分ける。記録はテクスチャごとに別のワーカースレッドから呼んでよい
+	//すべてのファイルのヘッダーをまとめて読んで解析し、ロード時に読み込むミップの範囲をまとめて読む。完了まで待つ
+	//解析はIoServiceの完了コールバックで行うので、スレッドプールのワーカーからは呼ばない
+	static void prepareTextures(const VectorArray<String>& filePaths, VectorArray<PreparedTexture>& outTextures);
+
+	//テクスチャを生成し、DDSのヘッダーと低解像度のミップだけをアップロードに積む
+	//キューブマップなどストリーミングできないテクスチャはすべてのミップを積む
+	void recordTexture(UploadContext& uploadContext, const PreparedTexture& preparedTexture, Texture2D& texture) const;
+
+	//ストリーミングの対象に登録する。メインスレッドから呼ぶ
+	void registerTexture(const PreparedTexture& preparedTexture, Texture2D& texture);
+
+	//すべてのミップを読み込み、以降はストリーミングの対象から外す
+	//バインドレステーブルを通さずにビューを作るテクスチャは、リソースが差し替わるとビューが古いリソースを指したままになるので固定する
+	void pinTexture(Texture2D& texture);
+
+	//テクスチャを使うオブジェクトの境界球を登録する。画面サイズの計算に使う
+	void addTextureUsage(const Texture2D& texture, const Vector3& center, float radius);
+
+	//フレームの先頭で呼ぶ。読み込み済みのミップを反映してから、画面サイズと予算で次の読み込みと解放を決める
+	void update(const Camera& camera, uint32 screenHeight);
+
+	//差し替えで不要になったテクスチャはフレームのフェンス値に紐づけ、完了後に解放する
+	void submit(uint64 fenceValue);
+	void reclaim(uint64 completedFenceValue);
+
+	//バインドレスの固定インデックスから現在のスロットへの変換表。シェーダーはtextures[remap[index]]で参照する
+	const uint32* getBindlessRemapTable() const { return _bindlessRemapTable.data(); }
+
+	void setBudget(uint64 budget);
+	uint64 getBudget() const { return _policy.getBudget(); }
+	Statistics getStatistics() const;
+
+private:
+	struct TextureUsage {
+		Vector3 center;
+		float radius;
+	};
+
+	struct StreamingTexture {
+		RefPtr<Texture2D> texture;
+		String filePath;
+		DdsLayout layout;
+		StreamingTextureState state;
+
+		//差し替え後のスロット。一度も差し替えていなければ無効で、テクスチャの固定インデックスのスロットをそのまま使う
+		BindlessHandle currentHandle;
+		VectorArray<TextureUsage> usages;
+		bool isPinned;
+		bool isLoading;
+
+		//読み込み中の要求。固定したときにキューに残っていれば取り消す
+		IoRequestId loadRequestId;
+	};
+
+	//IoServiceが読み込んだミップ。バッファの先頭はtopMipの位置で、endMipの手前までが入っている
+	struct LoadedMips {
+		uint32 textureIndex;
+		uint32 topMip;
+		uint32 endMip;
+		bool isSucceeded;
+		uint64 size;
+		IoBuffer buffer;
+	};
+
+	struct RetiredTexture {
+		uint64 fenceValue;
+		ComPtr<ID3D12Resource> resource;
+		GpuMemoryAllocation memoryAllocation;
+	};
+
+	//ロード時に常駐させる最も詳細なミップ。ストリーミングできなければInvalidMip
+	static uint32 computeMinResidentMip(const DdsLayout& layout);
+
+	//firstMipから最後までのミップを転送するときにアップロードリングに確保する量の上限
+	static uint64 computeUploadSize(const DdsLayout& layout, uint32 firstMip);
+
+	//topMipから最後までのミップを持つテクスチャを生成する
+	void createMipRange(const DdsLayout& layout, uint32 topMip, ComPtr<ID3D12Resource>& outResource, GpuMemoryAllocation& outMemoryAllocation) const;
+
+	//ファイルのミップをfirstSubresourceから順に転送する。dataの先頭はファイルのdataOffsetの位置
+	static void uploadMips(UploadContext& uploadContext, RefPtr<ID3D12Resource> resource, const DdsLayout& layout, uint32 firstMip, uint32 endMip,
+		const byte* data, uint64 dataOffset, uint32 firstSubresource);
+
+	//常駐ミップを変えたテクスチャを作り直して差し替える。共通のミップはGPU上でコピーし、増えたミップだけをdataから転送する
+	void changeResidentMip(UploadContext& uploadContext, uint32 textureIndex, uint32 newTopMip, const byte* data);
+
+	void requestLoad(uint32 textureIndex, uint32 topMip);
+
+	//1フレームの転送量の上限まで読み込み済みのミップを取り出す
+	void takeLoadedMips(VectorArray<LoadedMips>& outLoadedMips);
+	void applyLoadedMips();
+	void updateScreenSizes(const Camera& camera, uint32 screenHeight);
+
+	RefPtr<ID3D12Device> _device;
+	RefPtr<CommandContext> _commandContext;
+
+	VectorArray<StreamingTexture> _textures;
+	UnorderedMap<const Texture2D*, uint32> _textureIndices;
+	VectorArray<uint32> _bindlessRemapTable;
+
+	TextureStreamingPolicy _policy;
+	uint32 _pendingLoadCount;
+
+	//IoServiceの完了コールバックが読み込んだミップを_loadedMipsに積み、メインスレッドが取り出す
+	//終了時は読み込み中の要求のコールバックを_loadGroupで待つ
+	IoRequestGroup _loadGroup;
+	DequeArray<LoadedMips> _loadedMips;
+	std::mutex _loadedMipsMutex;
+
+	VectorArray<RetiredTexture> _unsubmittedRetiredTextures;
+	DequeArray<RetiredTexture> _retiredTextures;
+
+	Statistics _statistics;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Utility.h>
+
+//ストリーミング対象テクスチャ1枚の状態。ミップは0が最も詳細
+struct StreamingTextureState {
+	//ミップ0の幅と高さの大きい方
+	uint32 size = 0;
+	uint32 mipCount = 0;
+
+	//常に常駐させる最も粗いミップの範囲の先頭。これより粗いミップは解放しない
+	uint32 minResidentMip = 0;
+
+	//現在常駐している最も詳細なミップ
+	uint32 residentMip = 0;
+
+	//画面上での最大の大きさ(ピクセル)。0以下なら今は見えていない
+	float screenSize = 0.0f;
+
+	//ミップごとのバイト数
+	VectorArray<uint64> mipSizes;
+};
+
+//1段分のロードまたは解放の要求
+struct StreamingRequest {
+	uint32 textureIndex;
+	uint32 targetMip;
+	float priority;
+};
+
+//画面サイズとメモリ予算から各テクスチャの目標ミップを決め、ロードと解放の要求を作る
+//D3D12にもファイルにも依存しないので、テクスチャの状態を並べるだけで検証できる
+class TextureStreamingPolicy {
+public:
+	TextureStreamingPolicy();
+
+	//budgetは常駐テクスチャ全体のバイト数の上限。mipBiasを正にすると全体を粗くする
+	void create(uint64 budget, float mipBias);
+
+	//テクセルと画面のピクセルが1:1になるミップ。見えていなければ-1を返す
+	int32 computeWantedMip(const StreamingTextureState& texture) const;
+
+	//予算に収まるように各テクスチャの目標ミップを決める
+	//予算を超える間は、画面上で最もテクセルが余っている(優先度の低い)テクスチャから1段ずつ粗くする
+	//見えていないテクスチャは今のミップを維持するが、優先度は最低なので予算が足りなければ最初に削られる
+	void computeTargetMips(const VectorArray<StreamingTextureState>& textures, VectorArray<uint32>& outTargetMips) const;
+
+	//目標ミップとの差からロードと解放の要求を作る
+	//解放は目標ミップまで一度に、ロードは1段ずつ優先度の高い順に並べ、最大maxLoadCount個まで
+	void buildRequests(const VectorArray<StreamingTextureState>& textures, const VectorArray<uint32>& targetMips, uint32 maxLoadCount,
+		VectorArray<StreamingRequest>& outEvictions, VectorArray<StreamingRequest>& outLoads) const;
+
+	//mostDetailedMipから最も粗いミップまでのバイト数
+	static uint64 computeResidentSize(const StreamingTextureState& texture, uint32 mostDetailedMip);
+
+	uint64 getBudget() const { return _budget; }
+
+private:
+	//mipの解像度が画面サイズに対してどれだけ必要か。小さいほど削っても見た目に影響しない
+	static float computePriority(const StreamingTextureState& texture, uint32 mip);
+
+	uint64 _budget;
+	float _mipBias;
+};
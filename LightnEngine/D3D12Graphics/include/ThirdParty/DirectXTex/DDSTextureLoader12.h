@@ -18,6 +18,7 @@
 
 #include <d3d12.h>
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <stdint.h>
@@ -41,6 +42,10 @@ namespace DirectX
         DDS_LOADER_MIP_RESERVE = 0x8,
     };
 
+    // Optional hook to create the texture resource (e.g. as a placed resource).
+    // When not supplied the texture is created as a committed resource.
+    using DDSResourceCreateFunc = std::function<HRESULT(const D3D12_RESOURCE_DESC& desc, ID3D12Resource** texture)>;
+
     // Standard version
     HRESULT __cdecl LoadDDSTextureFromMemory(
         _In_ RefPtr<ID3D12Device> d3dDevice,
@@ -73,7 +78,8 @@ namespace DirectX
         _Outptr_ ID3D12Resource** texture,
         VectorArray<D3D12_SUBRESOURCE_DATA>& subresources,
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
-        _Out_opt_ bool* isCubeMap = nullptr);
+        _Out_opt_ bool* isCubeMap = nullptr,
+        _In_opt_ const DDSResourceCreateFunc* createFunc = nullptr);
 
     HRESULT __cdecl LoadDDSTextureFromFileEx(
         _In_ RefPtr<ID3D12Device> d3dDevice,
@@ -85,5 +91,6 @@ namespace DirectX
         UniquePtr<uint8_t[]>& ddsData,
         VectorArray<D3D12_SUBRESOURCE_DATA>& subresources,
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
-        _Out_opt_ bool* isCubeMap = nullptr);
+        _Out_opt_ bool* isCubeMap = nullptr,
+        _In_opt_ const DDSResourceCreateFunc* createFunc = nullptr);
 }
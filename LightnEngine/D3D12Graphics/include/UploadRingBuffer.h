@@ -0,0 +1,112 @@
+#pragma once
+
+#include "stdafx.h"
+#include <Utility.h>
+#include <mutex>
+#include <functional>
+#include "FencedRingAllocator.h"
+#include "CommandContext.h"
+
+using namespace Microsoft::WRL;
+
+struct UploadAllocation {
+	RefPtr<ID3D12Resource> resource;
+	uint64 offset;
+	void* cpuAddress;
+};
+
+//永続的にマップしたアップロードヒープをリングとして使い回す
+//リソースごとにアップロードヒープを生成せず、コピー完了はフェンスで判定して回収するのでCPUは待機しない
+//フェンス値は1つのキューのものである必要があるので、アップロードはグラフィックスキューから行う
+class UploadRingBuffer :public Singleton<UploadRingBuffer> {
+public:
+	UploadRingBuffer();
+	~UploadRingBuffer();
+
+	void create(RefPtr<ID3D12Device> device, uint64 size);
+	void shutdown();
+
+	//空きがなければ完了済み領域を回収し、それでも足りなければ最も古い提出済みアップロードの完了を待つ
+	//未提出の確保だけで埋まっている場合はfalseを返すので、呼び出し側で提出してから再確保する
+	bool allocate(RefPtr<CommandQueue> commandQueue, uint64 size, uint64 alignment, UploadAllocation& outAllocation);
+
+	//直前までの確保をこのフェンス値の完了で解放する
+	void submit(UINT64 fenceValue);
+
+	//1回のコピーで確保する最大サイズ。これより大きいデータは分割して転送する
+	uint64 getMaxChunkSize() const;
+
+	//最後に提出したアップロードのフェンス値。別キューからアップロード結果を使う場合はこの値を待つ
+	UINT64 getLastSubmittedFenceValue() const;
+
+	RefPtr<ID3D12Device> getDevice() const;
+	FencedRingAllocator::Statistics getStatistics();
+
+private:
+	RefPtr<ID3D12Device> _device;
+	ComPtr<ID3D12Resource> _buffer;
+	byte* _mappedPtr;
+	FencedRingAllocator _allocator;
+	UINT64 _lastSubmittedFenceValue;
+	std::mutex _mutex;
+};
+
+//アップロードリングを使ってコピーコマンドを積む
+//リングが未提出のデータで埋まったら途中まで提出して新しいコマンドリストで続けるので、リングより大きいデータも転送できる
+class UploadContext :private NonCopyable {
+public:
+	//isFlushEnabledがfalseなら途中で提出しない。UploadBatchがワーカースレッドに渡すコンテキストで使う
+	//その場合と、提出してもリングに収まらない場合はHrException(E_OUTOFMEMORY)を投げる
+	UploadContext(RefPtr<CommandContext> commandContext, bool isFlushEnabled = true);
+	~UploadContext();
+
+	//途中で提出するとコマンドリストが切り替わるので、転送後のバリアなどは毎回ここから取得したリストに積む
+	RefPtr<ID3D12GraphicsCommandList> getCommandList() const;
+
+	void uploadBuffer(RefPtr<ID3D12Resource> dstResource, uint64 dstOffset, const void* srcData, uint64 size);
+
+	//コピー元を用意せず、アップロードリングに直接書き込む。writeDataはチャンクごとに先頭から順に呼ばれる
+	//チャンクは最後を除いて4バイトの倍数なので、2バイトや4バイトの要素がチャンクをまたぐことはない
+	void uploadBuffer(RefPtr<ID3D12Resource> dstResource, uint64 dstOffset, uint64 size, const std::function<void(void* dst, uint64 size)>& writeData);
+
+	//サブリソースごとに転送し、リングに収まらないサブリソースは行単位で分割する
+	//firstSubresourceを指定すると、subresources[0]をそのサブリソースから順に書き込む
+	void uploadTexture(RefPtr<ID3D12Resource> dstResource, const D3D12_SUBRESOURCE_DATA* subresources, uint32 subresourceCount, uint32 firstSubresource = 0);
+
+	//積んだコマンドを実行して提出する。完了は待たない
+	UINT64 submit();
+
+private:
+	friend class UploadBatch;
+
+	UploadAllocation allocate(uint64 size, uint64 alignment);
+	void flush();
+
+	RefPtr<CommandContext> _commandContext;
+	CommandListSet _commandListSet;
+	bool _isFlushEnabled;
+	bool _isSubmitted;
+};
+
+//複数のスレッドが並列にアップロードを積み、まとめて1回で提出する
+//リングへの提出は直前までの確保すべてに同じフェンス値を付けるので、記録中に1つのコンテキストだけを提出すると他のスレッドの未提出のコピーまで解放対象になる
+//そのためコンテキストは途中で提出せず、すべてのコマンドリストを1回のExecuteCommandListsで実行してからリングに提出する
+//途中で提出できない分、1回のバッチで確保する量はgetMaxBatchSize以下に抑える必要がある
+class UploadBatch :private NonCopyable {
+public:
+	UploadBatch(RefPtr<CommandContext> commandContext, uint32 contextCount);
+	~UploadBatch();
+
+	//indexごとに別のスレッドから使ってよい
+	UploadContext& getContext(uint32 index);
+
+	//すべてのコンテキストを提出する。戻り値はバッチ内のすべてのコピーが完了するフェンス値
+	UINT64 submit();
+
+	//記録中にリングが埋まらないことを保証できる1バッチの確保量の上限
+	static uint64 getMaxBatchSize();
+
+private:
+	RefPtr<CommandContext> _commandContext;
+	VectorArray<UniquePtr<UploadContext>> _contexts;
+};
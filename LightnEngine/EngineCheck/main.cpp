@@ -0,0 +1,1010 @@
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <map>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <Utility.h>
+#include <RenderGraph.h>
+#include <FencedRingAllocator.h>
+#include <TlsfAllocator.h>
+#include <FencedObjectPool.h>
+#include <DdsLayout.h>
+#include <TextureStreamingPolicy.h>
+#include <ShaderCache.h>
+#include <AssetCooker.h>
+
+//D3D12のデバイスやFBX SDKがなくても動かせる処理を調べる検査ツール
+//D3D12Graphicsからはデバイスに依存しないソースだけを直接ビルドし、ライブラリはUtilityだけにリンクする
+//EngineCheck [name ...]  指定した検査だけを行う。省略するとすべて行う
+//検査ごとにValidかMismatchを表示し、1つでもMismatchなら1を返す
+
+//コンパイル結果が宣言と矛盾しないかを調べる。宣言のステートを順に追い、バリアの前後のステート、寿命、配置、破棄を照らし合わせる
+bool verifyRenderGraph(const RenderGraph& graph) {
+	const uint32 resourceCount = graph.getResourceCount();
+	const uint32 passCount = graph.getPassCount();
+	bool isValid = graph.isCompiled();
+
+	//寿命は使うパスをすべて含み、最初と最後のパスでは実際に使っている
+	for (RenderGraphResourceHandle resource = 0; resource < resourceCount && isValid; ++resource) {
+		const RenderGraphResourcePlacement& placement = graph.getPlacement(resource);
+		if (graph.getResourceDesc(resource).isImported || !placement.isAllocated) {
+			continue;
+		}
+
+		bool isFirstUsed = false;
+		bool isLastUsed = false;
+		for (uint32 passIndex = 0; passIndex < passCount; ++passIndex) {
+			if (graph.isPassCulled(passIndex)) {
+				continue;
+			}
+
+			for (const auto& access : graph.getPassDesc(passIndex).accesses) {
+				if (access.resource != resource) {
+					continue;
+				}
+
+				isValid = isValid && passIndex >= placement.firstPass && passIndex <= placement.lastPass;
+				isFirstUsed = isFirstUsed || passIndex == placement.firstPass;
+				isLastUsed = isLastUsed || passIndex == placement.lastPass;
+			}
+		}
+
+		isValid = isValid && isFirstUsed && isLastUsed;
+	}
+
+	//配置はアライメントを守ってヒープに収まり、寿命が重なるもの同士はメモリを共有しない
+	for (RenderGraphResourceHandle a = 0; a < resourceCount && isValid; ++a) {
+		const RenderGraphResourceDesc& descA = graph.getResourceDesc(a);
+		const RenderGraphResourcePlacement& placementA = graph.getPlacement(a);
+		if (descA.isImported || !placementA.isAllocated) {
+			continue;
+		}
+
+		isValid = placementA.heapOffset % descA.alignment == 0 && placementA.heapGroup < graph.getHeapSizes().size()
+			&& placementA.heapOffset + descA.size <= graph.getHeapSizes()[placementA.heapGroup];
+
+		for (RenderGraphResourceHandle b = a + 1; b < resourceCount && isValid; ++b) {
+			const RenderGraphResourceDesc& descB = graph.getResourceDesc(b);
+			const RenderGraphResourcePlacement& placementB = graph.getPlacement(b);
+			if (descB.isImported || !placementB.isAllocated || placementA.heapGroup != placementB.heapGroup) {
+				continue;
+			}
+
+			const bool isLifetimeOverlapped = placementA.firstPass <= placementB.lastPass && placementB.firstPass <= placementA.lastPass;
+			const bool isMemoryOverlapped = placementA.heapOffset < placementB.heapOffset + descB.size && placementB.heapOffset < placementA.heapOffset + descA.size;
+			isValid = !(isLifetimeOverlapped && isMemoryOverlapped);
+		}
+	}
+
+	VectorArray<uint32> states(resourceCount);
+	for (RenderGraphResourceHandle resource = 0; resource < resourceCount; ++resource) {
+		states[resource] = graph.getResourceDesc(resource).initialState;
+	}
+
+	for (uint32 passIndex = 0; passIndex < passCount && isValid; ++passIndex) {
+		const VectorArray<RenderGraphBarrier>& barriers = graph.getPassBarriers(passIndex);
+		const VectorArray<RenderGraphResourceAccess>& discards = graph.getPassDiscards(passIndex);
+		if (graph.isPassCulled(passIndex)) {
+			isValid = barriers.empty() && discards.empty();
+			continue;
+		}
+
+		//遷移は直前のステートから始まり、エイリアスは同じヒープで重なるメモリを使っていたリソースから切り替える
+		for (const auto& barrier : barriers) {
+			const RenderGraphResourcePlacement& placement = graph.getPlacement(barrier.resource);
+			switch (barrier.type) {
+			case RenderGraphBarrierType::TRANSITION:
+				isValid = isValid && barrier.stateBefore == states[barrier.resource];
+				states[barrier.resource] = barrier.stateAfter;
+				break;
+			case RenderGraphBarrierType::ALIASING: {
+				const RenderGraphResourcePlacement& beforePlacement = graph.getPlacement(barrier.aliasBefore);
+				const uint64 size = graph.getResourceDesc(barrier.resource).size;
+				const uint64 beforeSize = graph.getResourceDesc(barrier.aliasBefore).size;
+				isValid = isValid && placement.isAllocated && placement.firstPass == passIndex && beforePlacement.isAllocated
+					&& beforePlacement.heapGroup == placement.heapGroup
+					&& placement.heapOffset < beforePlacement.heapOffset + beforeSize && beforePlacement.heapOffset < placement.heapOffset + size;
+				break;
+			}
+			case RenderGraphBarrierType::UAV:
+				isValid = isValid && states[barrier.resource] == RENDER_GRAPH_STATE_UNORDERED_ACCESS;
+				break;
+			}
+		}
+
+		//バリアの後は宣言したステートになっている。読み込みは合成したステートに含まれていればよい
+		for (const auto& access : graph.getPassDesc(passIndex).accesses) {
+			const uint32 state = states[access.resource];
+			isValid = isValid && (access.isWrite ? state == access.state : (state & access.state) == access.state);
+		}
+
+		//破棄は最初に書き込むパスでだけ行う
+		for (const auto& discard : discards) {
+			const RenderGraphResourcePlacement& placement = graph.getPlacement(discard.resource);
+			isValid = isValid && !graph.getResourceDesc(discard.resource).isImported && placement.firstPass == passIndex
+				&& discard.isWrite && discard.state == states[discard.resource];
+		}
+
+		for (const auto& access : graph.getPassDesc(passIndex).accesses) {
+			const RenderGraphResourcePlacement& placement = graph.getPlacement(access.resource);
+			if (graph.getResourceDesc(access.resource).isImported || placement.firstPass != passIndex || !access.isWrite) {
+				continue;
+			}
+
+			isValid = isValid && std::any_of(discards.begin(), discards.end(), [&access](const RenderGraphResourceAccess& discard) {
+				return discard.resource == access.resource;
+			});
+		}
+	}
+
+	//終了時はインポートは最終ステートに戻り、トランジェントは次のフレームが始まるステートで終わる
+	for (const auto& barrier : graph.getFinalBarriers()) {
+		isValid = isValid && barrier.type == RenderGraphBarrierType::TRANSITION && barrier.stateBefore == states[barrier.resource];
+		states[barrier.resource] = barrier.stateAfter;
+	}
+
+	for (RenderGraphResourceHandle resource = 0; resource < resourceCount && isValid; ++resource) {
+		const RenderGraphResourceDesc& desc = graph.getResourceDesc(resource);
+		const bool isUsed = desc.isImported || graph.getPlacement(resource).isAllocated;
+		isValid = !isUsed || states[resource] == (desc.isImported ? desc.finalState : desc.initialState);
+	}
+
+	return isValid;
+}
+
+void printRenderGraph(const char* name, const RenderGraph& graph) {
+	const RenderGraphStatistics& statistics = graph.getStatistics();
+	std::cout << name << ": " << statistics.passCount << " passes (" << statistics.culledPassCount << " culled), "
+		<< statistics.transitionBarrierCount << " transitions, " << statistics.aliasingBarrierCount << " aliasing, "
+		<< statistics.uavBarrierCount << " uav, " << statistics.discardCount << " discards, heap "
+		<< statistics.transientHeapSize << " / " << statistics.transientMemoryWithoutAliasing << " bytes" << std::endl;
+}
+
+//出力を読まれないパスの除去、寿命の重ならないトランジェントのメモリの共有、ヒープグループの分離、UAVバリアを調べる
+int checkRenderGraph() {
+	//A -> B -> C -> バックバッファ。Deadの出力は誰も読まないので除去され、AとCは寿命が重ならないので同じメモリを使う
+	RenderGraph chain;
+	const RenderGraphResourceHandle backBuffer = chain.importResource("BackBuffer", RENDER_GRAPH_STATE_PRESENT, RENDER_GRAPH_STATE_PRESENT);
+	const RenderGraphResourceHandle a = chain.createTransientResource("A", 1024, 256);
+	const RenderGraphResourceHandle b = chain.createTransientResource("B", 1024, 256);
+	const RenderGraphResourceHandle c = chain.createTransientResource("C", 512, 256);
+	const RenderGraphResourceHandle unused = chain.createTransientResource("Unused", 4096, 256);
+
+	const uint32 writePass = chain.addPass("WriteA");
+	chain.writeResource(writePass, a, RENDER_GRAPH_STATE_RENDER_TARGET);
+	const uint32 blurPass = chain.addPass("AtoB");
+	chain.readResource(blurPass, a, RENDER_GRAPH_STATE_PIXEL_SHADER_RESOURCE);
+	chain.writeResource(blurPass, b, RENDER_GRAPH_STATE_RENDER_TARGET);
+	const uint32 computePass = chain.addPass("BtoC");
+	chain.readResource(computePass, b, RENDER_GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE);
+	chain.writeResource(computePass, c, RENDER_GRAPH_STATE_UNORDERED_ACCESS);
+	const uint32 deadPass = chain.addPass("Dead");
+	chain.writeResource(deadPass, unused, RENDER_GRAPH_STATE_RENDER_TARGET);
+	const uint32 composePass = chain.addPass("Compose");
+	chain.readResource(composePass, c, RENDER_GRAPH_STATE_PIXEL_SHADER_RESOURCE);
+	chain.writeResource(composePass, backBuffer, RENDER_GRAPH_STATE_RENDER_TARGET);
+	chain.compile();
+	printRenderGraph("Chain", chain);
+
+	bool isValid = verifyRenderGraph(chain);
+	isValid = isValid && chain.isPassCulled(deadPass) && !chain.isPassCulled(writePass) && !chain.isPassCulled(composePass)
+		&& chain.getStatistics().culledPassCount == 1 && !chain.getPlacement(unused).isAllocated;
+	isValid = isValid && chain.getPlacement(a).firstPass == writePass && chain.getPlacement(a).lastPass == blurPass
+		&& chain.getPlacement(c).firstPass == computePass && chain.getPlacement(c).lastPass == composePass;
+	isValid = isValid && chain.getPlacement(a).heapOffset == chain.getPlacement(c).heapOffset && chain.getStatistics().getMemorySaved() > 0;
+	isValid = isValid && chain.getStatistics().discardCount == 3 && chain.getFinalBarriers().size() == 1;
+
+	//バッファとテクスチャを別のヒープグループに置く。寿命が重ならなくてもグループが違えばメモリを共有しない
+	//同じバッファへUAVで続けて書くとUAVバリアが入り、読み込みへの遷移ではUAVバリアは入らない
+	RenderGraph groups;
+	const RenderGraphResourceHandle output = groups.importResource("Output", RENDER_GRAPH_STATE_COPY_DEST, RENDER_GRAPH_STATE_COPY_DEST);
+	const RenderGraphResourceHandle texture = groups.createTransientResource("Texture", 4096, 4096, 0);
+	const RenderGraphResourceHandle buffer = groups.createTransientResource("Buffer", 256, 256, 1);
+
+	const uint32 drawPass = groups.addPass("Draw");
+	groups.writeResource(drawPass, texture, RENDER_GRAPH_STATE_RENDER_TARGET);
+	const uint32 clearPass = groups.addPass("Clear");
+	groups.readResource(clearPass, texture, RENDER_GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE);
+	groups.writeResource(clearPass, buffer, RENDER_GRAPH_STATE_UNORDERED_ACCESS);
+	const uint32 accumulatePass = groups.addPass("Accumulate");
+	groups.writeResource(accumulatePass, buffer, RENDER_GRAPH_STATE_UNORDERED_ACCESS);
+	const uint32 copyPass = groups.addPass("Copy", true);
+	groups.readResource(copyPass, buffer, RENDER_GRAPH_STATE_COPY_SOURCE);
+	groups.writeResource(copyPass, output, RENDER_GRAPH_STATE_COPY_DEST);
+	groups.compile();
+	printRenderGraph("Groups", groups);
+
+	isValid = isValid && verifyRenderGraph(groups);
+	isValid = isValid && groups.getHeapSizes().size() == 2 && groups.getPlacement(texture).heapGroup == 0 && groups.getPlacement(buffer).heapGroup == 1
+		&& groups.getStatistics().uavBarrierCount == 1 && groups.getStatistics().aliasingBarrierCount == 0 && groups.getFinalBarriers().empty();
+
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//アップロードリングと同じ使い方で確保、提出、回収をランダムに繰り返し、GPUが使用中の領域を再び渡さないことを調べる
+//フェンスはカウンターで模擬し、完了したフェンス値より新しい提出の領域は使用中として持っておく
+int checkFencedRing() {
+	struct RingAllocation {
+		uint64 offset;
+		uint64 size;
+		uint64 fenceValue;
+	};
+
+	const uint64 capacity = 64 * 1024;
+	const uint32 operationCount = 200000;
+	const uint64 unsubmittedFenceValue = ~0ull;
+
+	FencedRingAllocator ring;
+	ring.create(capacity);
+
+	std::mt19937 random(1);
+	VectorArray<RingAllocation> liveAllocations;
+	uint64 submittedFenceValue = 0;
+	uint64 completedFenceValue = 0;
+	bool isValid = true;
+
+	auto submit = [&]() {
+		++submittedFenceValue;
+		ring.submit(submittedFenceValue);
+		for (auto& allocation : liveAllocations) {
+			if (allocation.fenceValue == unsubmittedFenceValue) {
+				allocation.fenceValue = submittedFenceValue;
+			}
+		}
+	};
+
+	auto complete = [&](uint64 fenceValue) {
+		completedFenceValue = fenceValue;
+		ring.reclaim(completedFenceValue);
+		auto end = std::remove_if(liveAllocations.begin(), liveAllocations.end(), [completedFenceValue](const RingAllocation& allocation) {
+			return allocation.fenceValue <= completedFenceValue;
+		});
+		liveAllocations.erase(end, liveAllocations.end());
+	};
+
+	for (uint32 i = 0; i < operationCount && isValid; ++i) {
+		//定数バッファ程度の小さい確保がほとんどで、ときどきテクスチャの1ミップ程度の確保をする
+		const uint64 size = 1 + random() % (random() % 16 == 0 ? capacity / 4 : 1024);
+		const uint64 alignment = 1ull << (random() % 10);
+		const uint64 offset = ring.allocate(size, alignment);
+		if (offset == FencedRingAllocator::InvalidOffset) {
+			//UploadContextと同じく、未提出があれば提出し、なければ最も古い提出の完了を待つ
+			if (ring.getUnsubmittedSize() > 0) {
+				submit();
+			}
+			else {
+				isValid = ring.hasPendingSubmission();
+				if (isValid) {
+					complete(ring.getOldestPendingFenceValue());
+				}
+			}
+			continue;
+		}
+
+		isValid = offset % alignment == 0 && offset + size <= capacity;
+		for (const auto& allocation : liveAllocations) {
+			isValid = isValid && (offset + size <= allocation.offset || allocation.offset + allocation.size <= offset);
+		}
+
+		liveAllocations.push_back({ offset, size, unsubmittedFenceValue });
+
+		//フレームの区切りとGPUの進み具合を模擬する
+		if (random() % 8 == 0) {
+			submit();
+		}
+		if (random() % 12 == 0 && completedFenceValue < submittedFenceValue) {
+			complete(completedFenceValue + 1);
+		}
+	}
+
+	const FencedRingAllocator::Statistics& statistics = ring.getStatistics();
+	std::cout << "Ring: " << statistics.allocationCount << " allocations, " << statistics.failedAllocationCount << " failed, peak "
+		<< statistics.peakUsedSize / 1024 << " KB" << std::endl;
+
+	//すべて提出して完了すれば空に戻り、容量いっぱいの確保ができる
+	submit();
+	complete(submittedFenceValue);
+	isValid = isValid && !ring.hasPendingSubmission() && ring.getUsedSize() == 0 && ring.allocate(capacity, 1) == 0;
+
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//シェーダー可視ヒープのリングとステージングヒープのページを、デスクリプタ単位の確保でデバイスなしに再現して調べる
+//リングは処理中のフレーム数分の容量があれば失敗せず、足りないときは使用中の領域に重ねずに失敗を返す
+//ステージングはページに入らなければページを追加し、すべて解放すれば各ページが1つの空きブロックに戻る
+int checkDescriptorHeap() {
+	struct RingTable {
+		uint64 offset;
+		uint64 size;
+		uint64 frameIndex;
+	};
+
+	const uint32 maxFramesInFlight = 3;
+	const uint64 tableCountPerFrame = 256;
+	const uint64 maxDescriptorCountPerTable = 16;
+	const uint64 ringCapacity = tableCountPerFrame * maxDescriptorCountPerTable * maxFramesInFlight;
+	const uint32 frameCount = 2000;
+
+	FencedRingAllocator ring;
+	ring.create(ringCapacity);
+
+	std::mt19937 random(1);
+	VectorArray<RingTable> liveTables;
+	uint64 completedFrameIndex = 0;
+	bool isValid = true;
+
+	auto complete = [&](uint64 frameIndex) {
+		if (completedFrameIndex >= frameIndex) {
+			return;
+		}
+
+		completedFrameIndex = frameIndex;
+		ring.reclaim(completedFrameIndex);
+		auto end = std::remove_if(liveTables.begin(), liveTables.end(), [completedFrameIndex](const RingTable& table) {
+			return table.frameIndex <= completedFrameIndex;
+		});
+		liveTables.erase(end, liveTables.end());
+	};
+
+	for (uint64 frameIndex = 1; frameIndex <= frameCount && isValid; ++frameIndex) {
+		//GPUは順に完了し、遅れはばらつく。ただし処理中のフレームが上限に達していれば、記録を始める前に最も古いフレームを待つ
+		const uint64 lag = random() % (maxFramesInFlight + 1);
+		if (frameIndex > lag + 1) {
+			complete(frameIndex - lag - 1);
+		}
+		if (frameIndex > maxFramesInFlight) {
+			complete(frameIndex - maxFramesInFlight);
+		}
+
+		const uint64 tableCount = 1 + random() % tableCountPerFrame;
+		for (uint64 i = 0; i < tableCount && isValid; ++i) {
+			const uint64 descriptorCount = 1 + random() % maxDescriptorCountPerTable;
+			const uint64 offset = ring.allocate(descriptorCount, 1);
+			isValid = offset != FencedRingAllocator::InvalidOffset && offset + descriptorCount <= ringCapacity;
+			for (const auto& table : liveTables) {
+				isValid = isValid && (offset + descriptorCount <= table.offset || table.offset + table.size <= offset);
+			}
+
+			liveTables.push_back({ offset, descriptorCount, frameIndex });
+		}
+
+		ring.submit(frameIndex);
+	}
+
+	std::cout << "Ring: " << ring.getStatistics().allocationCount << " tables, peak " << ring.getStatistics().peakUsedSize << " / " << ringCapacity
+		<< " descriptors" << std::endl;
+
+	//完了していないフレームの領域を使い切ったら、重ねずに失敗する。copyToRingはこれを例外にする
+	uint64 overflowCount = 0;
+	while (isValid && overflowCount == 0) {
+		const uint64 offset = ring.allocate(maxDescriptorCountPerTable, 1);
+		if (offset == FencedRingAllocator::InvalidOffset) {
+			++overflowCount;
+			break;
+		}
+
+		for (const auto& table : liveTables) {
+			isValid = isValid && (offset + maxDescriptorCountPerTable <= table.offset || table.offset + table.size <= offset);
+		}
+		liveTables.push_back({ offset, maxDescriptorCountPerTable, frameCount + 1 });
+	}
+	isValid = isValid && overflowCount == 1;
+
+	//ステージングヒープ DescriptorStagingHeap::allocateと同じく、前のページから順に探して入らなければページを追加する
+	struct StagingView {
+		uint32 page;
+		TlsfAllocator::Allocation block;
+	};
+
+	const uint64 descriptorCountPerPage = 256;
+	VectorArray<UniquePtr<TlsfAllocator>> pages;
+	VectorArray<std::map<uint64, uint64>> allocatedRanges;
+	VectorArray<StagingView> views;
+	for (uint32 i = 0; i < 100000 && isValid; ++i) {
+		if (views.empty() || random() % 2 == 0) {
+			//ほとんどはSRV1つかテーブル1つ分で、まれにページより大きいテーブルを作る
+			const uint64 descriptorCount = random() % 2000 == 0 ? descriptorCountPerPage + 1 + random() % 64 : 1 + random() % 8;
+			StagingView view = {};
+			for (uint32 page = 0; page < pages.size() && !view.block.isValid(); ++page) {
+				view.block = pages[page]->allocate(descriptorCount, 1);
+				view.page = page;
+			}
+
+			if (!view.block.isValid()) {
+				pages.emplace_back(makeUnique<TlsfAllocator>());
+				pages.back()->create(std::max(descriptorCount, descriptorCountPerPage), 1);
+				allocatedRanges.emplace_back();
+				view.page = static_cast<uint32>(pages.size() - 1);
+				view.block = pages.back()->allocate(descriptorCount, 1);
+			}
+
+			const uint64 offset = view.block.offset;
+			std::map<uint64, uint64>& ranges = allocatedRanges[view.page];
+			auto next = ranges.lower_bound(offset);
+			isValid = view.block.isValid() && view.block.size >= descriptorCount && offset + view.block.size <= pages[view.page]->getCapacity()
+				&& (next == ranges.end() || next->first >= offset + view.block.size)
+				&& (next == ranges.begin() || std::prev(next)->second <= offset);
+
+			if (isValid) {
+				ranges.emplace(offset, offset + view.block.size);
+				views.push_back(view);
+			}
+		}
+		else {
+			const size_t index = random() % views.size();
+			allocatedRanges[views[index].page].erase(views[index].block.offset);
+			pages[views[index].page]->free(views[index].block);
+			views[index] = views.back();
+			views.pop_back();
+		}
+	}
+
+	for (const auto& view : views) {
+		pages[view.page]->free(view.block);
+	}
+
+	uint64 stagingCapacity = 0;
+	for (const auto& page : pages) {
+		stagingCapacity += page->getCapacity();
+		isValid = isValid && page->isEmpty() && page->getStatistics().freeBlockCount == 1 && page->getLargestFreeBlockSize() == page->getCapacity();
+	}
+
+	std::cout << "Staging: " << pages.size() << " pages, " << stagingCapacity << " descriptors" << std::endl;
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//DDSのヘッダーを組み立てる。fourCCが"DX10"なら拡張ヘッダーにdxgiFormatを書く
+VectorArray<byte> makeDdsHeader(uint32 width, uint32 height, uint32 mipCount, const char* fourCC, uint32 dxgiFormat) {
+	VectorArray<byte> data(DdsLayout::MaxHeaderSize);
+	auto write = [&data](uint64 offset, uint32 value) {
+		memcpy(data.data() + offset, &value, sizeof(value));
+	};
+
+	memcpy(data.data(), "DDS ", 4);
+	write(4, 124);
+	write(12, height);
+	write(16, width);
+	write(28, mipCount);
+	write(76, 32);
+	write(80, 0x4);
+	memcpy(data.data() + 84, fourCC, 4);
+
+	if (strcmp(fourCC, "DX10") == 0) {
+		write(128, dxgiFormat);
+		write(132, 3);
+		write(140, 1);
+	}
+	else {
+		data.resize(128);
+	}
+
+	return data;
+}
+
+//2Dテクスチャ1枚のDDSで、各ミップが幅と高さから求めた大きさで隙間なく並び、ファイルの終わりで終わることを調べる
+bool verifyDdsLayout(const DdsLayout& layout) {
+	const uint32 blockSize = DdsLayout::getBlockSize(layout.getFormat());
+	const uint32 bitsPerPixel = DdsLayout::getBitsPerPixel(layout.getFormat());
+	uint64 offset = layout.getDataOffset();
+	bool isValid = true;
+	for (uint32 mip = 0; mip < layout.getMipCount() && isValid; ++mip) {
+		const DdsSubresourceLayout& subresource = layout.getSubresource(mip);
+		const uint32 width = std::max(layout.getWidth() >> mip, 1u);
+		const uint32 height = std::max(layout.getHeight() >> mip, 1u);
+		const uint64 rowSize = blockSize > 0 ? static_cast<uint64>((width + 3) / 4) * blockSize : (static_cast<uint64>(width) * bitsPerPixel + 7) / 8;
+		const uint64 rowCount = blockSize > 0 ? (height + 3) / 4 : height;
+
+		//ブロック圧縮では4の倍数でないミップを先頭にできない
+		isValid = subresource.offset == offset && subresource.width == width && subresource.height == height && subresource.size == rowSize * rowCount
+			&& layout.getMipChainSize(mip) == layout.getFileSize() - offset
+			&& layout.isValidTopMip(mip) == (blockSize == 0 || (width % 4 == 0 && height % 4 == 0));
+		offset += subresource.size;
+	}
+
+	return isValid && offset == layout.getFileSize() && !layout.isValidTopMip(layout.getMipCount());
+}
+
+//TextureStreamingPolicy::computePriorityと同じ、ミップの1テクセルが画面の何ピクセルに広がるか
+float computeStreamingPriority(const StreamingTextureState& texture, uint32 mip) {
+	return texture.screenSize > 0.0f ? texture.screenSize / static_cast<float>(std::max(texture.size >> mip, 1u)) : 0.0f;
+}
+
+//DDSのヘッダーから求めるミップの配置と、ストリーミングの目標ミップ、ロードと解放の要求を調べる
+//テクスチャはTextureStreamer::registerTextureと同じくDdsLayoutのミップサイズから状態を作り、要求を反映するフレームを繰り返す
+int checkTextureStreaming() {
+	//GraphicsConstantSettings.hのTextureStreamingMinResidentSizeとTextureStreamingMaxPendingLoadCount
+	const uint32 minResidentSize = 64;
+	const uint32 maxLoadCount = 8;
+	const uint32 bc1Format = 71;
+	const uint32 bc7Format = 98;
+	const uint32 rgbaFormat = 28;
+
+	//旧形式のDXT1、DX10拡張ヘッダーのBC7、非圧縮のRGBA。BC7は8x6のミップから、RGBAは幅が4の倍数でないミップがある
+	DdsLayout bc1;
+	DdsLayout bc7;
+	DdsLayout rgba;
+	const VectorArray<byte> bc1Header = makeDdsHeader(1024, 512, 11, "DXT1", 0);
+	const VectorArray<byte> bc7Header = makeDdsHeader(1024, 768, 11, "DX10", bc7Format);
+	const VectorArray<byte> rgbaHeader = makeDdsHeader(300, 200, 9, "DX10", rgbaFormat);
+	bool isValid = bc1.parse(bc1Header.data(), bc1Header.size()) && bc7.parse(bc7Header.data(), bc7Header.size()) && rgba.parse(rgbaHeader.data(), rgbaHeader.size());
+	isValid = isValid && verifyDdsLayout(bc1) && verifyDdsLayout(bc7) && verifyDdsLayout(rgba);
+	isValid = isValid && bc1.getFormat() == bc1Format && bc1.getDataOffset() == 128 && bc1.getSubresource(10).size == 8 && bc1.isStreamable()
+		&& bc7.getDataOffset() == 148 && !bc7.isValidTopMip(7) && rgba.getSubresource(0).rowPitch == 1200;
+
+	//ミップ数が大きさに合わないもの、ヘッダーが途中で切れているものは読まない
+	DdsLayout broken;
+	const VectorArray<byte> tooManyMipsHeader = makeDdsHeader(1024, 512, 12, "DXT1", 0);
+	isValid = isValid && !broken.parse(tooManyMipsHeader.data(), tooManyMipsHeader.size()) && !broken.parse(bc1Header.data(), 100)
+		&& !broken.parse(bc7Header.data(), 128);
+
+	std::cout << "Dds: " << bc1.getFileSize() << ", " << bc7.getFileSize() << ", " << rgba.getFileSize() << " bytes" << std::endl;
+
+	std::mt19937 random(1);
+	const uint32 textureCount = 64;
+	VectorArray<StreamingTextureState> textures(textureCount);
+	for (auto& texture : textures) {
+		const uint32 width = 1u << (6 + random() % 7);
+		const uint32 height = std::max(width >> (random() % 3), 1u);
+		uint32 mipCount = 1;
+		for (uint32 size = width; size > 1; size >>= 1) {
+			++mipCount;
+		}
+
+		DdsLayout layout;
+		const VectorArray<byte> header = makeDdsHeader(width, height, mipCount, "DXT1", 0);
+		isValid = isValid && layout.parse(header.data(), header.size());
+		if (!isValid) {
+			break;
+		}
+
+		texture.size = std::max(width, height);
+		texture.mipCount = layout.getMipCount();
+		texture.minResidentMip = 0;
+		while (texture.minResidentMip + 1 < texture.mipCount && std::max(texture.size >> texture.minResidentMip, 1u) > minResidentSize) {
+			++texture.minResidentMip;
+		}
+		texture.residentMip = random() % (texture.minResidentMip + 1);
+		texture.mipSizes.resize(texture.mipCount);
+		for (uint32 mip = 0; mip < texture.mipCount; ++mip) {
+			texture.mipSizes[mip] = layout.getSubresource(mip).size;
+		}
+	}
+
+	//予算は全部を最も詳細にしたときの一部。フレームごとに見え方を変え、最後は動かさずに目標へ収束させる
+	uint64 fullSize = 0;
+	for (const auto& texture : textures) {
+		fullSize += TextureStreamingPolicy::computeResidentSize(texture, 0);
+	}
+
+	TextureStreamingPolicy policy;
+	policy.create(fullSize / 8, 0.0f);
+
+	const uint32 movingFrameCount = 200;
+	const uint32 frameCount = 400;
+	uint32 loadCount = 0;
+	uint32 evictionCount = 0;
+	VectorArray<uint32> targetMips;
+	VectorArray<StreamingRequest> evictions;
+	VectorArray<StreamingRequest> loads;
+	for (uint32 frame = 0; frame < frameCount && isValid; ++frame) {
+		if (frame < movingFrameCount) {
+			for (auto& texture : textures) {
+				texture.screenSize = random() % 4 == 0 ? 0.0f : static_cast<float>(random() % (2 * texture.size));
+			}
+		}
+
+		policy.computeTargetMips(textures, targetMips);
+
+		//目標は常駐の範囲内で、見えていれば欲しいミップより粗く、見えていなければ今のミップより粗い
+		uint64 targetSize = 0;
+		bool isAllMinResident = true;
+		for (uint32 i = 0; i < textureCount; ++i) {
+			const int32 wantedMip = policy.computeWantedMip(textures[i]);
+			const uint32 baseMip = wantedMip < 0 ? textures[i].residentMip : static_cast<uint32>(wantedMip);
+			isValid = isValid && targetMips[i] >= baseMip && targetMips[i] <= textures[i].minResidentMip;
+			targetSize += TextureStreamingPolicy::computeResidentSize(textures[i], targetMips[i]);
+			isAllMinResident = isAllMinResident && targetMips[i] == textures[i].minResidentMip;
+		}
+		isValid = isValid && (targetSize <= policy.getBudget() || isAllMinResident);
+
+		//削られたテクスチャは、最後に削ったミップの優先度がまだ削れる他のテクスチャの優先度を超えない
+		for (uint32 i = 0; i < textureCount && isValid; ++i) {
+			const int32 wantedMip = policy.computeWantedMip(textures[i]);
+			const uint32 baseMip = wantedMip < 0 ? textures[i].residentMip : static_cast<uint32>(wantedMip);
+			if (targetMips[i] == baseMip) {
+				continue;
+			}
+
+			const float removedPriority = computeStreamingPriority(textures[i], targetMips[i] - 1);
+			for (uint32 j = 0; j < textureCount; ++j) {
+				isValid = isValid && (targetMips[j] == textures[j].minResidentMip || removedPriority <= computeStreamingPriority(textures[j], targetMips[j]));
+			}
+		}
+
+		policy.buildRequests(textures, targetMips, maxLoadCount, evictions, loads);
+
+		//解放は目標まで一度に、ロードは1段ずつ優先度の高い順に、上限までで、選ばれなかったものより優先度が低くない
+		uint32 evictionTargetCount = 0;
+		uint32 loadTargetCount = 0;
+		for (uint32 i = 0; i < textureCount; ++i) {
+			evictionTargetCount += targetMips[i] > textures[i].residentMip ? 1 : 0;
+			loadTargetCount += targetMips[i] < textures[i].residentMip ? 1 : 0;
+		}
+		isValid = isValid && evictions.size() == evictionTargetCount && loads.size() == std::min(loadTargetCount, maxLoadCount);
+
+		for (const auto& eviction : evictions) {
+			isValid = isValid && eviction.targetMip == targetMips[eviction.textureIndex] && eviction.targetMip > textures[eviction.textureIndex].residentMip;
+		}
+
+		VectorArray<bool> isLoaded(textureCount, false);
+		for (uint32 i = 0; i < loads.size() && isValid; ++i) {
+			const StreamingTextureState& texture = textures[loads[i].textureIndex];
+			isValid = !isLoaded[loads[i].textureIndex] && targetMips[loads[i].textureIndex] < texture.residentMip && loads[i].targetMip + 1 == texture.residentMip
+				&& loads[i].priority == computeStreamingPriority(texture, loads[i].targetMip) && (i == 0 || loads[i - 1].priority >= loads[i].priority);
+			isLoaded[loads[i].textureIndex] = true;
+		}
+
+		for (uint32 i = 0; i < textureCount && isValid && !loads.empty(); ++i) {
+			if (!isLoaded[i] && targetMips[i] < textures[i].residentMip) {
+				isValid = computeStreamingPriority(textures[i], textures[i].residentMip - 1) <= loads.back().priority;
+			}
+		}
+
+		for (const auto& eviction : evictions) {
+			textures[eviction.textureIndex].residentMip = eviction.targetMip;
+		}
+		for (const auto& load : loads) {
+			textures[load.textureIndex].residentMip = load.targetMip;
+		}
+
+		evictionCount += static_cast<uint32>(evictions.size());
+		loadCount += static_cast<uint32>(loads.size());
+	}
+
+	//動かさなければ要求がなくなり、常駐しているミップが目標と一致する
+	isValid = isValid && evictions.empty() && loads.empty();
+	for (uint32 i = 0; i < textureCount && isValid; ++i) {
+		isValid = textures[i].residentMip == targetMips[i];
+	}
+
+	std::cout << "Streaming: " << loadCount << " loads, " << evictionCount << " evictions, budget " << policy.getBudget() / 1024 << " KB" << std::endl;
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//インクルードの走査とキャッシュのキーを、メモリ上に置いたシェーダーのファイルで調べる
+//ディレクトリからの相対パス、パスそのままの順の解決、コメント内の#include、見つからないインクルード、重複を含める
+//キーはたどったファイルの内容、コンパイラーのバージョンで変わり、識別のハッシュはファイル、マクロ、フラグでだけ変わる
+int checkShaderCache() {
+	std::map<String, String> files;
+	files["Shaders/Main.hlsl"] =
+		"// #include \"Ignored.hlsli\"\n"
+		"/* #include \"Ignored.hlsli\" */\n"
+		"#include \"Common.hlsli\"\n"
+		"  #  include <Lighting/Light.hlsli>\n"
+		"#include \"Missing.hlsli\"\n"
+		"#define INCLUDE_TEXT #include \"Ignored.hlsli\"\n"
+		"float4 main() : SV_Target { return 0; } // #include \"Ignored.hlsli\"\n";
+	files["Shaders/Common.hlsli"] = "#define PI 3.14159\n";
+	files["Shaders/Lighting/Light.hlsli"] = "#include \"../Common.hlsli\"\n#include \"Shared/Constants.h\"\n";
+	files["Shared/Constants.h"] = "#define LIGHT_COUNT 4\n";
+
+	const ShaderSourceReader reader = [&files](const String& filePath, VectorArray<byte>& outData) {
+		auto itr = files.find(filePath);
+		if (itr == files.end()) {
+			return false;
+		}
+
+		outData.assign(itr->second.begin(), itr->second.end());
+		return true;
+	};
+
+	auto hashFile = [&files](const String& filePath) {
+		const String& source = files.at(filePath);
+		return AssetCooker::computeHash(source.data(), source.size());
+	};
+
+	VectorArray<ShaderSourceFile> sourceFiles;
+	bool isValid = ShaderSourceScanner::scan("Shaders/Main.hlsl", reader, sourceFiles);
+
+	//見つからないインクルードはパスそのままで、ハッシュ0で残る
+	const char* expectedPaths[] = { "Shaders/Main.hlsl", "Shaders/Common.hlsli", "Shaders/Lighting/Light.hlsli", "Missing.hlsli", "Shared/Constants.h" };
+	isValid = isValid && sourceFiles.size() == 5;
+	for (uint32 i = 0; i < sourceFiles.size() && isValid; ++i) {
+		const String expectedPath = expectedPaths[i];
+		isValid = sourceFiles[i].path == expectedPath && sourceFiles[i].hash == (files.count(expectedPath) > 0 ? hashFile(expectedPath) : 0);
+	}
+
+	isValid = isValid && ShaderSourceScanner::normalizePath("a\\b/./c/../d.hlsl") == "a/b/d.hlsl" && ShaderSourceScanner::normalizePath("../x/../../y") == "../../y"
+		&& ShaderSourceScanner::normalizePath("/root//p/") == "/root/p" && ShaderSourceScanner::getDirectory("a/b\\c.hlsl") == "a/b\\"
+		&& ShaderSourceScanner::getDirectory("c.hlsl").empty();
+	VectorArray<ShaderSourceFile> missingFiles;
+	isValid = isValid && !ShaderSourceScanner::scan("Shaders/Missing.hlsl", reader, missingFiles);
+
+	ShaderCompileDesc desc;
+	desc.filePath = "Shaders/Main.hlsl";
+	desc.entryPoint = "main";
+	desc.target = "ps_6_0";
+	desc.defines = { { "USE_SHADOW", "1" }, { "QUALITY", "" } };
+	desc.flags = 1;
+
+	auto computeKey = [&](const ShaderCompileDesc& keyDesc) {
+		VectorArray<ShaderSourceFile> keyFiles;
+		ShaderSourceScanner::scan(keyDesc.filePath, reader, keyFiles);
+		return ShaderCache::computeKey(keyDesc, keyFiles);
+	};
+
+	const uint64 identityHash = ShaderCache::computeIdentityHash(desc);
+	const uint64 key = computeKey(desc);
+	isValid = isValid && ShaderCache::computeIdentityHash(desc) == identityHash && computeKey(desc) == key;
+
+	//識別のハッシュが変わるもの。マクロは定義した順も区別し、名前と値の区切りもずらさない
+	ShaderCompileDesc otherDesc = desc;
+	otherDesc.defines = { { "QUALITY", "" }, { "USE_SHADOW", "1" } };
+	const uint64 reorderedIdentityHash = ShaderCache::computeIdentityHash(otherDesc);
+	otherDesc = desc;
+	otherDesc.defines[0] = { "USE_SHADOW1", "" };
+	const uint64 shiftedIdentityHash = ShaderCache::computeIdentityHash(otherDesc);
+	otherDesc = desc;
+	otherDesc.flags = 0;
+	const uint64 flagsIdentityHash = ShaderCache::computeIdentityHash(otherDesc);
+	otherDesc = desc;
+	otherDesc.entryPoint = "mainPS";
+	const uint64 entryPointIdentityHash = ShaderCache::computeIdentityHash(otherDesc);
+	isValid = isValid && reorderedIdentityHash != identityHash && shiftedIdentityHash != identityHash && flagsIdentityHash != identityHash
+		&& entryPointIdentityHash != identityHash;
+
+	//識別のハッシュはそのままでキーだけが変わるもの
+	otherDesc = desc;
+	otherDesc.compilerVersion = 1;
+	const uint64 compilerKey = computeKey(otherDesc);
+	otherDesc = desc;
+	otherDesc.settingsHash = 1;
+	const uint64 settingsKey = computeKey(otherDesc);
+
+	files["Shared/Constants.h"] = "#define LIGHT_COUNT 8\n";
+	const uint64 includeKey = computeKey(desc);
+	files["Missing.hlsli"] = "";
+	const uint64 createdKey = computeKey(desc);
+	files.erase("Missing.hlsli");
+	files["Shared/Constants.h"] = "#define LIGHT_COUNT 4\n";
+
+	//同じ内容でもインクルードの解決先が変われば別のキーになる
+	files["Shaders/Lighting/Shared/Constants.h"] = files["Shared/Constants.h"];
+	const uint64 resolvedKey = computeKey(desc);
+	files.erase("Shaders/Lighting/Shared/Constants.h");
+
+	isValid = isValid && ShaderCache::computeIdentityHash(otherDesc) == identityHash && compilerKey != key && settingsKey != key && includeKey != key
+		&& createdKey != key && createdKey != includeKey && resolvedKey != key && computeKey(desc) == key;
+
+	//保存して読み直しても同じ内容が見つかり、キーが違えば見つからない。壊れたファイルは捨てて空から始める
+	const String cacheFilePath = "EngineCheck.shadercache";
+	const VectorArray<byte> byteCode = { 0x44, 0x58, 0x42, 0x43, 0x01, 0x02 };
+	const VectorArray<byte> reflection = { 0x10, 0x20 };
+	VectorArray<byte> foundByteCode;
+	VectorArray<byte> foundReflection;
+	{
+		ShaderCache cache;
+		cache.store(identityHash, key, byteCode.data(), byteCode.size(), reflection);
+		cache.store(reorderedIdentityHash, key, byteCode.data(), 4, VectorArray<byte>());
+		isValid = isValid && cache.isDirty() && cache.save(cacheFilePath) && !cache.isDirty();
+
+		cache.clear();
+		isValid = isValid && cache.load(cacheFilePath) && cache.getStatistics().entryCount == 2
+			&& cache.find(identityHash, key, foundByteCode, foundReflection) && foundByteCode == byteCode && foundReflection == reflection
+			&& !cache.find(identityHash, includeKey, foundByteCode, foundReflection) && !cache.find(flagsIdentityHash, key, foundByteCode, foundReflection)
+			&& cache.find(reorderedIdentityHash, key, foundByteCode, foundReflection) && foundByteCode.size() == 4 && foundReflection.empty();
+		isValid = isValid && cache.getStatistics().hitCount == 2 && cache.getStatistics().missCount == 2;
+
+		VectorArray<byte> data;
+		isValid = isValid && ShaderSourceScanner::readFile(cacheFilePath, data) && !data.empty();
+		if (isValid) {
+			data.back() ^= 0xff;
+			std::ofstream fout(cacheFilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+		}
+
+		isValid = isValid && !cache.load(cacheFilePath) && cache.getStatistics().isDiscarded && cache.getStatistics().entryCount == 0
+			&& !cache.find(identityHash, key, foundByteCode, foundReflection) && cache.isDirty();
+	}
+	std::remove(cacheFilePath.c_str());
+
+	std::cout << "Shader: " << sourceFiles.size() << " files, key " << std::hex << key << std::dec << std::endl;
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+//CommandQueueの代わりにFencedObjectPoolへ渡すフェンス。完了値はsignalで進め、waitForFenceは完了するまで止まる
+//isBlockingがfalseなら、待つと同時にその値まで完了したものとして扱う
+struct MockFence {
+	std::mutex mutex;
+	std::condition_variable condition;
+	uint64 completedValue = 0;
+	uint32 waitingCount = 0;
+	bool isBlocking = true;
+
+	uint64 fenceValue() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return completedValue;
+	}
+
+	void waitForFence(uint64 value) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!isBlocking) {
+			completedValue = std::max(completedValue, value);
+			return;
+		}
+
+		++waitingCount;
+		condition.notify_all();
+		condition.wait(lock, [this, value]() { return completedValue >= value; });
+		--waitingCount;
+	}
+
+	void signal(uint64 value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		completedValue = std::max(completedValue, value);
+		condition.notify_all();
+	}
+
+	//いずれかのスレッドがwaitForFenceで止まるまで待つ
+	void waitForWaiter() {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this]() { return waitingCount > 0; });
+	}
+};
+
+//コマンドアロケーターとコマンドリストのプールの選び方を、模擬したフェンスで調べる
+//返却の順が前後しても完了したものを再利用し、上限では最も古いものを待つ。待っている間はプールのロックを持たず、他のスレッドが要求できる
+int checkFencedPool() {
+	uint32 nextObject = 1;
+	auto create = [&nextObject]() { return nextObject++; };
+
+	//フェンス3、1、2の順に返却されても、完了値1ならフェンス1のものを使う。上限に達していれば最も古いフェンスを待つ
+	MockFence fence;
+	fence.isBlocking = false;
+	FencedObjectPool<uint32> pool;
+	pool.create(3);
+	const uint32 first = pool.request(fence, create);
+	const uint32 second = pool.request(fence, create);
+	const uint32 third = pool.request(fence, create);
+	pool.discard(3, first);
+	pool.discard(1, second);
+	pool.discard(2, third);
+	fence.signal(1);
+	bool isValid = pool.request(fence, create) == second && pool.request(fence, create) == third && fence.completedValue == 2
+		&& pool.getStatistics().waitCount == 1 && pool.getStatistics().createCount == 3 && pool.size() == 3;
+
+	//上限に達して待つ間に、別のスレッドが要求と返却をできる。ロックを持ったまま待つと止まるので時間を区切る
+	MockFence blockingFence;
+	FencedObjectPool<uint32> blockingPool;
+	blockingPool.create(1);
+	const uint32 object = blockingPool.request(blockingFence, create);
+	blockingPool.discard(5, object);
+
+	std::future<uint32> waitingRequest = std::async(std::launch::async, [&]() { return blockingPool.request(blockingFence, create); });
+	blockingFence.waitForWaiter();
+	std::future<bool> otherRequest = std::async(std::launch::async, [&]() {
+		const uint32 overflowObject = blockingPool.request(blockingFence, create);
+		blockingPool.discard(6, overflowObject);
+		return overflowObject != object && blockingPool.getStatistics().overflowCount == 1;
+	});
+
+	const bool isOtherFinished = otherRequest.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+	blockingFence.signal(5);
+	isValid = isValid && isOtherFinished && otherRequest.get() && waitingRequest.get() == object;
+
+	//複数スレッドから要求と返却を繰り返し、貸し出し中のものを重ねて渡さず、返却時のフェンスが完了したものだけを渡すことを調べる
+	const uint32 threadCount = 4;
+	const uint32 requestCountPerThread = 20000;
+	const uint32 maxObjectCount = 8;
+	MockFence threadFence;
+	FencedObjectPool<uint32> threadPool;
+	threadPool.create(maxObjectCount);
+
+	std::mutex checkMutex;
+	std::map<uint32, uint64> discardedFenceValues;
+	std::map<uint32, bool> isLentObjects;
+	std::atomic<uint64> submittedFenceValue(0);
+	std::atomic<uint32> finishedThreadCount(0);
+	std::atomic<bool> isThreadValid(true);
+	std::atomic<uint32> nextThreadObject(1);
+
+	//GPUの代わりに、提出済みのフェンスを数個遅れで完了させる。遅れが上限を超えるとプールは待つ
+	std::thread gpuThread([&]() {
+		std::mt19937 gpuRandom(1);
+		while (finishedThreadCount < threadCount) {
+			const uint64 lag = gpuRandom() % (2 * maxObjectCount);
+			const uint64 fenceValue = submittedFenceValue;
+			if (fenceValue > lag) {
+				threadFence.signal(fenceValue - lag);
+			}
+			std::this_thread::yield();
+		}
+	});
+
+	VectorArray<std::thread> threads;
+	for (uint32 i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&]() {
+			for (uint32 j = 0; j < requestCountPerThread; ++j) {
+				const uint32 threadObject = threadPool.request(threadFence, [&nextThreadObject]() { return nextThreadObject++; });
+				const uint64 completedValue = threadFence.fenceValue();
+				{
+					std::lock_guard<std::mutex> lock(checkMutex);
+					auto itr = discardedFenceValues.find(threadObject);
+					if (isLentObjects[threadObject] || (itr != discardedFenceValues.end() && itr->second > completedValue)) {
+						isThreadValid = false;
+					}
+					isLentObjects[threadObject] = true;
+				}
+
+				//コマンドを積んで提出する代わりにフェンス値を進める
+				const uint64 fenceValue = ++submittedFenceValue;
+				{
+					std::lock_guard<std::mutex> lock(checkMutex);
+					isLentObjects[threadObject] = false;
+					discardedFenceValues[threadObject] = fenceValue;
+				}
+				threadPool.discard(fenceValue, threadObject);
+			}
+			++finishedThreadCount;
+		});
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	gpuThread.join();
+
+	const FencedPoolStatistics statistics = threadPool.getStatistics();
+	std::cout << "Pool: " << statistics.createCount << " created, " << statistics.reuseCount << " reused, " << statistics.waitCount << " waits, high watermark "
+		<< statistics.highWatermark << std::endl;
+
+	isValid = isValid && isThreadValid && threadPool.size() <= maxObjectCount && statistics.overflowCount == 0 && statistics.inUseCount == 0
+		&& statistics.highWatermark <= threadCount && statistics.createCount + statistics.reuseCount == threadCount * requestCountPerThread
+		&& threadPool.pendingSize() == threadPool.size();
+
+	std::cout << (isValid ? "Valid" : "Mismatch") << std::endl;
+	return isValid ? 0 : 1;
+}
+
+struct EngineCheck {
+	const char* name;
+	int(*function)();
+};
+
+int main(int argc, char* argv[]) {
+	const EngineCheck checks[] = {
+		{ "rendergraph", checkRenderGraph },
+		{ "fencedring", checkFencedRing },
+		{ "descriptorheap", checkDescriptorHeap },
+		{ "fencedpool", checkFencedPool },
+		{ "texturestreaming", checkTextureStreaming },
+		{ "shadercache", checkShaderCache },
+	};
+
+	int result = 0;
+	for (const auto& check : checks) {
+		bool isSelected = argc <= 1;
+		for (int i = 1; i < argc; ++i) {
+			isSelected = isSelected || strcmp(argv[i], check.name) == 0;
+		}
+
+		if (!isSelected) {
+			continue;
+		}
+
+		std::cout << "Check: " << check.name << std::endl;
+		result |= check.function();
+	}
+
+	return result;
+}
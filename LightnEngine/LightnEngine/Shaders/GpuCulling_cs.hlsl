@@ -1,5 +1,6 @@
 #define ThreadBlockSize 256
 #define FrustumPlaneCount 4
+#define MaxLodCount 4 //MESH_MAX_LOD_COUNTと合わせる
 
 struct AABB {
 	float3 min;
@@ -9,7 +10,9 @@ struct AABB {
 struct ObjectInfo {
 	float4x4 mtxWorld;
 	AABB boundingBox;
-	uint indirectArgumentIndex;
+	uint indirectArgumentIndex;//LOD0の出力先。LODごとの出力先はその後ろに続く
+	uint lodCount;
+	float lodErrors[MaxLodCount];//AABBの対角線に対するずれ。[0]はLOD0なので0
 };
 
 struct OutputInfo {
@@ -20,9 +23,10 @@ cbuffer RootConstants : register(b0)
 {
 	float4 cameraPosition;
 	float4 frustumPlanes[FrustumPlaneCount];//Right Left Top Bottom
+	float4 lodParameters;//xは画面の高さ/tan(fovY/2)、yは許すずれのピクセル数
 };
 
-//AABB̖@ɍł߂|CgT
+//AABBの法線方向に最も近いポイントを探す
 float3 GetPositivePoint(AABB aabb, float3 planeNormal)
 {
 	float3 result = aabb.min;
@@ -35,6 +39,23 @@ float3 GetPositivePoint(AABB aabb, float3 planeNormal)
 	return result;
 }
 
+//ずれが画面上でlodParameters.yピクセル以下に収まる最も粗いLODを選ぶ。MeshSimplifier::selectLodと同じ計算
+uint SelectLod(ObjectInfo objectInfo)
+{
+	//AABBを囲む境界球の画面上の直径。カメラが球の中にあれば画面の高さより大きくしない
+	float3 center = (objectInfo.boundingBox.min + objectInfo.boundingBox.max) * 0.5f;
+	float radius = length(objectInfo.boundingBox.max - objectInfo.boundingBox.min) * 0.5f;
+	float distance = max(length(center - cameraPosition.xyz), radius);
+	float screenSize = distance > 0 ? radius / distance * lodParameters.x : 0;
+
+	uint lod = 0;
+	while (lod + 1 < objectInfo.lodCount && objectInfo.lodErrors[lod + 1] * screenSize <= lodParameters.y) {
+		lod++;
+	}
+
+	return lod;
+}
+
 StructuredBuffer<ObjectInfo> inputCommands            : register(t0);    // SRV: Indirect commands
 AppendStructuredBuffer<OutputInfo> outputCommands[]    : register(u0);    // UAV: Processed indirect commands
 
@@ -47,7 +68,7 @@ void CSMain(uint3 groupId : SV_GroupID, uint3 threadGroupId : SV_GroupThreadID)
 	uint stride;
 	inputCommands.GetDimensions(numStructure, stride);
 
-	//256XbhPʂœĂ̂ňꂽ牽Ȃ
+	//256スレッド単位で動かしているので溢れたら何もしない
 	if (index >= numStructure) {
 		return;
 	}
@@ -55,23 +76,24 @@ void CSMain(uint3 groupId : SV_GroupID, uint3 threadGroupId : SV_GroupThreadID)
 	ObjectInfo objectInfo = inputCommands[index];
 	uint inCount = 0;
 
-	//䕽ʂ̐`FbN
+	//視錐台平面の数だけチェック
 	for (uint i = 0; i < FrustumPlaneCount; ++i) {
 		float3 aabbPos = GetPositivePoint(objectInfo.boundingBox, frustumPlanes[i].xyz);
 		float3 viewPosition = aabbPos - cameraPosition.xyz;
 		float length = dot(frustumPlanes[i].xyz, viewPosition);
 
-		//ʂAABB̕ʕ̊pɂΓς̒lvXɂȂ
+		//平面とAABBの平面方向の角が内側にあれば内積の値がプラスになる
 		if (length > 0) {
 			inCount++;
 		}
 	}
 
-	//䂷ׂĂ̕ʓɓĂ`惊Xgɉ
+	//視錐台すべての平面内に入っていたら選んだLODの描画リストに加える
 	if (inCount == FrustumPlaneCount) {
 		OutputInfo info;
 		info.mtxWorld = objectInfo.mtxWorld;
 
-		outputCommands[objectInfo.indirectArgumentIndex].Append(info);
+		uint outputIndex = objectInfo.indirectArgumentIndex + SelectLod(objectInfo);
+		outputCommands[outputIndex].Append(info);
 	}
 }
\ No newline at end of file
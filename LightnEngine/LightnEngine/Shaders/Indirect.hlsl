@@ -13,10 +13,7 @@ struct PSInput
 };
 
 struct VSInput {
-	float3 position : POSITION;
-	float3 normal : NORMAL;
-	float3 tangent : TANGENT;
-	float2 uv : TEXCOORD;
+	MeshVertexInput vertex;
 	float4x4 mtxWorld : MATRIX0;
 };
 
@@ -25,24 +22,27 @@ cbuffer CameraInfo : register(b0)
 	CameraInfo camera;
 }
 
-cbuffer TextureIndices: register(b1) {
+//インダイレクト引数のルート定数
+cbuffer DrawConstants : register(b1) {
 	uint4 textureIndices;
+	VertexDequantization dequantization;
 }
 
 PSInput VSMain(VSInput input, uint vertexId : SV_VertexID)
 {
 	PSInput result;
 
+	MeshVertex vertex = DecodeMeshVertex(input.vertex, dequantization);
 	float4x4 mtxWorld = input.mtxWorld;
-	float4 worldPos = mul(float4(input.position, 1), mtxWorld);
+	float4 worldPos = mul(float4(vertex.position, 1), mtxWorld);
 
 	float4 viewPos = mul(worldPos, camera.mtxView);
 	result.position = mul(viewPos, camera.mtxProj);
-	result.normal = normalize(mul(input.normal, (float3x3) mtxWorld));
-	result.tangent = normalize(mul(input.tangent, (float3x3) mtxWorld));
-	result.binormal = cross(result.normal, result.tangent);
+	result.normal = normalize(mul(vertex.normal, (float3x3) mtxWorld));
+	result.tangent = normalize(mul(vertex.tangent, (float3x3) mtxWorld));
+	result.binormal = cross(result.normal, result.tangent) * vertex.bitangentSign;
 
-	result.uv = input.uv;
+	result.uv = vertex.uv;
 	result.viewDir = normalize(camera.cameraPos - worldPos.xyz);
 	result.textureIndices = textureIndices;
 	result.worldPosition = worldPos.xyz;
@@ -53,7 +53,10 @@ PSInput VSMain(VSInput input, uint vertexId : SV_VertexID)
 TextureCube irradianceMap : register(t0);
 TextureCube prefilterMap : register(t1);
 Texture2D brdfLUT : register(t2);
-Texture2D textures[] : register(t3);
+//バインドレステーブル。インデックスはインダイレクト引数のルート定数で渡される
+Texture2D textures[] : register(t0, space1);
+//ストリーミングでテクスチャが差し替わるとスロットが変わるので、固定インデックスから現在のスロットを引く
+StructuredBuffer<uint> bindlessRemap : register(t3);
 SamplerState t_sampler : register(s0);
 
 cbuffer DirectionalLightBuffer : register(b0){
@@ -84,9 +87,9 @@ float computePreExposedIntensity(float intensity, float exposure) {
 }
 
 float4 PSMain(PSInput input) : SV_Target{
-	float3 albedo = textures[input.textureIndices.x].Sample(t_sampler, input.uv).rgb;
-	float2 normalMap = textures[input.textureIndices.y].Sample(t_sampler, input.uv).rg;
-	float3 arm = textures[input.textureIndices.z].Sample(t_sampler, input.uv).rgb;
+	float3 albedo = textures[bindlessRemap[input.textureIndices.x]].Sample(t_sampler, input.uv).rgb;
+	float2 normalMap = textures[bindlessRemap[input.textureIndices.y]].Sample(t_sampler, input.uv).rg;
+	float3 arm = textures[bindlessRemap[input.textureIndices.z]].Sample(t_sampler, input.uv).rgb;
 
 	float metallic = arm.b;
 	float roughness = arm.g;
@@ -98,20 +101,20 @@ float4 PSMain(PSInput input) : SV_Target{
 	//return float4(normalMap,1, 1);
 	//return float4(ao, 0, 0, 1);
 
-	//eNX`O
+	//テクスチャを前準備
 	albedo = ToLiner(albedo);
 	float3 bumpMap = DecodeNormalMapRG(normalMap);
 
-	//m[}}bv𔽉f
+	//ノーマルマップを反映
 	float3 N = (bumpMap.x * input.tangent) + (bumpMap.y * input.binormal) + (bumpMap.z * input.normal);
 	N = normalize(N);
 	//return float4(N / 2 + 0.5, 1);
 
-	//PBRx[XJ[Zo
+	//PBRベースカラーを算出
 	float3 diffuseColor = lerp(albedo, float3(0.04, 0.04, 0.04), metallic);
 	float3 specularColor = lerp(float3(0.04, 0.04, 0.04), albedo, metallic);
 
-	//CgxNgƐF`
+	//ライトベクトルと色を定義
 	float3 L = -directionalLight.direction;
 	float3 V = input.viewDir;
 	float3 H = normalize(L + V);
@@ -164,7 +167,7 @@ float4 PSMain(PSInput input) : SV_Target{
 	float3 prefilteredEnvColor = prefilterMap.SampleLevel(t_sampler, R, roughness * maxMipLevels).rgb;
 	prefilteredEnvColor = ToLiner(prefilteredEnvColor);
 	float2 envBRDF = brdfLUT.Sample(t_sampler, float2(dotNV, roughness)).rg;
-	float3 envSpecular = prefilteredEnvColor * (F * envBRDF.x + envBRDF.y)*0.2;//HDRƃXyL邷H
+	float3 envSpecular = prefilteredEnvColor * (F * envBRDF.x + envBRDF.y)*0.2;//HDRだとスペキュラが明るすぎる？
 	//return float4(envSpecular, 1);
 
 	float3 ambient = (kD * envDiffuse + envSpecular) * ao;
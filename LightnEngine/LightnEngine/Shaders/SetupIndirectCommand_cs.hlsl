@@ -6,39 +6,45 @@ struct IndirectCommand
 
 	uint2 ibAddress;
 	uint ibSizeInBytes;
-	uint ibFormat;
+	uint ibFormat;//R16_UINTとR32_UINTのメッシュが混ざるので、CPUが入れた値をそのまま渡す
 	
 	uint2 perInstanceVbAddress;
 	uint perInstanceSizeInBytes;
 	uint perInstanceStrideInBytes;
 	
 	uint4 textureIndices;
+	float4 positionScale;
+	float4 positionOffset;
 	uint drawArguments[6];
 };
 
+//MeshVertexFormatの数。頂点フォーマットごとにパイプラインステートが違うので、出力先を分けてExecuteIndirectを分ける
+#define VERTEX_FORMAT_COUNT 2
+
 struct InIndirectCommand {
-	uint4 meshIndex;
+	uint4 meshIndex;//xがメッシュとLODの組の番号、yが頂点フォーマット
 	IndirectCommand indirectCommand;
 };
 
-StructuredBuffer<InIndirectCommand> inputCommands : register(t0);//̕`R}h@bVCfbNXt
-StructuredBuffer<uint> countBufferOffsets : register(t1);//AppendStructureBuffer̃JEgl܂ł̃ItZbg
-ByteAddressBuffer objectDatas[] : register(t2);//`悳CX^VOp̍s񂪓ĂB̓JEgl邾
-AppendStructuredBuffer<IndirectCommand> outputCommands : register(u0);//ExecuteIndirectɓnobt@
+StructuredBuffer<InIndirectCommand> inputCommands : register(t0);//元の描画コマンド　メッシュインデックス付き
+StructuredBuffer<uint> countBufferOffsets : register(t1);//AppendStructureBufferのカウント値までのオフセット数
+ByteAddressBuffer objectDatas[] : register(t2);//描画されるインスタシング用の行列が入っている。今回はカウント値を見るだけ
+AppendStructuredBuffer<IndirectCommand> outputCommands[VERTEX_FORMAT_COUNT] : register(u0);//ExecuteIndirectに渡すバッファ。同じバッファを頂点フォーマットごとに区切っている
 
 [numthreads(1, 1, 1)]
 void CSMain(uint3 groupId : SV_GroupID)
 {	
 	uint argumentIndex = groupId.x;
 	uint meshIndex = inputCommands[argumentIndex].meshIndex.x;
+	uint vertexFormat = inputCommands[argumentIndex].meshIndex.y;
 	uint offsetCounterNum = countBufferOffsets[meshIndex];
-	uint numStructs = objectDatas[meshIndex].Load(offsetCounterNum);//AppendStructuredBuffer̃JEgɒڃANZX
+	uint numStructs = objectDatas[meshIndex].Load(offsetCounterNum);//AppendStructuredBufferのカウントに直接アクセス
 
-	//`悳Ȃꍇ͕`R}ĥǉȂ
+	//一つも描画されない場合は描画コマンド自体を追加しない
 	if (numStructs > 0) {
 		IndirectCommand command = inputCommands[argumentIndex].indirectCommand;
 		command.drawArguments[1] = numStructs;
 
-		outputCommands.Append(command);
+		outputCommands[vertexFormat].Append(command);
 	}
 }
\ No newline at end of file
@@ -19,7 +19,92 @@ struct PointLight {
 	float4 attenuation;
 };
 
-//0~1̃m[}}bv-1~1͈̔͂ɂ
+//メッシュの頂点。VERTEX_FORMAT_COMPACTを定義してコンパイルするとMeshFileCompactVertexの16バイトの並びを読む
+struct MeshVertexInput {
+#ifdef VERTEX_FORMAT_COMPACT
+	float4 position : POSITION;//xyzはAABB内の0~1、wは従法線の符号で0なら+1、1なら-1
+	float4 normalTangent : NORMAL;//xyが法線、zwが接線の八面体エンコード
+	float2 uv : TEXCOORD;
+#else
+	float3 position : POSITION;
+	float3 normal : NORMAL;
+	float3 tangent : TANGENT;//長さ1なら従法線の符号が+1、2なら-1
+	float2 uv : TEXCOORD;
+#endif
+};
+
+struct MeshVertex {
+	float3 position;
+	float3 normal;
+	float3 tangent;
+	float bitangentSign;//従法線はbitangentSign * cross(normal, tangent)
+	float2 uv;
+};
+
+//圧縮頂点の位置を戻す定数。float頂点ではscaleが1、offsetが0になっている
+struct VertexDequantization {
+	float4 positionScale;
+	float4 positionOffset;
+};
+
+//八面体エンコードした単位ベクトルを戻す。MeshVertexCodec::decodeOctahedralと同じ計算
+float3 DecodeOctahedral(float2 encoded) {
+	float3 direction = float3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-direction.z, 0.0);
+	direction.xy += direction.xy >= 0.0 ? -t : t;
+	return normalize(direction);
+}
+
+MeshVertex DecodeMeshVertex(MeshVertexInput input, VertexDequantization dequantization) {
+	MeshVertex vertex;
+#ifdef VERTEX_FORMAT_COMPACT
+	vertex.position = input.position.xyz * dequantization.positionScale.xyz + dequantization.positionOffset.xyz;
+	vertex.normal = DecodeOctahedral(input.normalTangent.xy);
+	vertex.tangent = DecodeOctahedral(input.normalTangent.zw);
+	vertex.bitangentSign = input.position.w > 0.5 ? -1.0 : 1.0;
+#else
+	vertex.position = input.position * dequantization.positionScale.xyz + dequantization.positionOffset.xyz;
+	vertex.normal = input.normal;
+	vertex.tangent = normalize(input.tangent);
+	vertex.bitangentSign = dot(input.tangent, input.tangent) > 2.25 ? -1.0 : 1.0;
+#endif
+	vertex.uv = input.uv;
+	return vertex;
+}
+
+//メッシュレットの境界とコーン。MeshFileMeshletと同じ48バイトの並び
+struct Meshlet {
+	float3 center;
+	float radius;
+	float3 coneAxis;
+	float coneCutoff;
+	uint vertexOffset;
+	uint triangleOffset;
+	uint vertexAndTriangleCount;//下位16ビットが頂点数、上位16ビットが三角形数
+	uint materialRangeIndex;
+};
+
+//メッシュレットが描画される可能性があるか。MeshletBuilder::cullMeshletと同じ計算
+//カメラ位置と視錐台の平面(内向きの法線)はメッシュのローカル空間で渡す
+bool IsMeshletVisible(Meshlet meshlet, float3 cameraPosition, float3 frustumPlanes[4], bool isBackfaceCullingEnabled) {
+	float3 toCenter = meshlet.center - cameraPosition;
+	for (uint i = 0; i < 4; ++i) {
+		if (dot(frustumPlanes[i], toCenter) < -meshlet.radius) {
+			return false;
+		}
+	}
+
+	//境界球のどこから見てもコーン内のすべての向きが視線と同じ側を向いていれば、すべての三角形が裏を向いている
+	if (isBackfaceCullingEnabled && meshlet.coneCutoff < 1.0) {
+		if (dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * length(toCenter) + meshlet.radius) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//0~1のノーマルマップを-1~1の範囲にする
 float3 DecodeNormalMapRG(in float2 normal) {
 	float2 flipGNormal = normal;
 	flipGNormal.g = 1.0 - normal.g;
@@ -30,23 +115,23 @@ float3 DecodeNormalMapRG(in float2 normal) {
 	return normalMap;
 }
 
-//gUBRDF
+//拡散反射BRDF
 float3 DiffuseBRDF(in float3 diffuseColor)
 {
 	return diffuseColor / PI;
 }
 
-//tl
+//フレネル
 float3 F_Schlick(in float3 f0, in float f90, in float u)
 {
 	return (f0 + (f90 - f0) * pow(1.0 - u, 5.0));
 }
 
-//Frostbyte3.0 DisnyDiffuseǔ https://seblagarde.files.wordpress.com/2015/07/course_notes_moving_frostbite_to_pbr_v32.pdf
+//Frostbyte3.0 DisnyDiffuse改良版 https://seblagarde.files.wordpress.com/2015/07/course_notes_moving_frostbite_to_pbr_v32.pdf
 float DisneyDiffuseBRDF(float dotNV, float dotNL, float dotLH, float linearRoughness)
 {
 	float energyBias = lerp(0, 0.5, linearRoughness);
-	float energyFactor = lerp(1.0, 1.0 / 1.51, linearRoughness); //]DisnyDiffuseł̓GlM[ۑ̖@𖞂Ȃ̂ŁAős[N1.5𐳋K
+	float energyFactor = lerp(1.0, 1.0 / 1.51, linearRoughness); //従来のDisnyDiffuseではエネルギー保存の法則を満たさないので、最大ピークの1.5を正規化する
 	float fd90 = energyBias + 2.0 * dotLH * dotLH * linearRoughness;
 	float3 f0 = float3(1.0f, 1.0f, 1.0f);
 
@@ -62,10 +147,10 @@ float V_SmithGGXCorralated(float dotNL, float dotNV, float alphaG)
 	float lambda_GGXV = dotNL * sqrt((-dotNV * alphaG2 + dotNV) * dotNV + alphaG2);
 	float lambda_GGXL = dotNV * sqrt((-dotNL * alphaG2 + dotNL) * dotNL + alphaG2);
 
-	return saturate(0.5f / lambda_GGXV + lambda_GGXL); //{saturate͂Ȃ͂BBB
+	return saturate(0.5f / lambda_GGXV + lambda_GGXL); //本来saturateはいらないはず。。。
 }
 
-//}CNt@Zbgz֐
+//マイクロファセット分布関数
 float D_GGX(in float a, in float dotNH)
 {
 	float a2 = a * a;
@@ -50,7 +50,7 @@ float4 PSMain(PSInput input) : SV_Target
     float3 diffuseColor = lerp(albedo.rgb, float3(0.04, 0.04, 0.04), metallic);
     float3 specularColor = lerp(float3(0.04, 0.04, 0.04), albedo.rgb, metallic);
 
-	 //CgxNgƐF`
+	 //ライトベクトルと色を定義
     float3 L = -directionalLight.direction;
     float3 V = input.viewDir;
     float3 H = normalize(L + V);
@@ -65,7 +65,7 @@ float4 PSMain(PSInput input) : SV_Target
     float3 irradistance = dotNL * directionalLight.color.xyz * directionalLight.intensity;
 	//return float4(irradistance,1);
 
-    //CeBOς݃J[XyL
+    //ライティング済みカラー＆スペキュラ
     float3 directDiffuse = irradistance * DisneyDiffuseBRDF(dotNV, dotNL, dotLH, roughness) * DiffuseBRDF(diffuseColor);
     float3 directSpecular = irradistance * FrostbiteSupecularBRDF(dotNH, dotNL, dotNV, dotLH, specularColor, roughness);
 
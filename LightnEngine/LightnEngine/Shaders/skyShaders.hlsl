@@ -1,17 +1,11 @@
+#include "ShaderUtil.hlsl"
+
 struct PSInput
 {
     float4 position : SV_POSITION;
     float3 uv : TEXCOORD;
 };
 
-struct VSInput
-{
-	float3 position : POSITION;
-	float3 normal : NORMAL;
-	float3 tangent : TANGENT;
-	float2 uv : TEXCOORD;
-};
-
 TextureCube _texture : register(t0);
 SamplerState _sampler : register(s0);
 
@@ -25,6 +19,7 @@ cbuffer CameraInfo : register(b0)
 cbuffer WorldMatrix : register(b1)
 {
 	float4x4 mtxWorld;
+	VertexDequantization dequantization;
 }
 
 cbuffer ConstantPS : register(b2)
@@ -33,16 +28,17 @@ cbuffer ConstantPS : register(b2)
     float dummy[60];
 }
 
-PSInput VSMain(VSInput input)
+PSInput VSMain(MeshVertexInput input)
 {
     PSInput result;
 
-    float4 worldPos = mul(float4(input.position, 1), mtxWorld);
+    MeshVertex vertex = DecodeMeshVertex(input, dequantization);
+    float4 worldPos = mul(float4(vertex.position, 1), mtxWorld);
 	float4 viewPos = float4(mul(worldPos.xyz, (float3x3)mtxView), 1);
     result.position = mul(viewPos, mtxProj);
 
     //result.position = input.position;
-    result.uv = input.position;
+    result.uv = vertex.position;
 
     //result.position.y += sin(offset2.x) / 2.0f;//+offset2_2.x;
     //result.position.x += cos(offset2_2.x) / 2.0f;
@@ -60,7 +60,7 @@ int Win32Application::run() {
 	_tmpCore.reset();
 
 #ifdef DEBUG
-	//[NĂComIuWFNg\
+	//メモリリークしているComオブジェクトを表示
 	IDXGIDebug1* pDebug = nullptr;
 	if (SUCCEEDED(DXGIGetDebugInterface1(0, IID_PPV_ARGS(&pDebug)))) {
 		pDebug->ReportLiveObjects(DXGI_DEBUG_ALL, DXGI_DEBUG_RLO_SUMMARY);
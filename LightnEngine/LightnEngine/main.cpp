@@ -5,7 +5,7 @@
 #include <SharedMaterial.h>
 #include <Scene.h>
 #include <GraphicsCore.h>
-#include <fstream>
+#include <AssetFileSystem.h>
 
 VectorArray<D3D12_INPUT_ELEMENT_DESC> inputLayouts = {
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,                            0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
@@ -37,7 +37,7 @@ public:
 		String roughness("Cerberus/Cerberus_R.dds");
 		String ao("Cerberus/Cerberus_AO.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		gfx.createTextures({ albedo, normal, metallic, roughness, ao, diffuseEnv, specularEnv, specularBrdf });
 
 		SharedMaterialCreateSettings materialSettings;
@@ -60,7 +60,7 @@ public:
 		skyMatSettings.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		gfx.createSharedMaterial(skyMatSettings);
 
-		//bVf[^ǂݍ
+		//メッシュデータ読み込み
 		gfx.createMeshSets({ meshName,skyName });
 		_mesh.loadInstance(meshName, { "TestM" });
 		_sky.loadInstance(skyName, { "TestS" });
@@ -139,7 +139,7 @@ public:
 		String roughness("ShaderBall/bamboo-wood-semigloss-roughness.dds");
 		String ao("ShaderBall/bamboo-wood-semigloss-ao.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		gfx.createTextures({ albedo, normal, metallic, roughness, ao, diffuseEnv, specularEnv, specularBrdf });
 
 		SharedMaterialCreateSettings materialSettings;
@@ -162,7 +162,7 @@ public:
 		skyMatSettings.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		gfx.createSharedMaterial(skyMatSettings);
 
-		//bVf[^ǂݍ
+		//メッシュデータ読み込み
 		gfx.createMeshSets({ shaderBallName,skyName });
 		_mesh.loadInstance(shaderBallName, { "TestM" });
 		_sky.loadInstance(skyName, { "TestS" });
@@ -238,7 +238,7 @@ public:
 		String specularEnv("cubemapSpecularHDR.dds");
 		String specularBrdf("cubemapBrdf.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		gfx.createTextures({ diffuseEnv, specularEnv, specularBrdf });
 
 		SharedMaterialCreateSettings skyMatSettings;
@@ -251,7 +251,7 @@ public:
 		skyMatSettings.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		gfx.createSharedMaterial(skyMatSettings);
 
-		//bVf[^ǂݍ
+		//メッシュデータ読み込み
 		gfx.createMeshSets({ meshName,skyName });
 
 		uint32 meshesLength = xNum * yNum;
@@ -375,7 +375,7 @@ public:
 		String roughness2("Cerberus/Cerberus_R.dds");
 		String ao2("Cerberus/Cerberus_AO.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		gfx.createTextures({ albedo, normal, metallic, roughness, ao, albedo2, normal2, metallic2, roughness2, ao2,
 			diffuseEnv, specularEnv, specularBrdf });
 
@@ -409,7 +409,7 @@ public:
 		skyMatSettings.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		gfx.createSharedMaterial(skyMatSettings);
 
-		//bVf[^ǂݍ
+		//メッシュデータ読み込み
 		gfx.createMeshSets({ meshName,skyName });
 		_mesh.loadInstance(meshName, { "TestM","TestM","TestM2" });
 		_sky.loadInstance(skyName, { "TestS" });
@@ -486,7 +486,7 @@ public:
 		String specularEnv("cubemapSpecularHDR.dds");
 		String specularBrdf("cubemapBrdf.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		//gfx.createTextures({ diffuseEnv, specularEnv, specularBrdf });
 
 		SharedMaterialCreateSettings skyMatSettings;
@@ -499,7 +499,7 @@ public:
 		skyMatSettings.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		gfx.createSharedMaterial(skyMatSettings);
 
-		//bVf[^ǂݍ
+		//メッシュデータ読み込み
 		//gfx.createMeshSets({ skyName });
 		//_sky.loadInstance(skyName, { "TestS" });
 	}
@@ -569,22 +569,29 @@ public:
 		String specularEnv("cubemapSpecularHDR.dds");
 		String specularBrdf("cubemapBrdf.dds");
 
-		//eNX`ǂݍ
+		//テクスチャ読み込み
 		gfx.createTextures({ diffuseEnv, specularEnv, specularBrdf });
 
 		String fullPath = "Resources/Environment/meshes.scene";
-		std::ifstream fin(fullPath.c_str(), std::ios::in | std::ios::binary);
-		fin.exceptions(std::ios::badbit);
-
-		assert(!fin.fail() && "bVt@Cǂݍ߂܂");
+		AssetFile sceneFile;
+		const bool isOpened = sceneFile.open(fullPath.c_str());
+		assert(isOpened && "メッシュファイルが読み込めません");
+
+		//アーカイブから開いてもよいように、ファイルの内容を先頭から順に読む
+		uint64 readOffset = 0;
+		auto read = [&](void* dst, uint64 size) {
+			assert(readOffset + size <= sceneFile.size() && "シーンファイルが壊れています");
+			memcpy(dst, sceneFile.data() + readOffset, static_cast<size_t>(size));
+			readOffset += size;
+		};
 
 		char materialName[64];
 		uint32 textureCount;
 		uint32 meshCount;
 
-		fin.read(reinterpret_cast<char*>(materialName), 64);
-		fin.read(reinterpret_cast<char*>(&textureCount), 4);
-		fin.read(reinterpret_cast<char*>(&meshCount), 4);
+		read(materialName, 64);
+		read(&textureCount, 4);
+		read(&meshCount, 4);
 
 		InitSettingsPerStaticMultiMesh initSettings;
 		initSettings.textureNames.resize(textureCount);
@@ -593,7 +600,7 @@ public:
 
 		for (uint32 i = 0; i < textureCount; ++i) {
 			char textureName[64];
-			fin.read(reinterpret_cast<char*>(textureName), 64);
+			read(textureName, 64);
 
 			initSettings.textureNames[i] = String("Environment/").append(String(textureName)).append(".dds");
 		}
@@ -602,9 +609,9 @@ public:
 			uint32 subMeshCount;
 			uint32 instanceCount;
 			char meshName[64];
-			fin.read(reinterpret_cast<char*>(meshName), 64);
-			fin.read(reinterpret_cast<char*>(&instanceCount), 4);
-			fin.read(reinterpret_cast<char*>(&subMeshCount), 4);
+			read(meshName, 64);
+			read(&instanceCount, 4);
+			read(&subMeshCount, 4);
 
 			initSettings.meshNames[i] = String("Environment/").append(String(meshName)).append(".mesh");
 
@@ -612,9 +619,9 @@ public:
 			meshData.matrices.resize(instanceCount);
 			meshData.textureIndices.resize(subMeshCount);
 
-			//eNX`Rǂݍ
+			//テクスチャ３枚読み込み
 			for (uint32 j = 0; j < subMeshCount; ++j) {
-				fin.read(reinterpret_cast<char*>(&meshData.textureIndices[j]), 12);
+				read(&meshData.textureIndices[j], 12);
 				//fin.read(reinterpret_cast<char*>(&meshData.textureIndices[j]), 16);
 			}
 
@@ -622,15 +629,15 @@ public:
 				Vector3 position;
 				Quaternion rotation;
 				Vector3 scale;
-				fin.read(reinterpret_cast<char*>(&position), 12);
-				fin.read(reinterpret_cast<char*>(&rotation), 16);
-				fin.read(reinterpret_cast<char*>(&scale), 12);
+				read(&position, 12);
+				read(&rotation, 16);
+				read(&scale, 12);
 
 				meshData.matrices[j] = Matrix4::createWorldMatrix(position, rotation, scale);
 			}
 		}
 
-		fin.close();
+		sceneFile.close();
 
 		RefPtr<GraphicsCore> graphicsCore = GFXInterface::instance()._graphicsCore.get();
 
@@ -649,6 +656,51 @@ public:
 	//SingleMeshRenderInstance _sky;
 };
 
+//大量のシングルメッシュで描画コマンドの並列記録のスケーリングを計測する
+class TestScene_ManySingleMeshes :public Scene {
+public:
+	void onStart() override {
+		Scene::onStart();
+
+		RefPtr<GraphicsCore> graphicsCore = GFXInterface::instance()._graphicsCore.get();
+
+		String meshName("sphere.mesh");
+		String diffuseEnv("cubemapEnvHDR.dds");
+
+		InitSettingsPerSingleMesh materialInfo = {};
+		materialInfo.vertexShaderName = "Shaders/skyShaders.hlsl";
+		materialInfo.pixelShaderName = "Shaders/skyShaders.hlsl";
+		materialInfo.textureNames = { diffuseEnv };
+
+		graphicsCore->createMeshSets({ meshName });
+
+		//パイプラインステートは1つだけ生成し、残りは共有インスタンスとして複製する
+		_meshes.resize(meshCountX * meshCountY);
+		_meshes[0] = graphicsCore->createSingleMeshRenderInstance(meshName, { materialInfo });
+		for (uint32 i = 1; i < _meshes.size(); ++i) {
+			_meshes[i] = graphicsCore->duplicateSingleMeshRenderInstance(_meshes[0]);
+		}
+
+		for (uint32 x = 0; x < meshCountX; ++x) {
+			for (uint32 y = 0; y < meshCountY; ++y) {
+				Vector3 position(x - meshCountX / 2.0f, y - meshCountY / 2.0f, 30.0f);
+				_meshes[x * meshCountY + y].updateWorldMatrix(Matrix4::scaleXYZ(Vector3::one * 0.4f).multiply(Matrix4::translateXYZ(position)));
+			}
+		}
+	}
+
+	void onUpdate() override {
+		Scene::onUpdate();
+	}
+	void onDestroy() override {
+		Scene::onDestroy();
+	}
+
+	const uint32 meshCountX = 64;
+	const uint32 meshCountY = 64;
+	VectorArray<SingleMeshRenderInstance> _meshes;
+};
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
 	Win32Application app;
 	app.init(hInstance, nCmdShow);
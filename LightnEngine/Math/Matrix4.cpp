@@ -160,7 +160,7 @@ Matrix4 Matrix4::inverse(const Matrix4 & m) {
 	float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
 
 	if (det == 0.0f) {
-		return m; // ts񂪑݂ȂI
+		return m; // 逆行列が存在しない！
 	}
 
 	float invDet = 1.0f / det;
@@ -242,7 +242,7 @@ Quaternion Matrix4::rotation() const {
 
 	Quaternion result;
 
-	// ő听
+	// 最大成分を検索
 	float elem[4]; // 0:x, 1:y, 2:z, 3:w
 	elem[0] = m[0][0] - m[1][1] - m[2][2] + 1.0f;
 	elem[1] = -m[0][0] + m[1][1] - m[2][2] + 1.0f;
@@ -256,10 +256,10 @@ Quaternion Matrix4::rotation() const {
 	}
 
 	if (elem[biggestIndex] < 0.0f) {
-		return result; // ̍sɊԈႢI
+		return result; // 引数の行列に間違いあり！
 	}
 
-	// ővf̒lZo
+	// 最大要素の値を算出
 	float *q[4] = { &result.x, &result.y, &result.z, &result.w };
 	float v = sqrtf(elem[biggestIndex]) * 0.5f;
 	*q[biggestIndex] = v;
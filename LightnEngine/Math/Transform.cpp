@@ -10,11 +10,11 @@ Matrix4 TransformQ::toMatrix4() const {
 }
 
 Vector3 TransformQ::InvTransformPosition(const Vector3 & pos) {
-	// ʒul
+	// 位置を考慮
 	const Vector3 transrated = pos - position;
-	// l
+	// 向きを考慮
 	const Vector3 rotated = Quaternion::rotVector(rotation.inverse(), transrated);
-	// XP[l
+	// スケールを考慮
 	return rotated * scale.safeReciprocal();
 }
 
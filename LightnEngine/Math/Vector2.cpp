@@ -60,13 +60,13 @@ float Vector2::angle(Vector2 v) const {
 	return angle(*this, v);
 }
 
-float Vector2::angle(Vector2 v1, Vector2 v2) {	//xNgAB̒vZ
+float Vector2::angle(Vector2 v1, Vector2 v2) {	//ベクトルAとBの長さを計算する
 	float length_A = length(v1);
 	float length_B = length(v2);
 
-	//ςƃxNggcosƂ߂
+	//内積とベクトル長さを使ってcosθを求める
 	float cos_sita = dot(v1, v2) / (length_A * length_B);
-	//cosƂƂ߂
+	//cosθからθを求める
 	float sita = acos(cos_sita);
 
 	return sita;
@@ -12,7 +12,7 @@ constexpr float M_1DIV2PI = 0.159154943f;
 constexpr float M_PIDIV2 = 1.570796327f;
 constexpr float M_PIDIV4 = 0.785398163f;
 
-//x烉WAɕϊ
+//度数からラジアンに変換
 constexpr inline float radianFromDegree(const float degree) {
 	return degree * (M_PI / 180.0f);
 }
@@ -37,12 +37,12 @@ constexpr float gravity = 9.80665f; // m/ss
 
 template <class T, class... Args>
 constexpr T cmax(const T& head, const Args&... args) {
-	// 킩₷ ėpɌ(int , float)̂悤ȃp^[ɑΉłȂB
+	// わかりやすいが 汎用性に欠ける(int , float)のようなパターンに対応できない。
 	/*std::initializer_list<int> list = { args... };
 	auto&& m = *std::max_element(list.begin(), list.end());
 	return head > m ? head : m;*/
 	T result = head;
-	using swallow = std::initializer_list<T>;	//kLXgɉ
+	using swallow = std::initializer_list<T>;	//縮小キャストを強引に回避
 	(void)swallow {
 		(void(result = result > args ? result : args), T())...
 	};
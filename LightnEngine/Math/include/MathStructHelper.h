@@ -2,8 +2,8 @@
 
 //#include <array>
 
-// MathClass._array ̌^
-// TODO g add ̊֐pӂ΃Iy[^̂قƂǂ܂Ƃ߂B@A߂ǂۗB
+// MathClass._array の型
+// TODO これを使って add 等の関数を用意すればオペレータのほとんどがまとめられる。　が、めんどくさいから保留。
 template<size_t size, class T = float>
 using MathUnionArray = T[size];
-//using MathUnionArray = std::array<float, size>; // TODO array ̊֐ constexprɑΉĂȂ̂ c++17 ňڍs
\ No newline at end of file
+//using MathUnionArray = std::array<float, size>; // TODO array の関数が constexprに対応していないので c++17 で移行
\ No newline at end of file
@@ -24,61 +24,61 @@ struct Matrix4 {
 			{ m31, m32, m33, m34},
 			{ m41, m42, m43, m44 } } {}
 
-	//]l]s쐬
+	//回転値から回転行列を作成
 	static Matrix4 rotateX(float pitch);
 	static Matrix4 rotateY(float yaw);
 	static Matrix4 rotateZ(float roll);
 	static Matrix4 rotateXYZ(float pitch, float yaw, float roll);
 	static Matrix4 rotateAxis(const Vector3& axis);
 
-	//XYZgks𐶐
+	//XYZから拡大縮小行列を生成
 	static Matrix4 scaleXYZ(float x, float y, float z);
 	static Matrix4 scaleXYZ(const Vector3& v);
 
-	//XYZ畽sړs𐶐
+	//XYZから平行移動行列を生成
 	static Matrix4 translateXYZ(float x, float y, float z);
 	static Matrix4 translateXYZ(const Vector3& v);
 
-	//s̏Z
+	//行列の乗算
 	static Matrix4 multiply(const Matrix4& m1, const Matrix4& m2);
 	Matrix4 multiply(const Matrix4& m2) const;
 
-	//xNgƍs̏Z
+	//ベクトルと行列の乗算
 	static Vector3 transform(const Vector3& v, const Matrix4& m);
 
-	//]us
+	//転置行列
 	static Matrix4 transpose(const Matrix4& m);
 	Matrix4 transpose() const;
 
-	//ts
+	//逆行列
 	static Matrix4 inverse(const Matrix4& m);
 
-	//Wnˉeϊs𐶐
+	//左手座標系射影変換行列を生成
 	static Matrix4 perspectiveFovLH(float FovAngleY, float AspectHByW, float NearZ, float FarZ);
 
-	//蕽teˉeԊҍs𐶐
+	//左手平衡投影射影返還行列を生成
 	static Matrix4 orthographicProjectionLH(float width, float height, float nearZ, float farZ, float farOffset = 0.0f);
 
-	//sړs擾
+	//平行移動行列を取得
 	Vector3 translate() const;
 
-	//NH[^jI擾
+	//クォータニオンを取得
 	Quaternion rotation() const;
 
-	//gkl擾
+	//拡大縮小値を取得
 	Vector3 scale() const;
 
-	//ts
+	//逆行列
 	Matrix4 inverse() const;
 
-	//[hs񂩂烏[hW擾
+	//ワールド行列からワールド座標を取得
 	Vector3 positionFromWorld() const;
 	Vector3 scaleFromWorld() const;
 
-	//NH[^jI]s𐶐
+	//クォータニオンから回転行列を生成
 	static Matrix4 matrixFromQuaternion(const Quaternion& q);
 
-	//ʒuA]A傫烏[hs쐬
+	//位置、回転、大きさからワールド行列を作成
 	static Matrix4 createWorldMatrix(const Vector3& position, const Quaternion& rotation, const Vector3& scale);
 
 	const float* operator[](const size_t i) const;
@@ -98,15 +98,15 @@ struct Matrix4 {
 	Matrix4 operator * (float s) const;
 	Matrix4 operator / (float s) const;
 
-	//Pʍs
+	//単位行列
 	static const Matrix4 identity;
-	//foCXKWnTexCoordsɕϊs
+	//デバイス正規化座標系からTexCoordsに変換する行列
 	static const Matrix4 textureBias;
 	union
 	{
-		float m[4][4];	// 4x4 }gbNX
-		Vector4 mv[4];	// Vector4 z
-		MathUnionArray<16> _array;	// z
+		float m[4][4];	// 4x4 マトリックス
+		Vector4 mv[4];	// Vector4 配列
+		MathUnionArray<16> _array;	// 配列
 	};
 };
 
@@ -13,34 +13,34 @@ struct Quaternion {
 	constexpr Quaternion(float x, float y, float z, float w) : x{ x }, y{ y }, z{ z }, w{ w }{
 	}
 
-	Quaternion(const Vector3& axis, float angle); // qŊȂ̂łƂ肠 constexpr
+	Quaternion(const Vector3& axis, float angle); // 初期化が初期化子で完結しないのでとりあえず 非constexpr
 
-	//NH[^jIm̓
+	//クォータニオン同士の内積
 	static float dot(const Quaternion& q1, const Quaternion& q2);
 
-	//NH[^jIʐ`⊮
+	//クォータニオンを球面線形補完する
 	static Quaternion slerp(const Quaternion q1, const Quaternion& q2, float t, bool nearRoute = true);
 
-	//IC[pNH[^jI𐶐
+	//オイラー角からクォータニオンを生成
 	static Quaternion euler(const Vector3& euler, bool valueIsRadian = false);
 	static Quaternion euler(float pitch, float yaw, float roll, bool valueIsRadian = false);
 
-	//xNgNH[^jIŉ]
+	//ベクトルをクォータニオンで回転
 	static Vector3 rotVector(const Quaternion& q, const Vector3& v);
 
-	//direction]쐬	TODO  inverse gĂ镔CKv
+	//directionを向く回転を作成	TODO 内部で inverse を使ってる部分を修正する必要あり
 	static Quaternion lookRotation(const Vector3& direction, const Vector3& up = Vector3::up);
 
-	//tNH[^jI
+	//逆クォータニオン
 	Quaternion inverse() const;
 
-	//NH[^jI
+	//共役クォータニオン
 	Quaternion conjugate() const;
 
-	//IC[px擾
+	//オイラー角度を取得
 	Vector3 toEulerAngle() const;
 
-	//߂l̓WA
+	//戻り値はラジアン
 	float getRoll(bool reprojectAxis = true) const;
 	float getPitch(bool reprojectAxis = true) const;
 	float getYaw(bool reprojectAxis = true) const;
@@ -19,7 +19,7 @@ struct TransformQ {
 
 	constexpr TransformQ() :position{ 0.0f,0.0f,0.0f }, rotation{ Quaternion::identity }, scale{ 1.0f,1.0f,1.0f }{}
 	constexpr TransformQ(const Vector3& position, const Quaternion& rotation, const Vector3& scale) :position{ position }, rotation{ rotation }, scale{ scale }{}
-	TransformQ(const Matrix4 matrix); // constexpr֐ĂԕKv̂łƂ肠 constexpr
+	TransformQ(const Matrix4 matrix); // 非constexpr関数を呼ぶ必要があるのでとりあえず 非constexpr
 	Matrix4 toMatrix4() const;
 
 	Vector3 InvTransformPosition(const Vector3& pos);
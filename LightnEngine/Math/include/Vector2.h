@@ -50,7 +50,7 @@ struct Vector2 {
 
 	bool operator ==(const Vector2& v2) const;
 
-	//萔
+	//定数
 	static const Vector2 zero;
 	static const Vector2 one;
 	static const Vector2 right;
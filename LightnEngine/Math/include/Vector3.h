@@ -4,7 +4,7 @@
 #include "Vector2.h"
 #include <string>
 
-//3xNgNX
+//3次元ベクトルクラス
 struct Vector3 {
 
 	constexpr Vector3() :x{ 0.0f }, y{ 0.0f }, z{ 0.0f }{
@@ -16,43 +16,43 @@ struct Vector3 {
 	/*explicit Vector3(const float xyz) :x{ xyz }, y{ xyz }, z{ xyz }{
 	}*/
 
-	//O
+	//外積
 	static Vector3 cross(const Vector3& v1, const Vector3& v2);
 
-	//
+	//内積
 	static float dot(const Vector3& v1, const Vector3& v2);
 	float dot(const Vector3& v) const;
 
 	Vector3 reciprocal() const;
 	Vector3 safeReciprocal() const;
 
-	//
+	//長さ
 	static float length(const Vector3& v);
 	float length() const;
-	//̓
+	//長さの二乗
 	static float sqrLength(const Vector3& v);
 	float sqrLength() const;
 
-	//_Ԃ̋
+	//二点間の距離
 	static float distance(const Vector3& v1, const Vector3& v2);
 	float distance(const Vector3& other) const;
-	//_Ԃ̋̓
+	//二点間の距離の二乗
 	static float sqrDistance(const Vector3& v1, const Vector3& v2);
 	float sqrDistance(const Vector3& other) const;
 
-	//PʃxNg
+	//単位ベクトル化
 	static Vector3 normalize(const Vector3& v);
 	Vector3 normalize() const;
 
-	//̊pxvZ
+	//二つの角度差を計算
 	static float Angle(const Vector3& v1, const Vector3& v2);
 	float angle(const Vector3& v) const;
 
-	//̃xNǧ
+	//二つのベクトルの向きが等しいか
 	static float EqualRotator(const Vector3& v1, const Vector3& v2);
 	float equalRotation(const Vector3& v) const;
 
-	//`⊮
+	//線形補完
 	static Vector3 lerp(const Vector3& start, const Vector3& end, float t);
 	Vector3 lerp(const Vector3& target, float t) const;
 
@@ -65,11 +65,11 @@ struct Vector3 {
 
 	std::string toString() const;
 
-	// YZq
+	// 添字演算子
 	float operator [] (std::size_t index) const;
 	float & operator [] (std::size_t index);
 
-	//萔
+	//定数
 	static const Vector3 up;
 	static const Vector3 right;
 	static const Vector3 forward;
@@ -87,18 +87,18 @@ struct Vector3 {
 	};
 };
 
-// PZqI[o[[h
+// 単項演算子オーバーロード
 Vector3 operator + (const Vector3& v);
 Vector3 operator - (const Vector3& v);
 
-// ZqI[o[[h
+// 代入演算子オーバーロード
 Vector3& operator += (Vector3& v1, const Vector3& v2);
 Vector3& operator -= (Vector3& v1, const Vector3& v2);
 Vector3& operator *= (Vector3& v, const Vector3& v2);
 Vector3& operator *= (Vector3& v, float s);
 Vector3& operator /= (Vector3& v, float s);
 
-// QZqI[o[[h
+// ２項演算子オーバーロード
 Vector3 operator + (const Vector3& v1, const Vector3& v2);
 Vector3 operator - (const Vector3& v1, const Vector3& v2);
 Vector3 operator * (const Vector3& v1, const Vector3& v2);
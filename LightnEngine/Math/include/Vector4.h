@@ -23,7 +23,7 @@ public:
 
 	constexpr bool operator == (const Vector4& v) const { return x == v.x&&y == v.y&&z == v.z&&w == v.w; }
 
-	// PZ
+	// 単項演算
 	constexpr Vector4 operator + () const {
 		return *this;
 	}
@@ -31,7 +31,7 @@ public:
 		return	Vector4(-x, -y, -z, -w);
 	}
 
-	// Z
+	// 代入演算
 	constexpr Vector4& operator += (float s) {
 		for (auto& i : _array) { i += s; }
 		return *this;
@@ -73,7 +73,7 @@ public:
 		return *this;
 	}
 
-	//`⊮
+	//線形補完
 	static Vector4 lerp(const Vector4& start, const Vector4& end, float t) {
 		t = clamp(t, 0.0f, 1.0f);
 
@@ -84,7 +84,7 @@ public:
 		return Vector4::lerp(*this, target, t);
 	}
 
-	// 񍀉ZivZj
+	// 二項演算（計算）
 	constexpr Vector4 operator + (const float s) const {
 		return Vector4(*this) += s;
 	}
@@ -119,7 +119,7 @@ public:
 			float z;
 			float w;
 		};
-		MathUnionArray<4> _array; //std::arrayconstexpr gȂ̂
+		MathUnionArray<4> _array; //std::arrayだとconstexpr が使えなかったので
 	};
 };
 
@@ -94,7 +94,7 @@ struct Block {
 		}
 	}
 
-	//̃ubNƏI[^OɃTCY
+	//このブロックと終端タグにサイズ数を書き込み
 	void setSize(uint32 size) {
 		this->size = size;
 		uint32* endHeaderPtr = (uint32*)((byte*)this + (sizeof(Block) + sizeof(uint32))*size);
@@ -145,27 +145,27 @@ public:
 		//uint32 divideIndex = fastLog2(divideBit);
 		//DEBUG_PRINT(std::bitset<8>(divideBit) << " Index:" << divideIndex);
 
-		//vTCYȉ̃rbgɃ}XN
+		//要求サイズ以下のビットにマスクをかける
 		uint32 mask = ~(fillRightBit(divideBit) >> 1);
 		uint32 freeBit = freeListFlags & mask;
 
-		//vTCYȏňԏt[ubNCfbNX߂
+		//要求サイズ以上で一番小さいフリーブロックインデックスを求める
 		uint32 targetBit = lowerBit(freeBit);
 		uint32 targetIndex = fastLog2(targetBit);
 
-		//vubNt[ubNCfbNX烁Ȃ
+		//要求ブロック数よりフリーブロックインデックスが小さかったらメモリが足りない
 		assert(divideBit <= targetBit && "No Memory");
 
 		Block* currentBlock = freeList[targetIndex];
 		removeFreeList(currentBlock);
 
-		//TCỸubNꍇ
+		//同じサイズのブロックだった場合
 		if (currentBlock->size == blockNum) {
 			currentBlock->enable = true;
 			return dataPtr + blockLocalIndex(currentBlock) * BLOCK_DATA_SIZE;
 		}
 
-		//ubNvTCYɕĕԋp
+		//ブロックを要求サイズに分割して返却
 		currentBlock->setSize(currentBlock->size - blockNum);
 
 		byte* newBlockPtr = (byte*)currentBlock + currentBlock->size*BLOCK_AND_HEADER_SIZE;
@@ -173,37 +173,37 @@ public:
 		newBlock->setSize(blockNum);
 		newBlock->enable = true;
 
-		//OubNēo^
+		//分割前ブロックを再登録
 		registFreeList(currentBlock);
 		debugAddActiveList(newBlock);
 
-		//ubNCfbNXf[^|C^ZoĕԂ
+		//ブロックインデックスからデータポインタを算出して返す
 		return dataPtr + blockLocalIndex(newBlock) * BLOCK_DATA_SIZE;
 	}
 
 	void releaseMemory(void* dataPtr) {
-		//f[^|C^̃[JItZbgvZăubN|C^߂
+		//データポインタのローカルオフセットを計算してブロックポインタを求める
 		ulong2 blockIndex = dataLocalIndex(dataPtr);
 		Block* block = (Block*)(blockPtr + blockIndex * BLOCK_AND_HEADER_SIZE);
 
-		//O㍶ẼubN|C^
+		//前後左右のブロックポインタ
 		uint32* prevBlockSize = (uint32*)((byte*)block - sizeof(uint32));
 		Block* prevBlock = (Block*)((byte*)block - *prevBlockSize*BLOCK_AND_HEADER_SIZE);
 		Block* nextBlock = (Block*)((byte*)block + block->size*BLOCK_AND_HEADER_SIZE);
 
-		//ẑOԖڂȂÕubN݂͑Ȃ
+		//配列の０番目なら前のブロックは存在しない
 		if (blockIndex == 0) {
 			prevBlock = nullptr;
 		}
 
-		//z̍ŌȂ玟̃ubN݂͑Ȃ
+		//配列の最後なら次のブロックは存在しない
 		if (blockIndex == (allocateBlockSize / BLOCK_AND_HEADER_SIZE - block->size)) {
 			nextBlock = nullptr;
 		}
 
 		debugRemoveActiveList(block);
 
-		//O}[W
+		//前マージ
 		if (prevBlock != nullptr) {
 			if (!prevBlock->enable) {
 				removeFreeList(prevBlock);
@@ -214,7 +214,7 @@ public:
 			}
 		}
 
-		//}[W
+		//後マージ
 		if (nextBlock != nullptr) {
 			if (!nextBlock->enable) {
 				removeFreeList(nextBlock);
@@ -223,7 +223,7 @@ public:
 			}
 		}
 
-		//t[Xgɓo^
+		//フリーリストに登録
 		block->enable = false;
 		registFreeList(block);
 	}
@@ -270,24 +270,24 @@ public:
 		}
 	}
 
-	//f[^|C^ubNwb_[擾
+	//データポインタからブロックヘッダーを取得する
 	inline Block* getBlockFromDataPtr(void* dataPtr) {
 		return (Block*)(blockPtr + dataLocalIndex(dataPtr) * BLOCK_AND_HEADER_SIZE);
 	}
 
-	//basePtrJnƂf[^{̂̃[J|C^Ԃ
+	//basePtrを開始としたデータ本体のローカルポインタを返す
 	inline ulong2 dataLocalIndex(void* blockPtr) {
 		ulong2 localPtr = reinterpret_cast<ulong2>(blockPtr) - reinterpret_cast<ulong2>(dataPtr);
 		return localPtr / BLOCK_DATA_SIZE;
 	}
 
-	//basePtrJnƂubÑ[J|C^Ԃ
+	//basePtrを開始としたブロックのローカルポインタを返す
 	inline ulong2 blockLocalIndex(void* blockPtr) {
 		ulong2 localPtr = reinterpret_cast<ulong2>(blockPtr) - reinterpret_cast<ulong2>(this->blockPtr);
 		return localPtr / BLOCK_AND_HEADER_SIZE;
 	}
 
-	//ubN[JCfbNXAP[^[̃f[^|C^߂
+	//ブロックローカルインデックスからアロケーターのデータポインタを求める
 	void* getDataPtrFromBlockLocation(ulong2 blockLocation) {
 		ulong2 localPtr = blockLocation * BLOCK_DATA_SIZE;
 		return dataPtr + localPtr;
@@ -295,7 +295,7 @@ public:
 
 	template<typename T>
 	T* allocateMemory() {
-		return (T*)allocateMemory(sizeof(T));//RXgN^̌Ăяo͕ʓrKvI
+		return (T*)allocateMemory(sizeof(T));//コンストラクタの呼び出しは別途必要！
 	}
 
 	void* allocateMemory(uint32 size) {
@@ -40,7 +40,7 @@ public:
 	}
 
 	byte* divideMemory(size_t size) {
-		assert(offset + size <= mainMemorySize && "ȏチmۏo܂");
+		assert(offset + size <= mainMemorySize && "これ以上メモリを確保出来ません");
 		byte * mem = reinterpret_cast<byte*>(mainMemory + offset);
 		offset += size;
 		DEBUG_PRINT("Divide Ptr: " << offset << " Size: " << size);
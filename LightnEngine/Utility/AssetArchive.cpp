@@ -0,0 +1,360 @@
+#include "include/AssetArchive.h"
+#include "include/Lz4Codec.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+//圧縮しても元の大きさのこの割合より縮まないエントリーは、展開の手間を省くため圧縮せずに置く
+constexpr uint64 ASSET_ARCHIVE_MIN_SAVING_DIVISOR = 8;
+
+//64ビットのFNV-1a
+static uint64 computeHash(const void* data, uint64 size) {
+	const byte* bytes = reinterpret_cast<const byte*>(data);
+	uint64 hash = 14695981039346656037ull;
+	for (uint64 i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+//存在して中身が空のファイルか
+static bool isEmptyFile(const String& filePath) {
+	std::ifstream fin(filePath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	return fin && fin.tellg() == 0;
+}
+
+static uint64 alignOffset(uint64 offset) {
+	return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~static_cast<uint64>(ASSET_ARCHIVE_ALIGNMENT - 1);
+}
+
+AssetArchive::AssetArchive() :_header(nullptr), _entries(nullptr), _pathTable(nullptr) {
+}
+
+bool AssetArchive::open(const char* filePath) {
+	close();
+	if (!_file.open(filePath) || _file.size() < sizeof(AssetArchiveHeader)) {
+		_file.close();
+		return false;
+	}
+
+	const byte* data = _file.data();
+	const uint64 fileSize = _file.size();
+	const AssetArchiveHeader* header = reinterpret_cast<const AssetArchiveHeader*>(data);
+	const bool isValidHeader = header->magic == ASSET_ARCHIVE_MAGIC && header->version == ASSET_ARCHIVE_VERSION
+		&& header->alignment == ASSET_ARCHIVE_ALIGNMENT && header->fileSize == fileSize
+		&& header->indexOffset <= fileSize && header->entryCount <= (fileSize - header->indexOffset) / sizeof(AssetArchiveEntry)
+		&& header->pathTableOffset <= fileSize && header->pathTableSize <= fileSize - header->pathTableOffset;
+	if (!isValidHeader) {
+		_file.close();
+		return false;
+	}
+
+	//エントリーがファイルとパスの範囲に収まり、索引がハッシュの順に並んでいるか
+	//展開後の大きさはそのまま確保に使うので、圧縮データから展開できる大きさを越えていないかも見る
+	const AssetArchiveEntry* entries = reinterpret_cast<const AssetArchiveEntry*>(data + header->indexOffset);
+	for (uint32 i = 0; i < header->entryCount; ++i) {
+		const AssetArchiveEntry& entry = entries[i];
+		const bool isValidEntry = entry.offset <= fileSize && entry.storedSize <= fileSize - entry.offset
+			&& static_cast<uint64>(entry.pathOffset) + entry.pathLength <= header->pathTableSize
+			&& entry.compression < ASSET_ARCHIVE_COMPRESSION_COUNT
+			&& (entry.compression != ASSET_ARCHIVE_COMPRESSION_NONE || entry.storedSize == entry.size)
+			&& (entry.compression != ASSET_ARCHIVE_COMPRESSION_LZ4 || entry.size <= Lz4Codec::getDecompressBound(entry.storedSize))
+			&& (i == 0 || entries[i - 1].pathHash <= entry.pathHash);
+		if (!isValidEntry) {
+			_file.close();
+			return false;
+		}
+	}
+
+	_header = header;
+	_entries = entries;
+	_pathTable = reinterpret_cast<const char*>(data + header->pathTableOffset);
+	_filePath = filePath;
+	return true;
+}
+
+void AssetArchive::close() {
+	_file.close();
+	_header = nullptr;
+	_entries = nullptr;
+	_pathTable = nullptr;
+	_filePath.clear();
+}
+
+const AssetArchiveEntry* AssetArchive::findEntry(const char* path) const {
+	if (!isOpen()) {
+		return nullptr;
+	}
+
+	const String normalizedPath = normalizePath(path);
+	const uint64 pathHash = computePathHash(normalizedPath);
+	const AssetArchiveEntry* end = _entries + _header->entryCount;
+	const AssetArchiveEntry* entry = std::lower_bound(_entries, end, pathHash, [](const AssetArchiveEntry& e, uint64 hash) {
+		return e.pathHash < hash;
+	});
+
+	//ハッシュが同じエントリーはパスを照合する
+	for (; entry != end && entry->pathHash == pathHash; ++entry) {
+		if (entry->pathLength == normalizedPath.size() && memcmp(_pathTable + entry->pathOffset, normalizedPath.data(), entry->pathLength) == 0) {
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool AssetArchive::verifyHashes() const {
+	VectorArray<byte> data;
+	for (uint32 i = 0; i < getEntryCount(); ++i) {
+		const AssetArchiveEntry& entry = _entries[i];
+		if (entry.compression == ASSET_ARCHIVE_COMPRESSION_NONE) {
+			if (computeHash(getStoredData(entry), entry.size) != entry.contentHash) {
+				return false;
+			}
+			continue;
+		}
+
+		if (!readEntry(entry, data) || computeHash(data.data(), data.size()) != entry.contentHash) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+String AssetArchive::getEntryPath(const AssetArchiveEntry& entry) const {
+	return String(_pathTable + entry.pathOffset, entry.pathLength);
+}
+
+bool AssetArchive::readEntry(const AssetArchiveEntry& entry, VectorArray<byte>& outData) const {
+	outData.resize(static_cast<size_t>(entry.size));
+	const byte* storedData = getStoredData(entry);
+	switch (entry.compression) {
+	case ASSET_ARCHIVE_COMPRESSION_NONE:
+		memcpy(outData.data(), storedData, static_cast<size_t>(entry.size));
+		return true;
+	case ASSET_ARCHIVE_COMPRESSION_LZ4:
+		return Lz4Codec::decompress(storedData, entry.storedSize, outData.data(), entry.size);
+	}
+
+	return false;
+}
+
+void AssetArchive::prefetch(const AssetArchiveEntry& entry, uint64 offset, uint64 size) const {
+	if (offset >= entry.storedSize) {
+		return;
+	}
+
+	_file.prefetch(entry.offset + offset, std::min(size, entry.storedSize - offset));
+}
+
+String AssetArchive::normalizePath(const char* path) {
+	String normalizedPath(path);
+	for (auto& c : normalizedPath) {
+		if (c == '\\') {
+			c = '/';
+		}
+		else if (c >= 'A' && c <= 'Z') {
+			c = static_cast<char>(c - 'A' + 'a');
+		}
+	}
+
+	size_t start = 0;
+	while (start < normalizedPath.size()) {
+		if (normalizedPath[start] == '/') {
+			++start;
+		}
+		else if (normalizedPath.compare(start, 2, "./") == 0) {
+			start += 2;
+		}
+		else {
+			break;
+		}
+	}
+
+	return normalizedPath.substr(start);
+}
+
+uint64 AssetArchive::computePathHash(const String& normalizedPath) {
+	return computeHash(normalizedPath.data(), normalizedPath.size());
+}
+
+void AssetArchiveWriter::addFile(const String& archivePath, const String& sourcePath, bool isCompressed) {
+	_files.push_back({ archivePath, sourcePath, isCompressed });
+}
+
+bool AssetArchiveWriter::write(const char* filePath, ThreadPool* threadPool, AssetArchiveWriteStatistics& outStatistics, String& outLog) const {
+	outStatistics = AssetArchiveWriteStatistics();
+	const uint32 fileCount = static_cast<uint32>(_files.size());
+
+	struct PackedFile {
+		String path;
+		uint64 pathHash = 0;
+		uint64 size = 0;
+		uint64 contentHash = 0;
+		bool isLoaded = false;
+
+		//圧縮して縮んだときだけ持つ。空なら元のファイルをそのまま置く
+		VectorArray<byte> compressedData;
+	};
+
+	//ファイルごとのハッシュの計算と圧縮は互いに独立なので並列に行う
+	VectorArray<PackedFile> packedFiles(fileCount);
+	auto loadFile = [&](uint32 i) {
+		PackedFile& packedFile = packedFiles[i];
+		packedFile.path = AssetArchive::normalizePath(_files[i].archivePath.c_str());
+		packedFile.pathHash = AssetArchive::computePathHash(packedFile.path);
+
+		//空のファイルはマップできないので、開けなかったときは空かどうかを確かめて空のエントリーとして置く
+		MappedFile file;
+		if (!file.open(_files[i].sourcePath.c_str())) {
+			packedFile.isLoaded = isEmptyFile(_files[i].sourcePath);
+			packedFile.contentHash = computeHash(nullptr, 0);
+			return;
+		}
+
+		packedFile.size = file.size();
+		packedFile.contentHash = computeHash(file.data(), file.size());
+		packedFile.isLoaded = true;
+		if (!_files[i].isCompressed) {
+			return;
+		}
+
+		packedFile.compressedData.resize(static_cast<size_t>(Lz4Codec::getCompressBound(file.size())));
+		const uint64 compressedSize = Lz4Codec::compress(file.data(), file.size(), packedFile.compressedData.data(), packedFile.compressedData.size());
+		if (compressedSize == 0 || compressedSize > file.size() - file.size() / ASSET_ARCHIVE_MIN_SAVING_DIVISOR) {
+			VectorArray<byte>().swap(packedFile.compressedData);
+			return;
+		}
+
+		packedFile.compressedData.resize(static_cast<size_t>(compressedSize));
+		packedFile.compressedData.shrink_to_fit();
+	};
+
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(fileCount, loadFile);
+	}
+	else {
+		for (uint32 i = 0; i < fileCount; ++i) {
+			loadFile(i);
+		}
+	}
+
+	bool isSucceeded = true;
+	for (uint32 i = 0; i < fileCount; ++i) {
+		if (!packedFiles[i].isLoaded) {
+			outLog += "Failed (read): " + _files[i].sourcePath + "\n";
+			isSucceeded = false;
+		}
+	}
+
+	//索引はパスのハッシュの順に並べる。同じハッシュは同じパスか衝突なので、どちらも書き出さない
+	VectorArray<uint32> order(fileCount);
+	for (uint32 i = 0; i < fileCount; ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) {
+		return packedFiles[a].pathHash != packedFiles[b].pathHash ? packedFiles[a].pathHash < packedFiles[b].pathHash : a < b;
+	});
+
+	for (uint32 i = 1; i < fileCount; ++i) {
+		const PackedFile& previous = packedFiles[order[i - 1]];
+		const PackedFile& current = packedFiles[order[i]];
+		if (previous.pathHash == current.pathHash) {
+			outLog += (previous.path == current.path ? "Duplicate: " : "Hash collision: ") + previous.path + " " + current.path + "\n";
+			isSucceeded = false;
+		}
+	}
+
+	if (!isSucceeded) {
+		return false;
+	}
+
+	//ヘッダー、索引、パスを先頭にまとめ、本体はページ境界から並べる
+	AssetArchiveHeader header = {};
+	header.magic = ASSET_ARCHIVE_MAGIC;
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.entryCount = fileCount;
+	header.alignment = ASSET_ARCHIVE_ALIGNMENT;
+	header.indexOffset = sizeof(AssetArchiveHeader);
+	header.pathTableOffset = header.indexOffset + sizeof(AssetArchiveEntry) * fileCount;
+
+	String pathTable;
+	VectorArray<AssetArchiveEntry> entries(fileCount);
+	for (uint32 i = 0; i < fileCount; ++i) {
+		const PackedFile& packedFile = packedFiles[order[i]];
+		AssetArchiveEntry& entry = entries[i];
+		entry.pathHash = packedFile.pathHash;
+		entry.size = packedFile.size;
+		entry.contentHash = packedFile.contentHash;
+		entry.pathOffset = static_cast<uint32>(pathTable.size());
+		entry.pathLength = static_cast<uint32>(packedFile.path.size());
+		entry.compression = packedFile.compressedData.empty() ? ASSET_ARCHIVE_COMPRESSION_NONE : ASSET_ARCHIVE_COMPRESSION_LZ4;
+		entry.storedSize = packedFile.compressedData.empty() ? packedFile.size : packedFile.compressedData.size();
+		pathTable += packedFile.path;
+	}
+
+	header.pathTableSize = pathTable.size();
+	uint64 offset = alignOffset(header.pathTableOffset + header.pathTableSize);
+	for (auto& entry : entries) {
+		entry.offset = offset;
+		offset = alignOffset(offset + entry.storedSize);
+	}
+	header.fileSize = fileCount > 0 ? entries.back().offset + entries.back().storedSize : header.pathTableOffset + header.pathTableSize;
+
+	std::ofstream fout(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fout) {
+		outLog += "Failed (write): " + String(filePath) + "\n";
+		return false;
+	}
+
+	const VectorArray<char> padding(ASSET_ARCHIVE_ALIGNMENT, 0);
+	uint64 writtenSize = 0;
+	auto writeData = [&](const void* data, uint64 size) {
+		fout.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+		writtenSize += size;
+	};
+
+	auto writePadding = [&](uint64 targetOffset) {
+		writeData(padding.data(), targetOffset - writtenSize);
+	};
+
+	writeData(&header, sizeof(header));
+	writeData(entries.data(), sizeof(AssetArchiveEntry) * fileCount);
+	writeData(pathTable.data(), pathTable.size());
+
+	for (uint32 i = 0; i < fileCount && fout; ++i) {
+		const PackedFile& packedFile = packedFiles[order[i]];
+		const AssetArchiveEntry& entry = entries[i];
+		writePadding(entry.offset);
+		if (!packedFile.compressedData.empty()) {
+			writeData(packedFile.compressedData.data(), entry.storedSize);
+		}
+		else if (entry.size > 0) {
+			//圧縮しないファイルは読み込み直して書く。ハッシュを取った後に書き換わっていれば失敗にする
+			MappedFile file;
+			if (!file.open(_files[order[i]].sourcePath.c_str()) || file.size() != entry.size || computeHash(file.data(), file.size()) != entry.contentHash) {
+				outLog += "Failed (changed): " + _files[order[i]].sourcePath + "\n";
+				return false;
+			}
+
+			writeData(file.data(), entry.size);
+		}
+
+		outStatistics.compressedCount += entry.compression != ASSET_ARCHIVE_COMPRESSION_NONE ? 1 : 0;
+		outStatistics.size += entry.size;
+		outStatistics.storedSize += entry.storedSize;
+	}
+
+	if (!fout) {
+		outLog += "Failed (write): " + String(filePath) + "\n";
+		return false;
+	}
+
+	outStatistics.fileCount = fileCount;
+	outStatistics.archiveSize = writtenSize;
+	return true;
+}
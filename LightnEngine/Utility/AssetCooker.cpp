@@ -0,0 +1,362 @@
+#include "include/AssetCooker.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+//キャッシュマニフェストは1行に1レコードをタブ区切りで書く
+//cache <バージョン>
+//asset <入力> <変換器> <入力のハッシュ> <設定のハッシュ>
+//output <出力> <ハッシュ>
+//depend <依存ファイル> <ハッシュ>
+//output、dependは直前のassetに属する
+static const char* ASSET_CACHE_HEADER = "cache";
+static const char* ASSET_CACHE_ASSET = "asset";
+static const char* ASSET_CACHE_OUTPUT = "output";
+static const char* ASSET_CACHE_DEPEND = "depend";
+
+static VectorArray<String> splitFields(const String& line) {
+	VectorArray<String> fields;
+	size_t begin = 0;
+	while (true) {
+		const size_t end = line.find('\t', begin);
+		fields.push_back(line.substr(begin, end == String::npos ? String::npos : end - begin));
+		if (end == String::npos) {
+			break;
+		}
+		begin = end + 1;
+	}
+
+	return fields;
+}
+
+static String formatHash(uint64 hash) {
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+	return String(text);
+}
+
+static bool parseHash(const String& text, uint64& outHash) {
+	char* end = nullptr;
+	outHash = strtoull(text.c_str(), &end, 16);
+	return !text.empty() && *end == '\0';
+}
+
+//Makefileの依存関係ではスペースと#を区切りやコメントと見なすのでエスケープする
+static String escapeMakePath(const String& path) {
+	String escaped;
+	for (char c : path) {
+		if (c == ' ' || c == '#') {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+
+	return escaped;
+}
+
+//ファイルが前回と同じ内容で残っているか
+static bool isFileUnchanged(const AssetFileHash& file) {
+	uint64 hash = 0;
+	return AssetCooker::computeFileHash(file.path, hash) && hash == file.hash;
+}
+
+bool AssetCookCache::load(const String& filePath) {
+	_entries.clear();
+
+	std::ifstream fin(filePath.c_str());
+	if (!fin) {
+		return true;
+	}
+
+	//書式が違うキャッシュは捨てて、すべて変換し直す
+	std::string line;
+	if (!std::getline(fin, line)) {
+		return true;
+	}
+
+	const VectorArray<String> header = splitFields(String(line.c_str()));
+	if (header.size() != 2 || header[0] != ASSET_CACHE_HEADER || strtoul(header[1].c_str(), nullptr, 10) != ASSET_CACHE_VERSION) {
+		return true;
+	}
+
+	AssetCacheEntry* entry = nullptr;
+	while (std::getline(fin, line)) {
+		if (line.empty()) {
+			continue;
+		}
+
+		const VectorArray<String> fields = splitFields(String(line.c_str()));
+		bool isValid = false;
+		if (fields[0] == ASSET_CACHE_ASSET && fields.size() == 5) {
+			_entries.emplace_back(fields[1], AssetCacheEntry());
+			entry = &_entries.back().second;
+			entry->converterName = fields[2];
+			isValid = parseHash(fields[3], entry->inputHash) && parseHash(fields[4], entry->settingsHash);
+		}
+		else if ((fields[0] == ASSET_CACHE_OUTPUT || fields[0] == ASSET_CACHE_DEPEND) && fields.size() == 3 && entry != nullptr) {
+			AssetFileHash file = { fields[1], 0 };
+			isValid = parseHash(fields[2], file.hash);
+			(fields[0] == ASSET_CACHE_OUTPUT ? entry->outputs : entry->dependencies).push_back(file);
+		}
+
+		if (!isValid) {
+			_entries.clear();
+			return false;
+		}
+	}
+
+	std::sort(_entries.begin(), _entries.end(), [](const std::pair<String, AssetCacheEntry>& a, const std::pair<String, AssetCacheEntry>& b) { return a.first < b.first; });
+	return true;
+}
+
+bool AssetCookCache::save(const String& filePath) const {
+	std::ofstream fout(filePath.c_str(), std::ios::out | std::ios::trunc);
+	fout << ASSET_CACHE_HEADER << '\t' << ASSET_CACHE_VERSION << '\n';
+	for (const auto& entry : _entries) {
+		const AssetCacheEntry& asset = entry.second;
+		fout << ASSET_CACHE_ASSET << '\t' << entry.first.c_str() << '\t' << asset.converterName.c_str() << '\t'
+			<< formatHash(asset.inputHash).c_str() << '\t' << formatHash(asset.settingsHash).c_str() << '\n';
+
+		for (const auto& output : asset.outputs) {
+			fout << ASSET_CACHE_OUTPUT << '\t' << output.path.c_str() << '\t' << formatHash(output.hash).c_str() << '\n';
+		}
+
+		for (const auto& dependency : asset.dependencies) {
+			fout << ASSET_CACHE_DEPEND << '\t' << dependency.path.c_str() << '\t' << formatHash(dependency.hash).c_str() << '\n';
+		}
+	}
+
+	return static_cast<bool>(fout);
+}
+
+bool AssetCookCache::isUpToDate(const String& inputPath, const char* converterName, uint64 inputHash, uint64 settingsHash) const {
+	const AssetCacheEntry* entry = findEntry(inputPath);
+	if (entry == nullptr || entry->converterName != converterName || entry->inputHash != inputHash || entry->settingsHash != settingsHash) {
+		return false;
+	}
+
+	//出力を消されたり書き換えられたりしていれば作り直す
+	return std::all_of(entry->outputs.begin(), entry->outputs.end(), isFileUnchanged)
+		&& std::all_of(entry->dependencies.begin(), entry->dependencies.end(), isFileUnchanged);
+}
+
+const AssetCacheEntry* AssetCookCache::findEntry(const String& inputPath) const {
+	auto itr = std::lower_bound(_entries.begin(), _entries.end(), inputPath, [](const std::pair<String, AssetCacheEntry>& entry, const String& path) { return entry.first < path; });
+	return itr != _entries.end() && itr->first == inputPath ? &itr->second : nullptr;
+}
+
+void AssetCookCache::setEntry(const String& inputPath, const AssetCacheEntry& entry) {
+	auto itr = std::lower_bound(_entries.begin(), _entries.end(), inputPath, [](const std::pair<String, AssetCacheEntry>& entry, const String& path) { return entry.first < path; });
+	if (itr != _entries.end() && itr->first == inputPath) {
+		itr->second = entry;
+		return;
+	}
+
+	_entries.emplace(itr, inputPath, entry);
+}
+
+void AssetCookCache::removeEntry(const String& inputPath) {
+	auto itr = std::lower_bound(_entries.begin(), _entries.end(), inputPath, [](const std::pair<String, AssetCacheEntry>& entry, const String& path) { return entry.first < path; });
+	if (itr != _entries.end() && itr->first == inputPath) {
+		_entries.erase(itr);
+	}
+}
+
+bool AssetCookCache::saveDependencies(const String& filePath) const {
+	std::ofstream fout(filePath.c_str(), std::ios::out | std::ios::trunc);
+	for (const auto& entry : _entries) {
+		const AssetCacheEntry& asset = entry.second;
+		if (asset.outputs.empty()) {
+			continue;
+		}
+
+		for (const auto& output : asset.outputs) {
+			fout << escapeMakePath(output.path).c_str() << ' ';
+		}
+		fout << ':';
+
+		//入力をそのまま書き換える変換では入力が出力にも入るので、自分自身には依存させない
+		auto isOutput = [&asset](const String& path) {
+			return std::any_of(asset.outputs.begin(), asset.outputs.end(), [&path](const AssetFileHash& output) { return output.path == path; });
+		};
+
+		if (!isOutput(entry.first)) {
+			fout << ' ' << escapeMakePath(entry.first).c_str();
+		}
+
+		for (const auto& dependency : asset.dependencies) {
+			if (!isOutput(dependency.path)) {
+				fout << ' ' << escapeMakePath(dependency.path).c_str();
+			}
+		}
+		fout << '\n';
+	}
+
+	return static_cast<bool>(fout);
+}
+
+AssetCooker::AssetCooker() :_isForced(false) {
+}
+
+void AssetCooker::addConverter(RefPtr<AssetConverter> converter) {
+	_converters.push_back(converter);
+}
+
+void AssetCooker::cook(const VectorArray<String>& inputPaths, ThreadPool& threadPool, AssetCookCache& cache,
+	VectorArray<AssetCookResult>& outResults, VectorArray<AssetCookStatus>& outStatuses, AssetCookStatistics& outStatistics) const {
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	const uint32 inputCount = static_cast<uint32>(inputPaths.size());
+	outResults.assign(inputCount, AssetCookResult());
+	outStatuses.assign(inputCount, ASSET_COOK_UNSUPPORTED);
+
+	//変換した入力の新しいエントリー。キャッシュへの反映は全部の変換が終わってから行う
+	VectorArray<AssetCacheEntry> cookedEntries(inputCount);
+	threadPool.parallelFor(inputCount, [&](uint32 i) {
+		const String& inputPath = inputPaths[i];
+		AssetCookResult& result = outResults[i];
+		RefPtr<AssetConverter> converter = findConverter(inputPath);
+		if (converter == nullptr) {
+			result.log = "Unsupported: " + inputPath + "\n";
+			return;
+		}
+
+		uint64 inputHash = 0;
+		if (!computeFileHash(inputPath, inputHash)) {
+			result.log = "Failed (not found): " + inputPath + "\n";
+			outStatuses[i] = ASSET_COOK_FAILED;
+			return;
+		}
+
+		//前回と同じなら出力と依存ファイルをキャッシュから埋め、依存マニフェストにも残す
+		const uint64 settingsHash = converter->getSettingsHash();
+		if (!_isForced && cache.isUpToDate(inputPath, converter->getName(), inputHash, settingsHash)) {
+			const AssetCacheEntry* entry = cache.findEntry(inputPath);
+			for (const auto& output : entry->outputs) {
+				result.outputPaths.push_back(output.path);
+			}
+
+			for (const auto& dependency : entry->dependencies) {
+				result.dependencyPaths.push_back(dependency.path);
+			}
+
+			result.log = "Skip (up to date): " + inputPath + "\n";
+			outStatuses[i] = ASSET_COOK_SKIPPED;
+			return;
+		}
+
+		if (!converter->convert(inputPath, result)) {
+			result.log += "Failed: " + inputPath + "\n";
+			outStatuses[i] = ASSET_COOK_FAILED;
+			return;
+		}
+
+		//入力をそのまま書き換える変換器もあるので、入力のハッシュは変換の後に取り直す
+		AssetCacheEntry& entry = cookedEntries[i];
+		entry.converterName = converter->getName();
+		entry.settingsHash = settingsHash;
+		bool isHashed = computeFileHash(inputPath, entry.inputHash);
+		for (const auto& outputPath : result.outputPaths) {
+			AssetFileHash output = { outputPath, 0 };
+			isHashed = isHashed && computeFileHash(outputPath, output.hash);
+			entry.outputs.push_back(output);
+		}
+
+		for (const auto& dependencyPath : result.dependencyPaths) {
+			AssetFileHash dependency = { dependencyPath, 0 };
+			isHashed = isHashed && computeFileHash(dependencyPath, dependency.hash);
+			entry.dependencies.push_back(dependency);
+		}
+
+		if (!isHashed) {
+			result.log += "Failed (output not found): " + inputPath + "\n";
+			outStatuses[i] = ASSET_COOK_FAILED;
+			return;
+		}
+
+		outStatuses[i] = ASSET_COOK_CONVERTED;
+	});
+
+	outStatistics = AssetCookStatistics();
+	for (uint32 i = 0; i < inputCount; ++i) {
+		switch (outStatuses[i]) {
+		case ASSET_COOK_CONVERTED:
+			cache.setEntry(inputPaths[i], cookedEntries[i]);
+			++outStatistics.convertedCount;
+			break;
+		case ASSET_COOK_SKIPPED:
+			++outStatistics.skippedCount;
+			break;
+		case ASSET_COOK_FAILED:
+			//次回も必ず変換し直すように消しておく
+			cache.removeEntry(inputPaths[i]);
+			++outStatistics.failedCount;
+			break;
+		case ASSET_COOK_UNSUPPORTED:
+			++outStatistics.unsupportedCount;
+			break;
+		}
+	}
+
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	outStatistics.elapsedMilliseconds = elapsed.count();
+}
+
+uint64 AssetCooker::computeHash(const void* data, uint64 size, uint64 seed) {
+	const byte* bytes = reinterpret_cast<const byte*>(data);
+	uint64 hash = seed;
+	for (uint64 i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+bool AssetCooker::computeFileHash(const String& filePath, uint64& outHash) {
+	std::ifstream fin(filePath.c_str(), std::ios::in | std::ios::binary);
+	if (!fin) {
+		return false;
+	}
+
+	//空のファイルも出力になりうるので、マップせずに読み込んで計算する
+	constexpr uint32 READ_SIZE = 1024 * 1024;
+	VectorArray<byte> buffer(READ_SIZE);
+	uint64 hash = computeHash(nullptr, 0);
+	while (fin) {
+		fin.read(reinterpret_cast<char*>(buffer.data()), READ_SIZE);
+		hash = computeHash(buffer.data(), static_cast<uint64>(fin.gcount()), hash);
+	}
+
+	outHash = hash;
+	return fin.eof();
+}
+
+bool AssetCooker::hasExtension(const String& filePath, const char* extension) {
+	const size_t dotPosition = filePath.find_last_of('.');
+	const size_t extensionLength = strlen(extension);
+	if (dotPosition == String::npos || filePath.size() - dotPosition - 1 != extensionLength) {
+		return false;
+	}
+
+	for (size_t i = 0; i < extensionLength; ++i) {
+		if (tolower(static_cast<unsigned char>(filePath[dotPosition + 1 + i])) != tolower(static_cast<unsigned char>(extension[i]))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+RefPtr<AssetConverter> AssetCooker::findConverter(const String& inputPath) const {
+	for (RefPtr<AssetConverter> converter : _converters) {
+		if (converter->canConvert(inputPath)) {
+			return converter;
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,146 @@
+#include "include/AssetFileSystem.h"
+
+AssetFileSystem* Singleton<AssetFileSystem>::_singleton = 0;
+
+AssetFileSystem::AssetFileSystem() {
+}
+
+AssetFileSystem::~AssetFileSystem() {
+	unmountAll();
+	_singleton = nullptr;
+}
+
+bool AssetFileSystem::mount(const char* archivePath, const char* mountPoint) {
+	UniquePtr<AssetArchive> archive = makeUnique<AssetArchive>();
+	if (!archive->open(archivePath)) {
+		return false;
+	}
+
+	MountedArchive mountedArchive;
+	mountedArchive.mountPoint = AssetArchive::normalizePath(mountPoint);
+	if (!mountedArchive.mountPoint.empty() && mountedArchive.mountPoint.back() != '/') {
+		mountedArchive.mountPoint += '/';
+	}
+
+	mountedArchive.archive = std::move(archive);
+	_archives.push_back(std::move(mountedArchive));
+	return true;
+}
+
+void AssetFileSystem::unmountAll() {
+	_archives.clear();
+}
+
+const AssetArchive* AssetFileSystem::findEntry(const char* filePath, const AssetArchiveEntry*& outEntry) const {
+	outEntry = nullptr;
+	if (_archives.empty()) {
+		return nullptr;
+	}
+
+	const String normalizedPath = AssetArchive::normalizePath(filePath);
+	for (auto itr = _archives.rbegin(); itr != _archives.rend(); ++itr) {
+		const String& mountPoint = itr->mountPoint;
+		if (normalizedPath.compare(0, mountPoint.size(), mountPoint) != 0) {
+			continue;
+		}
+
+		outEntry = itr->archive->findEntry(normalizedPath.c_str() + mountPoint.size());
+		if (outEntry != nullptr) {
+			return itr->archive.get();
+		}
+	}
+
+	return nullptr;
+}
+
+AssetFile::AssetFile() :_data(nullptr), _size(0), _archive(nullptr), _entry(nullptr) {
+}
+
+AssetFile::~AssetFile() {
+	close();
+}
+
+AssetFile::AssetFile(AssetFile&& other)
+	:_data(other._data), _size(other._size), _file(std::move(other._file)),
+	_archive(other._archive), _entry(other._entry), _decompressedData(std::move(other._decompressedData)) {
+	other._data = nullptr;
+	other._size = 0;
+	other._archive = nullptr;
+	other._entry = nullptr;
+}
+
+AssetFile& AssetFile::operator=(AssetFile&& other) {
+	if (this != &other) {
+		close();
+		_data = other._data;
+		_size = other._size;
+		_file = std::move(other._file);
+		_archive = other._archive;
+		_entry = other._entry;
+		_decompressedData = std::move(other._decompressedData);
+
+		other._data = nullptr;
+		other._size = 0;
+		other._archive = nullptr;
+		other._entry = nullptr;
+	}
+
+	return *this;
+}
+
+bool AssetFile::open(const char* filePath) {
+	close();
+
+	const AssetArchiveEntry* entry = nullptr;
+	const AssetArchive* archive = AssetFileSystem::isCreated() ? AssetFileSystem::instance().findEntry(filePath, entry) : nullptr;
+	if (archive == nullptr) {
+		if (!_file.open(filePath)) {
+			return false;
+		}
+
+		_data = _file.data();
+		_size = _file.size();
+		return true;
+	}
+
+	if (entry->size == 0) {
+		return false;
+	}
+
+	if (entry->compression != ASSET_ARCHIVE_COMPRESSION_NONE) {
+		if (!archive->readEntry(*entry, _decompressedData)) {
+			VectorArray<byte>().swap(_decompressedData);
+			return false;
+		}
+
+		_data = _decompressedData.data();
+	}
+	else {
+		_data = archive->getStoredData(*entry);
+	}
+
+	_size = entry->size;
+	_archive = archive;
+	_entry = entry;
+	return true;
+}
+
+void AssetFile::close() {
+	_file.close();
+	VectorArray<byte>().swap(_decompressedData);
+	_data = nullptr;
+	_size = 0;
+	_archive = nullptr;
+	_entry = nullptr;
+}
+
+void AssetFile::prefetch(uint64 offset, uint64 size) const {
+	if (_archive == nullptr) {
+		_file.prefetch(offset, size);
+		return;
+	}
+
+	if (_entry->compression == ASSET_ARCHIVE_COMPRESSION_NONE) {
+		_archive->prefetch(*_entry, offset, size);
+	}
+}
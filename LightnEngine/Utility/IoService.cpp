@@ -0,0 +1,786 @@
+#include "include/IoService.h"
+#include "include/AssetFileSystem.h"
+#include "include/Lz4Codec.h"
+#include <algorithm>
+#include <cassert>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+IoService* Singleton<IoService>::_singleton = 0;
+
+//読み込み先のメモリ。まとめて読んだ要求の数だけ参照される
+struct IoBlock {
+	VectorArray<byte> data;
+	std::atomic<uint32> referenceCount;
+
+	//先読みの合計に数えた大きさ。先読みでなければ0
+	uint64 readAheadSize;
+};
+
+struct IoService::IoFile {
+	String filePath;
+	uint64 size = 0;
+	bool isOpened = false;
+	bool isFailed = false;
+#ifdef _WIN32
+	HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+	int descriptor = -1;
+#endif
+};
+
+IoBuffer::IoBuffer() :_service(nullptr), _block(nullptr), _data(nullptr), _size(0) {
+}
+
+IoBuffer::~IoBuffer() {
+	release();
+}
+
+IoBuffer::IoBuffer(IoBuffer&& other) :_service(other._service), _block(other._block), _data(other._data), _size(other._size) {
+	other._service = nullptr;
+	other._block = nullptr;
+	other._data = nullptr;
+	other._size = 0;
+}
+
+IoBuffer& IoBuffer::operator=(IoBuffer&& other) {
+	if (this != &other) {
+		release();
+		_service = other._service;
+		_block = other._block;
+		_data = other._data;
+		_size = other._size;
+
+		other._service = nullptr;
+		other._block = nullptr;
+		other._data = nullptr;
+		other._size = 0;
+	}
+
+	return *this;
+}
+
+void IoBuffer::release() {
+	if (_block == nullptr) {
+		return;
+	}
+
+	_service->releaseBlock(_block);
+	_service = nullptr;
+	_block = nullptr;
+	_data = nullptr;
+	_size = 0;
+}
+
+IoRequestGroup::IoRequestGroup() :_pendingCount(0) {
+}
+
+void IoRequestGroup::wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_condition.wait(lock, [this]() { return _pendingCount.load(std::memory_order_acquire) == 0; });
+}
+
+void IoRequestGroup::add() {
+	_pendingCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IoRequestGroup::done() {
+	//待っている側がカウンターを見てから眠るまでの間に通知が抜けないよう、ロードを取ってから減らす
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		_condition.notify_all();
+	}
+}
+
+IoService::IoService() :_completionThreadPool(nullptr), _nextRequestId(1), _lowPriorityReadingCount(0), _isShutdown(true),
+	_freeBlockSize(0), _readAheadSize(0), _activeRequestCount(0) {
+}
+
+IoService::~IoService() {
+	shutdown();
+	_singleton = nullptr;
+}
+
+void IoService::create(const IoServiceSettings& settings, ThreadPool* completionThreadPool) {
+	assert(_ioThreads.empty() && "IoServiceは作成済み");
+	_settings = settings;
+	_settings.threadCount = std::max(_settings.threadCount, 1u);
+
+	//ワーカーのいないスレッドプールはその場でジョブを実行するので、I/Oスレッドで呼ぶのと変わらない
+	_completionThreadPool = completionThreadPool != nullptr && completionThreadPool->getWorkerCount() > 0 ? completionThreadPool : nullptr;
+	_isShutdown = false;
+
+	_ioThreads.reserve(_settings.threadCount);
+	for (uint32 i = 0; i < _settings.threadCount; ++i) {
+		_ioThreads.emplace_back(&IoService::ioThreadMain, this);
+	}
+}
+
+void IoService::shutdown() {
+	if (_ioThreads.empty()) {
+		return;
+	}
+
+	//キューに残っている要求はすべて取り消す。コールバックは呼ぶので待っている側は抜けられる
+	VectorArray<PendingRead> cancelledReads;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isShutdown = true;
+		for (auto& pendingReads : _pendingReads) {
+			for (auto& pendingRead : pendingReads) {
+				cancelledReads.emplace_back(std::move(pendingRead));
+			}
+
+			pendingReads.clear();
+		}
+	}
+
+	_condition.notify_all();
+	for (auto& cancelledRead : cancelledReads) {
+		cancelledRead.isCompletedOnIoThread = true;
+		complete(cancelledRead, IO_STATUS_CANCELLED, IoBuffer());
+	}
+
+	for (auto& ioThread : _ioThreads) {
+		if (ioThread.joinable()) {
+			ioThread.join();
+		}
+	}
+
+	_ioThreads.clear();
+
+	//スレッドプールに積んだコールバックが抜けるまで待ってから、ファイルとブロックを片付ける
+	waitIdle();
+	closeFiles();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (IoBlock* block : _freeBlocks) {
+		delete block;
+	}
+
+	_freeBlocks.clear();
+	_freeBlockSize = 0;
+	_completionThreadPool = nullptr;
+}
+
+IoRequestId IoService::read(const IoReadRequest& request, IoRequestGroup* group) {
+	return enqueue(request, group, false);
+}
+
+bool IoService::cancel(IoRequestId requestId) {
+	PendingRead cancelledRead;
+	bool isFound = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto& pendingReads : _pendingReads) {
+			auto itr = std::find_if(pendingReads.begin(), pendingReads.end(), [requestId](const PendingRead& pendingRead) {
+				return pendingRead.requestId == requestId;
+			});
+
+			if (itr != pendingReads.end()) {
+				cancelledRead = std::move(*itr);
+				pendingReads.erase(itr);
+				isFound = true;
+				break;
+			}
+		}
+	}
+
+	if (!isFound) {
+		return false;
+	}
+
+	complete(cancelledRead, IO_STATUS_CANCELLED, IoBuffer());
+	return true;
+}
+
+bool IoService::readBlocking(const String& filePath, uint64 offset, uint64 size, IoPriority priority, IoBuffer& outBuffer) {
+	IoStatus status = IO_STATUS_FAILED;
+	IoReadRequest request;
+	request.filePath = filePath;
+	request.offset = offset;
+	request.size = size;
+	request.priority = priority;
+	request.callback = [&status, &outBuffer](IoReadResult& result) {
+		status = result.status;
+		outBuffer = std::move(result.buffer);
+	};
+
+	//スレッドプールのワーカーがすべて待っていてもコールバックが呼ばれるよう、完了はI/Oスレッドで扱う
+	IoRequestGroup group;
+	enqueue(request, &group, true);
+	group.wait();
+	return status == IO_STATUS_SUCCEEDED;
+}
+
+void IoService::waitIdle() {
+	std::unique_lock<std::mutex> lock(_idleMutex);
+	_idleCondition.wait(lock, [this]() { return _activeRequestCount.load(std::memory_order_acquire) == 0; });
+}
+
+IoServiceStatistics IoService::getStatistics() const {
+	IoServiceStatistics statistics;
+	{
+		std::lock_guard<std::mutex> lock(_statisticsMutex);
+		statistics = _statistics;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	statistics.readAheadSize = _readAheadSize;
+	statistics.pendingRequestCount = 0;
+	for (const auto& pendingReads : _pendingReads) {
+		statistics.pendingRequestCount += static_cast<uint32>(pendingReads.size());
+	}
+
+	return statistics;
+}
+
+void IoService::resetStatistics() {
+	std::lock_guard<std::mutex> lock(_statisticsMutex);
+	_statistics = IoServiceStatistics();
+}
+
+IoRequestId IoService::enqueue(const IoReadRequest& request, IoRequestGroup* group, bool isCompletedOnIoThread) {
+	PendingRead pendingRead;
+	pendingRead.priority = request.priority;
+	pendingRead.offset = request.offset;
+	pendingRead.size = request.size;
+	pendingRead.isCompressed = false;
+	pendingRead.uncompressedSize = 0;
+	pendingRead.sliceOffset = 0;
+	pendingRead.sliceSize = 0;
+	pendingRead.isCompletedOnIoThread = isCompletedOnIoThread;
+	pendingRead.callback = request.callback;
+	pendingRead.group = group;
+	pendingRead.submitTime = Clock::now();
+
+	//アーカイブに入っていれば、アーカイブのファイル上の範囲に読み替える
+	String filePath = request.filePath;
+	const AssetArchiveEntry* entry = nullptr;
+	const AssetArchive* archive = AssetFileSystem::isCreated() ? AssetFileSystem::instance().findEntry(request.filePath.c_str(), entry) : nullptr;
+	if (archive != nullptr) {
+		filePath = archive->getFilePath();
+		const uint64 offset = std::min(request.offset, entry->size);
+		const uint64 size = std::min(request.size, entry->size - offset);
+		if (entry->compression == ASSET_ARCHIVE_COMPRESSION_NONE) {
+			pendingRead.offset = entry->offset + offset;
+			pendingRead.size = size;
+		}
+		else {
+			//圧縮したエントリーは本体をすべて読んでから展開して切り出す
+			pendingRead.offset = entry->offset;
+			pendingRead.size = entry->storedSize;
+			pendingRead.isCompressed = true;
+			pendingRead.uncompressedSize = entry->size;
+			pendingRead.sliceOffset = offset;
+			pendingRead.sliceSize = size;
+		}
+	}
+
+	if (group != nullptr) {
+		group->add();
+	}
+
+	_activeRequestCount.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(_statisticsMutex);
+		++_statistics.priorities[request.priority].requestCount;
+	}
+
+	IoRequestId requestId = INVALID_IO_REQUEST_ID;
+	bool isShutdown = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		requestId = _nextRequestId++;
+		pendingRead.requestId = requestId;
+		isShutdown = _isShutdown;
+		if (!isShutdown) {
+			pendingRead.fileIndex = findOrAddFile(filePath);
+			_pendingReads[request.priority].emplace_back(std::move(pendingRead));
+		}
+	}
+
+	//作成前と終了後の要求は読まずに取り消す
+	if (isShutdown) {
+		pendingRead.isCompletedOnIoThread = true;
+		complete(pendingRead, IO_STATUS_CANCELLED, IoBuffer());
+		return requestId;
+	}
+
+	_condition.notify_one();
+	return requestId;
+}
+
+uint32 IoService::findOrAddFile(const String& filePath) {
+	auto itr = _fileIndices.find(filePath);
+	if (itr != _fileIndices.end()) {
+		return itr->second;
+	}
+
+	const uint32 fileIndex = static_cast<uint32>(_files.size());
+	UniquePtr<IoFile> file = makeUnique<IoFile>();
+	file->filePath = filePath;
+	_files.emplace_back(std::move(file));
+	_fileIndices.emplace(filePath, fileIndex);
+	return fileIndex;
+}
+
+bool IoService::canIssue(IoPriority priority) const {
+	if (_pendingReads[priority].empty()) {
+		return false;
+	}
+
+	if (priority != IO_PRIORITY_LOW) {
+		return true;
+	}
+
+	//先読みは返されていないバッファが予算を超えている間は発行しない
+	//また、高い優先度の要求がすぐに読めるよう、I/Oスレッドを1つは先読みに使わずに残しておく
+	const uint32 lowPriorityThreadCount = _settings.threadCount > 1 ? _settings.threadCount - 1 : 1;
+	return _readAheadSize < _settings.readAheadBudget && _lowPriorityReadingCount < lowPriorityThreadCount;
+}
+
+bool IoService::takeReads(VectorArray<PendingRead>& outReads) {
+	uint32 priority = 0;
+	while (priority < IO_PRIORITY_COUNT && !canIssue(static_cast<IoPriority>(priority))) {
+		++priority;
+	}
+
+	if (priority == IO_PRIORITY_COUNT) {
+		return false;
+	}
+
+	DequeArray<PendingRead>& pendingReads = _pendingReads[priority];
+	const PendingRead& first = pendingReads.front();
+	const bool isCoalescible = _settings.maxCoalescedSize > 0 && !first.isCompressed && first.size != IO_READ_TO_END;
+	if (!isCoalescible) {
+		outReads.emplace_back(std::move(pendingReads.front()));
+		pendingReads.pop_front();
+		return true;
+	}
+
+	//先頭の要求と同じファイルの範囲を指定した要求を位置の順に並べ、先頭の要求から前後に隙間の小さいものをつなげていく
+	struct Candidate {
+		uint32 queueIndex;
+		uint64 offset;
+		uint64 end;
+	};
+
+	VectorArray<Candidate> candidates;
+	for (uint32 i = 0; i < pendingReads.size(); ++i) {
+		const PendingRead& pendingRead = pendingReads[i];
+		if (pendingRead.fileIndex == first.fileIndex && !pendingRead.isCompressed && pendingRead.size != IO_READ_TO_END) {
+			candidates.push_back({ i, pendingRead.offset, pendingRead.offset + pendingRead.size });
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& left, const Candidate& right) {
+		return left.offset < right.offset || (left.offset == right.offset && left.queueIndex < right.queueIndex);
+	});
+
+	const uint32 firstIndex = static_cast<uint32>(std::find_if(candidates.begin(), candidates.end(), [](const Candidate& candidate) {
+		return candidate.queueIndex == 0;
+	}) - candidates.begin());
+
+	uint64 rangeBegin = candidates[firstIndex].offset;
+	uint64 rangeEnd = candidates[firstIndex].end;
+	uint32 beginIndex = firstIndex;
+	uint32 endIndex = firstIndex + 1;
+	while (endIndex < candidates.size()) {
+		const Candidate& candidate = candidates[endIndex];
+		const uint64 newEnd = std::max(rangeEnd, candidate.end);
+		if (candidate.offset > rangeEnd + _settings.coalesceGap || newEnd - rangeBegin > _settings.maxCoalescedSize) {
+			break;
+		}
+
+		rangeEnd = newEnd;
+		++endIndex;
+	}
+
+	//前に並ぶ要求は終端で比べる。重なっている要求は終端が手前にあることもある
+	while (beginIndex > 0) {
+		const Candidate& candidate = candidates[beginIndex - 1];
+		if (candidate.end + _settings.coalesceGap < rangeBegin || rangeEnd - candidate.offset > _settings.maxCoalescedSize) {
+			break;
+		}
+
+		rangeBegin = candidate.offset;
+		--beginIndex;
+	}
+
+	VectorArray<uint32> queueIndices;
+	queueIndices.reserve(endIndex - beginIndex);
+	for (uint32 i = beginIndex; i < endIndex; ++i) {
+		queueIndices.push_back(candidates[i].queueIndex);
+	}
+
+	//キューから後ろの位置から取り除いて、残りの順番を保つ
+	std::sort(queueIndices.begin(), queueIndices.end());
+	for (auto itr = queueIndices.rbegin(); itr != queueIndices.rend(); ++itr) {
+		outReads.emplace_back(std::move(pendingReads[*itr]));
+		pendingReads.erase(pendingReads.begin() + *itr);
+	}
+
+	std::sort(outReads.begin(), outReads.end(), [](const PendingRead& left, const PendingRead& right) {
+		return left.offset < right.offset;
+	});
+
+	return true;
+}
+
+void IoService::ioThreadMain() {
+	VectorArray<PendingRead> reads;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this, &reads]() { return _isShutdown || takeReads(reads); });
+			if (reads.empty()) {
+				return;
+			}
+
+			if (reads.front().priority == IO_PRIORITY_LOW) {
+				++_lowPriorityReadingCount;
+			}
+		}
+
+		const bool isLowPriority = reads.front().priority == IO_PRIORITY_LOW;
+		executeReads(reads);
+		reads.clear();
+
+		if (isLowPriority) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			--_lowPriorityReadingCount;
+		}
+
+		//先読みのスレッドの枠が空いたので、待っている先読みを起こす
+		_condition.notify_all();
+	}
+}
+
+void IoService::executeReads(VectorArray<PendingRead>& reads) {
+	IoFile* file = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		file = _files[reads.front().fileIndex].get();
+	}
+
+	if (!openFile(*file)) {
+		for (auto& read : reads) {
+			complete(read, IO_STATUS_FAILED, IoBuffer());
+		}
+		return;
+	}
+
+	//範囲をファイルの終端で切る
+	uint64 rangeBegin = ~0ull;
+	uint64 rangeEnd = 0;
+	for (auto& read : reads) {
+		read.offset = std::min(read.offset, file->size);
+		read.size = std::min(read.size, file->size - read.offset);
+		rangeBegin = std::min(rangeBegin, read.offset);
+		rangeEnd = std::max(rangeEnd, read.offset + read.size);
+	}
+
+	const IoPriority priority = reads.front().priority;
+	const bool isReadAhead = priority == IO_PRIORITY_LOW;
+	PendingRead& first = reads.front();
+	const uint64 readSize = rangeEnd - rangeBegin;
+
+	IoBlock* block = acquireBlock(first.isCompressed ? readSize : std::max(readSize, 1ull), isReadAhead && !first.isCompressed);
+	bool isSucceeded = readFile(*file, rangeBegin, readSize, block->data.data());
+
+	{
+		std::lock_guard<std::mutex> lock(_statisticsMutex);
+		++_statistics.readCount;
+		_statistics.readSize += readSize;
+		_statistics.coalescedRequestCount += reads.size() > 1 ? static_cast<uint32>(reads.size()) : 0;
+	}
+
+	//圧縮したエントリーは展開先を別に取り、読んだ本体はすぐに返す
+	if (first.isCompressed) {
+		IoBlock* decompressedBlock = acquireBlock(std::max(first.uncompressedSize, 1ull), isReadAhead);
+		isSucceeded = isSucceeded && Lz4Codec::decompress(block->data.data(), readSize, decompressedBlock->data.data(), first.uncompressedSize);
+		releaseBlock(block);
+		block = decompressedBlock;
+		first.offset = 0;
+		first.size = first.uncompressedSize;
+		rangeBegin = 0;
+	}
+
+	for (auto& read : reads) {
+		if (!isSucceeded) {
+			complete(read, IO_STATUS_FAILED, IoBuffer());
+			continue;
+		}
+
+		const byte* data = block->data.data() + (read.offset - rangeBegin);
+		uint64 size = read.size;
+		if (read.isCompressed) {
+			data += read.sliceOffset;
+			size = read.sliceSize;
+		}
+
+		block->referenceCount.fetch_add(1, std::memory_order_relaxed);
+		complete(read, IO_STATUS_SUCCEEDED, makeBuffer(block, data, size));
+	}
+
+	//ここまでは読んだスレッドが参照を持っておき、コールバックより先にブロックが返されないようにする
+	releaseBlock(block);
+}
+
+bool IoService::openFile(IoFile& file) {
+	std::lock_guard<std::mutex> lock(_fileOpenMutex);
+	if (file.isOpened || file.isFailed) {
+		return file.isOpened;
+	}
+
+	//開けなかったファイルは覚えておき、同じファイルへの要求は開き直さずに失敗させる
+	file.isFailed = true;
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(file.filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(handle, &fileSize)) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	file.handle = handle;
+	file.size = static_cast<uint64>(fileSize.QuadPart);
+#else
+	const int descriptor = ::open(file.filePath.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	struct stat fileStat = {};
+	if (fstat(descriptor, &fileStat) != 0) {
+		::close(descriptor);
+		return false;
+	}
+
+	file.descriptor = descriptor;
+	file.size = static_cast<uint64>(fileStat.st_size);
+#endif
+
+	file.isFailed = false;
+	file.isOpened = true;
+	return true;
+}
+
+bool IoService::readFile(IoFile& file, uint64 offset, uint64 size, byte* dst) {
+	//1回で読める大きさに限りがあるので分けて読む。位置を指定するのでほかのスレッドと同じファイルを同時に読んでよい
+	constexpr uint64 MaxReadSize = 64 * 1024 * 1024;
+	while (size > 0) {
+		const uint64 chunkSize = std::min(size, MaxReadSize);
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+		DWORD readSize = 0;
+		if (!ReadFile(file.handle, dst, static_cast<DWORD>(chunkSize), &readSize, &overlapped) || readSize == 0) {
+			return false;
+		}
+#else
+		const ssize_t readSize = pread(file.descriptor, dst, static_cast<size_t>(chunkSize), static_cast<off_t>(offset));
+		if (readSize <= 0) {
+			return false;
+		}
+#endif
+
+		offset += static_cast<uint64>(readSize);
+		size -= static_cast<uint64>(readSize);
+		dst += readSize;
+	}
+
+	return true;
+}
+
+void IoService::closeFiles() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& file : _files) {
+		if (!file->isOpened) {
+			continue;
+		}
+
+#ifdef _WIN32
+		CloseHandle(file->handle);
+#else
+		::close(file->descriptor);
+#endif
+	}
+
+	_files.clear();
+	_fileIndices.clear();
+}
+
+IoBlock* IoService::acquireBlock(uint64 size, bool isReadAhead) {
+	IoBlock* block = nullptr;
+	uint64 readAheadSize = 0;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		//足りる中で最も小さいブロックを使う。倍以上大きいブロックは小さい要求に使わない
+		auto bestItr = _freeBlocks.end();
+		for (auto itr = _freeBlocks.begin(); itr != _freeBlocks.end(); ++itr) {
+			const uint64 capacity = (*itr)->data.size();
+			if (capacity >= size && capacity <= size * 2 && (bestItr == _freeBlocks.end() || capacity < (*bestItr)->data.size())) {
+				bestItr = itr;
+			}
+		}
+
+		if (bestItr != _freeBlocks.end()) {
+			block = *bestItr;
+			_freeBlockSize -= block->data.size();
+			*bestItr = _freeBlocks.back();
+			_freeBlocks.pop_back();
+		}
+
+		if (isReadAhead) {
+			_readAheadSize += size;
+			readAheadSize = _readAheadSize;
+		}
+	}
+
+	if (block == nullptr) {
+		block = new IoBlock();
+		block->data.resize(static_cast<size_t>(size));
+	}
+
+	block->referenceCount.store(1, std::memory_order_relaxed);
+	block->readAheadSize = isReadAhead ? size : 0;
+
+	if (isReadAhead) {
+		std::lock_guard<std::mutex> lock(_statisticsMutex);
+		_statistics.maxReadAheadSize = std::max(_statistics.maxReadAheadSize, readAheadSize);
+	}
+
+	return block;
+}
+
+void IoService::releaseBlock(IoBlock* block) {
+	if (block->referenceCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		return;
+	}
+
+	bool isReadAhead = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		isReadAhead = block->readAheadSize > 0;
+		_readAheadSize -= block->readAheadSize;
+
+		//使い回すブロックは先読みの予算と同じ大きさまでに抑え、超える分と終了後に返されたブロックは解放する
+		const uint64 capacity = block->data.size();
+		if (!_isShutdown && _freeBlockSize + capacity <= _settings.readAheadBudget) {
+			_freeBlocks.push_back(block);
+			_freeBlockSize += capacity;
+			block = nullptr;
+		}
+	}
+
+	delete block;
+
+	//先読みの予算が空いたので、待っている先読みを起こす
+	if (isReadAhead) {
+		_condition.notify_all();
+	}
+}
+
+IoBuffer IoService::makeBuffer(IoBlock* block, const byte* data, uint64 size) {
+	IoBuffer buffer;
+	buffer._service = this;
+	buffer._block = block;
+	buffer._data = data;
+	buffer._size = size;
+	return buffer;
+}
+
+void IoService::complete(PendingRead& read, IoStatus status, IoBuffer&& buffer) {
+	IoCompletion completion;
+	completion.callback = std::move(read.callback);
+	completion.group = read.group;
+	completion.result.requestId = read.requestId;
+	completion.result.status = status;
+	completion.result.priority = read.priority;
+	completion.result.buffer = std::move(buffer);
+	completion.result.latencyMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - read.submitTime).count();
+
+	{
+		std::lock_guard<std::mutex> lock(_statisticsMutex);
+		IoPriorityStatistics& statistics = _statistics.priorities[read.priority];
+		switch (status) {
+		case IO_STATUS_SUCCEEDED:
+			++statistics.completedCount;
+			statistics.completedSize += completion.result.buffer.size();
+			break;
+		case IO_STATUS_FAILED:
+			++statistics.failedCount;
+			break;
+		case IO_STATUS_CANCELLED:
+			++statistics.cancelledCount;
+			break;
+		}
+
+		//取り消した要求は待ち時間に数えない
+		if (status != IO_STATUS_CANCELLED) {
+			statistics.totalLatencyMilliseconds += completion.result.latencyMilliseconds;
+			statistics.maxLatencyMilliseconds = std::max(statistics.maxLatencyMilliseconds, completion.result.latencyMilliseconds);
+		}
+	}
+
+	if (_completionThreadPool == nullptr || read.isCompletedOnIoThread) {
+		finishCompletion(completion);
+		return;
+	}
+
+	//IoBufferはコピーできずジョブに持たせられないので、完了をキューに積んでジョブからは1つずつ取り出す
+	{
+		std::lock_guard<std::mutex> lock(_completionMutex);
+		_completions.emplace_back(std::move(completion));
+	}
+
+	_completionThreadPool->pushJob([this]() { executeCompletion(); });
+}
+
+void IoService::executeCompletion() {
+	IoCompletion completion;
+	{
+		std::lock_guard<std::mutex> lock(_completionMutex);
+		completion = std::move(_completions.front());
+		_completions.pop_front();
+	}
+
+	finishCompletion(completion);
+}
+
+void IoService::finishCompletion(IoCompletion& completion) {
+	if (completion.callback) {
+		completion.callback(completion.result);
+	}
+
+	//持ち出されなかったバッファはここで返す
+	completion.result.buffer.release();
+	completion.callback = nullptr;
+
+	if (completion.group != nullptr) {
+		completion.group->done();
+	}
+
+	if (_activeRequestCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		std::lock_guard<std::mutex> lock(_idleMutex);
+		_idleCondition.notify_all();
+	}
+}
@@ -0,0 +1,231 @@
+#include "include/Lz4Codec.h"
+#include <cstring>
+
+//一致の最短の長さ
+constexpr uint32 LZ4_MIN_MATCH = 4;
+
+//ブロックの末尾5バイトは必ずリテラルにし、最後の一致は末尾から12バイトより前で始める(LZ4の仕様)
+constexpr uint32 LZ4_LAST_LITERALS = 5;
+constexpr uint32 LZ4_MATCH_LIMIT = 12;
+
+constexpr uint32 LZ4_MAX_OFFSET = 65535;
+constexpr uint64 LZ4_MAX_INPUT_SIZE = 0x7E000000;
+
+//4バイトの並びから一致の候補を引くテーブルのビット数
+constexpr uint32 LZ4_HASH_BITS = 16;
+
+//一致が見つからない間は調べる間隔を広げていく。この回数ごとに1バイト広げる
+constexpr uint32 LZ4_SKIP_TRIGGER = 6;
+
+static uint32 read32(const byte* p) {
+	uint32 value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32 hashSequence(const byte* p) {
+	return (read32(p) * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+//15以上の長さは255ずつのバイトを続けて表す
+static byte* writeLength(byte* op, uint64 length) {
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+
+	*op++ = static_cast<byte>(length);
+	return op;
+}
+
+static bool readLength(const byte*& ip, const byte* ipEnd, uint64& length) {
+	byte value = 0;
+	do {
+		if (ip >= ipEnd) {
+			return false;
+		}
+
+		value = *ip++;
+		length += value;
+	} while (value == 255);
+
+	return true;
+}
+
+uint64 Lz4Codec::getCompressBound(uint64 srcSize) {
+	return srcSize + srcSize / 255 + 16;
+}
+
+uint64 Lz4Codec::getDecompressBound(uint64 srcSize) {
+	//1バイトから一番多く出力できるのはマッチ長の延長バイトの255バイト。トークンとオフセット、リテラルはこれより少ない
+	return srcSize * 255;
+}
+
+uint64 Lz4Codec::compress(const byte* src, uint64 srcSize, byte* dst, uint64 dstCapacity) {
+	if (srcSize > LZ4_MAX_INPUT_SIZE) {
+		return 0;
+	}
+
+	const byte* srcEnd = src + srcSize;
+	const byte* anchor = src;
+	byte* op = dst;
+	byte* opEnd = dst + dstCapacity;
+
+	//トークン、リテラル、オフセット、一致の長さを書き出す。収まらなければfalse
+	auto writeSequence = [&](const byte* literals, uint64 literalLength, uint32 offset, uint64 matchLength, bool isLast) {
+		const uint64 worstSize = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+		if (static_cast<uint64>(opEnd - op) < worstSize) {
+			return false;
+		}
+
+		byte* token = op++;
+		*token = static_cast<byte>((literalLength < 15 ? literalLength : 15) << 4);
+		if (literalLength >= 15) {
+			op = writeLength(op, literalLength - 15);
+		}
+
+		if (literalLength > 0) {
+			memcpy(op, literals, static_cast<size_t>(literalLength));
+			op += literalLength;
+		}
+
+		if (isLast) {
+			return true;
+		}
+
+		*op++ = static_cast<byte>(offset);
+		*op++ = static_cast<byte>(offset >> 8);
+		*token |= static_cast<byte>(matchLength < 15 ? matchLength : 15);
+		if (matchLength >= 15) {
+			op = writeLength(op, matchLength - 15);
+		}
+
+		return true;
+	};
+
+	if (srcSize > LZ4_MATCH_LIMIT) {
+		const byte* matchLimit = srcEnd - LZ4_MATCH_LIMIT;
+		const byte* matchEnd = srcEnd - LZ4_LAST_LITERALS;
+
+		//位置はブロックの先頭からの距離で持つ。候補は必ず内容を比べるので、初期値の0が外れていても問題ない
+		VectorArray<uint32> table(1 << LZ4_HASH_BITS, 0);
+		const byte* ip = src + 1;
+		table[hashSequence(src)] = 0;
+
+		while (ip <= matchLimit) {
+			//一致を探す
+			const byte* match = nullptr;
+			uint32 searchCount = 1 << LZ4_SKIP_TRIGGER;
+			while (ip <= matchLimit) {
+				const uint32 hash = hashSequence(ip);
+				const byte* candidate = src + table[hash];
+				table[hash] = static_cast<uint32>(ip - src);
+				if (candidate < ip && ip - candidate <= LZ4_MAX_OFFSET && read32(candidate) == read32(ip)) {
+					match = candidate;
+					break;
+				}
+
+				ip += searchCount++ >> LZ4_SKIP_TRIGGER;
+			}
+
+			if (match == nullptr) {
+				break;
+			}
+
+			//前後に一致を伸ばす
+			while (ip > anchor && match > src && ip[-1] == match[-1]) {
+				--ip;
+				--match;
+			}
+
+			const byte* matchStart = ip;
+			ip += LZ4_MIN_MATCH;
+			match += LZ4_MIN_MATCH;
+			while (ip < matchEnd && *ip == *match) {
+				++ip;
+				++match;
+			}
+
+			const uint32 offset = static_cast<uint32>(ip - match);
+			if (!writeSequence(anchor, matchStart - anchor, offset, ip - matchStart - LZ4_MIN_MATCH, false)) {
+				return 0;
+			}
+
+			anchor = ip;
+
+			//一致の末尾も候補に入れておくと、続く一致を拾いやすい
+			if (ip <= matchLimit) {
+				table[hashSequence(ip - 2)] = static_cast<uint32>(ip - 2 - src);
+			}
+		}
+	}
+
+	if (!writeSequence(anchor, srcEnd - anchor, 0, 0, true)) {
+		return 0;
+	}
+
+	return static_cast<uint64>(op - dst);
+}
+
+bool Lz4Codec::decompress(const byte* src, uint64 srcSize, byte* dst, uint64 dstSize) {
+	const byte* ip = src;
+	const byte* ipEnd = src + srcSize;
+	byte* op = dst;
+	byte* opEnd = dst + dstSize;
+
+	while (ip < ipEnd) {
+		const uint32 token = *ip++;
+
+		uint64 literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(ip, ipEnd, literalLength)) {
+			return false;
+		}
+
+		if (literalLength > static_cast<uint64>(ipEnd - ip) || literalLength > static_cast<uint64>(opEnd - op)) {
+			return false;
+		}
+
+		memcpy(op, ip, static_cast<size_t>(literalLength));
+		op += literalLength;
+		ip += literalLength;
+
+		//最後のシーケンスはリテラルだけで終わる
+		if (ip == ipEnd) {
+			break;
+		}
+
+		if (ipEnd - ip < 2) {
+			return false;
+		}
+
+		const uint32 offset = ip[0] | (static_cast<uint32>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<uint64>(op - dst)) {
+			return false;
+		}
+
+		uint64 matchLength = token & 15;
+		if (matchLength == 15 && !readLength(ip, ipEnd, matchLength)) {
+			return false;
+		}
+
+		matchLength += LZ4_MIN_MATCH;
+		if (matchLength > static_cast<uint64>(opEnd - op)) {
+			return false;
+		}
+
+		//オフセットが一致の長さより短ければ、書いたばかりの値を繰り返すので1バイトずつコピーする
+		const byte* match = op - offset;
+		if (offset >= matchLength) {
+			memcpy(op, match, static_cast<size_t>(matchLength));
+			op += matchLength;
+		}
+		else {
+			for (uint64 i = 0; i < matchLength; ++i) {
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op == opEnd;
+}
@@ -0,0 +1,141 @@
+#include "include/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :_data(nullptr), _size(0), _fileHandle(nullptr), _mappingHandle(nullptr) {
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) :_data(other._data), _size(other._size), _fileHandle(other._fileHandle), _mappingHandle(other._mappingHandle) {
+	other._data = nullptr;
+	other._size = 0;
+	other._fileHandle = nullptr;
+	other._mappingHandle = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+	if (this != &other) {
+		close();
+		_data = other._data;
+		_size = other._size;
+		_fileHandle = other._fileHandle;
+		_mappingHandle = other._mappingHandle;
+
+		other._data = nullptr;
+		other._size = 0;
+		other._fileHandle = nullptr;
+		other._mappingHandle = nullptr;
+	}
+
+	return *this;
+}
+
+bool MappedFile::open(const char* filePath) {
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_fileHandle = file;
+	_mappingHandle = mapping;
+	_size = static_cast<uint64>(fileSize.QuadPart);
+#else
+	const int file = ::open(filePath, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat fileStat = {};
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	//マップした領域はファイルを閉じても有効
+	::close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	_size = static_cast<uint64>(fileStat.st_size);
+#endif
+
+	_data = reinterpret_cast<const byte*>(data);
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_mappingHandle);
+	CloseHandle(_fileHandle);
+#else
+	munmap(const_cast<byte*>(_data), static_cast<size_t>(_size));
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+}
+
+void MappedFile::prefetch(uint64 offset, uint64 size) const {
+	if (offset >= _size) {
+		return;
+	}
+
+	const uint64 end = offset + size < _size ? offset + size : _size;
+
+#ifndef _WIN32
+	//先読みを依頼してから触れる。ページ境界に揃える必要がある
+	const uint64 pageSize = static_cast<uint64>(sysconf(_SC_PAGESIZE));
+	const uint64 alignedOffset = offset & ~(pageSize - 1);
+	madvise(const_cast<byte*>(_data) + alignedOffset, static_cast<size_t>(end - alignedOffset), MADV_WILLNEED);
+#endif
+
+	//1ページに1バイト読めば十分。最適化で読み出しが消えないようにvolatileで読む
+	constexpr uint64 TouchStride = 4096;
+	volatile byte sink = 0;
+	for (uint64 i = offset; i < end; i += TouchStride) {
+		sink = sink + _data[i];
+	}
+	sink = sink + _data[end - 1];
+}
@@ -0,0 +1,275 @@
+#include "include/MeshCooker.h"
+#include "include/MappedFile.h"
+#include "include/MeshIndexCodec.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+
+//並列にクックしても行が混ざらないように、経過は表示せずに文字列に足していく
+static void appendLog(String& log, const char* format, ...) {
+	char line[512];
+	va_list arguments;
+	va_start(arguments, format);
+	vsnprintf(line, sizeof(line), format, arguments);
+	va_end(arguments);
+
+	log += line;
+	log += '\n';
+}
+
+//設定の値を1つずつハッシュに足す。構造体のパディングを含めないように値ごとに計算する
+template <class T>
+static void hashValue(uint64& hash, const T& value) {
+	hash = AssetCooker::computeHash(&value, sizeof(value), hash);
+}
+
+uint64 MeshCookSettings::computeHash() const {
+	uint64 hash = AssetCooker::computeHash(nullptr, 0);
+	hashValue(hash, MESH_COOK_VERSION);
+	hashValue(hash, MESH_FILE_VERSION);
+	hashValue(hash, static_cast<uint32>(isOptimize));
+	hashValue(hash, optimize.cacheSize);
+	hashValue(hash, optimize.overdrawThreshold);
+	hashValue(hash, lod.lodCount);
+	hashValue(hash, lod.reductionRatio);
+	hashValue(hash, lod.maxError);
+	hashValue(hash, lod.minReduction);
+	hashValue(hash, vertexTolerance.position);
+	hashValue(hash, vertexTolerance.normalAngle);
+	hashValue(hash, vertexTolerance.texcoord);
+	return hash;
+}
+
+bool MeshCooker::cookMesh(MeshFileMesh& mesh, const MeshCookSettings& settings, MeshCookData& outData, String& outLog, bool& outIsChanged) {
+	outIsChanged = false;
+	if (settings.isOptimize) {
+		if (!optimizeMesh(mesh, settings, outData.optimized, outLog)) {
+			appendLog(outLog, "Optimize failed: %s", mesh.info.name);
+			return false;
+		}
+		outIsChanged = true;
+	}
+
+	//LODとメッシュレットは並べ替えた後のインデックスから作る。作り直すときに作れなければ失敗にする
+	const bool isLodBuilt = buildLods(mesh, settings, settings.isOptimize, outData.lods, outLog);
+	if (!isLodBuilt && settings.isOptimize) {
+		appendLog(outLog, "LOD failed: %s", mesh.info.name);
+		return false;
+	}
+
+	const bool isMeshletBuilt = buildMeshlets(mesh, settings.isOptimize, outData.meshlets, outLog);
+	if (!isMeshletBuilt && settings.isOptimize) {
+		appendLog(outLog, "Meshlet failed: %s", mesh.info.name);
+		return false;
+	}
+
+	const bool isVertexChanged = compactVertices(mesh, settings, outData.vertices, outLog);
+	const bool isIndexChanged = compressIndices(mesh, outData.packedIndices, outData.encodedIndices, outLog);
+	outIsChanged = outIsChanged || isLodBuilt || isMeshletBuilt || isVertexChanged || isIndexChanged;
+	return true;
+}
+
+bool MeshCooker::cookMeshFile(const String& filePath, const MeshCookSettings& settings, String& outLog, bool& outIsWritten) {
+	outIsWritten = false;
+
+	VectorArray<byte> data;
+	{
+		MappedFile file;
+		MeshFileReader reader;
+		if (!file.open(filePath.c_str()) || !reader.open(file.data(), file.size())) {
+			appendLog(outLog, "Failed: %s", filePath.c_str());
+			return false;
+		}
+
+		const uint32 meshCount = reader.getMeshCount();
+		VectorArray<MeshFileMesh> meshes(meshCount);
+		VectorArray<MeshCookData> cookData(meshCount);
+		bool isChanged = reader.getVersion() != MESH_FILE_VERSION;
+		for (uint32 i = 0; i < meshCount; ++i) {
+			meshes[i] = reader.getMesh(i);
+
+			bool isMeshChanged = false;
+			if (!cookMesh(meshes[i], settings, cookData[i], outLog, isMeshChanged)) {
+				appendLog(outLog, "Failed: %s", filePath.c_str());
+				return false;
+			}
+			isChanged = isChanged || isMeshChanged;
+		}
+
+		if (!isChanged) {
+			appendLog(outLog, "Skip (v2): %s", filePath.c_str());
+			return true;
+		}
+
+		MeshFileWriter writer;
+		for (const auto& mesh : meshes) {
+			writer.addMesh(mesh);
+		}
+		writer.build(data);
+	}
+
+	std::ofstream fout(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	if (!fout) {
+		appendLog(outLog, "Failed (write): %s", filePath.c_str());
+		return false;
+	}
+
+	appendLog(outLog, "Upgraded: %s", filePath.c_str());
+	outIsWritten = true;
+	return true;
+}
+
+bool MeshCooker::optimizeMesh(MeshFileMesh& mesh, const MeshCookSettings& settings, OptimizedMeshData& outData, String& outLog) {
+	const MeshOptimizeSettings& optimizeSettings = settings.optimize;
+	VectorArray<uint32> indices;
+	if (!MeshOptimizer::loadIndices(mesh, indices)) {
+		return false;
+	}
+
+	const MeshCacheStatistics before = MeshOptimizer::analyzeVertexCache(indices.data(), mesh.indexCount, mesh.vertexCount, optimizeSettings.cacheSize);
+	const float fetchBefore = MeshOptimizer::analyzeVertexFetch(indices.data(), mesh.indexCount, mesh.vertexCount, mesh.vertexStride);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	MeshFileMesh optimizedMesh;
+	if (!MeshOptimizer::optimizeMesh(mesh, optimizeSettings, outData, optimizedMesh)) {
+		return false;
+	}
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	const MeshCacheStatistics after = MeshOptimizer::analyzeVertexCache(outData.indices.data(), optimizedMesh.indexCount, optimizedMesh.vertexCount, optimizeSettings.cacheSize);
+	const float fetchAfter = MeshOptimizer::analyzeVertexFetch(outData.indices.data(), optimizedMesh.indexCount, optimizedMesh.vertexCount, optimizedMesh.vertexStride);
+	appendLog(outLog, "Optimize: %s triangles %u ACMR %g -> %g ATVR %g -> %g overfetch %g -> %g (%g ms)", mesh.info.name, mesh.indexCount / 3,
+		before.acmr, after.acmr, before.atvr, after.atvr, fetchBefore, fetchAfter, elapsed.count());
+
+	mesh = optimizedMesh;
+	return true;
+}
+
+bool MeshCooker::buildLods(MeshFileMesh& mesh, const MeshCookSettings& settings, bool isRebuild, MeshLodData& outData, String& outLog) {
+	if (mesh.lodCount > 0 && !isRebuild) {
+		return false;
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	MeshFileMesh lodMesh;
+	if (!MeshSimplifier::buildLods(mesh, settings.lod, outData, lodMesh)) {
+		return false;
+	}
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	//減らしても得のないメッシュはLODを持たないまま書き出す
+	if (outData.lods.empty() && !isRebuild) {
+		return false;
+	}
+
+	uint32 lod0TriangleCount = 0;
+	for (uint32 i = 0; i < mesh.materialRangeCount; ++i) {
+		lod0TriangleCount += mesh.materialRanges[i].indexCount / 3;
+	}
+
+	String lodText;
+	for (const auto& lod : outData.lods) {
+		char text[64];
+		snprintf(text, sizeof(text), " -> %u (error %g)", lod.triangleCount, lod.error);
+		lodText += text;
+	}
+	appendLog(outLog, "LOD: %s triangles %u%s (%g ms)", mesh.info.name, lod0TriangleCount, lodText.c_str(), elapsed.count());
+
+	mesh = lodMesh;
+	return true;
+}
+
+bool MeshCooker::buildMeshlets(MeshFileMesh& mesh, bool isRebuild, MeshletData& outData, String& outLog) {
+	if (mesh.meshletCount > 0 && !isRebuild) {
+		return false;
+	}
+
+	if (!MeshletBuilder::buildMeshlets(mesh, outData)) {
+		return false;
+	}
+
+	uint32 coneCount = 0;
+	for (const auto& meshlet : outData.meshlets) {
+		coneCount += meshlet.coneCutoff < 1.0f ? 1 : 0;
+	}
+
+	//メッシュレットはLOD0の描画範囲から作る
+	uint32 triangleCount = 0;
+	for (uint32 i = 0; i < mesh.materialRangeCount; ++i) {
+		triangleCount += mesh.materialRanges[i].indexCount / 3;
+	}
+
+	const float trianglesPerMeshlet = outData.meshlets.empty() ? 0.0f : static_cast<float>(triangleCount) / outData.meshlets.size();
+	appendLog(outLog, "Meshlet: %s %u meshlets, %g triangles/meshlet, %u with cone", mesh.info.name,
+		static_cast<uint32>(outData.meshlets.size()), trianglesPerMeshlet, coneCount);
+
+	MeshletBuilder::setMeshlets(outData, mesh);
+	return true;
+}
+
+bool MeshCooker::compactVertices(MeshFileMesh& mesh, const MeshCookSettings& settings, VectorArray<MeshFileCompactVertex>& outVertices, String& outLog) {
+	if (mesh.info.vertexFormat != MESH_VERTEX_FORMAT_FLOAT) {
+		return false;
+	}
+
+	MeshVertexError error;
+	const MeshFileFloatVertex* vertices = reinterpret_cast<const MeshFileFloatVertex*>(mesh.vertices);
+	const bool isCompact = MeshVertexCodec::encodeCompactVertices(vertices, mesh.vertexCount, mesh.info, settings.vertexTolerance, outVertices, error);
+	appendLog(outLog, "%s%s position %g normal %g tangent %g uv %g", isCompact ? "Compact: " : "Float: ", mesh.info.name,
+		error.position, error.normalAngle, error.tangentAngle, error.texcoord);
+
+	if (!isCompact) {
+		outVertices.clear();
+		return false;
+	}
+
+	mesh.info.vertexFormat = MESH_VERTEX_FORMAT_COMPACT;
+	mesh.vertexStride = sizeof(MeshFileCompactVertex);
+	mesh.vertices = reinterpret_cast<const byte*>(outVertices.data());
+	return true;
+}
+
+bool MeshCooker::compressIndices(MeshFileMesh& mesh, VectorArray<byte>& outPacked, VectorArray<byte>& outEncoded, String& outLog) {
+	//すでに符号化済みならそのまま書き出す
+	if (mesh.encodedIndices != nullptr) {
+		return false;
+	}
+
+	bool isChanged = false;
+	if (mesh.indexStride == sizeof(uint32)) {
+		mesh.indexStride = MeshIndexCodec::packIndices(reinterpret_cast<const uint32*>(mesh.indices), mesh.indexCount, mesh.vertexCount, outPacked);
+		mesh.indices = outPacked.data();
+		isChanged = mesh.indexStride != sizeof(uint32);
+	}
+
+	const uint64 rawSize = static_cast<uint64>(mesh.indexCount) * mesh.indexStride;
+	MeshIndexCodec::encode(mesh.indices, mesh.indexCount, mesh.indexStride, outEncoded);
+	appendLog(outLog, "Index: %s %ubit %llu -> %llu bytes", mesh.info.name, mesh.indexStride * 8,
+		static_cast<unsigned long long>(rawSize), static_cast<unsigned long long>(outEncoded.size()));
+
+	if (outEncoded.size() >= rawSize) {
+		outEncoded.clear();
+		return isChanged;
+	}
+
+	mesh.encodedIndices = outEncoded.data();
+	mesh.encodedIndexSize = outEncoded.size();
+	return true;
+}
+
+bool MeshAssetConverter::canConvert(const String& inputPath) const {
+	return AssetCooker::hasExtension(inputPath, "mesh");
+}
+
+bool MeshAssetConverter::convert(const String& inputPath, AssetCookResult& outResult) {
+	bool isWritten = false;
+	if (!MeshCooker::cookMeshFile(inputPath, _settings, outResult.log, isWritten)) {
+		return false;
+	}
+
+	//その場で書き換えるので入力がそのまま出力になる
+	outResult.outputPaths.push_back(inputPath);
+	return true;
+}
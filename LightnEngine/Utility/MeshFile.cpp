@@ -0,0 +1,398 @@
+#include "include/MeshFile.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+static uint64 alignUp(uint64 value, uint64 alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+MeshFileReader::MeshFileReader() :_data(nullptr), _size(0), _version(0), _payloadSize(0) {
+}
+
+bool MeshFileReader::open(const void* data, uint64 size) {
+	_data = reinterpret_cast<const byte*>(data);
+	_size = size;
+	_version = 0;
+	_payloadSize = 0;
+	_meshes.clear();
+
+	if (_data == nullptr || _size < sizeof(uint32)) {
+		return false;
+	}
+
+	//v1は先頭が本体サイズなので、マジックと一致すればv2とみなす
+	uint32 magic = 0;
+	memcpy(&magic, _data, sizeof(magic));
+	return magic == MESH_FILE_MAGIC ? openV2() : openV1();
+}
+
+bool MeshFileReader::openV1() {
+	const uint64 headerSize = sizeof(uint32) * 4;
+	const uint64 boundsSize = sizeof(float) * 6;
+	if (_size < headerSize) {
+		return false;
+	}
+
+	uint32 counts[4] = {};
+	memcpy(counts, _data, sizeof(counts));
+
+	MeshFileMesh mesh = {};
+	mesh.vertexStride = MESH_FILE_V1_VERTEX_STRIDE;
+	mesh.vertexCount = counts[1];
+	mesh.indexCount = counts[2];
+	mesh.materialRangeCount = counts[3];
+
+	const uint64 verticesSize = static_cast<uint64>(mesh.vertexCount) * mesh.vertexStride;
+	const uint64 indicesSize = static_cast<uint64>(mesh.indexCount) * sizeof(uint32);
+	const uint64 materialSize = static_cast<uint64>(mesh.materialRangeCount) * sizeof(MeshFileMaterialRange);
+	const uint64 dataSize = headerSize + verticesSize + indicesSize + materialSize;
+	if (dataSize > _size) {
+		return false;
+	}
+
+	const byte* vertices = _data + headerSize;
+	mesh.vertices = vertices;
+	mesh.indices = vertices + verticesSize;
+	mesh.materialRanges = reinterpret_cast<const MeshFileMaterialRange*>(vertices + verticesSize + indicesSize);
+
+	//古いコンバーターが書き出したファイルはAABBを持たないので頂点の位置から求める
+	if (dataSize + boundsSize <= _size) {
+		const byte* bounds = _data + dataSize;
+		memcpy(mesh.info.boundsMin, bounds, sizeof(float) * 3);
+		memcpy(mesh.info.boundsMax, bounds + sizeof(float) * 3, sizeof(float) * 3);
+	}
+	else {
+		computeBounds(mesh);
+	}
+
+	_version = 1;
+	_payloadSize = verticesSize + indicesSize + materialSize;
+	_meshes.push_back(mesh);
+	return true;
+}
+
+bool MeshFileReader::openV2() {
+	if (_size < sizeof(MeshFileHeader)) {
+		return false;
+	}
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(_data);
+	if (header->version != MESH_FILE_VERSION || header->fileSize > _size) {
+		return false;
+	}
+
+	//範囲は足し算で比べるとあふれて通ってしまうので、残りのサイズと比べる
+	const uint64 sectionTableSize = static_cast<uint64>(header->sectionCount) * sizeof(MeshFileSection);
+	if (header->sectionTableOffset % sizeof(uint64) != 0 || header->sectionTableOffset > header->fileSize
+		|| sectionTableSize > header->fileSize - header->sectionTableOffset) {
+		return false;
+	}
+
+	//メッシュは少なくとも情報のセクションを1つ持つ。壊れたメッシュ数で巨大な配列を確保しないように、先にセクション数と比べる
+	if (header->meshCount > header->sectionCount) {
+		return false;
+	}
+
+	_meshes.resize(header->meshCount);
+
+	//メッシュごとに必須のセクションがそろっているかを数える
+	VectorArray<uint32> foundSectionMasks(header->meshCount);
+	VectorArray<uint32> lodMaterialRangeCounts(header->meshCount);
+	const MeshFileSection* sections = reinterpret_cast<const MeshFileSection*>(_data + header->sectionTableOffset);
+	for (uint32 i = 0; i < header->sectionCount; ++i) {
+		const MeshFileSection& section = sections[i];
+		if (section.offset % MESH_FILE_SECTION_ALIGNMENT != 0 || section.offset > header->fileSize || section.size > header->fileSize - section.offset
+			|| section.size != static_cast<uint64>(section.stride) * section.count || section.meshIndex >= header->meshCount) {
+			return false;
+		}
+
+		//新しいバージョンで追加された種類は読み飛ばす
+		if (section.type >= MESH_SECTION_TYPE_COUNT) {
+			continue;
+		}
+
+		MeshFileMesh& mesh = _meshes[section.meshIndex];
+		const byte* payload = _data + section.offset;
+		switch (section.type) {
+		case MESH_SECTION_INFO:
+			//vertexFormatを追加する前のファイルは情報が短いので、足りない分は0(float頂点)のままにする
+			if (section.stride < offsetof(MeshFileMeshInfo, vertexFormat) || section.count != 1) {
+				return false;
+			}
+			memcpy(&mesh.info, payload, std::min<size_t>(section.stride, sizeof(MeshFileMeshInfo)));
+			mesh.info.name[MESH_FILE_MAX_NAME_LENGTH - 1] = '\0';
+			break;
+
+		case MESH_SECTION_VERTEX:
+			mesh.vertexStride = section.stride;
+			mesh.vertexCount = section.count;
+			mesh.vertices = payload;
+			break;
+
+		case MESH_SECTION_INDEX:
+			if (section.stride != sizeof(uint16) && section.stride != sizeof(uint32)) {
+				return false;
+			}
+			mesh.indexStride = section.stride;
+			mesh.indexCount = section.count;
+			mesh.indices = payload;
+			break;
+
+		case MESH_SECTION_MATERIAL_RANGE:
+			if (section.stride != sizeof(MeshFileMaterialRange)) {
+				return false;
+			}
+			mesh.materialRangeCount = section.count;
+			mesh.materialRanges = reinterpret_cast<const MeshFileMaterialRange*>(payload);
+			break;
+
+		case MESH_SECTION_ENCODED_INDEX:
+		{
+			MeshFileEncodedIndexHeader indexHeader;
+			if (section.stride != 1 || section.size < sizeof(indexHeader)) {
+				return false;
+			}
+
+			memcpy(&indexHeader, payload, sizeof(indexHeader));
+			if (indexHeader.indexStride != sizeof(uint16) && indexHeader.indexStride != sizeof(uint32)) {
+				return false;
+			}
+
+			mesh.indexStride = indexHeader.indexStride;
+			mesh.indexCount = indexHeader.indexCount;
+			mesh.encodedIndices = payload;
+			mesh.encodedIndexSize = section.size;
+
+			//インデックスのセクションとして数え、アップロード量は戻した後の大きさにする
+			foundSectionMasks[section.meshIndex] |= 1 << MESH_SECTION_INDEX;
+			_payloadSize += static_cast<uint64>(indexHeader.indexCount) * indexHeader.indexStride;
+			continue;
+		}
+
+		case MESH_SECTION_MESHLET:
+			if (section.stride != sizeof(MeshFileMeshlet)) {
+				return false;
+			}
+			mesh.meshletCount = section.count;
+			mesh.meshlets = reinterpret_cast<const MeshFileMeshlet*>(payload);
+			break;
+
+		case MESH_SECTION_MESHLET_VERTEX:
+			if (section.stride != sizeof(uint32)) {
+				return false;
+			}
+			mesh.meshletVertexCount = section.count;
+			mesh.meshletVertices = reinterpret_cast<const uint32*>(payload);
+			break;
+
+		case MESH_SECTION_MESHLET_TRIANGLE:
+			if (section.stride != sizeof(uint32)) {
+				return false;
+			}
+			mesh.meshletTriangleCount = section.count;
+			mesh.meshletTriangles = reinterpret_cast<const uint32*>(payload);
+			break;
+
+		case MESH_SECTION_LOD:
+			if (section.stride != sizeof(MeshFileLod) || section.count >= MESH_MAX_LOD_COUNT) {
+				return false;
+			}
+			mesh.lodCount = section.count;
+			mesh.lods = reinterpret_cast<const MeshFileLod*>(payload);
+			break;
+
+		case MESH_SECTION_LOD_MATERIAL_RANGE:
+			if (section.stride != sizeof(MeshFileMaterialRange)) {
+				return false;
+			}
+			lodMaterialRangeCounts[section.meshIndex] = section.count;
+			mesh.lodMaterialRanges = reinterpret_cast<const MeshFileMaterialRange*>(payload);
+			break;
+		}
+
+		foundSectionMasks[section.meshIndex] |= 1 << section.type;
+		_payloadSize += section.size;
+	}
+
+	//符号化したインデックスはMESH_SECTION_INDEXとして数えるので、必須なのはその手前まで
+	const uint32 requiredSectionMask = (1 << MESH_SECTION_ENCODED_INDEX) - 1;
+	const uint32 meshletSectionMask = (1 << MESH_SECTION_MESHLET) | (1 << MESH_SECTION_MESHLET_VERTEX) | (1 << MESH_SECTION_MESHLET_TRIANGLE);
+	const uint32 lodSectionMask = (1 << MESH_SECTION_LOD) | (1 << MESH_SECTION_LOD_MATERIAL_RANGE);
+	for (uint32 i = 0; i < header->meshCount; ++i) {
+		const MeshFileMesh& mesh = _meshes[i];
+		const uint32 foundMeshletSections = foundSectionMasks[i] & meshletSectionMask;
+		const uint32 foundLodSections = foundSectionMasks[i] & lodSectionMask;
+		if ((foundSectionMasks[i] & requiredSectionMask) != requiredSectionMask || mesh.info.vertexFormat >= MESH_VERTEX_FORMAT_COUNT
+			|| mesh.vertexStride != getMeshVertexStride(mesh.info.vertexFormat)
+			|| (foundMeshletSections != 0 && foundMeshletSections != meshletSectionMask) || !validateMeshlets(mesh)
+			|| (foundLodSections != 0 && foundLodSections != lodSectionMask) || !validateLods(mesh, lodMaterialRangeCounts[i])) {
+			return false;
+		}
+	}
+
+	_version = MESH_FILE_VERSION;
+	return true;
+}
+
+bool MeshFileReader::validateMeshlets(const MeshFileMesh& mesh) {
+	for (uint32 i = 0; i < mesh.meshletCount; ++i) {
+		const MeshFileMeshlet& meshlet = mesh.meshlets[i];
+		if (meshlet.vertexCount > MESHLET_MAX_VERTEX_COUNT || meshlet.triangleCount > MESHLET_MAX_TRIANGLE_COUNT
+			|| static_cast<uint64>(meshlet.vertexOffset) + meshlet.vertexCount > mesh.meshletVertexCount
+			|| static_cast<uint64>(meshlet.triangleOffset) + meshlet.triangleCount > mesh.meshletTriangleCount
+			|| meshlet.materialRangeIndex >= mesh.materialRangeCount) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshFileReader::validateLods(const MeshFileMesh& mesh, uint32 lodMaterialRangeCount) {
+	if (lodMaterialRangeCount != mesh.lodCount * mesh.materialRangeCount) {
+		return false;
+	}
+
+	for (uint32 i = 0; i < lodMaterialRangeCount; ++i) {
+		const MeshFileMaterialRange& range = mesh.lodMaterialRanges[i];
+		if (static_cast<uint64>(range.indexOffset) + range.indexCount > mesh.indexCount) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshFileReader::verifyHashes() const {
+	if (_version != MESH_FILE_VERSION) {
+		return true;
+	}
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(_data);
+	const MeshFileSection* sections = reinterpret_cast<const MeshFileSection*>(_data + header->sectionTableOffset);
+	for (uint32 i = 0; i < header->sectionCount; ++i) {
+		if (computeHash(_data + sections[i].offset, sections[i].size) != sections[i].hash) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshFileReader::computeBounds(MeshFileMesh& mesh) {
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		mesh.info.boundsMin[axis] = mesh.vertexCount > 0 ? FLT_MAX : 0.0f;
+		mesh.info.boundsMax[axis] = mesh.vertexCount > 0 ? -FLT_MAX : 0.0f;
+	}
+
+	//頂点の先頭は位置
+	for (uint32 i = 0; i < mesh.vertexCount; ++i) {
+		float position[3];
+		memcpy(position, mesh.vertices + static_cast<uint64>(mesh.vertexStride) * i, sizeof(position));
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			mesh.info.boundsMin[axis] = std::min(mesh.info.boundsMin[axis], position[axis]);
+			mesh.info.boundsMax[axis] = std::max(mesh.info.boundsMax[axis], position[axis]);
+		}
+	}
+}
+
+uint64 MeshFileReader::computeHash(const void* data, uint64 size) {
+	//64ビットのFNV-1a
+	const byte* bytes = reinterpret_cast<const byte*>(data);
+	uint64 hash = 14695981039346656037ull;
+	for (uint64 i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+void MeshFileWriter::addMesh(const MeshFileMesh& mesh) {
+	_meshes.push_back(mesh);
+}
+
+bool MeshFileWriter::write(const char* filePath) const {
+	VectorArray<byte> data;
+	build(data);
+
+	std::ofstream fout(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fout) {
+		return false;
+	}
+
+	fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(fout);
+}
+
+void MeshFileWriter::build(VectorArray<byte>& outData) const {
+	const uint32 meshCount = static_cast<uint32>(_meshes.size());
+
+	//メッシュごとに情報、頂点、インデックス、マテリアルの描画範囲、メッシュレット、LODの順に並べる
+	VectorArray<MeshFileSection> sections;
+	VectorArray<const void*> payloads;
+	sections.reserve(meshCount * MESH_SECTION_TYPE_COUNT);
+	payloads.reserve(meshCount * MESH_SECTION_TYPE_COUNT);
+
+	auto addSection = [&](uint32 type, uint32 meshIndex, uint32 stride, uint32 count, const void* payload) {
+		MeshFileSection section = {};
+		section.type = type;
+		section.meshIndex = meshIndex;
+		section.stride = stride;
+		section.count = count;
+		section.size = static_cast<uint64>(stride) * count;
+		section.hash = MeshFileReader::computeHash(payload, section.size);
+		sections.push_back(section);
+		payloads.push_back(payload);
+	};
+
+	for (uint32 i = 0; i < meshCount; ++i) {
+		const MeshFileMesh& mesh = _meshes[i];
+		addSection(MESH_SECTION_INFO, i, sizeof(MeshFileMeshInfo), 1, &mesh.info);
+		addSection(MESH_SECTION_VERTEX, i, mesh.vertexStride, mesh.vertexCount, mesh.vertices);
+		if (mesh.encodedIndices != nullptr) {
+			addSection(MESH_SECTION_ENCODED_INDEX, i, 1, static_cast<uint32>(mesh.encodedIndexSize), mesh.encodedIndices);
+		}
+		else {
+			addSection(MESH_SECTION_INDEX, i, mesh.indexStride, mesh.indexCount, mesh.indices);
+		}
+		addSection(MESH_SECTION_MATERIAL_RANGE, i, sizeof(MeshFileMaterialRange), mesh.materialRangeCount, mesh.materialRanges);
+		if (mesh.meshletCount > 0) {
+			addSection(MESH_SECTION_MESHLET, i, sizeof(MeshFileMeshlet), mesh.meshletCount, mesh.meshlets);
+			addSection(MESH_SECTION_MESHLET_VERTEX, i, sizeof(uint32), mesh.meshletVertexCount, mesh.meshletVertices);
+			addSection(MESH_SECTION_MESHLET_TRIANGLE, i, sizeof(uint32), mesh.meshletTriangleCount, mesh.meshletTriangles);
+		}
+		if (mesh.lodCount > 0) {
+			addSection(MESH_SECTION_LOD, i, sizeof(MeshFileLod), mesh.lodCount, mesh.lods);
+			addSection(MESH_SECTION_LOD_MATERIAL_RANGE, i, sizeof(MeshFileMaterialRange), mesh.lodCount * mesh.materialRangeCount, mesh.lodMaterialRanges);
+		}
+	}
+
+	MeshFileHeader header = {};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.meshCount = meshCount;
+	header.sectionCount = static_cast<uint32>(sections.size());
+	header.sectionTableOffset = sizeof(MeshFileHeader);
+
+	uint64 offset = header.sectionTableOffset + sizeof(MeshFileSection) * sections.size();
+	for (auto&& section : sections) {
+		offset = alignUp(offset, MESH_FILE_SECTION_ALIGNMENT);
+		section.offset = offset;
+		offset += section.size;
+	}
+	header.fileSize = offset;
+
+	//アラインメントの隙間は0で埋める
+	outData.assign(static_cast<size_t>(header.fileSize), 0);
+	memcpy(outData.data(), &header, sizeof(header));
+	memcpy(outData.data() + header.sectionTableOffset, sections.data(), sizeof(MeshFileSection) * sections.size());
+	for (size_t i = 0; i < sections.size(); ++i) {
+		if (sections[i].size > 0) {
+			memcpy(outData.data() + sections[i].offset, payloads[i], static_cast<size_t>(sections[i].size));
+		}
+	}
+}
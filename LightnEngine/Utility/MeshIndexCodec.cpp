@@ -0,0 +1,133 @@
+#include "include/MeshIndexCodec.h"
+#include <cstring>
+
+//16ビットのインデックスで指せる頂点数
+constexpr uint32 MAX_16BIT_VERTEX_COUNT = 0x10000;
+
+static uint32 loadIndex(const byte* indices, uint32 indexStride, uint32 index) {
+	if (indexStride == sizeof(uint16)) {
+		uint16 value;
+		memcpy(&value, indices + index * sizeof(uint16), sizeof(value));
+		return value;
+	}
+
+	uint32 value;
+	memcpy(&value, indices + index * sizeof(uint32), sizeof(value));
+	return value;
+}
+
+MeshIndexDecoder::MeshIndexDecoder() :_header{}, _cursor(nullptr), _end(nullptr), _previousIndex(0), _decodedCount(0) {
+}
+
+bool MeshIndexDecoder::open(const byte* data, uint64 size) {
+	if (data == nullptr || size < sizeof(MeshFileEncodedIndexHeader)) {
+		return false;
+	}
+
+	memcpy(&_header, data, sizeof(_header));
+	_cursor = data + sizeof(_header);
+	_end = data + size;
+	_previousIndex = 0;
+	_decodedCount = 0;
+	return _header.indexStride == sizeof(uint16) || _header.indexStride == sizeof(uint32);
+}
+
+bool MeshIndexDecoder::decode(void* outIndices, uint32 indexCount) {
+	if (indexCount > _header.indexCount - _decodedCount) {
+		return false;
+	}
+
+	_decodedCount += indexCount;
+	if (_header.indexStride == sizeof(uint16)) {
+		return decodeIndices(reinterpret_cast<uint16*>(outIndices), indexCount);
+	}
+
+	return decodeIndices(reinterpret_cast<uint32*>(outIndices), indexCount);
+}
+
+template <class T>
+bool MeshIndexDecoder::decodeIndices(T* outIndices, uint32 indexCount) {
+	const byte* cursor = _cursor;
+	uint32 previousIndex = _previousIndex;
+
+	for (uint32 i = 0; i < indexCount; ++i) {
+		if (cursor >= _end) {
+			return false;
+		}
+
+		//ほとんどの差は1バイトに収まるので、続きのバイトを読むのはまれ
+		uint32 value = *cursor++;
+		if (value >= 0x80) {
+			value &= 0x7f;
+			for (uint32 shift = 7;; shift += 7) {
+				if (cursor >= _end || shift > 28) {
+					return false;
+				}
+
+				const uint32 next = *cursor++;
+				value |= (next & 0x7f) << shift;
+				if (next < 0x80) {
+					break;
+				}
+			}
+		}
+
+		//ジグザグ符号化を戻す
+		const uint32 delta = (value >> 1) ^ (0u - (value & 1));
+		previousIndex += delta;
+		outIndices[i] = static_cast<T>(previousIndex);
+	}
+
+	_cursor = cursor;
+	_previousIndex = previousIndex;
+	return true;
+}
+
+void MeshIndexCodec::encode(const void* indices, uint32 indexCount, uint32 indexStride, VectorArray<byte>& outData) {
+	MeshFileEncodedIndexHeader header;
+	header.indexCount = indexCount;
+	header.indexStride = indexStride;
+
+	//1つあたり最大5バイトだが、ほとんどは1~2バイトに収まる
+	outData.clear();
+	outData.reserve(sizeof(header) + static_cast<size_t>(indexCount) * 2);
+	outData.resize(sizeof(header));
+	memcpy(outData.data(), &header, sizeof(header));
+
+	const byte* src = reinterpret_cast<const byte*>(indices);
+	uint32 previousIndex = 0;
+	for (uint32 i = 0; i < indexCount; ++i) {
+		const uint32 index = loadIndex(src, indexStride, i);
+		const int32 delta = static_cast<int32>(index - previousIndex);
+		uint32 value = (static_cast<uint32>(delta) << 1) ^ static_cast<uint32>(delta >> 31);
+		previousIndex = index;
+
+		while (value >= 0x80) {
+			outData.push_back(static_cast<byte>(value | 0x80));
+			value >>= 7;
+		}
+		outData.push_back(static_cast<byte>(value));
+	}
+}
+
+bool MeshIndexCodec::decode(const byte* data, uint64 size, void* outIndices) {
+	MeshIndexDecoder decoder;
+	return decoder.open(data, size) && decoder.decode(outIndices, decoder.getIndexCount());
+}
+
+uint32 MeshIndexCodec::packIndices(const uint32* indices, uint32 indexCount, uint32 vertexCount, VectorArray<byte>& outIndices) {
+	const uint32 indexStride = vertexCount <= MAX_16BIT_VERTEX_COUNT ? sizeof(uint16) : sizeof(uint32);
+	outIndices.resize(static_cast<size_t>(indexCount) * indexStride);
+
+	if (indexStride == sizeof(uint32)) {
+		memcpy(outIndices.data(), indices, outIndices.size());
+		return indexStride;
+	}
+
+	for (uint32 i = 0; i < indexCount; ++i) {
+		const uint16 index = static_cast<uint16>(indices[i]);
+		memcpy(outIndices.data() + i * sizeof(uint16), &index, sizeof(index));
+	}
+
+	return indexStride;
+}
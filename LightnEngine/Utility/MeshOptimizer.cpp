@@ -0,0 +1,451 @@
+#include "include/MeshOptimizer.h"
+#include "include/MeshIndexCodec.h"
+#include "include/MeshVertexCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr uint32 INVALID_VERTEX = 0xffffffff;
+constexpr uint32 VERTEX_FETCH_LINE_SIZE = 64;
+constexpr uint32 VERTEX_FETCH_LINE_COUNT = 128;
+
+//これより少ない三角形ではクラスターを分けない。分けるたびにキャッシュが空になるので小さすぎると損になる
+constexpr uint32 MIN_SOFT_CLUSTER_TRIANGLE_COUNT = 16;
+
+//要素をFIFOキャッシュとして模擬する。ミスのたびに時刻を進め、最後に入れた時刻が容量以内なら残っているとみなす
+class FifoCacheSimulator {
+public:
+	FifoCacheSimulator(uint32 elementCount, uint32 cacheSize) :_timestamps(elementCount, 0), _time(cacheSize + 1), _cacheSize(cacheSize) {
+	}
+
+	//ミスならtrue
+	bool access(uint32 element) {
+		if (_time - _timestamps[element] <= _cacheSize) {
+			return false;
+		}
+
+		_timestamps[element] = _time++;
+		return true;
+	}
+
+	void flush() {
+		_time += _cacheSize + 1;
+	}
+
+private:
+	VectorArray<uint32> _timestamps;
+	uint32 _time;
+	uint32 _cacheSize;
+};
+
+//クラスターの並べ替えに使う面積で重み付けした中心と向き
+struct TriangleGeometry {
+	float center[3];
+	float normal[3];
+};
+
+static TriangleGeometry getTriangleGeometry(const uint32* triangle, const float* positions) {
+	const float* p0 = positions + triangle[0] * 3;
+	const float* p1 = positions + triangle[1] * 3;
+	const float* p2 = positions + triangle[2] * 3;
+	const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+	//視点から見て時計回りが表なので、左手座標系ではe1 x e2が表を向く。長さは面積の2倍
+	TriangleGeometry geometry;
+	geometry.normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	geometry.normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	geometry.normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		geometry.center[axis] = (p0[axis] + p1[axis] + p2[axis]) / 3.0f;
+	}
+
+	return geometry;
+}
+
+bool MeshOptimizer::optimizeMesh(const MeshFileMesh& mesh, const MeshOptimizeSettings& settings, OptimizedMeshData& outData, MeshFileMesh& outMesh) {
+	if (!loadIndices(mesh, outData.indices)) {
+		return false;
+	}
+
+	//圧縮頂点は位置だけfloatに戻してオーバードローの並べ替えに使う
+	VectorArray<float> positions;
+	loadPositions(mesh, positions);
+
+	//三角形はマテリアルの描画範囲の中でだけ動かす
+	uint32* indices = outData.indices.data();
+	VectorArray<uint32> cacheOptimizedIndices;
+	VectorArray<uint32> hardBoundaries;
+	for (uint32 i = 0; i < mesh.materialRangeCount; ++i) {
+		const MeshFileMaterialRange& range = mesh.materialRanges[i];
+		if (static_cast<uint64>(range.indexOffset) + range.indexCount > mesh.indexCount || range.indexOffset % 3 != 0 || range.indexCount % 3 != 0) {
+			return false;
+		}
+
+		//すでに最適化したメッシュなどでキャッシュの効率が上がらなければ元の並びのままにする
+		uint32* rangeIndices = indices + range.indexOffset;
+		const float originalAcmr = analyzeVertexCache(rangeIndices, range.indexCount, mesh.vertexCount, settings.cacheSize).acmr;
+		cacheOptimizedIndices.assign(rangeIndices, rangeIndices + range.indexCount);
+		optimizeVertexCache(cacheOptimizedIndices.data(), range.indexCount, mesh.vertexCount, settings.cacheSize, hardBoundaries);
+		if (analyzeVertexCache(cacheOptimizedIndices.data(), range.indexCount, mesh.vertexCount, settings.cacheSize).acmr >= originalAcmr) {
+			continue;
+		}
+
+		//オーバードローの並べ替えで元より悪くなるなら、キャッシュの最適化だけにとどめる
+		memcpy(rangeIndices, cacheOptimizedIndices.data(), cacheOptimizedIndices.size() * sizeof(uint32));
+		optimizeOverdraw(rangeIndices, range.indexCount, positions.data(), hardBoundaries, settings.cacheSize, settings.overdrawThreshold);
+		if (analyzeVertexCache(rangeIndices, range.indexCount, mesh.vertexCount, settings.cacheSize).acmr >= originalAcmr) {
+			memcpy(rangeIndices, cacheOptimizedIndices.data(), cacheOptimizedIndices.size() * sizeof(uint32));
+		}
+	}
+
+	//LODのインデックスはLOD0の描画範囲の後ろに並んでいるので、並べ替えずに頂点番号だけ一緒に書き換える
+	outData.vertices.assign(mesh.vertices, mesh.vertices + static_cast<uint64>(mesh.vertexStride) * mesh.vertexCount);
+	const uint32 vertexCount = optimizeVertexFetch(outData.vertices, mesh.vertexStride, indices, mesh.indexCount);
+
+	outMesh = mesh;
+	outMesh.vertexCount = vertexCount;
+	outMesh.vertices = outData.vertices.data();
+	outMesh.indexStride = sizeof(uint32);
+	outMesh.indices = outData.indices.data();
+	outMesh.encodedIndices = nullptr;
+	outMesh.encodedIndexSize = 0;
+
+	//頂点番号が変わるので元のメッシュレットは使えない。MeshletBuilderで作り直す
+	outMesh.meshletCount = 0;
+	outMesh.meshletVertexCount = 0;
+	outMesh.meshletTriangleCount = 0;
+	outMesh.meshlets = nullptr;
+	outMesh.meshletVertices = nullptr;
+	outMesh.meshletTriangles = nullptr;
+	return true;
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 cacheSize, VectorArray<uint32>& outHardBoundaries) {
+	const uint32 triangleCount = indexCount / 3;
+	outHardBoundaries.clear();
+	if (triangleCount == 0) {
+		return;
+	}
+
+	//頂点ごとに隣接する三角形を並べる
+	VectorArray<uint32> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32 i = 0; i < triangleCount * 3; ++i) {
+		++adjacencyOffsets[indices[i] + 1];
+	}
+
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+
+	VectorArray<uint32> adjacency(triangleCount * 3);
+	VectorArray<uint32> liveCounts(vertexCount, 0);
+	for (uint32 i = 0; i < triangleCount * 3; ++i) {
+		const uint32 vertex = indices[i];
+		adjacency[adjacencyOffsets[vertex] + liveCounts[vertex]++] = i / 3;
+	}
+
+	VectorArray<uint32> timestamps(vertexCount, 0);
+	VectorArray<byte> isEmitted(triangleCount, 0);
+	VectorArray<uint32> deadEnd;
+	VectorArray<uint32> candidates;
+	VectorArray<uint32> output;
+	deadEnd.reserve(triangleCount * 3);
+	output.reserve(triangleCount * 3);
+
+	uint32 time = cacheSize + 1;
+	uint32 cursor = 0;
+	uint32 fanningVertex = INVALID_VERTEX;
+	while (true) {
+		//扇の中心にする頂点が決まらなければ、まだ三角形の残る頂点まで飛ぶ。飛んだ先がキャッシュになければここで途切れる
+		if (fanningVertex == INVALID_VERTEX) {
+			while (!deadEnd.empty() && fanningVertex == INVALID_VERTEX) {
+				const uint32 vertex = deadEnd.back();
+				deadEnd.pop_back();
+				fanningVertex = liveCounts[vertex] > 0 ? vertex : INVALID_VERTEX;
+			}
+
+			while (cursor < vertexCount && fanningVertex == INVALID_VERTEX) {
+				fanningVertex = liveCounts[cursor] > 0 ? cursor : INVALID_VERTEX;
+				++cursor;
+			}
+
+			if (fanningVertex == INVALID_VERTEX) {
+				break;
+			}
+
+			const uint32 emittedTriangleCount = static_cast<uint32>(output.size() / 3);
+			const bool isCached = time - timestamps[fanningVertex] <= cacheSize;
+			if (outHardBoundaries.empty() || (!isCached && outHardBoundaries.back() != emittedTriangleCount)) {
+				outHardBoundaries.push_back(emittedTriangleCount);
+			}
+		}
+
+		//扇の中心に隣接する三角形をすべて出す
+		candidates.clear();
+		for (uint32 i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; ++i) {
+			const uint32 triangle = adjacency[i];
+			if (isEmitted[triangle]) {
+				continue;
+			}
+
+			for (uint32 corner = 0; corner < 3; ++corner) {
+				const uint32 vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveCounts[vertex];
+				if (time - timestamps[vertex] > cacheSize) {
+					timestamps[vertex] = time++;
+				}
+			}
+			isEmitted[triangle] = 1;
+		}
+
+		//扇を出し切るまでキャッシュに残る頂点のうち、最も古いものを次の中心にする
+		uint32 bestPriority = 0;
+		fanningVertex = INVALID_VERTEX;
+		for (uint32 vertex : candidates) {
+			if (liveCounts[vertex] == 0) {
+				continue;
+			}
+
+			uint32 priority = 1;
+			if (time - timestamps[vertex] + 2 * liveCounts[vertex] <= cacheSize) {
+				priority += time - timestamps[vertex];
+			}
+
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanningVertex = vertex;
+			}
+		}
+	}
+
+	memcpy(indices, output.data(), output.size() * sizeof(uint32));
+}
+
+void MeshOptimizer::optimizeOverdraw(uint32* indices, uint32 indexCount, const float* positions, const VectorArray<uint32>& hardBoundaries, uint32 cacheSize, float threshold) {
+	const uint32 triangleCount = indexCount / 3;
+	if (triangleCount == 0 || hardBoundaries.empty()) {
+		return;
+	}
+
+	uint32 vertexCount = 0;
+	for (uint32 i = 0; i < triangleCount * 3; ++i) {
+		vertexCount = std::max(vertexCount, indices[i] + 1);
+	}
+
+	//並べ替えるとクラスターの境目でキャッシュが空になる。空から始めてもACMRが全体のthreshold倍に収まった位置でクラスターを閉じる
+	const float targetAcmr = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr * threshold;
+	VectorArray<uint32> clusters;
+	FifoCacheSimulator cache(vertexCount, cacheSize);
+	for (size_t i = 0; i < hardBoundaries.size(); ++i) {
+		const uint32 start = hardBoundaries[i];
+		const uint32 end = i + 1 < hardBoundaries.size() ? hardBoundaries[i + 1] : triangleCount;
+
+		uint32 clusterStart = start;
+		uint32 clusterMissCount = 0;
+		clusters.push_back(start);
+		cache.flush();
+		for (uint32 triangle = start; triangle < end; ++triangle) {
+			for (uint32 corner = 0; corner < 3; ++corner) {
+				clusterMissCount += cache.access(indices[triangle * 3 + corner]) ? 1 : 0;
+			}
+
+			const uint32 clusterTriangleCount = triangle + 1 - clusterStart;
+			if (end - (triangle + 1) >= clusterTriangleCount && clusterTriangleCount >= MIN_SOFT_CLUSTER_TRIANGLE_COUNT
+				&& clusterMissCount <= targetAcmr * clusterTriangleCount) {
+				clusterStart = triangle + 1;
+				clusterMissCount = 0;
+				clusters.push_back(clusterStart);
+				cache.flush();
+			}
+		}
+	}
+
+	//メッシュの中心から見て外側を向くクラスターほど手前を覆いやすいので先に描く
+	const uint32 clusterCount = static_cast<uint32>(clusters.size());
+	VectorArray<TriangleGeometry> clusterGeometries(clusterCount);
+	float meshCenter[3] = {};
+	float meshArea = 0.0f;
+	for (uint32 i = 0; i < clusterCount; ++i) {
+		const uint32 end = i + 1 < clusterCount ? clusters[i + 1] : triangleCount;
+		TriangleGeometry& clusterGeometry = clusterGeometries[i];
+		clusterGeometry = {};
+
+		float clusterArea = 0.0f;
+		for (uint32 triangle = clusters[i]; triangle < end; ++triangle) {
+			const TriangleGeometry geometry = getTriangleGeometry(indices + triangle * 3, positions);
+			const float area = std::sqrt(geometry.normal[0] * geometry.normal[0] + geometry.normal[1] * geometry.normal[1] + geometry.normal[2] * geometry.normal[2]);
+			for (uint32 axis = 0; axis < 3; ++axis) {
+				clusterGeometry.center[axis] += geometry.center[axis] * area;
+				clusterGeometry.normal[axis] += geometry.normal[axis];
+				meshCenter[axis] += geometry.center[axis] * area;
+			}
+			clusterArea += area;
+		}
+
+		meshArea += clusterArea;
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			clusterGeometry.center[axis] = clusterArea > 0.0f ? clusterGeometry.center[axis] / clusterArea : 0.0f;
+		}
+	}
+
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		meshCenter[axis] = meshArea > 0.0f ? meshCenter[axis] / meshArea : 0.0f;
+	}
+
+	VectorArray<float> sortKeys(clusterCount);
+	VectorArray<uint32> clusterOrder(clusterCount);
+	for (uint32 i = 0; i < clusterCount; ++i) {
+		const TriangleGeometry& geometry = clusterGeometries[i];
+		const float normalLength = std::sqrt(geometry.normal[0] * geometry.normal[0] + geometry.normal[1] * geometry.normal[1] + geometry.normal[2] * geometry.normal[2]);
+		float key = 0.0f;
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			key += (geometry.center[axis] - meshCenter[axis]) * geometry.normal[axis];
+		}
+
+		sortKeys[i] = normalLength > 0.0f ? key / normalLength : 0.0f;
+		clusterOrder[i] = i;
+	}
+
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+	VectorArray<uint32> sortedIndices;
+	sortedIndices.reserve(triangleCount * 3);
+	for (uint32 cluster : clusterOrder) {
+		const uint32 end = cluster + 1 < clusterCount ? clusters[cluster + 1] : triangleCount;
+		sortedIndices.insert(sortedIndices.end(), indices + clusters[cluster] * 3, indices + end * 3);
+	}
+
+	memcpy(indices, sortedIndices.data(), sortedIndices.size() * sizeof(uint32));
+}
+
+uint32 MeshOptimizer::optimizeVertexFetch(VectorArray<byte>& vertices, uint32 vertexStride, uint32* indices, uint32 indexCount) {
+	const uint32 vertexCount = static_cast<uint32>(vertices.size() / vertexStride);
+	VectorArray<uint32> remap(vertexCount, INVALID_VERTEX);
+
+	uint32 remappedCount = 0;
+	for (uint32 i = 0; i < indexCount; ++i) {
+		uint32& newIndex = remap[indices[i]];
+		if (newIndex == INVALID_VERTEX) {
+			newIndex = remappedCount++;
+		}
+		indices[i] = newIndex;
+	}
+
+	VectorArray<byte> remappedVertices(static_cast<size_t>(remappedCount) * vertexStride);
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		if (remap[i] != INVALID_VERTEX) {
+			memcpy(remappedVertices.data() + static_cast<size_t>(remap[i]) * vertexStride, vertices.data() + static_cast<size_t>(i) * vertexStride, vertexStride);
+		}
+	}
+
+	vertices.swap(remappedVertices);
+	return remappedCount;
+}
+
+MeshCacheStatistics MeshOptimizer::analyzeVertexCache(const uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 cacheSize) {
+	MeshCacheStatistics statistics;
+	const uint32 triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return statistics;
+	}
+
+	FifoCacheSimulator cache(vertexCount, cacheSize);
+	VectorArray<byte> isReferenced(vertexCount, 0);
+	uint32 missCount = 0;
+	uint32 referencedCount = 0;
+	for (uint32 i = 0; i < triangleCount * 3; ++i) {
+		missCount += cache.access(indices[i]) ? 1 : 0;
+		referencedCount += isReferenced[indices[i]] ? 0 : 1;
+		isReferenced[indices[i]] = 1;
+	}
+
+	statistics.acmr = missCount / static_cast<float>(triangleCount);
+	statistics.atvr = missCount / static_cast<float>(referencedCount);
+	return statistics;
+}
+
+float MeshOptimizer::analyzeVertexFetch(const uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 vertexStride) {
+	const uint32 lineCount = static_cast<uint32>((static_cast<uint64>(vertexCount) * vertexStride + VERTEX_FETCH_LINE_SIZE - 1) / VERTEX_FETCH_LINE_SIZE);
+	FifoCacheSimulator cache(lineCount, VERTEX_FETCH_LINE_COUNT);
+	VectorArray<byte> isReferenced(vertexCount, 0);
+	uint64 fetchedSize = 0;
+	uint64 referencedSize = 0;
+
+	for (uint32 i = 0; i < indexCount; ++i) {
+		const uint32 vertex = indices[i];
+		if (!isReferenced[vertex]) {
+			isReferenced[vertex] = 1;
+			referencedSize += vertexStride;
+		}
+
+		//頂点がまたがるキャッシュラインをすべて読む
+		const uint64 begin = static_cast<uint64>(vertex) * vertexStride;
+		const uint32 firstLine = static_cast<uint32>(begin / VERTEX_FETCH_LINE_SIZE);
+		const uint32 lastLine = static_cast<uint32>((begin + vertexStride - 1) / VERTEX_FETCH_LINE_SIZE);
+		for (uint32 line = firstLine; line <= lastLine; ++line) {
+			fetchedSize += cache.access(line) ? VERTEX_FETCH_LINE_SIZE : 0;
+		}
+	}
+
+	return referencedSize > 0 ? fetchedSize / static_cast<float>(referencedSize) : 0.0f;
+}
+
+bool MeshOptimizer::loadIndices(const MeshFileMesh& mesh, VectorArray<uint32>& outIndices) {
+	outIndices.resize(mesh.indexCount);
+	if (mesh.encodedIndices != nullptr) {
+		MeshIndexDecoder decoder;
+		if (!decoder.open(mesh.encodedIndices, mesh.encodedIndexSize) || decoder.getIndexCount() != mesh.indexCount) {
+			return false;
+		}
+
+		if (decoder.getIndexStride() == sizeof(uint32)) {
+			return decoder.decode(outIndices.data(), mesh.indexCount);
+		}
+
+		VectorArray<uint16> indices16(mesh.indexCount);
+		if (!decoder.decode(indices16.data(), mesh.indexCount)) {
+			return false;
+		}
+
+		std::copy(indices16.begin(), indices16.end(), outIndices.begin());
+	}
+	else if (mesh.indexStride == sizeof(uint16)) {
+		const byte* indices = reinterpret_cast<const byte*>(mesh.indices);
+		for (uint32 i = 0; i < mesh.indexCount; ++i) {
+			uint16 index;
+			memcpy(&index, indices + i * sizeof(uint16), sizeof(index));
+			outIndices[i] = index;
+		}
+	}
+	else {
+		memcpy(outIndices.data(), mesh.indices, static_cast<size_t>(mesh.indexCount) * sizeof(uint32));
+	}
+
+	//範囲外のインデックスがあれば並べ替えの配列を壊すので受け付けない
+	for (uint32 index : outIndices) {
+		if (index >= mesh.vertexCount) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshOptimizer::loadPositions(const MeshFileMesh& mesh, VectorArray<float>& outPositions) {
+	outPositions.resize(static_cast<size_t>(mesh.vertexCount) * 3);
+	for (uint32 i = 0; i < mesh.vertexCount; ++i) {
+		const byte* vertex = mesh.vertices + static_cast<uint64>(mesh.vertexStride) * i;
+		if (mesh.info.vertexFormat == MESH_VERTEX_FORMAT_COMPACT) {
+			MeshFileFloatVertex decoded;
+			MeshVertexCodec::decodeCompactVertex(*reinterpret_cast<const MeshFileCompactVertex*>(vertex), mesh.info, decoded);
+			memcpy(&outPositions[i * 3], decoded.position, sizeof(decoded.position));
+		}
+		else {
+			memcpy(&outPositions[i * 3], vertex, sizeof(float) * 3);
+		}
+	}
+}
@@ -0,0 +1,521 @@
+#include "include/MeshSimplifier.h"
+#include "include/MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//1回のパスで縮約する辺のコストの上限を、目標の数だけ縮約したときのコストの何倍までにするか
+//パスの中では縮約した頂点の周りを動かさないので、安い辺から順に少しずつ減らす
+constexpr float PASS_ERROR_FACTOR = 1.5f;
+
+//面の平面からの距離の二乗和を表す対称行列と、足し合わせた面積
+struct Quadric {
+	double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+	double weight;
+
+	void add(const Quadric& q) {
+		a2 += q.a2; b2 += q.b2; c2 += q.c2;
+		ab += q.ab; ac += q.ac; bc += q.bc;
+		ad += q.ad; bd += q.bd; cd += q.cd;
+		d2 += q.d2;
+		weight += q.weight;
+	}
+
+	//pに動かしたときの平面からの距離の二乗の面積平均
+	double evaluate(const float* p) const {
+		const double x = p[0];
+		const double y = p[1];
+		const double z = p[2];
+		const double error = a2 * x * x + b2 * y * y + c2 * z * z
+			+ 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z) + d2;
+		return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+	}
+};
+
+//三角形の平面の二次誤差を面積で重み付けして作る
+static Quadric makeTriangleQuadric(const float* p0, const float* p1, const float* p2) {
+	const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	double normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+	const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+	Quadric q = {};
+	if (length <= 0.0) {
+		return q;
+	}
+
+	for (uint32 k = 0; k < 3; ++k) {
+		normal[k] /= length;
+	}
+
+	const double a = normal[0];
+	const double b = normal[1];
+	const double c = normal[2];
+	const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+	const double area = length * 0.5;
+	q.a2 = a * a * area; q.b2 = b * b * area; q.c2 = c * c * area;
+	q.ab = a * b * area; q.ac = a * c * area; q.bc = b * c * area;
+	q.ad = a * d * area; q.bd = b * d * area; q.cd = c * d * area;
+	q.d2 = d * d * area;
+	q.weight = area;
+	return q;
+}
+
+static void computeNormal(const float* p0, const float* p1, const float* p2, float outNormal[3]) {
+	const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	outNormal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	outNormal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	outNormal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+//継ぎ目や縁の辺の二次誤差。辺を通り面に垂直な平面からの距離で、継ぎ目の線の形が崩れないようにする
+//面積には足さないので、継ぎ目に沿って縮約したときだけ上乗せされる
+static Quadric makeEdgeQuadric(const float* p0, const float* p1, const float* p2) {
+	const double edge[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	const double faceNormal[3] = { edge[1] * e2[2] - edge[2] * e2[1], edge[2] * e2[0] - edge[0] * e2[2], edge[0] * e2[1] - edge[1] * e2[0] };
+	double normal[3] = { edge[1] * faceNormal[2] - edge[2] * faceNormal[1], edge[2] * faceNormal[0] - edge[0] * faceNormal[2], edge[0] * faceNormal[1] - edge[1] * faceNormal[0] };
+	const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+	Quadric q = {};
+	if (length <= 0.0) {
+		return q;
+	}
+
+	for (uint32 k = 0; k < 3; ++k) {
+		normal[k] /= length;
+	}
+
+	const double a = normal[0];
+	const double b = normal[1];
+	const double c = normal[2];
+	const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+	const double weight = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+	q.a2 = a * a * weight; q.b2 = b * b * weight; q.c2 = c * c * weight;
+	q.ab = a * b * weight; q.ac = a * c * weight; q.bc = b * c * weight;
+	q.ad = a * d * weight; q.bd = b * d * weight; q.cd = c * d * weight;
+	q.d2 = d * d * weight;
+	return q;
+}
+
+enum SimplifyVertexKind {
+	//周りの三角形が同じ頂点を共有する
+	SIMPLIFY_VERTEX_MANIFOLD = 0,
+
+	//UVや法線の継ぎ目の上にあり、同じ位置に2つの頂点がある。継ぎ目の辺に沿ってだけ動かせる
+	SIMPLIFY_VERTEX_SEAM,
+
+	//穴の縁、3つ以上の頂点が重なる位置、複数の範囲にまたがる頂点。動かさない
+	SIMPLIFY_VERTEX_LOCKED
+};
+
+//三角形の向きの付いた辺。位置の番号の組をキーにして、両端の頂点番号を持つ
+struct SimplifyEdge {
+	uint64 key;
+	uint32 from;
+	uint32 to;
+};
+
+//縮約の候補。fromの頂点をtoの頂点に寄せる。継ぎ目に沿った縮約では反対側の頂点もfrom2からto2に寄せる
+struct EdgeCollapse {
+	float cost;
+	uint32 from;
+	uint32 to;
+	uint32 from2;
+	uint32 to2;
+};
+
+static uint64 makeEdgeKey(uint32 p0, uint32 p1) {
+	return (static_cast<uint64>(p0) << 32) | p1;
+}
+
+//位置の組で向きの付いた辺を探す。ちょうど1つだけあるときに返す
+static const SimplifyEdge* findEdge(const VectorArray<SimplifyEdge>& edges, uint64 key) {
+	auto compare = [](const SimplifyEdge& edge, uint64 value) { return edge.key < value; };
+	const auto found = std::lower_bound(edges.begin(), edges.end(), key, compare);
+	if (found == edges.end() || found->key != key || (found + 1 != edges.end() && (found + 1)->key == key)) {
+		return nullptr;
+	}
+
+	return &*found;
+}
+
+bool MeshSimplifier::buildLods(const MeshFileMesh& mesh, const MeshLodSettings& settings, MeshLodData& outData, MeshFileMesh& outMesh) {
+	if (!MeshOptimizer::loadIndices(mesh, outData.indices)) {
+		return false;
+	}
+
+	VectorArray<float> positions;
+	MeshOptimizer::loadPositions(mesh, positions);
+
+	//すでにLODを持っていれば捨て、LOD0の描画範囲の後ろから作り直す
+	uint32 lod0IndexCount = 0;
+	uint32 lod0TriangleCount = 0;
+	for (uint32 i = 0; i < mesh.materialRangeCount; ++i) {
+		const MeshFileMaterialRange& range = mesh.materialRanges[i];
+		if (static_cast<uint64>(range.indexOffset) + range.indexCount > mesh.indexCount || range.indexOffset % 3 != 0 || range.indexCount % 3 != 0) {
+			return false;
+		}
+
+		lod0IndexCount = std::max(lod0IndexCount, range.indexOffset + range.indexCount);
+		lod0TriangleCount += range.indexCount / 3;
+	}
+
+	outData.indices.resize(lod0IndexCount);
+	outData.lods.clear();
+	outData.lodMaterialRanges.clear();
+
+	const MeshOptimizeSettings optimizeSettings;
+	VectorArray<uint32> lodIndices;
+	VectorArray<MeshFileMaterialRange> lodRanges(mesh.materialRangeCount);
+	VectorArray<uint32> hardBoundaries;
+	uint32 previousTriangleCount = lod0TriangleCount;
+	for (uint32 lodIndex = 1; lodIndex < std::min(settings.lodCount, MESH_MAX_LOD_COUNT); ++lodIndex) {
+		//誤差を積み重ねないように、毎回LOD0から減らす
+		const uint32 targetTriangleCount = static_cast<uint32>(previousTriangleCount * settings.reductionRatio);
+		const float error = simplify(outData.indices.data(), mesh.materialRanges, mesh.materialRangeCount, positions.data(), mesh.vertexCount,
+			targetTriangleCount, settings.maxError, lodIndices, lodRanges.data());
+
+		const uint32 triangleCount = static_cast<uint32>(lodIndices.size() / 3);
+		if (triangleCount == 0 || triangleCount > previousTriangleCount * settings.minReduction) {
+			break;
+		}
+
+		//LODごとに頂点キャッシュ向けに並べる。頂点はLOD0と共有するので頂点の並べ直しはしない
+		const uint32 baseIndex = static_cast<uint32>(outData.indices.size());
+		for (auto&& range : lodRanges) {
+			MeshOptimizer::optimizeVertexCache(lodIndices.data() + range.indexOffset, range.indexCount, mesh.vertexCount, optimizeSettings.cacheSize, hardBoundaries);
+			range.indexOffset += baseIndex;
+			outData.lodMaterialRanges.push_back(range);
+		}
+
+		outData.indices.insert(outData.indices.end(), lodIndices.begin(), lodIndices.end());
+		outData.lods.push_back({ error, triangleCount });
+		previousTriangleCount = triangleCount;
+	}
+
+	outMesh = mesh;
+	outMesh.indexStride = sizeof(uint32);
+	outMesh.indexCount = static_cast<uint32>(outData.indices.size());
+	outMesh.indices = outData.indices.data();
+	outMesh.encodedIndices = nullptr;
+	outMesh.encodedIndexSize = 0;
+	outMesh.lodCount = static_cast<uint32>(outData.lods.size());
+	outMesh.lods = outData.lods.data();
+	outMesh.lodMaterialRanges = outData.lodMaterialRanges.data();
+	return true;
+}
+
+float MeshSimplifier::simplify(const uint32* indices, const MeshFileMaterialRange* ranges, uint32 rangeCount, const float* positions, uint32 vertexCount,
+	uint32 targetTriangleCount, float maxError, VectorArray<uint32>& outIndices, MeshFileMaterialRange* outRanges) {
+	//誤差をAABBの対角線に対する割合で測るように、位置を対角線の長さが1になるように縮める
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			boundsMin[axis] = std::min(boundsMin[axis], positions[i * 3 + axis]);
+			boundsMax[axis] = std::max(boundsMax[axis], positions[i * 3 + axis]);
+		}
+	}
+
+	const float size[3] = { boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2] };
+	const float diagonal = std::sqrt(size[0] * size[0] + size[1] * size[1] + size[2] * size[2]);
+	const float scale = diagonal > 0.0f ? 1.0f / diagonal : 1.0f;
+	VectorArray<float> scaledPositions(static_cast<size_t>(vertexCount) * 3);
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			scaledPositions[i * 3 + axis] = (positions[i * 3 + axis] - boundsMin[axis]) * scale;
+		}
+	}
+
+	//同じ位置の頂点をまとめ、位置ごとの代表の頂点番号を引けるようにする
+	VectorArray<uint32> sortedVertices(vertexCount);
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		sortedVertices[i] = i;
+	}
+
+	auto comparePosition = [&](uint32 a, uint32 b) { return memcmp(&positions[a * 3], &positions[b * 3], sizeof(float) * 3) < 0; };
+	std::sort(sortedVertices.begin(), sortedVertices.end(), comparePosition);
+
+	VectorArray<uint32> positionIds(vertexCount);
+	VectorArray<uint32> wedgeCounts(vertexCount, 0);
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		const uint32 vertex = sortedVertices[i];
+		const bool isSamePosition = i > 0 && !comparePosition(sortedVertices[i - 1], vertex);
+		positionIds[vertex] = isSamePosition ? positionIds[sortedVertices[i - 1]] : vertex;
+		++wedgeCounts[positionIds[vertex]];
+	}
+
+	//三角形を範囲の番号と一緒に持つ。縮退した三角形は最初から除く
+	VectorArray<uint32> triangles;
+	VectorArray<uint32> triangleRanges;
+	for (uint32 rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex) {
+		for (uint32 i = ranges[rangeIndex].indexOffset; i + 3 <= ranges[rangeIndex].indexOffset + ranges[rangeIndex].indexCount; i += 3) {
+			const uint32 p0 = positionIds[indices[i]];
+			const uint32 p1 = positionIds[indices[i + 1]];
+			const uint32 p2 = positionIds[indices[i + 2]];
+			if (p0 == p1 || p1 == p2 || p2 == p0) {
+				continue;
+			}
+
+			triangles.insert(triangles.end(), indices + i, indices + i + 3);
+			triangleRanges.push_back(rangeIndex);
+		}
+	}
+
+	//頂点の種類を決める。縁(逆向きの辺と数が合わない辺)、3つ以上の頂点が重なる位置、複数の範囲にまたがる頂点は動かさない
+	VectorArray<SimplifyVertexKind> vertexKinds(vertexCount, SIMPLIFY_VERTEX_MANIFOLD);
+	VectorArray<uint32> vertexRanges(vertexCount, UINT32_MAX);
+	VectorArray<SimplifyEdge> edges;
+	auto buildEdges = [&]() {
+		edges.clear();
+		for (uint32 i = 0; i < triangles.size(); ++i) {
+			const uint32 v0 = triangles[i];
+			const uint32 v1 = triangles[i - i % 3 + (i + 1) % 3];
+			edges.push_back({ makeEdgeKey(positionIds[v0], positionIds[v1]), v0, v1 });
+		}
+
+		std::sort(edges.begin(), edges.end(), [](const SimplifyEdge& a, const SimplifyEdge& b) { return a.key < b.key; });
+	};
+
+	for (uint32 t = 0; t < triangleRanges.size(); ++t) {
+		for (uint32 corner = 0; corner < 3; ++corner) {
+			const uint32 p = positionIds[triangles[t * 3 + corner]];
+			if (wedgeCounts[p] > 2 || (vertexRanges[p] != UINT32_MAX && vertexRanges[p] != triangleRanges[t])) {
+				vertexKinds[p] = SIMPLIFY_VERTEX_LOCKED;
+			}
+			else if (wedgeCounts[p] == 2 && vertexKinds[p] == SIMPLIFY_VERTEX_MANIFOLD) {
+				vertexKinds[p] = SIMPLIFY_VERTEX_SEAM;
+			}
+			vertexRanges[p] = triangleRanges[t];
+		}
+	}
+
+	buildEdges();
+	for (const auto& edge : edges) {
+		const uint32 p0 = static_cast<uint32>(edge.key >> 32);
+		const uint32 p1 = static_cast<uint32>(edge.key);
+		if (findEdge(edges, edge.key) == nullptr || findEdge(edges, makeEdgeKey(p1, p0)) == nullptr) {
+			vertexKinds[p0] = SIMPLIFY_VERTEX_LOCKED;
+			vertexKinds[p1] = SIMPLIFY_VERTEX_LOCKED;
+		}
+	}
+
+	//位置ごとに周りの三角形の二次誤差を足しておく。継ぎ目の辺は線の形を保つ誤差も足す
+	VectorArray<Quadric> quadrics(vertexCount, Quadric());
+	for (uint32 t = 0; t < triangleRanges.size(); ++t) {
+		const uint32 p0 = positionIds[triangles[t * 3]];
+		const uint32 p1 = positionIds[triangles[t * 3 + 1]];
+		const uint32 p2 = positionIds[triangles[t * 3 + 2]];
+		const Quadric q = makeTriangleQuadric(&scaledPositions[p0 * 3], &scaledPositions[p1 * 3], &scaledPositions[p2 * 3]);
+		quadrics[p0].add(q);
+		quadrics[p1].add(q);
+		quadrics[p2].add(q);
+
+		for (uint32 corner = 0; corner < 3; ++corner) {
+			const uint32 v0 = triangles[t * 3 + corner];
+			const uint32 v1 = triangles[t * 3 + (corner + 1) % 3];
+			const uint32 e0 = positionIds[v0];
+			const uint32 e1 = positionIds[v1];
+			const SimplifyEdge* reverse = findEdge(edges, makeEdgeKey(e1, e0));
+			if (reverse == nullptr || (reverse->to == v0 && reverse->from == v1)) {
+				continue;
+			}
+
+			const uint32 e2 = positionIds[triangles[t * 3 + (corner + 2) % 3]];
+			const Quadric edgeQuadric = makeEdgeQuadric(&scaledPositions[e0 * 3], &scaledPositions[e1 * 3], &scaledPositions[e2 * 3]);
+			quadrics[e0].add(edgeQuadric);
+			quadrics[e1].add(edgeQuadric);
+		}
+	}
+
+	const double maxCost = static_cast<double>(maxError) * maxError;
+	double resultCost = 0.0;
+	VectorArray<uint32> remap(vertexCount);
+	VectorArray<bool> isTouched(vertexCount);
+	VectorArray<uint32> adjacencyOffsets(vertexCount + 1);
+	VectorArray<uint32> adjacentTriangles;
+	VectorArray<EdgeCollapse> collapses;
+	while (triangleRanges.size() > targetTriangleCount) {
+		const uint32 triangleCount = static_cast<uint32>(triangleRanges.size());
+
+		//位置ごとに隣接する三角形の一覧を作り直す
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32 i = 0; i < triangleCount * 3; ++i) {
+			++adjacencyOffsets[positionIds[triangles[i]] + 1];
+		}
+
+		for (uint32 i = 0; i < vertexCount; ++i) {
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+
+		adjacentTriangles.resize(triangleCount * 3);
+		{
+			VectorArray<uint32> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32 i = 0; i < triangleCount * 3; ++i) {
+				adjacentTriangles[cursors[positionIds[triangles[i]]]++] = i / 3;
+			}
+		}
+
+		//辺ごとに安い向きの縮約を候補にする。内側の辺は2つの三角形に逆向きで現れるので片方だけ数える
+		//継ぎ目の頂点は、両側で頂点が分かれている継ぎ目の辺に沿ってだけ、両側の頂点をそろえて寄せる
+		buildEdges();
+		collapses.clear();
+		for (uint32 i = 0; i < triangleCount * 3; ++i) {
+			const uint32 v0 = triangles[i];
+			const uint32 v1 = triangles[i - i % 3 + (i + 1) % 3];
+			const uint32 p0 = positionIds[v0];
+			const uint32 p1 = positionIds[v1];
+			if (p0 > p1 || (vertexKinds[p0] == SIMPLIFY_VERTEX_LOCKED && vertexKinds[p1] == SIMPLIFY_VERTEX_LOCKED)) {
+				continue;
+			}
+
+			const SimplifyEdge* reverse = findEdge(edges, makeEdgeKey(p1, p0));
+			const bool isSeamEdge = reverse != nullptr && reverse->to != v0 && reverse->from != v1;
+			const uint32 w0 = reverse != nullptr ? reverse->to : v0;
+			const uint32 w1 = reverse != nullptr ? reverse->from : v1;
+			auto canCollapse = [&](uint32 p) {
+				return vertexKinds[p] == SIMPLIFY_VERTEX_MANIFOLD || (vertexKinds[p] == SIMPLIFY_VERTEX_SEAM && isSeamEdge);
+			};
+
+			Quadric q = quadrics[p0];
+			q.add(quadrics[p1]);
+			const double cost01 = canCollapse(p0) ? q.evaluate(&scaledPositions[p1 * 3]) : DBL_MAX;
+			const double cost10 = canCollapse(p1) ? q.evaluate(&scaledPositions[p0 * 3]) : DBL_MAX;
+			if (cost01 == DBL_MAX && cost10 == DBL_MAX) {
+				continue;
+			}
+
+			if (cost01 <= cost10) {
+				collapses.push_back({ static_cast<float>(cost01), v0, v1, isSeamEdge ? w0 : UINT32_MAX, w1 });
+			}
+			else {
+				collapses.push_back({ static_cast<float>(cost10), v1, v0, isSeamEdge ? w1 : UINT32_MAX, w0 });
+			}
+		}
+
+		if (collapses.empty()) {
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost < b.cost; });
+
+		//1回の縮約でおよそ2つの三角形が消える
+		const size_t collapseGoal = std::min<size_t>((triangleCount - targetTriangleCount) / 2 + 1, collapses.size());
+		const double passCost = std::min(maxCost, static_cast<double>(collapses[collapseGoal - 1].cost) * PASS_ERROR_FACTOR);
+
+		for (uint32 i = 0; i < vertexCount; ++i) {
+			remap[i] = i;
+		}
+		std::fill(isTouched.begin(), isTouched.end(), false);
+
+		uint32 removedTriangleCount = 0;
+		uint32 collapseCount = 0;
+		for (const auto& collapse : collapses) {
+			if (collapse.cost > passCost || triangleCount - removedTriangleCount <= targetTriangleCount) {
+				break;
+			}
+
+			const uint32 p0 = positionIds[collapse.from];
+			const uint32 p1 = positionIds[collapse.to];
+			if (isTouched[p0] || isTouched[p1]) {
+				continue;
+			}
+
+			//p0の周りの三角形がp1に寄せたときに裏返るなら縮約しない
+			bool isFlipped = false;
+			uint32 sharedTriangleCount = 0;
+			for (uint32 k = adjacencyOffsets[p0]; k < adjacencyOffsets[p0 + 1] && !isFlipped; ++k) {
+				const uint32* triangle = &triangles[adjacentTriangles[k] * 3];
+				const uint32 corners[3] = { positionIds[triangle[0]], positionIds[triangle[1]], positionIds[triangle[2]] };
+				if (corners[0] == p1 || corners[1] == p1 || corners[2] == p1) {
+					++sharedTriangleCount;
+					continue;
+				}
+
+				const float* before[3];
+				const float* after[3];
+				for (uint32 corner = 0; corner < 3; ++corner) {
+					before[corner] = &scaledPositions[corners[corner] * 3];
+					after[corner] = corners[corner] == p0 ? &scaledPositions[p1 * 3] : before[corner];
+				}
+
+				float normalBefore[3];
+				float normalAfter[3];
+				computeNormal(before[0], before[1], before[2], normalBefore);
+				computeNormal(after[0], after[1], after[2], normalAfter);
+				isFlipped = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2] <= 0.0f;
+			}
+
+			if (isFlipped) {
+				continue;
+			}
+
+			//p0の周りの頂点はこのパスでは動かさないので、裏返りの判定が古い位置で行われることはない
+			for (uint32 k = adjacencyOffsets[p0]; k < adjacencyOffsets[p0 + 1]; ++k) {
+				const uint32* triangle = &triangles[adjacentTriangles[k] * 3];
+				for (uint32 corner = 0; corner < 3; ++corner) {
+					isTouched[positionIds[triangle[corner]]] = true;
+				}
+			}
+
+			remap[collapse.from] = collapse.to;
+			if (collapse.from2 != UINT32_MAX) {
+				remap[collapse.from2] = collapse.to2;
+			}
+			quadrics[p1].add(quadrics[p0]);
+			resultCost = std::max(resultCost, static_cast<double>(collapse.cost));
+			removedTriangleCount += sharedTriangleCount;
+			++collapseCount;
+		}
+
+		if (collapseCount == 0) {
+			break;
+		}
+
+		//寄せた頂点を差し替え、縮退した三角形を詰める
+		uint32 writeTriangle = 0;
+		for (uint32 t = 0; t < triangleCount; ++t) {
+			uint32 triangle[3];
+			for (uint32 corner = 0; corner < 3; ++corner) {
+				triangle[corner] = remap[triangles[t * 3 + corner]];
+			}
+
+			const uint32 p0 = positionIds[triangle[0]];
+			const uint32 p1 = positionIds[triangle[1]];
+			const uint32 p2 = positionIds[triangle[2]];
+			if (p0 == p1 || p1 == p2 || p2 == p0) {
+				continue;
+			}
+
+			memcpy(&triangles[writeTriangle * 3], triangle, sizeof(triangle));
+			triangleRanges[writeTriangle] = triangleRanges[t];
+			++writeTriangle;
+		}
+
+		triangles.resize(writeTriangle * 3);
+		triangleRanges.resize(writeTriangle);
+	}
+
+	//三角形は範囲の順に並んだままなので、範囲ごとの位置を数えて返す
+	outIndices.assign(triangles.begin(), triangles.end());
+	for (uint32 rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex) {
+		outRanges[rangeIndex].indexOffset = static_cast<uint32>(std::lower_bound(triangleRanges.begin(), triangleRanges.end(), rangeIndex) - triangleRanges.begin()) * 3;
+		outRanges[rangeIndex].indexCount = static_cast<uint32>(std::upper_bound(triangleRanges.begin(), triangleRanges.end(), rangeIndex) - triangleRanges.begin()) * 3 - outRanges[rangeIndex].indexOffset;
+	}
+
+	return static_cast<float>(std::sqrt(resultCost));
+}
+
+uint32 MeshSimplifier::selectLod(const MeshFileLod* lods, uint32 lodCount, float screenSize, float errorPixels) {
+	//ずれはAABBの対角線に対する割合で、境界球の直径は対角線と同じ長さなので、掛ければ画面上のずれになる
+	uint32 lodIndex = 0;
+	while (lodIndex < lodCount && lods[lodIndex].error * screenSize <= errorPixels) {
+		++lodIndex;
+	}
+
+	return lodIndex;
+}
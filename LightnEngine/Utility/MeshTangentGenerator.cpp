@@ -0,0 +1,183 @@
+#include "include/MeshTangentGenerator.h"
+#include "include/MeshVertexCodec.h"
+#include "include/MeshWelder.h"
+#include <cfloat>
+#include <cmath>
+
+//三角形ごとの計算を分ける区間の三角形数
+constexpr uint32 TANGENT_CHUNK_TRIANGLE_COUNT = 16 * 1024;
+
+static float dot3(const float a[3], const float b[3]) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//長さがなければfalseを返して0のままにする
+static bool normalize3(float v[3]) {
+	const float length = std::sqrt(dot3(v, v));
+	if (length <= FLT_MIN) {
+		v[0] = v[1] = v[2] = 0.0f;
+		return false;
+	}
+
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+	return true;
+}
+
+//法線に垂直な面に投影して正規化する
+static bool projectToPlane(const float normal[3], const float v[3], float outProjected[3]) {
+	const float d = dot3(normal, v);
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		outProjected[axis] = v[axis] - normal[axis] * d;
+	}
+
+	return normalize3(outProjected);
+}
+
+//スレッドプールがなければ区間を順に処理する
+static void forEachChunk(ThreadPool* threadPool, uint32 chunkCount, const ThreadPool::IndexedJob& job) {
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(chunkCount, job);
+		return;
+	}
+
+	for (uint32 i = 0; i < chunkCount; ++i) {
+		job(i);
+	}
+}
+
+void MeshTangentGenerator::generateTangents(MeshFileFloatVertex* polygonVertices, uint32 polygonVertexCount, ThreadPool* threadPool) {
+	const uint32 triangleCount = polygonVertexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	const uint32 chunkCount = (triangleCount + TANGENT_CHUNK_TRIANGLE_COUNT - 1) / TANGENT_CHUNK_TRIANGLE_COUNT;
+
+	//三角形ごとにuが増える向きと、UVが裏返っているかを求める
+	//裏返りはMikkTSpaceと同じく、法線と接線の外積とvが増える向きが逆を向いているかで決める。面積の符号で決めると巻き順で結果が変わる
+	//コンバーターはvを反転してから渡すので、反転後のvの向きと比べれば、裏返っていない面は符号が+1になり、これまでのファイルとシェーダーの規約と一致する
+	//UVの面積が0の三角形は向きが決まらないので、裏返っていない側にまとめる
+	VectorArray<float> faceTangents(triangleCount * 3);
+	VectorArray<byte> isMirrored(triangleCount);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(triangleCount, (chunkIndex + 1) * TANGENT_CHUNK_TRIANGLE_COUNT);
+		for (uint32 triangle = chunkIndex * TANGENT_CHUNK_TRIANGLE_COUNT; triangle < end; ++triangle) {
+			const MeshFileFloatVertex& v0 = polygonVertices[triangle * 3 + 0];
+			const MeshFileFloatVertex& v1 = polygonVertices[triangle * 3 + 1];
+			const MeshFileFloatVertex& v2 = polygonVertices[triangle * 3 + 2];
+			const float t21x = v1.texcoord[0] - v0.texcoord[0];
+			const float t21y = v1.texcoord[1] - v0.texcoord[1];
+			const float t31x = v2.texcoord[0] - v0.texcoord[0];
+			const float t31y = v2.texcoord[1] - v0.texcoord[1];
+			const float signedArea = t21x * t31y - t21y * t31x;
+
+			//面積の符号を掛けて、巻き順によらずuとvが増える向きにそろえる
+			const float areaSign = signedArea < 0.0f ? -1.0f : 1.0f;
+			float* faceTangent = &faceTangents[triangle * 3];
+			float faceBitangent[3];
+			float faceNormal[3];
+			for (uint32 axis = 0; axis < 3; ++axis) {
+				const float d1 = v1.position[axis] - v0.position[axis];
+				const float d2 = v2.position[axis] - v0.position[axis];
+				faceTangent[axis] = (t31y * d1 - t21y * d2) * areaSign;
+				faceBitangent[axis] = (t21x * d2 - t31x * d1) * areaSign;
+				faceNormal[axis] = v0.normal[axis] + v1.normal[axis] + v2.normal[axis];
+			}
+
+			normalize3(faceTangent);
+
+			float crossNormalTangent[3];
+			crossNormalTangent[0] = faceNormal[1] * faceTangent[2] - faceNormal[2] * faceTangent[1];
+			crossNormalTangent[1] = faceNormal[2] * faceTangent[0] - faceNormal[0] * faceTangent[2];
+			crossNormalTangent[2] = faceNormal[0] * faceTangent[1] - faceNormal[1] * faceTangent[0];
+			const bool isDegenerate = std::abs(signedArea) <= FLT_MIN;
+			isMirrored[triangle] = !isDegenerate && dot3(crossNormalTangent, faceBitangent) < 0.0f ? 1 : 0;
+		}
+	});
+
+	//位置、法線、UV、裏返りが一致する角をまとめる。接線の欄に裏返りを入れて頂点の結合で番号をつける
+	VectorArray<MeshFileFloatVertex> groupKeys(triangleCount * 3);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(triangleCount, (chunkIndex + 1) * TANGENT_CHUNK_TRIANGLE_COUNT) * 3;
+		for (uint32 i = chunkIndex * TANGENT_CHUNK_TRIANGLE_COUNT * 3; i < end; ++i) {
+			MeshFileFloatVertex& key = groupKeys[i];
+			key = polygonVertices[i];
+			key.tangent[0] = isMirrored[i / 3] != 0 ? -1.0f : 1.0f;
+			key.tangent[1] = 0.0f;
+			key.tangent[2] = 0.0f;
+		}
+	});
+
+	VectorArray<uint32> groupIds;
+	VectorArray<MeshFileFloatVertex> groupVertices;
+	const uint32 groupCount = MeshWelder::weldVertices(groupKeys.data(), triangleCount * 3, MeshWeldSettings(), threadPool, groupIds, groupVertices);
+	VectorArray<MeshFileFloatVertex>().swap(groupKeys);
+
+	//角ごとに三角形の接線を法線に垂直な面に投影し、角の大きさで重みをつける
+	VectorArray<float> cornerTangents(triangleCount * 9);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(triangleCount, (chunkIndex + 1) * TANGENT_CHUNK_TRIANGLE_COUNT);
+		for (uint32 triangle = chunkIndex * TANGENT_CHUNK_TRIANGLE_COUNT; triangle < end; ++triangle) {
+			const float* faceTangent = &faceTangents[triangle * 3];
+			for (uint32 corner = 0; corner < 3; ++corner) {
+				const MeshFileFloatVertex& vertex = polygonVertices[triangle * 3 + corner];
+				const MeshFileFloatVertex& next = polygonVertices[triangle * 3 + (corner + 1) % 3];
+				const MeshFileFloatVertex& previous = polygonVertices[triangle * 3 + (corner + 2) % 3];
+				float* cornerTangent = &cornerTangents[(triangle * 3 + corner) * 3];
+
+				float normal[3] = { vertex.normal[0], vertex.normal[1], vertex.normal[2] };
+				float edge1[3];
+				float edge2[3];
+				for (uint32 axis = 0; axis < 3; ++axis) {
+					edge1[axis] = next.position[axis] - vertex.position[axis];
+					edge2[axis] = previous.position[axis] - vertex.position[axis];
+				}
+
+				float tangent[3];
+				float projectedEdge1[3];
+				float projectedEdge2[3];
+				const bool isValid = normalize3(normal) && projectToPlane(normal, faceTangent, tangent)
+					&& projectToPlane(normal, edge1, projectedEdge1) && projectToPlane(normal, edge2, projectedEdge2);
+				const float cosAngle = std::max(-1.0f, std::min(1.0f, dot3(projectedEdge1, projectedEdge2)));
+				const float angle = isValid ? std::acos(cosAngle) : 0.0f;
+				for (uint32 axis = 0; axis < 3; ++axis) {
+					cornerTangent[axis] = isValid ? tangent[axis] * angle : 0.0f;
+				}
+			}
+		}
+	});
+
+	//まとめた角ごとに足す。書き込み先が重なるので順に足す
+	VectorArray<float> groupTangents(groupCount * 3);
+	for (uint32 i = 0; i < triangleCount * 3; ++i) {
+		float* groupTangent = &groupTangents[groupIds[i] * 3];
+		groupTangent[0] += cornerTangents[i * 3 + 0];
+		groupTangent[1] += cornerTangents[i * 3 + 1];
+		groupTangent[2] += cornerTangents[i * 3 + 2];
+	}
+
+	//向きが決まらなかった角は、法線に垂直で上向きに近い向きにする
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(triangleCount, (chunkIndex + 1) * TANGENT_CHUNK_TRIANGLE_COUNT) * 3;
+		for (uint32 i = chunkIndex * TANGENT_CHUNK_TRIANGLE_COUNT * 3; i < end; ++i) {
+			MeshFileFloatVertex& vertex = polygonVertices[i];
+			float normal[3] = { vertex.normal[0], vertex.normal[1], vertex.normal[2] };
+			float tangent[3];
+			if (!normalize3(normal) || !projectToPlane(normal, &groupTangents[groupIds[i] * 3], tangent)) {
+				const float up[3] = { 0.0f, 1.0f, 0.0f };
+				const float right[3] = { 1.0f, 0.0f, 0.0f };
+				const float* axis = std::abs(normal[1]) < 0.99f ? up : right;
+				tangent[0] = normal[1] * axis[2] - normal[2] * axis[1];
+				tangent[1] = normal[2] * axis[0] - normal[0] * axis[2];
+				tangent[2] = normal[0] * axis[1] - normal[1] * axis[0];
+				if (!normalize3(tangent)) {
+					tangent[0] = 1.0f;
+				}
+			}
+
+			MeshVertexCodec::setTangent(vertex, tangent, isMirrored[i / 3] != 0 ? -1.0f : 1.0f);
+		}
+	});
+}
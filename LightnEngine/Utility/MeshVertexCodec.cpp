@@ -0,0 +1,233 @@
+#include "include/MeshVertexCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr float POSITION_UNORM_MAX = 65535.0f;
+constexpr float OCTAHEDRAL_SNORM_MAX = 127.0f;
+constexpr float RADIAN_TO_DEGREE = 57.2957795f;
+
+static float length3(const float v[3]) {
+	return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+//ベクトル同士の角度(度)。どちらかが長さを持たなければ誤差なしとみなす
+//接線は長さで従法線の符号を持つので、向きだけを比べる
+static float angleBetween(const float original[3], const float decoded[3]) {
+	const float length = length3(original) * length3(decoded);
+	if (length < 1e-6f) {
+		return 0.0f;
+	}
+
+	const float cosAngle = (original[0] * decoded[0] + original[1] * decoded[1] + original[2] * decoded[2]) / length;
+	return std::acos(std::max(-1.0f, std::min(1.0f, cosAngle))) * RADIAN_TO_DEGREE;
+}
+
+bool MeshVertexError::isWithin(const MeshVertexTolerance& tolerance) const {
+	//NaNが混ざっていれば比較がすべて偽になるので圧縮しない
+	return position <= tolerance.position && normalAngle <= tolerance.normalAngle
+		&& tangentAngle <= tolerance.normalAngle && texcoord <= tolerance.texcoord;
+}
+
+bool MeshVertexCodec::encodeCompactVertices(const MeshFileFloatVertex* vertices, uint32 vertexCount, const MeshFileMeshInfo& info,
+	const MeshVertexTolerance& tolerance, VectorArray<MeshFileCompactVertex>& outVertices, MeshVertexError& outError) {
+	outVertices.resize(vertexCount);
+	outError = MeshVertexError();
+
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		const MeshFileFloatVertex& vertex = vertices[i];
+		encodeCompactVertex(vertex, info, outVertices[i]);
+
+		MeshFileFloatVertex decoded;
+		decodeCompactVertex(outVertices[i], info, decoded);
+
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			outError.position = std::max(outError.position, std::abs(decoded.position[axis] - vertex.position[axis]));
+		}
+
+		for (uint32 axis = 0; axis < 2; ++axis) {
+			outError.texcoord = std::max(outError.texcoord, std::abs(decoded.texcoord[axis] - vertex.texcoord[axis]));
+		}
+
+		outError.normalAngle = std::max(outError.normalAngle, angleBetween(vertex.normal, decoded.normal));
+		outError.tangentAngle = std::max(outError.tangentAngle, angleBetween(vertex.tangent, decoded.tangent));
+	}
+
+	//従法線の符号は1ビットでそのまま持つので誤差はない
+
+	return outError.isWithin(tolerance);
+}
+
+void MeshVertexCodec::encodeCompactVertex(const MeshFileFloatVertex& vertex, const MeshFileMeshInfo& info, MeshFileCompactVertex& outVertex) {
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		const float extent = info.boundsMax[axis] - info.boundsMin[axis];
+		const float t = extent > 0.0f ? (vertex.position[axis] - info.boundsMin[axis]) / extent : 0.0f;
+		outVertex.position[axis] = static_cast<uint16>(std::lround(std::max(0.0f, std::min(1.0f, t)) * POSITION_UNORM_MAX));
+	}
+	outVertex.position[3] = getBitangentSign(vertex) < 0.0f ? static_cast<uint16>(POSITION_UNORM_MAX) : 0;
+
+	encodeOctahedral(vertex.normal, &outVertex.normalTangent[0]);
+	encodeOctahedral(vertex.tangent, &outVertex.normalTangent[2]);
+
+	outVertex.texcoord[0] = floatToHalf(vertex.texcoord[0]);
+	outVertex.texcoord[1] = floatToHalf(vertex.texcoord[1]);
+}
+
+void MeshVertexCodec::decodeCompactVertex(const MeshFileCompactVertex& vertex, const MeshFileMeshInfo& info, MeshFileFloatVertex& outVertex) {
+	float scale[3];
+	float offset[3];
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		scale[axis] = info.boundsMax[axis] - info.boundsMin[axis];
+		offset[axis] = info.boundsMin[axis];
+		outVertex.position[axis] = vertex.position[axis] / POSITION_UNORM_MAX * scale[axis] + offset[axis];
+	}
+
+	decodeOctahedral(&vertex.normalTangent[0], outVertex.normal);
+	decodeOctahedral(&vertex.normalTangent[2], outVertex.tangent);
+	if (vertex.position[3] > POSITION_UNORM_MAX / 2) {
+		setTangent(outVertex, outVertex.tangent, -1.0f);
+	}
+
+	outVertex.texcoord[0] = halfToFloat(vertex.texcoord[0]);
+	outVertex.texcoord[1] = halfToFloat(vertex.texcoord[1]);
+}
+
+void MeshVertexCodec::getPositionDequantization(const MeshFileMeshInfo& info, float outScale[3], float outOffset[3]) {
+	const bool isCompact = info.vertexFormat == MESH_VERTEX_FORMAT_COMPACT;
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		outScale[axis] = isCompact ? info.boundsMax[axis] - info.boundsMin[axis] : 1.0f;
+		outOffset[axis] = isCompact ? info.boundsMin[axis] : 0.0f;
+	}
+}
+
+void MeshVertexCodec::encodeOctahedral(const float direction[3], signed char outEncoded[2]) {
+	//八面体に投影し、下半分は上半分の外側に折り返す
+	const float l1 = std::abs(direction[0]) + std::abs(direction[1]) + std::abs(direction[2]);
+	if (l1 <= 0.0f) {
+		outEncoded[0] = 0;
+		outEncoded[1] = 0;
+		return;
+	}
+
+	float u = direction[0] / l1;
+	float v = direction[1] / l1;
+	if (direction[2] < 0.0f) {
+		const float foldedU = (1.0f - std::abs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		const float foldedV = (1.0f - std::abs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	const float length = length3(direction);
+	const float baseU = std::floor(u * OCTAHEDRAL_SNORM_MAX);
+	const float baseV = std::floor(v * OCTAHEDRAL_SNORM_MAX);
+
+	float bestDot = -2.0f;
+	for (uint32 i = 0; i < 4; ++i) {
+		const signed char candidate[2] = {
+			static_cast<signed char>(std::max(-OCTAHEDRAL_SNORM_MAX, std::min(OCTAHEDRAL_SNORM_MAX, baseU + (i & 1)))),
+			static_cast<signed char>(std::max(-OCTAHEDRAL_SNORM_MAX, std::min(OCTAHEDRAL_SNORM_MAX, baseV + (i >> 1)))) };
+
+		float decoded[3];
+		decodeOctahedral(candidate, decoded);
+
+		const float dot = (direction[0] * decoded[0] + direction[1] * decoded[1] + direction[2] * decoded[2]) / length;
+		if (dot > bestDot) {
+			bestDot = dot;
+			outEncoded[0] = candidate[0];
+			outEncoded[1] = candidate[1];
+		}
+	}
+}
+
+void MeshVertexCodec::decodeOctahedral(const signed char encoded[2], float outDirection[3]) {
+	//SNORMの変換と同じく-128は-1にする
+	float x = std::max(encoded[0] / OCTAHEDRAL_SNORM_MAX, -1.0f);
+	float y = std::max(encoded[1] / OCTAHEDRAL_SNORM_MAX, -1.0f);
+	const float z = 1.0f - std::abs(x) - std::abs(y);
+	const float t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	const float length = std::sqrt(x * x + y * y + z * z);
+	outDirection[0] = x / length;
+	outDirection[1] = y / length;
+	outDirection[2] = z / length;
+}
+
+float MeshVertexCodec::getBitangentSign(const MeshFileFloatVertex& vertex) {
+	//長さ1と2の間で分ける
+	const float threshold = (1.0f + MESH_MIRRORED_TANGENT_LENGTH) * 0.5f;
+	return length3(vertex.tangent) > threshold ? -1.0f : 1.0f;
+}
+
+void MeshVertexCodec::setTangent(MeshFileFloatVertex& vertex, const float tangent[3], float bitangentSign) {
+	const float length = length3(tangent);
+	const float scale = length > 0.0f ? (bitangentSign < 0.0f ? MESH_MIRRORED_TANGENT_LENGTH : 1.0f) / length : 0.0f;
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		vertex.tangent[axis] = tangent[axis] * scale;
+	}
+}
+
+uint16 MeshVertexCodec::floatToHalf(float value) {
+	uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint32 sign = (bits >> 16) & 0x8000;
+	const uint32 absBits = bits & 0x7fffffff;
+
+	//無限大とNaN
+	if (absBits >= 0x7f800000) {
+		return static_cast<uint16>(sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0));
+	}
+
+	const int32 exponent = static_cast<int32>(absBits >> 23) - 127 + 15;
+	if (exponent >= 31) {
+		return static_cast<uint16>(sign | 0x7c00);
+	}
+
+	//丸めは最近接偶数。仮数の繰り上がりは指数にそのまま足される
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return static_cast<uint16>(sign);
+		}
+
+		const uint32 mantissa = (absBits & 0x7fffff) | 0x800000;
+		const uint32 shift = static_cast<uint32>(14 - exponent);
+		uint32 half = mantissa >> shift;
+		const uint32 remainder = mantissa & ((1u << shift) - 1);
+		const uint32 halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+			++half;
+		}
+
+		return static_cast<uint16>(sign | half);
+	}
+
+	uint32 half = (static_cast<uint32>(exponent) << 10) | ((absBits >> 13) & 0x3ff);
+	const uint32 remainder = absBits & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+		++half;
+	}
+
+	return static_cast<uint16>(sign | half);
+}
+
+float MeshVertexCodec::halfToFloat(uint16 value) {
+	const uint32 sign = static_cast<uint32>(value & 0x8000) << 16;
+	const uint32 exponent = (value >> 10) & 0x1f;
+	const uint32 mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		const float subnormal = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign != 0 ? -subnormal : subnormal;
+	}
+
+	const uint32 bits = exponent == 31
+		? sign | 0x7f800000 | (mantissa << 13)
+		: sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -0,0 +1,221 @@
+#include "include/MeshWelder.h"
+#include <cmath>
+#include <cstring>
+
+//量子化した属性の数。位置3、法線3、接線3、UV2
+constexpr uint32 WELD_KEY_SIZE = 11;
+
+//ハッシュの計算と振り分けを分ける区間の頂点数
+constexpr uint32 WELD_CHUNK_SIZE = 64 * 1024;
+
+//ハッシュの上位ビットで頂点をバケットに振り分ける。バケットごとのハッシュテーブルがキャッシュに収まる大きさにする
+constexpr uint32 WELD_BUCKET_BITS = 10;
+constexpr uint32 WELD_BUCKET_COUNT = 1 << WELD_BUCKET_BITS;
+constexpr uint32 WELD_BUCKET_SHIFT = 64 - WELD_BUCKET_BITS;
+
+constexpr uint32 WELD_EMPTY_SLOT = UINT32_MAX;
+
+struct WeldItem {
+	uint64 hash;
+	uint32 index;
+};
+
+//比較とハッシュに使う値。間隔が0ならfloatのビット列をそのまま使う
+static uint32 quantizeValue(float value, float epsilon) {
+	if (epsilon > 0.0f) {
+		const float quantized = std::floor(value / epsilon + 0.5f);
+		const float clamped = quantized < -2147483648.0f ? -2147483648.0f : (quantized > 2147483520.0f ? 2147483520.0f : quantized);
+		return static_cast<uint32>(static_cast<int32>(clamped));
+	}
+
+	//+0と-0はビット列が違うので揃える
+	if (value == 0.0f) {
+		return 0;
+	}
+
+	uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static void makeWeldKey(const MeshFileFloatVertex& vertex, const MeshWeldSettings& settings, uint32* outKey) {
+	for (uint32 i = 0; i < 3; ++i) {
+		outKey[i] = quantizeValue(vertex.position[i], settings.positionEpsilon);
+		outKey[3 + i] = quantizeValue(vertex.normal[i], settings.normalEpsilon);
+		outKey[6 + i] = quantizeValue(vertex.tangent[i], settings.tangentEpsilon);
+	}
+
+	outKey[9] = quantizeValue(vertex.texcoord[0], settings.texcoordEpsilon);
+	outKey[10] = quantizeValue(vertex.texcoord[1], settings.texcoordEpsilon);
+}
+
+//64ビットのFNV-1aを属性ごとに回し、MurmurHash3の最後の混ぜ方でバケットとスロットに使うビットを偏らせない
+static uint64 hashWeldKey(const uint32* key) {
+	uint64 hash = 14695981039346656037ull;
+	for (uint32 i = 0; i < WELD_KEY_SIZE; ++i) {
+		hash ^= key[i];
+		hash *= 1099511628211ull;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+//スレッドプールがなければ区間を順に処理する
+static void forEachChunk(ThreadPool* threadPool, uint32 chunkCount, const ThreadPool::IndexedJob& job) {
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(chunkCount, job);
+		return;
+	}
+
+	for (uint32 i = 0; i < chunkCount; ++i) {
+		job(i);
+	}
+}
+
+//ハッシュの上位ビットで1回だけ基数ソートする。区間ごとに数えてから区間の順に書き込む位置を決めるので、並列でも安定になる
+//outBucketOffsetsにはバケットごとの先頭を終端を含めて入れる
+static void partitionWeldItems(const VectorArray<WeldItem>& items, uint32 chunkCount, ThreadPool* threadPool,
+	VectorArray<WeldItem>& outItems, VectorArray<uint32>& outBucketOffsets) {
+	const uint32 itemCount = static_cast<uint32>(items.size());
+	VectorArray<uint32> chunkOffsets(chunkCount * WELD_BUCKET_COUNT);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		uint32* counts = &chunkOffsets[chunkIndex * WELD_BUCKET_COUNT];
+		const uint32 end = std::min(itemCount, (chunkIndex + 1) * WELD_CHUNK_SIZE);
+		for (uint32 i = chunkIndex * WELD_CHUNK_SIZE; i < end; ++i) {
+			++counts[items[i].hash >> WELD_BUCKET_SHIFT];
+		}
+	});
+
+	outBucketOffsets.resize(WELD_BUCKET_COUNT + 1);
+	uint32 offset = 0;
+	for (uint32 bucket = 0; bucket < WELD_BUCKET_COUNT; ++bucket) {
+		outBucketOffsets[bucket] = offset;
+		for (uint32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+			uint32& count = chunkOffsets[chunkIndex * WELD_BUCKET_COUNT + bucket];
+			const uint32 chunkItemCount = count;
+			count = offset;
+			offset += chunkItemCount;
+		}
+	}
+	outBucketOffsets[WELD_BUCKET_COUNT] = offset;
+
+	outItems.resize(itemCount);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		uint32* offsets = &chunkOffsets[chunkIndex * WELD_BUCKET_COUNT];
+		const uint32 end = std::min(itemCount, (chunkIndex + 1) * WELD_CHUNK_SIZE);
+		for (uint32 i = chunkIndex * WELD_CHUNK_SIZE; i < end; ++i) {
+			outItems[offsets[items[i].hash >> WELD_BUCKET_SHIFT]++] = items[i];
+		}
+	});
+}
+
+uint32 MeshWelder::weldVertices(const MeshFileFloatVertex* vertices, uint32 vertexCount, const MeshWeldSettings& settings, ThreadPool* threadPool,
+	VectorArray<uint32>& outRemap, VectorArray<MeshFileFloatVertex>& outVertices) {
+	outRemap.resize(vertexCount);
+	outVertices.clear();
+	if (vertexCount == 0) {
+		return 0;
+	}
+
+	const uint32 chunkCount = (vertexCount + WELD_CHUNK_SIZE - 1) / WELD_CHUNK_SIZE;
+	VectorArray<WeldItem> items(vertexCount);
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(vertexCount, (chunkIndex + 1) * WELD_CHUNK_SIZE);
+		uint32 key[WELD_KEY_SIZE];
+		for (uint32 i = chunkIndex * WELD_CHUNK_SIZE; i < end; ++i) {
+			makeWeldKey(vertices[i], settings, key);
+			items[i].hash = hashWeldKey(key);
+			items[i].index = i;
+		}
+	});
+
+	//安定に振り分けるので、バケットの中では元の頂点番号の小さい順に並ぶ
+	VectorArray<WeldItem> bucketItems;
+	VectorArray<uint32> bucketOffsets;
+	partitionWeldItems(items, chunkCount, threadPool, bucketItems, bucketOffsets);
+	VectorArray<WeldItem>().swap(items);
+
+	//バケットごとに開番地法のハッシュテーブルで、ハッシュが一致した頂点のうち最初に現れた頂点を代表にする
+	//頂点をあちこち読まないように、ここではハッシュだけを比べる
+	VectorArray<uint32>& representatives = outRemap;
+	forEachChunk(threadPool, WELD_BUCKET_COUNT, [&](uint32 bucket) {
+		const uint32 begin = bucketOffsets[bucket];
+		const uint32 end = bucketOffsets[bucket + 1];
+		if (begin == end) {
+			return;
+		}
+
+		uint32 tableSize = 16;
+		while (tableSize < (end - begin) * 2) {
+			tableSize *= 2;
+		}
+
+		const WeldItem emptySlot = { 0, WELD_EMPTY_SLOT };
+		VectorArray<WeldItem> table(tableSize, emptySlot);
+		for (uint32 i = begin; i < end; ++i) {
+			const WeldItem& item = bucketItems[i];
+			uint32 slot = static_cast<uint32>(item.hash) & (tableSize - 1);
+			while (true) {
+				WeldItem& entry = table[slot];
+				if (entry.index == WELD_EMPTY_SLOT) {
+					entry = item;
+					representatives[item.index] = item.index;
+					break;
+				}
+
+				if (entry.hash == item.hash) {
+					representatives[item.index] = entry.index;
+					break;
+				}
+
+				slot = (slot + 1) & (tableSize - 1);
+			}
+		}
+	});
+
+	//頂点の順に代表と属性を比べて確かめる。ハッシュが衝突して一致しなければまとめずに自分を代表にする
+	//代表は近くに現れることが多いので、ハッシュテーブルの中で比べるより読み込みが少ない
+	forEachChunk(threadPool, chunkCount, [&](uint32 chunkIndex) {
+		const uint32 end = std::min(vertexCount, (chunkIndex + 1) * WELD_CHUNK_SIZE);
+		for (uint32 i = chunkIndex * WELD_CHUNK_SIZE; i < end; ++i) {
+			const uint32 representative = representatives[i];
+			if (representative != i && !isEqualVertex(vertices[representative], vertices[i], settings)) {
+				representatives[i] = i;
+			}
+		}
+	});
+
+	//代表は自分より前に現れるので、前から順に番号をつければ代表の番号は決まっている
+	uint32 weldedVertexCount = 0;
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		weldedVertexCount += representatives[i] == i ? 1 : 0;
+	}
+
+	outVertices.resize(weldedVertexCount);
+	uint32 vertexIndex = 0;
+	for (uint32 i = 0; i < vertexCount; ++i) {
+		const uint32 representative = representatives[i];
+		if (representative == i) {
+			outVertices[vertexIndex] = vertices[i];
+			outRemap[i] = vertexIndex++;
+		}
+		else {
+			outRemap[i] = outRemap[representative];
+		}
+	}
+
+	return weldedVertexCount;
+}
+
+bool MeshWelder::isEqualVertex(const MeshFileFloatVertex& a, const MeshFileFloatVertex& b, const MeshWeldSettings& settings) {
+	uint32 keyA[WELD_KEY_SIZE];
+	uint32 keyB[WELD_KEY_SIZE];
+	makeWeldKey(a, settings, keyA);
+	makeWeldKey(b, settings, keyB);
+	return memcmp(keyA, keyB, sizeof(keyA)) == 0;
+}
@@ -0,0 +1,334 @@
+#include "include/MeshletBuilder.h"
+#include "include/MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+constexpr byte INVALID_LOCAL_VERTEX = 0xff;
+
+//コーンの開き角がこれ以上(内積がこれ以下)だと裏面で除外できる位置がほとんどないので判定しない
+constexpr float MIN_CONE_DOT = 0.0f;
+
+//メッシュレットを広げるときに、増える頂点1つに対して向きのずれ(1 - cos)をどれだけ重く見るか
+constexpr float CONE_WEIGHT = 0.5f;
+
+static float dot3(const float a[3], const float b[3]) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//三角形の表の向きを正規化して求める。視点から見て時計回りが表なので、左手座標系ではe1 x e2が表を向く
+//面積を持たない三角形は0を返す
+static void computeTriangleNormal(const float* positions, const uint32* triangle, float outNormal[3]) {
+	const float* v0 = positions + static_cast<size_t>(triangle[0]) * 3;
+	const float* v1 = positions + static_cast<size_t>(triangle[1]) * 3;
+	const float* v2 = positions + static_cast<size_t>(triangle[2]) * 3;
+	const float e1[3] = { v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2] };
+	const float e2[3] = { v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2] };
+	outNormal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	outNormal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	outNormal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+	const float length = std::sqrt(dot3(outNormal, outNormal));
+	for (uint32 k = 0; k < 3; ++k) {
+		outNormal[k] = length > 0.0f ? outNormal[k] / length : 0.0f;
+	}
+}
+
+static float distanceSquared(const float a[3], const float b[3]) {
+	const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+	return dot3(d, d);
+}
+
+void MeshletCullingStatistics::add(const MeshletCullingStatistics& statistics) {
+	meshletCount += statistics.meshletCount;
+	frustumCulledMeshletCount += statistics.frustumCulledMeshletCount;
+	backfaceCulledMeshletCount += statistics.backfaceCulledMeshletCount;
+	triangleCount += statistics.triangleCount;
+	frustumCulledTriangleCount += statistics.frustumCulledTriangleCount;
+	backfaceCulledTriangleCount += statistics.backfaceCulledTriangleCount;
+}
+
+bool MeshletBuilder::buildMeshlets(const MeshFileMesh& mesh, MeshletData& outData) {
+	VectorArray<uint32> indices;
+	if (!MeshOptimizer::loadIndices(mesh, indices)) {
+		return false;
+	}
+
+	VectorArray<float> positions;
+	MeshOptimizer::loadPositions(mesh, positions);
+
+	outData.meshlets.clear();
+	outData.vertices.clear();
+	outData.triangles.clear();
+
+	//メッシュの頂点番号からメッシュレット内の番号を引く。閉じるたびに使った頂点だけ戻す
+	VectorArray<byte> localVertices(mesh.vertexCount, INVALID_LOCAL_VERTEX);
+	MeshFileMeshlet meshlet = {};
+	float meshletNormal[3] = {};
+
+	auto closeMeshlet = [&]() {
+		if (meshlet.triangleCount == 0) {
+			return;
+		}
+
+		for (uint32 i = 0; i < meshlet.vertexCount; ++i) {
+			localVertices[outData.vertices[meshlet.vertexOffset + i]] = INVALID_LOCAL_VERTEX;
+		}
+
+		computeBounds(meshlet, outData, positions.data());
+		outData.meshlets.push_back(meshlet);
+
+		const uint32 materialRangeIndex = meshlet.materialRangeIndex;
+		meshlet = {};
+		meshlet.vertexOffset = static_cast<uint32>(outData.vertices.size());
+		meshlet.triangleOffset = static_cast<uint32>(outData.triangles.size());
+		meshlet.materialRangeIndex = materialRangeIndex;
+		meshletNormal[0] = meshletNormal[1] = meshletNormal[2] = 0.0f;
+	};
+
+	//三角形を加えたときに増える頂点の数。縮退した三角形は同じ頂点を複数回指すので重複を数えない
+	auto countNewVertices = [&](const uint32* triangle) {
+		uint32 newVertexCount = 0;
+		for (uint32 corner = 0; corner < 3; ++corner) {
+			const bool isDuplicated = (corner > 0 && triangle[corner] == triangle[0]) || (corner > 1 && triangle[corner] == triangle[1]);
+			newVertexCount += localVertices[triangle[corner]] == INVALID_LOCAL_VERTEX && !isDuplicated ? 1 : 0;
+		}
+		return newVertexCount;
+	};
+
+	for (uint32 rangeIndex = 0; rangeIndex < mesh.materialRangeCount; ++rangeIndex) {
+		const MeshFileMaterialRange& range = mesh.materialRanges[rangeIndex];
+		if (static_cast<uint64>(range.indexOffset) + range.indexCount > mesh.indexCount) {
+			return false;
+		}
+
+		closeMeshlet();
+		meshlet.materialRangeIndex = rangeIndex;
+
+		const uint32* rangeIndices = &indices[range.indexOffset];
+		const uint32 triangleCount = range.indexCount / 3;
+
+		//範囲内の三角形の向きと、頂点ごとに隣接する三角形の一覧
+		VectorArray<float> normals(triangleCount * 3);
+		for (uint32 i = 0; i < triangleCount; ++i) {
+			computeTriangleNormal(positions.data(), &rangeIndices[i * 3], &normals[i * 3]);
+		}
+
+		VectorArray<uint32> adjacencyOffsets(mesh.vertexCount + 1, 0);
+		for (uint32 i = 0; i < triangleCount * 3; ++i) {
+			++adjacencyOffsets[rangeIndices[i] + 1];
+		}
+
+		for (uint32 i = 0; i < mesh.vertexCount; ++i) {
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+
+		VectorArray<uint32> adjacentTriangles(triangleCount * 3);
+		VectorArray<uint32> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32 i = 0; i < triangleCount * 3; ++i) {
+			adjacentTriangles[adjacencyCursors[rangeIndices[i]]++] = i / 3;
+		}
+
+		//メッシュレットの頂点に隣接する三角形から、増える頂点が少なく向きがそろうものを選んで広げる
+		//隣接する三角形がなくなったらインデックスの並び順で次の三角形から始める
+		VectorArray<bool> isEmitted(triangleCount, false);
+		uint32 seedTriangle = 0;
+		for (uint32 emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+			uint32 bestTriangle = UINT32_MAX;
+			float bestScore = FLT_MAX;
+			const float normalLength = std::sqrt(dot3(meshletNormal, meshletNormal));
+			for (uint32 i = 0; i < meshlet.vertexCount; ++i) {
+				const uint32 vertex = outData.vertices[meshlet.vertexOffset + i];
+				for (uint32 k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; ++k) {
+					const uint32 triangle = adjacentTriangles[k];
+					if (isEmitted[triangle]) {
+						continue;
+					}
+
+					const float normalDot = normalLength > 0.0f ? dot3(&normals[triangle * 3], meshletNormal) / normalLength : 1.0f;
+					const float score = countNewVertices(&rangeIndices[triangle * 3]) + (1.0f - normalDot) * CONE_WEIGHT;
+					if (score < bestScore) {
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+
+			if (bestTriangle == UINT32_MAX) {
+				while (isEmitted[seedTriangle]) {
+					++seedTriangle;
+				}
+				bestTriangle = seedTriangle;
+			}
+
+			const uint32* triangle = &rangeIndices[bestTriangle * 3];
+			if (meshlet.vertexCount + countNewVertices(triangle) > MESHLET_MAX_VERTEX_COUNT || meshlet.triangleCount + 1u > MESHLET_MAX_TRIANGLE_COUNT) {
+				closeMeshlet();
+			}
+
+			uint32 localTriangle[3];
+			for (uint32 corner = 0; corner < 3; ++corner) {
+				byte& localVertex = localVertices[triangle[corner]];
+				if (localVertex == INVALID_LOCAL_VERTEX) {
+					localVertex = static_cast<byte>(meshlet.vertexCount++);
+					outData.vertices.push_back(triangle[corner]);
+				}
+				localTriangle[corner] = localVertex;
+			}
+
+			for (uint32 k = 0; k < 3; ++k) {
+				meshletNormal[k] += normals[bestTriangle * 3 + k];
+			}
+
+			isEmitted[bestTriangle] = true;
+			outData.triangles.push_back(packMeshletTriangle(localTriangle[0], localTriangle[1], localTriangle[2]));
+			++meshlet.triangleCount;
+		}
+	}
+
+	closeMeshlet();
+	return true;
+}
+
+void MeshletBuilder::setMeshlets(const MeshletData& data, MeshFileMesh& mesh) {
+	mesh.meshletCount = static_cast<uint32>(data.meshlets.size());
+	mesh.meshletVertexCount = static_cast<uint32>(data.vertices.size());
+	mesh.meshletTriangleCount = static_cast<uint32>(data.triangles.size());
+	mesh.meshlets = data.meshlets.data();
+	mesh.meshletVertices = data.vertices.data();
+	mesh.meshletTriangles = data.triangles.data();
+}
+
+MeshletCullingResult MeshletBuilder::cullMeshlet(const MeshFileMeshlet& meshlet, const MeshletCullingView& view) {
+	const float toCenter[3] = {
+		meshlet.center[0] - view.cameraPosition[0],
+		meshlet.center[1] - view.cameraPosition[1],
+		meshlet.center[2] - view.cameraPosition[2] };
+
+	//境界球が1つでも平面の外側にあれば見えない
+	for (uint32 i = 0; i < 4; ++i) {
+		if (dot3(view.frustumPlanes[i], toCenter) < -meshlet.radius) {
+			return MESHLET_FRUSTUM_CULLED;
+		}
+	}
+
+	//境界球のどこから見てもコーン内のすべての向きが視線と同じ側を向いていれば、すべての三角形が裏を向いている
+	if (view.isBackfaceCullingEnabled && meshlet.coneCutoff < 1.0f) {
+		const float distance = std::sqrt(dot3(toCenter, toCenter));
+		if (dot3(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius) {
+			return MESHLET_BACKFACE_CULLED;
+		}
+	}
+
+	return MESHLET_VISIBLE;
+}
+
+void MeshletBuilder::cullMeshlets(const MeshFileMeshlet* meshlets, uint32 meshletCount, const MeshletCullingView& view, MeshletCullingStatistics& outStatistics) {
+	for (uint32 i = 0; i < meshletCount; ++i) {
+		const MeshFileMeshlet& meshlet = meshlets[i];
+		++outStatistics.meshletCount;
+		outStatistics.triangleCount += meshlet.triangleCount;
+
+		switch (cullMeshlet(meshlet, view)) {
+		case MESHLET_FRUSTUM_CULLED:
+			++outStatistics.frustumCulledMeshletCount;
+			outStatistics.frustumCulledTriangleCount += meshlet.triangleCount;
+			break;
+
+		case MESHLET_BACKFACE_CULLED:
+			++outStatistics.backfaceCulledMeshletCount;
+			outStatistics.backfaceCulledTriangleCount += meshlet.triangleCount;
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void MeshletBuilder::computeBounds(MeshFileMeshlet& meshlet, const MeshletData& data, const float* positions) {
+	const uint32* vertices = &data.vertices[meshlet.vertexOffset];
+	auto getPosition = [&](uint32 localVertex) { return positions + static_cast<size_t>(vertices[localVertex]) * 3; };
+
+	//境界球はRitterの方法で求める。各軸で最も離れた2点から始め、外れた頂点を含むように広げる
+	uint32 extremes[6] = {};
+	for (uint32 i = 1; i < meshlet.vertexCount; ++i) {
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			extremes[axis * 2] = getPosition(i)[axis] < getPosition(extremes[axis * 2])[axis] ? i : extremes[axis * 2];
+			extremes[axis * 2 + 1] = getPosition(i)[axis] > getPosition(extremes[axis * 2 + 1])[axis] ? i : extremes[axis * 2 + 1];
+		}
+	}
+
+	uint32 widestAxis = 0;
+	for (uint32 axis = 1; axis < 3; ++axis) {
+		if (distanceSquared(getPosition(extremes[axis * 2]), getPosition(extremes[axis * 2 + 1]))
+			> distanceSquared(getPosition(extremes[widestAxis * 2]), getPosition(extremes[widestAxis * 2 + 1]))) {
+			widestAxis = axis;
+		}
+	}
+
+	const float* p0 = getPosition(extremes[widestAxis * 2]);
+	const float* p1 = getPosition(extremes[widestAxis * 2 + 1]);
+	float center[3] = { (p0[0] + p1[0]) * 0.5f, (p0[1] + p1[1]) * 0.5f, (p0[2] + p1[2]) * 0.5f };
+	float radius = std::sqrt(distanceSquared(p0, p1)) * 0.5f;
+	for (uint32 i = 0; i < meshlet.vertexCount; ++i) {
+		const float* p = getPosition(i);
+		const float distance = std::sqrt(distanceSquared(p, center));
+		if (distance > radius) {
+			const float newRadius = (radius + distance) * 0.5f;
+			const float t = (newRadius - radius) / distance;
+			for (uint32 axis = 0; axis < 3; ++axis) {
+				center[axis] += (p[axis] - center[axis]) * t;
+			}
+			radius = newRadius;
+		}
+	}
+
+	memcpy(meshlet.center, center, sizeof(center));
+	meshlet.radius = radius;
+
+	//コーンの軸は三角形の表の向きの平均。面積を持たない三角形は向きがないので除く
+	VectorArray<float> normals;
+	normals.reserve(meshlet.triangleCount * 3);
+	float axis[3] = {};
+	for (uint32 i = 0; i < meshlet.triangleCount; ++i) {
+		const uint32 packedTriangle = data.triangles[meshlet.triangleOffset + i];
+		const uint32 triangle[3] = {
+			vertices[packedTriangle & 0xff],
+			vertices[(packedTriangle >> 8) & 0xff],
+			vertices[(packedTriangle >> 16) & 0xff] };
+
+		float normal[3];
+		computeTriangleNormal(positions, triangle, normal);
+		if (dot3(normal, normal) <= 0.0f) {
+			continue;
+		}
+
+		for (uint32 k = 0; k < 3; ++k) {
+			axis[k] += normal[k];
+			normals.push_back(normal[k]);
+		}
+	}
+
+	meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+	meshlet.coneCutoff = 1.0f;
+
+	const float axisLength = std::sqrt(dot3(axis, axis));
+	if (normals.empty() || axisLength <= 0.0f) {
+		return;
+	}
+
+	float minDot = 1.0f;
+	for (uint32 k = 0; k < 3; ++k) {
+		meshlet.coneAxis[k] = axis[k] / axisLength;
+	}
+
+	for (size_t i = 0; i < normals.size(); i += 3) {
+		minDot = std::min(minDot, dot3(&normals[i], meshlet.coneAxis));
+	}
+
+	if (minDot > MIN_CONE_DOT) {
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
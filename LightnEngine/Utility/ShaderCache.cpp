@@ -0,0 +1,420 @@
+#include "include/ShaderCache.h"
+#include "include/AssetCooker.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+ShaderCache* Singleton<ShaderCache>::_singleton = 0;
+
+//キャッシュファイルはヘッダーに続けてエントリーを並べる
+//エントリーは識別のハッシュ、キー、内容のハッシュ、バイトコード、リフレクション結果の順
+struct ShaderCacheHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 entryCount;
+	uint32 reserved;
+};
+
+static bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static uint64 hashString(const String& value, uint64 hash) {
+	//長さも混ぜて、区切りの位置が違う並びを区別する
+	const uint64 length = value.size();
+	hash = AssetCooker::computeHash(&length, sizeof(length), hash);
+	return AssetCooker::computeHash(value.data(), length, hash);
+}
+
+bool ShaderSourceScanner::scan(const String& filePath, const ShaderSourceReader& reader, VectorArray<ShaderSourceFile>& outFiles) {
+	outFiles.clear();
+
+	VectorArray<byte> source;
+	if (!reader(filePath, source)) {
+		return false;
+	}
+
+	const String normalizedFilePath = normalizePath(filePath);
+	outFiles.push_back({ normalizedFilePath, AssetCooker::computeHash(source.data(), source.size()) });
+
+	//たどるファイルとその内容。同じファイルは1回だけたどる
+	VectorArray<std::pair<String, VectorArray<byte>>> stack;
+	stack.emplace_back(normalizedFilePath, std::move(source));
+	VectorArray<String> fileNames;
+	while (!stack.empty()) {
+		const String directory = getDirectory(stack.back().first);
+		const VectorArray<byte> data = std::move(stack.back().second);
+		stack.pop_back();
+
+		fileNames.clear();
+		findIncludes(reinterpret_cast<const char*>(data.data()), data.size(), fileNames);
+		for (const auto& fileName : fileNames) {
+			String includePath = normalizePath(directory + fileName);
+			VectorArray<byte> includeSource;
+			bool isFound = reader(includePath, includeSource);
+			if (!isFound) {
+				includePath = normalizePath(fileName);
+				isFound = reader(includePath, includeSource);
+			}
+
+			const bool isVisited = std::any_of(outFiles.begin(), outFiles.end(), [&includePath](const ShaderSourceFile& file) { return file.path == includePath; });
+			if (isVisited) {
+				continue;
+			}
+
+			outFiles.push_back({ includePath, isFound ? AssetCooker::computeHash(includeSource.data(), includeSource.size()) : 0 });
+			if (isFound) {
+				stack.emplace_back(includePath, std::move(includeSource));
+			}
+		}
+	}
+
+	return true;
+}
+
+void ShaderSourceScanner::findIncludes(const char* source, uint64 size, VectorArray<String>& outFileNames) {
+	const char* current = source;
+	const char* end = source + size;
+
+	//行頭から空白とコメント以外が現れる前か
+	bool isLineStart = true;
+	while (current < end) {
+		const char c = *current;
+		if (c == '\n') {
+			isLineStart = true;
+			++current;
+			continue;
+		}
+
+		if (c == '/' && current + 1 < end && current[1] == '/') {
+			while (current < end && *current != '\n') {
+				++current;
+			}
+			continue;
+		}
+
+		if (c == '/' && current + 1 < end && current[1] == '*') {
+			current += 2;
+			while (current < end && !(current[0] == '*' && current + 1 < end && current[1] == '/')) {
+				++current;
+			}
+			current = std::min(current + 2, end);
+			continue;
+		}
+
+		if (isSpace(c)) {
+			++current;
+			continue;
+		}
+
+		if (c != '#' || !isLineStart) {
+			isLineStart = false;
+			++current;
+			continue;
+		}
+
+		//'#'と命令の間の空白は許す
+		isLineStart = false;
+		++current;
+		while (current < end && (*current == ' ' || *current == '\t')) {
+			++current;
+		}
+
+		const uint64 directiveLength = 7;
+		if (static_cast<uint64>(end - current) < directiveLength || strncmp(current, "include", directiveLength) != 0) {
+			continue;
+		}
+
+		current += directiveLength;
+		while (current < end && (*current == ' ' || *current == '\t')) {
+			++current;
+		}
+
+		if (current == end || (*current != '"' && *current != '<')) {
+			continue;
+		}
+
+		const char terminator = *current == '"' ? '"' : '>';
+		const char* nameBegin = ++current;
+		while (current < end && *current != terminator && *current != '\n') {
+			++current;
+		}
+
+		if (current < end && *current == terminator && current > nameBegin) {
+			outFileNames.emplace_back(nameBegin, current - nameBegin);
+			++current;
+		}
+	}
+}
+
+String ShaderSourceScanner::normalizePath(const String& filePath) {
+	VectorArray<String> segments;
+	size_t begin = 0;
+	while (begin <= filePath.size()) {
+		size_t end = filePath.find_first_of("/\\", begin);
+		if (end == String::npos) {
+			end = filePath.size();
+		}
+
+		const String segment = filePath.substr(begin, end - begin);
+		if (segment == "..") {
+			//先頭の".."は戻れないので残す
+			if (!segments.empty() && segments.back() != "..") {
+				segments.pop_back();
+			}
+			else {
+				segments.push_back(segment);
+			}
+		}
+		else if (!segment.empty() && segment != ".") {
+			segments.push_back(segment);
+		}
+
+		begin = end + 1;
+	}
+
+	//絶対パスの先頭の区切りは残す
+	const bool isAbsolute = !filePath.empty() && (filePath[0] == '/' || filePath[0] == '\\');
+	String normalizedPath = isAbsolute ? String("/") : String();
+	for (const auto& segment : segments) {
+		if (!normalizedPath.empty() && normalizedPath.back() != '/') {
+			normalizedPath += '/';
+		}
+		normalizedPath += segment;
+	}
+
+	return normalizedPath;
+}
+
+String ShaderSourceScanner::getDirectory(const String& filePath) {
+	const size_t separatorPosition = filePath.find_last_of("/\\");
+	return separatorPosition == String::npos ? String() : filePath.substr(0, separatorPosition + 1);
+}
+
+bool ShaderSourceScanner::readFile(const String& filePath, VectorArray<byte>& outData) {
+	std::ifstream fin(filePath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if (!fin) {
+		return false;
+	}
+
+	const std::streamoff size = fin.tellg();
+	outData.resize(static_cast<size_t>(size));
+	fin.seekg(0, std::ios::beg);
+	return size == 0 || static_cast<bool>(fin.read(reinterpret_cast<char*>(outData.data()), size));
+}
+
+void ShaderCacheWriter::writeBytes(const void* data, uint64 size) {
+	const byte* bytes = reinterpret_cast<const byte*>(data);
+	_data.insert(_data.end(), bytes, bytes + size);
+}
+
+void ShaderCacheWriter::writeString(const String& value) {
+	write(static_cast<uint64>(value.size()));
+	writeBytes(value.data(), value.size());
+}
+
+void ShaderCacheWriter::writeBlob(const VectorArray<byte>& value) {
+	write(static_cast<uint64>(value.size()));
+	writeBytes(value.data(), value.size());
+}
+
+bool ShaderCacheReader::readBytes(void* dst, uint64 size) {
+	if (_isFailed || size > _size - _position) {
+		_isFailed = true;
+		return false;
+	}
+
+	memcpy(dst, _data + _position, static_cast<size_t>(size));
+	_position += size;
+	return true;
+}
+
+bool ShaderCacheReader::readString(String& outValue) {
+	uint64 size = 0;
+	if (!read(size) || size > _size - _position) {
+		_isFailed = true;
+		return false;
+	}
+
+	outValue.assign(reinterpret_cast<const char*>(_data + _position), static_cast<size_t>(size));
+	_position += size;
+	return true;
+}
+
+bool ShaderCacheReader::readBlob(VectorArray<byte>& outValue) {
+	uint64 size = 0;
+	if (!read(size) || size > _size - _position) {
+		_isFailed = true;
+		return false;
+	}
+
+	outValue.assign(_data + _position, _data + _position + size);
+	_position += size;
+	return true;
+}
+
+ShaderCache::ShaderCache() :_isDirty(false) {
+}
+
+ShaderCache::~ShaderCache() {
+	_singleton = nullptr;
+}
+
+bool ShaderCache::load(const String& filePath) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_isDirty = false;
+	_statistics = ShaderCacheStatistics();
+
+	VectorArray<byte> data;
+	if (!ShaderSourceScanner::readFile(filePath, data)) {
+		return true;
+	}
+
+	ShaderCacheReader reader(data.data(), data.size());
+	ShaderCacheHeader header = {};
+	const bool isValidHeader = reader.read(header) && header.magic == SHADER_CACHE_MAGIC && header.version == SHADER_CACHE_VERSION;
+
+	//途中で壊れていれば読んだ分も捨てる。次の保存で書き直す
+	bool isValid = isValidHeader;
+	for (uint32 i = 0; i < header.entryCount && isValid; ++i) {
+		uint64 identityHash = 0;
+		uint64 entryHash = 0;
+		Entry entry;
+		isValid = reader.read(identityHash) && reader.read(entry.key) && reader.read(entryHash)
+			&& reader.readBlob(entry.byteCode) && reader.readBlob(entry.reflection)
+			&& computeEntryHash(entry) == entryHash;
+		if (isValid) {
+			_entries[identityHash] = std::move(entry);
+		}
+	}
+
+	if (!isValid || !reader.isEnd()) {
+		_entries.clear();
+		_isDirty = true;
+		_statistics.isDiscarded = true;
+		return false;
+	}
+
+	_statistics.entryCount = static_cast<uint32>(_entries.size());
+	return true;
+}
+
+bool ShaderCache::save(const String& filePath) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	//同じ内容なら同じファイルになるように、識別のハッシュの順に書く
+	VectorArray<uint64> identityHashes;
+	identityHashes.reserve(_entries.size());
+	for (const auto& entry : _entries) {
+		identityHashes.push_back(entry.first);
+	}
+	std::sort(identityHashes.begin(), identityHashes.end());
+
+	VectorArray<byte> data;
+	ShaderCacheWriter writer(data);
+	ShaderCacheHeader header = {};
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.entryCount = static_cast<uint32>(identityHashes.size());
+	writer.write(header);
+
+	for (uint64 identityHash : identityHashes) {
+		const Entry& entry = _entries.at(identityHash);
+		writer.write(identityHash);
+		writer.write(entry.key);
+		writer.write(computeEntryHash(entry));
+		writer.writeBlob(entry.byteCode);
+		writer.writeBlob(entry.reflection);
+	}
+
+	std::ofstream fout(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	if (!fout) {
+		return false;
+	}
+
+	_isDirty = false;
+	return true;
+}
+
+bool ShaderCache::isDirty() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _isDirty;
+}
+
+bool ShaderCache::find(uint64 identityHash, uint64 key, VectorArray<byte>& outByteCode, VectorArray<byte>& outReflection) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto itr = _entries.find(identityHash);
+	if (itr == _entries.end() || itr->second.key != key) {
+		_statistics.missCount++;
+		return false;
+	}
+
+	outByteCode = itr->second.byteCode;
+	outReflection = itr->second.reflection;
+	_statistics.hitCount++;
+	return true;
+}
+
+void ShaderCache::store(uint64 identityHash, uint64 key, const void* byteCode, uint64 byteCodeSize, const VectorArray<byte>& reflection) {
+	const byte* byteCodeData = reinterpret_cast<const byte*>(byteCode);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	Entry& entry = _entries[identityHash];
+	entry.key = key;
+	entry.byteCode.assign(byteCodeData, byteCodeData + byteCodeSize);
+	entry.reflection = reflection;
+	_isDirty = true;
+	_statistics.entryCount = static_cast<uint32>(_entries.size());
+}
+
+void ShaderCache::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_isDirty = _isDirty || !_entries.empty();
+	_entries.clear();
+	_statistics.entryCount = 0;
+}
+
+ShaderCacheStatistics ShaderCache::getStatistics() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _statistics;
+}
+
+uint64 ShaderCache::computeIdentityHash(const ShaderCompileDesc& desc) {
+	uint64 hash = AssetCooker::computeHash(nullptr, 0);
+	hash = hashString(desc.filePath, hash);
+	hash = hashString(desc.entryPoint, hash);
+	hash = hashString(desc.target, hash);
+
+	const uint64 defineCount = desc.defines.size();
+	hash = AssetCooker::computeHash(&defineCount, sizeof(defineCount), hash);
+	for (const auto& define : desc.defines) {
+		hash = hashString(define.first, hash);
+		hash = hashString(define.second, hash);
+	}
+
+	return AssetCooker::computeHash(&desc.flags, sizeof(desc.flags), hash);
+}
+
+uint64 ShaderCache::computeKey(const ShaderCompileDesc& desc, const VectorArray<ShaderSourceFile>& sourceFiles) {
+	const uint32 version = SHADER_CACHE_VERSION;
+	uint64 hash = computeIdentityHash(desc);
+	hash = AssetCooker::computeHash(&version, sizeof(version), hash);
+	hash = AssetCooker::computeHash(&desc.compilerVersion, sizeof(desc.compilerVersion), hash);
+	hash = AssetCooker::computeHash(&desc.settingsHash, sizeof(desc.settingsHash), hash);
+
+	//インクルードの解決先が変わってもキーが変わるよう、パスも混ぜる
+	for (const auto& sourceFile : sourceFiles) {
+		hash = hashString(sourceFile.path, hash);
+		hash = AssetCooker::computeHash(&sourceFile.hash, sizeof(sourceFile.hash), hash);
+	}
+
+	return hash;
+}
+
+uint64 ShaderCache::computeEntryHash(const Entry& entry) {
+	uint64 hash = AssetCooker::computeHash(&entry.key, sizeof(entry.key));
+	hash = AssetCooker::computeHash(entry.byteCode.data(), entry.byteCode.size(), hash);
+	return AssetCooker::computeHash(entry.reflection.data(), entry.reflection.size(), hash);
+}
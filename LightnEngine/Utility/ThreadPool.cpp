@@ -0,0 +1,111 @@
+#include "include/ThreadPool.h"
+
+ThreadPool::ThreadPool() :_isShutdown(false) {
+}
+
+ThreadPool::~ThreadPool() {
+	shutdown();
+}
+
+void ThreadPool::create(uint32 workerCount) {
+	_isShutdown = false;
+	_workers.reserve(workerCount);
+	for (uint32 i = 0; i < workerCount; ++i) {
+		_workers.emplace_back(&ThreadPool::workerMain, this);
+	}
+}
+
+void ThreadPool::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_isShutdown = true;
+	}
+
+	_jobCondition.notify_all();
+	for (auto&& worker : _workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+
+	_workers.clear();
+}
+
+void ThreadPool::pushJob(const Job& job) {
+	//ワーカーがいなければその場で実行
+	if (_workers.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_jobs.push(job);
+	}
+
+	_jobCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(uint32 jobCount, const IndexedJob& job) {
+	std::atomic<uint32> remainJobCount(jobCount);
+
+	//先頭以外をワーカーに渡し、先頭は呼び出しスレッドで処理する
+	for (uint32 i = 1; i < jobCount; ++i) {
+		pushJob([&job, &remainJobCount, i]() {
+			job(i);
+			remainJobCount.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	if (jobCount > 0) {
+		job(0);
+		remainJobCount.fetch_sub(1, std::memory_order_release);
+	}
+
+	//完了待ちの間も積まれているジョブを処理する
+	while (remainJobCount.load(std::memory_order_acquire) > 0) {
+		if (!tryExecuteJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+uint32 ThreadPool::getWorkerCount() const {
+	return static_cast<uint32>(_workers.size());
+}
+
+bool ThreadPool::tryExecuteJob() {
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		if (_jobs.empty()) {
+			return false;
+		}
+
+		job = std::move(_jobs.front());
+		_jobs.pop();
+	}
+
+	job();
+	return true;
+}
+
+void ThreadPool::workerMain() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_jobCondition.wait(lock, [this]() { return _isShutdown || !_jobs.empty(); });
+
+			//シャットダウン時は積まれているジョブを処理しきってから終了
+			if (_jobs.empty()) {
+				return;
+			}
+
+			job = std::move(_jobs.front());
+			_jobs.pop();
+		}
+
+		job();
+	}
+}
@@ -0,0 +1,305 @@
+#include "include/TlsfAllocator.h"
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+	//最下位・最上位の立っているビット位置 (value != 0)
+	uint32 findLowestBit(uint64 value) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return static_cast<uint32>(index);
+#else
+		return static_cast<uint32>(__builtin_ctzll(value));
+#endif
+	}
+
+	uint32 findHighestBit(uint64 value) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return static_cast<uint32>(index);
+#else
+		return static_cast<uint32>(63 - __builtin_clzll(value));
+#endif
+	}
+
+	uint64 alignUp(uint64 value, uint64 alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool isPowerOfTwo(uint64 value) {
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+}
+
+TlsfAllocator::TlsfAllocator() :
+	_capacity(0), _granularity(1), _firstLevelBitmap(0), _secondLevelBitmaps(), _freeHeads() {
+}
+
+void TlsfAllocator::create(uint64 capacity, uint64 granularity) {
+	assert(isPowerOfTwo(granularity) && "粒度は2のべき乗である必要があります");
+	_capacity = capacity / granularity * granularity;
+	_granularity = granularity;
+	clear();
+}
+
+void TlsfAllocator::clear() {
+	_blocks.clear();
+	_unusedBlocks.clear();
+	_firstLevelBitmap = 0;
+	for (uint32 i = 0; i < FirstLevelCount; ++i) {
+		_secondLevelBitmaps[i] = 0;
+		for (uint32 j = 0; j < SecondLevelCount; ++j) {
+			_freeHeads[i][j] = InvalidNode;
+		}
+	}
+	_statistics = Statistics();
+
+	if (_capacity > 0) {
+		insertFreeBlock(createBlock(0, _capacity));
+	}
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(uint64 size, uint64 alignment) {
+	assert(isPowerOfTwo(alignment) && "アライメントは2のべき乗である必要があります");
+	if (alignment < _granularity) {
+		alignment = _granularity;
+	}
+
+	//粒度より大きいアライメントは先頭のずれを吸収できるだけ大きいブロックを探す
+	const uint64 alignedSize = alignUp(size > 0 ? size : 1, _granularity);
+	const uint64 searchSize = alignedSize + (alignment - _granularity);
+
+	const uint32 found = findFreeBlock(searchSize);
+	if (found == InvalidNode) {
+		++_statistics.failedAllocationCount;
+		return Allocation();
+	}
+
+	removeFreeBlock(found);
+
+	//先頭のずれは空きブロックとして切り出す。隣接する空きブロックは常に結合済みなので前のブロックは使用中
+	const uint64 blockOffset = _blocks[found].offset;
+	const uint64 alignedOffset = alignUp(blockOffset, alignment);
+	if (alignedOffset > blockOffset) {
+		const uint32 padding = createBlock(blockOffset, alignedOffset - blockOffset);
+		const uint32 prev = _blocks[found].prevPhysical;
+		_blocks[padding].prevPhysical = prev;
+		_blocks[padding].nextPhysical = found;
+		if (prev != InvalidNode) {
+			_blocks[prev].nextPhysical = padding;
+		}
+		_blocks[found].prevPhysical = padding;
+		_blocks[found].offset = alignedOffset;
+		_blocks[found].size -= alignedOffset - blockOffset;
+		insertFreeBlock(padding);
+	}
+
+	//余りは後ろの空きブロックとして戻す
+	if (_blocks[found].size > alignedSize) {
+		const uint32 remainder = createBlock(alignedOffset + alignedSize, _blocks[found].size - alignedSize);
+		const uint32 next = _blocks[found].nextPhysical;
+		_blocks[remainder].prevPhysical = found;
+		_blocks[remainder].nextPhysical = next;
+		if (next != InvalidNode) {
+			_blocks[next].prevPhysical = remainder;
+		}
+		_blocks[found].nextPhysical = remainder;
+		_blocks[found].size = alignedSize;
+		insertFreeBlock(remainder);
+	}
+
+	_blocks[found].isFree = false;
+
+	++_statistics.allocationCount;
+	++_statistics.liveAllocationCount;
+	_statistics.usedSize += alignedSize;
+	if (_statistics.usedSize > _statistics.peakUsedSize) {
+		_statistics.peakUsedSize = _statistics.usedSize;
+	}
+
+	Allocation allocation;
+	allocation.offset = alignedOffset;
+	allocation.size = alignedSize;
+	allocation.node = found;
+	return allocation;
+}
+
+void TlsfAllocator::free(const Allocation& allocation) {
+	assert(allocation.isValid() && "無効な確保を解放しようとしています");
+	uint32 block = allocation.node;
+	assert(!_blocks[block].isFree && "二重解放です");
+
+	_statistics.usedSize -= _blocks[block].size;
+	--_statistics.liveAllocationCount;
+
+	//前後の空きブロックと結合する
+	const uint32 prev = _blocks[block].prevPhysical;
+	if (prev != InvalidNode && _blocks[prev].isFree) {
+		removeFreeBlock(prev);
+		_blocks[prev].size += _blocks[block].size;
+		_blocks[prev].nextPhysical = _blocks[block].nextPhysical;
+		if (_blocks[block].nextPhysical != InvalidNode) {
+			_blocks[_blocks[block].nextPhysical].prevPhysical = prev;
+		}
+		releaseBlock(block);
+		block = prev;
+	}
+
+	const uint32 next = _blocks[block].nextPhysical;
+	if (next != InvalidNode && _blocks[next].isFree) {
+		removeFreeBlock(next);
+		_blocks[block].size += _blocks[next].size;
+		_blocks[block].nextPhysical = _blocks[next].nextPhysical;
+		if (_blocks[next].nextPhysical != InvalidNode) {
+			_blocks[_blocks[next].nextPhysical].prevPhysical = block;
+		}
+		releaseBlock(next);
+	}
+
+	insertFreeBlock(block);
+}
+
+uint64 TlsfAllocator::getLargestFreeBlockSize() const {
+	if (_firstLevelBitmap == 0) {
+		return 0;
+	}
+
+	//最上位のサイズクラスのリスト内だけを調べればよい
+	const uint32 firstLevel = findHighestBit(_firstLevelBitmap);
+	const uint32 secondLevel = findHighestBit(_secondLevelBitmaps[firstLevel]);
+
+	uint64 largestSize = 0;
+	for (uint32 block = _freeHeads[firstLevel][secondLevel]; block != InvalidNode; block = _blocks[block].nextFree) {
+		if (_blocks[block].size > largestSize) {
+			largestSize = _blocks[block].size;
+		}
+	}
+
+	return largestSize;
+}
+
+void TlsfAllocator::mapSize(uint64 units, uint32& firstLevel, uint32& secondLevel) {
+	//小さいサイズは第1レベル0に線形に並べ、それ以上は最上位ビットの位置とその下のビットで分類する
+	if (units < SecondLevelCount) {
+		firstLevel = 0;
+		secondLevel = static_cast<uint32>(units);
+		return;
+	}
+
+	const uint32 highestBit = findHighestBit(units);
+	firstLevel = highestBit - SecondLevelBits + 1;
+	secondLevel = static_cast<uint32>(units >> (highestBit - SecondLevelBits)) - SecondLevelCount;
+}
+
+uint32 TlsfAllocator::createBlock(uint64 offset, uint64 size) {
+	Block block = { offset, size, InvalidNode, InvalidNode, InvalidNode, InvalidNode, false };
+
+	if (!_unusedBlocks.empty()) {
+		const uint32 index = _unusedBlocks.back();
+		_unusedBlocks.pop_back();
+		_blocks[index] = block;
+		return index;
+	}
+
+	_blocks.push_back(block);
+	return static_cast<uint32>(_blocks.size() - 1);
+}
+
+void TlsfAllocator::releaseBlock(uint32 block) {
+	_unusedBlocks.push_back(block);
+}
+
+void TlsfAllocator::insertFreeBlock(uint32 block) {
+	uint32 firstLevel, secondLevel;
+	mapSize(_blocks[block].size / _granularity, firstLevel, secondLevel);
+
+	const uint32 head = _freeHeads[firstLevel][secondLevel];
+	_blocks[block].isFree = true;
+	_blocks[block].prevFree = InvalidNode;
+	_blocks[block].nextFree = head;
+	if (head != InvalidNode) {
+		_blocks[head].prevFree = block;
+	}
+
+	_freeHeads[firstLevel][secondLevel] = block;
+	_firstLevelBitmap |= 1ull << firstLevel;
+	_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	++_statistics.freeBlockCount;
+}
+
+void TlsfAllocator::removeFreeBlock(uint32 block) {
+	uint32 firstLevel, secondLevel;
+	mapSize(_blocks[block].size / _granularity, firstLevel, secondLevel);
+
+	const uint32 prev = _blocks[block].prevFree;
+	const uint32 next = _blocks[block].nextFree;
+	if (prev != InvalidNode) {
+		_blocks[prev].nextFree = next;
+	}
+	else {
+		_freeHeads[firstLevel][secondLevel] = next;
+	}
+
+	if (next != InvalidNode) {
+		_blocks[next].prevFree = prev;
+	}
+
+	//リストが空になったらビットを落とす
+	if (_freeHeads[firstLevel][secondLevel] == InvalidNode) {
+		_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (_secondLevelBitmaps[firstLevel] == 0) {
+			_firstLevelBitmap &= ~(1ull << firstLevel);
+		}
+	}
+
+	_blocks[block].isFree = false;
+	--_statistics.freeBlockCount;
+}
+
+uint32 TlsfAllocator::findFreeBlock(uint64 size) const {
+	const uint64 units = size / _granularity;
+
+	//次のサイズクラスの先頭まで切り上げて探すことで、見つかったリストのどのブロックにも収まるようにする
+	uint64 roundedUnits = units;
+	if (roundedUnits >= SecondLevelCount) {
+		roundedUnits += (1ull << (findHighestBit(roundedUnits) - SecondLevelBits)) - 1;
+	}
+
+	uint32 firstLevel, secondLevel;
+	mapSize(roundedUnits, firstLevel, secondLevel);
+	if (firstLevel < FirstLevelCount) {
+		uint32 secondLevelMap = _secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+		if (secondLevelMap == 0) {
+			//同じ第1レベルに無ければそれより大きい第1レベルの最小クラスを使う
+			const uint64 firstLevelMap = firstLevel + 1 < FirstLevelCount ? _firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap != 0) {
+				firstLevel = findLowestBit(firstLevelMap);
+				secondLevelMap = _secondLevelBitmaps[firstLevel];
+			}
+		}
+
+		if (secondLevelMap != 0) {
+			return _freeHeads[firstLevel][findLowestBit(secondLevelMap)];
+		}
+	}
+
+	//切り上げたクラスに無くても、要求と同じクラスに収まるブロックが残っていることがある
+	//ページと同じ大きさの確保など、容量ちょうどの要求が失敗しないようにこのクラスだけは中を調べる
+	mapSize(units, firstLevel, secondLevel);
+	if (firstLevel >= FirstLevelCount) {
+		return InvalidNode;
+	}
+
+	for (uint32 block = _freeHeads[firstLevel][secondLevel]; block != InvalidNode; block = _blocks[block].nextFree) {
+		if (_blocks[block].size >= size) {
+			return block;
+		}
+	}
+
+	return InvalidNode;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Utility.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+//アセットを1つにまとめたアーカイブ(.pak)の読み書き。コンバーターとエンジンの両方から使う
+//
+//ヘッダー、パスのハッシュで並べたエントリーの索引、パスの文字列の後に、4KBにアラインしたエントリーの本体が並ぶ
+//索引は先頭のページに固めて置くので、起動時はアーカイブを1回マップして先頭を読むだけで全エントリーを引ける
+//本体はページ境界から始まるので、圧縮していないエントリーはマップした領域をそのまま渡し、必要なページだけが読み込まれる
+//エントリーごとにLZ4で圧縮でき、圧縮したエントリーは開くときに全体を展開する
+//パスは大文字と小文字を区別せず、区切りは'/'にそろえてからハッシュを取る
+
+//'LPAK'
+constexpr uint32 ASSET_ARCHIVE_MAGIC = 0x4b41504c;
+constexpr uint32 ASSET_ARCHIVE_VERSION = 1;
+constexpr uint32 ASSET_ARCHIVE_ALIGNMENT = 4096;
+
+enum AssetArchiveCompression {
+	ASSET_ARCHIVE_COMPRESSION_NONE = 0,
+	ASSET_ARCHIVE_COMPRESSION_LZ4,
+	ASSET_ARCHIVE_COMPRESSION_COUNT
+};
+
+struct AssetArchiveHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 entryCount;
+	uint32 alignment;
+	uint64 fileSize;
+	uint64 indexOffset;
+	uint64 pathTableOffset;
+	uint64 pathTableSize;
+};
+
+struct AssetArchiveEntry {
+	//正規化したパスのハッシュ。索引はこの値の昇順に並ぶ
+	uint64 pathHash;
+
+	//ファイル上の本体の位置と大きさ。圧縮していればstoredSizeは圧縮後の大きさ
+	uint64 offset;
+	uint64 storedSize;
+
+	//展開後の大きさと内容のハッシュ
+	uint64 size;
+	uint64 contentHash;
+
+	//パスの文字列の位置と長さ。ハッシュが衝突したときの照合に使う
+	uint32 pathOffset;
+	uint32 pathLength;
+	uint32 compression;
+	uint32 reserved;
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 48, "ヘッダーは48バイト");
+static_assert(sizeof(AssetArchiveEntry) == 56, "エントリーは56バイト");
+
+//アーカイブをマップして索引を引く。開いた後は読むだけなので、複数のスレッドから同時に引いてよい
+class AssetArchive :private NonCopyable {
+public:
+	AssetArchive();
+
+	//ヘッダーと索引を検証する。壊れていればfalse
+	bool open(const char* filePath);
+	void close();
+	bool isOpen() const { return _file.isOpen(); }
+
+	//マップとは別にエントリーの本体を位置指定で読むときに開くパス
+	const String& getFilePath() const { return _filePath; }
+
+	//アーカイブ内のパスでエントリーを探す。なければnullptr
+	const AssetArchiveEntry* findEntry(const char* path) const;
+
+	//すべてのエントリーの内容のハッシュを計算し直して照合する。圧縮したエントリーは展開して比べる
+	bool verifyHashes() const;
+
+	uint32 getEntryCount() const { return _header != nullptr ? _header->entryCount : 0; }
+	const AssetArchiveEntry& getEntry(uint32 index) const { return _entries[index]; }
+	String getEntryPath(const AssetArchiveEntry& entry) const;
+
+	//ファイル上の本体。圧縮していなければ展開後の内容そのもの
+	const byte* getStoredData(const AssetArchiveEntry& entry) const { return _file.data() + entry.offset; }
+
+	//展開した内容をoutDataに入れる。圧縮していなければコピーする
+	bool readEntry(const AssetArchiveEntry& entry, VectorArray<byte>& outData) const;
+
+	//エントリーの本体のoffsetからsizeの範囲のページを読み込ませる
+	void prefetch(const AssetArchiveEntry& entry, uint64 offset, uint64 size) const;
+
+	//区切りを'/'にそろえて小文字にし、先頭の"./"と'/'を除く
+	static String normalizePath(const char* path);
+
+	//正規化したパスのハッシュ
+	static uint64 computePathHash(const String& normalizedPath);
+
+private:
+	MappedFile _file;
+	String _filePath;
+	const AssetArchiveHeader* _header;
+	const AssetArchiveEntry* _entries;
+	const char* _pathTable;
+};
+
+struct AssetArchiveWriteStatistics {
+	uint32 fileCount = 0;
+	uint32 compressedCount = 0;
+
+	//元のファイルの合計と、アーカイブに置いた本体の合計
+	uint64 size = 0;
+	uint64 storedSize = 0;
+	uint64 archiveSize = 0;
+};
+
+//ファイルを並べてアーカイブを書き出す
+class AssetArchiveWriter {
+public:
+	//archivePathはアーカイブ内のパス。isCompressedなら、LZ4で圧縮して縮むときだけ圧縮して置く
+	void addFile(const String& archivePath, const String& sourcePath, bool isCompressed);
+
+	//threadPoolがあればファイルの読み込み、ハッシュの計算と圧縮を並列に行う。失敗したファイルはoutLogに出す
+	//同じパスが2回追加されているか、パスのハッシュが衝突していれば書き出さない
+	bool write(const char* filePath, ThreadPool* threadPool, AssetArchiveWriteStatistics& outStatistics, String& outLog) const;
+
+private:
+	struct SourceFile {
+		String archivePath;
+		String sourcePath;
+		bool isCompressed;
+	};
+
+	VectorArray<SourceFile> _files;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Utility.h"
+#include "ThreadPool.h"
+
+//アセットの変換(クック)をスレッドプールで並列に行い、入力と設定が前回から変わっていないアセットは変換しない
+//入力、出力、依存ファイルの内容のハッシュと変換の設定のハッシュをキャッシュマニフェストに記録して照合する
+//変換器はAssetConverterを継承して登録する。スケジューラーとキャッシュは変換の中身を知らないので、ファイルを作らない変換器でも動かせる
+
+//キャッシュマニフェストの書式のバージョン。違うファイルは空のキャッシュとして読む
+//変換の中身を変えたときは、変換器がgetSettingsHashに含める自分のバージョンを上げる
+constexpr uint32 ASSET_CACHE_VERSION = 1;
+
+//1つの入力を変換した結果
+struct AssetCookResult {
+	//書き出したファイル。入力をそのまま書き換えた場合は入力も含める
+	VectorArray<String> outputPaths;
+
+	//入力以外に読んだファイル。これが変わっても変換し直す
+	VectorArray<String> dependencyPaths;
+
+	//変換の経過。並列に変換するので、呼び出し側が入力の順にまとめて表示する
+	String log;
+};
+
+class AssetConverter {
+public:
+	virtual ~AssetConverter() {}
+
+	//キャッシュに記録して変換器を区別する名前
+	virtual const char* getName() const = 0;
+
+	virtual bool canConvert(const String& inputPath) const = 0;
+
+	//変換の設定と変換器のバージョンのハッシュ。変われば入力が同じでも変換し直す
+	virtual uint64 getSettingsHash() const = 0;
+
+	//ワーカースレッドから並列に呼ばれる。スレッドセーフでない処理は変換器の中で排他する
+	virtual bool convert(const String& inputPath, AssetCookResult& outResult) = 0;
+};
+
+struct AssetFileHash {
+	String path;
+	uint64 hash;
+};
+
+//キャッシュマニフェストの入力1つ分
+struct AssetCacheEntry {
+	String converterName;
+	uint64 inputHash = 0;
+	uint64 settingsHash = 0;
+	VectorArray<AssetFileHash> outputs;
+	VectorArray<AssetFileHash> dependencies;
+};
+
+//入力のパスをキーに、前回の変換の入力、設定、出力、依存ファイルのハッシュを持つ
+class AssetCookCache {
+public:
+	//ファイルがなければ空のキャッシュとして扱う。壊れていればfalseを返して空にする
+	bool load(const String& filePath);
+	bool save(const String& filePath) const;
+
+	//変換器、入力と設定のハッシュが一致し、出力と依存ファイルが前回の内容のまま残っていれば変換を省ける
+	bool isUpToDate(const String& inputPath, const char* converterName, uint64 inputHash, uint64 settingsHash) const;
+
+	const AssetCacheEntry* findEntry(const String& inputPath) const;
+	void setEntry(const String& inputPath, const AssetCacheEntry& entry);
+	void removeEntry(const String& inputPath);
+
+	//Makefile形式の依存マニフェストを書き出す。出力ごとに入力と依存ファイルを並べる
+	bool saveDependencies(const String& filePath) const;
+
+private:
+	//書き出す順番を決めるため、入力のパスで並べて持つ
+	VectorArray<std::pair<String, AssetCacheEntry>> _entries;
+};
+
+enum AssetCookStatus {
+	ASSET_COOK_CONVERTED = 0,
+	ASSET_COOK_SKIPPED,
+	ASSET_COOK_FAILED,
+	ASSET_COOK_UNSUPPORTED
+};
+
+struct AssetCookStatistics {
+	uint32 convertedCount = 0;
+	uint32 skippedCount = 0;
+	uint32 failedCount = 0;
+	uint32 unsupportedCount = 0;
+	float elapsedMilliseconds = 0.0f;
+};
+
+class AssetCooker {
+public:
+	AssetCooker();
+
+	//変換器は登録した順に探し、最初にcanConvertを返したものを使う。変換器は呼び出し側が保持する
+	void addConverter(RefPtr<AssetConverter> converter);
+
+	//trueならキャッシュを見ずにすべて変換し直す
+	void setForced(bool isForced) { _isForced = isForced; }
+
+	//入力を並列に変換し、変換できた入力のキャッシュのエントリーを更新する。失敗した入力のエントリーは消す
+	//並列の変換中はキャッシュを読むだけで、エントリーは全部の変換が終わってから書き換える。同じ入力を重複して渡さない
+	void cook(const VectorArray<String>& inputPaths, ThreadPool& threadPool, AssetCookCache& cache,
+		VectorArray<AssetCookResult>& outResults, VectorArray<AssetCookStatus>& outStatuses, AssetCookStatistics& outStatistics) const;
+
+	//64ビットのFNV-1a。seedに前のハッシュを渡すと続けて計算できる
+	static uint64 computeHash(const void* data, uint64 size, uint64 seed = 14695981039346656037ull);
+
+	//ファイルの内容のハッシュ。開けなければfalse
+	static bool computeFileHash(const String& filePath, uint64& outHash);
+
+	//拡張子が一致するか。大文字と小文字は区別しない
+	static bool hasExtension(const String& filePath, const char* extension);
+
+private:
+	RefPtr<AssetConverter> findConverter(const String& inputPath) const;
+
+	VectorArray<RefPtr<AssetConverter>> _converters;
+	bool _isForced;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Utility.h"
+#include "MappedFile.h"
+#include "AssetArchive.h"
+
+//アーカイブをマウントしてパスで引く仮想ファイルシステム
+//マウントポイントで始まるパスは、マウントしたアーカイブにあればアーカイブから、なければファイルを直接開く
+//アーカイブに入れていないファイルや、アーカイブを作らずに開発しているときはこれまでどおり個別のファイルが読まれる
+//マウントとアンマウントはロードを始める前にメインスレッドで行う。その後の検索は読むだけなので、どのスレッドから呼んでもよい
+class AssetFileSystem :public Singleton<AssetFileSystem> {
+public:
+	AssetFileSystem();
+	~AssetFileSystem();
+
+	//mountPointは"Resources/"のようなパスの先頭。後からマウントしたアーカイブを先に探す。開けなければfalse
+	bool mount(const char* archivePath, const char* mountPoint);
+	void unmountAll();
+
+	//パスに当たるエントリーを探す。なければnullptr
+	const AssetArchive* findEntry(const char* filePath, const AssetArchiveEntry*& outEntry) const;
+
+	uint32 getMountedArchiveCount() const { return static_cast<uint32>(_archives.size()); }
+
+	//ツールなどファイルシステムを作らないプログラムからも、同じ読み込み処理を使えるようにする
+	static bool isCreated() { return _singleton != nullptr; }
+
+private:
+	struct MountedArchive {
+		String mountPoint;
+		UniquePtr<AssetArchive> archive;
+	};
+
+	VectorArray<MountedArchive> _archives;
+};
+
+//アーカイブのエントリーか個別のファイルを読み取り専用で開く。MappedFileと同じように内容を直接参照できる
+//圧縮していないエントリーはアーカイブのマップした領域を指し、圧縮したエントリーは開くときに展開して持つ
+//アーカイブの領域を指している間は、そのアーカイブをアンマウントしない
+class AssetFile :private NonCopyable {
+public:
+	AssetFile();
+	~AssetFile();
+
+	AssetFile(AssetFile&& other);
+	AssetFile& operator=(AssetFile&& other);
+
+	//空のファイルは開けないので失敗扱い
+	bool open(const char* filePath);
+	void close();
+
+	//範囲内のページに触れて読み込ませておく。展開済みの内容はメモリ上にあるので何もしない
+	void prefetch(uint64 offset, uint64 size) const;
+
+	const byte* data() const { return _data; }
+	uint64 size() const { return _size; }
+	bool isOpen() const { return _data != nullptr; }
+
+	//アーカイブから開いたか
+	bool isArchived() const { return _archive != nullptr; }
+
+private:
+	const byte* _data;
+	uint64 _size;
+
+	//個別のファイルを開いたときのマップ
+	MappedFile _file;
+
+	//アーカイブから開いたときのエントリーと、圧縮していたときの展開先
+	const AssetArchive* _archive;
+	const AssetArchiveEntry* _entry;
+	VectorArray<byte> _decompressedData;
+};
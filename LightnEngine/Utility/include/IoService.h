@@ -0,0 +1,282 @@
+#pragma once
+
+#include "Utility.h"
+#include "ThreadPool.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+//ファイルの範囲を非同期に読み込むサービス。メッシュ、テクスチャ、シェーダーの読み込みはここを通す
+//
+//要求は優先度ごとのキューに積まれ、I/Oスレッドが優先度の高い順に取り出して位置指定で読む。キューにある間は取り消せる
+//同じファイルの近い範囲を読む同じ優先度の要求は、1回の読み込みにまとめて発行し、読んだバッファを要求ごとに切り分けて渡す
+//アーカイブに入っているパスはアーカイブのファイル上の範囲に読み替えるので、隣り合うエントリーもまとめて読まれる
+//低い優先度の要求は先読みとして扱い、読み込んだバッファの合計がreadAheadBudgetを超える間は発行しない
+//呼び出し側がバッファを返すまで次を読まないので、消費が追いつかないときにメモリを使い切らない
+//完了コールバックはスレッドプールのジョブとして呼ぶ。スレッドプールがなければI/Oスレッドで呼ぶ
+//
+//Windowsはオーバーラップ構造体で位置を指定したReadFile、それ以外はpreadで読む。どちらも同期読み込みをI/Oスレッドに並べて非同期にする
+
+enum IoPriority {
+	//フレームを止めて待っている読み込み
+	IO_PRIORITY_HIGH = 0,
+
+	//ロード画面など、まとめて待つ読み込み
+	IO_PRIORITY_NORMAL,
+
+	//ストリーミングなど、遅れても表示が粗くなるだけの読み込み
+	IO_PRIORITY_LOW,
+	IO_PRIORITY_COUNT
+};
+
+enum IoStatus {
+	IO_STATUS_SUCCEEDED = 0,
+	IO_STATUS_FAILED,
+	IO_STATUS_CANCELLED
+};
+
+using IoRequestId = uint64;
+constexpr IoRequestId INVALID_IO_REQUEST_ID = 0;
+
+//ファイルの終端まで読む
+constexpr uint64 IO_READ_TO_END = ~0ull;
+
+class IoService;
+struct IoBlock;
+
+//読み込んだ内容。まとめて読んだ要求同士は同じブロックを共有し、すべてのIoBufferが破棄されるとブロックがプールに返る
+class IoBuffer :private NonCopyable {
+public:
+	IoBuffer();
+	~IoBuffer();
+
+	IoBuffer(IoBuffer&& other);
+	IoBuffer& operator=(IoBuffer&& other);
+
+	void release();
+
+	const byte* data() const { return _data; }
+	uint64 size() const { return _size; }
+	bool isValid() const { return _block != nullptr; }
+
+private:
+	friend class IoService;
+
+	IoService* _service;
+	IoBlock* _block;
+	const byte* _data;
+	uint64 _size;
+};
+
+struct IoReadResult {
+	IoRequestId requestId = INVALID_IO_REQUEST_ID;
+	IoStatus status = IO_STATUS_FAILED;
+	IoPriority priority = IO_PRIORITY_NORMAL;
+
+	//要求した範囲のうちファイルの終端までの内容。コールバックから持ち出さなければコールバックを抜けた後に返される
+	IoBuffer buffer;
+
+	//要求してからコールバックが呼ばれるまで
+	double latencyMilliseconds = 0.0;
+
+	bool isSucceeded() const { return status == IO_STATUS_SUCCEEDED; }
+};
+
+using IoCallback = std::function<void(IoReadResult&)>;
+
+struct IoReadRequest {
+	String filePath;
+	uint64 offset = 0;
+	uint64 size = IO_READ_TO_END;
+	IoPriority priority = IO_PRIORITY_NORMAL;
+
+	//失敗と取り消しのときも必ず1回呼ばれる
+	IoCallback callback;
+};
+
+//要求をまとめて完了を待つためのカウンター。コールバックを抜けた時点で完了とみなす
+class IoRequestGroup :private NonCopyable {
+public:
+	IoRequestGroup();
+
+	void wait();
+	uint32 getPendingCount() const { return _pendingCount.load(std::memory_order_acquire); }
+
+private:
+	friend class IoService;
+
+	void add();
+	void done();
+
+	std::atomic<uint32> _pendingCount;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+};
+
+struct IoServiceSettings {
+	uint32 threadCount = 2;
+
+	//低い優先度の要求が読み込んだまま返されていないバッファの合計の上限
+	uint64 readAheadBudget = 64 * 1024 * 1024;
+
+	//まとめて読む範囲の上限。0ならまとめない
+	uint64 maxCoalescedSize = 4 * 1024 * 1024;
+
+	//この大きさまでの隙間は読み捨ててでも1回の読み込みにまとめる
+	uint64 coalesceGap = 64 * 1024;
+};
+
+struct IoPriorityStatistics {
+	uint32 requestCount = 0;
+	uint32 completedCount = 0;
+	uint32 failedCount = 0;
+	uint32 cancelledCount = 0;
+	uint64 completedSize = 0;
+	double totalLatencyMilliseconds = 0.0;
+	double maxLatencyMilliseconds = 0.0;
+
+	double getAverageLatency() const {
+		const uint32 count = completedCount + failedCount;
+		return count > 0 ? totalLatencyMilliseconds / count : 0.0;
+	}
+};
+
+struct IoServiceStatistics {
+	IoPriorityStatistics priorities[IO_PRIORITY_COUNT];
+
+	//実際に発行した読み込みの数と大きさ。まとめたときの隙間も含む
+	uint32 readCount = 0;
+	uint64 readSize = 0;
+
+	//ほかの要求と1回の読み込みにまとめた要求の数
+	uint32 coalescedRequestCount = 0;
+
+	//先読みのバッファの現在と最大の合計
+	uint64 readAheadSize = 0;
+	uint64 maxReadAheadSize = 0;
+
+	uint32 pendingRequestCount = 0;
+};
+
+class IoService :public Singleton<IoService> {
+public:
+	IoService();
+	~IoService();
+
+	//completionThreadPoolは完了コールバックを呼ぶスレッドプール。nullptrならI/Oスレッドで呼ぶ
+	//parallelForで待つスレッドは積まれたジョブを拾うので、フレームの処理に使うプールは渡さない
+	void create(const IoServiceSettings& settings, ThreadPool* completionThreadPool);
+
+	//キューに残っている要求は取り消し、読み込み中の要求はコールバックまで待つ
+	void shutdown();
+
+	//groupを渡すとコールバックを抜けるまでgroupの完了待ちに数える。どのスレッドから呼んでもよい
+	IoRequestId read(const IoReadRequest& request, IoRequestGroup* group = nullptr);
+
+	//キューにあって発行前の要求を取り消し、IO_STATUS_CANCELLEDでコールバックを呼ぶ。すでに読み込み中か完了していればfalse
+	bool cancel(IoRequestId requestId);
+
+	//読み終えるまで呼び出しスレッドで待つ。完了はI/Oスレッドで扱うので、スレッドプールのワーカーから呼んでもよい
+	bool readBlocking(const String& filePath, uint64 offset, uint64 size, IoPriority priority, IoBuffer& outBuffer);
+
+	//すべての要求のコールバックを抜けるまで待つ
+	void waitIdle();
+
+	IoServiceStatistics getStatistics() const;
+	void resetStatistics();
+	const IoServiceSettings& getSettings() const { return _settings; }
+
+	static bool isCreated() { return _singleton != nullptr; }
+
+private:
+	friend class IoBuffer;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct IoFile;
+
+	struct PendingRead {
+		IoRequestId requestId;
+		IoPriority priority;
+		uint32 fileIndex;
+
+		//ファイル上の範囲。IO_READ_TO_ENDのときはファイルを開いてから決める
+		uint64 offset;
+		uint64 size;
+
+		//圧縮したアーカイブのエントリーは、本体を読んで展開してからsliceOffsetからsliceSizeを切り出す
+		bool isCompressed;
+		uint64 uncompressedSize;
+		uint64 sliceOffset;
+		uint64 sliceSize;
+
+		bool isCompletedOnIoThread;
+		IoCallback callback;
+		IoRequestGroup* group;
+		Clock::time_point submitTime;
+	};
+
+	struct IoCompletion {
+		IoCallback callback;
+		IoReadResult result;
+		IoRequestGroup* group;
+	};
+
+	//パスをファイルとその上の範囲に読み替えて積む
+	IoRequestId enqueue(const IoReadRequest& request, IoRequestGroup* group, bool isCompletedOnIoThread);
+	uint32 findOrAddFile(const String& filePath);
+
+	//キューの先頭から発行できる要求を選び、近い範囲の要求をまとめて取り出す。発行できなければfalse
+	bool takeReads(VectorArray<PendingRead>& outReads);
+	bool canIssue(IoPriority priority) const;
+	void ioThreadMain();
+	void executeReads(VectorArray<PendingRead>& reads);
+
+	bool openFile(IoFile& file);
+	bool readFile(IoFile& file, uint64 offset, uint64 size, byte* dst);
+	void closeFiles();
+
+	IoBlock* acquireBlock(uint64 size, bool isReadAhead);
+	void releaseBlock(IoBlock* block);
+	IoBuffer makeBuffer(IoBlock* block, const byte* data, uint64 size);
+
+	void complete(PendingRead& read, IoStatus status, IoBuffer&& buffer);
+	void executeCompletion();
+	void finishCompletion(IoCompletion& completion);
+
+	IoServiceSettings _settings;
+	ThreadPool* _completionThreadPool;
+	VectorArray<std::thread> _ioThreads;
+
+	//キューとファイルの表は_mutexで守る
+	mutable std::mutex _mutex;
+	std::condition_variable _condition;
+	DequeArray<PendingRead> _pendingReads[IO_PRIORITY_COUNT];
+	VectorArray<UniquePtr<IoFile>> _files;
+	UnorderedMap<String, uint32> _fileIndices;
+	IoRequestId _nextRequestId;
+	uint32 _lowPriorityReadingCount;
+	bool _isShutdown;
+
+	//ファイルを開くのはI/Oスレッドなので、同じファイルを2回開かないように別に守る
+	std::mutex _fileOpenMutex;
+
+	//返されたブロックは大きさを変えずに使い回す。空きブロックと先読みの合計も_mutexで守る
+	VectorArray<IoBlock*> _freeBlocks;
+	uint64 _freeBlockSize;
+	uint64 _readAheadSize;
+
+	std::mutex _completionMutex;
+	DequeArray<IoCompletion> _completions;
+
+	//積んでからコールバックを抜けるまでの要求の数
+	std::atomic<uint32> _activeRequestCount;
+	std::mutex _idleMutex;
+	std::condition_variable _idleCondition;
+
+	mutable std::mutex _statisticsMutex;
+	IoServiceStatistics _statistics;
+};
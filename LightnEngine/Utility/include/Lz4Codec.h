@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Utility.h"
+
+//LZ4のブロック形式の圧縮と展開。フレーム形式のヘッダーやチェックサムは持たず、大きさは呼び出し側が別に記録しておく
+//出力はLZ4のブロック形式と互換で、外部のlz4でも展開できる
+//展開はアセットのロード中に使うので、壊れた入力でも書き込み先と読み込み元の範囲を越えない
+class Lz4Codec {
+public:
+	//srcSizeを圧縮したときの最大の大きさ
+	static uint64 getCompressBound(uint64 srcSize);
+
+	//srcSizeの圧縮データを展開したときの最大の大きさ。記録された大きさが壊れていないかを確かめるのに使う
+	static uint64 getDecompressBound(uint64 srcSize);
+
+	//dstCapacityに収まらなければ0を返す。1ブロックで扱えるのは2GB未満
+	static uint64 compress(const byte* src, uint64 srcSize, byte* dst, uint64 dstCapacity);
+
+	//展開した大きさがdstSizeちょうどにならなければfalse
+	static bool decompress(const byte* src, uint64 srcSize, byte* dst, uint64 dstSize);
+};
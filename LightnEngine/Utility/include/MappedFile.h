@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Utility.h"
+
+//ファイルを読み取り専用でメモリにマップする
+//読み込み用のバッファを介さずにファイルの内容を直接参照できるので、アップロードバッファへのコピーが1回で済む
+//Windowsはファイルマッピングオブジェクト、Linuxはmmapを使う
+class MappedFile :private NonCopyable {
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+
+	//空のファイルはマップできないので失敗扱い
+	bool open(const char* filePath);
+	void close();
+
+	//範囲内のページに触れて読み込ませておく。最初のアクセスでのページフォールトを呼び出しスレッドに肩代わりさせる
+	void prefetch(uint64 offset, uint64 size) const;
+
+	const byte* data() const { return _data; }
+	uint64 size() const { return _size; }
+	bool isOpen() const { return _data != nullptr; }
+
+private:
+	const byte* _data;
+	uint64 _size;
+
+	//Windowsのファイルとマッピングオブジェクトのハンドル
+	void* _fileHandle;
+	void* _mappingHandle;
+};
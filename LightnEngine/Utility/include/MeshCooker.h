@@ -0,0 +1,78 @@
+#pragma once
+
+#include "AssetCooker.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshVertexCodec.h"
+
+//変換したメッシュの後処理(並べ替え、LOD、メッシュレット、頂点とインデックスの圧縮)をまとめて行う
+//FBX SDKに依存しないので、FBXから変換したメッシュにも既存の.meshにも同じ手順を使える
+
+//後処理の中身を変えたら上げる。クックのキャッシュに記録した.meshを作り直す
+constexpr uint32 MESH_COOK_VERSION = 1;
+
+struct MeshCookSettings {
+	//頂点とインデックスを描画向けに並べ替え、LODとメッシュレットを作り直す
+	//falseならLODやメッシュレットを持たないメッシュにだけ作る
+	bool isOptimize = true;
+
+	MeshOptimizeSettings optimize;
+	MeshLodSettings lod;
+	MeshVertexTolerance vertexTolerance;
+
+	//クックのキャッシュで設定の変更を見分けるハッシュ。後処理のバージョンも含める
+	uint64 computeHash() const;
+};
+
+//書き出しが終わるまで最適化、圧縮した頂点とインデックス、LOD、メッシュレットを持っておく
+struct MeshCookData {
+	OptimizedMeshData optimized;
+	MeshLodData lods;
+	MeshletData meshlets;
+	VectorArray<MeshFileCompactVertex> vertices;
+	VectorArray<byte> packedIndices;
+	VectorArray<byte> encodedIndices;
+};
+
+class MeshCooker {
+public:
+	//並べ替え、LOD、メッシュレット、頂点とインデックスの圧縮の順に行い、meshをoutDataに向ける
+	//経過はoutLogに1行ずつ足す。何か書き換えればoutIsChangedがtrue。失敗すればfalse
+	static bool cookMesh(MeshFileMesh& mesh, const MeshCookSettings& settings, MeshCookData& outData, String& outLog, bool& outIsChanged);
+
+	//.meshを読んで後処理し、書き換えがあればそのファイルに書き出す
+	//マップしたままでは上書きできないので、メモリ上に組み立ててから閉じて書き出す
+	static bool cookMeshFile(const String& filePath, const MeshCookSettings& settings, String& outLog, bool& outIsWritten);
+
+private:
+	//頂点キャッシュ、オーバードロー、頂点フェッチの順に並べ替え、前後のACMRとATVRを記録する
+	static bool optimizeMesh(MeshFileMesh& mesh, const MeshCookSettings& settings, OptimizedMeshData& outData, String& outLog);
+
+	//LODを持たないメッシュ(isRebuildなら常に)はLOD0から三角形を減らしたLODを作る。書き換えればtrue
+	static bool buildLods(MeshFileMesh& mesh, const MeshCookSettings& settings, bool isRebuild, MeshLodData& outData, String& outLog);
+
+	//メッシュレットを持たないメッシュ(isRebuildなら常に)はメッシュレットに分ける。書き換えればtrue
+	static bool buildMeshlets(MeshFileMesh& mesh, bool isRebuild, MeshletData& outData, String& outLog);
+
+	//誤差が許容範囲に収まればfloat頂点を圧縮フォーマットに置き換える。置き換えればtrue
+	static bool compactVertices(MeshFileMesh& mesh, const MeshCookSettings& settings, VectorArray<MeshFileCompactVertex>& outVertices, String& outLog);
+
+	//インデックスを16ビットに詰められれば詰め、差分の符号化で小さくなれば符号化する。書き換えればtrue
+	static bool compressIndices(MeshFileMesh& mesh, VectorArray<byte>& outPacked, VectorArray<byte>& outEncoded, String& outLog);
+};
+
+//既存の.meshをその場で後処理するクックの変換器
+class MeshAssetConverter :public AssetConverter {
+public:
+	MeshAssetConverter(const MeshCookSettings& settings) :_settings(settings) {}
+
+	const char* getName() const override { return "mesh"; }
+	bool canConvert(const String& inputPath) const override;
+	uint64 getSettingsHash() const override { return _settings.computeHash(); }
+	bool convert(const String& inputPath, AssetCookResult& outResult) override;
+
+private:
+	MeshCookSettings _settings;
+};
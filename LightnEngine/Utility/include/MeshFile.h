@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Utility.h"
+
+//メッシュファイル(.mesh)の読み書き。コンバーターとエンジンの両方から使うのでD3D12にもMathにも依存しない
+//
+//v1はヘッダーなしで以下が詰めて並ぶ。頂点は44バイト固定で、1ファイルに1メッシュ
+//  uint32 本体サイズ, 頂点数, インデックス数, マテリアル数 / 頂点 / インデックス / マテリアルの描画範囲 / AABB(float x 6、古いファイルにはない)
+//
+//v2はヘッダーとセクションテーブルの後に、256バイトにアラインしたセクションの本体が並ぶ
+//セクションはメッシュごとに情報、頂点、インデックス、マテリアルの描画範囲があり、本体はそのままアップロードバッファにコピーできる
+//セクションごとに内容のハッシュを持つので、コンバーターやデバッグビルドで壊れたファイルを検出できる
+//
+//v2の頂点はメッシュごとに44バイトのfloatか16バイトの圧縮フォーマットのどちらかで、情報セクションのvertexFormatで区別する
+//インデックスはメッシュごとに16ビットか32ビットで、そのまま置くか差分を可変長整数に符号化して置く(MeshIndexCodec)
+//メッシュレットのセクションは省略でき、あればクラスター単位のカリングに使う(MeshletBuilder)
+//LODのセクションも省略できる。LODのインデックスはLOD0の後ろに続けて同じインデックスセクションに置き、頂点はLOD0と共有する(MeshSimplifier)
+
+//'LMSH'
+constexpr uint32 MESH_FILE_MAGIC = 0x48534d4c;
+constexpr uint32 MESH_FILE_VERSION = 2;
+constexpr uint32 MESH_FILE_SECTION_ALIGNMENT = 256;
+constexpr uint32 MESH_FILE_V1_VERTEX_STRIDE = 44;
+constexpr uint32 MESH_FILE_MAX_NAME_LENGTH = 56;
+constexpr uint32 MESH_FILE_COMPACT_VERTEX_STRIDE = 16;
+
+//UVが裏返った面の頂点は従法線をsign * cross(normal, tangent)のsign = -1で求める
+//float頂点は接線の長さをこの値にして-1を表し、圧縮頂点は位置のwを最大値にして表す。古いファイルはどちらも+1になる
+constexpr float MESH_MIRRORED_TANGENT_LENGTH = 2.0f;
+
+enum MeshVertexFormat {
+	//位置、法線、接線、UVをすべてfloatで持つ。v1と同じ並び
+	MESH_VERTEX_FORMAT_FLOAT = 0,
+
+	//位置はAABB内の16ビット固定小数、法線と接線は8ビットずつの八面体エンコード、UVはhalf
+	MESH_VERTEX_FORMAT_COMPACT,
+	MESH_VERTEX_FORMAT_COUNT
+};
+
+enum MeshFileSectionType {
+	MESH_SECTION_INFO = 0,
+	MESH_SECTION_VERTEX,
+	MESH_SECTION_INDEX,
+	MESH_SECTION_MATERIAL_RANGE,
+
+	//MESH_SECTION_INDEXの代わりに置く符号化したインデックス。本体はMeshFileEncodedIndexHeaderと符号化したバイト列
+	MESH_SECTION_ENCODED_INDEX,
+
+	//メッシュレットとその頂点、三角形。3つそろえて置く
+	MESH_SECTION_MESHLET,
+	MESH_SECTION_MESHLET_VERTEX,
+	MESH_SECTION_MESHLET_TRIANGLE,
+
+	//LOD1以降の情報とマテリアルの描画範囲。2つそろえて置く
+	MESH_SECTION_LOD,
+	MESH_SECTION_LOD_MATERIAL_RANGE,
+	MESH_SECTION_TYPE_COUNT
+};
+
+//LOD0を含めたLODの数の上限
+constexpr uint32 MESH_MAX_LOD_COUNT = 4;
+
+//1つのメッシュレットに入れる頂点と三角形の上限
+constexpr uint32 MESHLET_MAX_VERTEX_COUNT = 64;
+constexpr uint32 MESHLET_MAX_TRIANGLE_COUNT = 124;
+
+struct MeshFileHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 meshCount;
+	uint32 sectionCount;
+	uint64 fileSize;
+	uint64 sectionTableOffset;
+};
+
+struct MeshFileSection {
+	uint32 type;
+	uint32 meshIndex;
+
+	//要素1つのバイト数と要素数。size = stride * count
+	uint32 stride;
+	uint32 count;
+	uint64 offset;
+	uint64 size;
+	uint64 hash;
+};
+
+//MESH_SECTION_INFOの本体。後ろに追加したメンバーは古いファイルでは0として読む
+struct MeshFileMeshInfo {
+	float boundsMin[3];
+	float boundsMax[3];
+	char name[MESH_FILE_MAX_NAME_LENGTH];
+	uint32 vertexFormat;
+};
+
+//MESH_VERTEX_FORMAT_FLOATの頂点
+struct MeshFileFloatVertex {
+	float position[3];
+	float normal[3];
+	float tangent[3];//長さ1なら従法線の符号が+1、MESH_MIRRORED_TANGENT_LENGTHなら-1
+	float texcoord[2];
+};
+
+//MESH_VERTEX_FORMAT_COMPACTの頂点。各メンバーはそのままDXGIのフォーマットで入力アセンブラに読ませる
+struct MeshFileCompactVertex {
+	//R16G16B16A16_UNORM。AABBの最小点を0、最大点を1とする。wは従法線の符号で、0なら+1、1なら-1
+	uint16 position[4];
+
+	//R8G8B8A8_SNORM。xyが法線、zwが接線の八面体エンコード
+	signed char normalTangent[4];
+
+	//R16G16_FLOAT
+	uint16 texcoord[2];
+};
+
+static_assert(sizeof(MeshFileFloatVertex) == MESH_FILE_V1_VERTEX_STRIDE, "float頂点はv1と同じ大きさ");
+static_assert(sizeof(MeshFileCompactVertex) == MESH_FILE_COMPACT_VERTEX_STRIDE, "圧縮頂点は16バイト");
+
+inline uint32 getMeshVertexStride(uint32 vertexFormat) {
+	return vertexFormat == MESH_VERTEX_FORMAT_COMPACT ? MESH_FILE_COMPACT_VERTEX_STRIDE : MESH_FILE_V1_VERTEX_STRIDE;
+}
+
+//MESH_SECTION_ENCODED_INDEXの先頭。戻したインデックスの数と1つのバイト数
+struct MeshFileEncodedIndexHeader {
+	uint32 indexCount;
+	uint32 indexStride;
+};
+
+//MESH_SECTION_MESHLETの要素。境界とコーンはメッシュのローカル空間で、シェーダーからも同じ並びで読む
+struct MeshFileMeshlet {
+	//頂点を囲む境界球
+	float center[3];
+	float radius;
+
+	//三角形の表の向きを囲むコーン。coneCutoffは開き角のsinで、1なら裏面で除外できない
+	float coneAxis[3];
+	float coneCutoff;
+
+	//MESH_SECTION_MESHLET_VERTEXとMESH_SECTION_MESHLET_TRIANGLEの中の位置
+	uint32 vertexOffset;
+	uint32 triangleOffset;
+	uint16 vertexCount;
+	uint16 triangleCount;
+
+	//三角形が属するマテリアルの描画範囲。メッシュレットは範囲をまたがない
+	uint32 materialRangeIndex;
+};
+
+static_assert(sizeof(MeshFileMeshlet) == 48, "シェーダーと同じ48バイト");
+
+//MESH_SECTION_MESHLET_TRIANGLEの要素。メッシュレット内の頂点番号を8ビットずつ3つ詰める
+inline uint32 packMeshletTriangle(uint32 i0, uint32 i1, uint32 i2) {
+	return i0 | (i1 << 8) | (i2 << 16);
+}
+
+//エンジンのMaterialDrawRangeと同じ並び
+struct MeshFileMaterialRange {
+	uint32 indexCount;
+	uint32 indexOffset;
+};
+
+//MESH_SECTION_LODの要素。LOD1から順に並ぶ
+//マテリアルの描画範囲はMESH_SECTION_LOD_MATERIAL_RANGEにLODごとにメッシュのマテリアル数ずつ並ぶ
+struct MeshFileLod {
+	//元の形からのずれ。メッシュのAABBの対角線の長さに対する割合
+	float error;
+	uint32 triangleCount;
+};
+
+//書き込むメッシュ1つ分。読み込み時は各配列がファイル上を指す
+struct MeshFileMesh {
+	MeshFileMeshInfo info;
+	uint32 vertexStride = 0;
+	uint32 vertexCount = 0;
+
+	//インデックス1つのバイト数。2か4
+	uint32 indexStride = sizeof(uint32);
+	uint32 indexCount = 0;
+	uint32 materialRangeCount = 0;
+	const byte* vertices = nullptr;
+
+	//符号化したインデックスを持つメッシュはindicesがnullptrで、encodedIndicesをMeshIndexCodecで戻す
+	//書き込み時はencodedIndicesがあればそちらを書き出す
+	const void* indices = nullptr;
+	const byte* encodedIndices = nullptr;
+	uint64 encodedIndexSize = 0;
+
+	const MeshFileMaterialRange* materialRanges = nullptr;
+
+	//メッシュレットを持たないメッシュはmeshletCountが0
+	uint32 meshletCount = 0;
+	uint32 meshletVertexCount = 0;
+	uint32 meshletTriangleCount = 0;
+	const MeshFileMeshlet* meshlets = nullptr;
+
+	//メッシュの頂点番号
+	const uint32* meshletVertices = nullptr;
+
+	//packMeshletTriangleで詰めた三角形
+	const uint32* meshletTriangles = nullptr;
+
+	//LOD1以降の数。LOD0はmaterialRangesで、LODを持たないメッシュは0
+	uint32 lodCount = 0;
+	const MeshFileLod* lods = nullptr;
+
+	//lodCount * materialRangeCountの描画範囲。LOD1の全マテリアル、LOD2の全マテリアルの順
+	const MeshFileMaterialRange* lodMaterialRanges = nullptr;
+};
+
+//メモリ上のメッシュファイルを解析する。v1とv2のどちらも読め、コピーせずにファイル上のデータを指す
+//データはマップしたファイルなどで呼び出し側が保持しておく
+class MeshFileReader {
+public:
+	MeshFileReader();
+
+	//ヘッダーとセクションテーブルを検証してメッシュを列挙する。壊れていればfalse
+	bool open(const void* data, uint64 size);
+
+	//すべてのセクションのハッシュを計算し直して照合する。v1はハッシュを持たないので常にtrue
+	bool verifyHashes() const;
+
+	uint32 getVersion() const { return _version; }
+	uint32 getMeshCount() const { return static_cast<uint32>(_meshes.size()); }
+	const MeshFileMesh& getMesh(uint32 meshIndex) const { return _meshes[meshIndex]; }
+
+	//アップロードする内容の合計。符号化したインデックスは戻した後の大きさで数える
+	uint64 getPayloadSize() const { return _payloadSize; }
+
+	static uint64 computeHash(const void* data, uint64 size);
+
+private:
+	bool openV1();
+	bool openV2();
+
+	//頂点の位置からAABBを求める。float頂点にだけ使う
+	static void computeBounds(MeshFileMesh& mesh);
+
+	//メッシュレットが頂点と三角形のセクションの範囲に収まっているか
+	static bool validateMeshlets(const MeshFileMesh& mesh);
+
+	//LODの描画範囲がインデックスの範囲に収まっているか
+	static bool validateLods(const MeshFileMesh& mesh, uint32 lodMaterialRangeCount);
+
+	const byte* _data;
+	uint64 _size;
+	uint32 _version;
+	uint64 _payloadSize;
+	VectorArray<MeshFileMesh> _meshes;
+};
+
+//メッシュを並べてv2のファイルを書き出す。各配列は書き出しが終わるまで呼び出し側が保持しておく
+class MeshFileWriter {
+public:
+	void addMesh(const MeshFileMesh& mesh);
+
+	bool write(const char* filePath) const;
+
+	//書き出すファイルの内容をメモリ上に組み立てる
+	void build(VectorArray<byte>& outData) const;
+
+private:
+	VectorArray<MeshFileMesh> _meshes;
+};
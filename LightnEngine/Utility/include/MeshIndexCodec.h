@@ -0,0 +1,44 @@
+#pragma once
+
+#include "MeshFile.h"
+
+//MESH_SECTION_ENCODED_INDEXの符号化と復元
+//インデックスは直前のインデックスとの差をジグザグ符号化し、7ビットずつの可変長整数で並べる
+//頂点キャッシュ向けに並べたメッシュでは差がほとんど1バイトに収まり、復元は分岐の少ない1パスで済む
+
+//符号化したインデックスを先頭から少しずつ戻す。アップロードリングのチャンクごとに直接書き込むのに使う
+class MeshIndexDecoder {
+public:
+	MeshIndexDecoder();
+
+	//MESH_SECTION_ENCODED_INDEXの本体を渡す。ヘッダーが壊れていればfalse
+	bool open(const byte* data, uint64 size);
+
+	//続きのindexCount個をoutIndicesに書き込む。符号化したデータが途中で切れていればfalse
+	bool decode(void* outIndices, uint32 indexCount);
+
+	uint32 getIndexCount() const { return _header.indexCount; }
+	uint32 getIndexStride() const { return _header.indexStride; }
+
+private:
+	template <class T>
+	bool decodeIndices(T* outIndices, uint32 indexCount);
+
+	MeshFileEncodedIndexHeader _header;
+	const byte* _cursor;
+	const byte* _end;
+	uint32 _previousIndex;
+	uint32 _decodedCount;
+};
+
+class MeshIndexCodec {
+public:
+	//MESH_SECTION_ENCODED_INDEXの本体を作る。outDataの先頭にMeshFileEncodedIndexHeaderを置く
+	static void encode(const void* indices, uint32 indexCount, uint32 indexStride, VectorArray<byte>& outData);
+
+	//まとめて戻す。outIndicesにはインデックス数 x 1つのバイト数の領域が必要
+	static bool decode(const byte* data, uint64 size, void* outIndices);
+
+	//頂点数が16ビットで指せれば16ビットに詰め直す。戻り値はインデックス1つのバイト数
+	static uint32 packIndices(const uint32* indices, uint32 indexCount, uint32 vertexCount, VectorArray<byte>& outIndices);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MeshFile.h"
+
+//インデックスと頂点の並びを描画向けに最適化する。D3D12にもFBX SDKにも依存しないので、.meshのままどの環境でも実行できる
+//1. 頂点キャッシュ: Tipsifyで隣接する三角形を続けて描くように並べ替える
+//2. オーバードロー: Tipsifyが途切れた位置でクラスターに分け、外側を向くクラスターから描くように並べ替える
+//3. 頂点フェッチ: インデックスが最初に参照する順に頂点を並べ直し、参照されない頂点を取り除く
+//1と2はマテリアルの描画範囲ごとに行い、範囲をまたいで三角形を動かさない
+
+struct MeshOptimizeSettings {
+	//最適化と計測で想定する変換後頂点キャッシュ(FIFO)のエントリー数
+	uint32 cacheSize = 16;
+
+	//クラスターを細かく分けるときに許すACMRの悪化の割合。大きいほどオーバードローを優先する
+	float overdrawThreshold = 1.05f;
+};
+
+//変換後頂点キャッシュをFIFOとして模擬した結果
+struct MeshCacheStatistics {
+	//三角形あたりのキャッシュミス数。0.5に近いほど良い
+	float acmr = 0.0f;
+
+	//参照される頂点あたりのキャッシュミス数。1.0に近いほど良い
+	float atvr = 0.0f;
+};
+
+//最適化したメッシュの頂点とインデックスを持つ。MeshFileMeshはここを指すので書き出しが終わるまで保持しておく
+struct OptimizedMeshData {
+	VectorArray<byte> vertices;
+	VectorArray<uint32> indices;
+};
+
+class MeshOptimizer {
+public:
+	//メッシュの頂点とインデックスを最適化してoutDataに置き、outMeshをそこに向ける
+	//インデックスは32ビットで返すので、16ビットへの詰め直しや符号化は呼び出し側で改めて行う
+	static bool optimizeMesh(const MeshFileMesh& mesh, const MeshOptimizeSettings& settings, OptimizedMeshData& outData, MeshFileMesh& outMesh);
+
+	//インデックスを並べ替える。outHardBoundariesにはキャッシュが途切れた三角形の位置を先頭の0を含めて入れる
+	static void optimizeVertexCache(uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 cacheSize, VectorArray<uint32>& outHardBoundaries);
+
+	//optimizeVertexCacheの結果をクラスターに分けて並べ替える。positionsは頂点ごとのxyzを詰めた配列
+	static void optimizeOverdraw(uint32* indices, uint32 indexCount, const float* positions, const VectorArray<uint32>& hardBoundaries, uint32 cacheSize, float threshold);
+
+	//頂点を参照順に並べ直してインデックスを書き換える。戻り値は並べ直した後の頂点数
+	static uint32 optimizeVertexFetch(VectorArray<byte>& vertices, uint32 vertexStride, uint32* indices, uint32 indexCount);
+
+	static MeshCacheStatistics analyzeVertexCache(const uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 cacheSize);
+
+	//64バイトのキャッシュラインで頂点を読んだときに、参照される頂点の大きさの何倍を読むか。1.0に近いほど良い
+	static float analyzeVertexFetch(const uint32* indices, uint32 indexCount, uint32 vertexCount, uint32 vertexStride);
+
+	//インデックスを32ビットに戻す。16ビットや符号化されたインデックスにも使える
+	static bool loadIndices(const MeshFileMesh& mesh, VectorArray<uint32>& outIndices);
+
+	//頂点の位置をxyzのfloatで詰めて取り出す。圧縮頂点は戻して取り出す
+	static void loadPositions(const MeshFileMesh& mesh, VectorArray<float>& outPositions);
+};
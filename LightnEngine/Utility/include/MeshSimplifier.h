@@ -0,0 +1,44 @@
+#pragma once
+
+#include "MeshFile.h"
+
+//二次誤差(QEM)による辺の縮約でメッシュの三角形を減らし、LODを作る
+//頂点は動かさずに辺の片方の頂点へ寄せるので、LODはLOD0の頂点バッファをそのまま使える
+//UVや法線の継ぎ目の頂点は継ぎ目に沿ってだけ動かし、穴の縁や複数のマテリアルにまたがる頂点は見た目が崩れるので動かさない
+
+struct MeshLodSettings {
+	//LOD0を含めて作るLODの数。MESH_MAX_LOD_COUNT以下
+	uint32 lodCount = MESH_MAX_LOD_COUNT;
+
+	//1つ前のLODに対する三角形の数の割合
+	float reductionRatio = 0.5f;
+
+	//許すずれの上限。メッシュのAABBの対角線の長さに対する割合
+	float maxError = 0.05f;
+
+	//三角形がこの割合までしか減らなければ、見た目のわりに得がないのでそれ以上のLODを作らない
+	float minReduction = 0.85f;
+};
+
+//LODを加えたメッシュのインデックスとLODの情報を持つ。MeshFileMeshはここを指すので書き出しが終わるまで保持しておく
+struct MeshLodData {
+	VectorArray<uint32> indices;
+	VectorArray<MeshFileLod> lods;
+	VectorArray<MeshFileMaterialRange> lodMaterialRanges;
+};
+
+class MeshSimplifier {
+public:
+	//LOD0から三角形を減らしたLODを作り、インデックスをLOD0の後ろに足す。LODの三角形は頂点キャッシュ向けに並べる
+	//LODを作れなかったメッシュはlodCountが0のまま返る
+	static bool buildLods(const MeshFileMesh& mesh, const MeshLodSettings& settings, MeshLodData& outData, MeshFileMesh& outMesh);
+
+	//三角形がtargetTriangleCount以下になるか、ずれがmaxErrorを超えるまで辺を縮約する
+	//三角形はマテリアルの描画範囲の中に残したまま詰め、outRangesに範囲ごとの位置を返す。戻り値は実際のずれ
+	static float simplify(const uint32* indices, const MeshFileMaterialRange* ranges, uint32 rangeCount, const float* positions, uint32 vertexCount,
+		uint32 targetTriangleCount, float maxError, VectorArray<uint32>& outIndices, MeshFileMaterialRange* outRanges);
+
+	//画面上の境界球の直径(ピクセル)から、ずれがerrorPixels以下に収まる最も粗いLODを選ぶ。0がLOD0
+	//シェーダー側の選択はShaders/GpuCulling_cs.hlslと同じ計算にしておく
+	static uint32 selectLod(const MeshFileLod* lods, uint32 lodCount, float screenSize, float errorPixels);
+};
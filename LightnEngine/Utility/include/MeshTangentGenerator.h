@@ -0,0 +1,18 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "ThreadPool.h"
+
+//UVから接線と従法線の符号を求める。MikkTSpaceと同じ手順で、ノーマルマップのベイクと同じ接線空間になる
+//1. 三角形ごとにUVのuとvが増える向きを求め、法線と接線の外積とvの向きを比べてUVが裏返っているかを調べる
+//2. 角ごとにuの向きを法線に垂直な面に投影し、角の大きさで重みをつける
+//3. 位置、法線、UVが一致し、UVの向きも同じ角をまとめて重みつきで足し、正規化する
+//MikkTSpaceは辺でつながった三角形ごとに分けるが、ここでは一致する角をすべてまとめる
+//三角形ごとの計算と角ごとの合計はスレッドプールで並列に行う
+
+class MeshTangentGenerator {
+public:
+	//三角形の角ごとに並んだ頂点(3つで1つの三角形)の接線を書き換え、従法線の符号を接線の長さで持たせる
+	//UVがつぶれて向きが決まらない角は、法線に垂直な向きを選ぶ。threadPoolがnullptrなら呼び出しスレッドだけで処理する
+	static void generateTangents(MeshFileFloatVertex* polygonVertices, uint32 polygonVertexCount, ThreadPool* threadPool);
+};
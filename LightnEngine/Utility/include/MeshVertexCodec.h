@@ -0,0 +1,54 @@
+#pragma once
+
+#include "MeshFile.h"
+
+//MeshFileCompactVertexとの変換。コンバーターは圧縮と誤差の確認に、エンジンはシェーダーに渡す復元用の定数に使う
+//シェーダー側の復元はShaders/ShaderUtil.hlslのDecodeMeshVertexと同じ計算にしておく
+
+//圧縮してよい誤差の上限
+struct MeshVertexTolerance {
+	//位置の各軸の誤差(モデル空間の単位)
+	float position = 0.0005f;
+
+	//法線と接線の角度の誤差(度)
+	float normalAngle = 1.0f;
+
+	//UVの誤差。1024ピクセルのテクスチャで半テクセル
+	float texcoord = 1.0f / 2048.0f;
+};
+
+//圧縮して戻したときの最大誤差
+struct MeshVertexError {
+	float position = 0.0f;
+	float normalAngle = 0.0f;
+	float tangentAngle = 0.0f;
+	float texcoord = 0.0f;
+
+	bool isWithin(const MeshVertexTolerance& tolerance) const;
+};
+
+class MeshVertexCodec {
+public:
+	//全頂点を圧縮し、戻したときの誤差を求める。誤差が許容範囲に収まらなければfalseで、float頂点のまま使う
+	static bool encodeCompactVertices(const MeshFileFloatVertex* vertices, uint32 vertexCount, const MeshFileMeshInfo& info,
+		const MeshVertexTolerance& tolerance, VectorArray<MeshFileCompactVertex>& outVertices, MeshVertexError& outError);
+
+	static void encodeCompactVertex(const MeshFileFloatVertex& vertex, const MeshFileMeshInfo& info, MeshFileCompactVertex& outVertex);
+	static void decodeCompactVertex(const MeshFileCompactVertex& vertex, const MeshFileMeshInfo& info, MeshFileFloatVertex& outVertex);
+
+	//シェーダーで位置をposition * scale + offsetとして戻すための定数。float頂点はそのままになる値を返す
+	static void getPositionDequantization(const MeshFileMeshInfo& info, float outScale[3], float outOffset[3]);
+
+	//単位ベクトルを8ビットずつの八面体エンコードにする。丸め方の4通りから最も誤差の小さいものを選ぶ
+	static void encodeOctahedral(const float direction[3], signed char outEncoded[2]);
+	static void decodeOctahedral(const signed char encoded[2], float outDirection[3]);
+
+	//従法線の符号。float頂点の接線の長さから読む
+	static float getBitangentSign(const MeshFileFloatVertex& vertex);
+
+	//接線を単位ベクトルにして、従法線の符号を長さで持たせる
+	static void setTangent(MeshFileFloatVertex& vertex, const float tangent[3], float bitangentSign);
+
+	static uint16 floatToHalf(float value);
+	static float halfToFloat(uint16 value);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "MeshFile.h"
+#include "ThreadPool.h"
+
+//三角形の角ごとに並んだ頂点から、すべての属性(位置、法線、接線、UV)が一致する頂点を1つにまとめる
+//頂点ごとのハッシュの上位ビットで基数ソートしてバケットに振り分け、バケットごとに小さな開番地法のテーブルで重複を探す
+//頂点ごとのノードを確保せず、ハッシュの計算、振り分け、バケットごとの探索はスレッドプールで並列に行う
+
+struct MeshWeldSettings {
+	//属性ごとの量子化の間隔。0なら値が完全に一致する頂点だけをまとめる(+0と-0は同じ値とみなす)
+	//正の値なら間隔で丸めて同じ格子に入る頂点をまとめる。格子の境界をまたぐ近い頂点はまとまらない
+	float positionEpsilon = 0.0f;
+	float normalEpsilon = 0.0f;
+	float tangentEpsilon = 0.0f;
+	float texcoordEpsilon = 0.0f;
+};
+
+class MeshWelder {
+public:
+	//outRemapには入力の頂点ごとにまとめた後の頂点番号を入れ、outVerticesにはまとめた頂点を入れる
+	//まとめた頂点は最初に現れた頂点の値を使い、最初に現れた順に番号をつけるので、結果は並列数によらない
+	//threadPoolがnullptrなら呼び出しスレッドだけで処理する。戻り値はまとめた後の頂点数
+	static uint32 weldVertices(const MeshFileFloatVertex* vertices, uint32 vertexCount, const MeshWeldSettings& settings, ThreadPool* threadPool,
+		VectorArray<uint32>& outRemap, VectorArray<MeshFileFloatVertex>& outVertices);
+
+	//量子化した属性が一致するか
+	static bool isEqualVertex(const MeshFileFloatVertex& a, const MeshFileFloatVertex& b, const MeshWeldSettings& settings);
+};
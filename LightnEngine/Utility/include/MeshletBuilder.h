@@ -0,0 +1,62 @@
+#pragma once
+
+#include "MeshFile.h"
+
+//メッシュをメッシュレット(頂点64、三角形124以下のクラスター)に分け、クラスター単位でカリングする
+//分割はコンバーターでオフラインに行い、カリングはCPUの参照実装をここに置く
+//シェーダー側のカリングはShaders/ShaderUtil.hlslのIsMeshletVisibleと同じ計算にしておく
+
+//メッシュレットとその頂点、三角形を持つ。MeshFileMeshはここを指すので書き出しが終わるまで保持しておく
+struct MeshletData {
+	VectorArray<MeshFileMeshlet> meshlets;
+	VectorArray<uint32> vertices;
+	VectorArray<uint32> triangles;
+};
+
+//メッシュのローカル空間で表したカメラ。視錐台の平面はカメラ位置を通り、法線は内向き
+struct MeshletCullingView {
+	float cameraPosition[3];
+	float frustumPlanes[4][3];
+
+	//非一様な拡大縮小や反転を含むインスタンスではコーンが歪むので裏面の判定をしない
+	bool isBackfaceCullingEnabled = true;
+};
+
+enum MeshletCullingResult {
+	MESHLET_VISIBLE = 0,
+	MESHLET_FRUSTUM_CULLED,
+	MESHLET_BACKFACE_CULLED
+};
+
+//ビューごとのクラスターカリングの結果
+struct MeshletCullingStatistics {
+	uint32 meshletCount = 0;
+	uint32 frustumCulledMeshletCount = 0;
+	uint32 backfaceCulledMeshletCount = 0;
+	uint64 triangleCount = 0;
+	uint64 frustumCulledTriangleCount = 0;
+	uint64 backfaceCulledTriangleCount = 0;
+
+	void add(const MeshletCullingStatistics& statistics);
+
+	uint64 getVisibleTriangleCount() const { return triangleCount - frustumCulledTriangleCount - backfaceCulledTriangleCount; }
+};
+
+class MeshletBuilder {
+public:
+	//マテリアルの描画範囲ごとに、隣接する三角形をたどって上限まで詰めて分ける
+	//増える頂点が少ない三角形を優先し、同じなら向きがそろう三角形を選ぶのでコーンが狭くなる
+	static bool buildMeshlets(const MeshFileMesh& mesh, MeshletData& outData);
+
+	//outDataのメッシュレットをmeshに持たせる
+	static void setMeshlets(const MeshletData& data, MeshFileMesh& mesh);
+
+	static MeshletCullingResult cullMeshlet(const MeshFileMeshlet& meshlet, const MeshletCullingView& view);
+
+	//メッシュのすべてのメッシュレットをカリングし、除外できた三角形を数える
+	static void cullMeshlets(const MeshFileMeshlet* meshlets, uint32 meshletCount, const MeshletCullingView& view, MeshletCullingStatistics& outStatistics);
+
+private:
+	//メッシュレットの頂点から境界球を、三角形の向きからコーンを求める
+	static void computeBounds(MeshFileMeshlet& meshlet, const MeshletData& data, const float* positions);
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Utility.h"
+#include <mutex>
+#include <functional>
+
+//シェーダーのコンパイル結果をディスクに残し、次回の起動でコンパイルとリフレクションを省くキャッシュ
+//
+//エントリーはファイル、エントリーポイント、ターゲット、マクロ、フラグが同じシェーダーごとに1つ持ち、
+//ソースと#includeでたどれる全ファイルの内容、コンパイラーのバージョンのハッシュが前回と一致したときだけ使う
+//インクルードしたファイルを書き換えればハッシュが変わるので、そのシェーダーはコンパイルし直して上書きされる
+//バイトコードとリフレクション結果は中身を知らないバイト列として持つ。リフレクション結果の書式は呼び出し側がsettingsHashに含める
+//
+//D3Dに依存しないので、キーの計算、インクルードの走査と保存はコンバーターやほかのプラットフォームでも動かせる
+
+//'LSHC'
+constexpr uint32 SHADER_CACHE_MAGIC = 0x4348534c;
+
+//キャッシュファイルの書式とキーの計算のバージョン。違うファイルは空のキャッシュとして読む
+constexpr uint32 SHADER_CACHE_VERSION = 1;
+
+struct ShaderCompileDesc {
+	String filePath;
+	String entryPoint;
+	String target;
+
+	//定義した順に並べる。値のないマクロは空文字
+	VectorArray<std::pair<String, String>> defines;
+	uint32 flags = 0;
+
+	//変われば同じソースでもコンパイルし直す
+	uint32 compilerVersion = 0;
+
+	//リフレクション結果の書式など、呼び出し側がキャッシュの内容を変えたときに変える値
+	uint64 settingsHash = 0;
+};
+
+struct ShaderSourceFile {
+	String path;
+
+	//内容のハッシュ。見つからなかったインクルードは0
+	uint64 hash;
+};
+
+//ファイルの内容をすべて読む。読めなければfalse
+using ShaderSourceReader = std::function<bool(const String& filePath, VectorArray<byte>& outData)>;
+
+//#includeをたどってシェーダーが読むファイルを集める。コンパイラーと同じく、インクルードしたファイルのあるディレクトリ、パスそのままの順に探す
+//#ifで外れるインクルードも区別せずにたどる。余分に依存ファイルが増えてもコンパイルし直す回数が増えるだけで、結果は変わらない
+class ShaderSourceScanner {
+public:
+	//filePathとインクルードしたファイルを最初に現れた順に集める。filePathが読めなければfalse
+	//見つからないインクルードはハッシュを0にして残すので、後からファイルができればキーが変わる
+	static bool scan(const String& filePath, const ShaderSourceReader& reader, VectorArray<ShaderSourceFile>& outFiles);
+
+	//コメントを除いた#include "..."と#include <...>のファイル名を現れた順に返す
+	static void findIncludes(const char* source, uint64 size, VectorArray<String>& outFileNames);
+
+	//区切りを'/'にそろえ、"."と"ディレクトリ/.."を除く。同じファイルを別のパスでたどらないようにする
+	static String normalizePath(const String& filePath);
+
+	//末尾の区切りを含むディレクトリ。区切りがなければ空
+	static String getDirectory(const String& filePath);
+
+	//ShaderSourceReaderの既定の実装。ファイルをそのまま読む
+	static bool readFile(const String& filePath, VectorArray<byte>& outData);
+};
+
+//キャッシュファイルとリフレクション結果の書き出しに使う。値はメモリ上の表現のまま書く
+class ShaderCacheWriter {
+public:
+	explicit ShaderCacheWriter(VectorArray<byte>& data) :_data(data) {}
+
+	template<typename T>
+	void write(const T& value) {
+		writeBytes(&value, sizeof(T));
+	}
+
+	void writeBytes(const void* data, uint64 size);
+
+	//長さに続けて中身を書く
+	void writeString(const String& value);
+	void writeBlob(const VectorArray<byte>& value);
+
+private:
+	VectorArray<byte>& _data;
+};
+
+//ShaderCacheWriterで書いた内容を読む。範囲を越える読み込みはfalseを返し、以降もすべて失敗する
+class ShaderCacheReader {
+public:
+	ShaderCacheReader(const byte* data, uint64 size) :_data(data), _size(size), _position(0), _isFailed(false) {}
+
+	template<typename T>
+	bool read(T& outValue) {
+		return readBytes(&outValue, sizeof(T));
+	}
+
+	bool readBytes(void* dst, uint64 size);
+	bool readString(String& outValue);
+	bool readBlob(VectorArray<byte>& outValue);
+
+	uint64 getRemainingSize() const { return _size - _position; }
+	bool isEnd() const { return _position == _size; }
+	bool isFailed() const { return _isFailed; }
+
+private:
+	const byte* _data;
+	uint64 _size;
+	uint64 _position;
+	bool _isFailed;
+};
+
+struct ShaderCacheStatistics {
+	uint32 entryCount = 0;
+	uint32 hitCount = 0;
+	uint32 missCount = 0;
+
+	//起動時に読んだキャッシュファイルが壊れていたか、書式が違って捨てたか
+	bool isDiscarded = false;
+};
+
+//find、storeはどのスレッドから呼んでもよい
+class ShaderCache :public Singleton<ShaderCache> {
+public:
+	ShaderCache();
+	~ShaderCache();
+
+	//ファイルがなければ空のキャッシュとして扱う。壊れているか書式が違えばfalseを返して空にする
+	bool load(const String& filePath);
+
+	//エントリーをidentityHashの順に書き出し、変更済みの印を消す
+	bool save(const String& filePath);
+
+	//前回のloadかsaveから変わったエントリーがあるか
+	bool isDirty() const;
+
+	//identityHashのエントリーがkeyで作られていればバイトコードとリフレクション結果を返す
+	bool find(uint64 identityHash, uint64 key, VectorArray<byte>& outByteCode, VectorArray<byte>& outReflection);
+
+	//同じidentityHashの古いエントリーは置き換える
+	void store(uint64 identityHash, uint64 key, const void* byteCode, uint64 byteCodeSize, const VectorArray<byte>& reflection);
+
+	void clear();
+
+	ShaderCacheStatistics getStatistics() const;
+
+	//ファイル、エントリーポイント、ターゲット、マクロ、フラグのハッシュ。同じシェーダーの古いエントリーを探すのに使う
+	static uint64 computeIdentityHash(const ShaderCompileDesc& desc);
+
+	//identityHashにソースとインクルードの内容、コンパイラーのバージョン、設定を加えたハッシュ
+	static uint64 computeKey(const ShaderCompileDesc& desc, const VectorArray<ShaderSourceFile>& sourceFiles);
+
+	static bool isCreated() { return _singleton != nullptr; }
+
+private:
+	struct Entry {
+		uint64 key;
+		VectorArray<byte> byteCode;
+		VectorArray<byte> reflection;
+	};
+
+	static uint64 computeEntryHash(const Entry& entry);
+
+	mutable std::mutex _mutex;
+	UnorderedMap<uint64, Entry> _entries;
+	bool _isDirty;
+	ShaderCacheStatistics _statistics;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Utility.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <queue>
+
+//固定数のワーカースレッドでジョブを処理するスレッドプール
+class ThreadPool :private NonCopyable {
+public:
+	using Job = std::function<void()>;
+	using IndexedJob = std::function<void(uint32)>;
+
+	ThreadPool();
+	~ThreadPool();
+
+	//ワーカースレッドを生成 0の場合は呼び出しスレッドのみで処理する
+	void create(uint32 workerCount);
+	void shutdown();
+
+	//ジョブを積む。完了は待たない
+	void pushJob(const Job& job);
+
+	//0～jobCount-1のインデックスでジョブを並列実行し、全完了まで待機する
+	//呼び出しスレッドも完了待ちの間ジョブを処理する
+	void parallelFor(uint32 jobCount, const IndexedJob& job);
+
+	//ワーカースレッド数
+	uint32 getWorkerCount() const;
+
+private:
+	//積まれたジョブを1つ取り出して実行　ジョブがなければfalse
+	bool tryExecuteJob();
+	void workerMain();
+
+	VectorArray<std::thread> _workers;
+	std::queue<Job> _jobs;
+	std::mutex _jobMutex;
+	std::condition_variable _jobCondition;
+	bool _isShutdown;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Utility.h"
+
+//TLSF(Two-Level Segregated Fit)方式のオフセットアロケーター
+//空きブロックをサイズの2段階のクラスで分類し、ビットマップで探索するので確保・解放ともに定数時間で終わる
+//メモリは持たずオフセットを返すだけなので、D3D12なしで検証できる(AssetTool -tlsfbench)。ヒープやバッファの中の配置に使う
+class TlsfAllocator {
+public:
+	static constexpr uint64 InvalidOffset = ~0ull;
+	static constexpr uint32 InvalidNode = 0xffffffff;
+
+	//第2レベルの分割数(2のべき乗)
+	static constexpr uint32 SecondLevelBits = 4;
+	static constexpr uint32 SecondLevelCount = 1 << SecondLevelBits;
+	static constexpr uint32 FirstLevelCount = 64;
+
+	struct Allocation {
+		uint64 offset = InvalidOffset;
+		uint64 size = 0;
+
+		//解放時に使うブロック番号
+		uint32 node = InvalidNode;
+
+		bool isValid() const { return node != InvalidNode; }
+	};
+
+	struct Statistics {
+		uint64 allocationCount = 0;
+		uint64 failedAllocationCount = 0;
+		uint64 usedSize = 0;
+		uint64 peakUsedSize = 0;
+		uint32 liveAllocationCount = 0;
+		uint32 freeBlockCount = 0;
+	};
+
+	TlsfAllocator();
+
+	//granularityはすべての確保サイズとオフセットの最小単位(2のべき乗)
+	void create(uint64 capacity, uint64 granularity);
+	void clear();
+
+	//空きがなければ無効なAllocationを返す
+	Allocation allocate(uint64 size, uint64 alignment);
+	void free(const Allocation& allocation);
+
+	uint64 getCapacity() const { return _capacity; }
+	uint64 getFreeSize() const { return _capacity - _statistics.usedSize; }
+
+	//確保できる最大の連続サイズ
+	uint64 getLargestFreeBlockSize() const;
+
+	bool isEmpty() const { return _statistics.liveAllocationCount == 0; }
+	const Statistics& getStatistics() const { return _statistics; }
+
+private:
+	//物理的に隣接するブロックと、同じサイズクラスの空きブロックをそれぞれ双方向リストでつなぐ
+	struct Block {
+		uint64 offset;
+		uint64 size;
+		uint32 prevPhysical;
+		uint32 nextPhysical;
+		uint32 prevFree;
+		uint32 nextFree;
+		bool isFree;
+	};
+
+	//サイズ(granularity単位)からサイズクラスを求める
+	static void mapSize(uint64 units, uint32& firstLevel, uint32& secondLevel);
+
+	uint32 createBlock(uint64 offset, uint64 size);
+	void releaseBlock(uint32 block);
+	void insertFreeBlock(uint32 block);
+	void removeFreeBlock(uint32 block);
+
+	//指定サイズ以上が必ず収まる空きブロックを探す。切り上げたクラスに無ければ要求と同じクラスの中を調べる
+	uint32 findFreeBlock(uint64 size) const;
+
+	uint64 _capacity;
+	uint64 _granularity;
+
+	VectorArray<Block> _blocks;
+	VectorArray<uint32> _unusedBlocks;
+
+	uint64 _firstLevelBitmap;
+	uint32 _secondLevelBitmaps[FirstLevelCount];
+	uint32 _freeHeads[FirstLevelCount][SecondLevelCount];
+
+	Statistics _statistics;
+};
@@ -5,5 +5,6 @@ using uint16 = unsigned short;
 using uint32 = unsigned int;
 using ulong = unsigned long;
 using ulong2 = unsigned long long;
+using uint64 = unsigned long long;
 using int32 = int;
 using uchar = unsigned char;
\ No newline at end of file
@@ -44,31 +44,31 @@ protected:
 
 template <class T>
 struct MyAllocator {
-	// vf̌^
+	// 要素の型
 	using value_type = T;
 
-	// ֐
-	// (ftHgRXgN^ARs[RXgN^
-	//  A[uRXgN^)
+	// 特殊関数
+	// (デフォルトコンストラクタ、コピーコンストラクタ
+	//  、ムーブコンストラクタ)
 	MyAllocator() {}
 
-	// ʂȗvf^̃AP[^󂯎RXgN^
+	// 別な要素型のアロケータを受け取るコンストラクタ
 	template <class U>
 	MyAllocator(const MyAllocator<U>&) {}
 
-	// m
+	// メモリ確保
 	T* allocate(std::size_t n) {
 		return reinterpret_cast<T*>(std::malloc(sizeof(T) * n));
 	}
 
-	// 
+	// メモリ解放
 	void deallocate(T* p, std::size_t n) {
 		static_cast<void>(n);
 		std::free(p);
 	}
 };
 
-// rZq
+// 比較演算子
 template <class T, class U>
 bool operator==(const MyAllocator<T>&, const MyAllocator<U>&) {
 	return true;
@@ -81,6 +81,7 @@ bool operator!=(const MyAllocator<T>&, const MyAllocator<U>&) {
 
 #include <vector>
 #include <list>
+#include <deque>
 #include <string>
 #include <codecvt> 
 #include <memory>
@@ -92,6 +93,9 @@ using VectorArray = std::vector<T, MyAllocator<T>>;
 template <class T>
 using ListArray = std::list<T, MyAllocator<T>>;
 
+template <class T>
+using DequeArray = std::deque<T, MyAllocator<T>>;
+
 template <class T>
 using UniquePtr = std::unique_ptr<T>;
 
@@ -113,7 +117,7 @@ WString convertWString(const String& srcStr);
 
 namespace std {
 
-	//nbVvZ@https://stackoverflow.com/questions/34597260/stdhash-value-on-char-value-and-not-on-memory-address
+	//ハッシュ計算　https://stackoverflow.com/questions/34597260/stdhash-value-on-char-value-and-not-on-memory-address
 #if SIZE_MAX == UINT32_MAX
 	constexpr std::size_t FNV_PRIME = 16777619u;
 	constexpr std::size_t FNV_OFFSET_BASIS = 2166136261u;